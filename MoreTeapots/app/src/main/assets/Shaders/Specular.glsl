@@ -0,0 +1,32 @@
+//
+// Copyright (C) 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Specular.glsl
+//  Specular term shared by ShaderPlain.fsh and ShaderPlainES3.fsh,
+//  pulled in with #include
+//
+
+uniform mediump vec4    vMaterialSpecular;
+uniform highp vec3      vLight0;
+
+lowp vec4 SpecularColor(mediump vec3 position, mediump vec3 normal)
+{
+    mediump vec3 halfVector = normalize(-vLight0 + position);
+    mediump float NdotH = max(dot(normalize(normal), halfVector), 0.0);
+    mediump float fPower = vMaterialSpecular.w;
+    mediump float specular = pow(NdotH, fPower);
+
+    return vec4( vMaterialSpecular.xyz * specular, 1 );
+}
@@ -52,6 +52,8 @@ class Engine {
   MoreTeapotsRenderer renderer_;
 
   ndk_helper::GLContext* gl_context_;
+  // Loads the renderer's resources in the background; gone once they are in
+  ndk_helper::ResourceLoader* loader_;
 
   bool initialized_resources_;
   bool has_focus_;
@@ -60,6 +62,10 @@ class Engine {
   ndk_helper::PinchDetector pinch_detector_;
   ndk_helper::DragDetector drag_detector_;
   ndk_helper::PerfMonitor monitor_;
+  ndk_helper::ResolutionController resolution_;
+  // Render size the viewport was set for
+  int32_t viewport_width_;
+  int32_t viewport_height_;
 
   ndk_helper::TapCamera tap_camera_;
 
@@ -86,6 +92,8 @@ class Engine {
   void DrawFrame();
   void TermDisplay();
   void TrimMemory();
+  void UpdateRenderScale();
+  void UpdateViewport();
   bool IsReady();
 
   void UpdatePosition(AInputEvent* event, int32_t index, float& x, float& y);
@@ -100,8 +108,11 @@ class Engine {
 // Ctor
 //-------------------------------------------------------------------------
 Engine::Engine()
-    : initialized_resources_(false),
+    : loader_(NULL),
+      initialized_resources_(false),
       has_focus_(false),
+      viewport_width_(0),
+      viewport_height_(0),
       app_(NULL),
       sensor_manager_(NULL),
       accelerometer_sensor_(NULL),
@@ -118,14 +129,23 @@ Engine::~Engine() {}
  * Load resources
  */
 void Engine::LoadResources() {
-  renderer_.Init(NUM_TEAPOTS_X, NUM_TEAPOTS_Y, NUM_TEAPOTS_Z);
+  ndk_helper::shader::ProgramCache::GetInstance()->Init(
+      app_->activity->internalDataPath);
+  loader_ = new ndk_helper::ResourceLoader(gl_context_->CreateLoaderBackend());
+  renderer_.Init(loader_, NUM_TEAPOTS_X, NUM_TEAPOTS_Y, NUM_TEAPOTS_Z);
   renderer_.Bind(&tap_camera_);
 }
 
 /**
  * Unload resources
  */
-void Engine::UnloadResources() { renderer_.Unload(); }
+void Engine::UnloadResources() {
+  // Before the renderer deletes what the loader may still be making
+  delete loader_;
+  loader_ = NULL;
+  renderer_.Unload();
+  monitor_.InvalidateGpuTimer();
+}
 
 /**
  * Initialize an EGL context for the current display.
@@ -151,8 +171,8 @@ int Engine::InitDisplay() {
   glDepthFunc(GL_LEQUAL);
 
   // Note that screen size might have been changed
-  glViewport(0, 0, gl_context_->GetScreenWidth(), gl_context_->GetScreenHeight());
-  renderer_.UpdateViewport();
+  UpdateViewport();
+  resolution_.SetTargetFrameTime(monitor_.GetTargetFrameInterval());
 
   tap_camera_.SetFlip(1.f, -1.f, -1.f);
   tap_camera_.SetPinchTransformFactor(10.f, 10.f, 8.f);
@@ -164,23 +184,78 @@ int Engine::InitDisplay() {
  * Just the current frame in the display.
  */
 void Engine::DrawFrame() {
+  if (loader_) {
+    loader_->Update();
+    if (!loader_->GetPendingCount()) {
+      // Everything is loaded: the thread and its context are not needed
+      delete loader_;
+      loader_ = NULL;
+    }
+  }
+
   float fps;
   if (monitor_.Update(fps)) {
     UpdateFPS(fps);
   }
-  double dTime = monitor_.GetCurrentTime();
-  renderer_.Update(dTime);
+  monitor_.BeginFrameWork();
+  {
+    ndk_helper::TraceZone zone("update");
+    // The frame is shown about one frame interval from now
+    double dTime = monitor_.GetCurrentTime() +
+                   monitor_.GetTargetFrameInterval() / 1000000000.0;
+    renderer_.Update(dTime);
+  }
 
-  // Just fill the screen with a color.
-  glClearColor(0.5f, 0.5f, 0.5f, 1.f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  renderer_.Render();
+  {
+    ndk_helper::TraceZone zone("render");
+    // Just fill the screen with a color.
+    glClearColor(0.5f, 0.5f, 0.5f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderer_.Render();
+  }
 
   // Swap
-  if (EGL_SUCCESS != gl_context_->Swap()) {
-    UnloadResources();
-    LoadResources();
+  monitor_.EndFrameWork();
+  {
+    ndk_helper::TraceZone zone("swap");
+    if (EGL_SUCCESS != gl_context_->Swap()) {
+      UnloadResources();
+      LoadResources();
+    }
+  }
+
+  if (resolution_.Update(monitor_.GetFrameCost(),
+                         monitor_.GetLastFrameInterval())) {
+    UpdateRenderScale();
+  }
+  // A new render scale reaches the surface with a swap
+  if (gl_context_->GetRenderWidth() != viewport_width_ ||
+      gl_context_->GetRenderHeight() != viewport_height_) {
+    UpdateViewport();
+  }
+}
+
+/**
+ * Render at the scale picked by the resolution controller.
+ */
+void Engine::UpdateRenderScale() {
+  if (!gl_context_->SetRenderScale(resolution_.GetScale())) {
+    // The window keeps the buffer size it has
+    resolution_.HoldScale(gl_context_->GetRenderScale());
+    return;
   }
+  LOGI("Render scale %.2f", resolution_.GetScale());
+}
+
+/**
+ * Fit the viewport and projection to the render size.
+ */
+void Engine::UpdateViewport() {
+  viewport_width_ = gl_context_->GetRenderWidth();
+  viewport_height_ = gl_context_->GetRenderHeight();
+  glViewport(0, 0, viewport_width_, viewport_height_);
+  renderer_.UpdateViewport();
+  LOGI("Viewport %dx%d", viewport_width_, viewport_height_);
 }
 
 /**
@@ -212,16 +287,23 @@ int32_t Engine::HandleInput(android_app* app, AInputEvent* event) {
       if (dragState & ndk_helper::GESTURE_STATE_START) {
         // Otherwise, start dragging
         ndk_helper::Vec2 v;
+        double time = eng->drag_detector_.GetEventTime();
         eng->drag_detector_.GetPointer(v);
         eng->TransformPosition(v);
-        eng->tap_camera_.BeginDrag(v);
+        eng->tap_camera_.BeginDrag(v, time);
       } else if (dragState & ndk_helper::GESTURE_STATE_MOVE) {
-        ndk_helper::Vec2 v;
-        eng->drag_detector_.GetPointer(v);
-        eng->TransformPosition(v);
-        eng->tap_camera_.Drag(v);
+        // Pass every sample batched into the event, the camera resamples
+        // them at the display time of the frame
+        int32_t history_size = eng->drag_detector_.GetHistorySize();
+        for (int32_t i = 0; i <= history_size; ++i) {
+          ndk_helper::Vec2 v;
+          double time;
+          if (!eng->drag_detector_.GetPointer(v, i, time)) break;
+          eng->TransformPosition(v);
+          eng->tap_camera_.Drag(v, time);
+        }
       } else if (dragState & ndk_helper::GESTURE_STATE_END) {
-        eng->tap_camera_.EndDrag();
+        eng->tap_camera_.EndDrag(eng->drag_detector_.GetEventTime());
       }
 
       // Handle pinch state
@@ -229,19 +311,23 @@ int32_t Engine::HandleInput(android_app* app, AInputEvent* event) {
         // Start new pinch
         ndk_helper::Vec2 v1;
         ndk_helper::Vec2 v2;
+        double time = eng->pinch_detector_.GetEventTime();
         eng->pinch_detector_.GetPointers(v1, v2);
         eng->TransformPosition(v1);
         eng->TransformPosition(v2);
-        eng->tap_camera_.BeginPinch(v1, v2);
+        eng->tap_camera_.BeginPinch(v1, v2, time);
       } else if (pinchState & ndk_helper::GESTURE_STATE_MOVE) {
         // Multi touch
-        // Start new pinch
-        ndk_helper::Vec2 v1;
-        ndk_helper::Vec2 v2;
-        eng->pinch_detector_.GetPointers(v1, v2);
-        eng->TransformPosition(v1);
-        eng->TransformPosition(v2);
-        eng->tap_camera_.Pinch(v1, v2);
+        int32_t history_size = eng->pinch_detector_.GetHistorySize();
+        for (int32_t i = 0; i <= history_size; ++i) {
+          ndk_helper::Vec2 v1;
+          ndk_helper::Vec2 v2;
+          double time;
+          if (!eng->pinch_detector_.GetPointers(v1, v2, i, time)) break;
+          eng->TransformPosition(v1);
+          eng->TransformPosition(v2);
+          eng->tap_camera_.Pinch(v1, v2, time);
+        }
       }
     }
     return 1;
@@ -269,8 +355,18 @@ void Engine::HandleCmd(struct android_app* app, int32_t cmd) {
       eng->TermDisplay();
       eng->has_focus_ = false;
       break;
-    case APP_CMD_STOP:
+    case APP_CMD_STOP: {
+      // Leave frame time stats behind
+      eng->monitor_.LogStats();
+#ifdef USE_NDK_TRACE
+      // And a trace of the last frames, e.g.
+      // adb shell run-as <package> cat files/trace.json > trace.json
+      std::string trace_file =
+          std::string(app->activity->internalDataPath) + "/trace.json";
+      ndk_helper::TraceRecorder::ExportChromeJson(trace_file.c_str());
+#endif
       break;
+    }
     case APP_CMD_GAINED_FOCUS:
       eng->ResumeSensors();
       // Start animation
@@ -402,6 +498,11 @@ void android_main(android_app* state) {
   monstartup("libMoreTeapotsNativeActivity.so");
 #endif
 
+#ifdef USE_NDK_TRACE
+  // Record the TraceZones of the frame loop, exported on APP_CMD_STOP
+  ndk_helper::TraceRecorder::SetEnabled(true);
+#endif
+
   // Prepare to monitor accelerometer
   g_engine.InitSensors();
 
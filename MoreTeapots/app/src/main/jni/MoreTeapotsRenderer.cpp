@@ -23,16 +23,22 @@
 //--------------------------------------------------------------------------------
 #include "MoreTeapotsRenderer.h"
 
+#include <GLES2/gl2ext.h>
+
 //--------------------------------------------------------------------------------
 // Teapot model data
 //--------------------------------------------------------------------------------
 #include "teapot.inl"
+#include "teapotLod.inl"
 
 //--------------------------------------------------------------------------------
 // Ctor
 //--------------------------------------------------------------------------------
 MoreTeapotsRenderer::MoreTeapotsRenderer()
-    : geometry_instancing_support_(false) {}
+    : vertex_layout_(ndk_helper::VERTEX_LAYOUT_FLOAT_POSITION),
+      jobs_(ndk_helper::JOB_SYSTEM_DEFAULT_THREADS),
+      geometry_instancing_support_(false),
+      ready_(false) {}
 
 //--------------------------------------------------------------------------------
 // Dtor
@@ -42,7 +48,8 @@ MoreTeapotsRenderer::~MoreTeapotsRenderer() { Unload(); }
 //--------------------------------------------------------------------------------
 // Init
 //--------------------------------------------------------------------------------
-void MoreTeapotsRenderer::Init(const int32_t numX, const int32_t numY,
+void MoreTeapotsRenderer::Init(ndk_helper::ResourceLoader* loader,
+                               const int32_t numX, const int32_t numY,
                                const int32_t numZ) {
   if (ndk_helper::GLContext::GetInstance()->GetGLVersion() >= 3.0) {
     geometry_instancing_support_ = true;
@@ -59,40 +66,31 @@ void MoreTeapotsRenderer::Init(const int32_t numX, const int32_t numY,
   // Settings
   glFrontFace(GL_CCW);
 
-  // Create Index buffer
-  num_indices_ = sizeof(teapotIndices) / sizeof(teapotIndices[0]);
-  glGenBuffers(1, &ibo_);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(teapotIndices), teapotIndices,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  // Create VBO
-  num_vertices_ = sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
-  int32_t stride = sizeof(TEAPOT_VERTEX);
-  int32_t index = 0;
-  TEAPOT_VERTEX* p = new TEAPOT_VERTEX[num_vertices_];
-  for (int32_t i = 0; i < num_vertices_; ++i) {
-    p[i].pos[0] = teapotPositions[index];
-    p[i].pos[1] = teapotPositions[index + 1];
-    p[i].pos[2] = teapotPositions[index + 2];
-
-    p[i].normal[0] = teapotNormals[index];
-    p[i].normal[1] = teapotNormals[index + 1];
-    p[i].normal[2] = teapotNormals[index + 2];
-    index += 3;
+  // Smallest vertex layout the context fetches; the loader packs it
+  ndk_helper::GLContext* context = ndk_helper::GLContext::GetInstance();
+  vertex_layout_ = ndk_helper::vertex::ChooseLayout(
+      context->GetGLVersion() >= 3.0,
+      context->CheckExtension("GL_OES_vertex_half_float"));
+  LOGI("Vertex layout %d, %d bytes per vertex", vertex_layout_,
+       ndk_helper::vertex::GetStride(vertex_layout_));
+
+  // Index ranges of the full mesh, then of the decimated levels of detail,
+  // all indexing the same vertices
+  num_lods_ = sizeof(teapotLodIndexCounts) / sizeof(teapotLodIndexCounts[0]);
+  int32_t first_index = 0;
+  for (int32_t l = 0; l < num_lods_; ++l) {
+    lod_first_index_[l] = first_index;
+    lod_num_indices_[l] = teapotLodIndexCounts[l];
+    first_index += lod_num_indices_[l];
   }
-  glGenBuffers(1, &vbo_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER, stride * num_vertices_, p, GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  delete[] p;
 
   // Init Projection matrices
   teapot_x_ = numX;
   teapot_y_ = numY;
   teapot_z_ = numZ;
-  vec_mat_models_.reserve(teapot_x_ * teapot_y_ * teapot_z_);
+  transforms_.Init(teapot_x_ * teapot_y_ * teapot_z_);
+  transforms_.SetMesh(teapotBoundingCenter, teapotBoundingRadius,
+                      teapotLodErrors, num_lods_);
 
   UpdateViewport();
 
@@ -104,95 +102,106 @@ void MoreTeapotsRenderer::Init(const int32_t numX, const int32_t numY,
   float offset_y = -total_width / 2.f;
   float offset_z = -total_width / 2.f;
 
+  int32_t teapot = 0;
   for (int32_t x = 0; x < teapot_x_; ++x)
     for (int32_t y = 0; y < teapot_y_; ++y)
       for (int32_t z = 0; z < teapot_z_; ++z) {
-        vec_mat_models_.push_back(ndk_helper::Mat4::Translation(
-            x * gap_x + offset_x, y * gap_y + offset_y,
-            z * gap_z + offset_z));
-        vec_colors_.push_back(ndk_helper::Vec3(
-            random() / float(RAND_MAX * 1.1), random() / float(RAND_MAX * 1.1),
-            random() / float(RAND_MAX * 1.1)));
+        float color[3] = {random() / float(RAND_MAX * 1.1),
+                          random() / float(RAND_MAX * 1.1),
+                          random() / float(RAND_MAX * 1.1)};
 
         float rotation_x = random() / float(RAND_MAX) - 0.5f;
         float rotation_y = random() / float(RAND_MAX) - 0.5f;
-        vec_rotations_.push_back(ndk_helper::Vec2(rotation_x * 0.05f, rotation_y * 0.05f));
-        vec_current_rotations_.push_back(
-            ndk_helper::Vec2(rotation_x * M_PI, rotation_y * M_PI));
+        transforms_.SetTeapot(
+            teapot++, ndk_helper::Mat4::Translation(x * gap_x + offset_x,
+                                                    y * gap_y + offset_y,
+                                                    z * gap_z + offset_z),
+            rotation_x * M_PI, rotation_y * M_PI, rotation_x * 0.05f,
+            rotation_y * 0.05f, color);
       }
 
+  // Buffers and programs are made on the loader thread; Render() draws
+  // nothing until they are committed
+  ready_ = false;
+  loader->Submit(LoadResources, CommitResources, this);
+}
+
+//--------------------------------------------------------------------------------
+// Loader thread
+//--------------------------------------------------------------------------------
+bool MoreTeapotsRenderer::LoadResources(void* data) {
+  MoreTeapotsRenderer* renderer = static_cast<MoreTeapotsRenderer*>(data);
+  renderer->LoadBuffers();
+  return renderer->LoadPrograms();
+}
+
+void MoreTeapotsRenderer::CommitResources(void* data, const bool succeeded) {
+  // Buffers and programs are all shared, and the attributes are set up on
+  // every draw, so there is no state to bind here
+  static_cast<MoreTeapotsRenderer*>(data)->ready_ = succeeded;
+}
+
+void MoreTeapotsRenderer::LoadBuffers() {
+  // Create Index buffer; teapotLodIndices has the full mesh too, in the
+  // order meshTool optimized it in
+  glGenBuffers(1, &ibo_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(teapotLodIndices),
+               teapotLodIndices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // Create VBO, packed in the layout Init() picked
+  num_vertices_ = sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
+  std::vector<uint8_t> vertices;
+  ndk_helper::vertex::PackVertices(vertex_layout_, teapotPositions,
+                                   teapotNormals, num_vertices_, &vertices);
+  glGenBuffers(1, &vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size(), &vertices[0],
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool MoreTeapotsRenderer::LoadPrograms() {
   if (geometry_instancing_support_) {
     //
     // Create parameter dictionary for shader patch
     std::map<std::string, std::string> param;
-    param[std::string("%NUM_TEAPOT%")] =
-        ToString(teapot_x_ * teapot_y_ * teapot_z_);
     param[std::string("%LOCATION_VERTEX%")] = ToString(ATTRIB_VERTEX);
     param[std::string("%LOCATION_NORMAL%")] = ToString(ATTRIB_NORMAL);
-    if (arb_support_)
-      param[std::string("%ARB%")] = std::string("ARB");
-    else
-      param[std::string("%ARB%")] = std::string("");
+    param[std::string("%LOCATION_MVP%")] = ToString(ATTRIB_INSTANCE_MVP);
+    param[std::string("%LOCATION_NORMAL_MATRIX%")] =
+        ToString(ATTRIB_INSTANCE_NORMAL_MATRIX);
+    param[std::string("%LOCATION_DIFFUSE%")] =
+        ToString(ATTRIB_INSTANCE_DIFFUSE);
 
     // Load shader
     bool b = LoadShadersES3(&shader_param_, "Shaders/VS_ShaderPlainES3.vsh",
                             "Shaders/ShaderPlainES3.fsh", param);
-    if (b) {
-      //
-      // Create uniform buffer
-      //
-      GLuint bindingPoint = 1;
-      GLuint blockIndex;
-      blockIndex = glGetUniformBlockIndex(shader_param_.program_, "ParamBlock");
-      glUniformBlockBinding(shader_param_.program_, blockIndex, bindingPoint);
-
-      // Retrieve array stride value
-      int32_t num_indices;
-      glGetActiveUniformBlockiv(shader_param_.program_, blockIndex,
-                                GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &num_indices);
-      GLint i[num_indices];
-      GLint stride[num_indices];
-      glGetActiveUniformBlockiv(shader_param_.program_, blockIndex,
-                                GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, i);
-      glGetActiveUniformsiv(shader_param_.program_, num_indices, (GLuint*)i,
-                            GL_UNIFORM_ARRAY_STRIDE, stride);
-
-      ubo_matrix_stride_ = stride[0] / sizeof(float);
-      ubo_vector_stride_ = stride[2] / sizeof(float);
-
-      glGenBuffers(1, &ubo_);
-      glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
-      glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo_);
-
-      // Store color value which wouldn't be updated every frame
-      int32_t size = teapot_x_ * teapot_y_ * teapot_z_ *
-                      (ubo_matrix_stride_ + ubo_matrix_stride_ +
-                       ubo_vector_stride_);  // Mat4 + Mat4 + Vec3 + 1 stride
-      float* pBuffer = new float[size];
-      float* pColor =
-          pBuffer + teapot_x_ * teapot_y_ * teapot_z_ * ubo_matrix_stride_ * 2;
-      for (int32_t i = 0; i < teapot_x_ * teapot_y_ * teapot_z_; ++i) {
-        memcpy(pColor, &vec_colors_[i], 3 * sizeof(float));
-        pColor += ubo_vector_stride_;  // Assuming std140 layout which is 4
-                                       // DWORD stride for vectors
-      }
-
-      glBufferData(GL_UNIFORM_BUFFER, size * sizeof(float), pBuffer,
-                   GL_DYNAMIC_DRAW);
-      delete[] pBuffer;
-    } else {
+    // Per instance data goes in vertex attributes, streamed through a ring
+    // of frames, so the teapot count is not capped by the uniform block size
+    if (b &&
+        !instances_.Init(GL_ARRAY_BUFFER, teapot_x_ * teapot_y_ * teapot_z_ *
+                                              sizeof(TEAPOT_INSTANCE),
+                         ndk_helper::STREAM_BUFFER_FRAMES,
+                         sizeof(float) * 4)) {
+      glDeleteProgram(shader_param_.program_);
+      shader_param_.program_ = 0;
+      b = false;
+    }
+    if (!b) {
       LOGI("Shader compilation failed!! Falls back to ES2.0 pass");
       // This happens some devices.
       geometry_instancing_support_ = false;
       // Load shader for GLES2.0
-      LoadShaders(&shader_param_, "Shaders/VS_ShaderPlain.vsh",
-                  "Shaders/ShaderPlain.fsh");
+      return LoadShaders(&shader_param_, "Shaders/VS_ShaderPlain.vsh",
+                         "Shaders/ShaderPlain.fsh");
     }
-  } else {
-    // Load shader for GLES2.0
-    LoadShaders(&shader_param_, "Shaders/VS_ShaderPlain.vsh",
-                "Shaders/ShaderPlain.fsh");
+    return true;
   }
+  // Load shader for GLES2.0
+  return LoadShaders(&shader_param_, "Shaders/VS_ShaderPlain.vsh",
+                     "Shaders/ShaderPlain.fsh");
 }
 
 void MoreTeapotsRenderer::UpdateViewport() {
@@ -218,14 +227,12 @@ void MoreTeapotsRenderer::UpdateViewport() {
 // Unload
 //--------------------------------------------------------------------------------
 void MoreTeapotsRenderer::Unload() {
+  ready_ = false;
   if (vbo_) {
     glDeleteBuffers(1, &vbo_);
     vbo_ = 0;
   }
-  if (ubo_) {
-    glDeleteBuffers(1, &ubo_);
-    ubo_ = 0;
-  }
+  instances_.Release();
   if (ibo_) {
     glDeleteBuffers(1, &ibo_);
     ibo_ = 0;
@@ -239,7 +246,7 @@ void MoreTeapotsRenderer::Unload() {
 //--------------------------------------------------------------------------------
 // Update
 //--------------------------------------------------------------------------------
-void MoreTeapotsRenderer::Update(float fTime) {
+void MoreTeapotsRenderer::Update(double fTime) {
   const float CAM_X = 0.f;
   const float CAM_Y = 0.f;
   const float CAM_Z = 2000.f;
@@ -249,7 +256,7 @@ void MoreTeapotsRenderer::Update(float fTime) {
                                        ndk_helper::Vec3(0.f, 1.f, 0.f));
 
   if (camera_) {
-    camera_->Update();
+    camera_->Update(fTime);
     mat_view_ = camera_->GetTransformMatrix() * mat_view_ *
                 camera_->GetRotationMatrix();
   }
@@ -259,18 +266,10 @@ void MoreTeapotsRenderer::Update(float fTime) {
 // Render
 //--------------------------------------------------------------------------------
 void MoreTeapotsRenderer::Render() {
-  // Bind the VBO
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-
-  int32_t iStride = sizeof(TEAPOT_VERTEX);
-  // Pass the vertex data
-  glVertexAttribPointer(ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE, iStride,
-                        BUFFER_OFFSET(0));
-  glEnableVertexAttribArray(ATTRIB_VERTEX);
+  if (!ready_) return;
 
-  glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, iStride,
-                        BUFFER_OFFSET(3 * sizeof(GLfloat)));
-  glEnableVertexAttribArray(ATTRIB_NORMAL);
+  // Bind the VBO
+  BindVertices();
 
   // Bind the IB
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
@@ -296,62 +295,53 @@ void MoreTeapotsRenderer::Render() {
     // Geometry instancing, new feature in GLES3.0
     //
 
-    // Update UBO
-    glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
-    float* p = (float*)glMapBufferRange(
-        GL_UNIFORM_BUFFER, 0, teapot_x_ * teapot_y_ * teapot_z_ *
-                                  (ubo_matrix_stride_ * 2) * sizeof(float),
-        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
-    float* mat_mvp = p;
-    float* mat_mv = p + teapot_x_ * teapot_y_ * teapot_z_ * ubo_matrix_stride_;
-    for (int32_t i = 0; i < teapot_x_ * teapot_y_ * teapot_z_; ++i) {
-      // Rotation
-      float x, y;
-      vec_current_rotations_[i] += vec_rotations_[i];
-      vec_current_rotations_[i].Value(x, y);
-      ndk_helper::Mat4 mat_rotation =
-          ndk_helper::Mat4::RotationX(x) * ndk_helper::Mat4::RotationY(y);
-
-      // Feed Projection and Model View matrices to the shaders
-      ndk_helper::Mat4 mat_v = mat_view_ * vec_mat_models_[i] * mat_rotation;
-      ndk_helper::Mat4 mat_vp = mat_projection_ * mat_v;
-
-      memcpy(mat_mvp, mat_vp.Ptr(), sizeof(mat_v));
-      mat_mvp += ubo_matrix_stride_;
-
-      memcpy(mat_mv, mat_v.Ptr(), sizeof(mat_v));
-      mat_mv += ubo_matrix_stride_;
+    // The job threads cull the teapots and write the visible ones, grouped
+    // by level of detail, straight into a range of the instance stream that
+    // no frame in flight uses
+    const size_t instance_size = sizeof(TEAPOT_INSTANCE);
+    float* p = static_cast<float*>(instances_.Map(
+        teapot_x_ * teapot_y_ * teapot_z_ * instance_size));
+    transforms_.Update(mat_view_, mat_projection_, &jobs_, p);
+    if (p) {
+      instances_.Unmap(transforms_.GetVisibleCount() * instance_size);
+
+      // Instanced rendering, a draw per level of detail. ES3 has no base
+      // instance, so each draw points the attributes at its records.
+      for (int32_t l = 0; l < num_lods_; ++l) {
+        if (!transforms_.GetLodCount(l)) continue;
+        BindInstances(instances_.GetOffset() +
+                      transforms_.GetLodFirst(l) * instance_size);
+        glDrawElementsInstanced(
+            GL_TRIANGLES, lod_num_indices_[l], GL_UNSIGNED_SHORT,
+            BUFFER_OFFSET(lod_first_index_[l] * sizeof(uint16_t)),
+            transforms_.GetLodCount(l));
+      }
+      UnbindInstances();
     }
-    glUnmapBuffer(GL_UNIFORM_BUFFER);
-
-    // Instanced rendering
-    glDrawElementsInstanced(GL_TRIANGLES, num_indices_, GL_UNSIGNED_SHORT,
-                            BUFFER_OFFSET(0),
-                            teapot_x_ * teapot_y_ * teapot_z_);
+    instances_.EndFrame();
 
   } else {
     // Regular rendering pass
-    for (int32_t i = 0; i < teapot_x_ * teapot_y_ * teapot_z_; ++i) {
-      // Set diffuse
-      float x, y, z;
-      vec_colors_[i].Value(x, y, z);
-      glUniform4f(shader_param_.material_diffuse_, x, y, z, 1.f);
+    transforms_.Update(mat_view_, mat_projection_, &jobs_, NULL);
+    for (int32_t v = 0; v < transforms_.GetVisibleCount(); ++v) {
+      const int32_t i = transforms_.GetVisible(v);
+      const int32_t lod = transforms_.GetLod(i);
 
-      // Rotation
-      vec_current_rotations_[i] += vec_rotations_[i];
-      vec_current_rotations_[i].Value(x, y);
-      ndk_helper::Mat4 mat_rotation =
-          ndk_helper::Mat4::RotationX(x) * ndk_helper::Mat4::RotationY(y);
+      // Set diffuse
+      const float* color = transforms_.GetColor(i);
+      glUniform4f(shader_param_.material_diffuse_, color[0], color[1],
+                  color[2], 1.f);
 
       // Feed Projection and Model View matrices to the shaders
-      ndk_helper::Mat4 mat_v = mat_view_ * vec_mat_models_[i] * mat_rotation;
-      ndk_helper::Mat4 mat_vp = mat_projection_ * mat_v;
-      glUniformMatrix4fv(shader_param_.matrix_projection_, 1, GL_FALSE,
-                         mat_vp.Ptr());
-      glUniformMatrix4fv(shader_param_.matrix_view_, 1, GL_FALSE, mat_v.Ptr());
-
-      glDrawElements(GL_TRIANGLES, num_indices_, GL_UNSIGNED_SHORT,
-                     BUFFER_OFFSET(0));
+      float mat_v[16];
+      float mat_vp[16];
+      transforms_.GetModelView(i, mat_v);
+      transforms_.GetModelViewProjection(i, mat_vp);
+      glUniformMatrix4fv(shader_param_.matrix_projection_, 1, GL_FALSE, mat_vp);
+      glUniformMatrix4fv(shader_param_.matrix_view_, 1, GL_FALSE, mat_v);
+
+      glDrawElements(GL_TRIANGLES, lod_num_indices_[lod], GL_UNSIGNED_SHORT,
+                     BUFFER_OFFSET(lod_first_index_[lod] * sizeof(uint16_t)));
     }
   }
 
@@ -359,6 +349,74 @@ void MoreTeapotsRenderer::Render() {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+//--------------------------------------------------------------------------------
+// Vertex attributes
+//--------------------------------------------------------------------------------
+void MoreTeapotsRenderer::BindVertices() {
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  const int32_t stride = ndk_helper::vertex::GetStride(vertex_layout_);
+  const void* normal_offset =
+      BUFFER_OFFSET(ndk_helper::vertex::GetNormalOffset(vertex_layout_));
+
+  // The packed attributes carry w, which the shaders' vec3 inputs drop
+  switch (vertex_layout_) {
+    case ndk_helper::VERTEX_LAYOUT_PACKED:
+      glVertexAttribPointer(ATTRIB_VERTEX, 4, GL_HALF_FLOAT, GL_FALSE, stride,
+                            BUFFER_OFFSET(0));
+      glVertexAttribPointer(ATTRIB_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                            stride, normal_offset);
+      break;
+    case ndk_helper::VERTEX_LAYOUT_HALF_POSITION:
+      glVertexAttribPointer(ATTRIB_VERTEX, 4, GL_HALF_FLOAT_OES, GL_FALSE,
+                            stride, BUFFER_OFFSET(0));
+      glVertexAttribPointer(ATTRIB_NORMAL, 4, GL_SHORT, GL_TRUE, stride,
+                            normal_offset);
+      break;
+    default:
+      glVertexAttribPointer(ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE, stride,
+                            BUFFER_OFFSET(0));
+      glVertexAttribPointer(ATTRIB_NORMAL, 4, GL_SHORT, GL_TRUE, stride,
+                            normal_offset);
+      break;
+  }
+  glEnableVertexAttribArray(ATTRIB_VERTEX);
+  glEnableVertexAttribArray(ATTRIB_NORMAL);
+}
+
+//--------------------------------------------------------------------------------
+// Instance attributes
+//--------------------------------------------------------------------------------
+void MoreTeapotsRenderer::BindInstances(const size_t offset) {
+  glBindBuffer(GL_ARRAY_BUFFER, instances_.GetBuffer());
+  const int32_t stride = sizeof(TEAPOT_INSTANCE);
+  for (int32_t c = 0; c < 4; ++c) {
+    glVertexAttribPointer(
+        ATTRIB_INSTANCE_MVP + c, 4, GL_FLOAT, GL_FALSE, stride,
+        BUFFER_OFFSET(offset + offsetof(TEAPOT_INSTANCE, mvp) +
+                      c * 4 * sizeof(float)));
+  }
+  for (int32_t c = 0; c < 3; ++c) {
+    glVertexAttribPointer(
+        ATTRIB_INSTANCE_NORMAL_MATRIX + c, 3, GL_FLOAT, GL_FALSE, stride,
+        BUFFER_OFFSET(offset + offsetof(TEAPOT_INSTANCE, normal_matrix) +
+                      c * 3 * sizeof(float)));
+  }
+  glVertexAttribPointer(
+      ATTRIB_INSTANCE_DIFFUSE, 3, GL_FLOAT, GL_FALSE, stride,
+      BUFFER_OFFSET(offset + offsetof(TEAPOT_INSTANCE, diffuse)));
+  for (int32_t a = ATTRIB_INSTANCE_MVP; a <= ATTRIB_INSTANCE_DIFFUSE; ++a) {
+    glVertexAttribDivisor(a, 1);
+    glEnableVertexAttribArray(a);
+  }
+}
+
+void MoreTeapotsRenderer::UnbindInstances() {
+  for (int32_t a = ATTRIB_INSTANCE_MVP; a <= ATTRIB_INSTANCE_DIFFUSE; ++a) {
+    glDisableVertexAttribArray(a);
+    glVertexAttribDivisor(a, 0);
+  }
+}
+
 //--------------------------------------------------------------------------------
 // LoadShaders
 //--------------------------------------------------------------------------------
@@ -370,56 +428,21 @@ bool MoreTeapotsRenderer::LoadShaders(SHADER_PARAMS* params, const char* strVsh,
   // before linking
   //
   GLuint program;
-  GLuint vertShader, fragShader;
-
-  // Create shader program
-  program = glCreateProgram();
-  LOGI("Created Shader %d", program);
-
-  // Create and compile vertex shader
-  if (!ndk_helper::shader::CompileShader(&vertShader, GL_VERTEX_SHADER,
-                                         strVsh)) {
-    LOGI("Failed to compile vertex shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Create and compile fragment shader
-  if (!ndk_helper::shader::CompileShader(&fragShader, GL_FRAGMENT_SHADER,
-                                         strFsh)) {
-    LOGI("Failed to compile fragment shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Attach vertex shader to program
-  glAttachShader(program, vertShader);
-
-  // Attach fragment shader to program
-  glAttachShader(program, fragShader);
 
   // Bind attribute locations
   // this needs to be done prior to linking
-  glBindAttribLocation(program, ATTRIB_VERTEX, "myVertex");
-  glBindAttribLocation(program, ATTRIB_NORMAL, "myNormal");
-
-  // Link program
-  if (!ndk_helper::shader::LinkProgram(program)) {
-    LOGI("Failed to link program: %d", program);
-
-    if (vertShader) {
-      glDeleteShader(vertShader);
-      vertShader = 0;
-    }
-    if (fragShader) {
-      glDeleteShader(fragShader);
-      fragShader = 0;
-    }
-    if (program) {
-      glDeleteProgram(program);
-    }
+  std::map<std::string, GLuint> attributes;
+  attributes["myVertex"] = ATTRIB_VERTEX;
+  attributes["myNormal"] = ATTRIB_NORMAL;
+
+  // Compile and link, or load the program from the binary cache
+  if (!ndk_helper::shader::CreateProgram(&program, strVsh, strFsh,
+                                         std::map<std::string, std::string>(),
+                                         attributes)) {
+    LOGI("Failed to create program");
     return false;
   }
+  LOGI("Created Shader %d", program);
 
   // Get uniform locations
   params->matrix_projection_ = glGetUniformLocation(program, "uPMatrix");
@@ -431,10 +454,6 @@ bool MoreTeapotsRenderer::LoadShaders(SHADER_PARAMS* params, const char* strVsh,
   params->material_specular_ =
       glGetUniformLocation(program, "vMaterialSpecular");
 
-  // Release vertex and fragment shaders
-  if (vertShader) glDeleteShader(vertShader);
-  if (fragShader) glDeleteShader(fragShader);
-
   params->program_ = program;
   return true;
 }
@@ -448,52 +467,14 @@ bool MoreTeapotsRenderer::LoadShadersES3(
   // directly with layout() attribute
   //
   GLuint program;
-  GLuint vertShader, fragShader;
-
-  // Create shader program
-  program = glCreateProgram();
-  LOGI("Created Shader %d", program);
-
-  // Create and compile vertex shader
-  if (!ndk_helper::shader::CompileShader(&vertShader, GL_VERTEX_SHADER, strVsh,
-                                         shaderParams)) {
-    LOGI("Failed to compile vertex shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Create and compile fragment shader
-  if (!ndk_helper::shader::CompileShader(&fragShader, GL_FRAGMENT_SHADER,
-                                         strFsh, shaderParams)) {
-    LOGI("Failed to compile fragment shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Attach vertex shader to program
-  glAttachShader(program, vertShader);
-
-  // Attach fragment shader to program
-  glAttachShader(program, fragShader);
-
-  // Link program
-  if (!ndk_helper::shader::LinkProgram(program)) {
-    LOGI("Failed to link program: %d", program);
-
-    if (vertShader) {
-      glDeleteShader(vertShader);
-      vertShader = 0;
-    }
-    if (fragShader) {
-      glDeleteShader(fragShader);
-      fragShader = 0;
-    }
-    if (program) {
-      glDeleteProgram(program);
-    }
 
+  // Compile and link, or load the program from the binary cache
+  if (!ndk_helper::shader::CreateProgram(&program, strVsh, strFsh, shaderParams,
+                                         std::map<std::string, GLuint>())) {
+    LOGI("Failed to create program");
     return false;
   }
+  LOGI("Created Shader %d", program);
 
   // Get uniform locations
   params->light0_ = glGetUniformLocation(program, "vLight0");
@@ -501,10 +482,6 @@ bool MoreTeapotsRenderer::LoadShadersES3(
   params->material_specular_ =
       glGetUniformLocation(program, "vMaterialSpecular");
 
-  // Release vertex and fragment shaders
-  if (vertShader) glDeleteShader(vertShader);
-  if (fragShader) glDeleteShader(fragShader);
-
   params->program_ = program;
   return true;
 }
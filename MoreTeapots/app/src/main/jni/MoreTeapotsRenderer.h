@@ -42,19 +42,27 @@
 #define APPLICATION_CLASS_NAME "com/sample/moreteapots/MoreTeapotsApplication"
 
 #include "NDKHelper.h"
+#include "TeapotTransforms.h"
 
 #define BUFFER_OFFSET(i) ((char*)NULL + (i))
 
-struct TEAPOT_VERTEX {
-  float pos[3];
-  float normal[3];
+// Per instance vertex attributes, as TeapotTransforms writes them
+struct TEAPOT_INSTANCE {
+  float mvp[16];
+  float normal_matrix[9];
+  float diffuse[3];
 };
+static_assert(sizeof(TEAPOT_INSTANCE) == TEAPOT_INSTANCE_FLOATS * sizeof(float),
+              "TEAPOT_INSTANCE must match TeapotTransforms' records");
 
 enum SHADER_ATTRIBUTES {
   ATTRIB_VERTEX,
   ATTRIB_NORMAL,
   ATTRIB_COLOR,
-  ATTRIB_UV
+  ATTRIB_UV,
+  ATTRIB_INSTANCE_MVP,  // mat4, 4 locations
+  ATTRIB_INSTANCE_NORMAL_MATRIX = ATTRIB_INSTANCE_MVP + 4,  // mat3
+  ATTRIB_INSTANCE_DIFFUSE = ATTRIB_INSTANCE_NORMAL_MATRIX + 3
 };
 
 struct SHADER_PARAMS {
@@ -74,11 +82,16 @@ struct TEAPOT_MATERIALS {
 };
 
 class MoreTeapotsRenderer {
-  int32_t num_indices_;
+  // Index range of each level of detail in the index buffer
+  int32_t num_lods_;
+  int32_t lod_first_index_[TEAPOT_MAX_LODS];
+  int32_t lod_num_indices_[TEAPOT_MAX_LODS];
   int32_t num_vertices_;
+  // Picked from the context in Init()
+  ndk_helper::VERTEX_LAYOUT vertex_layout_;
   GLuint ibo_;
   GLuint vbo_;
-  GLuint ubo_;
+  ndk_helper::StreamBuffer instances_;
 
   SHADER_PARAMS shader_param_;
   bool LoadShaders(SHADER_PARAMS* params, const char* strVsh,
@@ -89,29 +102,40 @@ class MoreTeapotsRenderer {
 
   ndk_helper::Mat4 mat_projection_;
   ndk_helper::Mat4 mat_view_;
-  std::vector<ndk_helper::Mat4> vec_mat_models_;
-  std::vector<ndk_helper::Vec3> vec_colors_;
-  std::vector<ndk_helper::Vec2> vec_rotations_;
-  std::vector<ndk_helper::Vec2> vec_current_rotations_;
+
+  // Per teapot transforms, culling and level of detail, updated in parallel
+  // on the job threads
+  TeapotTransforms transforms_;
+  ndk_helper::JobSystem jobs_;
 
   ndk_helper::TapCamera* camera_;
 
   int32_t teapot_x_;
   int32_t teapot_y_;
   int32_t teapot_z_;
-  int32_t ubo_matrix_stride_;
-  int32_t ubo_vector_stride_;
   bool geometry_instancing_support_;
-  bool arb_support_;
 
+  // Set once the loader has committed the programs and the buffers
+  bool ready_;
+  static bool LoadResources(void* data);
+  static void CommitResources(void* data, const bool succeeded);
+  void LoadBuffers();
+  bool LoadPrograms();
+
+  void BindVertices();
+  void BindInstances(const size_t offset);
+  void UnbindInstances();
   std::string ToString(const int32_t i);
 
  public:
   MoreTeapotsRenderer();
   virtual ~MoreTeapotsRenderer();
-  void Init(const int32_t numX, const int32_t numY, const int32_t numZ);
+  // Queues the programs and the buffers on |loader|
+  void Init(ndk_helper::ResourceLoader* loader, const int32_t numX,
+            const int32_t numY, const int32_t numZ);
   void Render();
-  void Update(float dTime);
+  // dTime: predicted display time of the frame, PerfMonitor clock
+  void Update(double dTime);
   bool Bind(ndk_helper::TapCamera* camera);
   void Unload();
   void UpdateViewport();
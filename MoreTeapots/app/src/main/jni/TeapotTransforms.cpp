@@ -0,0 +1,242 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// TeapotTransforms.cpp
+//--------------------------------------------------------------------------------
+#include "TeapotTransforms.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+TeapotTransforms::TeapotTransforms()
+    : count_(0),
+      radius_(0.f),
+      num_lods_(1),
+      visible_count_(0),
+      instances_(NULL),
+      projection_scale_(0.f) {
+  memset(center_, 0, sizeof(center_));
+  memset(lod_errors_, 0, sizeof(lod_errors_));
+  memset(lod_first_, 0, sizeof(lod_first_));
+  memset(lod_count_, 0, sizeof(lod_count_));
+}
+
+//--------------------------------------------------------------------------------
+// Setup
+//--------------------------------------------------------------------------------
+void TeapotTransforms::Init(const int32_t count) {
+  count_ = count;
+  // Sized up front: the jobs write disjoint ranges and must not reallocate
+  mat_models_.Resize(count);
+  mat_rotations_.Resize(count);
+  mat_model_views_.Resize(count);
+  mat_model_view_projections_.Resize(count);
+  rotations_x_.assign(count, 0.f);
+  rotations_y_.assign(count, 0.f);
+  current_rotations_x_.assign(count, 0.f);
+  current_rotations_y_.assign(count, 0.f);
+  colors_.assign(count * 3, 1.f);
+  lods_.assign(count, -1);
+  chunk_counts_.assign(
+      (count + TEAPOT_UPDATE_GRAIN - 1) / TEAPOT_UPDATE_GRAIN * TEAPOT_MAX_LODS,
+      0);
+  visible_.assign(count, 0);
+  visible_count_ = 0;
+}
+
+void TeapotTransforms::SetTeapot(const int32_t index,
+                                 const ndk_helper::Mat4& model,
+                                 const float angle_x, const float angle_y,
+                                 const float speed_x, const float speed_y,
+                                 const float* color) {
+  mat_models_.Set(index, model);
+  current_rotations_x_[index] = angle_x;
+  current_rotations_y_[index] = angle_y;
+  rotations_x_[index] = speed_x;
+  rotations_y_[index] = speed_y;
+  memcpy(&colors_[index * 3], color, sizeof(float) * 3);
+}
+
+void TeapotTransforms::SetMesh(const float* center, const float radius,
+                               const float* lod_errors,
+                               const int32_t num_lods) {
+  memcpy(center_, center, sizeof(center_));
+  radius_ = radius;
+  num_lods_ = std::min(std::max(num_lods, 1), TEAPOT_MAX_LODS);
+  for (int32_t l = 0; l < num_lods_; ++l) lod_errors_[l] = lod_errors[l];
+}
+
+//--------------------------------------------------------------------------------
+// Update
+//--------------------------------------------------------------------------------
+void TeapotTransforms::Update(const ndk_helper::Mat4& view,
+                              const ndk_helper::Mat4& projection,
+                              ndk_helper::JobSystem* jobs,
+                              float* instances) {
+  visible_count_ = 0;
+  memset(lod_first_, 0, sizeof(lod_first_));
+  memset(lod_count_, 0, sizeof(lod_count_));
+  if (!count_) return;
+  mat_view_ = view;
+  mat_projection_ = projection;
+  instances_ = instances;
+
+  // View space frustum planes from the rows of the projection (Gribb,
+  // Hartmann), normalized so distances to them are in view units
+  const float* p = mat_projection_.Ptr();
+  for (int32_t i = 0; i < 6; ++i) {
+    const int32_t row = i / 2;
+    const float sign = i & 1 ? -1.f : 1.f;
+    float length = 0.f;
+    for (int32_t c = 0; c < 4; ++c) {
+      frustum_[i][c] = p[c * 4 + 3] + sign * p[c * 4 + row];
+      if (c < 3) length += frustum_[i][c] * frustum_[i][c];
+    }
+    length = 1.f / sqrtf(length);
+    for (int32_t c = 0; c < 4; ++c) frustum_[i][c] *= length;
+  }
+  // Normalized device units per view unit at depth 1, on the larger axis
+  projection_scale_ = std::max(fabsf(p[0]), fabsf(p[5]));
+
+  if (jobs)
+    jobs->ParallelFor(count_, TEAPOT_UPDATE_GRAIN, UpdateRange, this);
+  else
+    UpdateRange(this, 0, count_);
+
+  // Where each chunk's teapots of each level go: levels one after another,
+  // chunks in order within a level, so the order does not depend on timing
+  const int32_t num_chunks = (int32_t)chunk_counts_.size() / TEAPOT_MAX_LODS;
+  for (int32_t l = 0; l < TEAPOT_MAX_LODS; ++l) {
+    lod_first_[l] = visible_count_;
+    for (int32_t c = 0; c < num_chunks; ++c) {
+      int32_t& slot = chunk_counts_[c * TEAPOT_MAX_LODS + l];
+      int32_t chunk_count = slot;
+      slot = visible_count_;
+      visible_count_ += chunk_count;
+    }
+    lod_count_[l] = visible_count_ - lod_first_[l];
+  }
+
+  if (jobs)
+    jobs->ParallelFor(count_, TEAPOT_UPDATE_GRAIN, CompactRange, this);
+  else
+    CompactRange(this, 0, count_);
+}
+
+void TeapotTransforms::UpdateRange(void* data, const int32_t begin,
+                                   const int32_t end) {
+  TeapotTransforms* t = static_cast<TeapotTransforms*>(data);
+  for (int32_t i = begin; i < end; ++i) {
+    t->current_rotations_x_[i] += t->rotations_x_[i];
+    t->current_rotations_y_[i] += t->rotations_y_[i];
+  }
+  ndk_helper::ComposeRotationsXY(&t->current_rotations_x_[0],
+                                 &t->current_rotations_y_[0],
+                                 t->mat_rotations_, begin, end);
+
+  // view * model * rotation, then projection * that
+  ndk_helper::MultiplyMany(t->mat_view_, t->mat_models_, t->mat_model_views_,
+                           begin, end);
+  ndk_helper::MultiplyMany(t->mat_model_views_, t->mat_rotations_,
+                           t->mat_model_views_, begin, end);
+  ndk_helper::MultiplyMany(t->mat_projection_, t->mat_model_views_,
+                           t->mat_model_view_projections_, begin, end);
+
+  t->Classify(begin, end);
+}
+
+void TeapotTransforms::Classify(const int32_t begin, const int32_t end) {
+  const float* m[16];
+  for (int32_t c = 0; c < 16; ++c) m[c] = mat_model_views_.Component(c);
+
+  // Levels are allowed from this projected radius down
+  float min_size[TEAPOT_MAX_LODS];
+  for (int32_t l = 0; l < num_lods_; ++l)
+    min_size[l] = lod_errors_[l] > 0.f
+                      ? radius_ * TEAPOT_LOD_MAX_ERROR / lod_errors_[l]
+                      : HUGE_VALF;
+
+  for (int32_t i = begin; i < end; ++i) {
+    int32_t* counts =
+        &chunk_counts_[i / TEAPOT_UPDATE_GRAIN * TEAPOT_MAX_LODS];
+    if (i == begin || i % TEAPOT_UPDATE_GRAIN == 0)
+      memset(counts, 0, sizeof(int32_t) * TEAPOT_MAX_LODS);
+
+    // Sphere center in view space
+    const float x = m[0][i] * center_[0] + m[4][i] * center_[1] +
+                    m[8][i] * center_[2] + m[12][i];
+    const float y = m[1][i] * center_[0] + m[5][i] * center_[1] +
+                    m[9][i] * center_[2] + m[13][i];
+    const float z = m[2][i] * center_[0] + m[6][i] * center_[1] +
+                    m[10][i] * center_[2] + m[14][i];
+
+    bool inside = true;
+    for (int32_t p = 0; p < 6; ++p)
+      inside &= frustum_[p][0] * x + frustum_[p][1] * y + frustum_[p][2] * z +
+                    frustum_[p][3] >=
+                -radius_;
+    if (!inside) {
+      lods_[i] = -1;
+      continue;
+    }
+
+    // The camera looks down -z. Errors are projected at the sphere's
+    // nearest depth; a camera inside the sphere gets the full mesh.
+    int32_t lod = 0;
+    const float depth = -z - radius_;
+    if (depth > 0.f) {
+      const float size = radius_ * projection_scale_ / depth;
+      while (lod + 1 < num_lods_ && size <= min_size[lod + 1]) ++lod;
+    }
+    lods_[i] = (int8_t)lod;
+    ++counts[lod];
+  }
+}
+
+void TeapotTransforms::CompactRange(void* data, const int32_t begin,
+                                    const int32_t end) {
+  TeapotTransforms* t = static_cast<TeapotTransforms*>(data);
+  int32_t slots[TEAPOT_MAX_LODS];
+  for (int32_t i = begin; i < end; ++i) {
+    if (i == begin || i % TEAPOT_UPDATE_GRAIN == 0)
+      memcpy(slots,
+             &t->chunk_counts_[i / TEAPOT_UPDATE_GRAIN * TEAPOT_MAX_LODS],
+             sizeof(slots));
+    const int32_t lod = t->lods_[i];
+    if (lod < 0) continue;
+
+    const int32_t slot = slots[lod]++;
+    t->visible_[slot] = i;
+    if (!t->instances_) continue;
+
+    // Assembled on the stack: the destination may be write combined memory
+    float record[TEAPOT_INSTANCE_FLOATS];
+    float mv[16];
+    t->mat_model_view_projections_.Get(i, record);
+    t->mat_model_views_.Get(i, mv);
+    for (int32_t c = 0; c < 3; ++c)
+      memcpy(&record[16 + c * 3], &mv[c * 4], sizeof(float) * 3);
+    memcpy(&record[25], &t->colors_[i * 3], sizeof(float) * 3);
+    memcpy(t->instances_ + slot * TEAPOT_INSTANCE_FLOATS, record,
+           sizeof(record));
+  }
+}
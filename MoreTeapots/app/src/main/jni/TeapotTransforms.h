@@ -0,0 +1,153 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// TeapotTransforms.h
+// Per teapot animation and matrices, updated on the job threads
+//--------------------------------------------------------------------------------
+#ifndef _TeapotTransforms_H
+#define _TeapotTransforms_H
+
+#include <vector>
+
+#include "vecmath.h"
+#include "vecmathArray.h"
+#include "jobSystem.h"
+
+// Teapots per job; a multiple of 4 so jobs never share a SIMD lane
+const int32_t TEAPOT_UPDATE_GRAIN = 128;
+const int32_t TEAPOT_MAX_LODS = 4;
+// Largest on screen error a level of detail may add, in normalized device
+// coordinates: about two pixels on a viewport 1080 pixels on its short side
+const float TEAPOT_LOD_MAX_ERROR = 0.004f;
+// Floats per instance record: the MVP, the model view's upper 3x3 (both
+// column major) and the diffuse color
+const int32_t TEAPOT_INSTANCE_FLOATS = 16 + 9 + 3;
+
+/******************************************************************
+ * Transforms of all teapots
+ * Update() advances the rotations and computes the model view and MVP
+ * matrices in parallel chunks. Teapots whose bounding sphere is outside the
+ * view frustum are culled; the others get the coarsest level of detail whose
+ * error, projected to the screen at the nearest depth of the sphere, stays
+ * under TEAPOT_LOD_MAX_ERROR.
+ *
+ * The visible teapots are then compacted, grouped by level of detail, into
+ * instance records for per instance vertex attributes, written straight
+ * into the caller's (mapped) memory. Only the first GetVisibleCount()
+ * records are written, and level |l| is drawn with records
+ * [GetLodFirst(l), + GetLodCount(l)).
+ *
+ * Transforms must not scale: the bounding radius is used as is.
+ * No GL calls, so the update can be run and measured off device.
+ */
+class TeapotTransforms {
+ private:
+  int32_t count_;
+  ndk_helper::Mat4Array mat_models_;
+  ndk_helper::Mat4Array mat_rotations_;
+  ndk_helper::Mat4Array mat_model_views_;
+  ndk_helper::Mat4Array mat_model_view_projections_;
+  std::vector<float> rotations_x_;
+  std::vector<float> rotations_y_;
+  std::vector<float> current_rotations_x_;
+  std::vector<float> current_rotations_y_;
+
+  std::vector<float> colors_;
+
+  // Bounding sphere and level of detail thresholds, in model space
+  float center_[3];
+  float radius_;
+  int32_t num_lods_;
+  float lod_errors_[TEAPOT_MAX_LODS];
+
+  // Level of detail of each teapot, -1 if culled, and the number of
+  // teapots per level in each chunk, then where the chunk's first goes
+  std::vector<int8_t> lods_;
+  std::vector<int32_t> chunk_counts_;
+  int32_t visible_count_;
+  int32_t lod_first_[TEAPOT_MAX_LODS];
+  int32_t lod_count_[TEAPOT_MAX_LODS];
+  std::vector<int32_t> visible_;
+
+  // Inputs of the update being run
+  float* instances_;
+  ndk_helper::Mat4 mat_view_;
+  ndk_helper::Mat4 mat_projection_;
+  float frustum_[6][4];
+  float projection_scale_;
+
+  static void UpdateRange(void* data, const int32_t begin, const int32_t end);
+  static void CompactRange(void* data, const int32_t begin,
+                           const int32_t end);
+  void Classify(const int32_t begin, const int32_t end);
+
+ public:
+  TeapotTransforms();
+
+  void Init(const int32_t count);
+  /*
+   * arguments:
+   * in: model, placement of the teapot
+   * in: angle_x, angle_y, initial rotation in radians
+   * in: speed_x, speed_y, rotation per Update() in radians
+   * in: color, diffuse rgb
+   */
+  void SetTeapot(const int32_t index, const ndk_helper::Mat4& model,
+                 const float angle_x, const float angle_y, const float speed_x,
+                 const float speed_y, const float* color);
+
+  /*
+   * arguments:
+   * in: center, radius, bounding sphere of the mesh
+   * in: lod_errors, largest distance of each level of detail to the full
+   *     mesh, increasing, starting with the full mesh's 0
+   */
+  void SetMesh(const float* center, const float radius,
+               const float* lod_errors, const int32_t num_lods);
+
+  /*
+   * arguments:
+   * in: view, projection
+   * in: jobs, job system to update on, NULL to update on this thread
+   * out: instances, room for GetCount() records of TEAPOT_INSTANCE_FLOATS,
+   *      or NULL for none
+   */
+  void Update(const ndk_helper::Mat4& view,
+              const ndk_helper::Mat4& projection, ndk_helper::JobSystem* jobs,
+              float* instances);
+
+  int32_t GetCount() const { return count_; }
+  void GetModelView(const int32_t index, float* out) const {
+    mat_model_views_.Get(index, out);
+  }
+  void GetModelViewProjection(const int32_t index, float* out) const {
+    mat_model_view_projections_.Get(index, out);
+  }
+  const float* GetColor(const int32_t index) const {
+    return &colors_[index * 3];
+  }
+  // Level of detail of teapot |index| in the last update, -1 if culled
+  int32_t GetLod(const int32_t index) const { return lods_[index]; }
+
+  // Visible teapots of the last update, grouped by level of detail
+  int32_t GetVisibleCount() const { return visible_count_; }
+  int32_t GetVisible(const int32_t i) const { return visible_[i]; }
+  int32_t GetLodFirst(const int32_t lod) const { return lod_first_[lod]; }
+  int32_t GetLodCount(const int32_t lod) const { return lod_count_[lod]; }
+};
+
+#endif
@@ -20,8 +20,10 @@
 //--------------------------------------------------------------------------------
 // includes
 //--------------------------------------------------------------------------------
+#include <string.h>
 #include <unistd.h>
 #include "GLContext.h"
+#include "eglLoaderBackend.h"
 #include "gl3stub.h"
 
 namespace ndk_helper {
@@ -39,6 +41,10 @@ GLContext::GLContext()
       context_(EGL_NO_CONTEXT),
       screen_width_(0),
       screen_height_(0),
+      render_width_(0),
+      render_height_(0),
+      render_scale_(1.f),
+      render_size_pending_(false),
       gles_initialized_(false),
       egl_context_initialized_(false),
       es3_supported_(false) {}
@@ -116,10 +122,50 @@ bool GLContext::InitEGLSurface() {
     return false;
   }
 
+  return CreateSurface();
+}
+
+bool GLContext::CreateSurface() {
+  // The window's own size first, then the buffers at the render scale
+  ANativeWindow_setBuffersGeometry(window_, 0, 0, 0);
+  screen_width_ = ANativeWindow_getWidth(window_);
+  screen_height_ = ANativeWindow_getHeight(window_);
+  if (render_scale_ < 1.f) {
+    ANativeWindow_setBuffersGeometry(
+        window_, (int32_t)(screen_width_ * render_scale_ + 0.5f),
+        (int32_t)(screen_height_ * render_scale_ + 0.5f), 0);
+  }
+
   surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
-  eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
-  eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
+  eglQuerySurface(display_, surface_, EGL_WIDTH, &render_width_);
+  eglQuerySurface(display_, surface_, EGL_HEIGHT, &render_height_);
+  render_size_pending_ = false;
+  return surface_ != EGL_NO_SURFACE;
+}
+
+bool GLContext::SetRenderScale(const float scale) {
+  float clamped = scale < 1.f ? scale : 1.f;
+  if (clamped == render_scale_) return true;
+  // Without a surface, Resume() applies it
+  if (surface_ == EGL_NO_SURFACE) {
+    render_scale_ = clamped;
+    return true;
+  }
 
+  // The surface stays; it takes the new size with the next buffer it
+  // dequeues, at the next eglSwapBuffers(). 0x0 is the window's own size.
+  int32_t width = 0;
+  int32_t height = 0;
+  if (clamped < 1.f) {
+    width = (int32_t)(screen_width_ * clamped + 0.5f);
+    height = (int32_t)(screen_height_ * clamped + 0.5f);
+  }
+  if (ANativeWindow_setBuffersGeometry(window_, width, height, 0) < 0) {
+    LOGW("Unable to resize the surface to scale %f", clamped);
+    return false;
+  }
+  render_scale_ = clamped;
+  render_size_pending_ = true;
   return true;
 }
 
@@ -154,6 +200,11 @@ EGLint GLContext::Swap() {
     }
     return err;
   }
+  if (render_size_pending_) {
+    eglQuerySurface(display_, surface_, EGL_WIDTH, &render_width_);
+    eglQuerySurface(display_, surface_, EGL_HEIGHT, &render_height_);
+    render_size_pending_ = false;
+  }
   return EGL_SUCCESS;
 }
 
@@ -187,9 +238,7 @@ EGLint GLContext::Resume(ANativeWindow* window) {
 
   // Create surface
   window_ = window;
-  surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
-  eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
-  eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
+  CreateSurface();
 
   if (screen_width_ != original_widhth || screen_height_ != original_height) {
     // Screen resized
@@ -230,6 +279,46 @@ bool GLContext::Invalidate() {
   return true;
 }
 
+LoaderBackend* GLContext::CreateLoaderBackend() {
+  if (display_ == EGL_NO_DISPLAY || context_ == EGL_NO_CONTEXT) return NULL;
+
+  // The window config can usually make pbuffers too; if not, any ES2 config
+  // that can will do, objects are shared whatever the configs
+  EGLConfig config = config_;
+  EGLint surface_type = 0;
+  eglGetConfigAttrib(display_, config_, EGL_SURFACE_TYPE, &surface_type);
+  if (!(surface_type & EGL_PBUFFER_BIT)) {
+    const EGLint attribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                              EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE};
+    EGLint num_configs = 0;
+    eglChooseConfig(display_, attribs, &config, 1, &num_configs);
+    if (!num_configs) {
+      LOGW("Unable to retrieve an EGL config for the loader");
+      return NULL;
+    }
+  }
+
+  const EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION,
+                                    2,  // Request opengl ES2.0
+                                    EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display_, config, context_, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    LOGW("Unable to create a shared context %d", eglGetError());
+    return NULL;
+  }
+
+  const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+  EGLSurface surface =
+      eglCreatePbufferSurface(display_, config, pbuffer_attribs);
+  if (surface == EGL_NO_SURFACE) {
+    LOGW("Unable to create a pbuffer %d", eglGetError());
+    eglDestroyContext(display_, context);
+    return NULL;
+  }
+  return new EGLLoaderBackend(display_, context, surface);
+}
+
 bool GLContext::CheckExtension(const char* extension) {
   if (extension == NULL) return false;
 
@@ -15,8 +15,7 @@
  */
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
-#include <fstream>
-#include <iostream>
+#include <string.h>
 
 #include "JNIHelper.h"
 
@@ -90,6 +89,16 @@ void JNIHelper::Init(ANativeActivity* activity, const char* helper_class_name) {
   helper.jni_helper_java_ref_ = env->NewGlobalRef(helper.jni_helper_java_ref_);
 
   env->ReleaseStringUTFChars(packageName, appname);
+
+  // Resolve the external files dir once, so file reads need no JNI
+  jstring str_path = helper.GetExternalFilesDirJString(env);
+  const char* path = str_path ? env->GetStringUTFChars(str_path, NULL) : NULL;
+  AssetCache::GetInstance()->Init(activity->assetManager, path);
+  if (path) {
+    env->ReleaseStringUTFChars(str_path, path);
+    env->DeleteLocalRef(str_path);
+  }
+
   helper.activity_->vm->DetachCurrentThread();
 
   pthread_mutex_unlock(&helper.mutex_);
@@ -107,63 +116,15 @@ bool JNIHelper::ReadFile(const char* fileName,
     return false;
   }
 
-  // First, try reading from externalFileDir;
-  JNIEnv* env;
-
-  pthread_mutex_lock(&mutex_);
-  activity_->vm->AttachCurrentThread(&env, NULL);
-
-  jstring str_path = GetExternalFilesDirJString(env);
-  const char* path = env->GetStringUTFChars(str_path, NULL);
-  std::string s(path);
-
-  if (fileName[0] != '/') {
-    s.append("/");
+  // Looks in externalFileDir first, then in the APK; no JNI or lock involved
+  AssetView view = AssetCache::GetInstance()->Open(fileName);
+  if (!view.IsValid()) {
+    LOGI("Failed to load:%s", fileName);
+    return false;
   }
-  s.append(fileName);
-  std::ifstream f(s.c_str(), std::ios::binary);
 
-  env->ReleaseStringUTFChars(str_path, path);
-  env->DeleteLocalRef(str_path);
-  activity_->vm->DetachCurrentThread();
-
-  if (f) {
-    LOGI("reading:%s", s.c_str());
-    f.seekg(0, std::ifstream::end);
-    int32_t fileSize = f.tellg();
-    f.seekg(0, std::ifstream::beg);
-    buffer_ref->reserve(fileSize);
-    buffer_ref->assign(std::istreambuf_iterator<char>(f),
-                       std::istreambuf_iterator<char>());
-    f.close();
-    pthread_mutex_unlock(&mutex_);
-    return true;
-  } else {
-    // Fallback to assetManager
-    AAssetManager* assetManager = activity_->assetManager;
-    AAsset* assetFile =
-        AAssetManager_open(assetManager, fileName, AASSET_MODE_BUFFER);
-    if (!assetFile) {
-      pthread_mutex_unlock(&mutex_);
-      return false;
-    }
-    uint8_t* data = (uint8_t*)AAsset_getBuffer(assetFile);
-    int32_t size = AAsset_getLength(assetFile);
-    if (data == NULL) {
-      AAsset_close(assetFile);
-
-      LOGI("Failed to load:%s", fileName);
-      pthread_mutex_unlock(&mutex_);
-      return false;
-    }
-
-    buffer_ref->reserve(size);
-    buffer_ref->assign(data, data + size);
-
-    AAsset_close(assetFile);
-    pthread_mutex_unlock(&mutex_);
-    return true;
-  }
+  buffer_ref->assign(view.Data(), view.Data() + view.Size());
+  return true;
 }
 
 std::string JNIHelper::GetExternalFilesDir() {
@@ -23,6 +23,12 @@
 #include <android/log.h>
 #include <android_native_app_glue.h>
 
+#include "assetCache.h"
+
+// Replace the host versions of logging.h, if it came first
+#undef LOGI
+#undef LOGW
+#undef LOGE
 #define LOGI(...)                                                           \
   ((void)__android_log_print(                                               \
       ANDROID_LOG_INFO, ndk_helper::JNIHelper::GetInstance()->GetAppName(), \
@@ -100,6 +106,8 @@ class JNIHelper {
    * First, the method tries to read the file from an external storage.
    * If it fails to read, it falls back to use assset manager and try to read
    *the file from APK asset.
+   * The contents are copied; AssetCache::Open() gives the same file without
+   *a copy.
    *
    * arguments:
    * in: file_name, file name to read
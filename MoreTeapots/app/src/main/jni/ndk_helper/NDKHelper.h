@@ -32,9 +32,18 @@
 #include "GLContext.h"  //EGL & OpenGL manager
 #include "shader.h"     //Shader compiler support
 #include "vecmath.h"  //Vector math support, C++ implementation n current version
+#include "vecmathArray.h"     //Batched (SoA) vector math
+#include "mesh.h"             //Binary mesh format
 #include "tapCamera.h"        //Tap/Pinch camera control
+#include "inputResampler.h"   //Touch samples resampled at frame time
 #include "JNIHelper.h"        //JNI support
 #include "gestureDetector.h"  //Tap/Doubletap/Pinch detector
 #include "perfMonitor.h"      //FPS counter
+#include "resolutionController.h"  //Dynamic render resolution
 #include "interpolator.h"     //Interpolator
+#include "jobSystem.h"        //Work stealing ParallelFor
+#include "ringAllocator.h"     //Frame ring allocator for streamed data
+#include "streamBuffer.h"      //Fenced, unsynchronized buffer streaming
+#include "resourceLoader.h"    //GL resources loaded on a shared context
+#include "vertexFormat.h"      //Packed vertex layouts
 #endif
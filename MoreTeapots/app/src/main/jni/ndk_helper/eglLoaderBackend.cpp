@@ -0,0 +1,111 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// eglLoaderBackend.cpp
+//--------------------------------------------------------------------------------
+#include "eglLoaderBackend.h"
+
+#include <string.h>
+
+#include <GLES2/gl2.h>
+
+#include "JNIHelper.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+EGLLoaderBackend::EGLLoaderBackend(EGLDisplay display, EGLContext context,
+                                   EGLSurface surface)
+    : display_(display),
+      context_(context),
+      surface_(surface),
+      eglCreateSyncKHR_(NULL),
+      eglDestroySyncKHR_(NULL),
+      eglClientWaitSyncKHR_(NULL) {
+  const char* extensions = eglQueryString(display_, EGL_EXTENSIONS);
+  if (extensions && strstr(extensions, "EGL_KHR_fence_sync")) {
+    eglCreateSyncKHR_ =
+        (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    eglDestroySyncKHR_ =
+        (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    eglClientWaitSyncKHR_ = (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress(
+        "eglClientWaitSyncKHR");
+  }
+  if (!eglCreateSyncKHR_ || !eglDestroySyncKHR_ || !eglClientWaitSyncKHR_) {
+    LOGI("No EGL_KHR_fence_sync, the loader finishes every task");
+    eglCreateSyncKHR_ = NULL;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+EGLLoaderBackend::~EGLLoaderBackend() {
+  if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
+  if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
+}
+
+//--------------------------------------------------------------------------------
+// Loader thread
+//--------------------------------------------------------------------------------
+bool EGLLoaderBackend::MakeCurrent() {
+  if (eglMakeCurrent(display_, surface_, surface_, context_) == EGL_FALSE) {
+    LOGW("Unable to eglMakeCurrent the loader context %d", eglGetError());
+    return false;
+  }
+  return true;
+}
+
+void EGLLoaderBackend::ReleaseCurrent() {
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglReleaseThread();
+}
+
+void* EGLLoaderBackend::CreateFence() {
+  if (eglCreateSyncKHR_) {
+    EGLSyncKHR sync = eglCreateSyncKHR_(display_, EGL_SYNC_FENCE_KHR, NULL);
+    if (sync != EGL_NO_SYNC_KHR) {
+      // The fence is signaled only once the commands reach the GPU, and the
+      // GL thread can not flush this context
+      glFlush();
+      return sync;
+    }
+  }
+  glFinish();
+  return NULL;
+}
+
+//--------------------------------------------------------------------------------
+// GL thread
+//--------------------------------------------------------------------------------
+bool EGLLoaderBackend::IsFenceSignaled(void* fence) {
+  EGLint result = eglClientWaitSyncKHR_(display_, (EGLSyncKHR)fence, 0, 0);
+  // An error would never clear; do not wait on it forever
+  return result != EGL_TIMEOUT_EXPIRED_KHR;
+}
+
+void EGLLoaderBackend::WaitFence(void* fence) {
+  eglClientWaitSyncKHR_(display_, (EGLSyncKHR)fence, 0, EGL_FOREVER_KHR);
+}
+
+void EGLLoaderBackend::DeleteFence(void* fence) {
+  eglDestroySyncKHR_(display_, (EGLSyncKHR)fence);
+}
+
+}  // namespace ndkHelper
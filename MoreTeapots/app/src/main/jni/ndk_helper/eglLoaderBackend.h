@@ -0,0 +1,62 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EGL_LOADER_BACKEND_H_
+#define EGL_LOADER_BACKEND_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "resourceLoader.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * EGL backend of ResourceLoader
+ * A context sharing objects with the GL thread's context, current on a 1x1
+ * pbuffer on the loader thread. Fences are EGL_KHR_fence_sync objects, so
+ * the GL thread can poll them without a context switch; without the
+ * extension every task ends with glFinish() on the loader thread instead.
+ *
+ * Create it with GLContext::CreateLoaderBackend(), which owns the choice of
+ * config; the backend destroys the context and the surface it is given.
+ */
+class EGLLoaderBackend : public LoaderBackend {
+ private:
+  EGLDisplay display_;
+  EGLContext context_;
+  EGLSurface surface_;
+
+  PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR_;
+  PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR_;
+  PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR_;
+
+ public:
+  EGLLoaderBackend(EGLDisplay display, EGLContext context,
+                   EGLSurface surface);
+  virtual ~EGLLoaderBackend();
+
+  virtual bool MakeCurrent();
+  virtual void ReleaseCurrent();
+  virtual void* CreateFence();
+
+  virtual bool IsFenceSignaled(void* fence);
+  virtual void WaitFence(void* fence);
+  virtual void DeleteFence(void* fence);
+};
+
+}  // namespace ndkHelper
+#endif /* EGL_LOADER_BACKEND_H_ */
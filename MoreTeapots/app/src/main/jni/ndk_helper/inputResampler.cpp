@@ -0,0 +1,121 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// inputResampler.cpp
+//--------------------------------------------------------------------------------
+#include "inputResampler.h"
+
+namespace ndk_helper {
+
+void InputResampler::AddSample(const double time, const Vec2* pointers,
+                               const int32_t num_pointers) {
+  Sample* sample;
+  if (count_ && time <= GetSample(count_ - 1).time_) {
+    if (time < GetSample(count_ - 1).time_) return;
+    sample = &samples_[(head_ + count_ - 1) % INPUT_MAX_SAMPLES];
+  } else if (count_ == INPUT_MAX_SAMPLES) {
+    sample = &samples_[head_];
+    head_ = (head_ + 1) % INPUT_MAX_SAMPLES;
+  } else {
+    sample = &samples_[(head_ + count_) % INPUT_MAX_SAMPLES];
+    ++count_;
+  }
+
+  sample->time_ = time;
+  for (int32_t i = 0; i < INPUT_MAX_POINTERS; ++i)
+    sample->pointers_[i] = i < num_pointers ? pointers[i] : Vec2();
+}
+
+bool InputResampler::Resample(const double time, Vec2* pointers) const {
+  if (!count_) return false;
+
+  // Newest sample at or before the time
+  int32_t i = count_ - 1;
+  while (i >= 0 && GetSample(i).time_ > time) --i;
+
+  const Sample* a;
+  const Sample* b;
+  double t = time;
+  if (i < 0 || (i == count_ - 1 && count_ < 2)) {
+    // Before the first sample, or nothing to extrapolate from
+    const Sample& s = GetSample(i < 0 ? 0 : i);
+    for (int32_t p = 0; p < INPUT_MAX_POINTERS; ++p)
+      pointers[p] = s.pointers_[p];
+    return true;
+  } else if (i < count_ - 1) {
+    a = &GetSample(i);
+    b = &GetSample(i + 1);
+  } else {
+    a = &GetSample(count_ - 2);
+    b = &GetSample(count_ - 1);
+    double interval = b->time_ - a->time_;
+    if (interval < INPUT_MIN_SAMPLE_INTERVAL) {
+      t = b->time_;
+    } else {
+      double prediction = interval * 0.5;
+      if (prediction > INPUT_MAX_PREDICTION) prediction = INPUT_MAX_PREDICTION;
+      if (t > b->time_ + prediction) t = b->time_ + prediction;
+    }
+  }
+
+  const float alpha = (float)((t - a->time_) / (b->time_ - a->time_));
+  for (int32_t p = 0; p < INPUT_MAX_POINTERS; ++p)
+    pointers[p] =
+        a->pointers_[p] + (b->pointers_[p] - a->pointers_[p]) * alpha;
+  return true;
+}
+
+bool InputResampler::GetLastSample(Vec2* pointers) const {
+  if (!count_) return false;
+  const Sample& s = GetSample(count_ - 1);
+  for (int32_t p = 0; p < INPUT_MAX_POINTERS; ++p)
+    pointers[p] = s.pointers_[p];
+  return true;
+}
+
+Vec2 InputResampler::GetVelocity(const int32_t pointer,
+                                 const double time) const {
+  if (count_ < 2) return Vec2();
+  const double last = GetSample(count_ - 1).time_;
+  if (time - last > INPUT_VELOCITY_STOP) return Vec2();
+
+  // Fit p = p0 + v * t; times relative to the last sample keep the sums small
+  double sum_t = 0.0, sum_tt = 0.0;
+  double sum_x = 0.0, sum_y = 0.0, sum_tx = 0.0, sum_ty = 0.0;
+  int32_t n = 0;
+  for (int32_t i = count_ - 1; i >= 0; --i) {
+    const Sample& s = GetSample(i);
+    double t = s.time_ - last;
+    if (t < -INPUT_VELOCITY_WINDOW) break;
+    float x, y;
+    Vec2 p = s.pointers_[pointer];
+    p.Value(x, y);
+    sum_t += t;
+    sum_tt += t * t;
+    sum_x += x;
+    sum_y += y;
+    sum_tx += t * x;
+    sum_ty += t * y;
+    ++n;
+  }
+  double denominator = n * sum_tt - sum_t * sum_t;
+  if (n < 2 || denominator <= 0.0) return Vec2();
+  return Vec2((float)((n * sum_tx - sum_t * sum_x) / denominator),
+              (float)((n * sum_ty - sum_t * sum_y) / denominator));
+}
+
+}  // namespace ndkHelper
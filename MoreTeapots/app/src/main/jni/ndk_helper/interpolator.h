@@ -23,6 +23,7 @@
 #include "JNIHelper.h"
 #include "perfMonitor.h"
 #include <list>
+#include <vector>
 
 namespace ndk_helper {
 
@@ -58,9 +59,6 @@ class Interpolator {
   float dest_value_;
   std::list<InterpolatorParams> list_params_;
 
-  float GetFormula(const INTERPOLATOR_TYPE type, const float t, const float b,
-                   const float d, const float c);
-
  public:
   Interpolator();
   ~Interpolator();
@@ -74,6 +72,82 @@ class Interpolator {
   bool Update(const double currentTime, float& p);
 
   void Clear();
+
+  // Value of the curve |type| from |b| to |b| + |c|, at |t| of |d| seconds
+  static float GetFormula(const INTERPOLATOR_TYPE type, const float t,
+                          const float b, const float d, const float c);
+};
+
+/******************************************************************
+ * Evaluates many interpolated values ("channels") at once
+ * Same easing curves and keyframe queue semantics as Interpolator, but all
+ * state lives in flat arrays, one per field, and queued keyframes come from a
+ * shared pool, so nothing is allocated once the pools have grown. When a
+ * segment starts its curve is expanded into polynomial coefficients, which
+ * lets Update() evaluate every channel in one branch free loop the compiler
+ * can vectorize. Only the exponential curves need a second, scalar pass.
+ */
+const int32_t INTERPOLATOR_COEFFS = 5;
+// Start times are kept as floats relative to a base time that is moved
+// forward this often (seconds), so they keep sub-millisecond precision
+const double INTERPOLATOR_REBASE_INTERVAL = 32.0;
+
+class BatchInterpolator {
+ private:
+  // Per channel
+  std::vector<float> start_time_;    // relative to time_base_
+  std::vector<float> inv_duration_;  // 0 when the channel is not animating
+  std::vector<float> coeff_[INTERPOLATOR_COEFFS];
+  std::vector<float> progress_;
+  std::vector<float> values_;
+  std::vector<float> start_value_;
+  std::vector<float> dest_value_;
+  std::vector<uint8_t> type_;
+  std::vector<uint8_t> active_;
+  std::vector<int32_t> queue_head_;
+  std::vector<int32_t> queue_tail_;
+  std::vector<int32_t> free_channels_;
+  int32_t expo_channels_;
+
+  // Keyframe pool, linked per channel through key_next_
+  std::vector<InterpolatorParams> keys_;
+  std::vector<int32_t> key_next_;
+  int32_t free_keys_;
+
+  double time_base_;
+
+  float RelativeTime(const double time);
+  void StartSegment(const int32_t channel, const float start, const float dest,
+                    const INTERPOLATOR_TYPE type, const double duration,
+                    const float start_time);
+  void SetConstant(const int32_t channel, const float value);
+  void SetType(const int32_t channel, const INTERPOLATOR_TYPE type);
+  void ClearQueue(const int32_t channel);
+
+ public:
+  BatchInterpolator();
+  ~BatchInterpolator();
+
+  // Returns a channel id, valid until Release()
+  int32_t Create();
+  void Release(const int32_t channel);
+  int32_t Size() const { return (int32_t)values_.size(); }
+
+  // Same as Interpolator::Set/Add/Clear, for one channel
+  void Set(const int32_t channel, const float start, const float dest,
+           const INTERPOLATOR_TYPE type, const double duration);
+  void Add(const int32_t channel, const float dest,
+           const INTERPOLATOR_TYPE type, const double duration);
+  void Clear(const int32_t channel);
+
+  // Evaluate all channels at |current_time| (PerfMonitor::GetCurrentTime())
+  void Update(const double current_time);
+
+  // Results of the last Update(). A channel stays active while it is
+  // animating or has queued keyframes, i.e. what Interpolator::Update returns.
+  float GetValue(const int32_t channel) const { return values_[channel]; }
+  bool IsActive(const int32_t channel) const { return active_[channel] != 0; }
+  const float* GetValues() const { return values_.data(); }
 };
 
 }  // namespace ndkHelper
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace ndk_helper {
+
+// Runs elements [begin, end) of a ParallelFor()
+typedef void (*JobFunction)(void* data, const int32_t begin,
+                            const int32_t end);
+
+// One worker per CPU, besides the thread calling ParallelFor()
+const int32_t JOB_SYSTEM_DEFAULT_THREADS = -1;
+
+/******************************************************************
+ * Small work stealing job system for data parallel loops
+ * ParallelFor() cuts a range into chunks and deals them to one queue per
+ * thread. Each thread takes chunks from the back of its own queue and, once
+ * that is empty, steals from the front of the others, so a thread that got
+ * slow chunks (or was scheduled on a little core) does not hold up the loop.
+ * The calling thread runs chunks too; once none is left to take, it sleeps
+ * until the ones still running on other threads are done.
+ *
+ * Usage:
+ *  JobSystem jobs(JOB_SYSTEM_DEFAULT_THREADS);
+ *  jobs.ParallelFor(count, 256, UpdateRange, this);
+ *
+ * ParallelFor() is meant to be called from one thread at a time, and not
+ * from inside a job. Workers sleep while there is no work.
+ */
+class JobSystem {
+ private:
+  struct Job {
+    JobFunction function_;
+    void* data_;
+    int32_t begin_;
+    int32_t end_;
+    std::atomic<int32_t>* remaining_;
+  };
+
+  struct Queue {
+    pthread_mutex_t mutex_;
+    std::deque<Job> jobs_;
+  };
+
+  // queues_[0] belongs to the thread calling ParallelFor()
+  std::vector<Queue*> queues_;
+  std::vector<pthread_t> threads_;
+  std::atomic<int32_t> next_worker_;
+
+  // Jobs pushed and not taken yet; workers sleep on cond_ while it is 0
+  std::atomic<int32_t> queued_;
+  bool quit_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  // Signaled by the job finishing a ParallelFor()
+  pthread_cond_t done_cond_;
+
+  static void* WorkerThread(void* param);
+  void Work(const int32_t queue);
+  bool Pop(const int32_t queue, Job* job);
+  void Run(const Job& job);
+
+  JobSystem(JobSystem const&);
+  void operator=(JobSystem const&);
+
+ public:
+  /*
+   * arguments:
+   * in: num_threads, worker threads, JOB_SYSTEM_DEFAULT_THREADS for one per
+   *     CPU besides the caller. With 0 ParallelFor() runs inline.
+   */
+  explicit JobSystem(const int32_t num_threads);
+  ~JobSystem();
+
+  // Threads running jobs, including the caller of ParallelFor()
+  int32_t GetThreadCount() const { return (int32_t)queues_.size(); }
+
+  /*
+   * Run function(data, begin, end) over [0, count) in chunks of |grain|
+   * elements and wait for all of them. Chunks start at multiples of |grain|.
+   * With no worker the whole range is a single call.
+   */
+  void ParallelFor(const int32_t count, const int32_t grain,
+                   JobFunction function, void* data);
+};
+
+}  // namespace ndkHelper
+#endif /* JOB_SYSTEM_H_ */
@@ -17,29 +17,99 @@
 #ifndef PERFMONITOR_H_
 #define PERFMONITOR_H_
 
-#include <jni.h>
 #include <errno.h>
+#include <stdint.h>
 #include <time.h>
-#include "JNIHelper.h"
+#include <atomic>
+#include <GLES2/gl2.h>
+#include "logging.h"
 
 namespace ndk_helper {
 
 const int32_t NUM_SAMPLES = 100;
 
+/******************************************************************
+ * Fixed size, log bucketed histogram of durations
+ * Each power of two (in microseconds) is split into HISTOGRAM_SUB_BUCKETS
+ * linear buckets; a percentile is reported as its bucket's midpoint, within
+ * 1/32 (~3%) of the real value, without storing individual samples. The max,
+ * and so the 100th percentile, is tracked exactly.
+ */
+const int32_t HISTOGRAM_SUB_BUCKETS = 16;
+const int32_t HISTOGRAM_OCTAVES = 28;  // 1us .. ~268s
+const int32_t HISTOGRAM_BUCKETS = HISTOGRAM_SUB_BUCKETS * HISTOGRAM_OCTAVES;
+
+class FrameHistogram {
+ private:
+  uint32_t buckets_[HISTOGRAM_BUCKETS];
+  uint32_t count_;
+  int64_t max_ns_;
+
+  static int32_t BucketIndex(int64_t us);
+  static int64_t BucketMidpointUs(int32_t index);
+
+ public:
+  FrameHistogram() { Reset(); }
+
+  void Reset();
+  void Record(int64_t duration_ns);
+
+  // |percentile| in 0..100, returns 0 if nothing was recorded
+  int64_t GetPercentileNs(float percentile) const;
+  int64_t GetMaxNs() const { return max_ns_; }
+  uint32_t GetCount() const { return count_; }
+};
+
 /******************************************************************
  * Helper class for a performance monitoring and get current tick time
+ * Besides the averaged FPS, every frame interval goes into a histogram, and
+ * frames longer than JANK_THRESHOLD target intervals are counted as janky.
+ *
+ * The cost of a frame is measured between BeginFrameWork() and
+ * EndFrameWork(), called on the GL thread around the frame's work up to the
+ * swap: the CPU time, and the GPU time of the GL commands in between when
+ * GL_EXT_disjoint_timer_query is supported. GPU times come from a ring of
+ * GPU_TIMER_QUERIES queries, so they are a few frames old.
  */
+const int64_t DEFAULT_TARGET_FRAME_NS = 1000000000LL / 60;
+const float JANK_THRESHOLD = 1.5f;
+// Intervals longer than this are pauses (app in background etc), not frames
+const int64_t MAX_FRAME_INTERVAL_NS = 1000000000LL;
+const int32_t GPU_TIMER_QUERIES = 4;
+
 class PerfMonitor {
  private:
-  float current_FPS_;
-  time_t tv_last_sec_;
+  float current_FPS_ {0.f};
+  int64_t last_report_ns_ {0};
 
-  double last_tick_;
-  int32_t tickindex_;
-  double ticksum_;
+  int64_t last_tick_ns_ {0};
+  int32_t tickindex_ {0};
+  double ticksum_ {0.0};
   double ticklist_[NUM_SAMPLES];
 
+  FrameHistogram histogram_;
+  int64_t target_frame_ns_ {DEFAULT_TARGET_FRAME_NS};
+  uint32_t jank_count_ {0};
+  int64_t last_interval_ns_ {0};
+
+  // Frame cost
+  enum GpuTimerState {
+    GPU_TIMER_UNKNOWN,
+    GPU_TIMER_UNSUPPORTED,
+    GPU_TIMER_READY,
+  };
+  GpuTimerState gpu_timer_state_ {GPU_TIMER_UNKNOWN};
+  GLuint gpu_queries_[GPU_TIMER_QUERIES];
+  int32_t gpu_query_next_ {0};     // Query the next frame uses
+  int32_t gpu_query_pending_ {0};  // Queries issued, results not read yet
+  bool gpu_query_active_ {false};
+  int64_t work_begin_ns_ {0};
+  int64_t cpu_frame_ns_ {0};
+  int64_t gpu_frame_ns_ {0};
+
   double UpdateTick(double current_tick);
+  bool InitGpuTimer();
+  void ReadGpuTimer();
 
  public:
   PerfMonitor();
@@ -47,11 +117,99 @@ class PerfMonitor {
 
   bool Update(float &fFPS);
 
-  static double GetCurrentTime() {
-    struct timeval time;
-    gettimeofday(&time, NULL);
-    double ret = time.tv_sec + time.tv_usec * 1.0 / 1000000.0;
-    return ret;
+  // Frame interval jank is measured against, e.g. 2 vsyncs for 30fps
+  void SetTargetFrameInterval(int64_t interval_ns) {
+    target_frame_ns_ = interval_ns;
+  }
+  int64_t GetTargetFrameInterval() const { return target_frame_ns_; }
+  const FrameHistogram &GetHistogram() const { return histogram_; }
+  uint32_t GetJankCount() const { return jank_count_; }
+  // Time between the last two Update() calls
+  int64_t GetLastFrameInterval() const { return last_interval_ns_; }
+  void ResetStats() {
+    histogram_.Reset();
+    jank_count_ = 0;
+  }
+  // Log p50/p90/p99/max and jank count
+  void LogStats() const;
+
+  // Around the frame's work, with its GL context current
+  void BeginFrameWork();
+  void EndFrameWork();
+  int64_t GetCpuFrameTime() const { return cpu_frame_ns_; }
+  // Latest GPU time measured, 0 if GPU timing is not supported
+  int64_t GetGpuFrameTime() const { return gpu_frame_ns_; }
+  // The larger of the two: what the frame rate is bound by
+  int64_t GetFrameCost() const {
+    return cpu_frame_ns_ > gpu_frame_ns_ ? cpu_frame_ns_ : gpu_frame_ns_;
+  }
+  // Forget the GPU queries, e.g. when the GL context was lost
+  void InvalidateGpuTimer();
+
+  // Monotonic clock; not affected by wall clock changes
+  static int64_t GetCurrentTimeNs() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+  }
+
+  static double GetCurrentTime() { return GetCurrentTimeNs() / 1000000000.0; }
+};
+
+/******************************************************************
+ * CPU zone tracing, exported as Chrome trace event JSON
+ * (load the file in chrome://tracing or ui.perfetto.dev).
+ *
+ * Usage:
+ *   {
+ *     ndk_helper::TraceZone zone("render");
+ *     ...
+ *   }
+ *   ndk_helper::TraceRecorder::ExportChromeJson(path);
+ *
+ * Every thread records into its own fixed size ring buffer, so recording
+ * takes no locks and never allocates after the first zone on a thread. Zone
+ * names must be string literals (only the pointer is stored).
+ *
+ * Recording is off until SetEnabled(true); a disabled zone costs one relaxed
+ * atomic load. The samples enable it, and export on APP_CMD_STOP, only when
+ * built with USE_NDK_TRACE defined.
+ */
+const int32_t TRACE_BUFFER_EVENTS = 4096;
+
+struct TraceEvent {
+  const char *name;
+  int64_t begin_ns;
+  int64_t duration_ns;
+};
+
+class TraceRecorder {
+ public:
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+
+  // Append a completed zone to the calling thread's buffer
+  static void Record(const char *name, int64_t begin_ns, int64_t end_ns);
+
+  // Write the most recent events of all threads, up to
+  // TRACE_BUFFER_EVENTS - 1 each (the oldest slot may be being rewritten);
+  // safe to call while other threads keep recording
+  static bool ExportChromeJson(const char *file_name);
+};
+
+class TraceZone {
+ private:
+  const char *name_;
+  int64_t begin_ns_;
+
+ public:
+  explicit TraceZone(const char *name)
+      : name_(name),
+        begin_ns_(TraceRecorder::IsEnabled() ? PerfMonitor::GetCurrentTimeNs()
+                                             : 0) {}
+  ~TraceZone() {
+    if (begin_ns_)
+      TraceRecorder::Record(name_, begin_ns_, PerfMonitor::GetCurrentTimeNs());
   }
 };
 
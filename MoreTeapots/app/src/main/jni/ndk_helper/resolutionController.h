@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESOLUTION_CONTROLLER_H_
+#define RESOLUTION_CONTROLLER_H_
+
+#include <stdint.h>
+
+namespace ndk_helper {
+
+// Frames the frame costs are gathered over before a decision
+const int32_t RESOLUTION_WINDOW_FRAMES = 30;
+// Frames ignored after a change, while the old size drains from the queue
+// and the GPU timer results catch up
+const int32_t RESOLUTION_SETTLE_FRAMES = 4;
+// Render scale steps, in fractions of the full window size
+const float RESOLUTION_SCALE_STEP = 0.05f;
+
+/******************************************************************
+ * Dynamic render resolution
+ * Picks the scale of the window size frames are rendered at, so that the
+ * frame cost holds a target frame time (e.g. the vsync interval). The
+ * decision is made once per RESOLUTION_WINDOW_FRAMES on the 90th percentile
+ * cost, in RESOLUTION_SCALE_STEP steps:
+ * - above 90% of the target the scale goes down, by two steps when the cost
+ *   is far over;
+ * - it goes up one step when the cost, scaled by the larger area, would
+ *   still be under 75% of the target, several windows in a row;
+ * - it does not go back up to a scale it just left for a while, so a cost
+ *   right at the edge does not flip between two sizes.
+ * Fill cost is assumed to follow the area, the square of the scale.
+ *
+ * The class has no GL calls; GLContext::SetRenderScale() applies the scale.
+ *
+ * Usage, once per frame:
+ *  if (resolution.Update(monitor.GetFrameCost(),
+ *                        monitor.GetLastFrameInterval()) &&
+ *      !gl_context->SetRenderScale(resolution.GetScale()))
+ *    resolution.HoldScale(gl_context->GetRenderScale());
+ */
+class ResolutionController {
+ private:
+  int64_t target_frame_ns_;
+  // Levels are steps below the full size; max_level_ is the smallest scale
+  int32_t max_level_;
+  int32_t level_;
+  int32_t ceiling_level_;
+  int32_t ceiling_frames_;
+  int32_t settle_frames_;
+  int32_t headroom_windows_;
+
+  int64_t costs_[RESOLUTION_WINDOW_FRAMES];
+  int32_t cost_count_;
+
+  static float LevelScale(const int32_t level) {
+    return 1.f - level * RESOLUTION_SCALE_STEP;
+  }
+  static int32_t ScaleLevel(const float scale);
+  void SetLevel(const int32_t level);
+  bool Decide();
+
+ public:
+  ResolutionController();
+
+  // Frame time to hold, e.g. PerfMonitor::GetTargetFrameInterval()
+  void SetTargetFrameTime(const int64_t frame_ns) {
+    target_frame_ns_ = frame_ns;
+  }
+  int64_t GetTargetFrameTime() const { return target_frame_ns_; }
+
+  // Smallest scale picked, 0.5 by default; never below one step
+  void SetMinScale(const float scale);
+
+  // Stay at |scale|, e.g. when the window takes no other buffer size. After
+  // a Reset() it is the smallest scale.
+  void HoldScale(const float scale);
+
+  // Back to the full size, forgetting the costs seen so far
+  void Reset();
+
+  /*
+   * arguments:
+   * in: cost_ns, time the frame took to render, e.g. the larger of its CPU
+   *     and GPU time
+   * in: interval_ns, time since the previous frame; a frame that missed its
+   *     vsync counts as costing this much. 0 if unknown
+   * return: true when GetScale() changed
+   */
+  bool Update(const int64_t cost_ns, const int64_t interval_ns);
+
+  float GetScale() const { return LevelScale(level_); }
+};
+
+}  // namespace ndkHelper
+#endif /* RESOLUTION_CONTROLLER_H_ */
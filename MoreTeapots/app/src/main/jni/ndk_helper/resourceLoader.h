@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESOURCE_LOADER_H_
+#define RESOURCE_LOADER_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <deque>
+
+namespace ndk_helper {
+
+// Runs on the loader thread with the loader context current: reads files,
+// compiles programs, creates buffers. Returns false on failure.
+typedef bool (*LoadFunction)(void* data);
+// Runs on the GL thread once everything the load made is usable there, with
+// the result of the load: binds state that is not shared between contexts,
+// such as vertex array objects, and marks the resource ready.
+typedef void (*CommitFunction)(void* data, const bool succeeded);
+
+/******************************************************************
+ * Context interface of ResourceLoader
+ * EGLLoaderBackend (GLContext::CreateLoaderBackend()) is the EGL
+ * implementation, a context sharing objects with the GL thread's one. Another
+ * backend (e.g. fences that are plain flags) lets the scheduling and the
+ * handoff run without EGL.
+ */
+class LoaderBackend {
+ public:
+  virtual ~LoaderBackend() {}
+
+  // Loader thread, before its first task and after its last one
+  virtual bool MakeCurrent() = 0;
+  virtual void ReleaseCurrent() = 0;
+  // Loader thread, after each task: fence the commands it issued and flush
+  // them. NULL when the commands are known to be complete already.
+  virtual void* CreateFence() = 0;
+
+  // GL thread
+  virtual bool IsFenceSignaled(void* fence) = 0;
+  virtual void WaitFence(void* fence) = 0;
+  virtual void DeleteFence(void* fence) = 0;
+};
+
+/******************************************************************
+ * Background GL resource loader
+ * Tasks are loaded in order on a thread of their own, in a context that
+ * shares objects with the GL thread's context, so shader compiles and buffer
+ * uploads do not hold up the first frame. Each load is followed by a fence;
+ * Update() on the GL thread commits the tasks whose fence has signaled, in
+ * the order they were submitted.
+ *
+ * Without a backend, or when the backend can not be made current on the
+ * loader thread, tasks are loaded and committed on the GL thread instead:
+ * by Submit() in the first case, by Update() in the second.
+ *
+ * Usage, on the GL thread:
+ *  ResourceLoader loader(GLContext::GetInstance()->CreateLoaderBackend());
+ *  loader.Submit(LoadMesh, CommitMesh, this);
+ *  // each frame
+ *  loader.Update();
+ *
+ * Destroy the loader before the GL context. Tasks not loaded yet are dropped
+ * then and loaded ones are not committed: the objects they made are still
+ * wherever the load put them, to be deleted by their owner.
+ */
+class ResourceLoader {
+ private:
+  struct Task {
+    LoadFunction load_;
+    CommitFunction commit_;
+    void* data_;
+    bool succeeded_;
+    void* fence_;
+  };
+
+  LoaderBackend* backend_;
+  int32_t pending_;  // GL thread only
+
+  // Shared with the loader thread, guarded by mutex_
+  std::deque<Task> tasks_;   // Not loaded yet
+  std::deque<Task> loaded_;  // Loaded, not committed yet
+  bool thread_failed_;       // No context on the loader thread
+  bool quit_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  pthread_t thread_;
+  bool thread_started_;
+
+  static void* LoaderThread(void* param);
+  void Work();
+  void Commit(const Task& task);
+  bool LoadInline();
+
+  ResourceLoader(ResourceLoader const&);
+  void operator=(ResourceLoader const&);
+
+ public:
+  /*
+   * arguments:
+   * in: backend, owned by the loader; NULL to load on the GL thread
+   */
+  explicit ResourceLoader(LoaderBackend* backend);
+  ~ResourceLoader();
+
+  /*
+   * Queue a task. |data| must stay valid until the task is committed or the
+   * loader is destroyed.
+   */
+  void Submit(LoadFunction load, CommitFunction commit, void* data);
+
+  /*
+   * Commit the tasks that are loaded and whose fence has signaled
+   *
+   * return: tasks committed
+   */
+  int32_t Update();
+
+  // Wait for every task submitted and commit them all
+  void Finish();
+
+  // Tasks submitted and not committed yet
+  int32_t GetPendingCount() const { return pending_; }
+  // False when tasks are loaded on the GL thread
+  bool IsAsync();
+};
+
+}  // namespace ndkHelper
+#endif /* RESOURCE_LOADER_H_ */
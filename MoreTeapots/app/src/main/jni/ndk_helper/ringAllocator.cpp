@@ -0,0 +1,114 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ringAllocator.cpp
+//--------------------------------------------------------------------------------
+#include "ringAllocator.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+RingAllocator::RingAllocator() { Init(0, 1); }
+
+void RingAllocator::Init(const size_t size, const size_t alignment) {
+  alignment_ = alignment ? alignment : 1;
+  // Whole aligned ranges only, so a range never runs past the end
+  size_ = size / alignment_ * alignment_;
+  head_ = tail_ = used_ = frame_bytes_ = 0;
+  last_offset_ = RING_ALLOCATION_FAILED;
+  last_size_ = 0;
+  frames_.clear();
+}
+
+//--------------------------------------------------------------------------------
+// Allocation
+//--------------------------------------------------------------------------------
+size_t RingAllocator::Allocate(const size_t size) {
+  const size_t bytes = Align(size);
+  if (bytes == 0 || bytes > size_) return RING_ALLOCATION_FAILED;
+
+  // Nothing in flight: restart at 0 for the longest contiguous run
+  if (used_ == 0) head_ = tail_ = 0;
+
+  size_t offset;
+  size_t padding = 0;
+  if (used_ == size_) {
+    return RING_ALLOCATION_FAILED;
+  } else if (head_ >= tail_) {
+    // Free space is [head, size) and [0, tail)
+    if (bytes <= size_ - head_) {
+      offset = head_;
+    } else if (bytes <= tail_) {
+      padding = size_ - head_;
+      offset = 0;
+    } else {
+      return RING_ALLOCATION_FAILED;
+    }
+  } else {
+    // Free space is [head, tail)
+    if (bytes > tail_ - head_) return RING_ALLOCATION_FAILED;
+    offset = head_;
+  }
+
+  head_ = offset + bytes;
+  if (head_ == size_) head_ = 0;
+  used_ += padding + bytes;
+  frame_bytes_ += padding + bytes;
+  last_offset_ = offset;
+  last_size_ = bytes;
+  return offset;
+}
+
+void RingAllocator::Shrink(const size_t size) {
+  if (last_offset_ == RING_ALLOCATION_FAILED) return;
+  const size_t bytes = Align(size);
+  if (bytes >= last_size_) return;
+
+  const size_t freed = last_size_ - bytes;
+  head_ = last_offset_ + bytes;
+  used_ -= freed;
+  frame_bytes_ -= freed;
+  last_size_ = bytes;
+}
+
+//--------------------------------------------------------------------------------
+// Frames
+//--------------------------------------------------------------------------------
+void RingAllocator::EndFrame(void* fence) {
+  Frame frame;
+  frame.fence_ = fence;
+  frame.end_ = head_;
+  frame.bytes_ = frame_bytes_;
+  frames_.push_back(frame);
+  frame_bytes_ = 0;
+  // The closed frame's ranges can no longer shrink
+  last_offset_ = RING_ALLOCATION_FAILED;
+}
+
+void* RingAllocator::RetireOldest() {
+  if (frames_.empty()) return NULL;
+  const Frame frame = frames_.front();
+  frames_.pop_front();
+  used_ -= frame.bytes_;
+  // Frames are freed in order, so everything up to its end is free now
+  if (frame.bytes_) tail_ = frame.end_;
+  return frame.fence_;
+}
+
+}  // namespace ndkHelper
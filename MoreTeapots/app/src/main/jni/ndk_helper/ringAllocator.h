@@ -0,0 +1,99 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RING_ALLOCATOR_H_
+#define RING_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+
+namespace ndk_helper {
+
+// Returned by RingAllocator::Allocate() when the frames in flight hold the
+// space
+const size_t RING_ALLOCATION_FAILED = (size_t)-1;
+
+/******************************************************************
+ * Ring allocator for data streamed to the GPU
+ * Hands out ranges of a buffer in order, wrapping around at its end. The
+ * ranges allocated before an EndFrame() belong to that frame, and stay in
+ * use until the frame is retired, oldest first, once its fence has
+ * signaled. That is what lets the writer map without synchronization: it
+ * never touches a range the GPU may still read.
+ *
+ * Fences are opaque handles to the allocator (a GLsync for StreamBuffer),
+ * so it has no GL calls and can be run and tested off device.
+ *
+ * Usage:
+ *  size_t offset = ring.Allocate(bytes);  // Write [offset, + bytes)
+ *  ring.EndFrame(fence);
+ *  ...
+ *  while (ring.GetFramesInFlight() && IsSignaled(ring.GetOldestFence()))
+ *    Delete(ring.RetireOldest());
+ */
+class RingAllocator {
+ private:
+  struct Frame {
+    void* fence_;
+    size_t end_;    // Where the frame's last range ends
+    size_t bytes_;  // Bytes it holds, including the padding at a wrap
+  };
+
+  size_t size_;
+  size_t alignment_;
+  size_t head_;  // Next free byte
+  size_t tail_;  // First byte in use
+  size_t used_;
+  size_t frame_bytes_;
+  size_t last_offset_;
+  size_t last_size_;
+  std::deque<Frame> frames_;
+
+  size_t Align(const size_t size) const {
+    return (size + alignment_ - 1) / alignment_ * alignment_;
+  }
+
+ public:
+  RingAllocator();
+
+  /*
+   * Forget all ranges and frames, and start over with a buffer of |size|
+   * bytes. Offsets are multiples of |alignment| (a power of two).
+   */
+  void Init(const size_t size, const size_t alignment);
+
+  // Offset of |size| contiguous bytes, or RING_ALLOCATION_FAILED
+  size_t Allocate(const size_t size);
+  // Give the end of the last allocation back, keeping its first |size| bytes
+  void Shrink(const size_t size);
+
+  // Close the current frame; its ranges are freed once |fence| signals
+  void EndFrame(void* fence);
+  int32_t GetFramesInFlight() const { return (int32_t)frames_.size(); }
+  void* GetOldestFence() const {
+    return frames_.empty() ? NULL : frames_.front().fence_;
+  }
+  // Free the oldest frame's ranges and return its fence, for deletion
+  void* RetireOldest();
+
+  size_t GetSize() const { return size_; }
+  size_t GetUsed() const { return used_; }
+};
+
+}  // namespace ndkHelper
+#endif /* RING_ALLOCATOR_H_ */
@@ -16,6 +16,11 @@
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "shader.h"
 #include "JNIHelper.h"
@@ -24,49 +29,127 @@ namespace ndk_helper {
 
 #define DEBUG (1)
 
+namespace {
+
+// GLES3 only, not in the GLES2 headers
+const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+
+const uint32_t PROGRAM_CACHE_MAGIC = 0x31434250;  // "PBC1"
+
+struct ProgramCacheHeader {
+  uint32_t magic;
+  uint32_t format;
+  uint32_t length;
+};
+
+bool ReadShaderFile(const char *file_name, std::vector<uint8_t> *data) {
+  if (!JNIHelper::GetInstance()->ReadFile(file_name, data)) {
+    LOGI("Can not open a file:%s", file_name);
+    return false;
+  }
+  return true;
+}
+
+bool LoadShaderSource(const char *file_name,
+                      const std::map<std::string, std::string> &map_parameters,
+                      std::string *out) {
+  AssetView view = AssetCache::GetInstance()->Open(file_name);
+  if (!view.IsValid() || !view.Size()) {
+    LOGI("Can not open a file:%s", file_name);
+    return false;
+  }
+  if (!shader::PreprocessShader(file_name, (const char *)view.Data(),
+                                (int32_t)view.Size(), map_parameters,
+                                ReadShaderFile, out)) {
+    LOGI("Failed to preprocess %s", file_name);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 bool shader::CompileShader(
     GLuint *shader, const GLenum type, const char *str_file_name,
     const std::map<std::string, std::string> &map_parameters) {
-  std::vector<uint8_t> data;
-  if (!JNIHelper::GetInstance()->ReadFile(str_file_name, &data)) {
-    LOGI("Can not open a file:%s", str_file_name);
+  std::string str;
+  if (!LoadShaderSource(str_file_name, map_parameters, &str)) return false;
+
+  LOGI("Patched Shdader:\n%s", str.c_str());
+
+  return shader::CompileShader(shader, type, str.data(), (int32_t)str.size());
+}
+
+bool shader::CreateProgram(
+    GLuint *program, const char *str_vsh, const char *str_fsh,
+    const std::map<std::string, std::string> &map_parameters,
+    const std::map<std::string, GLuint> &attributes) {
+  std::vector<std::string> sources(2);
+  if (!LoadShaderSource(str_vsh, map_parameters, &sources[0]) ||
+      !LoadShaderSource(str_fsh, map_parameters, &sources[1]))
     return false;
-  }
 
-  const char REPLACEMENT_TAG = '*';
-  // Fill-in parameters
-  std::string str(data.begin(), data.end());
-  std::string str_replacement_map(data.size(), ' ');
-
-  std::map<std::string, std::string>::const_iterator it =
-      map_parameters.begin();
-  std::map<std::string, std::string>::const_iterator itEnd =
-      map_parameters.end();
-  while (it != itEnd) {
-    size_t pos = 0;
-    while ((pos = str.find(it->first, pos)) != std::string::npos) {
-      // Check if the sub string is already touched
-
-      size_t replaced_pos = str_replacement_map.find(REPLACEMENT_TAG, pos);
-      if (replaced_pos == std::string::npos || replaced_pos > pos) {
-
-        str.replace(pos, it->first.length(), it->second);
-        str_replacement_map.replace(pos, it->first.length(), it->first.length(),
-                                    REPLACEMENT_TAG);
-        pos += it->second.length();
-      } else {
-        // The replacement target has been touched by other tag, skipping them
-        pos += it->second.length();
-      }
+  ProgramCache *cache = ProgramCache::GetInstance();
+  std::string key;
+  GLuint prog = glCreateProgram();
+  if (cache->IsEnabled()) {
+    char str[32];
+    std::map<std::string, GLuint>::const_iterator it = attributes.begin();
+    for (; it != attributes.end(); ++it) {
+      snprintf(str, sizeof(str), "=%u", it->second);
+      sources.push_back(it->first + str);
     }
-    it++;
+    key = MakeProgramCacheKey(sources, cache->GetDriver());
+    if (cache->Load(key, prog)) {
+      LOGI("Loaded program %s from the cache", key.c_str());
+      *program = prog;
+      return true;
+    }
+    // Build from a fresh program object, whatever glProgramBinary left behind
+    glDeleteProgram(prog);
+    prog = glCreateProgram();
   }
 
-  LOGI("Patched Shdader:\n%s", str.c_str());
+  GLuint vert_shader, frag_shader;
+  if (!CompileShader(&vert_shader, GL_VERTEX_SHADER, sources[0].data(),
+                     (int32_t)sources[0].size())) {
+    LOGI("Failed to compile vertex shader %s", str_vsh);
+    glDeleteProgram(prog);
+    return false;
+  }
+  if (!CompileShader(&frag_shader, GL_FRAGMENT_SHADER, sources[1].data(),
+                     (int32_t)sources[1].size())) {
+    LOGI("Failed to compile fragment shader %s", str_fsh);
+    glDeleteShader(vert_shader);
+    glDeleteProgram(prog);
+    return false;
+  }
+
+  glAttachShader(prog, vert_shader);
+  glAttachShader(prog, frag_shader);
+
+  // Bind attribute locations
+  // this needs to be done prior to linking
+  std::map<std::string, GLuint>::const_iterator it = attributes.begin();
+  for (; it != attributes.end(); ++it)
+    glBindAttribLocation(prog, it->second, it->first.c_str());
+
+  if (cache->IsEnabled()) cache->PrepareProgram(prog);
+  bool linked = LinkProgram(prog);
+
+  // Release vertex and fragment shaders
+  glDeleteShader(vert_shader);
+  glDeleteShader(frag_shader);
 
-  std::vector<uint8_t> v(str.begin(), str.end());
-  str.clear();
-  return shader::CompileShader(shader, type, v);
+  if (!linked) {
+    LOGI("Failed to link program: %d", prog);
+    glDeleteProgram(prog);
+    return false;
+  }
+
+  if (cache->IsEnabled()) cache->Store(key, prog);
+  *program = prog;
+  return true;
 }
 
 bool shader::CompileShader(GLuint *shader, const GLenum type,
@@ -111,14 +194,14 @@ bool shader::CompileShader(GLuint *shader, const GLenum type,
 
 bool shader::CompileShader(GLuint *shader, const GLenum type,
                            const char *strFileName) {
-  std::vector<uint8_t> data;
-  bool b = JNIHelper::GetInstance()->ReadFile(strFileName, &data);
-  if (!b) {
+  AssetView view = AssetCache::GetInstance()->Open(strFileName);
+  if (!view.IsValid()) {
     LOGI("Can not open a file:%s", strFileName);
     return false;
   }
 
-  return shader::CompileShader(shader, type, data);
+  return shader::CompileShader(shader, type, (const GLchar *)view.Data(),
+                               (int32_t)view.Size());
 }
 
 bool shader::LinkProgram(const GLuint prog) {
@@ -164,4 +247,124 @@ bool shader::ValidateProgram(const GLuint prog) {
   return true;
 }
 
+//--------------------------------------------------------------------------------
+// ProgramCache
+//--------------------------------------------------------------------------------
+shader::ProgramCache::ProgramCache()
+    : get_program_binary_(NULL),
+      program_binary_(NULL),
+      program_parameteri_(NULL) {}
+
+void shader::ProgramCache::Init(const char *data_path) {
+  get_program_binary_ = NULL;
+  program_binary_ = NULL;
+  program_parameteri_ = NULL;
+  if (data_path == NULL) return;
+
+  const char *vendor = (const char *)glGetString(GL_VENDOR);
+  const char *renderer = (const char *)glGetString(GL_RENDERER);
+  const char *version = (const char *)glGetString(GL_VERSION);
+  const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+  if (vendor == NULL || renderer == NULL || version == NULL) return;
+  driver_ = std::string(vendor) + "\n" + renderer + "\n" + version;
+
+  if (strstr(version, "OpenGL ES 3.")) {
+    get_program_binary_ =
+        (GetProgramBinaryFunc)eglGetProcAddress("glGetProgramBinary");
+    program_binary_ = (ProgramBinaryFunc)eglGetProcAddress("glProgramBinary");
+    program_parameteri_ =
+        (ProgramParameteriFunc)eglGetProcAddress("glProgramParameteri");
+  } else if (extensions && strstr(extensions, "GL_OES_get_program_binary")) {
+    get_program_binary_ =
+        (GetProgramBinaryFunc)eglGetProcAddress("glGetProgramBinaryOES");
+    program_binary_ =
+        (ProgramBinaryFunc)eglGetProcAddress("glProgramBinaryOES");
+  }
+
+  // Some drivers expose the entry points but no binary format
+  GLint formats = 0;
+  if (get_program_binary_ && program_binary_)
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+  if (formats <= 0) {
+    LOGI("Program binaries not supported, shaders are compiled every time");
+    get_program_binary_ = NULL;
+    program_binary_ = NULL;
+    program_parameteri_ = NULL;
+    return;
+  }
+
+  directory_ = std::string(data_path) + "/program_cache";
+  mkdir(directory_.c_str(), 0700);
+}
+
+void shader::ProgramCache::PrepareProgram(const GLuint program) {
+  // GLES3 wants to be told before linking; the OES extension has no hint
+  if (program_parameteri_)
+    program_parameteri_(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool shader::ProgramCache::Load(const std::string &key, const GLuint program) {
+  if (!IsEnabled()) return false;
+
+  std::string file_name = directory_ + "/" + key + ".bin";
+  FILE *f = fopen(file_name.c_str(), "rb");
+  if (f == NULL) return false;
+
+  ProgramCacheHeader header;
+  std::vector<uint8_t> data;
+  bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+            header.magic == PROGRAM_CACHE_MAGIC && header.length > 0;
+  if (ok) {
+    data.resize(header.length);
+    ok = fread(&data[0], 1, data.size(), f) == data.size();
+  }
+  fclose(f);
+
+  GLint status = 0;
+  if (ok) {
+    program_binary_(program, header.format, &data[0], header.length);
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+  }
+  if (!status) {
+    // Truncated file, or the driver no longer accepts the binary
+    LOGI("Discarding cached program %s", key.c_str());
+    unlink(file_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+void shader::ProgramCache::Store(const std::string &key, const GLuint program) {
+  if (!IsEnabled()) return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+  if (length <= 0) return;
+
+  std::vector<uint8_t> data(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  get_program_binary_(program, length, &written, &format, &data[0]);
+  if (written <= 0) return;
+
+  ProgramCacheHeader header;
+  header.magic = PROGRAM_CACHE_MAGIC;
+  header.format = format;
+  header.length = written;
+
+  // Written to a temporary file and renamed, so a reader never sees a partial
+  // file under the final name
+  std::string file_name = directory_ + "/" + key + ".bin";
+  std::string tmp_name = file_name + ".tmp";
+  FILE *f = fopen(tmp_name.c_str(), "wb");
+  if (f == NULL) return;
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(&data[0], 1, written, f) == (size_t)written;
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmp_name.c_str(), file_name.c_str())) {
+    LOGI("Failed to store program %s", key.c_str());
+    unlink(tmp_name.c_str());
+  }
+}
+
 }  // namespace ndkHelper
@@ -29,6 +29,7 @@
 #include <android/log.h>
 
 #include "JNIHelper.h"
+#include "shaderPreprocessor.h"
 
 namespace ndk_helper {
 
@@ -89,12 +90,33 @@ bool CompileShader(GLuint *shader, const GLenum type, const char *strFileName);
  *      For a example,
  *      map : %KEY% -> %VALUE% replaces all %KEY% entries in the given shader
  *code to %VALUE"
+ *      #include "file" lines are expanded as well, see PreprocessShader()
  * return: true if a shader compilation succeeded, false if it failed
  *
  */
 bool CompileShader(GLuint *shader, const GLenum type, const char *str_file_name,
                    const std::map<std::string, std::string> &map_parameters);
 
+/******************************************************************
+ * CreateProgram()
+ * Compiles and links a program from a vertex and a fragment shader file,
+ * both preprocessed with map_parameters. When ProgramCache is enabled the
+ * linked binary is stored on disk, and the next build of the same program
+ * on the same driver loads it instead of compiling.
+ *
+ * arguments:
+ *  out: program, program variable
+ *  in: str_vsh, vertex shader file name
+ *  in: str_fsh, fragment shader file name
+ *  in: map_parameters, see CompileShader()
+ *  in: attributes, attribute name -> location, bound before linking
+ * return: true if the program is ready to use, false if it failed
+ *
+ */
+bool CreateProgram(GLuint *program, const char *str_vsh, const char *str_fsh,
+                   const std::map<std::string, std::string> &map_parameters,
+                   const std::map<std::string, GLuint> &attributes);
+
 /******************************************************************
  * LinkProgram()
  *
@@ -114,6 +136,53 @@ bool LinkProgram(const GLuint prog);
  *
  */
 bool ValidateProgram(const GLuint prog);
+
+/******************************************************************
+ * Linked program binaries cached on disk
+ * Uses glGetProgramBinary/glProgramBinary (GLES3 or
+ * GL_OES_get_program_binary). Files are named by MakeProgramCacheKey(), so
+ * a driver update or a shader change simply misses the cache. A binary the
+ * driver rejects is deleted and the program is built from source.
+ *
+ */
+class ProgramCache {
+ private:
+  typedef void(GL_APIENTRY *GetProgramBinaryFunc)(GLuint, GLsizei, GLsizei *,
+                                                  GLenum *, GLvoid *);
+  typedef void(GL_APIENTRY *ProgramBinaryFunc)(GLuint, GLenum, const GLvoid *,
+                                               GLint);
+  typedef void(GL_APIENTRY *ProgramParameteriFunc)(GLuint, GLenum, GLint);
+
+  std::string directory_;
+  std::string driver_;
+  GetProgramBinaryFunc get_program_binary_;
+  ProgramBinaryFunc program_binary_;
+  ProgramParameteriFunc program_parameteri_;
+
+  ProgramCache(ProgramCache const &);
+  void operator=(ProgramCache const &);
+  ProgramCache();
+
+ public:
+  static ProgramCache *GetInstance() {
+    // Singleton
+    static ProgramCache instance;
+
+    return &instance;
+  }
+
+  // Call with the GL context current, e.g. before loading shaders.
+  // data_path: writable directory, the cache goes to data_path/program_cache
+  void Init(const char *data_path);
+  bool IsEnabled() const { return program_binary_ != NULL; }
+  const std::string &GetDriver() const { return driver_; }
+
+  // Call before linking a program that will be stored
+  void PrepareProgram(const GLuint program);
+  bool Load(const std::string &key, const GLuint program);
+  void Store(const std::string &key, const GLuint program);
+};
+
 }  // namespace shader
 
 }  // namespace ndkHelper
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// shaderPreprocessor.cpp
+//--------------------------------------------------------------------------------
+#include "shaderPreprocessor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace ndk_helper {
+
+namespace {
+
+inline bool IsSpace(const char c) { return c == ' ' || c == '\t'; }
+
+//--------------------------------------------------------------------------------
+// Matches #include "name" or #include <name> at |p| (the '#').
+// On success |name| holds the file name and |line_end| points past the line.
+//--------------------------------------------------------------------------------
+bool ParseInclude(const char *p, const char *end, std::string *name,
+                  const char **line_end) {
+  static const char DIRECTIVE[] = "include";
+  const size_t DIRECTIVE_LENGTH = sizeof(DIRECTIVE) - 1;
+
+  ++p;
+  while (p < end && IsSpace(*p)) ++p;
+  if ((size_t)(end - p) < DIRECTIVE_LENGTH ||
+      memcmp(p, DIRECTIVE, DIRECTIVE_LENGTH))
+    return false;
+  p += DIRECTIVE_LENGTH;
+  while (p < end && IsSpace(*p)) ++p;
+  if (p == end || (*p != '"' && *p != '<')) return false;
+
+  const char close = *p == '"' ? '"' : '>';
+  const char *name_start = ++p;
+  while (p < end && *p != close && *p != '\n') ++p;
+  if (p == end || *p != close) return false;
+  name->assign(name_start, p);
+
+  while (p < end && *p != '\n') ++p;
+  *line_end = p < end ? p + 1 : p;
+  return true;
+}
+
+std::string ResolveInclude(const std::string &file_name,
+                           const std::string &name) {
+  if (name.size() && name[0] == '/') return name.substr(1);
+  size_t slash = file_name.rfind('/');
+  if (slash == std::string::npos) return name;
+  return file_name.substr(0, slash + 1) + name;
+}
+
+bool Preprocess(const std::string &file_name, const char *source,
+                const int32_t size,
+                const std::map<std::string, std::string> &map_parameters,
+                shader::IncludeLoader loader, const int32_t depth,
+                std::string *out) {
+  const char *p = source;
+  const char *end = source + size;
+  bool line_start = true;
+  std::string key;
+  std::string name;
+
+  while (p < end) {
+    if (line_start) {
+      line_start = false;
+      const char *q = p;
+      while (q < end && IsSpace(*q)) ++q;
+      const char *line_end;
+      if (q < end && *q == '#' && ParseInclude(q, end, &name, &line_end)) {
+        std::string include_name = ResolveInclude(file_name, name);
+        std::vector<uint8_t> data;
+        if (depth >= shader::MAX_INCLUDE_DEPTH || loader == NULL ||
+            !loader(include_name.c_str(), &data))
+          return false;
+        if (data.size() &&
+            !Preprocess(include_name, (const char *)&data[0],
+                        (int32_t)data.size(), map_parameters, loader,
+                        depth + 1, out))
+          return false;
+        if (out->size() && (*out)[out->size() - 1] != '\n')
+          out->push_back('\n');
+        p = line_end;
+        line_start = true;
+        continue;
+      }
+    }
+
+    // Copy the run up to the next token or line break in one go
+    const char *run = p;
+    while (p < end && *p != '%' && *p != '\n') ++p;
+    out->append(run, p);
+    if (p == end) break;
+
+    if (*p == '\n') {
+      out->push_back('\n');
+      ++p;
+      line_start = true;
+      continue;
+    }
+
+    // %KEY%, within the line
+    const char *close = p + 1;
+    while (close < end && *close != '%' && *close != '\n') ++close;
+    if (close < end && *close == '%') {
+      key.assign(p, close + 1);
+      std::map<std::string, std::string>::const_iterator it =
+          map_parameters.find(key);
+      if (it != map_parameters.end()) {
+        out->append(it->second);
+        p = close + 1;
+        continue;
+      }
+    }
+    // Not a parameter; the closing '%' may still open one
+    out->push_back('%');
+    ++p;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool shader::PreprocessShader(
+    const char *file_name, const char *source, const int32_t size,
+    const std::map<std::string, std::string> &map_parameters,
+    IncludeLoader loader, std::string *out) {
+  out->clear();
+  out->reserve(size);
+  return Preprocess(file_name ? file_name : "", source, size, map_parameters,
+                    loader, 0, out);
+}
+
+uint64_t shader::HashString(const std::string &str, const uint64_t hash) {
+  const uint64_t FNV_PRIME = 0x100000001b3ULL;
+  uint64_t h = hash;
+  for (size_t i = 0; i < str.size(); ++i) {
+    h ^= (uint8_t)str[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+std::string shader::MakeProgramCacheKey(const std::vector<std::string> &sources,
+                                        const std::string &driver) {
+  // Each part is prefixed with its length so moving text from one part to
+  // the next changes the key
+  char str[32];
+  uint64_t hash = HASH_SEED;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    snprintf(str, sizeof(str), "%zu:", sources[i].size());
+    hash = HashString(sources[i], HashString(str, hash));
+  }
+  snprintf(str, sizeof(str), "%zu:", driver.size());
+  hash = HashString(driver, HashString(str, hash));
+
+  snprintf(str, sizeof(str), "%016llx", (unsigned long long)hash);
+  return std::string(str);
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHADER_PREPROCESSOR_H_
+#define SHADER_PREPROCESSOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ndk_helper {
+
+namespace shader {
+
+/******************************************************************
+ * Shader source helpers with no GL or JNI dependency
+ * namespace: ndkHelper::shader
+ *
+ */
+
+// Deepest #include nesting accepted, also stops include cycles
+const int32_t MAX_INCLUDE_DEPTH = 16;
+
+/******************************************************************
+ * Reads the file named by an #include directive
+ *
+ * arguments:
+ *  in: file_name, file name resolved against the including file
+ *  out: data, file contents
+ * return: true if the file could be read
+ *
+ */
+typedef bool (*IncludeLoader)(const char *file_name,
+                              std::vector<uint8_t> *data);
+
+/******************************************************************
+ * PreprocessShader()
+ * Expands a shader source in a single pass:
+ *  - %KEY% tokens whose key (with the % signs) is in map_parameters are
+ *    replaced by the value. Values are copied as is, never scanned again.
+ *  - A line holding #include "file" (or <file>) is replaced by the
+ *    preprocessed contents of file. The name is relative to the directory
+ *    of the including file, or to the asset root if it starts with '/'.
+ *
+ * arguments:
+ *  in: file_name, name of the source, used to resolve includes
+ *  in: source, source buffer
+ *  in: size, buffer size
+ *  in: map_parameters, %KEY% -> VALUE
+ *  in: loader, reads included files; NULL makes every #include an error
+ *  out: out, the expanded source
+ * return: false if an included file can not be read or nests too deep
+ *
+ */
+bool PreprocessShader(const char *file_name, const char *source,
+                      const int32_t size,
+                      const std::map<std::string, std::string> &map_parameters,
+                      IncludeLoader loader, std::string *out);
+
+/******************************************************************
+ * HashString()
+ * 64bit FNV-1a hash of str, continuing from hash
+ *
+ */
+const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+uint64_t HashString(const std::string &str, const uint64_t hash = HASH_SEED);
+
+/******************************************************************
+ * MakeProgramCacheKey()
+ * Key a linked program binary is stored under: the hash of every input of
+ * the link (preprocessed sources, attribute bindings, ...) and of the driver
+ * identification, as 16 hex digits. Any change in either gives a new key.
+ *
+ * arguments:
+ *  in: sources, program inputs, in a fixed order
+ *  in: driver, GL_VENDOR, GL_RENDERER and GL_VERSION strings
+ * return: the key
+ *
+ */
+std::string MakeProgramCacheKey(const std::vector<std::string> &sources,
+                                const std::string &driver);
+
+}  // namespace shader
+
+}  // namespace ndkHelper
+#endif /* SHADER_PREPROCESSOR_H_ */
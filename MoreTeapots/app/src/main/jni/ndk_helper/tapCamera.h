@@ -22,6 +22,7 @@
 #include "JNIHelper.h"
 #include "vecmath.h"
 #include "interpolator.h"
+#include "inputResampler.h"
 
 namespace ndk_helper {
 
@@ -29,45 +30,56 @@ namespace ndk_helper {
  * Camera control helper class with a tap gesture
  * This class is mainly used for 3D space camera control in samples.
  *
+ * Input is timestamped: pass every batched sample of a motion event with its
+ * event time (see DragDetector::GetPointer()), and the predicted display time
+ * of the frame to Update(). The camera then shows the gesture resampled at
+ * that time, and momentum after a release is a function of the time since
+ * the release, so the motion is the same at 30, 60, 90 or 120 fps.
+ * The overloads without a time use the current time.
  */
 class TapCamera {
  private:
   // Trackball
   Vec2 vec_ball_center_;
-  float ball_radius_;
+  float ball_radius_ {0.75f};
   Quaternion quat_ball_now_;
   Quaternion quat_ball_down_;
   Vec2 vec_ball_now_;
   Vec2 vec_ball_down_;
   Quaternion quat_ball_rot_;
 
-  bool dragging_;
-  bool pinching_;
+  bool dragging_ {false};
+  bool pinching_ {false};
 
   // Pinch related info
   Vec2 vec_pinch_start_;
   Vec2 vec_pinch_start_center_;
-  float pinch_start_distance_SQ_;
+  float pinch_start_distance_SQ_ {0.0f};
 
   // Camera shift
   Vec3 vec_offset_;
   Vec3 vec_offset_now_;
 
   // Camera Rotation
-  float camera_rotation_;
-  float camera_rotation_start_;
-  float camera_rotation_now_;
+  float camera_rotation_ {0.0f};
+  float camera_rotation_start_ {0.0f};
+  float camera_rotation_now_ {0.0f};
+
+  // Input samples of the gesture, flipped ball positions while dragging,
+  // the two pointers while pinching
+  InputResampler input_;
 
   // Momentum support
-  bool momentum_;
-  Vec2 vec_drag_delta_;
-  Vec2 vec_last_input_;
-  Vec3 vec_offset_last_;
-  Vec3 vec_offset_delta_;
-  float momemtum_steps_;
+  bool momentum_ {false};
+  double momentum_start_ {0.0};
+  Quaternion quat_momentum_start_;
+  Vec3 vec_momentum_axis_;
+  float momentum_angular_velocity_ {0.0f};
+  Vec3 vec_offset_start_;
+  Vec3 vec_offset_velocity_;
 
   Vec2 vec_flip_;
-  float flip_z_;
+  float flip_z_ {0.0f};
 
   Mat4 mat_rotation_;
   Mat4 mat_transform_;
@@ -77,10 +89,21 @@ class TapCamera {
   Vec3 PointOnSphere(Vec2& point);
   void BallUpdate();
   void InitParameters();
+  void ApplyPinch(const Vec2& v1, const Vec2& v2);
+  void StartMomentum(const double time, const Vec2& ball_velocity,
+                     const Vec3& offset_velocity);
+  void UpdateMomentum(const double time);
 
  public:
   TapCamera();
   virtual ~TapCamera();
+  // time: event time in seconds, CLOCK_MONOTONIC
+  void BeginDrag(const Vec2& vec, const double time);
+  void EndDrag(const double time);
+  void Drag(const Vec2& vec, const double time);
+  // display_time: when the frame is expected on screen
+  void Update(const double display_time);
+
   void BeginDrag(const Vec2& vec);
   void EndDrag();
   void Drag(const Vec2& vec);
@@ -89,6 +112,10 @@ class TapCamera {
   Mat4& GetRotationMatrix();
   Mat4& GetTransformMatrix();
 
+  void BeginPinch(const Vec2& v1, const Vec2& v2, const double time);
+  void EndPinch(const double time);
+  void Pinch(const Vec2& v1, const Vec2& v2, const double time);
+
   void BeginPinch(const Vec2& v1, const Vec2& v2);
   void EndPinch();
   void Pinch(const Vec2& v1, const Vec2& v2);
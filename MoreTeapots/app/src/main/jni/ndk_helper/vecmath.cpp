@@ -18,6 +18,7 @@
 // vecmath.cpp
 //--------------------------------------------------------------------------------
 #include "vecmath.h"
+#include <string.h>
 
 namespace ndk_helper {
 
@@ -35,17 +36,58 @@ Vec3::Vec3(const Vec4& vec) {
 //--------------------------------------------------------------------------------
 Vec4 Vec4::operator*(const Mat4& rhs) const {
   Vec4 out;
+#if defined(VECMATH_USE_NEON)
+  // Row vector: each output lane is a dot product with one column, so work
+  // on the transposed matrix to keep the scalar summation order.
+  float32x4x4_t t = vld4q_f32(rhs.f_);
+  float32x4_t acc = vmulq_n_f32(t.val[0], x_);
+  acc = vaddq_f32(acc, vmulq_n_f32(t.val[1], y_));
+  acc = vaddq_f32(acc, vmulq_n_f32(t.val[2], z_));
+  acc = vaddq_f32(acc, vmulq_n_f32(t.val[3], w_));
+  vst1q_f32(&out.x_, acc);
+#elif defined(VECMATH_USE_SSE)
+  __m128 c0 = _mm_loadu_ps(rhs.f_ + 0);
+  __m128 c1 = _mm_loadu_ps(rhs.f_ + 4);
+  __m128 c2 = _mm_loadu_ps(rhs.f_ + 8);
+  __m128 c3 = _mm_loadu_ps(rhs.f_ + 12);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  __m128 acc = _mm_mul_ps(c0, _mm_set1_ps(x_));
+  acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_set1_ps(y_)));
+  acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_set1_ps(z_)));
+  acc = _mm_add_ps(acc, _mm_mul_ps(c3, _mm_set1_ps(w_)));
+  _mm_storeu_ps(&out.x_, acc);
+#else
   out.x_ = x_ * rhs.f_[0] + y_ * rhs.f_[1] + z_ * rhs.f_[2] + w_ * rhs.f_[3];
   out.y_ = x_ * rhs.f_[4] + y_ * rhs.f_[5] + z_ * rhs.f_[6] + w_ * rhs.f_[7];
   out.z_ = x_ * rhs.f_[8] + y_ * rhs.f_[9] + z_ * rhs.f_[10] + w_ * rhs.f_[11];
   out.w_ =
       x_ * rhs.f_[12] + y_ * rhs.f_[13] + z_ * rhs.f_[14] + w_ * rhs.f_[15];
+#endif
   return out;
 }
 
 //--------------------------------------------------------------------------------
 // mat4
 //--------------------------------------------------------------------------------
+#if defined(VECMATH_USE_SSE)
+namespace {
+// out = c0 * r[0] + c1 * r[1] + c2 * r[2] + c3 * r[3], the weights broadcast
+// from one load
+inline void MulColumnSSE(const __m128 c0, const __m128 c1, const __m128 c2,
+                         const __m128 c3, const float* r, float* out) {
+  __m128 w = _mm_loadu_ps(r);
+  __m128 acc = _mm_mul_ps(c0, _mm_shuffle_ps(w, w, _MM_SHUFFLE(0, 0, 0, 0)));
+  acc = _mm_add_ps(acc,
+                   _mm_mul_ps(c1, _mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 1, 1, 1))));
+  acc = _mm_add_ps(acc,
+                   _mm_mul_ps(c2, _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 2, 2))));
+  acc = _mm_add_ps(acc,
+                   _mm_mul_ps(c3, _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 3, 3))));
+  _mm_storeu_ps(out, acc);
+}
+}  // namespace
+#endif
+
 Mat4::Mat4() {
   for (int32_t i = 0; i < 16; ++i) f_[i] = 0.f;
 }
@@ -56,6 +98,33 @@ Mat4::Mat4(const float* mIn) {
 
 Mat4 Mat4::operator*(const Mat4& rhs) const {
   Mat4 ret;
+#if defined(VECMATH_USE_NEON)
+  // Each result column is a linear combination of our columns, weighted by
+  // the matching column of rhs. Multiplies and adds are kept separate (no
+  // fused multiply-add) so results match the scalar code.
+  float32x4_t c0 = vld1q_f32(f_ + 0);
+  float32x4_t c1 = vld1q_f32(f_ + 4);
+  float32x4_t c2 = vld1q_f32(f_ + 8);
+  float32x4_t c3 = vld1q_f32(f_ + 12);
+  for (int32_t i = 0; i < 16; i += 4) {
+    float32x4_t acc = vmulq_n_f32(c0, rhs.f_[i]);
+    acc = vaddq_f32(acc, vmulq_n_f32(c1, rhs.f_[i + 1]));
+    acc = vaddq_f32(acc, vmulq_n_f32(c2, rhs.f_[i + 2]));
+    acc = vaddq_f32(acc, vmulq_n_f32(c3, rhs.f_[i + 3]));
+    vst1q_f32(ret.f_ + i, acc);
+  }
+#elif defined(VECMATH_USE_SSE)
+  __m128 c0 = _mm_loadu_ps(f_ + 0);
+  __m128 c1 = _mm_loadu_ps(f_ + 4);
+  __m128 c2 = _mm_loadu_ps(f_ + 8);
+  __m128 c3 = _mm_loadu_ps(f_ + 12);
+  // Unrolled, so the compiler sees every element of ret written and drops
+  // the zeroing done by its constructor
+  MulColumnSSE(c0, c1, c2, c3, rhs.f_ + 0, ret.f_ + 0);
+  MulColumnSSE(c0, c1, c2, c3, rhs.f_ + 4, ret.f_ + 4);
+  MulColumnSSE(c0, c1, c2, c3, rhs.f_ + 8, ret.f_ + 8);
+  MulColumnSSE(c0, c1, c2, c3, rhs.f_ + 12, ret.f_ + 12);
+#else
   ret.f_[0] = f_[0] * rhs.f_[0] + f_[4] * rhs.f_[1] + f_[8] * rhs.f_[2] +
               f_[12] * rhs.f_[3];
   ret.f_[1] = f_[1] * rhs.f_[0] + f_[5] * rhs.f_[1] + f_[9] * rhs.f_[2] +
@@ -92,15 +161,30 @@ Mat4 Mat4::operator*(const Mat4& rhs) const {
   ret.f_[15] = f_[3] * rhs.f_[12] + f_[7] * rhs.f_[13] + f_[11] * rhs.f_[14] +
                f_[15] * rhs.f_[15];
 
+#endif
   return ret;
 }
 
 Vec4 Mat4::operator*(const Vec4& rhs) const {
   Vec4 ret;
+#if defined(VECMATH_USE_NEON)
+  float32x4_t acc = vmulq_n_f32(vld1q_f32(f_ + 0), rhs.x_);
+  acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(f_ + 4), rhs.y_));
+  acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(f_ + 8), rhs.z_));
+  acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(f_ + 12), rhs.w_));
+  vst1q_f32(&ret.x_, acc);
+#elif defined(VECMATH_USE_SSE)
+  __m128 acc = _mm_mul_ps(_mm_loadu_ps(f_ + 0), _mm_set1_ps(rhs.x_));
+  acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(f_ + 4), _mm_set1_ps(rhs.y_)));
+  acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(f_ + 8), _mm_set1_ps(rhs.z_)));
+  acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(f_ + 12), _mm_set1_ps(rhs.w_)));
+  _mm_storeu_ps(&ret.x_, acc);
+#else
   ret.x_ = rhs.x_ * f_[0] + rhs.y_ * f_[4] + rhs.z_ * f_[8] + rhs.w_ * f_[12];
   ret.y_ = rhs.x_ * f_[1] + rhs.y_ * f_[5] + rhs.z_ * f_[9] + rhs.w_ * f_[13];
   ret.z_ = rhs.x_ * f_[2] + rhs.y_ * f_[6] + rhs.z_ * f_[10] + rhs.w_ * f_[14];
   ret.w_ = rhs.x_ * f_[3] + rhs.y_ * f_[7] + rhs.z_ * f_[11] + rhs.w_ * f_[15];
+#endif
   return ret;
 }
 
@@ -175,6 +259,228 @@ Mat4 Mat4::Inverse() {
   return *this;
 }
 
+#if defined(VECMATH_USE_NEON) || defined(VECMATH_USE_SSE)
+//--------------------------------------------------------------------------------
+// General inverse, block matrix method
+// The matrix is split into 2x2 blocks | A B |
+//                                     | C D |
+// and everything is expressed with 2x2 adjugates (A#), so no block has to be
+// invertible itself. Each 2x2 block lives in one register as (m00 m01 m10 m11).
+// Uses the compiler's vector extensions so the same code maps to NEON and
+// SSE.
+//--------------------------------------------------------------------------------
+namespace {
+typedef float V4 __attribute__((vector_size(16)));
+#define V4_SHUFFLE(a, b, i0, i1, i2, i3) \
+  __builtin_shufflevector(a, b, i0, i1, i2, i3)
+#define V4_SWIZZLE(a, i0, i1, i2, i3) V4_SHUFFLE(a, a, i0, i1, i2, i3)
+
+// A * B
+inline V4 Mat2Mul(const V4 a, const V4 b) {
+  return a * V4_SWIZZLE(b, 0, 3, 0, 3) +
+         V4_SWIZZLE(a, 1, 0, 3, 2) * V4_SWIZZLE(b, 2, 1, 2, 1);
+}
+
+// A# * B
+inline V4 Mat2AdjMul(const V4 a, const V4 b) {
+  return V4_SWIZZLE(a, 3, 3, 0, 0) * b -
+         V4_SWIZZLE(a, 1, 1, 2, 2) * V4_SWIZZLE(b, 2, 3, 0, 1);
+}
+
+// A * B#
+inline V4 Mat2MulAdj(const V4 a, const V4 b) {
+  return a * V4_SWIZZLE(b, 3, 0, 3, 0) -
+         V4_SWIZZLE(a, 1, 0, 3, 2) * V4_SWIZZLE(b, 2, 1, 2, 1);
+}
+
+inline V4 Splat(const V4 a, const int32_t i) {
+  V4 ret = {a[i], a[i], a[i], a[i]};
+  return ret;
+}
+}  // namespace
+
+bool Mat4::InverseGeneral(Mat4& out) const {
+  // Columns are treated as rows here; inverting the transpose and storing
+  // rows back as columns gives the inverse of the original matrix.
+  V4 r0, r1, r2, r3;
+  memcpy(&r0, f_ + 0, sizeof(V4));
+  memcpy(&r1, f_ + 4, sizeof(V4));
+  memcpy(&r2, f_ + 8, sizeof(V4));
+  memcpy(&r3, f_ + 12, sizeof(V4));
+
+  V4 a = V4_SHUFFLE(r0, r1, 0, 1, 4, 5);
+  V4 b = V4_SHUFFLE(r0, r1, 2, 3, 6, 7);
+  V4 c = V4_SHUFFLE(r2, r3, 0, 1, 4, 5);
+  V4 d = V4_SHUFFLE(r2, r3, 2, 3, 6, 7);
+
+  // (|A| |B| |C| |D|)
+  V4 det_sub = V4_SHUFFLE(r0, r2, 0, 2, 4, 6) * V4_SHUFFLE(r1, r3, 1, 3, 5, 7) -
+               V4_SHUFFLE(r0, r2, 1, 3, 5, 7) * V4_SHUFFLE(r1, r3, 0, 2, 4, 6);
+  V4 det_a = Splat(det_sub, 0);
+  V4 det_b = Splat(det_sub, 1);
+  V4 det_c = Splat(det_sub, 2);
+  V4 det_d = Splat(det_sub, 3);
+
+  V4 d_c = Mat2AdjMul(d, c);
+  V4 a_b = Mat2AdjMul(a, b);
+
+  // Adjugates of the result blocks, inverse = 1/|M| * | X Y |
+  //                                                   | Z W |
+  V4 x = det_d * a - Mat2Mul(b, d_c);
+  V4 w = det_a * d - Mat2Mul(c, a_b);
+  V4 y = det_b * c - Mat2MulAdj(d, a_b);
+  V4 z = det_c * b - Mat2MulAdj(a, d_c);
+
+  // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+  V4 tr = a_b * V4_SWIZZLE(d_c, 0, 2, 1, 3);
+  float det = det_sub[0] * det_sub[3] + det_sub[1] * det_sub[2] -
+              ((tr[0] + tr[1]) + (tr[2] + tr[3]));
+  if (det == 0.f) return false;
+
+  float rcp = 1.f / det;
+  V4 rcp_det = {rcp, -rcp, -rcp, rcp};
+  x *= rcp_det;
+  y *= rcp_det;
+  z *= rcp_det;
+  w *= rcp_det;
+
+  // Undo the adjugate while storing
+  V4 o0 = V4_SHUFFLE(x, y, 3, 1, 7, 5);
+  V4 o1 = V4_SHUFFLE(x, y, 2, 0, 6, 4);
+  V4 o2 = V4_SHUFFLE(z, w, 3, 1, 7, 5);
+  V4 o3 = V4_SHUFFLE(z, w, 2, 0, 6, 4);
+  memcpy(out.f_ + 0, &o0, sizeof(V4));
+  memcpy(out.f_ + 4, &o1, sizeof(V4));
+  memcpy(out.f_ + 8, &o2, sizeof(V4));
+  memcpy(out.f_ + 12, &o3, sizeof(V4));
+  return true;
+}
+
+#undef V4_SWIZZLE
+#undef V4_SHUFFLE
+#else
+bool Mat4::InverseGeneral(Mat4& out) const {
+  // Cofactor expansion, sharing the 2x2 sub-determinants of the lower and
+  // upper two rows
+  const float* m = f_;
+  float s0 = m[0] * m[5] - m[4] * m[1];
+  float s1 = m[0] * m[9] - m[8] * m[1];
+  float s2 = m[0] * m[13] - m[12] * m[1];
+  float s3 = m[4] * m[9] - m[8] * m[5];
+  float s4 = m[4] * m[13] - m[12] * m[5];
+  float s5 = m[8] * m[13] - m[12] * m[9];
+
+  float c5 = m[10] * m[15] - m[14] * m[11];
+  float c4 = m[6] * m[15] - m[14] * m[7];
+  float c3 = m[6] * m[11] - m[10] * m[7];
+  float c2 = m[2] * m[15] - m[14] * m[3];
+  float c1 = m[2] * m[11] - m[10] * m[3];
+  float c0 = m[2] * m[7] - m[6] * m[3];
+
+  float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  if (det == 0.f) return false;
+  float rcp = 1.f / det;
+
+  out.f_[0] = (m[5] * c5 - m[9] * c4 + m[13] * c3) * rcp;
+  out.f_[4] = (-m[4] * c5 + m[8] * c4 - m[12] * c3) * rcp;
+  out.f_[8] = (m[7] * s5 - m[11] * s4 + m[15] * s3) * rcp;
+  out.f_[12] = (-m[6] * s5 + m[10] * s4 - m[14] * s3) * rcp;
+
+  out.f_[1] = (-m[1] * c5 + m[9] * c2 - m[13] * c1) * rcp;
+  out.f_[5] = (m[0] * c5 - m[8] * c2 + m[12] * c1) * rcp;
+  out.f_[9] = (-m[3] * s5 + m[11] * s2 - m[15] * s1) * rcp;
+  out.f_[13] = (m[2] * s5 - m[10] * s2 + m[14] * s1) * rcp;
+
+  out.f_[2] = (m[1] * c4 - m[5] * c2 + m[13] * c0) * rcp;
+  out.f_[6] = (-m[0] * c4 + m[4] * c2 - m[12] * c0) * rcp;
+  out.f_[10] = (m[3] * s4 - m[7] * s2 + m[15] * s0) * rcp;
+  out.f_[14] = (-m[2] * s4 + m[6] * s2 - m[14] * s0) * rcp;
+
+  out.f_[3] = (-m[1] * c3 + m[5] * c1 - m[9] * c0) * rcp;
+  out.f_[7] = (m[0] * c3 - m[4] * c1 + m[8] * c0) * rcp;
+  out.f_[11] = (-m[3] * s3 + m[7] * s1 - m[11] * s0) * rcp;
+  out.f_[15] = (m[2] * s3 - m[6] * s1 + m[10] * s0) * rcp;
+  return true;
+}
+#endif
+
+Mat3 Mat4::NormalMatrix() const {
+  // With a0..a2 the columns of the upper 3x3, the columns of its inverse
+  // transpose are (a1 x a2, a2 x a0, a0 x a1) / det
+  Vec3 a0(f_[0], f_[1], f_[2]);
+  Vec3 a1(f_[4], f_[5], f_[6]);
+  Vec3 a2(f_[8], f_[9], f_[10]);
+  Vec3 c0 = a1.Cross(a2);
+  Vec3 c1 = a2.Cross(a0);
+  Vec3 c2 = a0.Cross(a1);
+
+  float det = a0.Dot(c0);
+  float scale = det != 0.f ? 1.f / det : 1.f;
+
+  Mat3 ret;
+  ret.f_[0] = c0.x_ * scale;
+  ret.f_[1] = c0.y_ * scale;
+  ret.f_[2] = c0.z_ * scale;
+  ret.f_[3] = c1.x_ * scale;
+  ret.f_[4] = c1.y_ * scale;
+  ret.f_[5] = c1.z_ * scale;
+  ret.f_[6] = c2.x_ * scale;
+  ret.f_[7] = c2.y_ * scale;
+  ret.f_[8] = c2.z_ * scale;
+  return ret;
+}
+
+bool Mat4::Decompose(Vec3& translation, Quaternion& rotation,
+                     Vec3& scale) const {
+  translation = Vec3(f_[12], f_[13], f_[14]);
+
+  Vec3 a0(f_[0], f_[1], f_[2]);
+  Vec3 a1(f_[4], f_[5], f_[6]);
+  Vec3 a2(f_[8], f_[9], f_[10]);
+  float sx = a0.Length();
+  float sy = a1.Length();
+  float sz = a2.Length();
+  if (sx == 0.f || sy == 0.f || sz == 0.f) return false;
+
+  // A negative determinant means the matrix mirrors; put that in x
+  if (a0.Dot(a1.Cross(a2)) < 0.f) sx = -sx;
+  scale = Vec3(sx, sy, sz);
+
+  // Rotation part, r[col][row]
+  float r[3][3] = {{a0.x_ / sx, a0.y_ / sx, a0.z_ / sx},
+                   {a1.x_ / sy, a1.y_ / sy, a1.z_ / sy},
+                   {a2.x_ / sz, a2.y_ / sz, a2.z_ / sz}};
+
+  // Pick the largest of w, x, y, z to divide by, for precision
+  float trace = r[0][0] + r[1][1] + r[2][2];
+  if (trace > 0.f) {
+    float s = sqrtf(trace + 1.f) * 2.f;
+    rotation.w_ = 0.25f * s;
+    rotation.x_ = (r[1][2] - r[2][1]) / s;
+    rotation.y_ = (r[2][0] - r[0][2]) / s;
+    rotation.z_ = (r[0][1] - r[1][0]) / s;
+  } else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+    float s = sqrtf(1.f + r[0][0] - r[1][1] - r[2][2]) * 2.f;
+    rotation.w_ = (r[1][2] - r[2][1]) / s;
+    rotation.x_ = 0.25f * s;
+    rotation.y_ = (r[1][0] + r[0][1]) / s;
+    rotation.z_ = (r[2][0] + r[0][2]) / s;
+  } else if (r[1][1] > r[2][2]) {
+    float s = sqrtf(1.f + r[1][1] - r[0][0] - r[2][2]) * 2.f;
+    rotation.w_ = (r[2][0] - r[0][2]) / s;
+    rotation.x_ = (r[1][0] + r[0][1]) / s;
+    rotation.y_ = 0.25f * s;
+    rotation.z_ = (r[2][1] + r[1][2]) / s;
+  } else {
+    float s = sqrtf(1.f + r[2][2] - r[0][0] - r[1][1]) * 2.f;
+    rotation.w_ = (r[0][1] - r[1][0]) / s;
+    rotation.x_ = (r[2][0] + r[0][2]) / s;
+    rotation.y_ = (r[2][1] + r[1][2]) / s;
+    rotation.z_ = 0.25f * s;
+  }
+  return true;
+}
+
 //--------------------------------------------------------------------------------
 // Misc
 //--------------------------------------------------------------------------------
@@ -359,4 +665,53 @@ Mat4 Mat4::LookAt(const Vec3& vec_eye, const Vec3& vec_at, const Vec3& vec_up) {
   return result;
 }
 
+//--------------------------------------------------------------------------------
+// Quaternion
+//--------------------------------------------------------------------------------
+Quaternion Quaternion::operator*(const Quaternion rhs) {
+  Quaternion ret;
+#if defined(VECMATH_USE_NEON) || defined(VECMATH_USE_SSE)
+  // ret = x * (rw, -rz, ry, -rx) + y * (rz, rw, -rx, -ry)
+  //     + z * (-ry, rx, rw, -rz) + w * (rx, ry, rz, rw)
+  // Signs are applied with exact +-1 multiplies, so lanes match the scalar
+  // expressions bit for bit.
+#if defined(VECMATH_USE_NEON)
+  static const float kSignX[4] = {1.f, -1.f, 1.f, -1.f};
+  static const float kSignY[4] = {1.f, 1.f, -1.f, -1.f};
+  static const float kSignZ[4] = {-1.f, 1.f, 1.f, -1.f};
+  float32x4_t r = vld1q_f32(&rhs.x_);
+  float32x4_t r_1032 = vrev64q_f32(r);
+  float32x4_t r_2301 = vcombine_f32(vget_high_f32(r), vget_low_f32(r));
+  float32x4_t r_3210 = vrev64q_f32(r_2301);
+  float32x4_t acc =
+      vmulq_n_f32(vmulq_f32(r_3210, vld1q_f32(kSignX)), x_);
+  acc = vaddq_f32(acc, vmulq_n_f32(vmulq_f32(r_2301, vld1q_f32(kSignY)), y_));
+  acc = vaddq_f32(acc, vmulq_n_f32(vmulq_f32(r_1032, vld1q_f32(kSignZ)), z_));
+  acc = vaddq_f32(acc, vmulq_n_f32(r, w_));
+  vst1q_f32(&ret.x_, acc);
+#else
+  __m128 r = _mm_loadu_ps(&rhs.x_);
+  __m128 r_3210 = _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 1, 2, 3));
+  __m128 r_2301 = _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2));
+  __m128 r_1032 = _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 acc = _mm_mul_ps(
+      _mm_mul_ps(r_3210, _mm_setr_ps(1.f, -1.f, 1.f, -1.f)), _mm_set1_ps(x_));
+  acc = _mm_add_ps(
+      acc, _mm_mul_ps(_mm_mul_ps(r_2301, _mm_setr_ps(1.f, 1.f, -1.f, -1.f)),
+                      _mm_set1_ps(y_)));
+  acc = _mm_add_ps(
+      acc, _mm_mul_ps(_mm_mul_ps(r_1032, _mm_setr_ps(-1.f, 1.f, 1.f, -1.f)),
+                      _mm_set1_ps(z_)));
+  acc = _mm_add_ps(acc, _mm_mul_ps(r, _mm_set1_ps(w_)));
+  _mm_storeu_ps(&ret.x_, acc);
+#endif
+#else
+  ret.x_ = x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_ + w_ * rhs.x_;
+  ret.y_ = -x_ * rhs.z_ + y_ * rhs.w_ + z_ * rhs.x_ + w_ * rhs.y_;
+  ret.z_ = x_ * rhs.y_ - y_ * rhs.x_ + z_ * rhs.w_ + w_ * rhs.z_;
+  ret.w_ = -x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_ + w_ * rhs.w_;
+#endif
+  return ret;
+}
+
 }  // namespace ndkHelper
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathArray.cpp
+//--------------------------------------------------------------------------------
+#include "vecmathArray.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Lane helpers
+// A Lane holds one component of LANE_WIDTH consecutive objects. The kernels
+// below are written once against these helpers.
+//--------------------------------------------------------------------------------
+namespace {
+
+#if defined(VECMATH_USE_NEON)
+const int32_t LANE_WIDTH = 4;
+typedef float32x4_t Lane;
+inline Lane Load(const float* p) { return vld1q_f32(p); }
+inline void Store(float* p, const Lane v) { vst1q_f32(p, v); }
+inline Lane Splat(const float f) { return vdupq_n_f32(f); }
+inline Lane Add(const Lane a, const Lane b) { return vaddq_f32(a, b); }
+inline Lane Mul(const Lane a, const Lane b) { return vmulq_f32(a, b); }
+#elif defined(VECMATH_USE_SSE)
+const int32_t LANE_WIDTH = 4;
+typedef __m128 Lane;
+inline Lane Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, const Lane v) { _mm_storeu_ps(p, v); }
+inline Lane Splat(const float f) { return _mm_set1_ps(f); }
+inline Lane Add(const Lane a, const Lane b) { return _mm_add_ps(a, b); }
+inline Lane Mul(const Lane a, const Lane b) { return _mm_mul_ps(a, b); }
+#else
+const int32_t LANE_WIDTH = 1;
+typedef float Lane;
+inline Lane Load(const float* p) { return *p; }
+inline void Store(float* p, const Lane v) { *p = v; }
+inline Lane Splat(const float f) { return f; }
+inline Lane Add(const Lane a, const Lane b) { return a + b; }
+inline Lane Mul(const Lane a, const Lane b) { return a * b; }
+#endif
+
+// Storage is padded so every kernel can run whole lanes
+int32_t PaddedSize(const int32_t size) { return (size + 3) & ~3; }
+
+// End of the lanes covering elements up to |end|
+int32_t LaneEnd(const int32_t end, const int32_t stride) {
+  int32_t padded = PaddedSize(end);
+  return padded < stride ? padded : stride;
+}
+
+// Same summation order as Mat4::operator*, so results match it exactly
+inline Lane Dot4(const Lane a0, const Lane b0, const Lane a1, const Lane b1,
+                 const Lane a2, const Lane b2, const Lane a3, const Lane b3) {
+  return Add(Add(Add(Mul(a0, b0), Mul(a1, b1)), Mul(a2, b2)), Mul(a3, b3));
+}
+
+}  // namespace
+
+//--------------------------------------------------------------------------------
+// Mat4Array
+//--------------------------------------------------------------------------------
+void Mat4Array::Resize(const int32_t size) {
+  if (size == size_) return;
+  size_ = size;
+  stride_ = PaddedSize(size);
+  data_.assign(16 * stride_, 0.f);
+}
+
+void Mat4Array::Set(const int32_t index, const Mat4& mat) {
+  for (int32_t c = 0; c < 16; ++c) data_[c * stride_ + index] = mat.f_[c];
+}
+
+Mat4 Mat4Array::Get(const int32_t index) const {
+  Mat4 ret;
+  Get(index, ret.f_);
+  return ret;
+}
+
+void Mat4Array::Get(const int32_t index, float* out) const {
+  for (int32_t c = 0; c < 16; ++c) out[c] = data_[c * stride_ + index];
+}
+
+void Mat4Array::CopyTo(float* dest, const int32_t dest_stride) const {
+  CopyTo(dest, dest_stride, 0, size_);
+}
+
+void Mat4Array::CopyTo(float* dest, const int32_t dest_stride,
+                       const int32_t begin, const int32_t end) const {
+  dest += begin * dest_stride;
+  for (int32_t i = begin; i < end; ++i) {
+    Get(i, dest);
+    dest += dest_stride;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Vec4Array
+//--------------------------------------------------------------------------------
+void Vec4Array::Resize(const int32_t size) {
+  if (size == size_) return;
+  size_ = size;
+  stride_ = PaddedSize(size);
+  data_.assign(4 * stride_, 0.f);
+}
+
+void Vec4Array::Set(const int32_t index, const Vec4& vec) {
+  data_[index] = vec.x_;
+  data_[stride_ + index] = vec.y_;
+  data_[2 * stride_ + index] = vec.z_;
+  data_[3 * stride_ + index] = vec.w_;
+}
+
+Vec4 Vec4Array::Get(const int32_t index) const {
+  return Vec4(data_[index], data_[stride_ + index],
+              data_[2 * stride_ + index], data_[3 * stride_ + index]);
+}
+
+//--------------------------------------------------------------------------------
+// Batch operations
+//--------------------------------------------------------------------------------
+void MultiplyMany(const Mat4& a, const Mat4Array& b, Mat4Array& out) {
+  if (&out != &b) out.Resize(b.Size());
+  MultiplyMany(a, b, out, 0, b.Size());
+}
+
+void MultiplyMany(const Mat4& a, const Mat4Array& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end) {
+  Mat4 mat_a = a;
+  Lane m[16];
+  for (int32_t c = 0; c < 16; ++c) m[c] = Splat(mat_a.Ptr()[c]);
+
+  const int32_t stride = b.Stride();
+  const float* src = b.Component(0);
+  float* dest = out.Component(0);
+  for (int32_t i = begin; i < LaneEnd(end, stride); i += LANE_WIDTH) {
+    // Each result column only reads the same column of b, so writing it back
+    // straight away is safe even if out and b are the same array
+    for (int32_t col = 0; col < 16; col += 4) {
+      Lane b0 = Load(src + (col + 0) * stride + i);
+      Lane b1 = Load(src + (col + 1) * stride + i);
+      Lane b2 = Load(src + (col + 2) * stride + i);
+      Lane b3 = Load(src + (col + 3) * stride + i);
+      for (int32_t row = 0; row < 4; ++row) {
+        Store(dest + (col + row) * stride + i,
+              Dot4(m[row], b0, m[4 + row], b1, m[8 + row], b2, m[12 + row],
+                   b3));
+      }
+    }
+  }
+}
+
+void MultiplyMany(const Mat4Array& a, const Mat4& b, Mat4Array& out) {
+  if (&out != &a) out.Resize(a.Size());
+  MultiplyMany(a, b, out, 0, a.Size());
+}
+
+void MultiplyMany(const Mat4Array& a, const Mat4& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end) {
+  Mat4 mat_b = b;
+  Lane m[16];
+  for (int32_t c = 0; c < 16; ++c) m[c] = Splat(mat_b.Ptr()[c]);
+
+  const int32_t stride = a.Stride();
+  const float* src = a.Component(0);
+  float* dest = out.Component(0);
+  for (int32_t i = begin; i < LaneEnd(end, stride); i += LANE_WIDTH) {
+    // Row by row, holding only that row of a: the row's results overwrite
+    // just the elements of a it has read, so out may be a
+    for (int32_t row = 0; row < 4; ++row) {
+      Lane l0 = Load(src + (0 + row) * stride + i);
+      Lane l1 = Load(src + (4 + row) * stride + i);
+      Lane l2 = Load(src + (8 + row) * stride + i);
+      Lane l3 = Load(src + (12 + row) * stride + i);
+      for (int32_t col = 0; col < 16; col += 4) {
+        Store(dest + (col + row) * stride + i,
+              Dot4(l0, m[col], l1, m[col + 1], l2, m[col + 2], l3, m[col + 3]));
+      }
+    }
+  }
+}
+
+void MultiplyMany(const Mat4Array& a, const Mat4Array& b, Mat4Array& out) {
+  if (&out != &a && &out != &b) out.Resize(a.Size());
+  MultiplyMany(a, b, out, 0, a.Size());
+}
+
+void MultiplyMany(const Mat4Array& a, const Mat4Array& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end) {
+  const int32_t stride = a.Stride();
+  const float* src_a = a.Component(0);
+  const float* src_b = b.Component(0);
+  float* dest = out.Component(0);
+  if (&out == &b) {
+    // Every result element reads a whole column of b, so all of b is loaded
+    // before anything is written
+    for (int32_t i = begin; i < LaneEnd(end, stride); i += LANE_WIDTH) {
+      Lane l[16], r[16];
+      for (int32_t c = 0; c < 16; ++c) {
+        l[c] = Load(src_a + c * stride + i);
+        r[c] = Load(src_b + c * stride + i);
+      }
+      for (int32_t col = 0; col < 16; col += 4) {
+        for (int32_t row = 0; row < 4; ++row) {
+          Store(dest + (col + row) * stride + i,
+                Dot4(l[row], r[col], l[4 + row], r[col + 1], l[8 + row],
+                     r[col + 2], l[12 + row], r[col + 3]));
+        }
+      }
+    }
+    return;
+  }
+
+  // Row by row as for array * Mat4, reloading b for each row: 32 live lanes
+  // would not fit in registers
+  for (int32_t i = begin; i < LaneEnd(end, stride); i += LANE_WIDTH) {
+    for (int32_t row = 0; row < 4; ++row) {
+      Lane l0 = Load(src_a + (0 + row) * stride + i);
+      Lane l1 = Load(src_a + (4 + row) * stride + i);
+      Lane l2 = Load(src_a + (8 + row) * stride + i);
+      Lane l3 = Load(src_a + (12 + row) * stride + i);
+      for (int32_t col = 0; col < 16; col += 4) {
+        Store(dest + (col + row) * stride + i,
+              Dot4(l0, Load(src_b + (col + 0) * stride + i), l1,
+                   Load(src_b + (col + 1) * stride + i), l2,
+                   Load(src_b + (col + 2) * stride + i), l3,
+                   Load(src_b + (col + 3) * stride + i)));
+      }
+    }
+  }
+}
+
+void TransformPoints(const Mat4& mat, const Vec4Array& in, Vec4Array& out) {
+  if (&out != &in) out.Resize(in.Size());
+
+  Mat4 mat_m = mat;
+  Lane m[16];
+  for (int32_t c = 0; c < 16; ++c) m[c] = Splat(mat_m.Ptr()[c]);
+
+  const int32_t stride = in.Stride();
+  const float* src = in.Component(0);
+  float* dest = out.Component(0);
+  for (int32_t i = 0; i < stride; i += LANE_WIDTH) {
+    Lane x = Load(src + i);
+    Lane y = Load(src + stride + i);
+    Lane z = Load(src + 2 * stride + i);
+    Lane w = Load(src + 3 * stride + i);
+    for (int32_t row = 0; row < 4; ++row) {
+      Store(dest + row * stride + i,
+            Dot4(x, m[row], y, m[4 + row], z, m[8 + row], w, m[12 + row]));
+    }
+  }
+}
+
+void ComposeRotationsXY(const float* angle_x, const float* angle_y,
+                        const int32_t count, Mat4Array& out) {
+  out.Resize(count);
+  ComposeRotationsXY(angle_x, angle_y, out, 0, count);
+}
+
+void ComposeRotationsXY(const float* angle_x, const float* angle_y,
+                        Mat4Array& out, const int32_t begin,
+                        const int32_t end) {
+  const int32_t stride = out.Stride();
+  if (stride == 0) return;
+
+  // sin/cos are computed with libm and parked in result slots: f_[0] and
+  // f_[5] already hold their final values (cos y, cos x); f_[2] and f_[9] are
+  // read back and overwritten below.
+  float* sx = out.Component(9);
+  float* cx = out.Component(5);
+  float* sy = out.Component(2);
+  float* cy = out.Component(0);
+  for (int32_t i = begin; i < end; ++i) {
+    sx[i] = sinf(angle_x[i]);
+    cx[i] = cosf(angle_x[i]);
+    sy[i] = sinf(angle_y[i]);
+    cy[i] = cosf(angle_y[i]);
+  }
+
+  // RotationX(x) * RotationY(y), column major:
+  //  cy        0    -sy      0
+  //  sx * sy   cx    sx * cy 0
+  //  cx * sy  -sx    cx * cy 0
+  //  0         0     0       1
+  float* f = out.Component(0);
+  const Lane zero = Splat(0.f);
+  const Lane one = Splat(1.f);
+  for (int32_t i = begin; i < LaneEnd(end, stride); i += LANE_WIDTH) {
+    Lane s_x = Load(sx + i);
+    Lane c_x = Load(cx + i);
+    Lane s_y = Load(sy + i);
+    Lane c_y = Load(cy + i);
+    Store(f + 1 * stride + i, Mul(s_x, s_y));
+    Store(f + 2 * stride + i, Mul(c_x, s_y));
+    Store(f + 3 * stride + i, zero);
+    Store(f + 4 * stride + i, zero);
+    Store(f + 6 * stride + i, Mul(Splat(-1.f), s_x));
+    Store(f + 7 * stride + i, zero);
+    Store(f + 8 * stride + i, Mul(Splat(-1.f), s_y));
+    Store(f + 9 * stride + i, Mul(s_x, c_y));
+    Store(f + 10 * stride + i, Mul(c_x, c_y));
+    Store(f + 11 * stride + i, zero);
+    Store(f + 12 * stride + i, zero);
+    Store(f + 13 * stride + i, zero);
+    Store(f + 14 * stride + i, zero);
+    Store(f + 15 * stride + i, one);
+  }
+}
+
+}  // namespace ndk_helper
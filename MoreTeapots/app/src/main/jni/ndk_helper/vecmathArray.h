@@ -0,0 +1,141 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VECMATH_ARRAY_H_
+#define VECMATH_ARRAY_H_
+
+#include <vector>
+#include "vecmath.h"
+
+namespace ndk_helper {
+
+// Below this many objects, the batch products are slower than the same
+// products of Mat4/Vec4 objects one at a time (measured with
+// MoreTeapots/tools/vecmathArrayBench): not worth moving Mat4/Vec4 objects
+// into arrays for. Data that already lives in arrays should stay batched at
+// any count, as Get() and Set() on each object cost more than the batch.
+const int32_t VECMATH_ARRAY_MIN_BATCH = 32;
+
+/******************************************************************
+ * Batched (structure of arrays) versions of the vecmath types
+ *
+ * Each array keeps one float array per matrix/vector component, so the batch
+ * functions below can process 4 objects per SIMD instruction instead of one
+ * object at a time. Storage is padded to a multiple of 4 elements; padding
+ * elements are zero and are processed along with the real ones.
+ *
+ * The results are the same as doing the same operations one by one with
+ * Mat4/Vec4 (see MoreTeapots/tools/vecmathArrayBench).
+ */
+class Mat4Array {
+ private:
+  int32_t size_;
+  int32_t stride_;
+  std::vector<float> data_;
+
+ public:
+  Mat4Array() : size_(0), stride_(0) {}
+  explicit Mat4Array(const int32_t size) : size_(0), stride_(0) {
+    Resize(size);
+  }
+
+  // Resize the array; existing contents are not preserved unless the size
+  // stays the same, in which case this is a no-op
+  void Resize(const int32_t size);
+  int32_t Size() const { return size_; }
+  int32_t Stride() const { return stride_; }
+
+  void Set(const int32_t index, const Mat4& mat);
+  Mat4 Get(const int32_t index) const;
+
+  // Copy matrix |index| out as 16 column major floats
+  void Get(const int32_t index, float* out) const;
+
+  // Copy all matrices out as 16 column major floats each, |dest_stride|
+  // floats apart (e.g. into a uniform buffer)
+  void CopyTo(float* dest, const int32_t dest_stride) const;
+  // Same for matrices [begin, end); |dest| is still where matrix 0 goes
+  void CopyTo(float* dest, const int32_t dest_stride, const int32_t begin,
+              const int32_t end) const;
+
+  // Component |c| (0..15, column major as in Mat4) of every matrix
+  float* Component(const int32_t c) { return &data_[c * stride_]; }
+  const float* Component(const int32_t c) const { return &data_[c * stride_]; }
+};
+
+class Vec4Array {
+ private:
+  int32_t size_;
+  int32_t stride_;
+  std::vector<float> data_;
+
+ public:
+  Vec4Array() : size_(0), stride_(0) {}
+  explicit Vec4Array(const int32_t size) : size_(0), stride_(0) {
+    Resize(size);
+  }
+
+  // Resize the array; existing contents are not preserved unless the size
+  // stays the same, in which case this is a no-op
+  void Resize(const int32_t size);
+  int32_t Size() const { return size_; }
+  int32_t Stride() const { return stride_; }
+
+  void Set(const int32_t index, const Vec4& vec);
+  Vec4 Get(const int32_t index) const;
+
+  // Component |c| (0..3 for x, y, z, w) of every vector
+  float* Component(const int32_t c) { return &data_[c * stride_]; }
+  const float* Component(const int32_t c) const { return &data_[c * stride_]; }
+};
+
+//--------------------------------------------------------------------------------
+// Batch operations
+// |out| is resized to match the input. It may be the same object as an array
+// input.
+//--------------------------------------------------------------------------------
+// out[i] = a * b[i]
+void MultiplyMany(const Mat4& a, const Mat4Array& b, Mat4Array& out);
+// out[i] = a[i] * b
+void MultiplyMany(const Mat4Array& a, const Mat4& b, Mat4Array& out);
+// out[i] = a[i] * b[i]
+void MultiplyMany(const Mat4Array& a, const Mat4Array& b, Mat4Array& out);
+
+// out[i] = mat * in[i]
+void TransformPoints(const Mat4& mat, const Vec4Array& in, Vec4Array& out);
+
+// out[i] = Mat4::RotationX(angle_x[i]) * Mat4::RotationY(angle_y[i])
+void ComposeRotationsXY(const float* angle_x, const float* angle_y,
+                        const int32_t count, Mat4Array& out);
+
+//--------------------------------------------------------------------------------
+// Range versions, to split a batch across threads
+// Only elements [begin, end) are written. |begin| must be a multiple of 4 so
+// that two ranges never share a SIMD lane, and |out| must already have the
+// size of the inputs.
+//--------------------------------------------------------------------------------
+void MultiplyMany(const Mat4& a, const Mat4Array& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end);
+void MultiplyMany(const Mat4Array& a, const Mat4& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end);
+void MultiplyMany(const Mat4Array& a, const Mat4Array& b, Mat4Array& out,
+                  const int32_t begin, const int32_t end);
+void ComposeRotationsXY(const float* angle_x, const float* angle_y,
+                        Mat4Array& out, const int32_t begin,
+                        const int32_t end);
+
+}  // namespace ndk_helper
+#endif /* VECMATH_ARRAY_H_ */
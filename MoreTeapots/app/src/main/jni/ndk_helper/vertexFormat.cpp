@@ -0,0 +1,229 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vertexFormat.cpp
+//--------------------------------------------------------------------------------
+#include "vertexFormat.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace ndk_helper {
+
+namespace {
+
+const float SNORM10_MAX = 511.f;
+const float SNORM16_MAX = 32767.f;
+const uint16_t HALF_ONE = 0x3c00;
+
+// Packing runs over every vertex of a mesh, with the signs of the normals
+// and the dropped bits all but random: the helpers below pick their results
+// without branches. This form compiles to min and max instructions.
+inline float ClampUnit(float v) {
+  v = v < 1.f ? v : 1.f;
+  return v > -1.f ? v : -1.f;
+}
+
+// Rounds half away from zero, converting by truncation
+inline int32_t RoundSnorm(const float v, const float max) {
+  const float scaled = ClampUnit(v) * max;
+  return (int32_t)(scaled + copysignf(0.5f, scaled));
+}
+
+inline uint32_t FloatBits(const float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+inline float BitsFloat(const uint32_t bits) {
+  float v;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+inline uint16_t HalfBits(const float v) {
+  const uint32_t bits = FloatBits(v);
+  const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+  const uint32_t abs_bits = bits & 0x7fffffff;
+
+  if (abs_bits >= 0x7f800000) {
+    // Infinity, or NaN with a mantissa bit kept set
+    return sign | 0x7c00 | (abs_bits > 0x7f800000 ? 0x200 : 0);
+  }
+  if (abs_bits >= 0x477ff000) {
+    // Rounds past VERTEX_HALF_MAX
+    return sign | 0x7c00;
+  }
+  if (abs_bits < 0x38800000) {
+    // Below the smallest normal half: scale the mantissa down to a
+    // denormal, adding the float's implicit bit back first
+    if (abs_bits < 0x33000000) return sign;  // Rounds to zero
+    const uint32_t exponent = abs_bits >> 23;
+    const uint32_t mantissa = (abs_bits & 0x7fffff) | 0x800000;
+    const uint32_t shift = 126 - exponent;  // 14 to 24
+    const uint32_t half = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    return sign | (uint16_t)(half + (rest + (half & 1) > halfway));
+  }
+
+  // Normal: rebias the exponent, round the 13 dropped mantissa bits to
+  // nearest even: up past halfway, or at it when odd. A carry into the
+  // exponent is the right result.
+  const uint32_t half = (abs_bits - 0x38000000) >> 13;
+  const uint32_t rest = abs_bits & 0x1fff;
+  return sign | (uint16_t)(half + (rest + (half & 1) > 0x1000));
+}
+
+inline uint32_t Snorm10Bits(const float* n) {
+  uint32_t packed = 0;
+  for (int32_t c = 0; c < 3; ++c)
+    packed |= ((uint32_t)RoundSnorm(n[c], SNORM10_MAX) & 0x3ff) << (c * 10);
+  return packed;
+}
+
+inline void Snorm16Bits(const float* n, int16_t* packed) {
+  for (int32_t c = 0; c < 3; ++c)
+    packed[c] = (int16_t)RoundSnorm(n[c], SNORM16_MAX);
+  packed[3] = 0;
+}
+
+inline void PackHalfPosition(const float* p, uint16_t* pos) {
+  for (int32_t c = 0; c < 3; ++c) pos[c] = HalfBits(p[c]);
+  pos[3] = HALF_ONE;
+}
+
+}  // namespace
+
+//--------------------------------------------------------------------------------
+// Layouts
+//--------------------------------------------------------------------------------
+VERTEX_LAYOUT vertex::ChooseLayout(const bool es3,
+                                   const bool half_float_extension) {
+  // Half float and 2_10_10_10 attributes are both core in ES3
+  if (es3) return VERTEX_LAYOUT_PACKED;
+  if (half_float_extension) return VERTEX_LAYOUT_HALF_POSITION;
+  return VERTEX_LAYOUT_FLOAT_POSITION;
+}
+
+int32_t vertex::GetStride(const VERTEX_LAYOUT layout) {
+  switch (layout) {
+    case VERTEX_LAYOUT_PACKED:
+      return sizeof(VertexPacked);
+    case VERTEX_LAYOUT_HALF_POSITION:
+      return sizeof(VertexHalfPosition);
+    default:
+      return sizeof(VertexFloatPosition);
+  }
+}
+
+int32_t vertex::GetNormalOffset(const VERTEX_LAYOUT layout) {
+  switch (layout) {
+    case VERTEX_LAYOUT_PACKED:
+      return offsetof(VertexPacked, normal_);
+    case VERTEX_LAYOUT_HALF_POSITION:
+      return offsetof(VertexHalfPosition, normal_);
+    default:
+      return offsetof(VertexFloatPosition, normal_);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Half float
+//--------------------------------------------------------------------------------
+uint16_t vertex::FloatToHalf(const float v) { return HalfBits(v); }
+
+float vertex::HalfToFloat(const uint16_t h) {
+  const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  const uint32_t exponent = (h >> 10) & 0x1f;
+  const uint32_t mantissa = h & 0x3ff;
+
+  if (exponent == 0x1f)
+    return BitsFloat(sign | 0x7f800000 | (mantissa << 13));
+  if (exponent == 0) {
+    // Zero or denormal: mantissa * 2^-24, exact in float
+    const float v = ldexpf((float)mantissa, -24);
+    return sign ? -v : v;
+  }
+  return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+//--------------------------------------------------------------------------------
+// Normals
+//--------------------------------------------------------------------------------
+uint32_t vertex::PackSnorm10(const float* n) { return Snorm10Bits(n); }
+
+void vertex::UnpackSnorm10(const uint32_t packed, float* n) {
+  for (int32_t c = 0; c < 3; ++c) {
+    // Sign extend the field
+    int32_t v = (int32_t)((packed >> (c * 10)) & 0x3ff);
+    if (v & 0x200) v -= 0x400;
+    // As ES3 normalizes: -512 clamps to -1
+    n[c] = ClampUnit(v / SNORM10_MAX);
+  }
+}
+
+void vertex::PackSnorm16(const float* n, int16_t* packed) {
+  Snorm16Bits(n, packed);
+}
+
+void vertex::UnpackSnorm16(const int16_t* packed, float* n) {
+  for (int32_t c = 0; c < 3; ++c) n[c] = ClampUnit(packed[c] / SNORM16_MAX);
+}
+
+//--------------------------------------------------------------------------------
+// Vertices
+//--------------------------------------------------------------------------------
+void vertex::PackVertices(const VERTEX_LAYOUT layout, const float* positions,
+                          const float* normals, const int32_t num_vertices,
+                          std::vector<uint8_t>* out) {
+  // Every byte of a vertex is written below
+  out->resize((size_t)num_vertices * GetStride(layout));
+  if (!num_vertices) return;
+  // One loop per layout, so each one inlines its packing
+  switch (layout) {
+    case VERTEX_LAYOUT_PACKED: {
+      VertexPacked* v = reinterpret_cast<VertexPacked*>(&(*out)[0]);
+      for (int32_t i = 0; i < num_vertices; ++i) {
+        PackHalfPosition(&positions[i * 3], v[i].pos_);
+        v[i].normal_ = Snorm10Bits(&normals[i * 3]);
+      }
+      break;
+    }
+    case VERTEX_LAYOUT_HALF_POSITION: {
+      VertexHalfPosition* v =
+          reinterpret_cast<VertexHalfPosition*>(&(*out)[0]);
+      for (int32_t i = 0; i < num_vertices; ++i) {
+        PackHalfPosition(&positions[i * 3], v[i].pos_);
+        Snorm16Bits(&normals[i * 3], v[i].normal_);
+      }
+      break;
+    }
+    default: {
+      VertexFloatPosition* v =
+          reinterpret_cast<VertexFloatPosition*>(&(*out)[0]);
+      for (int32_t i = 0; i < num_vertices; ++i) {
+        memcpy(v[i].pos_, &positions[i * 3], sizeof(v[i].pos_));
+        Snorm16Bits(&normals[i * 3], v[i].normal_);
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Packed vertex layouts
+ * Interleaved position and normal layouts for meshes built at run time, the
+ * smallest the context can fetch without changing the shaders: every packed
+ * attribute still reaches them as a vec3 in the original units.
+ *
+ *  VERTEX_LAYOUT_PACKED (ES3), 12 bytes:
+ *   position: 4 x half float (GL_HALF_FLOAT), w = 1
+ *   normal: GL_INT_2_10_10_10_REV, normalized, w = 0
+ *  VERTEX_LAYOUT_HALF_POSITION (ES2 with GL_OES_vertex_half_float), 16 bytes:
+ *   position: 4 x half float (GL_HALF_FLOAT_OES), w = 1
+ *   normal: 4 x snorm16 (GL_SHORT, normalized), w = 0
+ *  VERTEX_LAYOUT_FLOAT_POSITION (ES2), 20 bytes:
+ *   position: 3 x float
+ *   normal: 4 x snorm16, w = 0
+ *
+ * Positions are padded to 4 components and normals to 32 bit words, so
+ * every attribute stays 4 byte aligned.
+ *
+ * Half floats keep 11 significant bits: a position is off by at most
+ * |p| * 2^-11 (VERTEX_HALF_RELATIVE_ERROR), which suits models sized around
+ * the origin. Normal components are off by at most half a step:
+ * VERTEX_NORMAL10_ERROR and VERTEX_NORMAL16_ERROR. ES2 normalizes snorm16 as
+ * (2c + 1) / 65535 rather than c / 32767, which adds up to one more step.
+ */
+enum VERTEX_LAYOUT {
+  VERTEX_LAYOUT_PACKED,
+  VERTEX_LAYOUT_HALF_POSITION,
+  VERTEX_LAYOUT_FLOAT_POSITION,
+};
+
+const float VERTEX_HALF_RELATIVE_ERROR = 1.f / 2048.f;
+// Largest finite half float
+const float VERTEX_HALF_MAX = 65504.f;
+const float VERTEX_NORMAL10_ERROR = 0.5f / 511.f;
+const float VERTEX_NORMAL16_ERROR = 0.5f / 32767.f;
+
+struct VertexPacked {
+  uint16_t pos_[4];
+  uint32_t normal_;
+};
+
+struct VertexHalfPosition {
+  uint16_t pos_[4];
+  int16_t normal_[4];
+};
+
+struct VertexFloatPosition {
+  float pos_[3];
+  int16_t normal_[4];
+};
+
+namespace vertex {
+
+/******************************************************************
+ * ChooseLayout()
+ * Smallest layout the context fetches
+ *
+ * arguments:
+ *  in: es3, the context is ES 3.0 or later
+ *  in: half_float_extension, GL_OES_vertex_half_float is exposed
+ *
+ */
+VERTEX_LAYOUT ChooseLayout(const bool es3, const bool half_float_extension);
+
+// Bytes per vertex, and offset of the normal in it
+int32_t GetStride(const VERTEX_LAYOUT layout);
+int32_t GetNormalOffset(const VERTEX_LAYOUT layout);
+
+/******************************************************************
+ * IEEE 754 binary16 conversions. FloatToHalf() rounds to nearest even;
+ * values past VERTEX_HALF_MAX become infinities, NaNs stay NaNs.
+ */
+uint16_t FloatToHalf(const float v);
+float HalfToFloat(const uint16_t h);
+
+/******************************************************************
+ * Normal packing, components clamped to [-1, 1] and rounded to nearest.
+ * The 2_10_10_10 word has x in the low bits and w = 0.
+ */
+uint32_t PackSnorm10(const float* n);
+void UnpackSnorm10(const uint32_t packed, float* n);
+void PackSnorm16(const float* n, int16_t* packed);
+void UnpackSnorm16(const int16_t* packed, float* n);
+
+/******************************************************************
+ * PackVertices()
+ * Interleave positions and normals in a layout, ready for glBufferData()
+ *
+ * arguments:
+ *  in: layout, VERTEX_LAYOUT_*
+ *  in: positions, num_vertices xyz
+ *  in: normals, num_vertices xyz, unit length
+ *  out: out, num_vertices * GetStride(layout) bytes
+ *
+ */
+void PackVertices(const VERTEX_LAYOUT layout, const float* positions,
+                  const float* normals, const int32_t num_vertices,
+                  std::vector<uint8_t>* out);
+
+}  // namespace vertex
+
+}  // namespace ndkHelper
+#endif /* VERTEX_FORMAT_H_ */
@@ -0,0 +1,322 @@
+// Generated by Teapot/tools/meshTool -lod from teapot.inl, do not edit.
+// The teapot and decimated teapots, indexing the vertices of teapot.inl.
+
+const float teapotBoundingCenter[] = { 2.72694969, 0, 20.0641994 };
+const float teapotBoundingRadius = 42.5318146;
+
+// Largest distance between teapot.inl and each level, either way, full mesh
+// first
+const float teapotLodErrors[] = { 0, 2.49892116, 4.81021976 };
+
+// Indices of each level, the levels one after another, ordered for the vertex
+// cache and overdraw
+const uint16_t teapotLodIndexCounts[] = { 3072, 1227, 612 };
+const uint16_t teapotLodIndices[] = {
+    0, 1, 2, 2, 3, 0, 3, 2, 4, 4, 5, 3, 5, 4, 6, 6,
+    7, 5, 7, 6, 8, 8, 9, 7, 1, 10, 11, 11, 2, 1, 2, 11,
+    12, 12, 4, 2, 4, 12, 13, 13, 6, 4, 6, 13, 14, 14, 8, 6,
+    10, 15, 16, 16, 11, 10, 11, 16, 17, 17, 12, 11, 12, 17, 18, 18,
+    13, 12, 13, 18, 19, 19, 14, 13, 15, 20, 21, 21, 16, 15, 16, 21,
+    22, 22, 17, 16, 17, 22, 23, 23, 18, 17, 18, 23, 24, 24, 19, 18,
+    25, 26, 27, 27, 28, 25, 28, 27, 29, 29, 30, 28, 30, 29, 31, 31,
+    32, 30, 32, 31, 33, 33, 34, 32, 26, 35, 36, 36, 27, 26, 27, 36,
+    37, 37, 29, 27, 29, 37, 38, 38, 31, 29, 31, 38, 39, 39, 33, 31,
+    35, 40, 41, 41, 36, 35, 36, 41, 42, 42, 37, 36, 37, 42, 43, 43,
+    38, 37, 38, 43, 44, 44, 39, 38, 40, 45, 46, 46, 41, 40, 41, 46,
+    47, 47, 42, 41, 42, 47, 48, 48, 43, 42, 43, 48, 49, 49, 44, 43,
+    50, 51, 52, 52, 53, 50, 53, 52, 54, 54, 55, 53, 55, 54, 56, 56,
+    57, 55, 57, 56, 58, 58, 59, 57, 51, 60, 61, 61, 52, 51, 52, 61,
+    62, 62, 54, 52, 54, 62, 63, 63, 56, 54, 56, 63, 64, 64, 58, 56,
+    60, 65, 66, 66, 61, 60, 61, 66, 67, 67, 62, 61, 62, 67, 68, 68,
+    63, 62, 63, 68, 69, 69, 64, 63, 65, 70, 71, 71, 66, 65, 66, 71,
+    72, 72, 67, 66, 67, 72, 73, 73, 68, 67, 68, 73, 74, 74, 69, 68,
+    75, 76, 77, 77, 78, 75, 78, 77, 79, 79, 80, 78, 80, 79, 81, 81,
+    82, 80, 82, 81, 83, 83, 84, 82, 76, 85, 86, 86, 77, 76, 77, 86,
+    87, 87, 79, 77, 79, 87, 88, 88, 81, 79, 81, 88, 89, 89, 83, 81,
+    85, 90, 91, 91, 86, 85, 86, 91, 92, 92, 87, 86, 87, 92, 93, 93,
+    88, 87, 88, 93, 94, 94, 89, 88, 90, 95, 96, 96, 91, 90, 91, 96,
+    97, 97, 92, 91, 92, 97, 98, 98, 93, 92, 93, 98, 99, 99, 94, 93,
+    100, 101, 102, 102, 103, 100, 103, 102, 104, 104, 105, 103, 105, 104, 106, 106,
+    107, 105, 107, 106, 108, 108, 109, 107, 101, 110, 111, 111, 102, 101, 102, 111,
+    112, 112, 104, 102, 104, 112, 113, 113, 106, 104, 106, 113, 114, 114, 108, 106,
+    110, 115, 116, 116, 111, 110, 111, 116, 117, 117, 112, 111, 112, 117, 118, 118,
+    113, 112, 113, 118, 119, 119, 114, 113, 115, 120, 121, 121, 116, 115, 116, 121,
+    122, 122, 117, 116, 117, 122, 123, 123, 118, 117, 118, 123, 124, 124, 119, 118,
+    125, 126, 127, 127, 128, 125, 128, 127, 129, 129, 130, 128, 130, 129, 131, 131,
+    132, 130, 132, 131, 133, 133, 134, 132, 126, 135, 136, 136, 127, 126, 127, 136,
+    137, 137, 129, 127, 129, 137, 138, 138, 131, 129, 131, 138, 139, 139, 133, 131,
+    135, 140, 141, 141, 136, 135, 136, 141, 142, 142, 137, 136, 137, 142, 143, 143,
+    138, 137, 138, 143, 144, 144, 139, 138, 140, 145, 146, 146, 141, 140, 141, 146,
+    147, 147, 142, 141, 142, 147, 148, 148, 143, 142, 143, 148, 149, 149, 144, 143,
+    150, 151, 152, 152, 153, 150, 153, 152, 154, 154, 155, 153, 155, 154, 156, 156,
+    157, 155, 157, 156, 158, 158, 159, 157, 151, 160, 161, 161, 152, 151, 152, 161,
+    162, 162, 154, 152, 154, 162, 163, 163, 156, 154, 156, 163, 164, 164, 158, 156,
+    160, 165, 166, 166, 161, 160, 161, 166, 167, 167, 162, 161, 162, 167, 168, 168,
+    163, 162, 163, 168, 169, 169, 164, 163, 165, 170, 171, 171, 166, 165, 166, 171,
+    172, 172, 167, 166, 167, 172, 173, 173, 168, 167, 168, 173, 174, 174, 169, 168,
+    175, 176, 177, 177, 178, 175, 178, 177, 179, 179, 180, 178, 180, 179, 181, 181,
+    182, 180, 182, 181, 183, 183, 184, 182, 176, 185, 186, 186, 177, 176, 177, 186,
+    187, 187, 179, 177, 179, 187, 188, 188, 181, 179, 181, 188, 189, 189, 183, 181,
+    185, 190, 191, 191, 186, 185, 186, 191, 192, 192, 187, 186, 187, 192, 193, 193,
+    188, 187, 188, 193, 194, 194, 189, 188, 190, 195, 196, 196, 191, 190, 191, 196,
+    197, 197, 192, 191, 192, 197, 198, 198, 193, 192, 193, 198, 199, 199, 194, 193,
+    200, 201, 202, 202, 203, 200, 203, 202, 204, 204, 205, 203, 205, 204, 206, 206,
+    207, 205, 207, 206, 208, 208, 209, 207, 201, 210, 211, 211, 202, 201, 202, 211,
+    212, 212, 204, 202, 204, 212, 213, 213, 206, 204, 206, 213, 214, 214, 208, 206,
+    210, 215, 216, 216, 211, 210, 211, 216, 217, 217, 212, 211, 212, 217, 218, 218,
+    213, 212, 213, 218, 219, 219, 214, 213, 215, 220, 221, 221, 216, 215, 216, 221,
+    222, 222, 217, 216, 217, 222, 223, 223, 218, 217, 218, 223, 224, 224, 219, 218,
+    225, 226, 227, 227, 228, 225, 228, 227, 229, 229, 230, 228, 230, 229, 231, 231,
+    232, 230, 232, 231, 233, 233, 234, 232, 226, 235, 236, 236, 227, 226, 227, 236,
+    237, 237, 229, 227, 229, 237, 238, 238, 231, 229, 231, 238, 239, 239, 233, 231,
+    235, 240, 241, 241, 236, 235, 236, 241, 242, 242, 237, 236, 237, 242, 243, 243,
+    238, 237, 238, 243, 244, 244, 239, 238, 240, 245, 246, 246, 241, 240, 241, 246,
+    247, 247, 242, 241, 242, 247, 248, 248, 243, 242, 243, 248, 249, 249, 244, 243,
+    250, 251, 252, 252, 253, 250, 253, 252, 254, 254, 255, 253, 255, 254, 256, 256,
+    257, 255, 257, 256, 258, 258, 259, 257, 251, 260, 261, 261, 252, 251, 252, 261,
+    262, 262, 254, 252, 254, 262, 263, 263, 256, 254, 256, 263, 264, 264, 258, 256,
+    260, 265, 266, 266, 261, 260, 261, 266, 267, 267, 262, 261, 262, 267, 268, 268,
+    263, 262, 263, 268, 269, 269, 264, 263, 265, 270, 271, 271, 266, 265, 266, 271,
+    272, 272, 267, 266, 267, 272, 273, 273, 268, 267, 268, 273, 274, 274, 269, 268,
+    275, 276, 277, 277, 278, 275, 278, 277, 279, 279, 280, 278, 280, 279, 281, 281,
+    282, 280, 282, 281, 283, 283, 284, 282, 276, 285, 286, 286, 277, 276, 277, 286,
+    287, 287, 279, 277, 279, 287, 288, 288, 281, 279, 281, 288, 289, 289, 283, 281,
+    285, 290, 291, 291, 286, 285, 286, 291, 292, 292, 287, 286, 287, 292, 293, 293,
+    288, 287, 288, 293, 294, 294, 289, 288, 290, 295, 296, 296, 291, 290, 291, 296,
+    297, 297, 292, 291, 292, 297, 298, 298, 293, 292, 293, 298, 299, 299, 294, 293,
+    300, 301, 302, 302, 303, 300, 303, 302, 304, 304, 305, 303, 305, 304, 306, 306,
+    307, 305, 307, 306, 308, 308, 309, 307, 301, 310, 311, 311, 302, 301, 302, 311,
+    312, 312, 304, 302, 304, 312, 313, 313, 306, 304, 306, 313, 314, 314, 308, 306,
+    310, 315, 316, 316, 311, 310, 311, 316, 317, 317, 312, 311, 312, 317, 318, 318,
+    313, 312, 313, 318, 319, 319, 314, 313, 315, 320, 321, 321, 316, 315, 316, 321,
+    322, 322, 317, 316, 317, 322, 323, 323, 318, 317, 318, 323, 324, 324, 319, 318,
+    325, 326, 327, 327, 328, 325, 328, 327, 329, 329, 330, 328, 330, 329, 331, 331,
+    332, 330, 332, 331, 333, 333, 334, 332, 326, 335, 336, 336, 327, 326, 327, 336,
+    337, 337, 329, 327, 329, 337, 338, 338, 331, 329, 331, 338, 339, 339, 333, 331,
+    335, 340, 341, 341, 336, 335, 336, 341, 342, 342, 337, 336, 337, 342, 343, 343,
+    338, 337, 338, 343, 344, 344, 339, 338, 340, 345, 346, 346, 341, 340, 341, 346,
+    347, 347, 342, 341, 342, 347, 348, 348, 343, 342, 343, 348, 349, 349, 344, 343,
+    350, 351, 352, 352, 353, 350, 353, 352, 354, 354, 355, 353, 355, 354, 356, 356,
+    357, 355, 357, 356, 358, 358, 359, 357, 351, 360, 361, 361, 352, 351, 352, 361,
+    362, 362, 354, 352, 354, 362, 363, 363, 356, 354, 356, 363, 364, 364, 358, 356,
+    360, 365, 366, 366, 361, 360, 361, 366, 367, 367, 362, 361, 362, 367, 368, 368,
+    363, 362, 363, 368, 369, 369, 364, 363, 365, 370, 371, 371, 366, 365, 366, 371,
+    372, 372, 367, 366, 367, 372, 373, 373, 368, 367, 368, 373, 374, 374, 369, 368,
+    375, 376, 377, 377, 378, 375, 378, 377, 379, 379, 380, 378, 380, 379, 381, 381,
+    382, 380, 382, 381, 383, 383, 384, 382, 376, 385, 386, 386, 377, 376, 377, 386,
+    387, 387, 379, 377, 379, 387, 388, 388, 381, 379, 381, 388, 389, 389, 383, 381,
+    385, 390, 391, 391, 386, 385, 386, 391, 392, 392, 387, 386, 387, 392, 393, 393,
+    388, 387, 388, 393, 394, 394, 389, 388, 390, 395, 396, 396, 391, 390, 391, 396,
+    397, 397, 392, 391, 392, 397, 398, 398, 393, 392, 393, 398, 399, 399, 394, 393,
+    400, 401, 402, 402, 403, 400, 403, 402, 404, 404, 405, 403, 405, 404, 406, 406,
+    407, 405, 407, 406, 408, 408, 409, 407, 401, 410, 411, 411, 402, 401, 402, 411,
+    412, 412, 404, 402, 404, 412, 413, 413, 406, 404, 406, 413, 414, 414, 408, 406,
+    410, 415, 416, 416, 411, 410, 411, 416, 417, 417, 412, 411, 412, 417, 418, 418,
+    413, 412, 413, 418, 419, 419, 414, 413, 415, 420, 421, 421, 416, 415, 416, 421,
+    422, 422, 417, 416, 417, 422, 423, 423, 418, 417, 418, 423, 424, 424, 419, 418,
+    425, 426, 427, 427, 428, 425, 428, 427, 429, 429, 430, 428, 430, 429, 431, 431,
+    432, 430, 432, 431, 433, 433, 434, 432, 426, 435, 436, 436, 427, 426, 427, 436,
+    437, 437, 429, 427, 429, 437, 438, 438, 431, 429, 431, 438, 439, 439, 433, 431,
+    435, 440, 441, 441, 436, 435, 436, 441, 442, 442, 437, 436, 437, 442, 443, 443,
+    438, 437, 438, 443, 444, 444, 439, 438, 440, 445, 446, 446, 441, 440, 441, 446,
+    447, 447, 442, 441, 442, 447, 448, 448, 443, 442, 443, 448, 449, 449, 444, 443,
+    450, 451, 452, 452, 453, 450, 453, 452, 454, 454, 455, 453, 455, 454, 456, 456,
+    457, 455, 457, 456, 458, 458, 459, 457, 451, 460, 461, 461, 452, 451, 452, 461,
+    462, 462, 454, 452, 454, 462, 463, 463, 456, 454, 456, 463, 464, 464, 458, 456,
+    460, 465, 466, 466, 461, 460, 461, 466, 467, 467, 462, 461, 462, 467, 468, 468,
+    463, 462, 463, 468, 469, 469, 464, 463, 465, 470, 471, 471, 466, 465, 466, 471,
+    472, 472, 467, 466, 467, 472, 473, 473, 468, 467, 468, 473, 474, 474, 469, 468,
+    475, 476, 477, 477, 478, 475, 478, 477, 479, 479, 480, 478, 480, 479, 481, 481,
+    482, 480, 482, 481, 483, 483, 484, 482, 476, 485, 486, 486, 477, 476, 477, 486,
+    487, 487, 479, 477, 479, 487, 488, 488, 481, 479, 481, 488, 489, 489, 483, 481,
+    485, 490, 491, 491, 486, 485, 486, 491, 492, 492, 487, 486, 487, 492, 493, 493,
+    488, 487, 488, 493, 494, 494, 489, 488, 490, 495, 496, 496, 491, 490, 491, 496,
+    497, 497, 492, 491, 492, 497, 498, 498, 493, 492, 493, 498, 499, 499, 494, 493,
+    500, 501, 502, 502, 503, 500, 503, 502, 504, 504, 505, 503, 505, 504, 506, 506,
+    507, 505, 507, 506, 508, 508, 509, 507, 501, 510, 511, 511, 502, 501, 502, 511,
+    512, 512, 504, 502, 504, 512, 513, 513, 506, 504, 506, 513, 514, 514, 508, 506,
+    510, 515, 516, 516, 511, 510, 511, 516, 517, 517, 512, 511, 512, 517, 518, 518,
+    513, 512, 513, 518, 519, 519, 514, 513, 515, 520, 521, 521, 516, 515, 516, 521,
+    522, 522, 517, 516, 517, 522, 523, 523, 518, 517, 518, 523, 524, 524, 519, 518,
+    525, 526, 527, 527, 528, 525, 528, 527, 529, 529, 530, 528, 530, 529, 531, 531,
+    532, 530, 532, 531, 533, 533, 534, 532, 526, 535, 536, 536, 527, 526, 527, 536,
+    537, 537, 529, 527, 529, 537, 538, 538, 531, 529, 531, 538, 539, 539, 533, 531,
+    535, 540, 541, 541, 536, 535, 536, 541, 542, 542, 537, 536, 537, 542, 543, 543,
+    538, 537, 538, 543, 544, 544, 539, 538, 540, 545, 546, 546, 541, 540, 541, 546,
+    547, 547, 542, 541, 542, 547, 548, 548, 543, 542, 543, 548, 549, 549, 544, 543,
+    550, 551, 552, 552, 553, 550, 553, 552, 554, 554, 555, 553, 555, 554, 556, 556,
+    557, 555, 557, 556, 558, 558, 559, 557, 551, 560, 561, 561, 552, 551, 552, 561,
+    562, 562, 554, 552, 554, 562, 563, 563, 556, 554, 556, 563, 564, 564, 558, 556,
+    560, 565, 566, 566, 561, 560, 561, 566, 567, 567, 562, 561, 562, 567, 568, 568,
+    563, 562, 563, 568, 569, 569, 564, 563, 565, 570, 571, 571, 566, 565, 566, 571,
+    572, 572, 567, 566, 567, 572, 573, 573, 568, 567, 568, 573, 574, 574, 569, 568,
+    575, 576, 577, 577, 578, 575, 578, 577, 579, 579, 580, 578, 580, 579, 581, 581,
+    582, 580, 582, 581, 583, 583, 584, 582, 576, 585, 586, 586, 577, 576, 577, 586,
+    587, 587, 579, 577, 579, 587, 588, 588, 581, 579, 581, 588, 589, 589, 583, 581,
+    585, 590, 591, 591, 586, 585, 586, 591, 592, 592, 587, 586, 587, 592, 593, 593,
+    588, 587, 588, 593, 594, 594, 589, 588, 590, 595, 596, 596, 591, 590, 591, 596,
+    597, 597, 592, 591, 592, 597, 598, 598, 593, 592, 593, 598, 599, 599, 594, 593,
+    600, 601, 602, 602, 603, 600, 603, 602, 604, 604, 605, 603, 605, 604, 606, 606,
+    607, 605, 607, 606, 608, 608, 609, 607, 601, 610, 611, 611, 602, 601, 602, 611,
+    612, 612, 604, 602, 604, 612, 613, 613, 606, 604, 606, 613, 614, 614, 608, 606,
+    610, 615, 616, 616, 611, 610, 611, 616, 617, 617, 612, 611, 612, 617, 618, 618,
+    613, 612, 613, 618, 619, 619, 614, 613, 615, 620, 621, 621, 616, 615, 616, 621,
+    622, 622, 617, 616, 617, 622, 623, 623, 618, 617, 618, 623, 624, 624, 619, 618,
+    625, 626, 627, 627, 628, 625, 628, 627, 629, 629, 630, 628, 630, 629, 631, 631,
+    632, 630, 632, 631, 633, 633, 634, 632, 626, 635, 636, 636, 627, 626, 627, 636,
+    637, 637, 629, 627, 629, 637, 638, 638, 631, 629, 631, 638, 639, 639, 633, 631,
+    635, 640, 641, 641, 636, 635, 636, 641, 642, 642, 637, 636, 637, 642, 643, 643,
+    638, 637, 638, 643, 644, 644, 639, 638, 640, 645, 646, 646, 641, 640, 641, 646,
+    647, 647, 642, 641, 642, 647, 648, 648, 643, 642, 643, 648, 649, 649, 644, 643,
+    650, 651, 652, 652, 653, 650, 653, 652, 654, 654, 655, 653, 655, 654, 656, 656,
+    657, 655, 657, 656, 658, 658, 659, 657, 651, 660, 661, 661, 652, 651, 652, 661,
+    662, 662, 654, 652, 654, 662, 663, 663, 656, 654, 656, 663, 664, 664, 658, 656,
+    660, 665, 666, 666, 661, 660, 661, 666, 667, 667, 662, 661, 662, 667, 668, 668,
+    663, 662, 663, 668, 669, 669, 664, 663, 665, 670, 671, 671, 666, 665, 666, 671,
+    672, 672, 667, 666, 667, 672, 673, 673, 668, 667, 668, 673, 674, 674, 669, 668,
+    675, 676, 677, 677, 678, 675, 678, 677, 679, 679, 680, 678, 680, 679, 681, 681,
+    682, 680, 682, 681, 683, 683, 684, 682, 676, 685, 686, 686, 677, 676, 677, 686,
+    687, 687, 679, 677, 679, 687, 688, 688, 681, 679, 681, 688, 689, 689, 683, 681,
+    685, 690, 691, 691, 686, 685, 686, 691, 692, 692, 687, 686, 687, 692, 693, 693,
+    688, 687, 688, 693, 694, 694, 689, 688, 690, 695, 696, 696, 691, 690, 691, 696,
+    697, 697, 692, 691, 692, 697, 698, 698, 693, 692, 693, 698, 699, 699, 694, 693,
+    700, 701, 702, 702, 703, 700, 703, 702, 704, 704, 705, 703, 705, 704, 706, 706,
+    707, 705, 707, 706, 708, 708, 709, 707, 701, 710, 711, 711, 702, 701, 702, 711,
+    712, 712, 704, 702, 704, 712, 713, 713, 706, 704, 706, 713, 714, 714, 708, 706,
+    710, 715, 716, 716, 711, 710, 711, 716, 717, 717, 712, 711, 712, 717, 718, 718,
+    713, 712, 713, 718, 719, 719, 714, 713, 715, 720, 721, 721, 716, 715, 716, 721,
+    722, 722, 717, 716, 717, 722, 723, 723, 718, 717, 718, 723, 724, 724, 719, 718,
+    725, 726, 727, 727, 728, 725, 728, 727, 729, 729, 730, 728, 730, 729, 731, 731,
+    732, 730, 732, 731, 733, 733, 734, 732, 726, 735, 736, 736, 727, 726, 727, 736,
+    737, 737, 729, 727, 729, 737, 738, 738, 731, 729, 731, 738, 739, 739, 733, 731,
+    735, 740, 741, 741, 736, 735, 736, 741, 742, 742, 737, 736, 737, 742, 743, 743,
+    738, 737, 738, 743, 744, 744, 739, 738, 740, 745, 746, 746, 741, 740, 741, 746,
+    747, 747, 742, 741, 742, 747, 748, 748, 743, 742, 743, 748, 749, 749, 744, 743,
+    750, 751, 752, 752, 753, 750, 753, 752, 754, 754, 755, 753, 755, 754, 756, 756,
+    757, 755, 757, 756, 758, 758, 759, 757, 751, 760, 761, 761, 752, 751, 752, 761,
+    762, 762, 754, 752, 754, 762, 763, 763, 756, 754, 756, 763, 764, 764, 758, 756,
+    760, 765, 766, 766, 761, 760, 761, 766, 767, 767, 762, 761, 762, 767, 768, 768,
+    763, 762, 763, 768, 769, 769, 764, 763, 765, 770, 771, 771, 766, 765, 766, 771,
+    772, 772, 767, 766, 767, 772, 773, 773, 768, 767, 768, 773, 774, 774, 769, 768,
+    775, 776, 777, 777, 778, 775, 778, 777, 779, 779, 780, 778, 780, 779, 781, 781,
+    782, 780, 782, 781, 783, 783, 784, 782, 776, 785, 786, 786, 777, 776, 777, 786,
+    787, 787, 779, 777, 779, 787, 788, 788, 781, 779, 781, 788, 789, 789, 783, 781,
+    785, 790, 791, 791, 786, 785, 786, 791, 792, 792, 787, 786, 787, 792, 793, 793,
+    788, 787, 788, 793, 794, 794, 789, 788, 790, 795, 796, 796, 791, 790, 791, 796,
+    797, 797, 792, 791, 792, 797, 798, 798, 793, 792, 793, 798, 799, 799, 794, 793,
+    559, 594, 583, 558, 559, 583, 583, 562, 558, 564, 558, 562, 569, 564, 562, 574,
+    569, 562, 583, 574, 572, 562, 572, 574, 572, 579, 583, 572, 562, 567, 572, 567,
+    566, 562, 566, 567, 572, 523, 579, 572, 566, 523, 583, 579, 523, 562, 523, 566,
+    562, 583, 509, 509, 508, 562, 544, 509, 583, 562, 508, 504, 508, 509, 504, 544,
+    583, 538, 523, 538, 583, 509, 544, 543, 538, 543, 544, 543, 504, 509, 538, 523,
+    529, 543, 538, 536, 529, 536, 538, 504, 543, 542, 536, 542, 543, 504, 542, 541,
+    536, 541, 542, 504, 541, 540, 535, 540, 541, 541, 536, 535, 540, 500, 504, 526,
+    535, 536, 520, 526, 536, 536, 521, 520, 521, 536, 529, 515, 520, 521, 529, 523,
+    521, 521, 516, 515, 516, 521, 523, 510, 515, 516, 523, 517, 516, 516, 511, 510,
+    511, 516, 517, 511, 517, 523, 523, 562, 511, 501, 510, 511, 504, 511, 562, 511,
+    502, 501, 511, 504, 502, 500, 501, 502, 502, 504, 500, 0, 1, 5, 90, 0,
+    5, 85, 90, 5, 12, 5, 1, 1, 10, 12, 10, 15, 20, 20, 12, 10,
+    35, 20, 26, 12, 20, 19, 35, 31, 20, 20, 31, 33, 33, 24, 20, 24,
+    19, 20, 137, 33, 31, 31, 35, 137, 24, 33, 127, 137, 127, 33, 127, 122,
+    24, 19, 24, 122, 137, 129, 127, 122, 127, 129, 137, 131, 129, 122, 129, 131,
+    122, 116, 19, 112, 19, 116, 19, 112, 12, 122, 117, 116, 112, 116, 117, 122,
+    118, 117, 112, 117, 118, 118, 122, 124, 6, 12, 112, 12, 6, 5, 112, 8,
+    6, 5, 6, 8, 112, 102, 8, 5, 8, 102, 112, 118, 119, 124, 119, 118,
+    112, 104, 102, 112, 106, 104, 105, 102, 104, 105, 104, 106, 102, 105, 5, 106,
+    112, 114, 119, 114, 112, 114, 108, 106, 105, 106, 108, 114, 119, 216, 108, 114,
+    211, 216, 211, 114, 221, 216, 119, 119, 124, 221, 211, 216, 217, 216, 221, 321,
+    321, 217, 216, 227, 221, 124, 229, 321, 221, 221, 227, 229, 124, 133, 227, 133,
+    124, 122, 122, 131, 133, 139, 133, 131, 131, 137, 139, 236, 227, 133, 133, 139,
+    236, 227, 236, 237, 237, 229, 227, 241, 236, 139, 229, 237, 336, 336, 321, 229,
+    242, 237, 236, 236, 241, 242, 237, 242, 243, 243, 336, 237, 346, 243, 242, 336,
+    243, 346, 346, 242, 241, 321, 336, 331, 336, 346, 331, 311, 321, 331, 311, 218,
+    321, 321, 218, 217, 212, 217, 218, 218, 311, 212, 217, 212, 211, 202, 211, 212,
+    211, 202, 108, 212, 204, 202, 204, 212, 311, 109, 108, 202, 108, 109, 105, 203,
+    202, 204, 202, 203, 109, 204, 303, 203, 311, 303, 204, 194, 109, 203, 303, 311,
+    306, 331, 306, 311, 109, 194, 193, 193, 105, 109, 306, 331, 308, 105, 193, 192,
+    331, 356, 308, 356, 331, 346, 381, 306, 308, 356, 381, 308, 306, 381, 303, 381,
+    356, 361, 346, 361, 356, 386, 303, 381, 361, 346, 254, 371, 386, 381, 361, 371,
+    381, 254, 346, 246, 241, 246, 346, 254, 262, 361, 246, 241, 144, 139, 144, 241,
+    144, 139, 137, 246, 252, 254, 262, 254, 252, 144, 149, 246, 252, 246, 149, 149,
+    144, 143, 137, 143, 144, 149, 158, 252, 137, 142, 143, 137, 141, 142, 147, 143,
+    142, 147, 142, 141, 143, 147, 149, 137, 44, 141, 147, 141, 44, 44, 137, 35,
+    35, 47, 44, 44, 47, 147, 35, 40, 47, 40, 45, 47, 45, 51, 47, 62,
+    47, 51, 51, 60, 62, 62, 56, 47, 47, 56, 58, 47, 58, 152, 152, 147,
+    47, 162, 58, 56, 162, 152, 58, 56, 62, 162, 147, 152, 154, 162, 154, 152,
+    147, 154, 156, 162, 156, 154, 147, 156, 158, 158, 149, 147, 164, 158, 156, 156,
+    162, 164, 158, 164, 261, 261, 252, 158, 252, 261, 262, 266, 261, 164, 267, 262,
+    261, 261, 266, 267, 262, 267, 268, 268, 361, 262, 361, 268, 371, 371, 268, 267,
+    371, 267, 266, 164, 169, 266, 169, 164, 162, 266, 271, 371, 271, 266, 169, 279,
+    371, 271, 386, 371, 279, 169, 174, 271, 271, 277, 279, 277, 271, 174, 279, 287,
+    386, 287, 279, 277, 293, 386, 287, 386, 293, 303, 287, 292, 293, 303, 293, 292,
+    292, 287, 286, 277, 286, 287, 303, 292, 291, 286, 291, 292, 291, 203, 303, 203,
+    291, 194, 291, 286, 189, 189, 194, 291, 286, 277, 183, 183, 189, 286, 174, 183,
+    277, 189, 183, 181, 183, 174, 172, 172, 181, 183, 194, 189, 187, 181, 187, 189,
+    187, 193, 194, 187, 192, 193, 187, 181, 179, 172, 179, 181, 187, 191, 192, 105,
+    192, 191, 105, 191, 94, 187, 94, 191, 94, 5, 105, 87, 5, 94, 94, 187,
+    87, 5, 87, 85, 76, 85, 87, 81, 87, 187, 87, 72, 76, 87, 81, 72,
+    70, 76, 72, 65, 70, 72, 60, 65, 72, 72, 62, 60, 62, 72, 69, 69,
+    162, 62, 72, 81, 83, 187, 83, 81, 187, 177, 83, 72, 83, 177, 187, 179,
+    177, 172, 177, 179, 177, 172, 72, 69, 72, 172, 172, 166, 69, 162, 69, 166,
+    172, 167, 166, 162, 166, 167, 172, 168, 167, 162, 167, 168, 168, 172, 174, 162,
+    168, 169, 174, 169, 168, 400, 401, 405, 440, 400, 405, 435, 440, 405, 412, 405,
+    401, 401, 410, 412, 405, 437, 435, 426, 435, 437, 437, 422, 426, 420, 426, 422,
+    415, 420, 422, 410, 415, 422, 422, 412, 410, 412, 422, 418, 418, 413, 412, 405,
+    412, 413, 418, 422, 424, 413, 418, 414, 424, 414, 418, 405, 413, 414, 439, 424,
+    422, 422, 437, 439, 405, 439, 437, 414, 409, 405, 409, 439, 405, 409, 414, 463,
+    463, 439, 409, 462, 463, 414, 472, 462, 414, 472, 463, 462, 414, 424, 472, 424,
+    439, 472, 463, 472, 469, 469, 464, 463, 474, 469, 472, 464, 458, 463, 483, 474,
+    472, 489, 483, 472, 457, 463, 458, 463, 457, 439, 458, 149, 457, 492, 439, 457,
+    493, 457, 149, 457, 493, 492, 149, 494, 493, 489, 493, 494, 487, 492, 493, 493,
+    489, 487, 492, 487, 439, 472, 487, 489, 472, 439, 487, 602, 691, 600, 691, 666,
+    600, 616, 602, 600, 666, 691, 683, 691, 602, 683, 666, 652, 600, 652, 666, 683,
+    652, 641, 600, 641, 616, 600, 641, 652, 654, 683, 654, 652, 641, 654, 656, 683,
+    656, 654, 616, 641, 633, 656, 633, 641, 602, 616, 633, 633, 683, 602, 633, 656,
+    658, 656, 683, 658, 761, 633, 658, 683, 761, 658, 633, 761, 763, 761, 683, 773,
+    773, 763, 761, 763, 773, 769, 769, 764, 763, 774, 769, 773, 783, 774, 773, 789,
+    783, 773, 756, 763, 764, 763, 756, 633, 764, 758, 756, 748, 756, 758, 748, 633,
+    756, 758, 749, 748, 743, 748, 749, 749, 744, 743, 738, 748, 743, 738, 743, 744,
+    748, 738, 633, 744, 739, 738, 738, 723, 633, 723, 738, 739, 739, 733, 723, 733,
+    724, 723, 724, 719, 723, 683, 633, 723, 713, 723, 719, 723, 713, 683, 719, 714,
+    713, 706, 713, 714, 713, 706, 683, 714, 708, 706, 707, 706, 708, 707, 683, 706,
+    708, 709, 707, 707, 788, 683, 788, 773, 683, 773, 788, 789, 794, 789, 788, 788,
+    707, 793, 788, 793, 794, 793, 707, 709, 709, 794, 793, 559, 594, 583, 558, 559,
+    583, 583, 562, 558, 564, 558, 562, 569, 564, 562, 574, 569, 562, 583, 574, 572,
+    562, 572, 574, 572, 579, 583, 572, 523, 579, 583, 579, 523, 572, 567, 523, 572,
+    562, 567, 562, 523, 567, 544, 583, 523, 544, 562, 583, 523, 543, 544, 562, 544,
+    543, 543, 523, 536, 536, 562, 543, 521, 536, 523, 562, 521, 523, 536, 521, 520,
+    520, 526, 536, 515, 520, 521, 526, 535, 536, 521, 562, 515, 562, 536, 535, 510,
+    515, 562, 535, 540, 562, 501, 510, 562, 540, 500, 562, 500, 501, 562, 0, 10,
+    12, 20, 12, 10, 0, 12, 112, 20, 112, 12, 35, 20, 26, 112, 20, 118,
+    20, 35, 137, 45, 137, 35, 118, 20, 227, 137, 227, 20, 112, 118, 119, 227,
+    119, 118, 119, 202, 112, 112, 202, 0, 227, 216, 119, 202, 119, 216, 202, 216,
+    217, 321, 217, 216, 202, 217, 321, 216, 227, 321, 321, 311, 202, 336, 321, 227,
+    311, 321, 331, 321, 336, 331, 331, 306, 311, 336, 346, 331, 346, 336, 227, 306,
+    331, 308, 331, 356, 308, 356, 331, 346, 381, 306, 308, 356, 381, 308, 303, 311,
+    306, 306, 381, 303, 311, 303, 202, 381, 356, 361, 346, 361, 356, 361, 371, 381,
+    371, 386, 381, 386, 303, 381, 371, 361, 252, 361, 346, 252, 386, 371, 277, 303,
+    386, 277, 266, 277, 371, 371, 252, 266, 277, 292, 303, 303, 292, 291, 277, 291,
+    292, 291, 202, 303, 202, 291, 194, 277, 194, 291, 202, 194, 193, 193, 0, 202,
+    187, 193, 194, 187, 0, 193, 194, 277, 187, 0, 187, 87, 0, 87, 85, 70,
+    85, 87, 70, 87, 187, 187, 277, 70, 168, 70, 277, 277, 169, 168, 277, 266,
+    169, 252, 169, 266, 162, 168, 169, 162, 70, 168, 169, 252, 162, 70, 162, 62,
+    70, 62, 60, 45, 60, 62, 45, 62, 162, 162, 252, 45, 252, 149, 45, 143,
+    45, 149, 137, 45, 143, 137, 143, 144, 149, 144, 143, 144, 227, 137, 144, 149,
+    252, 252, 241, 144, 227, 144, 241, 241, 252, 346, 227, 241, 242, 227, 242, 346,
+    346, 242, 241, 149, 494, 493, 489, 493, 494, 493, 457, 149, 458, 149, 457, 493,
+    489, 487, 457, 493, 492, 487, 492, 493, 457, 463, 458, 464, 458, 463, 469, 464,
+    463, 492, 439, 457, 492, 487, 439, 463, 457, 439, 472, 487, 489, 472, 439, 487,
+    489, 483, 472, 483, 474, 472, 474, 469, 472, 463, 472, 469, 472, 463, 414, 409,
+    414, 463, 463, 439, 409, 414, 422, 472, 422, 439, 472, 414, 409, 405, 409, 439,
+    405, 405, 422, 414, 405, 439, 437, 422, 437, 439, 405, 437, 435, 426, 435, 437,
+    437, 422, 426, 435, 440, 405, 440, 400, 405, 400, 401, 405, 422, 405, 401, 401,
+    410, 422, 410, 415, 422, 415, 420, 422, 420, 426, 422, 683, 616, 633, 616, 641,
+    633, 641, 616, 683, 656, 633, 641, 641, 654, 656, 641, 652, 654, 652, 641, 683,
+    683, 654, 652, 683, 656, 654, 633, 656, 658, 656, 683, 658, 761, 633, 658, 683,
+    761, 658, 633, 761, 763, 683, 763, 761, 763, 756, 633, 756, 763, 764, 769, 764,
+    763, 763, 683, 769, 764, 758, 756, 774, 769, 683, 783, 774, 683, 789, 783, 683,
+    794, 789, 683, 709, 794, 683, 708, 709, 683, 714, 708, 683, 719, 714, 683, 683,
+    723, 719, 724, 719, 723, 733, 724, 723, 739, 733, 723, 683, 633, 723, 723, 738,
+    739, 738, 723, 633, 744, 739, 738, 738, 743, 744, 749, 744, 743, 738, 748, 743,
+    743, 748, 749, 748, 738, 633, 758, 749, 748, 748, 633, 756, 748, 756, 758
+};
@@ -0,0 +1,650 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// teapotTransformsTest.cpp
+// Host test and benchmark of the frustum culling and level of detail
+// selection of TeapotTransforms, and of the levels of detail meshTool built
+// into teapotLod.inl.
+//
+// The mesh data must hold what Classify() relies on: the bounding sphere
+// contains every teapot.inl vertex, and teapotLodErrors is the largest
+// distance between teapot.inl and each level, recomputed here by brute
+// force: from every teapot.inl vertex to the level, and from points spread
+// over the level's triangles to teapot.inl.
+//
+// Random cameras and projections then look at random teapots. No teapot
+// with any vertex inside the clip volume may be culled, and culling must
+// match the sphere test done in double precision. Each visible teapot must
+// get the coarsest level whose error, projected at the nearest depth of its
+// bounding sphere, stays under TEAPOT_LOD_MAX_ERROR. The visible teapots
+// must be grouped by level in teapot order, with their instance records,
+// and updating on the job threads must give the same result.
+//
+// Last, Update() is timed for the sample's grids of teapots, and
+// SimplifyIndices() for each level.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  NDK_HELPER=$JNI/ndk_helper
+//  MESH_TOOL=../../../Teapot/tools/meshTool
+//  g++ -O2 -pthread -I$JNI -I$NDK_HELPER -I$MESH_TOOL -o teapotTransformsTest
+//  teapotTransformsTest.cpp $JNI/TeapotTransforms.cpp $NDK_HELPER/vecmath.cpp
+//  $NDK_HELPER/vecmathArray.cpp $NDK_HELPER/jobSystem.cpp
+//  $MESH_TOOL/meshSimplifier.cpp
+//  ./teapotTransformsTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "TeapotTransforms.h"
+#include "jobSystem.h"
+#include "meshSimplifier.h"
+#include "vecmath.h"
+
+#include "teapot.inl"
+#include "teapotLod.inl"
+
+using ndk_helper::JobSystem;
+using ndk_helper::Mat4;
+using ndk_helper::Vec3;
+
+namespace {
+
+const int32_t NUM_VERTICES =
+    sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
+const int32_t NUM_LODS =
+    sizeof(teapotLodIndexCounts) / sizeof(teapotLodIndexCounts[0]);
+// As MoreTeapotsRenderer
+const int32_t NUM_SOURCE_INDICES =
+    sizeof(teapotIndices) / sizeof(teapotIndices[0]);
+const float CAM_NEAR = 5.f;
+const float CAM_FAR = 10000.f;
+const float GRID_WIDTH = 500.f;
+
+const int32_t NUM_SCENES = 40;
+const int32_t SCENE_TEAPOTS = 1000;
+// Samples per triangle edge for the level to full mesh distance
+const int32_t SURFACE_SAMPLES = 8;
+// Relative slack for float against double results
+const double TOLERANCE = 1e-4;
+// Grid sizes timed, as the sample's numX * numY * numZ
+const int32_t BENCH_GRIDS[] = {8, 16, 32};
+const int32_t NUM_BENCH_GRIDS = sizeof(BENCH_GRIDS) / sizeof(BENCH_GRIDS[0]);
+const int32_t BENCH_RUNS = 7;
+const int32_t SIMPLIFY_RUNS = 3;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("  FAILED: ");     \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      ++g_failures;             \
+    }                           \
+  } while (0)
+
+uint32_t g_seed = 12345;
+
+// In [-1, 1)
+float Random() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return (g_seed >> 8) * (1.f / 16777216.f) * 2.f - 1.f;
+}
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//--------------------------------------------------------------------------------
+// Geometry, in double
+//--------------------------------------------------------------------------------
+struct Point {
+  double v_[3];
+  Point() { v_[0] = v_[1] = v_[2] = 0.0; }
+  Point(const double x, const double y, const double z) {
+    v_[0] = x;
+    v_[1] = y;
+    v_[2] = z;
+  }
+  explicit Point(const float* p) {
+    for (int32_t c = 0; c < 3; ++c) v_[c] = p[c];
+  }
+  Point operator+(const Point& p) const {
+    return Point(v_[0] + p.v_[0], v_[1] + p.v_[1], v_[2] + p.v_[2]);
+  }
+  Point operator-(const Point& p) const {
+    return Point(v_[0] - p.v_[0], v_[1] - p.v_[1], v_[2] - p.v_[2]);
+  }
+  Point operator*(const double s) const {
+    return Point(v_[0] * s, v_[1] * s, v_[2] * s);
+  }
+  double Dot(const Point& p) const {
+    return v_[0] * p.v_[0] + v_[1] * p.v_[1] + v_[2] * p.v_[2];
+  }
+  double Length() const { return sqrt(Dot(*this)); }
+};
+
+Point Vertex(const int32_t i) { return Point(&teapotPositions[i * 3]); }
+
+// Closest point on triangle abc (Ericson, Real-Time Collision Detection)
+double PointTriangleDistance(const Point& p, const Point& a, const Point& b,
+                             const Point& c) {
+  const Point ab = b - a, ac = c - a, ap = p - a;
+  const double d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+  if (d1 <= 0.0 && d2 <= 0.0) return ap.Length();
+  const Point bp = p - b;
+  const double d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+  if (d3 >= 0.0 && d4 <= d3) return bp.Length();
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    return (p - (a + ab * (d1 / (d1 - d3)))).Length();
+  const Point cp = p - c;
+  const double d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+  if (d6 >= 0.0 && d5 <= d6) return cp.Length();
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    return (p - (a + ac * (d2 / (d2 - d6)))).Length();
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+    return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))))
+        .Length();
+  const double denom = 1.0 / (va + vb + vc);
+  return (p - (a + ab * (vb * denom) + ac * (vc * denom))).Length();
+}
+
+double SurfaceDistance(const Point& p, const uint16_t* indices,
+                       const int32_t num_indices) {
+  double distance = HUGE_VAL;
+  for (int32_t t = 0; t < num_indices; t += 3)
+    distance = std::min(
+        distance, PointTriangleDistance(p, Vertex(indices[t]),
+                                        Vertex(indices[t + 1]),
+                                        Vertex(indices[t + 2])));
+  return distance;
+}
+
+const uint16_t* LodIndices(const int32_t lod) {
+  const uint16_t* indices = teapotLodIndices;
+  for (int32_t l = 0; l < lod; ++l) indices += teapotLodIndexCounts[l];
+  return indices;
+}
+
+// Column major, as Mat4
+void Transform(const float* m, const Point& p, double* out) {
+  for (int32_t r = 0; r < 4; ++r)
+    out[r] = m[r] * p.v_[0] + m[4 + r] * p.v_[1] + m[8 + r] * p.v_[2] +
+             m[12 + r];
+}
+
+//--------------------------------------------------------------------------------
+// Mesh data
+//--------------------------------------------------------------------------------
+void TestMeshData() {
+  printf("Mesh data\n");
+  const Point center(teapotBoundingCenter);
+  double farthest = 0.0;
+  for (int32_t i = 0; i < NUM_VERTICES; ++i)
+    farthest = std::max(farthest, (Vertex(i) - center).Length());
+  printf("  bounding sphere radius %.4f, farthest vertex %.4f\n",
+         teapotBoundingRadius, farthest);
+  CHECK(farthest <= teapotBoundingRadius * (1.0 + TOLERANCE),
+        "a vertex is outside the bounding sphere");
+
+  // The full level is teapot.inl's triangles, in any order
+  CHECK(teapotLodIndexCounts[0] == NUM_SOURCE_INDICES &&
+            teapotLodErrors[0] == 0.f,
+        "level 0 is not the full mesh");
+  std::vector<uint64_t> source, full;
+  for (int32_t t = 0; t < NUM_SOURCE_INDICES; t += 3) {
+    source.push_back((uint64_t)teapotIndices[t] << 32 |
+                     teapotIndices[t + 1] << 16 | teapotIndices[t + 2]);
+  }
+  const uint16_t* lod0 = LodIndices(0);
+  for (int32_t t = 0; t < teapotLodIndexCounts[0]; t += 3) {
+    // Rotated so the smallest index comes first, keeping the winding
+    int32_t first = 0;
+    for (int32_t c = 1; c < 3; ++c)
+      if (lod0[t + c] < lod0[t + first]) first = c;
+    uint16_t v[3];
+    for (int32_t c = 0; c < 3; ++c) v[c] = lod0[t + (first + c) % 3];
+    full.push_back((uint64_t)v[0] << 32 | v[1] << 16 | v[2]);
+  }
+  for (size_t t = 0; t < source.size(); ++t) {
+    // teapot.inl's triangles get the same rotation
+    const uint16_t a = source[t] >> 32, b = source[t] >> 16, c = source[t];
+    if (b < a && b <= c)
+      source[t] = (uint64_t)b << 32 | c << 16 | a;
+    else if (c < a && c < b)
+      source[t] = (uint64_t)c << 32 | a << 16 | b;
+  }
+  std::sort(source.begin(), source.end());
+  std::sort(full.begin(), full.end());
+  CHECK(source == full, "level 0 has other triangles than teapot.inl");
+
+  for (int32_t l = 1; l < NUM_LODS; ++l) {
+    const uint16_t* indices = LodIndices(l);
+    const int32_t count = teapotLodIndexCounts[l];
+    double error = 0.0;
+    for (int32_t i = 0; i < NUM_VERTICES; ++i)
+      error = std::max(error, SurfaceDistance(Vertex(i), indices, count));
+
+    // Points spread over the level's triangles, to the full mesh
+    double back = 0.0;
+    for (int32_t t = 0; t < count; t += 3) {
+      const Point a = Vertex(indices[t]);
+      const Point ab = Vertex(indices[t + 1]) - a;
+      const Point ac = Vertex(indices[t + 2]) - a;
+      for (int32_t u = 0; u <= SURFACE_SAMPLES; ++u)
+        for (int32_t v = 0; u + v <= SURFACE_SAMPLES; ++v) {
+          const Point p = a + ab * ((double)u / SURFACE_SAMPLES) +
+                          ac * ((double)v / SURFACE_SAMPLES);
+          back = std::max(back, SurfaceDistance(p, teapotIndices,
+                                                NUM_SOURCE_INDICES));
+        }
+    }
+    printf("  level %d: %d triangles, full mesh to level %.4f, level to "
+           "full mesh %.4f, teapotLodErrors %.4f\n",
+           l, count / 3, error, back, teapotLodErrors[l]);
+    error = std::max(error, back);
+    CHECK(fabs(error - teapotLodErrors[l]) <= teapotLodErrors[l] * TOLERANCE,
+          "level %d: teapotLodErrors is not its largest distance", l);
+    CHECK(teapotLodErrors[l] > teapotLodErrors[l - 1],
+          "level %d: errors do not increase", l);
+    CHECK(count < teapotLodIndexCounts[l - 1],
+          "level %d: no fewer triangles than level %d", l, l - 1);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Culling and levels of detail
+//--------------------------------------------------------------------------------
+struct Scene {
+  Mat4 view_;
+  Mat4 projection_;
+  std::vector<Mat4> models_;
+  std::vector<float> angles_x_, angles_y_, speeds_x_, speeds_y_;
+  std::vector<float> colors_;
+};
+
+void RandomScene(const int32_t count, Scene* scene) {
+  // Teapots in a box around the origin, looked at from inside or outside it
+  const float box = 150.f + 1000.f * (Random() + 1.f);
+  const Vec3 eye(Random() * box * 1.5f, Random() * box * 1.5f,
+                 Random() * box * 1.5f);
+  const Vec3 at(Random() * box * 0.3f, Random() * box * 0.3f,
+                Random() * box * 0.3f);
+  scene->view_ = Mat4::LookAt(eye, at, Vec3(0.f, 1.f, 0.f));
+  // From a narrow view as the sample's to a wide one, in either orientation
+  const float width = 0.1f + 4.5f * (Random() + 1.f) / 2.f;
+  const float aspect = 0.4f + 0.6f * (Random() + 1.f) / 2.f;
+  const float near = CAM_NEAR * (0.2f + (Random() + 1.f));
+  scene->projection_ =
+      Random() < 0.f ? Mat4::Perspective(width * aspect, width, near, CAM_FAR)
+                     : Mat4::Perspective(width, width * aspect, near, CAM_FAR);
+
+  scene->models_.clear();
+  scene->angles_x_.clear();
+  scene->angles_y_.clear();
+  scene->speeds_x_.clear();
+  scene->speeds_y_.clear();
+  scene->colors_.clear();
+  for (int32_t i = 0; i < count; ++i) {
+    scene->models_.push_back(
+        Mat4::Translation(Random() * box, Random() * box, Random() * box));
+    scene->angles_x_.push_back(Random() * (float)M_PI);
+    scene->angles_y_.push_back(Random() * (float)M_PI);
+    scene->speeds_x_.push_back(Random() * 0.05f);
+    scene->speeds_y_.push_back(Random() * 0.05f);
+    for (int32_t c = 0; c < 3; ++c)
+      scene->colors_.push_back((Random() + 1.f) / 2.f);
+  }
+}
+
+void SetScene(const Scene& scene, TeapotTransforms* transforms) {
+  const int32_t count = (int32_t)scene.models_.size();
+  transforms->Init(count);
+  transforms->SetMesh(teapotBoundingCenter, teapotBoundingRadius,
+                      teapotLodErrors, NUM_LODS);
+  for (int32_t i = 0; i < count; ++i)
+    transforms->SetTeapot(i, scene.models_[i], scene.angles_x_[i],
+                          scene.angles_y_[i], scene.speeds_x_[i],
+                          scene.speeds_y_[i], &scene.colors_[i * 3]);
+}
+
+struct Stats {
+  int32_t teapots_;
+  int32_t culled_;
+  int32_t vertex_visible_;
+  int32_t lods_[TEAPOT_MAX_LODS];
+  double worst_lod_error_;
+};
+
+// Checks one update of |scene|, |frame| updates after SetScene()
+void CheckUpdate(const Scene& scene, const int32_t frame,
+                 const TeapotTransforms& transforms,
+                 const std::vector<float>& instances, Stats* stats) {
+  const int32_t count = transforms.GetCount();
+  Mat4 projection = scene.projection_;
+  const float* p = projection.Ptr();
+
+  // Frustum planes, normalized, and the scale of the projection
+  double planes[6][4];
+  for (int32_t i = 0; i < 6; ++i) {
+    double length = 0.0;
+    for (int32_t c = 0; c < 4; ++c) {
+      planes[i][c] = (double)p[c * 4 + 3] +
+                     (i & 1 ? -1.0 : 1.0) * (double)p[c * 4 + i / 2];
+      if (c < 3) length += planes[i][c] * planes[i][c];
+    }
+    for (int32_t c = 0; c < 4; ++c) planes[i][c] /= sqrt(length);
+  }
+  const double scale = std::max(fabs(p[0]), fabs(p[5]));
+  const double radius = teapotBoundingRadius;
+  const Point center(teapotBoundingCenter);
+
+  std::vector<int32_t> expected_visible[TEAPOT_MAX_LODS];
+  for (int32_t i = 0; i < count; ++i) {
+    // The matrices the teapot is drawn with
+    const float angle_x = scene.angles_x_[i] + scene.speeds_x_[i] * frame;
+    const float angle_y = scene.angles_y_[i] + scene.speeds_y_[i] * frame;
+    Mat4 model_view = scene.view_ * scene.models_[i] *
+                      Mat4::RotationX(angle_x) * Mat4::RotationY(angle_y);
+    Mat4 mvp = scene.projection_ * model_view;
+    float mv[16], mat_mvp[16];
+    transforms.GetModelView(i, mv);
+    transforms.GetModelViewProjection(i, mat_mvp);
+    double mv_error = 0.0, mvp_error = 0.0;
+    for (int32_t c = 0; c < 16; ++c) {
+      mv_error = std::max(mv_error, (double)fabsf(mv[c] - model_view.Ptr()[c]));
+      mvp_error = std::max(mvp_error, (double)fabsf(mat_mvp[c] - mvp.Ptr()[c]));
+    }
+    if (mv_error > 1e-3 * (1.f + fabsf(model_view.Ptr()[14])) ||
+        mvp_error > 1e-3 * (1.f + fabsf(mvp.Ptr()[14]))) {
+      CHECK(false, "teapot %d: matrices off by %g, %g", i, mv_error,
+            mvp_error);
+      return;
+    }
+
+    // The sphere test in double, with the matrix the teapot got
+    double view_center[4];
+    Transform(mv, center, view_center);
+    double nearest_plane = HUGE_VAL;
+    for (int32_t c = 0; c < 6; ++c)
+      nearest_plane = std::min(
+          nearest_plane, planes[c][0] * view_center[0] +
+                             planes[c][1] * view_center[1] +
+                             planes[c][2] * view_center[2] + planes[c][3]);
+    const int32_t lod = transforms.GetLod(i);
+    ++stats->teapots_;
+    const double slack = radius * TOLERANCE;
+    if (nearest_plane < -radius - slack)
+      CHECK(lod < 0, "teapot %d: outside the frustum by %g but drawn", i,
+            -radius - nearest_plane);
+    if (nearest_plane > -radius + slack)
+      CHECK(lod >= 0, "teapot %d: sphere in the frustum but culled", i);
+
+    if (lod < 0) {
+      ++stats->culled_;
+      // No vertex of a culled teapot may reach the screen
+      for (int32_t v = 0; v < NUM_VERTICES; ++v) {
+        double clip[4];
+        Transform(mat_mvp, Vertex(v), clip);
+        const double w = clip[3] * (1.0 + TOLERANCE);
+        if (fabs(clip[0]) <= w && fabs(clip[1]) <= w && fabs(clip[2]) <= w) {
+          ++stats->vertex_visible_;
+          CHECK(false, "teapot %d: culled, but vertex %d is on screen", i, v);
+          break;
+        }
+      }
+      continue;
+    }
+    CHECK(lod < NUM_LODS, "teapot %d: level %d", i, lod);
+    if (lod >= NUM_LODS) continue;
+    ++stats->lods_[lod];
+    expected_visible[lod].push_back(i);
+
+    // The coarsest level whose error, at the sphere's nearest depth, is
+    // small enough; the full mesh when the camera is in the sphere
+    const double depth = -view_center[2] - radius;
+    int32_t expected = 0;
+    if (depth > 0.0) {
+      for (int32_t l = 1; l < NUM_LODS; ++l) {
+        const double error = teapotLodErrors[l] * scale / depth;
+        if (error <= TEAPOT_LOD_MAX_ERROR * (1.0 - TOLERANCE))
+          expected = l;
+        else if (error <= TEAPOT_LOD_MAX_ERROR * (1.0 + TOLERANCE))
+          expected = std::max(expected, lod == l ? l : 0);
+      }
+      stats->worst_lod_error_ =
+          std::max(stats->worst_lod_error_,
+                   teapotLodErrors[lod] * scale / depth);
+    }
+    CHECK(lod == expected,
+          "teapot %d: level %d at depth %g, expected level %d", i, lod,
+          depth, expected);
+  }
+
+  // Grouped by level, in teapot order, with their records
+  int32_t slot = 0;
+  for (int32_t l = 0; l < TEAPOT_MAX_LODS; ++l) {
+    CHECK(transforms.GetLodFirst(l) == slot &&
+              transforms.GetLodCount(l) == (int32_t)expected_visible[l].size(),
+          "level %d: records [%d, +%d), expected [%d, +%d)", l,
+          transforms.GetLodFirst(l), transforms.GetLodCount(l), slot,
+          (int32_t)expected_visible[l].size());
+    for (size_t i = 0; i < expected_visible[l].size(); ++i, ++slot) {
+      const int32_t teapot = expected_visible[l][i];
+      if (slot >= transforms.GetVisibleCount() ||
+          transforms.GetVisible(slot) != teapot) {
+        CHECK(false, "record %d is not teapot %d", slot, teapot);
+        return;
+      }
+      float record[TEAPOT_INSTANCE_FLOATS];
+      float mv[16];
+      transforms.GetModelViewProjection(teapot, record);
+      transforms.GetModelView(teapot, mv);
+      for (int32_t c = 0; c < 3; ++c)
+        memcpy(&record[16 + c * 3], &mv[c * 4], sizeof(float) * 3);
+      memcpy(&record[25], transforms.GetColor(teapot), sizeof(float) * 3);
+      if (memcmp(record, &instances[slot * TEAPOT_INSTANCE_FLOATS],
+                 sizeof(record))) {
+        CHECK(false, "record %d (teapot %d) differs", slot, teapot);
+        return;
+      }
+    }
+  }
+  CHECK(transforms.GetVisibleCount() == slot, "%d visible, expected %d",
+        transforms.GetVisibleCount(), slot);
+}
+
+bool SameUpdate(const TeapotTransforms& a, const TeapotTransforms& b,
+                const std::vector<float>& instances_a,
+                const std::vector<float>& instances_b) {
+  if (a.GetVisibleCount() != b.GetVisibleCount()) return false;
+  for (int32_t i = 0; i < a.GetCount(); ++i)
+    if (a.GetLod(i) != b.GetLod(i)) return false;
+  for (int32_t l = 0; l < TEAPOT_MAX_LODS; ++l)
+    if (a.GetLodFirst(l) != b.GetLodFirst(l) ||
+        a.GetLodCount(l) != b.GetLodCount(l))
+      return false;
+  for (int32_t i = 0; i < a.GetVisibleCount(); ++i)
+    if (a.GetVisible(i) != b.GetVisible(i)) return false;
+  return !memcmp(&instances_a[0], &instances_b[0],
+                 sizeof(float) * TEAPOT_INSTANCE_FLOATS *
+                     a.GetVisibleCount());
+}
+
+void TestCulling() {
+  printf("Culling and levels of detail, %d scenes\n", NUM_SCENES);
+  JobSystem jobs(3);
+  Stats stats;
+  memset(&stats, 0, sizeof(stats));
+  for (int32_t s = 0; s < NUM_SCENES; ++s) {
+    // Counts off the grain, and an empty scene
+    const int32_t count =
+        s == 0 ? 0 : SCENE_TEAPOTS + (int32_t)(Random() * 200.f);
+    Scene scene;
+    RandomScene(count, &scene);
+    TeapotTransforms serial, parallel;
+    SetScene(scene, &serial);
+    SetScene(scene, &parallel);
+    std::vector<float> instances(
+        std::max(count, 1) * TEAPOT_INSTANCE_FLOATS, -1.f);
+    std::vector<float> parallel_instances = instances;
+
+    const int32_t failures = g_failures;
+    for (int32_t frame = 1; frame <= 3; ++frame) {
+      serial.Update(scene.view_, scene.projection_, NULL, &instances[0]);
+      parallel.Update(scene.view_, scene.projection_, &jobs,
+                      &parallel_instances[0]);
+      CheckUpdate(scene, frame, serial, instances, &stats);
+      CHECK(SameUpdate(serial, parallel, instances, parallel_instances),
+            "scene %d, frame %d: the job threads give another result", s,
+            frame);
+    }
+    if (g_failures != failures) {
+      printf("  in scene %d\n", s);
+      if (g_failures > 20) return;
+    }
+  }
+  printf("  %d teapots: %d culled, %d full, %d level 1, %d level 2\n",
+         stats.teapots_, stats.culled_, stats.lods_[0], stats.lods_[1],
+         stats.lods_[2]);
+  printf("  largest projected error %.5f (limit %.5f)\n",
+         stats.worst_lod_error_, TEAPOT_LOD_MAX_ERROR);
+  CHECK(stats.culled_ > stats.teapots_ / 10 &&
+            stats.culled_ < stats.teapots_ * 9 / 10,
+        "the scenes do not exercise culling");
+  for (int32_t l = 0; l < NUM_LODS; ++l)
+    CHECK(stats.lods_[l] > stats.teapots_ / 100,
+          "the scenes do not exercise level %d", l);
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+// The sample's grid and camera on a 1080 x 1920 portrait viewport. Its
+// narrow projection shows the teapots too large for the coarser levels, so
+// the grid is also seen through a 90 degree one.
+void GridScene(const int32_t n, const bool wide, Scene* scene) {
+  scene->view_ = Mat4::LookAt(Vec3(0.f, 0.f, 2000.f), Vec3(0.f, 0.f, 0.f),
+                              Vec3(0.f, 1.f, 0.f));
+  const float height = wide ? CAM_NEAR * 2.f : 1.f;
+  scene->projection_ = Mat4::Perspective(height * 1080.f / 1920.f, height,
+                                         CAM_NEAR, CAM_FAR);
+  const float gap = GRID_WIDTH / (n - 1);
+  for (int32_t x = 0; x < n; ++x)
+    for (int32_t y = 0; y < n; ++y)
+      for (int32_t z = 0; z < n; ++z) {
+        scene->models_.push_back(Mat4::Translation(
+            x * gap - GRID_WIDTH / 2.f, y * gap - GRID_WIDTH / 2.f,
+            z * gap - GRID_WIDTH / 2.f));
+        scene->angles_x_.push_back(Random() * (float)M_PI / 2.f);
+        scene->angles_y_.push_back(Random() * (float)M_PI / 2.f);
+        scene->speeds_x_.push_back(Random() * 0.025f);
+        scene->speeds_y_.push_back(Random() * 0.025f);
+        for (int32_t c = 0; c < 3; ++c)
+          scene->colors_.push_back((Random() + 1.f) / 2.f);
+      }
+}
+
+double TimeUpdate(const Scene& scene, TeapotTransforms* transforms,
+                  JobSystem* jobs, std::vector<float>* instances) {
+  double best = HUGE_VAL;
+  for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+    const double start = NowNs();
+    transforms->Update(scene.view_, scene.projection_, jobs, &(*instances)[0]);
+    best = std::min(best, NowNs() - start);
+  }
+  return best;
+}
+
+void Benchmark() {
+  printf("Update(), best of %d\n", BENCH_RUNS);
+  JobSystem jobs(ndk_helper::JOB_SYSTEM_DEFAULT_THREADS);
+  for (int32_t g = 0; g < NUM_BENCH_GRIDS * 2; ++g) {
+    const int32_t n = BENCH_GRIDS[g % NUM_BENCH_GRIDS];
+    const bool wide = g >= NUM_BENCH_GRIDS;
+    if (g % NUM_BENCH_GRIDS == 0)
+      printf(" %s projection\n", wide ? "90 degree" : "The sample's");
+    Scene scene;
+    GridScene(n, wide, &scene);
+    TeapotTransforms transforms;
+    SetScene(scene, &transforms);
+    std::vector<float> instances(n * n * n * TEAPOT_INSTANCE_FLOATS);
+    const double serial = TimeUpdate(scene, &transforms, NULL, &instances);
+    const double parallel = TimeUpdate(scene, &transforms, &jobs, &instances);
+
+    int64_t triangles = 0;
+    for (int32_t l = 0; l < NUM_LODS; ++l)
+      triangles +=
+          (int64_t)transforms.GetLodCount(l) * teapotLodIndexCounts[l] / 3;
+    const int64_t full = (int64_t)n * n * n * teapotLodIndexCounts[0] / 3;
+    printf("  %5d teapots: %8.1f us, %8.1f us on the job threads; "
+           "%d visible (%d/%d/%d), %.1f%% of the full triangles\n",
+           n * n * n, serial / 1e3, parallel / 1e3,
+           transforms.GetVisibleCount(), transforms.GetLodCount(0),
+           transforms.GetLodCount(1), transforms.GetLodCount(2),
+           100.0 * triangles / full);
+  }
+
+  printf("SimplifyIndices(), best of %d\n", SIMPLIFY_RUNS);
+  const std::vector<uint16_t> source(teapotIndices,
+                                     teapotIndices + NUM_SOURCE_INDICES);
+  for (int32_t l = 1; l < NUM_LODS; ++l) {
+    const int32_t target = teapotLodIndexCounts[l] / 3;
+    std::vector<uint16_t> out;
+    double best = HUGE_VAL;
+    float error = 0.f;
+    for (int32_t run = 0; run < SIMPLIFY_RUNS; ++run) {
+      const double start = NowNs();
+      error = mesh_optimizer::SimplifyIndices(teapotPositions, NUM_VERTICES,
+                                              source, target, &out);
+      best = std::min(best, NowNs() - start);
+    }
+    printf("  %4d to %4d triangles: %8.1f us, error %.4f\n",
+           NUM_SOURCE_INDICES / 3, (int32_t)out.size() / 3, best / 1e3,
+           error);
+    CHECK((int32_t)out.size() / 3 <= target, "level %d: %d triangles", l,
+          (int32_t)out.size() / 3);
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestMeshData();
+  TestCulling();
+  Benchmark();
+
+  if (g_failures) {
+    printf("FAILED: %d\n", g_failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
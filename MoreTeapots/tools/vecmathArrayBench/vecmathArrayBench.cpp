@@ -0,0 +1,350 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathArrayBench.cpp
+// Host benchmark for the batched operations of ndk_helper (vecmathArray.h),
+// against the same operations done one Mat4 at a time, for 1 to 100000
+// objects: the Mat4Array ones TeapotTransforms runs every frame, and
+// TransformPoints on a Vec4Array.
+//
+// Every batch result is checked first against the Mat4 result: whole
+// arrays, arrays updated in place, and arrays done in ranges as the job
+// threads do. Any difference fails the benchmark, and so does a batch
+// operation slower than Mat4 from VECMATH_ARRAY_MIN_BATCH objects up.
+//
+// Mat4 and batch runs alternate, TIMING_REPEATS times, so that other load on
+// the host hits both sides alike, and each side keeps its best run. Slower
+// means by more than TIMING_NOISE: out of cache, where both sides wait on the
+// same memory traffic, array * array only keeps up with Mat4, and the best
+// runs of the two then differ by a few percent either way. A batch operation
+// found slower is timed again, and fails if it stays slower TIMING_ATTEMPTS
+// times in a row. The SIMD code is held to this; the scalar code
+// (-DVECMATH_NO_SIMD below) is only measured.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  g++ -O2 -ffp-contract=off -I$NDK_HELPER -o vecmathArrayBench
+//  vecmathArrayBench.cpp $NDK_HELPER/vecmathArray.cpp $NDK_HELPER/vecmath.cpp
+//  ./vecmathArrayBench
+// Add -DVECMATH_NO_SIMD to measure the scalar code. -ffp-contract=off keeps
+// the compiler from fusing the scalar Mat4 multiplies and adds, which the
+// batch code never does.
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "vecmath.h"
+#include "vecmathArray.h"
+
+using ndk_helper::Mat4;
+using ndk_helper::Mat4Array;
+using ndk_helper::Vec4;
+using ndk_helper::Vec4Array;
+
+namespace {
+
+const int32_t SIZES[] = {1, 3, 4, 10, 16, 31, 32, 100, 1000, 10000, 100000};
+const int32_t NUM_SIZES = sizeof(SIZES) / sizeof(SIZES[0]);
+// Objects processed per measurement
+const double ELEMENTS_PER_RUN = 5e4;
+const int32_t TIMING_REPEATS = 51;
+const double TIMING_NOISE = 0.05;
+const int32_t TIMING_ATTEMPTS = 3;
+// As TEAPOT_UPDATE_GRAIN
+const int32_t RANGE_GRAIN = 128;
+
+int32_t g_failures = 0;
+
+uint32_t g_seed = 12345;
+
+float Random() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return (g_seed >> 8) * (1.f / 16777216.f) * 2.f - 1.f;
+}
+
+Mat4 RandomMat4() {
+  float f[16];
+  for (int32_t i = 0; i < 16; ++i) f[i] = Random() * 4.f;
+  return Mat4(f);
+}
+
+Vec4 RandomVec4() {
+  return Vec4(Random() * 4.f, Random() * 4.f, Random() * 4.f, Random() * 4.f);
+}
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Matches with ==, so a zero may come out with either sign
+bool Same(const Mat4& a, const Mat4& b) {
+  Mat4 ca = a, cb = b;
+  for (int32_t i = 0; i < 16; ++i)
+    if (!(ca.Ptr()[i] == cb.Ptr()[i])) return false;
+  return true;
+}
+
+bool Same(Vec4 a, Vec4 b) {
+  float fa[4], fb[4];
+  a.Value(fa[0], fa[1], fa[2], fa[3]);
+  b.Value(fb[0], fb[1], fb[2], fb[3]);
+  for (int32_t i = 0; i < 4; ++i)
+    if (!(fa[i] == fb[i])) return false;
+  return true;
+}
+
+template <class ARRAY, class T>
+void Check(const char* what, const int32_t n, const ARRAY& batch,
+           const std::vector<T>& expected) {
+  if (batch.Size() != n) {
+    printf("  %s, %d objects: size %d\n", what, n, batch.Size());
+    ++g_failures;
+    return;
+  }
+  for (int32_t i = 0; i < n; ++i) {
+    if (!Same(batch.Get(i), expected[i])) {
+      printf("  %s, %d objects: object %d differs\n", what, n, i);
+      ++g_failures;
+      return;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Inputs and expected results, one Mat4 at a time
+//--------------------------------------------------------------------------------
+struct Inputs {
+  int32_t n_;
+  Mat4 m_;
+  std::vector<Mat4> a_, b_;
+  std::vector<Vec4> v_;
+  std::vector<float> angle_x_, angle_y_;
+  Mat4Array array_a_, array_b_;
+  Vec4Array array_v_;
+
+  std::vector<Mat4> m_b_, a_m_, a_b_, rotations_;
+  std::vector<Vec4> m_v_;
+
+  explicit Inputs(const int32_t n) : n_(n), m_(RandomMat4()) {
+    array_a_.Resize(n);
+    array_b_.Resize(n);
+    array_v_.Resize(n);
+    for (int32_t i = 0; i < n; ++i) {
+      a_.push_back(RandomMat4());
+      b_.push_back(RandomMat4());
+      v_.push_back(RandomVec4());
+      angle_x_.push_back(Random() * 4.f);
+      angle_y_.push_back(Random() * 4.f);
+      array_a_.Set(i, a_[i]);
+      array_b_.Set(i, b_[i]);
+      array_v_.Set(i, v_[i]);
+    }
+    m_b_.resize(n);
+    a_m_.resize(n);
+    a_b_.resize(n);
+    rotations_.resize(n);
+    m_v_.resize(n);
+    RunMat4();
+  }
+
+  void RunMat4() {
+    for (int32_t i = 0; i < n_; ++i) m_b_[i] = m_ * b_[i];
+    for (int32_t i = 0; i < n_; ++i) a_m_[i] = a_[i] * m_;
+    for (int32_t i = 0; i < n_; ++i) a_b_[i] = a_[i] * b_[i];
+    for (int32_t i = 0; i < n_; ++i)
+      rotations_[i] =
+          Mat4::RotationX(angle_x_[i]) * Mat4::RotationY(angle_y_[i]);
+    for (int32_t i = 0; i < n_; ++i) m_v_[i] = m_ * v_[i];
+  }
+};
+
+//--------------------------------------------------------------------------------
+// Correctness
+//--------------------------------------------------------------------------------
+void TestSize(const int32_t n) {
+  Inputs in(n);
+  Mat4Array out;
+
+  ndk_helper::MultiplyMany(in.m_, in.array_b_, out);
+  Check("Mat4 * Mat4Array", n, out, in.m_b_);
+  ndk_helper::MultiplyMany(in.array_a_, in.m_, out);
+  Check("Mat4Array * Mat4", n, out, in.a_m_);
+  ndk_helper::MultiplyMany(in.array_a_, in.array_b_, out);
+  Check("Mat4Array * Mat4Array", n, out, in.a_b_);
+  ndk_helper::ComposeRotationsXY(&in.angle_x_[0], &in.angle_y_[0], n, out);
+  Check("ComposeRotationsXY", n, out, in.rotations_);
+  Vec4Array points;
+  ndk_helper::TransformPoints(in.m_, in.array_v_, points);
+  Check("TransformPoints", n, points, in.m_v_);
+
+  // In place, out being one of the inputs
+  Mat4Array inplace = in.array_b_;
+  ndk_helper::MultiplyMany(in.m_, inplace, inplace);
+  Check("Mat4 * Mat4Array in place", n, inplace, in.m_b_);
+  inplace = in.array_a_;
+  ndk_helper::MultiplyMany(inplace, in.m_, inplace);
+  Check("Mat4Array * Mat4 in place", n, inplace, in.a_m_);
+  inplace = in.array_a_;
+  ndk_helper::MultiplyMany(inplace, in.array_b_, inplace);
+  Check("Mat4Array * Mat4Array in place (a)", n, inplace, in.a_b_);
+  inplace = in.array_b_;
+  ndk_helper::MultiplyMany(in.array_a_, inplace, inplace);
+  Check("Mat4Array * Mat4Array in place (b)", n, inplace, in.a_b_);
+  points = in.array_v_;
+  ndk_helper::TransformPoints(in.m_, points, points);
+  Check("TransformPoints in place", n, points, in.m_v_);
+
+  // In ranges, the last one shorter, in reverse order so no range can lean
+  // on the one before it
+  Mat4Array ranges[4];
+  for (int32_t r = 0; r < 4; ++r) ranges[r].Resize(n);
+  for (int32_t begin = (n - 1) / RANGE_GRAIN * RANGE_GRAIN; begin >= 0;
+       begin -= RANGE_GRAIN) {
+    const int32_t end = begin + RANGE_GRAIN < n ? begin + RANGE_GRAIN : n;
+    ndk_helper::MultiplyMany(in.m_, in.array_b_, ranges[0], begin, end);
+    ndk_helper::MultiplyMany(in.array_a_, in.m_, ranges[1], begin, end);
+    ndk_helper::MultiplyMany(in.array_a_, in.array_b_, ranges[2], begin, end);
+    ndk_helper::ComposeRotationsXY(&in.angle_x_[0], &in.angle_y_[0],
+                                   ranges[3], begin, end);
+  }
+  Check("Mat4 * Mat4Array in ranges", n, ranges[0], in.m_b_);
+  Check("Mat4Array * Mat4 in ranges", n, ranges[1], in.a_m_);
+  Check("Mat4Array * Mat4Array in ranges", n, ranges[2], in.a_b_);
+  Check("ComposeRotationsXY in ranges", n, ranges[3], in.rotations_);
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+enum OPERATION {
+  OPERATION_MAT4_ARRAY,
+  OPERATION_ARRAY_MAT4,
+  OPERATION_ARRAY_ARRAY,
+  OPERATION_ROTATIONS,
+  OPERATION_TRANSFORM_POINTS,
+  OPERATION_COUNT,
+};
+
+const char* OPERATION_NAMES[OPERATION_COUNT] = {
+    "Mat4 * array", "array * Mat4",  "array * array",
+    "rotations XY", "points",
+};
+
+void RunMat4(Inputs& in, const OPERATION op) {
+  switch (op) {
+    case OPERATION_MAT4_ARRAY:
+      for (int32_t i = 0; i < in.n_; ++i) in.m_b_[i] = in.m_ * in.b_[i];
+      break;
+    case OPERATION_ARRAY_MAT4:
+      for (int32_t i = 0; i < in.n_; ++i) in.a_m_[i] = in.a_[i] * in.m_;
+      break;
+    case OPERATION_ARRAY_ARRAY:
+      for (int32_t i = 0; i < in.n_; ++i) in.a_b_[i] = in.a_[i] * in.b_[i];
+      break;
+    case OPERATION_ROTATIONS:
+      for (int32_t i = 0; i < in.n_; ++i)
+        in.rotations_[i] =
+            Mat4::RotationX(in.angle_x_[i]) * Mat4::RotationY(in.angle_y_[i]);
+      break;
+    default:
+      for (int32_t i = 0; i < in.n_; ++i) in.m_v_[i] = in.m_ * in.v_[i];
+      break;
+  }
+}
+
+void RunBatch(Inputs& in, const OPERATION op, Mat4Array& out,
+              Vec4Array& points) {
+  switch (op) {
+    case OPERATION_MAT4_ARRAY:
+      ndk_helper::MultiplyMany(in.m_, in.array_b_, out);
+      break;
+    case OPERATION_ARRAY_MAT4:
+      ndk_helper::MultiplyMany(in.array_a_, in.m_, out);
+      break;
+    case OPERATION_ARRAY_ARRAY:
+      ndk_helper::MultiplyMany(in.array_a_, in.array_b_, out);
+      break;
+    case OPERATION_ROTATIONS:
+      ndk_helper::ComposeRotationsXY(&in.angle_x_[0], &in.angle_y_[0], in.n_,
+                                     out);
+      break;
+    default:
+      ndk_helper::TransformPoints(in.m_, in.array_v_, points);
+      break;
+  }
+}
+
+// Nanoseconds per object, one Mat4 at a time and batched
+void Time(Inputs& in, const OPERATION op, double* mat4_ns, double* batch_ns) {
+  const int32_t runs =
+      (int32_t)(ELEMENTS_PER_RUN / in.n_) > 0 ? ELEMENTS_PER_RUN / in.n_ : 1;
+  Mat4Array out(in.n_);
+  Vec4Array points(in.n_);
+
+  *mat4_ns = *batch_ns = 1e30;
+  for (int32_t repeat = 0; repeat < TIMING_REPEATS; ++repeat) {
+    double start = NowNs();
+    for (int32_t r = 0; r < runs; ++r) RunMat4(in, op);
+    const double mat4 = (NowNs() - start) / ((double)runs * in.n_);
+
+    start = NowNs();
+    for (int32_t r = 0; r < runs; ++r) RunBatch(in, op, out, points);
+    const double batch = (NowNs() - start) / ((double)runs * in.n_);
+
+    *mat4_ns = std::min(*mat4_ns, mat4);
+    *batch_ns = std::min(*batch_ns, batch);
+  }
+}
+
+}  // namespace
+
+int main() {
+  for (int32_t s = 0; s < NUM_SIZES; ++s) TestSize(SIZES[s]);
+  printf("Batch results %s\n\n", g_failures ? "differ" : "match Mat4");
+
+  printf("ns per object     %8s %10s %10s %8s\n", "count", "Mat4", "batch",
+         "speedup");
+  for (int32_t op = 0; op < OPERATION_COUNT; ++op) {
+    for (int32_t s = 0; s < NUM_SIZES; ++s) {
+      Inputs in(SIZES[s]);
+      const bool used = SIZES[s] >= ndk_helper::VECMATH_ARRAY_MIN_BATCH;
+      double mat4_ns, batch_ns;
+      bool slower = false;
+      for (int32_t attempt = 0; attempt < TIMING_ATTEMPTS; ++attempt) {
+        Time(in, (OPERATION)op, &mat4_ns, &batch_ns);
+        slower = used && batch_ns > mat4_ns * (1.0 + TIMING_NOISE);
+        if (!slower) break;
+      }
+      printf("%-17s %8d %10.2f %10.2f %7.2fx%s\n", OPERATION_NAMES[op],
+             SIZES[s], mat4_ns, batch_ns, mat4_ns / batch_ns,
+             !used ? "  (under MIN_BATCH)" : slower ? "  SLOWER" : "");
+#if defined(VECMATH_USE_NEON) || defined(VECMATH_USE_SSE)
+      if (slower) ++g_failures;
+#endif
+    }
+  }
+
+  printf("\n%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
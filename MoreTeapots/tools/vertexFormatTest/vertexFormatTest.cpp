@@ -0,0 +1,486 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vertexFormatTest.cpp
+// Host test and benchmark of the packed vertex layouts of ndk_helper/
+// vertexFormat.h
+//
+// Every half float must convert to the float it stands for and back. Float
+// to half must round to nearest even, against a rounding done in double,
+// over a sweep of float bit patterns, with the denormal, overflow, signed
+// zero, infinity and NaN cases checked one by one.
+//
+// Each layout must have the size and offsets MoreTeapotsRenderer points its
+// attributes at. The teapot.inl vertices, and random ones, are then packed
+// in each layout and fetched back as GL would with those attributes: ES3
+// normalization for VERTEX_LAYOUT_PACKED, ES2 for the others. Positions
+// must be within the half float bound of vertexFormat.h, or exact as
+// floats, with w = 1; normals within their bound, with w = 0.
+//
+// Last, PackVertices() is timed for each layout, against interleaving the
+// 24 byte float vertices the renderer used to upload.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  NDK_HELPER=$JNI/ndk_helper
+//  g++ -O2 -I$JNI -I$NDK_HELPER -o vertexFormatTest vertexFormatTest.cpp
+//  $NDK_HELPER/vertexFormat.cpp
+//  ./vertexFormatTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "vertexFormat.h"
+
+#include "teapot.inl"
+
+using ndk_helper::VERTEX_LAYOUT;
+namespace vertex = ndk_helper::vertex;
+
+namespace {
+
+const int32_t NUM_TEAPOT_VERTICES =
+    sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
+const int32_t NUM_RANDOM_VERTICES = 100000;
+// Random positions span this many powers of two each way from 1
+const int32_t RANDOM_POSITION_OCTAVES = 12;
+// Float bit patterns between two checked ones
+const uint32_t HALF_SWEEP_STEP = 251;
+const int32_t BENCH_RUNS = 200;
+
+const VERTEX_LAYOUT LAYOUTS[] = {ndk_helper::VERTEX_LAYOUT_PACKED,
+                                 ndk_helper::VERTEX_LAYOUT_HALF_POSITION,
+                                 ndk_helper::VERTEX_LAYOUT_FLOAT_POSITION};
+const char* LAYOUT_NAMES[] = {"packed", "half position", "float position"};
+const int32_t NUM_LAYOUTS = sizeof(LAYOUTS) / sizeof(LAYOUTS[0]);
+
+// Smallest half denormal
+const double HALF_MIN_DENORMAL = 1. / 16777216.;
+// Smallest normal half
+const double HALF_MIN_NORMAL = 1. / 16384.;
+// Float rounding of a normal component scaled to the snorm range and back
+const float NORMAL_ROUNDING = 1e-7f;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+uint32_t g_seed = 0x12345678;
+
+uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// In [-1, 1)
+float RandomUnit() { return (Random() >> 8) * (1.f / 8388608.f) - 1.f; }
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+float BitsFloat(const uint32_t bits) {
+  float v;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+//--------------------------------------------------------------------------------
+// References, in double
+//--------------------------------------------------------------------------------
+// The value of a half, from its fields
+double DecodeHalf(const uint16_t h) {
+  const int32_t exponent = (h >> 10) & 0x1f;
+  const int32_t mantissa = h & 0x3ff;
+  double v;
+  if (exponent == 0x1f)
+    v = mantissa ? NAN : HUGE_VAL;
+  else if (exponent == 0)
+    v = ldexp(mantissa, -24);
+  else
+    v = ldexp(mantissa + 1024, exponent - 25);
+  return (h & 0x8000) ? -v : v;
+}
+
+// |v| rounded to the nearest half, ties to even, with its sign kept
+double RoundToHalf(const double v) {
+  if (isnan(v) || isinf(v)) return v;
+  const double a = fabs(v);
+  int32_t exponent;
+  frexp(a, &exponent);
+  // 11 significant bits, or the denormal step below the normal range
+  const double step =
+      a < HALF_MIN_NORMAL ? HALF_MIN_DENORMAL : ldexp(1., exponent - 11);
+  // nearbyint() rounds ties to even in the default rounding mode
+  double r = nearbyint(a / step) * step;
+  if (r > ndk_helper::VERTEX_HALF_MAX) r = HUGE_VAL;
+  return copysign(r, v);
+}
+
+//--------------------------------------------------------------------------------
+// What the vertex shader sees
+//--------------------------------------------------------------------------------
+float FetchHalf(const uint8_t* p) {
+  uint16_t h;
+  memcpy(&h, p, sizeof(h));
+  return (float)DecodeHalf(h);
+}
+
+float FetchFloat(const uint8_t* p) {
+  float v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// GL_SHORT normalized, as ES2 maps it: (2c + 1) / 65535
+float FetchSnorm16(const uint8_t* p) {
+  int16_t c;
+  memcpy(&c, p, sizeof(c));
+  return (2.f * c + 1.f) / 65535.f;
+}
+
+// GL_INT_2_10_10_10_REV normalized, ES3 rules; w has 2 bits
+void FetchInt2101010(const uint8_t* p, float* n) {
+  uint32_t packed;
+  memcpy(&packed, p, sizeof(packed));
+  for (int32_t c = 0; c < 4; ++c) {
+    const int32_t bits = c < 3 ? 10 : 2;
+    int32_t v = (int32_t)((packed >> (c * 10)) & ((1u << bits) - 1));
+    if (v & (1 << (bits - 1))) v -= 1 << bits;
+    n[c] = std::max(v / (float)((1 << (bits - 1)) - 1), -1.f);
+  }
+}
+
+// Position and normal of |vertex|, as MoreTeapotsRenderer::BindVertices()
+// has GL fetch them
+void FetchVertex(const VERTEX_LAYOUT layout, const std::vector<uint8_t>& data,
+                 const int32_t index, float* position, float* normal) {
+  const uint8_t* v = &data[(size_t)index * vertex::GetStride(layout)];
+  const uint8_t* n = v + vertex::GetNormalOffset(layout);
+  switch (layout) {
+    case ndk_helper::VERTEX_LAYOUT_PACKED:
+      for (int32_t c = 0; c < 4; ++c) position[c] = FetchHalf(v + c * 2);
+      FetchInt2101010(n, normal);
+      break;
+    case ndk_helper::VERTEX_LAYOUT_HALF_POSITION:
+      for (int32_t c = 0; c < 4; ++c) position[c] = FetchHalf(v + c * 2);
+      for (int32_t c = 0; c < 4; ++c) normal[c] = FetchSnorm16(n + c * 2);
+      break;
+    default:
+      for (int32_t c = 0; c < 3; ++c) position[c] = FetchFloat(v + c * 4);
+      position[3] = 1.f;
+      for (int32_t c = 0; c < 4; ++c) normal[c] = FetchSnorm16(n + c * 2);
+      break;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Layouts
+//--------------------------------------------------------------------------------
+void TestLayouts() {
+  printf("Layouts\n");
+  CHECK(vertex::ChooseLayout(true, false) == ndk_helper::VERTEX_LAYOUT_PACKED &&
+            vertex::ChooseLayout(true, true) ==
+                ndk_helper::VERTEX_LAYOUT_PACKED &&
+            vertex::ChooseLayout(false, true) ==
+                ndk_helper::VERTEX_LAYOUT_HALF_POSITION &&
+            vertex::ChooseLayout(false, false) ==
+                ndk_helper::VERTEX_LAYOUT_FLOAT_POSITION,
+        "ChooseLayout() does not pick the smallest layout fetched");
+  const int32_t strides[] = {12, 16, 20};
+  const int32_t normal_offsets[] = {8, 8, 12};
+  for (int32_t l = 0; l < NUM_LAYOUTS; ++l) {
+    const int32_t stride = vertex::GetStride(LAYOUTS[l]);
+    const int32_t offset = vertex::GetNormalOffset(LAYOUTS[l]);
+    CHECK(stride == strides[l] && offset == normal_offsets[l],
+          "%s: stride %d, normal at %d", LAYOUT_NAMES[l], stride, offset);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Half float
+//--------------------------------------------------------------------------------
+void TestHalf() {
+  printf("Half float\n");
+  int32_t wrong_decodes = 0, wrong_round_trips = 0;
+  for (uint32_t h = 0; h < 0x10000; ++h) {
+    const float v = vertex::HalfToFloat((uint16_t)h);
+    const double reference = DecodeHalf((uint16_t)h);
+    const uint16_t back = vertex::FloatToHalf(v);
+    if (isnan(reference)) {
+      wrong_decodes += !isnan(v);
+      wrong_round_trips += !isnan(DecodeHalf(back));
+      continue;
+    }
+    // Compares the sign of zeros too
+    wrong_decodes += v != reference || signbit(v) != signbit(reference);
+    wrong_round_trips += back != h;
+  }
+  CHECK(!wrong_decodes, "%d halves decode wrong", wrong_decodes);
+  CHECK(!wrong_round_trips, "%d halves do not convert back",
+        wrong_round_trips);
+
+  // The sweep visits every exponent, signs included
+  int32_t wrong_roundings = 0;
+  uint32_t first_wrong = 0;
+  for (uint64_t bits = 0; bits <= 0xffffffffu; bits += HALF_SWEEP_STEP) {
+    const float v = BitsFloat((uint32_t)bits);
+    if (isnan(v)) continue;
+    const double reference = RoundToHalf(v);
+    const double half = DecodeHalf(vertex::FloatToHalf(v));
+    if (half != reference || signbit(half) != signbit(reference)) {
+      if (!wrong_roundings) first_wrong = (uint32_t)bits;
+      ++wrong_roundings;
+    }
+  }
+  CHECK(!wrong_roundings, "%d floats round wrong, first 0x%08x",
+        wrong_roundings, first_wrong);
+
+  struct Case {
+    float v;
+    uint16_t half;
+  };
+  const Case cases[] = {
+      {0.f, 0x0000},
+      {-0.f, 0x8000},
+      {1.f, 0x3c00},
+      {-2.f, 0xc000},
+      // Ties between 1 and its neighbours go to the even mantissa
+      {1.f + 1.f / 2048.f, 0x3c00},
+      {1.f + 3.f / 2048.f, 0x3c02},
+      {65504.f, 0x7bff},
+      {65519.f, 0x7bff},
+      // Rounds past VERTEX_HALF_MAX
+      {65520.f, 0x7c00},
+      {-1e6f, 0xfc00},
+      {(float)HALF_MIN_NORMAL, 0x0400},
+      {(float)HALF_MIN_DENORMAL, 0x0001},
+      // Half the smallest denormal ties to zero, more rounds up
+      {(float)HALF_MIN_DENORMAL / 2.f, 0x0000},
+      {(float)HALF_MIN_DENORMAL * 0.75f, 0x0001},
+      {-(float)HALF_MIN_DENORMAL * 1.5f, 0x8002},
+      {1e-10f, 0x0000},
+      {HUGE_VALF, 0x7c00},
+      {-HUGE_VALF, 0xfc00},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    const uint16_t half = vertex::FloatToHalf(cases[i].v);
+    CHECK(half == cases[i].half, "%g: 0x%04x, not 0x%04x", cases[i].v, half,
+          cases[i].half);
+  }
+  const uint16_t nan = vertex::FloatToHalf(NAN);
+  CHECK((nan & 0x7c00) == 0x7c00 && (nan & 0x3ff), "NaN: 0x%04x", nan);
+}
+
+//--------------------------------------------------------------------------------
+// Layouts, decoded
+//--------------------------------------------------------------------------------
+void RandomVertices(const int32_t count, std::vector<float>* positions,
+                    std::vector<float>* normals) {
+  positions->resize(count * 3);
+  normals->resize(count * 3);
+  for (int32_t i = 0; i < count; ++i) {
+    for (int32_t c = 0; c < 3; ++c) {
+      const int32_t octave =
+          (int32_t)(Random() % (2 * RANDOM_POSITION_OCTAVES + 1)) -
+          RANDOM_POSITION_OCTAVES;
+      (*positions)[i * 3 + c] = ldexpf(RandomUnit(), octave);
+    }
+    // Every 16th normal on an axis, where the snorm range ends
+    float n[3], length = 0.f;
+    if (i % 16 == 0) {
+      n[0] = n[1] = n[2] = 0.f;
+      n[i / 16 % 3] = (i / 48) % 2 ? -1.f : 1.f;
+      length = 1.f;
+    } else {
+      do {
+        for (int32_t c = 0; c < 3; ++c) n[c] = RandomUnit();
+        length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      } while (length < 0.1f || length > 1.f);
+    }
+    for (int32_t c = 0; c < 3; ++c) (*normals)[i * 3 + c] = n[c] / length;
+  }
+}
+
+void TestVertices(const char* name, const std::vector<float>& positions,
+                  const std::vector<float>& normals) {
+  const int32_t count = (int32_t)positions.size() / 3;
+  for (int32_t l = 0; l < NUM_LAYOUTS; ++l) {
+    const VERTEX_LAYOUT layout = LAYOUTS[l];
+    const bool half = layout != ndk_helper::VERTEX_LAYOUT_FLOAT_POSITION;
+    const bool es3 = layout == ndk_helper::VERTEX_LAYOUT_PACKED;
+    // One more step where ES2 normalizes snorm16
+    const float normal_bound =
+        (es3 ? ndk_helper::VERTEX_NORMAL10_ERROR
+             : ndk_helper::VERTEX_NORMAL16_ERROR + 1.f / 32767.f) +
+        NORMAL_ROUNDING;
+
+    std::vector<uint8_t> data;
+    vertex::PackVertices(layout, &positions[0], &normals[0], count, &data);
+    CHECK(data.size() == (size_t)count * vertex::GetStride(layout),
+          "%s, %s: %d bytes for %d vertices", name, LAYOUT_NAMES[l],
+          (int32_t)data.size(), count);
+    if (data.size() != (size_t)count * vertex::GetStride(layout)) continue;
+
+    float worst_position = 0.f, worst_normal = 0.f;
+    int32_t bad_positions = 0, bad_normals = 0, bad_w = 0;
+    for (int32_t i = 0; i < count; ++i) {
+      float position[4], normal[4];
+      FetchVertex(layout, data, i, position, normal);
+      for (int32_t c = 0; c < 3; ++c) {
+        const float p = positions[i * 3 + c];
+        const float error = fabsf(position[c] - p);
+        // Relative above the denormals, half the smallest one below
+        const float bound =
+            half ? std::max(fabsf(p) * ndk_helper::VERTEX_HALF_RELATIVE_ERROR,
+                            (float)HALF_MIN_DENORMAL / 2.f)
+                 : 0.f;
+        bad_positions += !(error <= bound);
+        if (half && fabsf(p) >= HALF_MIN_NORMAL)
+          worst_position = std::max(worst_position, error / fabsf(p));
+
+        const float normal_error = fabsf(normal[c] - normals[i * 3 + c]);
+        bad_normals += !(normal_error <= normal_bound);
+        worst_normal = std::max(worst_normal, normal_error);
+      }
+      // ES2 normalization has no exact 0: the snorm16 w is 0 before it
+      bad_w += position[3] != 1.f ||
+               fabsf(normal[3]) > (es3 ? 0.f : 1.f / 65535.f);
+    }
+    CHECK(!bad_positions, "%s, %s: %d position components out of bounds",
+          name, LAYOUT_NAMES[l], bad_positions);
+    CHECK(!bad_normals, "%s, %s: %d normal components out of %g", name,
+          LAYOUT_NAMES[l], bad_normals, normal_bound);
+    CHECK(!bad_w, "%s, %s: %d vertices with a wrong w", name,
+          LAYOUT_NAMES[l], bad_w);
+    printf(" %-14s %d bytes: position %g relative (bound %g), normal %g "
+           "(bound %g)\n",
+           LAYOUT_NAMES[l], vertex::GetStride(layout), worst_position,
+           half ? ndk_helper::VERTEX_HALF_RELATIVE_ERROR : 0.f, worst_normal,
+           normal_bound);
+  }
+}
+
+void TestPackVertices() {
+  printf("PackVertices(), teapot.inl\n");
+  const std::vector<float> positions(
+      teapotPositions, teapotPositions + NUM_TEAPOT_VERTICES * 3);
+  const std::vector<float> normals(teapotNormals,
+                                   teapotNormals + NUM_TEAPOT_VERTICES * 3);
+  TestVertices("teapot.inl", positions, normals);
+
+  printf("PackVertices(), %d random vertices\n", NUM_RANDOM_VERTICES);
+  std::vector<float> random_positions, random_normals;
+  RandomVertices(NUM_RANDOM_VERTICES, &random_positions, &random_normals);
+  TestVertices("random", random_positions, random_normals);
+
+  // Normals off the unit sphere clamp to the snorm range
+  const float position[3] = {0.f, 0.f, 0.f};
+  const float normal[3] = {2.f, -3.f, 0.5f};
+  for (int32_t l = 0; l < NUM_LAYOUTS; ++l) {
+    std::vector<uint8_t> data;
+    vertex::PackVertices(LAYOUTS[l], position, normal, 1, &data);
+    float p[4], n[4];
+    FetchVertex(LAYOUTS[l], data, 0, p, n);
+    CHECK(n[0] >= 0.999f && n[0] <= 1.f && n[1] >= -1.f && n[1] <= -0.999f &&
+              fabsf(n[2] - 0.5f) <= 0.002f,
+          "%s: (2, -3, 0.5) packs to (%g, %g, %g)", LAYOUT_NAMES[l], n[0], n[1],
+          n[2]);
+  }
+  std::vector<uint8_t> data(1, 0xff);
+  vertex::PackVertices(LAYOUTS[0], position, normal, 0, &data);
+  CHECK(data.empty(), "no vertices packed to %d bytes", (int32_t)data.size());
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+// What MoreTeapotsRenderer::LoadBuffers() did before the packed layouts
+struct TEAPOT_VERTEX {
+  float pos[3];
+  float normal[3];
+};
+
+void InterleaveFloat(const float* positions, const float* normals,
+                     const int32_t count, std::vector<uint8_t>* out) {
+  out->resize(count * sizeof(TEAPOT_VERTEX));
+  TEAPOT_VERTEX* v = reinterpret_cast<TEAPOT_VERTEX*>(&(*out)[0]);
+  for (int32_t i = 0; i < count; ++i) {
+    memcpy(v[i].pos, &positions[i * 3], sizeof(v[i].pos));
+    memcpy(v[i].normal, &normals[i * 3], sizeof(v[i].normal));
+  }
+}
+
+void Benchmark() {
+  printf("Benchmark, best of %d\n", BENCH_RUNS);
+  std::vector<float> positions, normals;
+  RandomVertices(NUM_RANDOM_VERTICES, &positions, &normals);
+  const float* sources[2][2] = {{teapotPositions, teapotNormals},
+                                {&positions[0], &normals[0]}};
+  const int32_t counts[2] = {NUM_TEAPOT_VERTICES, NUM_RANDOM_VERTICES};
+  const char* names[2] = {"teapot.inl", "random"};
+
+  for (int32_t s = 0; s < 2; ++s) {
+    printf(" %s, %d vertices\n", names[s], counts[s]);
+    std::vector<uint8_t> out;
+    for (int32_t l = 0; l <= NUM_LAYOUTS; ++l) {
+      double best = HUGE_VAL;
+      for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+        const double start = NowNs();
+        if (l < NUM_LAYOUTS)
+          vertex::PackVertices(LAYOUTS[l], sources[s][0], sources[s][1],
+                               counts[s], &out);
+        else
+          InterleaveFloat(sources[s][0], sources[s][1], counts[s], &out);
+        best = std::min(best, NowNs() - start);
+      }
+      printf("  %-14s %7d bytes: %8.1fus, %.2fns a vertex\n",
+             l < NUM_LAYOUTS ? LAYOUT_NAMES[l] : "float, before",
+             (int32_t)out.size(), best / 1e3, best / counts[s]);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestLayouts();
+  TestHalf();
+  TestPackVertices();
+  Benchmark();
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -23,90 +23,24 @@
 //--------------------------------------------------------------------------------
 #include "TeapotRenderer.h"
 
-//--------------------------------------------------------------------------------
-// Teapot model data
-//--------------------------------------------------------------------------------
-#include "teapot.inl"
 #include "ndk_helper/vecmath.h"
 
 //--------------------------------------------------------------------------------
 // Ctor
 //--------------------------------------------------------------------------------
-TeapotRenderer::TeapotRenderer() {}
+TeapotRenderer::TeapotRenderer() : ibo_(0), vbo_(0), ready_(false) {
+  shader_param_.program_ = 0;
+}
 
 //--------------------------------------------------------------------------------
 // Dtor
 //--------------------------------------------------------------------------------
 TeapotRenderer::~TeapotRenderer() { Unload(); }
 
-void TeapotRenderer::Init() {
+void TeapotRenderer::Init(ndk_helper::ResourceLoader* loader) {
   // Settings
   glFrontFace(GL_CCW);
 
-  // Load shader
-  LoadShaders(&shader_param_, "Shaders/VS_ShaderPlain.vsh",
-              "Shaders/ShaderPlain.fsh");
-
-  // Create Index buffer
-  num_indices_ = sizeof(teapotIndices) / sizeof(teapotIndices[0]);
-  glGenBuffers(1, &ibo_);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(teapotIndices), teapotIndices,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  // Create VBO
-  num_vertices_ = sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
-  int32_t stride = sizeof(TEAPOT_VERTEX);
-  int32_t index = 0;
-  TEAPOT_VERTEX* p = new TEAPOT_VERTEX[num_vertices_];
-
-    float xMax = 0 ; float xMin = 0 ;
-    float yMax = 0 ; float yMin = 0 ;
-    float zMax = 0 ; float zMin = 0 ;
-  for (int32_t i = 0; i < num_vertices_; ++i) {
-
-      p[i].pos[0] = teapotPositions[index];
-      if( teapotPositions[index] >  xMax   ){
-          xMax = teapotPositions[index];
-      }
-      if( teapotPositions[index] < xMin   ){
-          xMin = teapotPositions[index];
-      }
-
-      p[i].pos[1] = teapotPositions[index + 1];
-      if( teapotPositions[index + 1] > yMax ){
-          yMax = teapotPositions[index + 1];
-      }
-      if( teapotPositions[index + 1 ] < yMin   ){
-          yMin = teapotPositions[index + 1];
-      }
-
-      p[i].pos[2] = teapotPositions[index + 2];
-      if( teapotPositions[index + 2] > zMax){
-          zMax = teapotPositions[index + 2];
-      }
-      if( teapotPositions[index + 2 ] < zMin   ){
-          zMin = teapotPositions[index + 2];
-      }
-
-    p[i].normal[0] = teapotNormals[index];
-    p[i].normal[1] = teapotNormals[index + 1];
-    p[i].normal[2] = teapotNormals[index + 2];
-    index += 3;
-  }
-
-    LOGI("xMax = %f yMax = %f zMax = %f\n" , xMax , yMax , zMax );
-    LOGI("xMin = %f yMin = %f zMin = %f\n" , xMin , yMin , zMin );
-    // xMax = 43.671501 yMax = 25.478399 zMax = 40.128399
-
-  glGenBuffers(1, &vbo_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-  glBufferData(GL_ARRAY_BUFFER, stride * num_vertices_, p, GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  delete[] p;
-
   UpdateViewport();
   mat_model_ = ndk_helper::Mat4::Translation(0, 0, -15.f);
 
@@ -125,6 +59,68 @@ void TeapotRenderer::Init() {
 
   mat_model_ = mat * mat_model_;
 //    mat_model_ =    mat_model_ * mat ;
+
+  // The program and the mesh are made on the loader thread; Render() draws
+  // nothing until they are committed
+  ready_ = false;
+  loader->Submit(LoadResources, CommitResources, this);
+}
+
+//--------------------------------------------------------------------------------
+// Loader thread
+//--------------------------------------------------------------------------------
+bool TeapotRenderer::LoadResources(void* data) {
+  TeapotRenderer* renderer = static_cast<TeapotRenderer*>(data);
+  return renderer->LoadShaders(&renderer->shader_param_,
+                               "Shaders/VS_ShaderPlain.vsh",
+                               "Shaders/ShaderPlain.fsh") &&
+         renderer->LoadMesh();
+}
+
+void TeapotRenderer::CommitResources(void* data, const bool succeeded) {
+  // Buffers and the program are all shared, there is no state to bind here
+  static_cast<TeapotRenderer*>(data)->ready_ = succeeded;
+}
+
+bool TeapotRenderer::LoadMesh() {
+  // Load the mesh, written offline by tools/meshTool: vertices are already
+  // interleaved and packed, so they are uploaded straight from the file
+  ndk_helper::AssetView view =
+      ndk_helper::AssetCache::GetInstance()->Open("Models/Teapot.mesh");
+  ndk_helper::MeshData mesh;
+  if (!view.IsValid() || !mesh.Parse(view.Data(), view.Size())) {
+    LOGE("Failed to load Models/Teapot.mesh");
+    num_indices_ = 0;
+    return false;
+  }
+
+  // Create Index buffer
+  num_indices_ = mesh.GetNumIndices();
+  glGenBuffers(1, &ibo_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.GetIndexDataSize(),
+               mesh.GetIndexData(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // Create VBO
+  num_vertices_ = mesh.GetNumVertices();
+  vertex_stride_ = mesh.GetVertexStride();
+  quantized_ = mesh.IsQuantized();
+  mesh.GetPositionScale(position_scale_);
+  mesh.GetPositionBias(position_bias_);
+  glGenBuffers(1, &vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, mesh.GetVertexDataSize(), mesh.GetVertexData(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  const float* aabb_min = mesh.GetAabbMin();
+  const float* aabb_max = mesh.GetAabbMax();
+  LOGI("xMax = %f yMax = %f zMax = %f\n", aabb_max[0], aabb_max[1],
+       aabb_max[2]);
+  LOGI("xMin = %f yMin = %f zMin = %f\n", aabb_min[0], aabb_min[1],
+       aabb_min[2]);
+  return true;
 }
 
 void TeapotRenderer::UpdateViewport() {
@@ -152,6 +148,7 @@ void TeapotRenderer::UpdateViewport() {
 }
 
 void TeapotRenderer::Unload() {
+  ready_ = false;
   if (vbo_) {
     glDeleteBuffers(1, &vbo_);
     vbo_ = 0;
@@ -168,7 +165,7 @@ void TeapotRenderer::Unload() {
   }
 }
 
-void TeapotRenderer::Update(float fTime) {
+void TeapotRenderer::Update(double fTime) {
   const float CAM_X = 0.f;
   const float CAM_Y = 0.f;
   const float CAM_Z = 700.f;
@@ -178,7 +175,7 @@ void TeapotRenderer::Update(float fTime) {
                                        ndk_helper::Vec3(0.f, 1.f, 0.f));
 
   if (camera_) {   // 每次都调用
-    camera_->Update();
+    camera_->Update(fTime);
     mat_view_ = camera_->GetTransformMatrix() * mat_view_ *
                 camera_->GetRotationMatrix() * mat_model_;
   } else {
@@ -187,6 +184,8 @@ void TeapotRenderer::Update(float fTime) {
 }
 
 void TeapotRenderer::Render() {
+  if (!ready_) return;
+
   //
   // Feed Projection and Model View matrices to the shaders
   ndk_helper::Mat4 mat_vp = mat_projection_ * mat_view_; // P * M * V
@@ -194,14 +193,21 @@ void TeapotRenderer::Render() {
   // Bind the VBO
   glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 
-  int32_t iStride = sizeof(TEAPOT_VERTEX);
   // Pass the vertex data
-  glVertexAttribPointer(ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE, iStride,
-                        BUFFER_OFFSET(0));
+  if (quantized_) {
+    glVertexAttribPointer(ATTRIB_VERTEX, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                          vertex_stride_, BUFFER_OFFSET(0));
+    glVertexAttribPointer(
+        ATTRIB_NORMAL, 2, GL_SHORT, GL_TRUE, vertex_stride_,
+        BUFFER_OFFSET(offsetof(ndk_helper::MeshVertexQuantized, normal_)));
+  } else {
+    glVertexAttribPointer(ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE, vertex_stride_,
+                          BUFFER_OFFSET(0));
+    glVertexAttribPointer(
+        ATTRIB_NORMAL, 2, GL_SHORT, GL_TRUE, vertex_stride_,
+        BUFFER_OFFSET(offsetof(ndk_helper::MeshVertexFloat, normal_)));
+  }
   glEnableVertexAttribArray(ATTRIB_VERTEX);
-
-  glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, iStride,
-                        BUFFER_OFFSET(3 * sizeof(GLfloat)));
   glEnableVertexAttribArray(ATTRIB_NORMAL);
 
   // Bind the IB
@@ -228,7 +234,14 @@ void TeapotRenderer::Render() {
   glUniformMatrix4fv(shader_param_.matrix_projection_, 1, GL_FALSE,
                      mat_vp.Ptr());
   glUniformMatrix4fv(shader_param_.matrix_view_, 1, GL_FALSE, mat_view_.Ptr());
+  // Normals need the inverse transpose; compute it once here rather than
+  // per vertex
+  ndk_helper::Mat3 mat_normal = mat_view_.NormalMatrix();
+  glUniformMatrix3fv(shader_param_.matrix_normal_, 1, GL_FALSE,
+                     mat_normal.Ptr());
   glUniform3f(shader_param_.light0_, 100.f, -200.f, -600.f);
+  glUniform3fv(shader_param_.position_scale_, 1, position_scale_);
+  glUniform3fv(shader_param_.position_bias_, 1, position_bias_);
 
   glDrawElements(GL_TRIANGLES, num_indices_, GL_UNSIGNED_SHORT,
                  BUFFER_OFFSET(0));
@@ -240,58 +253,22 @@ void TeapotRenderer::Render() {
 bool TeapotRenderer::LoadShaders(SHADER_PARAMS* params, const char* strVsh,
                                  const char* strFsh) {
   GLuint program;
-  GLuint vert_shader, frag_shader;
-
-  // Create shader program
-  program = glCreateProgram();
-  LOGI("Created Shader %d", program);
-
-  // Create and compile vertex shader
-  if (!ndk_helper::shader::CompileShader(&vert_shader, GL_VERTEX_SHADER,
-                                         strVsh)) {
-    LOGI("Failed to compile vertex shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Create and compile fragment shader
-  if (!ndk_helper::shader::CompileShader(&frag_shader, GL_FRAGMENT_SHADER,
-                                         strFsh)) {
-    LOGI("Failed to compile fragment shader");
-    glDeleteProgram(program);
-    return false;
-  }
-
-  // Attach vertex shader to program
-  glAttachShader(program, vert_shader);
-
-  // Attach fragment shader to program
-  glAttachShader(program, frag_shader);
 
   // Bind attribute locations
   // this needs to be done prior to linking
-  glBindAttribLocation(program, ATTRIB_VERTEX, "myVertex");
-  glBindAttribLocation(program, ATTRIB_NORMAL, "myNormal");
-  glBindAttribLocation(program, ATTRIB_UV, "myUV");
-
-  // Link program
-  if (!ndk_helper::shader::LinkProgram(program)) {
-    LOGI("Failed to link program: %d", program);
-
-    if (vert_shader) {
-      glDeleteShader(vert_shader);
-      vert_shader = 0;
-    }
-    if (frag_shader) {
-      glDeleteShader(frag_shader);
-      frag_shader = 0;
-    }
-    if (program) {
-      glDeleteProgram(program);
-    }
-
+  std::map<std::string, GLuint> attributes;
+  attributes["myVertex"] = ATTRIB_VERTEX;
+  attributes["myNormal"] = ATTRIB_NORMAL;
+  attributes["myUV"] = ATTRIB_UV;
+
+  // Compile and link, or load the program from the binary cache
+  if (!ndk_helper::shader::CreateProgram(&program, strVsh, strFsh,
+                                         std::map<std::string, std::string>(),
+                                         attributes)) {
+    LOGI("Failed to create program");
     return false;
   }
+  LOGI("Created Shader %d", program);
 
   // Get uniform locations
   params->matrix_projection_ = glGetUniformLocation(program, "uPMatrix");
@@ -300,16 +277,17 @@ bool TeapotRenderer::LoadShaders(SHADER_PARAMS* params, const char* strVsh,
   params->matrix_view_ = glGetUniformLocation(program, "uMVMatrix");
     // 改变颜色 光照
 
+  params->matrix_normal_ = glGetUniformLocation(program, "uNormalMatrix");
+
+  params->position_scale_ = glGetUniformLocation(program, "uPositionScale");
+  params->position_bias_ = glGetUniformLocation(program, "uPositionBias");
+
   params->light0_ = glGetUniformLocation(program, "vLight0");
   params->material_diffuse_ = glGetUniformLocation(program, "vMaterialDiffuse");
   params->material_ambient_ = glGetUniformLocation(program, "vMaterialAmbient");
   params->material_specular_ =
       glGetUniformLocation(program, "vMaterialSpecular");
 
-  // Release vertex and fragment shaders
-  if (vert_shader) glDeleteShader(vert_shader);
-  if (frag_shader) glDeleteShader(frag_shader);
-
   params->program_ = program;
   return true;
 }
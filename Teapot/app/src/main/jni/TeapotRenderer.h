@@ -45,11 +45,6 @@
 
 #define BUFFER_OFFSET(i) ((char*)NULL + (i))
 
-struct TEAPOT_VERTEX {
-  float pos[3];
-  float normal[3];
-};
-
 enum SHADER_ATTRIBUTES {
   ATTRIB_VERTEX,
   ATTRIB_NORMAL,
@@ -65,6 +60,9 @@ struct SHADER_PARAMS {
 
   GLuint matrix_projection_;
   GLuint matrix_view_;
+  GLuint matrix_normal_;
+  GLuint position_scale_;
+  GLuint position_bias_;
 };
 
 struct TEAPOT_MATERIALS {
@@ -79,9 +77,21 @@ class TeapotRenderer {
   GLuint ibo_;
   GLuint vbo_;
 
+  // Vertex layout of Models/Teapot.mesh, see ndk_helper/mesh.h
+  int32_t vertex_stride_;
+  bool quantized_;
+  float position_scale_[3];
+  float position_bias_[3];
+
   SHADER_PARAMS shader_param_;
   bool LoadShaders(SHADER_PARAMS* params, const char* strVsh,
                    const char* strFsh);
+  bool LoadMesh();
+
+  // Set once the loader has committed the program and the buffers
+  bool ready_;
+  static bool LoadResources(void* data);
+  static void CommitResources(void* data, const bool succeeded);
 
   ndk_helper::Mat4 mat_projection_;
   ndk_helper::Mat4 mat_view_;
@@ -92,9 +102,11 @@ class TeapotRenderer {
  public:
   TeapotRenderer();
   virtual ~TeapotRenderer();
-  void Init();
+  // Queues the program and the mesh on |loader|
+  void Init(ndk_helper::ResourceLoader* loader);
   void Render();
-  void Update(float dTime);
+  // dTime: predicted display time of the frame, PerfMonitor clock
+  void Update(double dTime);
   bool Bind(ndk_helper::TapCamera* camera);
   void Unload();
   void UpdateViewport();
@@ -28,6 +28,8 @@
 
 namespace ndk_helper {
 
+class LoaderBackend;
+
 //--------------------------------------------------------------------------------
 // Constants
 //--------------------------------------------------------------------------------
@@ -62,6 +64,12 @@ class GLContext {
   // Screen parameters
   int32_t screen_width_ {0};
   int32_t screen_height_ {0};
+  // Size of the surface frames are rendered to, see SetRenderScale()
+  int32_t render_width_ {0};
+  int32_t render_height_ {0};
+  float render_scale_ {1.f};
+  // The surface takes a new render size at the next Swap()
+  bool render_size_pending_ {false};
   int32_t color_size_;
   int32_t depth_size_;
 
@@ -75,6 +83,7 @@ class GLContext {
   void InitGLES();
   void Terminate();
   bool InitEGLSurface();
+  bool CreateSurface();
   bool InitEGLContext();
 
   GLContext(GLContext const&);
@@ -97,13 +106,35 @@ class GLContext {
   void Suspend();
   EGLint Resume(ANativeWindow* window);
 
+  // Window size; touch coordinates are in this space
   int32_t GetScreenWidth() { return screen_width_; }
   int32_t GetScreenHeight() { return screen_height_; }
+  // Size frames are rendered at, use it for the viewport
+  int32_t GetRenderWidth() { return render_width_; }
+  int32_t GetRenderHeight() { return render_height_; }
+
+  /*
+   * Render at |scale| times the window size, the compositor scales the
+   * buffers up to the window. The surface keeps the frame being drawn at the
+   * old size and takes the new one with the next Swap(): set the viewport
+   * again once GetRenderWidth() and GetRenderHeight() change. On failure the
+   * scale stays as it was. The scale is kept across Suspend() and Resume().
+   */
+  bool SetRenderScale(const float scale);
+  float GetRenderScale() const { return render_scale_; }
 
   int32_t GetBufferColorSize() { return color_size_; }
   int32_t GetBufferDepthSize() { return depth_size_; }
   float GetGLVersion() { return gl_version_; }
   bool CheckExtension(const char* extension);
+
+  /*
+   * Context for a ResourceLoader thread: it shares objects with this one and
+   * is current on a 1x1 pbuffer. Call it after Init(), on the GL thread.
+   *
+   * return: a new EGLLoaderBackend, NULL if no shared context can be made
+   */
+  LoaderBackend* CreateLoaderBackend();
 };
 
 }  // namespace ndkHelper
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// assetCache.cpp
+//--------------------------------------------------------------------------------
+#include "assetCache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#if defined(__ANDROID__)
+#include <android/asset_manager.h>
+#endif
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// AssetEntry
+// One opened file. The cache holds one reference while the entry is in its
+// map, every AssetView one more.
+//--------------------------------------------------------------------------------
+struct AssetEntry {
+  std::atomic<int32_t> ref_count;
+  const uint8_t* data;
+  size_t size;
+  void* map_base;  // mmap'ed range holding data, or NULL
+  size_t map_size;
+#if defined(__ANDROID__)
+  AAsset* asset;  // owns data for compressed assets, or NULL
+#endif
+
+  AssetEntry()
+      : ref_count(1), data(NULL), size(0), map_base(NULL), map_size(0) {
+#if defined(__ANDROID__)
+    asset = NULL;
+#endif
+  }
+
+  ~AssetEntry() {
+    if (map_base) munmap(map_base, map_size);
+#if defined(__ANDROID__)
+    if (asset) AAsset_close(asset);
+#endif
+  }
+
+  // Map |length| bytes of |fd| from |offset|, which need not be page aligned
+  bool Map(const int fd, const off_t offset, const size_t length) {
+    static const uint8_t EMPTY = 0;
+    if (length == 0) {
+      data = &EMPTY;
+      size = 0;
+      return true;
+    }
+    const off_t page_mask = (off_t)sysconf(_SC_PAGESIZE) - 1;
+    const off_t aligned = offset & ~page_mask;
+    const size_t delta = (size_t)(offset - aligned);
+    void* base =
+        mmap(NULL, length + delta, PROT_READ, MAP_PRIVATE, fd, aligned);
+    if (base == MAP_FAILED) return false;
+    map_base = base;
+    map_size = length + delta;
+    data = (const uint8_t*)base + delta;
+    size = length;
+    return true;
+  }
+};
+
+namespace {
+
+void AddRef(AssetEntry* entry) {
+  if (entry) entry->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Release(AssetEntry* entry) {
+  if (entry && entry->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete entry;
+}
+
+}  // namespace
+
+//--------------------------------------------------------------------------------
+// AssetView
+//--------------------------------------------------------------------------------
+AssetView::AssetView(AssetEntry* entry) : entry_(entry) {}
+
+AssetView::AssetView(const AssetView& rhs) : entry_(rhs.entry_) {
+  AddRef(entry_);
+}
+
+AssetView& AssetView::operator=(const AssetView& rhs) {
+  AddRef(rhs.entry_);
+  Release(entry_);
+  entry_ = rhs.entry_;
+  return *this;
+}
+
+AssetView::~AssetView() { Release(entry_); }
+
+const uint8_t* AssetView::Data() const { return entry_ ? entry_->data : NULL; }
+
+size_t AssetView::Size() const { return entry_ ? entry_->size : 0; }
+
+//--------------------------------------------------------------------------------
+// AssetCache
+//--------------------------------------------------------------------------------
+AssetCache::AssetCache() : asset_manager_(NULL) {
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+AssetCache::~AssetCache() {
+  std::map<std::string, AssetEntry*>::iterator it = entries_.begin();
+  for (; it != entries_.end(); ++it) Release(it->second);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void AssetCache::Init(AAssetManager* asset_manager, const char* files_dir) {
+  pthread_mutex_lock(&mutex_);
+  asset_manager_ = asset_manager;
+  files_dir_ = files_dir ? files_dir : "";
+
+  // Entries may come from a previous activity's asset manager. Views still
+  // using them keep them alive.
+  std::map<std::string, AssetEntry*>::iterator it = entries_.begin();
+  for (; it != entries_.end(); ++it) Release(it->second);
+  entries_.clear();
+  pthread_mutex_unlock(&mutex_);
+}
+
+AssetView AssetCache::Open(const char* file_name) {
+  std::string name(file_name);
+
+  pthread_mutex_lock(&mutex_);
+  std::map<std::string, AssetEntry*>::iterator it = entries_.find(name);
+  if (it != entries_.end()) {
+    AssetEntry* entry = it->second;
+    AddRef(entry);
+    pthread_mutex_unlock(&mutex_);
+    return AssetView(entry);
+  }
+  AAssetManager* asset_manager = asset_manager_;
+  std::string files_dir = files_dir_;
+  pthread_mutex_unlock(&mutex_);
+
+  // Map the file without holding the lock
+  AssetEntry* entry = Load(name, asset_manager, files_dir);
+  if (entry == NULL) return AssetView();
+
+  pthread_mutex_lock(&mutex_);
+  it = entries_.find(name);
+  if (it != entries_.end()) {
+    // Another thread opened it meanwhile
+    Release(entry);
+    entry = it->second;
+  } else {
+    entries_[name] = entry;
+  }
+  AddRef(entry);
+  pthread_mutex_unlock(&mutex_);
+  return AssetView(entry);
+}
+
+void AssetCache::Trim() {
+  pthread_mutex_lock(&mutex_);
+  // A count of 1 is the cache's own reference. Views can only be copied from
+  // other views, so nobody can take a new one without the lock.
+  std::map<std::string, AssetEntry*>::iterator it = entries_.begin();
+  while (it != entries_.end()) {
+    if (it->second->ref_count.load(std::memory_order_acquire) == 1) {
+      Release(it->second);
+      entries_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+AssetEntry* AssetCache::Load(const std::string& file_name,
+                             AAssetManager* asset_manager,
+                             const std::string& files_dir) {
+  // Loose file in the files dir
+  if (files_dir.size()) {
+    std::string path(files_dir);
+    if (file_name[0] != '/') path.append("/");
+    path.append(file_name);
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      struct stat st;
+      AssetEntry* entry = new AssetEntry();
+      bool ok = fstat(fd, &st) == 0 && entry->Map(fd, 0, (size_t)st.st_size);
+      close(fd);
+      if (ok) return entry;
+      delete entry;
+    }
+  }
+
+#if defined(__ANDROID__)
+  // APK asset
+  if (asset_manager == NULL) return NULL;
+  AAsset* asset =
+      AAssetManager_open(asset_manager, file_name.c_str(), AASSET_MODE_BUFFER);
+  if (asset == NULL) return NULL;
+
+  AssetEntry* entry = new AssetEntry();
+
+  // Uncompressed (stored) assets can be mapped straight from the APK
+  off_t start, length;
+  int fd = AAsset_openFileDescriptor(asset, &start, &length);
+  if (fd >= 0) {
+    bool ok = entry->Map(fd, start, (size_t)length);
+    close(fd);
+    if (ok) {
+      AAsset_close(asset);
+      return entry;
+    }
+  }
+
+  // Compressed: the asset manager inflates it once, the entry keeps the asset
+  const void* buffer = AAsset_getBuffer(asset);
+  if (buffer == NULL) {
+    AAsset_close(asset);
+    delete entry;
+    return NULL;
+  }
+  entry->asset = asset;
+  entry->data = (const uint8_t*)buffer;
+  entry->size = (size_t)AAsset_getLength(asset);
+  return entry;
+#else
+  (void)asset_manager;
+  return NULL;
+#endif
+}
+
+}  // namespace ndkHelper
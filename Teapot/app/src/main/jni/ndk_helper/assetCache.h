@@ -0,0 +1,116 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ASSET_CACHE_H_
+#define ASSET_CACHE_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+struct AAssetManager;
+
+namespace ndk_helper {
+
+struct AssetEntry;
+
+/******************************************************************
+ * Read only view of a file's contents
+ * Copies share the same memory, which stays valid until the last copy is
+ * destroyed and AssetCache::Trim() has run. Copying and destroying views is
+ * lock free.
+ */
+class AssetView {
+ private:
+  AssetEntry* entry_;
+
+  explicit AssetView(AssetEntry* entry);
+  friend class AssetCache;
+
+ public:
+  AssetView() : entry_(NULL) {}
+  AssetView(const AssetView& rhs);
+  AssetView& operator=(const AssetView& rhs);
+  ~AssetView();
+
+  bool IsValid() const { return entry_ != NULL; }
+  const uint8_t* Data() const;
+  size_t Size() const;
+};
+
+/******************************************************************
+ * Zero copy access to files and APK assets
+ * Open() looks the file up first in the files directory (loose files, e.g.
+ * pushed with adb for quick iteration), then in the APK. Loose files and
+ * uncompressed assets are mmap'ed, compressed assets are inflated once by the
+ * asset manager. Nothing goes through JNI, and opened files are kept in a
+ * reference counted cache so opening them again is a lookup.
+ *
+ * Thread safe. Only the cache lookup in Open() and Trim() take a lock.
+ */
+class AssetCache {
+ private:
+  AAssetManager* asset_manager_;
+  std::string files_dir_;
+  std::map<std::string, AssetEntry*> entries_;
+  pthread_mutex_t mutex_;
+
+  static AssetEntry* Load(const std::string& file_name,
+                          AAssetManager* asset_manager,
+                          const std::string& files_dir);
+
+  AssetCache(AssetCache const&);
+  void operator=(AssetCache const&);
+  AssetCache();
+  ~AssetCache();
+
+ public:
+  static AssetCache* GetInstance() {
+    // Singleton
+    static AssetCache instance;
+
+    return &instance;
+  }
+
+  /*
+   * Set where files are looked up. Either can be NULL.
+   *
+   * arguments:
+   * in: asset_manager, APK assets (AAssetManager, Android only)
+   * in: files_dir, directory checked first for loose files
+   */
+  void Init(AAssetManager* asset_manager, const char* files_dir);
+
+  /*
+   * Open a file
+   *
+   * arguments:
+   * in: file_name, file name relative to the files dir / asset root
+   * return: view of the contents, invalid if the file can not be read
+   */
+  AssetView Open(const char* file_name);
+
+  /*
+   * Release cached files that no view refers to
+   */
+  void Trim();
+};
+
+}  // namespace ndkHelper
+#endif /* ASSET_CACHE_H_ */
@@ -25,6 +25,31 @@ namespace ndk_helper {
 // includes
 //--------------------------------------------------------------------------------
 
+//--------------------------------------------------------------------------------
+// Motion event samples
+//--------------------------------------------------------------------------------
+namespace {
+
+const double NS_TO_S = 1.0 / 1000000000.0;
+
+// history == AMotionEvent_getHistorySize() reads the current sample
+Vec2 GetSample(const AInputEvent* event, const int32_t index,
+               const int32_t history) {
+  if (history >= (int32_t)AMotionEvent_getHistorySize(event))
+    return Vec2(AMotionEvent_getX(event, index),
+                AMotionEvent_getY(event, index));
+  return Vec2(AMotionEvent_getHistoricalX(event, index, history),
+              AMotionEvent_getHistoricalY(event, index, history));
+}
+
+double GetSampleTime(const AInputEvent* event, const int32_t history) {
+  if (history >= (int32_t)AMotionEvent_getHistorySize(event))
+    return AMotionEvent_getEventTime(event) * NS_TO_S;
+  return AMotionEvent_getHistoricalEventTime(event, history) * NS_TO_S;
+}
+
+}  // namespace
+
 //--------------------------------------------------------------------------------
 // GestureDetector
 //--------------------------------------------------------------------------------
@@ -208,6 +233,28 @@ bool PinchDetector::GetPointers(Vec2& v1, Vec2& v2) {
   return true;
 }
 
+int32_t PinchDetector::GetHistorySize() {
+  return (int32_t)AMotionEvent_getHistorySize(event_);
+}
+
+bool PinchDetector::GetPointers(Vec2& v1, Vec2& v2, const int32_t history,
+                                double& time) {
+  if (vec_pointers_.size() < 2) return false;
+
+  int32_t index1 = FindIndex(event_, vec_pointers_[0]);
+  int32_t index2 = FindIndex(event_, vec_pointers_[1]);
+  if (index1 == -1 || index2 == -1) return false;
+
+  v1 = GetSample(event_, index1, history);
+  v2 = GetSample(event_, index2, history);
+  time = GetSampleTime(event_, history);
+  return true;
+}
+
+double PinchDetector::GetEventTime() {
+  return AMotionEvent_getEventTime(event_) * NS_TO_S;
+}
+
 //--------------------------------------------------------------------------------
 // DragDetector
 //--------------------------------------------------------------------------------
@@ -293,4 +340,23 @@ bool DragDetector::GetPointer(Vec2& v) {
   return true;
 }
 
+int32_t DragDetector::GetHistorySize() {
+  return (int32_t)AMotionEvent_getHistorySize(event_);
+}
+
+bool DragDetector::GetPointer(Vec2& v, const int32_t history, double& time) {
+  if (vec_pointers_.size() < 1) return false;
+
+  int32_t index = FindIndex(event_, vec_pointers_[0]);
+  if (index == -1) return false;
+
+  v = GetSample(event_, index, history);
+  time = GetSampleTime(event_, history);
+  return true;
+}
+
+double DragDetector::GetEventTime() {
+  return AMotionEvent_getEventTime(event_) * NS_TO_S;
+}
+
 }  // namespace ndkHelper
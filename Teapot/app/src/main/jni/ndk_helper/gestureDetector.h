@@ -120,6 +120,13 @@ class PinchDetector : public GestureDetector {
   virtual ~PinchDetector() {}
   virtual GESTURE_STATE Detect(const AInputEvent* event);
   bool GetPointers(Vec2& v1, Vec2& v2);
+
+  // Samples batched into the last event: history in [0, GetHistorySize()],
+  // oldest first, GetHistorySize() being the current sample.
+  // time: event time in seconds, CLOCK_MONOTONIC
+  int32_t GetHistorySize();
+  bool GetPointers(Vec2& v1, Vec2& v2, const int32_t history, double& time);
+  double GetEventTime();
 };
 
 /******************************************************************
@@ -138,6 +145,11 @@ class DragDetector : public GestureDetector {
   virtual ~DragDetector() {}
   virtual GESTURE_STATE Detect(const AInputEvent* event);
   bool GetPointer(Vec2& v);
+
+  // Samples batched into the last event, see PinchDetector::GetPointers()
+  int32_t GetHistorySize();
+  bool GetPointer(Vec2& v, const int32_t history, double& time);
+  double GetEventTime();
 };
 
 }  // namespace ndkHelper
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glTextureBackend.cpp
+//--------------------------------------------------------------------------------
+#include "glTextureBackend.h"
+
+#include <string.h>
+
+#include "gl3stub.h"
+#include "GLContext.h"
+#include "JNIHelper.h"
+
+namespace ndk_helper {
+
+namespace {
+
+GLenum GetGLFormat(const IMAGE_FORMAT format) {
+  switch (format) {
+    case IMAGE_FORMAT_L8:
+      return GL_LUMINANCE;
+    case IMAGE_FORMAT_LA8:
+      return GL_LUMINANCE_ALPHA;
+    case IMAGE_FORMAT_RGB8:
+      return GL_RGB;
+    default:
+      return GL_RGBA;
+  }
+}
+
+inline bool IsPowerOfTwo(const int32_t v) { return (v & (v - 1)) == 0; }
+
+}  // namespace
+
+GLTextureBackend::GLTextureBackend() : pbo_(0) {
+  es3_ = GLContext::GetInstance()->GetGLVersion() >= 3.0f;
+  if (es3_) glGenBuffers(1, &pbo_);
+}
+
+GLTextureBackend::~GLTextureBackend() {
+  if (pbo_) glDeleteBuffers(1, &pbo_);
+}
+
+uint32_t GLTextureBackend::CreatePlaceholder() {
+  static const uint8_t WHITE[4] = {255, 255, 255, 255};
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               WHITE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  return tex;
+}
+
+uint32_t GLTextureBackend::CreateTexture(const Image& image) {
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+
+  if (image.format_ == IMAGE_FORMAT_COMPRESSED) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, image.compressed_format_,
+                           image.width_, image.height_, 0,
+                           (GLsizei)image.pixels_.size(), &image.pixels_[0]);
+  } else {
+    const GLenum format = GetGLFormat(image.format_);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width_, image.height_, 0,
+                 format, GL_UNSIGNED_BYTE, NULL);
+  }
+
+  if (glGetError() != GL_NO_ERROR) {
+    LOGI("Texture creation failed %dx%d", image.width_, image.height_);
+    glDeleteTextures(1, &tex);
+    return 0;
+  }
+  return tex;
+}
+
+void GLTextureBackend::UploadRows(const uint32_t texture, const Image& image,
+                                  const int32_t y, const int32_t rows) {
+  const GLenum format = GetGLFormat(image.format_);
+  const size_t stride = image.Stride();
+  const uint8_t* src = &image.pixels_[y * stride];
+  const GLsizeiptr size = (GLsizeiptr)(rows * stride);
+
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  if (es3_) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                  GL_MAP_WRITE_BIT |
+                                      GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dest) {
+      memcpy(dest, src, size);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, image.width_, rows, format,
+                      GL_UNSIGNED_BYTE, NULL);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      return;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, image.width_, rows, format,
+                  GL_UNSIGNED_BYTE, src);
+}
+
+void GLTextureBackend::FinishTexture(const uint32_t texture,
+                                     const Image& image) {
+  glBindTexture(GL_TEXTURE_2D, texture);
+  const bool mipmap = image.format_ != IMAGE_FORMAT_COMPRESSED &&
+                      (es3_ || (IsPowerOfTwo(image.width_) &&
+                                IsPowerOfTwo(image.height_)));
+  if (mipmap) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_NEAREST);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  } else {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void GLTextureBackend::DeleteTexture(const uint32_t texture) {
+  GLuint tex = texture;
+  glDeleteTextures(1, &tex);
+}
+
+}  // namespace ndkHelper
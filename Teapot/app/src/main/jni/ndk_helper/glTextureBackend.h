@@ -0,0 +1,57 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GL_TEXTURE_BACKEND_H_
+#define GL_TEXTURE_BACKEND_H_
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "textureManager.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * OpenGL ES texture backend of TextureManager
+ * On ES3 rows are staged in a pixel unpack buffer, orphaned on every upload
+ * so the driver never waits for the previous copy, and glTexSubImage2D reads
+ * from it. On ES2 rows go straight to glTexSubImage2D.
+ *
+ * Textures get mipmaps (GL_LINEAR_MIPMAP_NEAREST, as JNIHelper::LoadTexture)
+ * unless they are compressed, or non power of two on ES2, which get
+ * GL_LINEAR and GL_CLAMP_TO_EDGE instead.
+ *
+ * Create it with the GL context current, after GLContext::Init().
+ */
+class GLTextureBackend : public TextureBackend {
+ private:
+  bool es3_;
+  GLuint pbo_;
+
+ public:
+  GLTextureBackend();
+  virtual ~GLTextureBackend();
+
+  virtual uint32_t CreatePlaceholder();
+  virtual uint32_t CreateTexture(const Image& image);
+  virtual void UploadRows(const uint32_t texture, const Image& image,
+                          const int32_t y, const int32_t rows);
+  virtual void FinishTexture(const uint32_t texture, const Image& image);
+  virtual void DeleteTexture(const uint32_t texture);
+};
+
+}  // namespace ndkHelper
+#endif /* GL_TEXTURE_BACKEND_H_ */
@@ -0,0 +1,513 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// imageDecoder.cpp
+//--------------------------------------------------------------------------------
+#include "imageDecoder.h"
+
+#include <string.h>
+#include <zlib.h>
+
+namespace ndk_helper {
+
+namespace {
+
+// Largest image accepted, in pixels, so a corrupt header can not make us
+// allocate gigabytes
+const uint64_t MAX_IMAGE_PIXELS = 1 << 26;
+
+inline uint32_t ReadBE32(const uint8_t* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         p[3];
+}
+
+//--------------------------------------------------------------------------------
+// PNG
+//--------------------------------------------------------------------------------
+const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+enum PNG_COLOR {
+  PNG_COLOR_GRAY = 0,
+  PNG_COLOR_RGB = 2,
+  PNG_COLOR_PALETTE = 3,
+  PNG_COLOR_GRAY_ALPHA = 4,
+  PNG_COLOR_RGBA = 6,
+};
+
+// Adam7 passes: first column, first row, column step, row step
+const int32_t ADAM7[7][4] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8},
+                             {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2},
+                             {0, 1, 1, 2}};
+
+struct PngInfo {
+  int32_t width_;
+  int32_t height_;
+  int32_t depth_;
+  int32_t color_;
+  int32_t channels_;
+  bool interlaced_;
+  uint8_t palette_[256 * 4];
+  int32_t palette_size_;
+  bool has_key_;  // tRNS color key for gray and RGB images
+  uint16_t key_[3];
+};
+
+size_t RowBytes(const PngInfo& info, const int32_t width) {
+  return ((size_t)width * info.channels_ * info.depth_ + 7) / 8;
+}
+
+int32_t PassSize(const int32_t size, const int32_t first, const int32_t step) {
+  return size > first ? (size - first + step - 1) / step : 0;
+}
+
+inline uint8_t Paeth(const int32_t a, const int32_t b, const int32_t c) {
+  int32_t p = a + b - c;
+  int32_t pa = p > a ? p - a : a - p;
+  int32_t pb = p > b ? p - b : b - p;
+  int32_t pc = p > c ? p - c : c - p;
+  if (pa <= pb && pa <= pc) return (uint8_t)a;
+  if (pb <= pc) return (uint8_t)b;
+  return (uint8_t)c;
+}
+
+// Undo the filter of one row in place. |prev| is the previous row, already
+// unfiltered, or a row of zeros.
+bool Unfilter(const uint8_t filter, uint8_t* row, const uint8_t* prev,
+              const size_t row_bytes, const size_t bpp) {
+  size_t i;
+  switch (filter) {
+    case 0:
+      break;
+    case 1:
+      for (i = bpp; i < row_bytes; ++i) row[i] += row[i - bpp];
+      break;
+    case 2:
+      for (i = 0; i < row_bytes; ++i) row[i] += prev[i];
+      break;
+    case 3:
+      for (i = 0; i < bpp; ++i) row[i] += prev[i] >> 1;
+      for (; i < row_bytes; ++i) row[i] += (row[i - bpp] + prev[i]) >> 1;
+      break;
+    case 4:
+      for (i = 0; i < bpp; ++i) row[i] += prev[i];
+      for (; i < row_bytes; ++i)
+        row[i] += Paeth(row[i - bpp], prev[i], prev[i - bpp]);
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// Sample |index| of a row, at the image's bit depth
+inline uint32_t Sample(const uint8_t* row, const size_t index,
+                       const int32_t depth) {
+  switch (depth) {
+    case 8:
+      return row[index];
+    case 16:
+      return (uint32_t)row[index * 2] << 8 | row[index * 2 + 1];
+    default: {
+      size_t bit = index * depth;
+      return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+    }
+  }
+}
+
+// Sample scaled to 8 bits
+inline uint8_t Sample8(const uint32_t v, const int32_t depth) {
+  switch (depth) {
+    case 1:
+      return v ? 255 : 0;
+    case 2:
+      return (uint8_t)(v * 85);
+    case 4:
+      return (uint8_t)(v * 17);
+    case 16:
+      return (uint8_t)(v >> 8);
+    default:
+      return (uint8_t)v;
+  }
+}
+
+// Convert |count| unfiltered pixels of |row| into |dest_bpp| bytes output
+// pixels, written every |dest_step| bytes
+void ConvertRow(const PngInfo& info, const uint8_t* row, const int32_t count,
+                uint8_t* dest, const size_t dest_bpp, const size_t dest_step) {
+  const int32_t depth = info.depth_;
+  for (int32_t x = 0; x < count; ++x, dest += dest_step) {
+    switch (info.color_) {
+      case PNG_COLOR_GRAY: {
+        uint32_t v = Sample(row, x, depth);
+        dest[0] = Sample8(v, depth);
+        if (info.has_key_) dest[1] = v == info.key_[0] ? 0 : 255;
+        break;
+      }
+      case PNG_COLOR_GRAY_ALPHA:
+        dest[0] = Sample8(Sample(row, x * 2, depth), depth);
+        dest[1] = Sample8(Sample(row, x * 2 + 1, depth), depth);
+        break;
+      case PNG_COLOR_RGB: {
+        uint32_t r = Sample(row, x * 3, depth);
+        uint32_t g = Sample(row, x * 3 + 1, depth);
+        uint32_t b = Sample(row, x * 3 + 2, depth);
+        dest[0] = Sample8(r, depth);
+        dest[1] = Sample8(g, depth);
+        dest[2] = Sample8(b, depth);
+        if (info.has_key_)
+          dest[3] = r == info.key_[0] && g == info.key_[1] && b == info.key_[2]
+                        ? 0
+                        : 255;
+        break;
+      }
+      case PNG_COLOR_RGBA:
+        for (int32_t c = 0; c < 4; ++c)
+          dest[c] = Sample8(Sample(row, x * 4 + c, depth), depth);
+        break;
+      case PNG_COLOR_PALETTE: {
+        // Out of range indices read as zero, like most decoders
+        const uint8_t* entry = &info.palette_[Sample(row, x, depth) * 4];
+        memcpy(dest, entry, dest_bpp);
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int32_t Image::BytesPerPixel() const {
+  switch (format_) {
+    case IMAGE_FORMAT_L8:
+      return 1;
+    case IMAGE_FORMAT_LA8:
+      return 2;
+    case IMAGE_FORMAT_RGB8:
+      return 3;
+    case IMAGE_FORMAT_RGBA8:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+bool DecodePng(const uint8_t* data, const size_t size, Image* image) {
+  if (size < 8 || memcmp(data, PNG_SIGNATURE, 8)) return false;
+
+  PngInfo info;
+  memset(&info, 0, sizeof(info));
+  bool has_trns = false;
+  std::vector<uint8_t> raw;
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  bool stream_open = false;
+  bool stream_end = false;
+  bool ok = true;
+
+  size_t pos = 8;
+  while (ok) {
+    if (size - pos < 12) {
+      ok = false;
+      break;
+    }
+    const uint32_t length = ReadBE32(data + pos);
+    const uint8_t* type = data + pos + 4;
+    const uint8_t* chunk = data + pos + 8;
+    if (length > size - pos - 12) {
+      ok = false;
+      break;
+    }
+    pos += 12 + length;
+
+    if (!memcmp(type, "IHDR", 4)) {
+      if (length != 13 || stream_open) {
+        ok = false;
+        break;
+      }
+      info.width_ = (int32_t)ReadBE32(chunk);
+      info.height_ = (int32_t)ReadBE32(chunk + 4);
+      info.depth_ = chunk[8];
+      info.color_ = chunk[9];
+      info.interlaced_ = chunk[12] == 1;
+      const int32_t d = info.depth_;
+      switch (info.color_) {
+        case PNG_COLOR_GRAY:
+          info.channels_ = 1;
+          ok = d == 1 || d == 2 || d == 4 || d == 8 || d == 16;
+          break;
+        case PNG_COLOR_PALETTE:
+          info.channels_ = 1;
+          ok = d == 1 || d == 2 || d == 4 || d == 8;
+          break;
+        case PNG_COLOR_RGB:
+          info.channels_ = 3;
+          ok = d == 8 || d == 16;
+          break;
+        case PNG_COLOR_GRAY_ALPHA:
+          info.channels_ = 2;
+          ok = d == 8 || d == 16;
+          break;
+        case PNG_COLOR_RGBA:
+          info.channels_ = 4;
+          ok = d == 8 || d == 16;
+          break;
+        default:
+          ok = false;
+      }
+      ok = ok && info.width_ > 0 && info.height_ > 0 && chunk[10] == 0 &&
+           chunk[11] == 0 && chunk[12] <= 1 &&
+           (uint64_t)info.width_ * info.height_ <= MAX_IMAGE_PIXELS;
+      if (!ok) break;
+
+      // All passes, each row preceded by its filter byte
+      size_t raw_size = 0;
+      if (info.interlaced_) {
+        for (int32_t p = 0; p < 7; ++p) {
+          int32_t w = PassSize(info.width_, ADAM7[p][0], ADAM7[p][2]);
+          int32_t h = PassSize(info.height_, ADAM7[p][1], ADAM7[p][3]);
+          if (w && h) raw_size += (RowBytes(info, w) + 1) * h;
+        }
+      } else {
+        raw_size = (RowBytes(info, info.width_) + 1) * info.height_;
+      }
+      raw.resize(raw_size);
+      ok = inflateInit(&stream) == Z_OK;
+      stream_open = ok;
+      stream.next_out = &raw[0];
+      stream.avail_out = (uInt)raw.size();
+    } else if (!memcmp(type, "PLTE", 4)) {
+      if (length % 3 || length > 256 * 3) {
+        ok = false;
+        break;
+      }
+      info.palette_size_ = length / 3;
+      for (int32_t i = 0; i < info.palette_size_; ++i) {
+        memcpy(&info.palette_[i * 4], chunk + i * 3, 3);
+        info.palette_[i * 4 + 3] = 255;
+      }
+    } else if (!memcmp(type, "tRNS", 4)) {
+      if (info.color_ == PNG_COLOR_PALETTE) {
+        for (uint32_t i = 0; i < length && i < 256; ++i)
+          info.palette_[i * 4 + 3] = chunk[i];
+        has_trns = true;
+      } else if (info.color_ == PNG_COLOR_GRAY && length >= 2) {
+        info.key_[0] = (uint16_t)(chunk[0] << 8 | chunk[1]);
+        info.has_key_ = true;
+      } else if (info.color_ == PNG_COLOR_RGB && length >= 6) {
+        for (int32_t c = 0; c < 3; ++c)
+          info.key_[c] = (uint16_t)(chunk[c * 2] << 8 | chunk[c * 2 + 1]);
+        info.has_key_ = true;
+      }
+    } else if (!memcmp(type, "IDAT", 4)) {
+      if (!stream_open) {
+        ok = false;
+        break;
+      }
+      if (stream_end || !length) continue;
+      stream.next_in = (Bytef*)chunk;
+      stream.avail_in = length;
+      int ret = inflate(&stream, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END)
+        stream_end = true;
+      else if (ret != Z_OK)
+        ok = false;
+    } else if (!memcmp(type, "IEND", 4)) {
+      break;
+    } else if (!(type[0] & 0x20)) {
+      // Unknown critical chunk
+      ok = false;
+    }
+  }
+
+  if (stream_open) {
+    ok = ok && stream_end && stream.total_out == raw.size();
+    inflateEnd(&stream);
+  } else {
+    ok = false;
+  }
+  if (!ok || (info.color_ == PNG_COLOR_PALETTE && !info.palette_size_))
+    return false;
+
+  // Output format
+  if (info.color_ == PNG_COLOR_PALETTE) {
+    image->format_ = has_trns ? IMAGE_FORMAT_RGBA8 : IMAGE_FORMAT_RGB8;
+  } else if (info.color_ == PNG_COLOR_GRAY) {
+    image->format_ = info.has_key_ ? IMAGE_FORMAT_LA8 : IMAGE_FORMAT_L8;
+  } else if (info.color_ == PNG_COLOR_GRAY_ALPHA) {
+    image->format_ = IMAGE_FORMAT_LA8;
+  } else if (info.color_ == PNG_COLOR_RGB) {
+    image->format_ = info.has_key_ ? IMAGE_FORMAT_RGBA8 : IMAGE_FORMAT_RGB8;
+  } else {
+    image->format_ = IMAGE_FORMAT_RGBA8;
+  }
+  image->width_ = info.width_;
+  image->height_ = info.height_;
+  image->compressed_format_ = 0;
+
+  const size_t out_bpp = image->BytesPerPixel();
+  const size_t stride = out_bpp * info.width_;
+  // 8 bit rows that need no conversion are copied as they are
+  const bool direct = info.depth_ == 8 && !info.has_key_ &&
+                      info.color_ != PNG_COLOR_PALETTE;
+  const size_t filter_bpp =
+      info.channels_ * info.depth_ >= 8 ? info.channels_ * info.depth_ / 8 : 1;
+  image->pixels_.resize(stride * info.height_);
+
+  std::vector<uint8_t> zero(RowBytes(info, info.width_), 0);
+  uint8_t* src = raw.size() ? &raw[0] : NULL;
+  for (int32_t p = 0; p < (info.interlaced_ ? 7 : 1); ++p) {
+    const int32_t* a = info.interlaced_ ? ADAM7[p] : NULL;
+    const int32_t x0 = a ? a[0] : 0, y0 = a ? a[1] : 0;
+    const int32_t dx = a ? a[2] : 1, dy = a ? a[3] : 1;
+    const int32_t w = PassSize(info.width_, x0, dx);
+    const int32_t h = PassSize(info.height_, y0, dy);
+    if (!w || !h) continue;
+
+    const size_t row_bytes = RowBytes(info, w);
+    const uint8_t* prev = &zero[0];
+    for (int32_t y = 0; y < h; ++y) {
+      uint8_t filter = *src++;
+      if (!Unfilter(filter, src, prev, row_bytes, filter_bpp)) return false;
+      uint8_t* dest = &image->pixels_[(y0 + y * dy) * stride + x0 * out_bpp];
+      if (direct && dx == 1)
+        memcpy(dest, src, row_bytes);
+      else
+        ConvertRow(info, src, w, dest, out_bpp, out_bpp * dx);
+      prev = src;
+      src += row_bytes;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------
+// KTX
+//--------------------------------------------------------------------------------
+namespace {
+
+const uint8_t KTX_IDENTIFIER[12] = {0xab, 'K',  'T',  'X',  ' ',  '1',
+                                    '1',  0xbb, '\r', '\n', 0x1a, '\n'};
+const size_t KTX_HEADER_SIZE = 64;
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+// GL enums, to keep this file free of GL headers
+const uint32_t KTX_GL_UNSIGNED_BYTE = 0x1401;
+const uint32_t KTX_GL_RGB = 0x1907;
+const uint32_t KTX_GL_RGBA = 0x1908;
+const uint32_t KTX_GL_LUMINANCE = 0x1909;
+const uint32_t KTX_GL_LUMINANCE_ALPHA = 0x190a;
+
+enum KTX_FIELD {
+  KTX_FIELD_ENDIANNESS,
+  KTX_FIELD_GL_TYPE,
+  KTX_FIELD_GL_TYPE_SIZE,
+  KTX_FIELD_GL_FORMAT,
+  KTX_FIELD_GL_INTERNAL_FORMAT,
+  KTX_FIELD_GL_BASE_INTERNAL_FORMAT,
+  KTX_FIELD_PIXEL_WIDTH,
+  KTX_FIELD_PIXEL_HEIGHT,
+  KTX_FIELD_PIXEL_DEPTH,
+  KTX_FIELD_NUMBER_OF_ARRAY_ELEMENTS,
+  KTX_FIELD_NUMBER_OF_FACES,
+  KTX_FIELD_NUMBER_OF_MIPMAP_LEVELS,
+  KTX_FIELD_BYTES_OF_KEY_VALUE_DATA,
+  KTX_FIELD_COUNT,
+};
+
+inline uint32_t ReadU32(const uint8_t* p, const bool swap) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+}  // namespace
+
+bool DecodeKtx(const uint8_t* data, const size_t size, Image* image) {
+  if (size < KTX_HEADER_SIZE + 4 || memcmp(data, KTX_IDENTIFIER, 12))
+    return false;
+
+  uint32_t header[KTX_FIELD_COUNT];
+  const uint32_t endianness = ReadU32(data + 12, false);
+  const bool swap = endianness != KTX_ENDIANNESS;
+  if (swap && __builtin_bswap32(endianness) != KTX_ENDIANNESS) return false;
+  for (int32_t i = 0; i < KTX_FIELD_COUNT; ++i)
+    header[i] = ReadU32(data + 12 + i * 4, swap);
+
+  const uint32_t width = header[KTX_FIELD_PIXEL_WIDTH];
+  const uint32_t height = header[KTX_FIELD_PIXEL_HEIGHT];
+  if (!width || !height || header[KTX_FIELD_PIXEL_DEPTH] ||
+      header[KTX_FIELD_NUMBER_OF_ARRAY_ELEMENTS] ||
+      header[KTX_FIELD_NUMBER_OF_FACES] != 1 ||
+      (uint64_t)width * height > MAX_IMAGE_PIXELS)
+    return false;
+
+  const uint64_t offset =
+      KTX_HEADER_SIZE + (uint64_t)header[KTX_FIELD_BYTES_OF_KEY_VALUE_DATA];
+  if (offset + 4 > size) return false;
+  const uint32_t image_size = ReadU32(data + offset, swap);
+  const uint8_t* level = data + offset + 4;
+  if (image_size > size - offset - 4) return false;
+
+  image->width_ = (int32_t)width;
+  image->height_ = (int32_t)height;
+
+  if (header[KTX_FIELD_GL_TYPE] == 0) {
+    // Compressed, uploaded as is
+    image->format_ = IMAGE_FORMAT_COMPRESSED;
+    image->compressed_format_ = header[KTX_FIELD_GL_INTERNAL_FORMAT];
+    image->pixels_.assign(level, level + image_size);
+    return image_size > 0;
+  }
+
+  if (header[KTX_FIELD_GL_TYPE] != KTX_GL_UNSIGNED_BYTE) return false;
+  switch (header[KTX_FIELD_GL_FORMAT]) {
+    case KTX_GL_LUMINANCE:
+      image->format_ = IMAGE_FORMAT_L8;
+      break;
+    case KTX_GL_LUMINANCE_ALPHA:
+      image->format_ = IMAGE_FORMAT_LA8;
+      break;
+    case KTX_GL_RGB:
+      image->format_ = IMAGE_FORMAT_RGB8;
+      break;
+    case KTX_GL_RGBA:
+      image->format_ = IMAGE_FORMAT_RGBA8;
+      break;
+    default:
+      return false;
+  }
+  image->compressed_format_ = 0;
+
+  // KTX rows are padded to 4 bytes
+  const size_t stride = image->Stride();
+  const size_t src_stride = (stride + 3) & ~(size_t)3;
+  if ((uint64_t)src_stride * (height - 1) + stride > image_size) return false;
+  image->pixels_.resize(stride * height);
+  for (uint32_t y = 0; y < height; ++y)
+    memcpy(&image->pixels_[y * stride], level + y * src_stride, stride);
+  return true;
+}
+
+bool DecodeImage(const uint8_t* data, const size_t size, Image* image) {
+  if (size >= 8 && !memcmp(data, PNG_SIGNATURE, 8))
+    return DecodePng(data, size, image);
+  if (size >= 12 && !memcmp(data, KTX_IDENTIFIER, 12))
+    return DecodeKtx(data, size, image);
+  return false;
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_DECODER_H_
+#define IMAGE_DECODER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ndk_helper {
+
+enum IMAGE_FORMAT {
+  IMAGE_FORMAT_L8,          // GL_LUMINANCE
+  IMAGE_FORMAT_LA8,         // GL_LUMINANCE_ALPHA
+  IMAGE_FORMAT_RGB8,        // GL_RGB
+  IMAGE_FORMAT_RGBA8,       // GL_RGBA
+  IMAGE_FORMAT_COMPRESSED,  // Image::compressed_format_, e.g. ETC1
+};
+
+/******************************************************************
+ * Decoded image, level 0 only
+ * Uncompressed rows are tightly packed (GL_UNPACK_ALIGNMENT 1), in file
+ * order (top row first for PNG), and are uploaded as they are.
+ */
+struct Image {
+  int32_t width_;
+  int32_t height_;
+  IMAGE_FORMAT format_;
+  uint32_t compressed_format_;  // GL internal format when compressed
+  std::vector<uint8_t> pixels_;
+
+  Image()
+      : width_(0),
+        height_(0),
+        format_(IMAGE_FORMAT_RGBA8),
+        compressed_format_(0) {}
+
+  int32_t BytesPerPixel() const;
+  // Bytes per row, 0 for compressed images
+  int32_t Stride() const { return width_ * BytesPerPixel(); }
+};
+
+/******************************************************************
+ * Image decoders
+ * Native replacements for BitmapFactory, safe to call from any thread. They
+ * need no GL, JNI or Android API, so they also run on a Linux host.
+ *
+ * PNG: every color type and bit depth, interlaced or not. 16 bit channels
+ * are reduced to 8 bits, palettes are expanded to RGB(A).
+ * KTX: 2D GL_UNSIGNED_BYTE textures in the formats above, or any compressed
+ * format (passed through). Only level 0 is kept.
+ *
+ * return: false if the data is not a supported, well formed image
+ */
+bool DecodeImage(const uint8_t* data, const size_t size, Image* image);
+bool DecodePng(const uint8_t* data, const size_t size, Image* image);
+bool DecodeKtx(const uint8_t* data, const size_t size, Image* image);
+
+}  // namespace ndkHelper
+#endif /* IMAGE_DECODER_H_ */
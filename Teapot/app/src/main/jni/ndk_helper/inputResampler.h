@@ -0,0 +1,116 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INPUT_RESAMPLER_H_
+#define INPUT_RESAMPLER_H_
+
+#include <stdint.h>
+
+#include "vecmath.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Timestamped pointer samples of a gesture
+ * Touch panels report at 60-240Hz and the events reach the app in batches,
+ * while frames are shown at 30-120Hz. Sampling the pointers at the time a
+ * frame is displayed, instead of taking the last event, makes the motion on
+ * screen independent of both rates.
+ *
+ * Resample() interpolates the two samples around the time. Past the last
+ * sample it extrapolates, by at most half the last sample interval and
+ * INPUT_MAX_PREDICTION, and only when the last two samples are at least
+ * INPUT_MIN_SAMPLE_INTERVAL apart (the policy of the framework's
+ * InputConsumer).
+ *
+ * Times are in seconds on CLOCK_MONOTONIC, the clock of AMotionEvent times
+ * and PerfMonitor::GetCurrentTime().
+ */
+// Input is shown this long before the frame's display time, so that a sample
+// usually exists on both sides
+const double INPUT_RESAMPLE_LATENCY = 0.005;
+const double INPUT_MAX_PREDICTION = 0.008;
+const double INPUT_MIN_SAMPLE_INTERVAL = 0.002;
+// Velocity is fit over this window; no sample for INPUT_VELOCITY_STOP before
+// the release means the finger stopped
+const double INPUT_VELOCITY_WINDOW = 0.1;
+const double INPUT_VELOCITY_STOP = 0.04;
+
+const int32_t INPUT_MAX_SAMPLES = 32;
+const int32_t INPUT_MAX_POINTERS = 2;
+
+class InputResampler {
+ private:
+  struct Sample {
+    double time_;
+    Vec2 pointers_[INPUT_MAX_POINTERS];
+  };
+
+  Sample samples_[INPUT_MAX_SAMPLES];
+  int32_t head_;  // Index of the oldest sample
+  int32_t count_;
+
+  const Sample& GetSample(const int32_t i) const {
+    return samples_[(head_ + i) % INPUT_MAX_SAMPLES];
+  }
+
+ public:
+  InputResampler() : head_(0), count_(0) {}
+
+  // Start a new gesture
+  void Reset() { head_ = count_ = 0; }
+
+  /*
+   * Add a sample. A sample older than the last one is dropped, one with the
+   * same time replaces it. The oldest samples are overwritten when full.
+   *
+   * arguments:
+   * in: time, event time in seconds
+   * in: pointers, num_pointers positions, up to INPUT_MAX_POINTERS
+   */
+  void AddSample(const double time, const Vec2* pointers,
+                 const int32_t num_pointers);
+
+  int32_t GetSampleCount() const { return count_; }
+
+  /*
+   * arguments:
+   * in: time, sample time
+   * out: pointers, INPUT_MAX_POINTERS positions at the time
+   * return: false if there is no sample
+   */
+  bool Resample(const double time, Vec2* pointers) const;
+
+  /*
+   * return: false if there is no sample
+   */
+  bool GetLastSample(Vec2* pointers) const;
+
+  /*
+   * Least squares velocity of a pointer over the INPUT_VELOCITY_WINDOW before
+   * the last sample
+   *
+   * arguments:
+   * in: pointer, pointer index
+   * in: time, release time; zero velocity if the last sample is more than
+   *     INPUT_VELOCITY_STOP older
+   * return: velocity in units per second
+   */
+  Vec2 GetVelocity(const int32_t pointer, const double time) const;
+};
+
+}  // namespace ndkHelper
+#endif /* INPUT_RESAMPLER_H_ */
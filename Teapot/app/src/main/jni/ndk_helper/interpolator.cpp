@@ -150,4 +150,242 @@ float Interpolator::GetFormula(const INTERPOLATOR_TYPE type, const float t,
   }
 }
 
+//-------------------------------------------------
+// BatchInterpolator
+//-------------------------------------------------
+namespace {
+
+// Branch free so it vectorizes; __restrict keeps the compiler from giving up
+// on the alias checks between this many arrays
+void EvaluateCurves(const float now, const int32_t count,
+                    const float* __restrict start_time,
+                    const float* __restrict inv_duration,
+                    const float* __restrict k0, const float* __restrict k1,
+                    const float* __restrict k2, const float* __restrict k3,
+                    const float* __restrict k4, float* __restrict progress,
+                    float* __restrict values) {
+  for (int32_t i = 0; i < count; ++i) {
+    float u = (now - start_time[i]) * inv_duration[i];
+    u = u < 1.f ? u : 1.f;
+    progress[i] = u;
+    values[i] = (((k4[i] * u + k3[i]) * u + k2[i]) * u + k1[i]) * u + k0[i];
+  }
+}
+
+}  // namespace
+
+BatchInterpolator::BatchInterpolator()
+    : expo_channels_(0),
+      free_keys_(-1),
+      time_base_(PerfMonitor::GetCurrentTime()) {}
+
+BatchInterpolator::~BatchInterpolator() {}
+
+int32_t BatchInterpolator::Create() {
+  int32_t channel;
+  if (free_channels_.size()) {
+    channel = free_channels_.back();
+    free_channels_.pop_back();
+  } else {
+    channel = (int32_t)values_.size();
+    start_time_.push_back(0.f);
+    inv_duration_.push_back(0.f);
+    for (int32_t i = 0; i < INTERPOLATOR_COEFFS; ++i) coeff_[i].push_back(0.f);
+    progress_.push_back(0.f);
+    values_.push_back(0.f);
+    start_value_.push_back(0.f);
+    dest_value_.push_back(0.f);
+    type_.push_back(INTERPOLATOR_TYPE_LINEAR);
+    active_.push_back(0);
+    queue_head_.push_back(-1);
+    queue_tail_.push_back(-1);
+  }
+  SetConstant(channel, 0.f);
+  return channel;
+}
+
+void BatchInterpolator::Release(const int32_t channel) {
+  ClearQueue(channel);
+  SetConstant(channel, 0.f);
+  free_channels_.push_back(channel);
+}
+
+void BatchInterpolator::Set(const int32_t channel, const float start,
+                            const float dest, const INTERPOLATOR_TYPE type,
+                            const double duration) {
+  StartSegment(channel, start, dest, type, duration,
+               RelativeTime(PerfMonitor::GetCurrentTime()));
+}
+
+void BatchInterpolator::Add(const int32_t channel, const float dest,
+                            const INTERPOLATOR_TYPE type,
+                            const double duration) {
+  int32_t key = free_keys_;
+  if (key >= 0) {
+    free_keys_ = key_next_[key];
+  } else {
+    key = (int32_t)keys_.size();
+    keys_.push_back(InterpolatorParams());
+    key_next_.push_back(-1);
+  }
+  keys_[key].dest_value_ = dest;
+  keys_[key].type_ = type;
+  keys_[key].duration_ = duration;
+  key_next_[key] = -1;
+
+  if (queue_tail_[channel] >= 0)
+    key_next_[queue_tail_[channel]] = key;
+  else
+    queue_head_[channel] = key;
+  queue_tail_[channel] = key;
+}
+
+void BatchInterpolator::Clear(const int32_t channel) { ClearQueue(channel); }
+
+void BatchInterpolator::ClearQueue(const int32_t channel) {
+  if (queue_head_[channel] < 0) return;
+  // Splice the whole queue onto the free list
+  key_next_[queue_tail_[channel]] = free_keys_;
+  free_keys_ = queue_head_[channel];
+  queue_head_[channel] = -1;
+  queue_tail_[channel] = -1;
+}
+
+float BatchInterpolator::RelativeTime(const double time) {
+  double delta = time - time_base_;
+  if (delta > INTERPOLATOR_REBASE_INTERVAL) {
+    const float shift = (float)delta;
+    const int32_t count = (int32_t)start_time_.size();
+    for (int32_t i = 0; i < count; ++i) start_time_[i] -= shift;
+    time_base_ = time;
+    delta = 0.0;
+  }
+  return (float)delta;
+}
+
+void BatchInterpolator::SetType(const int32_t channel,
+                                const INTERPOLATOR_TYPE type) {
+  const bool was_expo = type_[channel] >= INTERPOLATOR_TYPE_EASEINEXPO;
+  const bool is_expo = type >= INTERPOLATOR_TYPE_EASEINEXPO;
+  expo_channels_ += (int32_t)is_expo - (int32_t)was_expo;
+  type_[channel] = type;
+}
+
+void BatchInterpolator::SetConstant(const int32_t channel, const float value) {
+  // inv_duration_ 0 keeps progress at 0, so the channel never completes
+  inv_duration_[channel] = 0.f;
+  coeff_[0][channel] = value;
+  for (int32_t i = 1; i < INTERPOLATOR_COEFFS; ++i) coeff_[i][channel] = 0.f;
+  start_value_[channel] = value;
+  dest_value_[channel] = value;
+  values_[channel] = value;
+  SetType(channel, INTERPOLATOR_TYPE_LINEAR);
+  active_[channel] = 0;
+}
+
+void BatchInterpolator::StartSegment(const int32_t channel, const float start,
+                                     const float dest,
+                                     const INTERPOLATOR_TYPE type,
+                                     const double duration,
+                                     const float start_time) {
+  // Value = sum(k[i] * u^i) with u = t / d, expanded from GetFormula(). The
+  // in/out curves follow GetFormula() as written: it scales u by 1/2, so only
+  // their first half is ever used.
+  const float b = start;
+  const float c = dest - start;
+  float k[INTERPOLATOR_COEFFS] = {b, 0.f, 0.f, 0.f, 0.f};
+  switch (type) {
+    case INTERPOLATOR_TYPE_LINEAR:
+      k[1] = c;
+      break;
+    case INTERPOLATOR_TYPE_EASEINQUAD:
+      k[2] = c;
+      break;
+    case INTERPOLATOR_TYPE_EASEOUTQUAD:
+      k[1] = 2.f * c;
+      k[2] = -c;
+      break;
+    case INTERPOLATOR_TYPE_EASEINOUTQUAD:
+      k[2] = c / 8.f;
+      break;
+    case INTERPOLATOR_TYPE_EASEINCUBIC:
+      k[3] = c;
+      break;
+    case INTERPOLATOR_TYPE_EASEOUTCUBIC:
+      k[1] = 3.f * c;
+      k[2] = -3.f * c;
+      k[3] = c;
+      break;
+    case INTERPOLATOR_TYPE_EASEINOUTCUBIC:
+      k[3] = c / 16.f;
+      break;
+    case INTERPOLATOR_TYPE_EASEINQUART:
+      k[4] = c;
+      break;
+    case INTERPOLATOR_TYPE_EASEINEXPO:
+    case INTERPOLATOR_TYPE_EASEOUTEXPO:
+      // Evaluated separately in Update()
+      break;
+    default:
+      k[0] = 0.f;
+      break;
+  }
+  for (int32_t i = 0; i < INTERPOLATOR_COEFFS; ++i) coeff_[i][channel] = k[i];
+
+  start_time_[channel] = start_time;
+  // A zero duration gives an infinite (or NaN) progress, which Update()
+  // treats as complete, like Interpolator does
+  inv_duration_[channel] = (float)(1.0 / duration);
+  start_value_[channel] = start;
+  dest_value_[channel] = dest;
+  SetType(channel, type);
+  active_[channel] = 1;
+}
+
+void BatchInterpolator::Update(const double current_time) {
+  const float now = RelativeTime(current_time);
+  const int32_t count = (int32_t)values_.size();
+
+  // Pass 1: progress and polynomial curves for all channels
+  float* progress = progress_.data();
+  float* values = values_.data();
+  EvaluateCurves(now, count, start_time_.data(), inv_duration_.data(),
+                 coeff_[0].data(), coeff_[1].data(), coeff_[2].data(),
+                 coeff_[3].data(), coeff_[4].data(), progress, values);
+
+  // Pass 2: exponential curves
+  if (expo_channels_) {
+    const uint8_t* type = type_.data();
+    for (int32_t i = 0; i < count; ++i) {
+      if (type[i] < INTERPOLATOR_TYPE_EASEINEXPO || progress[i] >= 1.f)
+        continue;
+      const float u = progress[i];
+      const float b = start_value_[i];
+      const float c = dest_value_[i] - b;
+      if (type[i] == INTERPOLATOR_TYPE_EASEINEXPO)
+        values[i] = u == 0.f ? b : c * powf(2, 10 * (u - 1)) + b;
+      else
+        values[i] = c * (-powf(2, -10 * u) + 1) + b;
+    }
+  }
+
+  // Pass 3: completed segments move on to their next keyframe
+  for (int32_t i = 0; i < count; ++i) {
+    if (progress[i] < 1.f) continue;
+    const float dest = dest_value_[i];
+    const int32_t key = queue_head_[i];
+    if (key >= 0) {
+      const InterpolatorParams& item = keys_[key];
+      StartSegment(i, dest, item.dest_value_, item.type_, item.duration_, now);
+      queue_head_[i] = key_next_[key];
+      if (queue_head_[i] < 0) queue_tail_[i] = -1;
+      key_next_[key] = free_keys_;
+      free_keys_ = key;
+    } else {
+      SetConstant(i, dest);
+    }
+    values[i] = dest;
+  }
+}
+
 }  // namespace ndkHelper
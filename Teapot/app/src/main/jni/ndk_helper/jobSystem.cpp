@@ -0,0 +1,181 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// jobSystem.cpp
+//--------------------------------------------------------------------------------
+#include "jobSystem.h"
+
+#include <unistd.h>
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+JobSystem::JobSystem(const int32_t num_threads)
+    : next_worker_(1), queued_(0), quit_(false) {
+  int32_t workers = num_threads;
+  if (workers < 0) {
+    // Configured rather than online CPUs: idle cores may be powered down
+    workers = (int32_t)sysconf(_SC_NPROCESSORS_CONF) - 1;
+    if (workers < 0) workers = 0;
+  }
+
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+  pthread_cond_init(&done_cond_, NULL);
+  for (int32_t i = 0; i <= workers; ++i) {
+    Queue* queue = new Queue();
+    pthread_mutex_init(&queue->mutex_, NULL);
+    queues_.push_back(queue);
+  }
+  for (int32_t i = 0; i < workers; ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, WorkerThread, this) == 0)
+      threads_.push_back(thread);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+JobSystem::~JobSystem() {
+  pthread_mutex_lock(&mutex_);
+  quit_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  for (size_t i = 0; i < threads_.size(); ++i) pthread_join(threads_[i], NULL);
+
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    pthread_mutex_destroy(&queues_[i]->mutex_);
+    delete queues_[i];
+  }
+  pthread_cond_destroy(&done_cond_);
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+//--------------------------------------------------------------------------------
+// Workers
+//--------------------------------------------------------------------------------
+void* JobSystem::WorkerThread(void* param) {
+  JobSystem* jobs = static_cast<JobSystem*>(param);
+  jobs->Work(jobs->next_worker_++);
+  return NULL;
+}
+
+void JobSystem::Work(const int32_t queue) {
+  for (;;) {
+    Job job;
+    if (Pop(queue, &job)) {
+      Run(job);
+      continue;
+    }
+
+    pthread_mutex_lock(&mutex_);
+    while (!quit_ && queued_.load() == 0) pthread_cond_wait(&cond_, &mutex_);
+    bool quit = quit_;
+    pthread_mutex_unlock(&mutex_);
+    if (quit) break;
+  }
+}
+
+bool JobSystem::Pop(const int32_t queue, Job* job) {
+  // Own queue first, newest job: its data is the most likely to be in cache
+  const int32_t count = (int32_t)queues_.size();
+  for (int32_t i = 0; i < count; ++i) {
+    Queue* q = queues_[(queue + i) % count];
+    pthread_mutex_lock(&q->mutex_);
+    bool found = !q->jobs_.empty();
+    if (found) {
+      if (i == 0) {
+        *job = q->jobs_.back();
+        q->jobs_.pop_back();
+      } else {
+        // Steal the oldest job
+        *job = q->jobs_.front();
+        q->jobs_.pop_front();
+      }
+    }
+    pthread_mutex_unlock(&q->mutex_);
+    if (found) {
+      --queued_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void JobSystem::Run(const Job& job) {
+  job.function_(job.data_, job.begin_, job.end_);
+  if (job.remaining_->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Last one: wake the caller. Under the mutex, so the wakeup cannot fall
+    // between its check of the count and its wait. The count lives on the
+    // caller's stack and is not touched past this point.
+    pthread_mutex_lock(&mutex_);
+    pthread_cond_broadcast(&done_cond_);
+    pthread_mutex_unlock(&mutex_);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// ParallelFor
+//--------------------------------------------------------------------------------
+void JobSystem::ParallelFor(const int32_t count, const int32_t grain,
+                            JobFunction function, void* data) {
+  if (count <= 0) return;
+  const int32_t chunk = grain > 0 ? grain : 1;
+  const int32_t num_jobs = (count + chunk - 1) / chunk;
+  const int32_t num_queues = (int32_t)queues_.size();
+  if (num_jobs == 1 || threads_.empty()) {
+    function(data, 0, count);
+    return;
+  }
+
+  std::atomic<int32_t> remaining(num_jobs);
+  pthread_mutex_lock(&mutex_);
+  queued_ += num_jobs;
+
+  // Deal the chunks round robin, so each queue starts with its share
+  for (int32_t q = 0; q < num_queues && q < num_jobs; ++q) {
+    Queue* queue = queues_[q];
+    pthread_mutex_lock(&queue->mutex_);
+    for (int32_t j = q; j < num_jobs; j += num_queues) {
+      Job job;
+      job.function_ = function;
+      job.data_ = data;
+      job.begin_ = j * chunk;
+      job.end_ = job.begin_ + chunk < count ? job.begin_ + chunk : count;
+      job.remaining_ = &remaining;
+      queue->jobs_.push_back(job);
+    }
+    pthread_mutex_unlock(&queue->mutex_);
+  }
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+
+  // Help while there are chunks to take. All were queued above, so once
+  // none is left the rest are running on workers: sleep until they finish.
+  Job job;
+  while (Pop(0, &job)) Run(job);
+  pthread_mutex_lock(&mutex_);
+  while (remaining.load(std::memory_order_acquire) > 0)
+    pthread_cond_wait(&done_cond_, &mutex_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+}  // namespace ndkHelper
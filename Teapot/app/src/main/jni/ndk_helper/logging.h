@@ -0,0 +1,34 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NDK_HELPER_LOGGING_H_
+#define NDK_HELPER_LOGGING_H_
+
+/******************************************************************
+ * LOGI/LOGW/LOGE for code that does not otherwise need JNI or the activity.
+ * Including this rather than JNIHelper.h lets that code build on a host for
+ * the tests in tools/, where the log goes to stderr.
+ */
+#ifdef __ANDROID__
+#include "JNIHelper.h"
+#elif !defined(LOGI)  // Unless JNIHelper.h came first
+#include <stdio.h>
+#define LOGI(...) ((void)(fprintf(stderr, __VA_ARGS__), fputc('\n', stderr)))
+#define LOGW(...) LOGI(__VA_ARGS__)
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+#endif /* NDK_HELPER_LOGGING_H_ */
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh.cpp
+//--------------------------------------------------------------------------------
+#include "mesh.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace ndk_helper {
+
+namespace {
+
+const float SNORM16_MAX = 32767.f;
+const float UNORM16_MAX = 65535.f;
+
+inline float SignNotZero(const float v) { return v >= 0.f ? 1.f : -1.f; }
+
+inline int16_t ClampSnorm16(const float v) {
+  return (int16_t)(v > SNORM16_MAX ? SNORM16_MAX
+                                   : v < -SNORM16_MAX ? -SNORM16_MAX : v);
+}
+
+inline uint32_t AlignData(const uint32_t offset) {
+  return (offset + MESH_DATA_ALIGNMENT - 1) & ~(MESH_DATA_ALIGNMENT - 1);
+}
+
+}  // namespace
+
+//--------------------------------------------------------------------------------
+// Encoding
+//--------------------------------------------------------------------------------
+void mesh::OctDecode(const int16_t* encoded, float* n) {
+  float x = encoded[0] / SNORM16_MAX;
+  float y = encoded[1] / SNORM16_MAX;
+  float z = 1.f - fabsf(x) - fabsf(y);
+  if (z < 0.f) {
+    float t = x;
+    x = (1.f - fabsf(y)) * SignNotZero(x);
+    y = (1.f - fabsf(t)) * SignNotZero(y);
+  }
+  float inv_length = 1.f / sqrtf(x * x + y * y + z * z);
+  n[0] = x * inv_length;
+  n[1] = y * inv_length;
+  n[2] = z * inv_length;
+}
+
+void mesh::OctEncode(const float* n, int16_t* encoded) {
+  // Project on the octahedron, fold the lower half over the upper one
+  float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+  float x = l1 > 0.f ? n[0] / l1 : 0.f;
+  float y = l1 > 0.f ? n[1] / l1 : 0.f;
+  if (n[2] < 0.f) {
+    float t = x;
+    x = (1.f - fabsf(y)) * SignNotZero(x);
+    y = (1.f - fabsf(t)) * SignNotZero(y);
+  }
+
+  // Try the four roundings, keep the one decoding closest to n
+  const float fx = floorf(x * SNORM16_MAX);
+  const float fy = floorf(y * SNORM16_MAX);
+  float best = -2.f;
+  for (int32_t i = 0; i < 4; ++i) {
+    int16_t candidate[2] = {ClampSnorm16(fx + (i & 1)),
+                            ClampSnorm16(fy + (i >> 1))};
+    float decoded[3];
+    OctDecode(candidate, decoded);
+    float d = decoded[0] * n[0] + decoded[1] * n[1] + decoded[2] * n[2];
+    if (d > best) {
+      best = d;
+      encoded[0] = candidate[0];
+      encoded[1] = candidate[1];
+    }
+  }
+}
+
+uint16_t mesh::QuantizeUnorm16(const float v, const float min,
+                               const float extent) {
+  if (extent <= 0.f) return 0;
+  float q = floorf((v - min) / extent * UNORM16_MAX + 0.5f);
+  return (uint16_t)(q < 0.f ? 0.f : q > UNORM16_MAX ? UNORM16_MAX : q);
+}
+
+float mesh::DequantizeUnorm16(const uint16_t q, const float min,
+                              const float extent) {
+  return q / UNORM16_MAX * extent + min;
+}
+
+bool mesh::WriteMesh(const float* positions, const float* normals,
+                     const int32_t num_vertices, const uint16_t* indices,
+                     const int32_t num_indices, const uint32_t flags,
+                     std::vector<uint8_t>* out) {
+  if (num_vertices <= 0 || num_vertices > 65536 || num_indices % 3)
+    return false;
+
+  MeshHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic_ = MESH_MAGIC;
+  header.version_ = MESH_VERSION;
+  header.flags_ = flags;
+  header.num_vertices_ = num_vertices;
+  header.num_indices_ = num_indices;
+  const bool quantized = (flags & MESH_FLAG_QUANTIZED_POSITIONS) != 0;
+  header.vertex_stride_ =
+      quantized ? sizeof(MeshVertexQuantized) : sizeof(MeshVertexFloat);
+  header.vertex_offset_ = AlignData(sizeof(MeshHeader));
+  header.index_offset_ =
+      AlignData(header.vertex_offset_ + num_vertices * header.vertex_stride_);
+
+  for (int32_t c = 0; c < 3; ++c)
+    header.aabb_min_[c] = header.aabb_max_[c] = positions[c];
+  for (int32_t i = 1; i < num_vertices; ++i) {
+    for (int32_t c = 0; c < 3; ++c) {
+      float v = positions[i * 3 + c];
+      if (v < header.aabb_min_[c]) header.aabb_min_[c] = v;
+      if (v > header.aabb_max_[c]) header.aabb_max_[c] = v;
+    }
+  }
+
+  out->assign(header.index_offset_ + num_indices * sizeof(uint16_t), 0);
+  memcpy(&(*out)[0], &header, sizeof(header));
+
+  uint8_t* vertex = &(*out)[header.vertex_offset_];
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    const float* p = positions + i * 3;
+    if (quantized) {
+      MeshVertexQuantized v;
+      memset(&v, 0, sizeof(v));
+      for (int32_t c = 0; c < 3; ++c)
+        v.pos_[c] = QuantizeUnorm16(p[c], header.aabb_min_[c],
+                                    header.aabb_max_[c] - header.aabb_min_[c]);
+      OctEncode(normals + i * 3, v.normal_);
+      memcpy(vertex, &v, sizeof(v));
+    } else {
+      MeshVertexFloat v;
+      memcpy(v.pos_, p, sizeof(v.pos_));
+      OctEncode(normals + i * 3, v.normal_);
+      memcpy(vertex, &v, sizeof(v));
+    }
+    vertex += header.vertex_stride_;
+  }
+  if (num_indices)
+    memcpy(&(*out)[header.index_offset_], indices,
+           num_indices * sizeof(uint16_t));
+  return true;
+}
+
+//--------------------------------------------------------------------------------
+// MeshData
+//--------------------------------------------------------------------------------
+MeshData::MeshData() : vertices_(NULL), indices_(NULL) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+bool MeshData::Parse(const uint8_t* data, const size_t size) {
+  vertices_ = indices_ = NULL;
+  if (data == NULL || size < sizeof(MeshHeader)) return false;
+  memcpy(&header_, data, sizeof(header_));
+  if (header_.magic_ != MESH_MAGIC || header_.version_ != MESH_VERSION)
+    return false;
+
+  uint32_t stride = IsQuantized() ? sizeof(MeshVertexQuantized)
+                                  : sizeof(MeshVertexFloat);
+  if (header_.vertex_stride_ != stride || header_.num_indices_ % 3 ||
+      header_.num_vertices_ > 65536)
+    return false;
+  if ((uint64_t)header_.vertex_offset_ + GetVertexDataSize() > size ||
+      (uint64_t)header_.index_offset_ + GetIndexDataSize() > size)
+    return false;
+
+  vertices_ = data + header_.vertex_offset_;
+  indices_ = data + header_.index_offset_;
+
+  // An index past the vertices would make the GPU read out of the buffer
+  for (uint32_t i = 0; i < header_.num_indices_; ++i) {
+    if (GetIndex(i) >= header_.num_vertices_) {
+      vertices_ = indices_ = NULL;
+      return false;
+    }
+  }
+  return true;
+}
+
+void MeshData::GetPositionScale(float* scale) const {
+  for (int32_t c = 0; c < 3; ++c)
+    scale[c] =
+        IsQuantized() ? header_.aabb_max_[c] - header_.aabb_min_[c] : 1.f;
+}
+
+void MeshData::GetPositionBias(float* bias) const {
+  for (int32_t c = 0; c < 3; ++c)
+    bias[c] = IsQuantized() ? header_.aabb_min_[c] : 0.f;
+}
+
+void MeshData::GetPosition(const int32_t index, float* position) const {
+  const uint8_t* vertex = vertices_ + (size_t)index * header_.vertex_stride_;
+  if (IsQuantized()) {
+    MeshVertexQuantized v;
+    memcpy(&v, vertex, sizeof(v));
+    for (int32_t c = 0; c < 3; ++c)
+      position[c] = mesh::DequantizeUnorm16(
+          v.pos_[c], header_.aabb_min_[c],
+          header_.aabb_max_[c] - header_.aabb_min_[c]);
+  } else {
+    memcpy(position, vertex, sizeof(float) * 3);
+  }
+}
+
+void MeshData::GetNormal(const int32_t index, float* normal) const {
+  const uint8_t* vertex = vertices_ + (size_t)index * header_.vertex_stride_;
+  int16_t encoded[2];
+  memcpy(encoded,
+         vertex + (IsQuantized() ? offsetof(MeshVertexQuantized, normal_)
+                                 : offsetof(MeshVertexFloat, normal_)),
+         sizeof(encoded));
+  mesh::OctDecode(encoded, normal);
+}
+
+uint16_t MeshData::GetIndex(const int32_t index) const {
+  uint16_t v;
+  memcpy(&v, indices_ + index * sizeof(uint16_t), sizeof(v));
+  return v;
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_H_
+#define MESH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Binary mesh format
+ * A mesh ready for glBufferData(): the header, interleaved vertices and 16 bit
+ * triangle list indices, little endian. Files are written offline (see
+ * Teapot/tools/meshTool) so loading is a validation and two uploads.
+ *
+ * Vertex layouts:
+ *  MESH_FLAG_QUANTIZED_POSITIONS set: MeshVertexQuantized, 12 bytes
+ *  otherwise: MeshVertexFloat, 16 bytes
+ *
+ * Quantized positions are unorm16 over the AABB: with GL_UNSIGNED_SHORT,
+ * normalized, the vertex shader gets p in [0,1] and
+ * position = p * GetPositionScale() + GetPositionBias().
+ *
+ * Normals are octahedral encoded in two snorm16 (GL_SHORT, normalized),
+ * see mesh::OctDecode(). ES2 and ES3 normalize snorm slightly differently;
+ * the difference (< 2^-15) is below the encoding error.
+ */
+const uint32_t MESH_MAGIC = 0x48534d4e;  // "NMSH"
+const uint32_t MESH_VERSION = 1;
+const uint32_t MESH_DATA_ALIGNMENT = 16;
+
+enum MESH_FLAG {
+  MESH_FLAG_QUANTIZED_POSITIONS = 1 << 0,
+};
+
+struct MeshHeader {
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t flags_;
+  uint32_t num_vertices_;
+  uint32_t num_indices_;
+  uint32_t vertex_stride_;
+  uint32_t vertex_offset_;  // From the start of the file
+  uint32_t index_offset_;
+  float aabb_min_[3];
+  float aabb_max_[3];
+};
+
+struct MeshVertexQuantized {
+  uint16_t pos_[4];  // pos_[3] is padding
+  int16_t normal_[2];
+};
+
+struct MeshVertexFloat {
+  float pos_[3];
+  int16_t normal_[2];
+};
+
+namespace mesh {
+
+/******************************************************************
+ * Octahedral normal encoding
+ * OctEncode() picks the rounding of the two components that decodes closest
+ * to n, so the error is the smallest the 32 bits allow.
+ */
+void OctEncode(const float* n, int16_t* encoded);
+void OctDecode(const int16_t* encoded, float* n);
+
+/******************************************************************
+ * Quantize v in [min, min + extent] to unorm16, and back
+ */
+uint16_t QuantizeUnorm16(const float v, const float min, const float extent);
+float DequantizeUnorm16(const uint16_t q, const float min, const float extent);
+
+/******************************************************************
+ * WriteMesh()
+ * Encode a mesh in the binary format
+ *
+ * arguments:
+ *  in: positions, num_vertices xyz
+ *  in: normals, num_vertices xyz, unit length
+ *  in: indices, triangle list
+ *  in: flags, MESH_FLAG_*
+ *  out: out, the file
+ * return: false if the mesh has more vertices than 16 bit indices address
+ *
+ */
+bool WriteMesh(const float* positions, const float* normals,
+               const int32_t num_vertices, const uint16_t* indices,
+               const int32_t num_indices, const uint32_t flags,
+               std::vector<uint8_t>* out);
+
+}  // namespace mesh
+
+/******************************************************************
+ * Read only view of a binary mesh
+ * Parse() validates the file and keeps pointers into it; the data must
+ * outlive the view. The data needs no alignment.
+ */
+class MeshData {
+ private:
+  MeshHeader header_;
+  const uint8_t* vertices_;
+  const uint8_t* indices_;
+
+ public:
+  MeshData();
+
+  bool Parse(const uint8_t* data, const size_t size);
+
+  bool IsQuantized() const {
+    return (header_.flags_ & MESH_FLAG_QUANTIZED_POSITIONS) != 0;
+  }
+  int32_t GetNumVertices() const { return header_.num_vertices_; }
+  int32_t GetNumIndices() const { return header_.num_indices_; }
+  int32_t GetVertexStride() const { return header_.vertex_stride_; }
+  const uint8_t* GetVertexData() const { return vertices_; }
+  size_t GetVertexDataSize() const {
+    return (size_t)header_.num_vertices_ * header_.vertex_stride_;
+  }
+  const uint8_t* GetIndexData() const { return indices_; }
+  size_t GetIndexDataSize() const {
+    return (size_t)header_.num_indices_ * sizeof(uint16_t);
+  }
+  const float* GetAabbMin() const { return header_.aabb_min_; }
+  const float* GetAabbMax() const { return header_.aabb_max_; }
+
+  // Dequantization of the position attribute, identity if not quantized
+  void GetPositionScale(float* scale) const;
+  void GetPositionBias(float* bias) const;
+
+  // Decoded attributes, for CPU side use
+  void GetPosition(const int32_t index, float* position) const;
+  void GetNormal(const int32_t index, float* normal) const;
+  uint16_t GetIndex(const int32_t index) const;
+};
+
+}  // namespace ndkHelper
+#endif /* MESH_H_ */
@@ -16,8 +16,70 @@
 
 #include "perfMonitor.h"
 
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <vector>
+
 namespace ndk_helper {
 
+//--------------------------------------------------------------------------------
+// FrameHistogram
+//--------------------------------------------------------------------------------
+void FrameHistogram::Reset() {
+  for (int32_t i = 0; i < HISTOGRAM_BUCKETS; ++i) buckets_[i] = 0;
+  count_ = 0;
+  max_ns_ = 0;
+}
+
+int32_t FrameHistogram::BucketIndex(int64_t us) {
+  if (us < 1) us = 1;
+  int32_t octave = 63 - __builtin_clzll(us);
+  if (octave >= HISTOGRAM_OCTAVES) return HISTOGRAM_BUCKETS - 1;
+  int64_t base = 1LL << octave;
+  int32_t sub = (int32_t)(((us - base) * HISTOGRAM_SUB_BUCKETS) >> octave);
+  return octave * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+int64_t FrameHistogram::BucketMidpointUs(int32_t index) {
+  int32_t octave = index / HISTOGRAM_SUB_BUCKETS;
+  int32_t sub = index % HISTOGRAM_SUB_BUCKETS;
+  double width = (double)(1LL << octave) / HISTOGRAM_SUB_BUCKETS;
+  return (int64_t)((1LL << octave) + width * (sub + 0.5));
+}
+
+void FrameHistogram::Record(int64_t duration_ns) {
+  buckets_[BucketIndex(duration_ns / 1000)]++;
+  count_++;
+  if (duration_ns > max_ns_) max_ns_ = duration_ns;
+}
+
+int64_t FrameHistogram::GetPercentileNs(float percentile) const {
+  if (count_ == 0) return 0;
+
+  // Rank of the sample we are after, 1 based
+  uint32_t rank = (uint32_t)ceil(percentile / 100.f * count_);
+  if (rank < 1) rank = 1;
+  if (rank >= count_) return max_ns_;
+
+  uint32_t seen = 0;
+  for (int32_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      int64_t ns = BucketMidpointUs(i) * 1000;
+      return ns < max_ns_ ? ns : max_ns_;
+    }
+  }
+  return max_ns_;
+}
+
+//--------------------------------------------------------------------------------
+// PerfMonitor
+//--------------------------------------------------------------------------------
 PerfMonitor::PerfMonitor() {
   for (int32_t i = 0; i < NUM_SAMPLES; ++i) ticklist_[i] = 0;
 }
@@ -34,17 +96,20 @@ double PerfMonitor::UpdateTick(double currentTick) {
 }
 
 bool PerfMonitor::Update(float &fFPS) {
-  struct timeval Time;
-  gettimeofday(&Time, NULL);
+  int64_t time = GetCurrentTimeNs();
+  int64_t tick = time - last_tick_ns_;
+  double d = UpdateTick(tick / 1000000000.0);
 
-  double time = Time.tv_sec + Time.tv_usec * 1.0 / 1000000.0;
-  double tick = time - last_tick_;
-  double d = UpdateTick(tick);
-  last_tick_ = time;
+  last_interval_ns_ = last_tick_ns_ ? tick : 0;
+  if (last_tick_ns_ && tick < MAX_FRAME_INTERVAL_NS) {
+    histogram_.Record(tick);
+    if (tick > target_frame_ns_ * JANK_THRESHOLD) jank_count_++;
+  }
+  last_tick_ns_ = time;
 
-  if (Time.tv_sec - tv_last_sec_ >= 1) {
+  if (time - last_report_ns_ >= 1000000000LL) {
     current_FPS_ = 1.f / d;
-    tv_last_sec_ = Time.tv_sec;
+    last_report_ns_ = time;
     fFPS = current_FPS_;
     return true;
   } else {
@@ -53,4 +118,225 @@ bool PerfMonitor::Update(float &fFPS) {
   }
 }
 
+void PerfMonitor::LogStats() const {
+  LOGI("Frame time p50 %.2fms p90 %.2fms p99 %.2fms max %.2fms, %u/%u janky",
+       histogram_.GetPercentileNs(50.f) / 1000000.0,
+       histogram_.GetPercentileNs(90.f) / 1000000.0,
+       histogram_.GetPercentileNs(99.f) / 1000000.0,
+       histogram_.GetMaxNs() / 1000000.0, jank_count_, histogram_.GetCount());
+}
+
+//--------------------------------------------------------------------------------
+// Frame cost
+//--------------------------------------------------------------------------------
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace {
+
+// GL_EXT_disjoint_timer_query entry points, the same for every context
+typedef void(GL_APIENTRY *GenQueriesFunc)(GLsizei, GLuint *);
+typedef void(GL_APIENTRY *BeginQueryFunc)(GLenum, GLuint);
+typedef void(GL_APIENTRY *EndQueryFunc)(GLenum);
+typedef void(GL_APIENTRY *GetQueryObjectuivFunc)(GLuint, GLenum, GLuint *);
+typedef void(GL_APIENTRY *GetQueryObjectui64vFunc)(GLuint, GLenum,
+                                                    uint64_t *);
+GenQueriesFunc gen_queries = nullptr;
+BeginQueryFunc begin_query = nullptr;
+EndQueryFunc end_query = nullptr;
+GetQueryObjectuivFunc get_query_objectuiv = nullptr;
+GetQueryObjectui64vFunc get_query_objectui64v = nullptr;
+
+}  // namespace
+
+bool PerfMonitor::InitGpuTimer() {
+  const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+  if (extensions && strstr(extensions, "GL_EXT_disjoint_timer_query")) {
+    gen_queries = (GenQueriesFunc)eglGetProcAddress("glGenQueriesEXT");
+    begin_query = (BeginQueryFunc)eglGetProcAddress("glBeginQueryEXT");
+    end_query = (EndQueryFunc)eglGetProcAddress("glEndQueryEXT");
+    get_query_objectuiv =
+        (GetQueryObjectuivFunc)eglGetProcAddress("glGetQueryObjectuivEXT");
+    get_query_objectui64v =
+        (GetQueryObjectui64vFunc)eglGetProcAddress("glGetQueryObjectui64vEXT");
+  }
+  if (!gen_queries || !begin_query || !end_query || !get_query_objectuiv ||
+      !get_query_objectui64v) {
+    LOGI("GPU timer queries not supported, frame cost is CPU time only");
+    return false;
+  }
+
+  gen_queries(GPU_TIMER_QUERIES, gpu_queries_);
+  gpu_query_next_ = 0;
+  gpu_query_pending_ = 0;
+  // Clear the disjoint flag; it is set from context creation on
+  GLint disjoint;
+  glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+  return true;
+}
+
+void PerfMonitor::ReadGpuTimer() {
+  // Oldest query first; a query is never read before it is available, so
+  // this does not stall the pipeline
+  while (gpu_query_pending_) {
+    int32_t index = (gpu_query_next_ - gpu_query_pending_ + GPU_TIMER_QUERIES) %
+                    GPU_TIMER_QUERIES;
+    GLuint available = 0;
+    get_query_objectuiv(gpu_queries_[index], GL_QUERY_RESULT_AVAILABLE_EXT,
+                        &available);
+    if (!available) break;
+
+    uint64_t elapsed = 0;
+    get_query_objectui64v(gpu_queries_[index], GL_QUERY_RESULT_EXT, &elapsed);
+    gpu_query_pending_--;
+
+    // A disjoint operation (e.g. a GPU frequency change) makes the results
+    // of the queries in flight meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (!disjoint) gpu_frame_ns_ = (int64_t)elapsed;
+  }
+}
+
+void PerfMonitor::BeginFrameWork() {
+  work_begin_ns_ = GetCurrentTimeNs();
+  if (gpu_timer_state_ == GPU_TIMER_UNKNOWN)
+    gpu_timer_state_ = InitGpuTimer() ? GPU_TIMER_READY : GPU_TIMER_UNSUPPORTED;
+  if (gpu_timer_state_ != GPU_TIMER_READY) return;
+
+  ReadGpuTimer();
+  // All queries still in flight: this frame goes untimed
+  if (gpu_query_pending_ == GPU_TIMER_QUERIES) return;
+  begin_query(GL_TIME_ELAPSED_EXT, gpu_queries_[gpu_query_next_]);
+  gpu_query_active_ = true;
+}
+
+void PerfMonitor::EndFrameWork() {
+  if (gpu_query_active_) {
+    end_query(GL_TIME_ELAPSED_EXT);
+    gpu_query_next_ = (gpu_query_next_ + 1) % GPU_TIMER_QUERIES;
+    gpu_query_pending_++;
+    gpu_query_active_ = false;
+  }
+  if (work_begin_ns_) cpu_frame_ns_ = GetCurrentTimeNs() - work_begin_ns_;
+}
+
+void PerfMonitor::InvalidateGpuTimer() {
+  // The queries went with the context; new ones are made on the next frame
+  gpu_timer_state_ = GPU_TIMER_UNKNOWN;
+  gpu_query_pending_ = 0;
+  gpu_query_active_ = false;
+  gpu_frame_ns_ = 0;
+}
+
+//--------------------------------------------------------------------------------
+// TraceRecorder
+//--------------------------------------------------------------------------------
+namespace {
+
+struct TraceBuffer {
+  TraceEvent events[TRACE_BUFFER_EVENTS];
+  // Total number of events ever written; the slot for event n is
+  // n % TRACE_BUFFER_EVENTS
+  std::atomic<uint32_t> written;
+  int32_t tid;
+  TraceBuffer *next;
+};
+
+// Buffers are only ever added to this list, never removed
+std::atomic<TraceBuffer *> g_trace_buffers(nullptr);
+std::atomic<bool> g_trace_enabled(false);
+__thread TraceBuffer *t_trace_buffer = nullptr;
+
+TraceBuffer *GetThreadBuffer() {
+  if (t_trace_buffer == nullptr) {
+    TraceBuffer *buffer = new TraceBuffer();
+    buffer->written.store(0, std::memory_order_relaxed);
+    buffer->tid = (int32_t)syscall(__NR_gettid);
+    buffer->next = g_trace_buffers.load(std::memory_order_relaxed);
+    while (!g_trace_buffers.compare_exchange_weak(buffer->next, buffer,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+    }
+    t_trace_buffer = buffer;
+  }
+  return t_trace_buffer;
+}
+
+}  // namespace
+
+void TraceRecorder::SetEnabled(bool enabled) {
+  g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TraceRecorder::IsEnabled() {
+  return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::Record(const char *name, int64_t begin_ns, int64_t end_ns) {
+  TraceBuffer *buffer = GetThreadBuffer();
+  uint32_t index = buffer->written.load(std::memory_order_relaxed);
+  TraceEvent &event = buffer->events[index % TRACE_BUFFER_EVENTS];
+  event.name = name;
+  event.begin_ns = begin_ns;
+  event.duration_ns = end_ns - begin_ns;
+  buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::ExportChromeJson(const char *file_name) {
+  FILE *f = fopen(file_name, "w");
+  if (!f) {
+    LOGE("Can't open %s to write trace", file_name);
+    return false;
+  }
+
+  int32_t pid = (int32_t)getpid();
+  int32_t exported = 0;
+  std::vector<TraceEvent> events;
+  events.reserve(TRACE_BUFFER_EVENTS);
+
+  fprintf(f, "{\"traceEvents\":[");
+  for (TraceBuffer *buffer = g_trace_buffers.load(std::memory_order_acquire);
+       buffer != nullptr; buffer = buffer->next) {
+    // Copy first, then check how far the owner thread got in the meantime;
+    // anything it may have overwritten is dropped (seqlock style)
+    uint32_t end = buffer->written.load(std::memory_order_acquire);
+    uint32_t begin = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+    events.clear();
+    for (uint32_t i = begin; i < end; ++i)
+      events.push_back(buffer->events[i % TRACE_BUFFER_EVENTS]);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t now = buffer->written.load(std::memory_order_relaxed);
+    uint32_t first_valid =
+        now >= TRACE_BUFFER_EVENTS ? now - TRACE_BUFFER_EVENTS + 1 : 0;
+
+    for (uint32_t i = begin; i < end; ++i) {
+      if (i < first_valid) continue;
+      const TraceEvent &event = events[i - begin];
+      fprintf(f,
+              "%s\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":%d,"
+              "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+              exported ? "," : "", event.name, pid, buffer->tid,
+              event.begin_ns / 1000.0, event.duration_ns / 1000.0);
+      exported++;
+    }
+  }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  bool success = !ferror(f);
+  if (fclose(f) != 0) success = false;
+  LOGI("Exported %d trace events to %s", exported, file_name);
+  return success;
+}
+
 }  // namespace ndkHelper
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// resolutionController.cpp
+//--------------------------------------------------------------------------------
+#include "resolutionController.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace ndk_helper {
+
+// Above this part of the target the scale goes down; above the second, by
+// two steps
+const double RESOLUTION_HIGH_LOAD = 0.9;
+const double RESOLUTION_FAR_LOAD = 1.2;
+// The scale goes up when the cost at the next size would stay under this
+// part of the target for RESOLUTION_HEADROOM_WINDOWS windows in a row
+const double RESOLUTION_LOW_LOAD = 0.75;
+const int32_t RESOLUTION_HEADROOM_WINDOWS = 4;
+// Frames before the scale may go back up to a size it left
+const int32_t RESOLUTION_CEILING_FRAMES = 600;
+// Intervals over this many target frames are missed vsyncs; over
+// RESOLUTION_MAX_INTERVAL_NS they are pauses, not frames
+const double RESOLUTION_MISSED_FRAME = 1.5;
+const int64_t RESOLUTION_MAX_INTERVAL_NS = 1000000000LL;
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ResolutionController::ResolutionController()
+    : target_frame_ns_(1000000000LL / 60), max_level_(0), level_(0) {
+  SetMinScale(0.5f);
+  Reset();
+}
+
+int32_t ResolutionController::ScaleLevel(const float scale) {
+  const int32_t limit = (int32_t)(1.f / RESOLUTION_SCALE_STEP + 0.5f) - 1;
+  int32_t level = (int32_t)floorf((1.f - scale) / RESOLUTION_SCALE_STEP + 0.5f);
+  return std::min(std::max(level, 0), limit);
+}
+
+void ResolutionController::SetMinScale(const float scale) {
+  max_level_ = ScaleLevel(scale);
+  if (level_ > max_level_) SetLevel(max_level_);
+}
+
+void ResolutionController::HoldScale(const float scale) {
+  max_level_ = ScaleLevel(scale);
+  // A ceiling with no frames left to count never lifts
+  ceiling_level_ = max_level_;
+  ceiling_frames_ = 0;
+  SetLevel(max_level_);
+}
+
+void ResolutionController::Reset() {
+  level_ = 0;
+  ceiling_level_ = 0;
+  ceiling_frames_ = 0;
+  settle_frames_ = 0;
+  headroom_windows_ = 0;
+  cost_count_ = 0;
+}
+
+void ResolutionController::SetLevel(const int32_t level) {
+  level_ = level;
+  // Costs measured at the old size say little about the new one
+  settle_frames_ = RESOLUTION_SETTLE_FRAMES;
+  cost_count_ = 0;
+  headroom_windows_ = 0;
+}
+
+//--------------------------------------------------------------------------------
+// Control
+//--------------------------------------------------------------------------------
+bool ResolutionController::Update(const int64_t cost_ns,
+                                  const int64_t interval_ns) {
+  if (ceiling_frames_ && --ceiling_frames_ == 0) ceiling_level_ = 0;
+  if (settle_frames_) {
+    --settle_frames_;
+    return false;
+  }
+
+  int64_t cost = cost_ns;
+  if (interval_ns > target_frame_ns_ * RESOLUTION_MISSED_FRAME &&
+      interval_ns < RESOLUTION_MAX_INTERVAL_NS) {
+    // The frame missed its vsync: whatever the timers say, it cost too much
+    cost = std::max(cost, interval_ns);
+  }
+  costs_[cost_count_++] = cost;
+  if (cost_count_ < RESOLUTION_WINDOW_FRAMES) return false;
+  return Decide();
+}
+
+bool ResolutionController::Decide() {
+  const int32_t index = cost_count_ * 9 / 10;
+  std::nth_element(costs_, costs_ + index, costs_ + cost_count_);
+  const double load = (double)costs_[index] / target_frame_ns_;
+  cost_count_ = 0;
+
+  if (load > RESOLUTION_HIGH_LOAD) {
+    const int32_t steps = load > RESOLUTION_FAR_LOAD ? 2 : 1;
+    const int32_t level = std::min(level_ + steps, max_level_);
+    headroom_windows_ = 0;
+    if (level == level_) return false;
+    // Stay below the size that was too slow for a while
+    ceiling_level_ = level_ + 1;
+    ceiling_frames_ = RESOLUTION_CEILING_FRAMES;
+    SetLevel(level);
+    return true;
+  }
+
+  if (level_ > ceiling_level_) {
+    const double area = LevelScale(level_ - 1) / LevelScale(level_);
+    if (load * area * area < RESOLUTION_LOW_LOAD) {
+      if (++headroom_windows_ >= RESOLUTION_HEADROOM_WINDOWS) {
+        SetLevel(level_ - 1);
+        return true;
+      }
+      return false;
+    }
+  }
+  headroom_windows_ = 0;
+  return false;
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// resourceLoader.cpp
+//--------------------------------------------------------------------------------
+#include "resourceLoader.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ResourceLoader::ResourceLoader(LoaderBackend* backend)
+    : backend_(backend),
+      pending_(0),
+      thread_failed_(false),
+      quit_(false),
+      thread_started_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+  if (backend_) {
+    // The thread may set thread_failed_ itself as soon as it runs
+    if (pthread_create(&thread_, NULL, LoaderThread, this) == 0)
+      thread_started_ = true;
+    else
+      thread_failed_ = true;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+ResourceLoader::~ResourceLoader() {
+  if (thread_started_) {
+    // The task being loaded, if any, runs to its end
+    pthread_mutex_lock(&mutex_);
+    quit_ = true;
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    pthread_join(thread_, NULL);
+  }
+
+  for (size_t i = 0; i < loaded_.size(); ++i)
+    if (loaded_[i].fence_) backend_->DeleteFence(loaded_[i].fence_);
+  delete backend_;
+
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+//--------------------------------------------------------------------------------
+// Loader thread
+//--------------------------------------------------------------------------------
+void* ResourceLoader::LoaderThread(void* param) {
+  static_cast<ResourceLoader*>(param)->Work();
+  return NULL;
+}
+
+void ResourceLoader::Work() {
+  const bool current = backend_->MakeCurrent();
+  pthread_mutex_lock(&mutex_);
+  if (!current) {
+    // Update() and Finish() load the tasks on the GL thread instead
+    thread_failed_ = true;
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    return;
+  }
+
+  for (;;) {
+    while (!quit_ && tasks_.empty()) pthread_cond_wait(&cond_, &mutex_);
+    if (quit_) break;
+    Task task = tasks_.front();
+    tasks_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+
+    task.succeeded_ = task.load_(task.data_);
+    task.fence_ = backend_->CreateFence();
+
+    pthread_mutex_lock(&mutex_);
+    loaded_.push_back(task);
+    pthread_cond_broadcast(&cond_);
+  }
+  pthread_mutex_unlock(&mutex_);
+  backend_->ReleaseCurrent();
+}
+
+//--------------------------------------------------------------------------------
+// GL thread
+//--------------------------------------------------------------------------------
+void ResourceLoader::Submit(LoadFunction load, CommitFunction commit,
+                            void* data) {
+  if (!backend_) {
+    commit(data, load(data));
+    return;
+  }
+
+  Task task;
+  task.load_ = load;
+  task.commit_ = commit;
+  task.data_ = data;
+  task.succeeded_ = false;
+  task.fence_ = NULL;
+  ++pending_;
+
+  pthread_mutex_lock(&mutex_);
+  tasks_.push_back(task);
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+void ResourceLoader::Commit(const Task& task) {
+  if (task.fence_) backend_->DeleteFence(task.fence_);
+  --pending_;
+  task.commit_(task.data_, task.succeeded_);
+}
+
+bool ResourceLoader::LoadInline() {
+  pthread_mutex_lock(&mutex_);
+  if (!thread_failed_ || tasks_.empty()) {
+    pthread_mutex_unlock(&mutex_);
+    return false;
+  }
+  Task task = tasks_.front();
+  tasks_.pop_front();
+  pthread_mutex_unlock(&mutex_);
+
+  task.succeeded_ = task.load_(task.data_);
+  task.fence_ = NULL;
+  Commit(task);
+  return true;
+}
+
+int32_t ResourceLoader::Update() {
+  int32_t committed = 0;
+  while (pending_) {
+    // Only this thread pops loaded_, so its front stays put while unlocked
+    pthread_mutex_lock(&mutex_);
+    const bool empty = loaded_.empty();
+    Task task;
+    if (!empty) task = loaded_.front();
+    pthread_mutex_unlock(&mutex_);
+
+    if (empty) {
+      if (!LoadInline()) break;
+    } else {
+      if (task.fence_ && !backend_->IsFenceSignaled(task.fence_)) break;
+      pthread_mutex_lock(&mutex_);
+      loaded_.pop_front();
+      pthread_mutex_unlock(&mutex_);
+      Commit(task);
+    }
+    ++committed;
+  }
+  return committed;
+}
+
+void ResourceLoader::Finish() {
+  while (pending_) {
+    pthread_mutex_lock(&mutex_);
+    // A pending task is queued, being loaded or loaded
+    while (loaded_.empty() && !thread_failed_)
+      pthread_cond_wait(&cond_, &mutex_);
+    if (loaded_.empty()) {
+      pthread_mutex_unlock(&mutex_);
+      LoadInline();
+      continue;
+    }
+    Task task = loaded_.front();
+    loaded_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+
+    if (task.fence_) backend_->WaitFence(task.fence_);
+    Commit(task);
+  }
+}
+
+bool ResourceLoader::IsAsync() {
+  pthread_mutex_lock(&mutex_);
+  const bool async = backend_ && !thread_failed_;
+  pthread_mutex_unlock(&mutex_);
+  return async;
+}
+
+}  // namespace ndkHelper
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// streamBuffer.cpp
+//--------------------------------------------------------------------------------
+#include "streamBuffer.h"
+
+#include "gl3stub.h"
+#include "JNIHelper.h"
+
+namespace ndk_helper {
+
+namespace {
+
+// A frame's fence should signal within a few frames; a second means the GPU
+// hung and waiting longer will not help
+const GLuint64 STREAM_FENCE_TIMEOUT = 1000000000ull;
+
+}  // namespace
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+StreamBuffer::StreamBuffer()
+    : target_(GL_ARRAY_BUFFER), buffer_(0), offset_(0) {}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+StreamBuffer::~StreamBuffer() { Release(); }
+
+bool StreamBuffer::Init(const GLenum target, const size_t frame_size,
+                        const int32_t frames, const size_t alignment) {
+  Release();
+  // Every frame's range may start a whole alignment past the previous end,
+  // and one more frame of room covers what is skipped when a range does not
+  // fit before the end: then |frames| - 1 in flight never block Map()
+  const int32_t slots = (frames > 0 ? frames : 1) + 1;
+  const size_t size = (frame_size + alignment) * slots;
+  target_ = target;
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(target_, buffer_);
+  glBufferData(target_, size, NULL, GL_STREAM_DRAW);
+  if (glGetError() != GL_NO_ERROR) {
+    LOGI("Stream buffer of %zu bytes can not be created", size);
+    Release();
+    return false;
+  }
+  ring_.Init(size, alignment);
+  return true;
+}
+
+void StreamBuffer::Release() {
+  // Delete the fences of the frames still in flight
+  while (ring_.GetFramesInFlight()) {
+    GLsync fence = static_cast<GLsync>(ring_.RetireOldest());
+    if (fence) glDeleteSync(fence);
+  }
+  ring_.Init(0, 1);
+  if (buffer_) {
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Fences
+//--------------------------------------------------------------------------------
+void StreamBuffer::Retire(const bool wait) {
+  while (ring_.GetFramesInFlight()) {
+    GLsync fence = static_cast<GLsync>(ring_.GetOldestFence());
+    if (fence) {
+      GLenum result =
+          glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                           wait ? STREAM_FENCE_TIMEOUT : 0);
+      if (result == GL_TIMEOUT_EXPIRED) return;
+      // GL_WAIT_FAILED too: the fence is gone, so is the reason to wait
+      glDeleteSync(fence);
+    }
+    ring_.RetireOldest();
+    if (wait) return;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Map
+//--------------------------------------------------------------------------------
+void* StreamBuffer::Map(const size_t size) {
+  if (!buffer_) return NULL;
+
+  Retire(false);
+  size_t offset = ring_.Allocate(size);
+  while (offset == RING_ALLOCATION_FAILED && ring_.GetFramesInFlight()) {
+    // Every range is in flight: wait for the oldest frame only
+    const int32_t in_flight = ring_.GetFramesInFlight();
+    Retire(true);
+    if (ring_.GetFramesInFlight() == in_flight) {
+      LOGI("Stream buffer fence timed out");
+      return NULL;
+    }
+    offset = ring_.Allocate(size);
+  }
+  if (offset == RING_ALLOCATION_FAILED) return NULL;
+
+  offset_ = offset;
+  glBindBuffer(target_, buffer_);
+  void* p = glMapBufferRange(target_, offset, size,
+                             GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                 GL_MAP_INVALIDATE_RANGE_BIT |
+                                 GL_MAP_FLUSH_EXPLICIT_BIT);
+  if (p == NULL) ring_.Shrink(0);
+  return p;
+}
+
+bool StreamBuffer::Unmap(const size_t size) {
+  glBindBuffer(target_, buffer_);
+  // Relative to the mapped range
+  if (size) glFlushMappedBufferRange(target_, 0, size);
+  ring_.Shrink(size);
+  return glUnmapBuffer(target_) == GL_TRUE;
+}
+
+void StreamBuffer::EndFrame() {
+  if (!buffer_) return;
+  ring_.EndFrame(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+}  // namespace ndkHelper
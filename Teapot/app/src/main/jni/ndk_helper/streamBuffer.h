@@ -0,0 +1,89 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STREAM_BUFFER_H_
+#define STREAM_BUFFER_H_
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "ringAllocator.h"
+
+namespace ndk_helper {
+
+// Frames of data a StreamBuffer holds by default: one being written, up to
+// two queued or being drawn
+const int32_t STREAM_BUFFER_FRAMES = 3;
+
+/******************************************************************
+ * Buffer object for data rewritten every frame (GLES3)
+ * Map() returns a range of a persistent ring that no frame in flight uses,
+ * mapped with GL_MAP_UNSYNCHRONIZED_BIT, so the driver neither waits for
+ * the GPU nor reallocates the buffer behind the scenes. EndFrame() puts a
+ * fence after the frame's draws; the ring reuses a frame's ranges once its
+ * fence has signaled. Map() only blocks when all |frames| are in flight.
+ *
+ * Usage:
+ *  void* p = stream.Map(max_bytes);  // Binds the buffer to its target
+ *  ...write...
+ *  stream.Unmap(written_bytes);
+ *  glVertexAttribPointer(..., BUFFER_OFFSET(stream.GetOffset()));
+ *  ...draw...
+ *  stream.EndFrame();
+ *
+ * Create it with the GL context current, after GLContext::Init().
+ */
+class StreamBuffer {
+ private:
+  GLenum target_;
+  GLuint buffer_;
+  RingAllocator ring_;
+  size_t offset_;
+
+  void Retire(const bool wait);
+
+  StreamBuffer(const StreamBuffer&);
+  void operator=(const StreamBuffer&);
+
+ public:
+  StreamBuffer();
+  ~StreamBuffer();
+
+  /*
+   * arguments:
+   * in: target, e.g. GL_ARRAY_BUFFER
+   * in: frame_size, bytes a frame maps at most
+   * in: frames, frames the buffer holds
+   * in: alignment, of the mapped ranges' offsets, a power of two
+   * return: false if the buffer could not be created
+   */
+  bool Init(const GLenum target, const size_t frame_size,
+            const int32_t frames, const size_t alignment);
+  void Release();
+
+  // Map |size| bytes for writing, NULL on failure
+  void* Map(const size_t size);
+  // Flush the first |size| bytes written and unmap; the rest is given back
+  bool Unmap(const size_t size);
+  // Offset of the last mapped range in the buffer
+  size_t GetOffset() const { return offset_; }
+  GLuint GetBuffer() const { return buffer_; }
+
+  void EndFrame();
+};
+
+}  // namespace ndkHelper
+#endif /* STREAM_BUFFER_H_ */
@@ -27,10 +27,14 @@ namespace ndk_helper {
 const float TRANSFORM_FACTOR = 15.f;
 const float TRANSFORM_FACTORZ = 10.f;
 
+// Momentum decays by these factors every 1/60s and stops once the rotation
+// is below the threshold
+const float MOMENTUM_FRAME_TIME = 1.f / 60.f;
 const float MOMENTUM_FACTOR_DECREASE = 0.85f;
 const float MOMENTUM_FACTOR_DECREASE_SHIFT = 0.9f;
-const float MOMENTUM_FACTOR = 0.8f;
 const float MOMENTUM_FACTOR_THRESHOLD = 0.001f;
+// Momentum starts at the release velocity times this
+const float MOMENTUM_GAIN = 2.2f;
 
 //----------------------------------------------------------
 //  Ctor
@@ -60,13 +64,14 @@ void TapCamera::InitParameters() {
 
   quat_ball_rot_ = Quaternion();
   quat_ball_now_ = Quaternion();
+  quat_ball_down_ = Quaternion();
   quat_ball_now_.ToMatrix(mat_rotation_);
   camera_rotation_ = 0.f;
 
-  vec_drag_delta_ = Vec2();
-  vec_offset_delta_ = Vec3();
-
+  dragging_ = false;
+  pinching_ = false;
   momentum_ = false;
+  input_.Reset();
 }
 
 //----------------------------------------------------------
@@ -74,35 +79,17 @@ void TapCamera::InitParameters() {
 //----------------------------------------------------------
 TapCamera::~TapCamera() {}
 
-void TapCamera::Update() {
-  if (momentum_) {
-    float momenttum_steps = momemtum_steps_;
-
-    // Momentum rotation
-    Vec2 v = vec_drag_delta_;
-    BeginDrag(Vec2());  // NOTE:This call reset _VDragDelta
-    Drag(v * vec_flip_);
-
-    // Momentum shift
-    vec_offset_ += vec_offset_delta_;
-
-    BallUpdate();
-    EndDrag();
-
-    // Decrease deltas
-    vec_drag_delta_ = v * MOMENTUM_FACTOR_DECREASE;
-    vec_offset_delta_ = vec_offset_delta_ * MOMENTUM_FACTOR_DECREASE_SHIFT;
-
-    // Count steps
-    momemtum_steps_ = momenttum_steps * MOMENTUM_FACTOR_DECREASE;
-    if (momemtum_steps_ < MOMENTUM_FACTOR_THRESHOLD) {
-      momentum_ = false;
-    }
-  } else {
-    vec_drag_delta_ *= MOMENTUM_FACTOR;
-    vec_offset_delta_ = vec_offset_delta_ * MOMENTUM_FACTOR;
-    BallUpdate();
+void TapCamera::Update(const double display_time) {
+  const double time = display_time - INPUT_RESAMPLE_LATENCY;
+  Vec2 pointers[INPUT_MAX_POINTERS];
+  if (pinching_) {
+    if (input_.Resample(time, pointers)) ApplyPinch(pointers[0], pointers[1]);
+  } else if (dragging_) {
+    if (input_.Resample(time, pointers)) vec_ball_now_ = pointers[0];
+  } else if (momentum_) {
+    UpdateMomentum(time);
   }
+  BallUpdate();
 
   Vec3 vec = vec_offset_ + vec_offset_now_;
   Vec3 vec_tmp(TRANSFORM_FACTOR, -TRANSFORM_FACTOR, TRANSFORM_FACTORZ);
@@ -112,6 +99,8 @@ void TapCamera::Update() {
   mat_transform_ = Mat4::Translation(vec);
 }
 
+void TapCamera::Update() { Update(PerfMonitor::GetCurrentTime()); }
+
 Mat4& TapCamera::GetRotationMatrix() { return mat_rotation_; }
 
 Mat4& TapCamera::GetTransformMatrix() { return mat_transform_; }
@@ -122,12 +111,63 @@ void TapCamera::Reset(const bool bAnimate) {
 }
 
 //----------------------------------------------------------
-// Drag control
+// Momentum
 //----------------------------------------------------------
-void TapCamera::BeginDrag(const Vec2& v) {
-  if (dragging_) EndDrag();
+void TapCamera::StartMomentum(const double time, const Vec2& ball_velocity,
+                              const Vec3& offset_velocity) {
+  // The ball turns by 2 * distance / radius around the axis normal to the drag
+  float speed = ball_velocity.Length();
+  momentum_angular_velocity_ = MOMENTUM_GAIN * 2.f * speed / ball_radius_;
+  if (speed > 0.f) {
+    float x, y;
+    Vec2 v = ball_velocity;
+    v.Value(x, y);
+    vec_momentum_axis_ = Vec3(-y / speed, x / speed, 0.f);
+  }
+  vec_offset_velocity_ = offset_velocity * MOMENTUM_GAIN;
+
+  momentum_start_ = time;
+  quat_momentum_start_ = quat_ball_now_;
+  vec_offset_start_ = vec_offset_;
+  momentum_ = momentum_angular_velocity_ > 0.f ||
+              vec_offset_velocity_.Length() > 0.f;
+}
 
-  if (pinching_) EndPinch();
+void TapCamera::UpdateMomentum(const double time) {
+  // Continuous versions of the per frame decay factors
+  const float decay = -logf(MOMENTUM_FACTOR_DECREASE) / MOMENTUM_FRAME_TIME;
+  const float decay_shift =
+      -logf(MOMENTUM_FACTOR_DECREASE_SHIFT) / MOMENTUM_FRAME_TIME;
+  const float duration = -logf(MOMENTUM_FACTOR_THRESHOLD) / decay;
+
+  // The pose is a function of the time since the release only, so it does
+  // not depend on how many frames were drawn in between
+  float t = (float)(time - momentum_start_);
+  if (t < 0.f) t = 0.f;
+  if (t >= duration) {
+    t = duration;
+    momentum_ = false;
+  }
+
+  // Integral of v * exp(-decay * t)
+  float angle =
+      momentum_angular_velocity_ * (1.f - expf(-decay * t)) / decay;
+  quat_ball_now_ = Quaternion::RotationAxis(vec_momentum_axis_, angle) *
+                   quat_momentum_start_;
+  quat_ball_down_ = quat_ball_now_;
+  vec_offset_ = vec_offset_start_ +
+                vec_offset_velocity_ *
+                    ((1.f - expf(-decay_shift * t)) / decay_shift);
+}
+
+//----------------------------------------------------------
+// Drag control
+//----------------------------------------------------------
+void TapCamera::BeginDrag(const Vec2& v, const double time) {
+  if (pinching_)
+    EndPinch(time);
+  else if (dragging_)
+    EndDrag(time);
 
   Vec2 vec = v * vec_flip_;
   vec_ball_now_ = vec;
@@ -135,38 +175,55 @@ void TapCamera::BeginDrag(const Vec2& v) {
 
   dragging_ = true;
   momentum_ = false;
-  vec_last_input_ = vec;
-  vec_drag_delta_ = Vec2();
+  input_.Reset();
+  input_.AddSample(time, &vec, 1);
 }
 
-void TapCamera::EndDrag() {
+void TapCamera::EndDrag(const double time) {
+  Vec2 velocity;
+  Vec2 pointers[INPUT_MAX_POINTERS];
+  if (dragging_ && input_.GetLastSample(pointers)) {
+    // Stop at the release position, not at the last resampled one
+    vec_ball_now_ = pointers[0];
+    BallUpdate();
+    velocity = input_.GetVelocity(0, time);
+  }
+
   quat_ball_down_ = quat_ball_now_;
   quat_ball_rot_ = Quaternion();
 
   dragging_ = false;
-  momentum_ = true;
-  momemtum_steps_ = 1.0f;
+  StartMomentum(time, velocity, Vec3());
 }
 
-void TapCamera::Drag(const Vec2& v) {
+void TapCamera::Drag(const Vec2& v, const double time) {
   if (!dragging_) return;
 
   Vec2 vec = v * vec_flip_;
-  vec_ball_now_ = vec;
+  input_.AddSample(time, &vec, 1);
+}
 
-  vec_drag_delta_ = vec_drag_delta_ * MOMENTUM_FACTOR + (vec - vec_last_input_);
-  vec_last_input_ = vec;
+void TapCamera::BeginDrag(const Vec2& v) {
+  BeginDrag(v, PerfMonitor::GetCurrentTime());
 }
 
+void TapCamera::EndDrag() { EndDrag(PerfMonitor::GetCurrentTime()); }
+
+void TapCamera::Drag(const Vec2& v) { Drag(v, PerfMonitor::GetCurrentTime()); }
+
 //----------------------------------------------------------
 // Pinch controll
 //----------------------------------------------------------
-void TapCamera::BeginPinch(const Vec2& v1, const Vec2& v2) {
-  if (dragging_) EndDrag();
-
-  if (pinching_) EndPinch();
-
-  BeginDrag(Vec2());
+void TapCamera::BeginPinch(const Vec2& v1, const Vec2& v2, const double time) {
+  if (pinching_)
+    EndPinch(time);
+  else if (dragging_)
+    EndDrag(time);
+
+  // The trackball only applies the pinch rotation
+  vec_ball_now_ = Vec2();
+  vec_ball_down_ = Vec2();
+  dragging_ = true;
 
   vec_pinch_start_center_ = (v1 + v2) / 2.f;
 
@@ -182,29 +239,67 @@ void TapCamera::BeginPinch(const Vec2& v1, const Vec2& v2) {
   pinching_ = true;
   momentum_ = false;
 
-  // Init momentum factors
-  vec_offset_delta_ = Vec3();
+  Vec2 pointers[INPUT_MAX_POINTERS] = {v1, v2};
+  input_.Reset();
+  input_.AddSample(time, pointers, INPUT_MAX_POINTERS);
 }
 
-void TapCamera::EndPinch() {
+void TapCamera::EndPinch(const double time) {
+  Vec3 offset_velocity;
+  Vec2 p[INPUT_MAX_POINTERS];
+  if (pinching_ && input_.GetLastSample(p)) {
+    ApplyPinch(p[0], p[1]);
+    BallUpdate();
+
+    // Offset velocity from the pointer velocities, through the pinch mapping
+    Vec2 v1 = input_.GetVelocity(0, time);
+    Vec2 v2 = input_.GetVelocity(1, time);
+    Vec2 center_velocity = (v1 + v2) / 2.f;
+
+    float x_diff, y_diff, vx_diff, vy_diff;
+    (p[0] - p[1]).Value(x_diff, y_diff);
+    (v1 - v2).Value(vx_diff, vy_diff);
+    float distance_SQ = x_diff * x_diff + y_diff * y_diff;
+    float distance_SQ_velocity = 2.f * (x_diff * vx_diff + y_diff * vy_diff);
+    float f = pinch_start_distance_SQ_ / distance_SQ;
+    float df = f < 1.f ? -1.f / pinch_start_distance_SQ_
+                       : -f / distance_SQ;
+    float z_velocity = flip_z_ * df * distance_SQ_velocity;
+    if (isnan(z_velocity) || isinf(z_velocity)) z_velocity = 0.f;
+    offset_velocity = Vec3(center_velocity, z_velocity);
+  }
+
   pinching_ = false;
-  momentum_ = true;
-  momemtum_steps_ = 1.f;
   vec_offset_ += vec_offset_now_;
   camera_rotation_ += camera_rotation_now_;
   vec_offset_now_ = Vec3();
 
   camera_rotation_now_ = 0;
 
-  EndDrag();
+  quat_ball_down_ = quat_ball_now_;
+  quat_ball_rot_ = Quaternion();
+  dragging_ = false;
+  StartMomentum(time, Vec2(), offset_velocity);
 }
 
-void TapCamera::Pinch(const Vec2& v1, const Vec2& v2) {
+void TapCamera::Pinch(const Vec2& v1, const Vec2& v2, const double time) {
   if (!pinching_) return;
 
-  // Update momentum factor
-  vec_offset_last_ = vec_offset_now_;
+  Vec2 pointers[INPUT_MAX_POINTERS] = {v1, v2};
+  input_.AddSample(time, pointers, INPUT_MAX_POINTERS);
+}
 
+void TapCamera::BeginPinch(const Vec2& v1, const Vec2& v2) {
+  BeginPinch(v1, v2, PerfMonitor::GetCurrentTime());
+}
+
+void TapCamera::EndPinch() { EndPinch(PerfMonitor::GetCurrentTime()); }
+
+void TapCamera::Pinch(const Vec2& v1, const Vec2& v2) {
+  Pinch(v1, v2, PerfMonitor::GetCurrentTime());
+}
+
+void TapCamera::ApplyPinch(const Vec2& v1, const Vec2& v2) {
   float x_diff, y_diff;
   Vec2 vec = v1 - v2;
   vec.Value(x_diff, y_diff);
@@ -221,10 +316,6 @@ void TapCamera::Pinch(const Vec2& v1, const Vec2& v2) {
   vec = (v1 + v2) / 2.f - vec_pinch_start_center_;
   vec_offset_now_ = Vec3(vec, flip_z_ * f);
 
-  // Update momentum factor
-  vec_offset_delta_ = vec_offset_delta_ * MOMENTUM_FACTOR +
-                      (vec_offset_now_ - vec_offset_last_);
-
   //
   // Update ration quaternion
   float fRotation = atan2f(y_diff, x_diff);
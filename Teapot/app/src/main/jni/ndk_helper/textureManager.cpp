@@ -0,0 +1,239 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// textureManager.cpp
+//--------------------------------------------------------------------------------
+#include "textureManager.h"
+
+#include <algorithm>
+
+#include "assetCache.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+TextureManager::TextureManager(TextureBackend* backend,
+                               const int32_t num_threads)
+    : backend_(backend), placeholder_(0), pending_(0), quit_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+  for (int32_t i = 0; i < std::max(num_threads, 1); ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, WorkerThread, this) == 0)
+      threads_.push_back(thread);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+TextureManager::~TextureManager() {
+  pthread_mutex_lock(&mutex_);
+  quit_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  for (size_t i = 0; i < threads_.size(); ++i) pthread_join(threads_[i], NULL);
+
+  for (size_t i = 0; i < slots_.size(); ++i)
+    if (slots_[i].texture_) backend_->DeleteTexture(slots_[i].texture_);
+  if (placeholder_) backend_->DeleteTexture(placeholder_);
+  delete backend_;
+
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+//--------------------------------------------------------------------------------
+// Decode threads
+//--------------------------------------------------------------------------------
+void* TextureManager::WorkerThread(void* param) {
+  static_cast<TextureManager*>(param)->Work();
+  return NULL;
+}
+
+void TextureManager::Work() {
+  pthread_mutex_lock(&mutex_);
+  for (;;) {
+    while (!quit_ && jobs_.empty()) pthread_cond_wait(&cond_, &mutex_);
+    if (quit_) break;
+    Job job;
+    job.handle_ = jobs_.front().handle_;
+    job.file_name_.swap(jobs_.front().file_name_);
+    jobs_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+
+    // Read and decode without holding the lock
+    Image image;
+    AssetView view = AssetCache::GetInstance()->Open(job.file_name_.c_str());
+    bool succeeded =
+        view.IsValid() && DecodeImage(view.Data(), view.Size(), &image);
+
+    pthread_mutex_lock(&mutex_);
+    results_.push_back(Result());
+    Result& result = results_.back();
+    result.handle_ = job.handle_;
+    result.succeeded_ = succeeded;
+    std::swap(result.image_, image);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+//--------------------------------------------------------------------------------
+// Handles
+//--------------------------------------------------------------------------------
+int32_t TextureManager::Load(const char* file_name) {
+  int32_t handle;
+  if (free_slots_.size()) {
+    handle = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    handle = (int32_t)slots_.size();
+    slots_.push_back(Slot());
+  }
+  Slot& slot = slots_[handle];
+  slot.texture_ = 0;
+  slot.state_ = TEXTURE_STATE_LOADING;
+  slot.in_use_ = true;
+  slot.released_ = false;
+  slot.uploaded_rows_ = 0;
+  ++pending_;
+
+  pthread_mutex_lock(&mutex_);
+  jobs_.push_back(Job());
+  jobs_.back().handle_ = handle;
+  jobs_.back().file_name_ = file_name;
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  return handle;
+}
+
+void TextureManager::Release(const int32_t handle) {
+  if (!IsValidHandle(handle)) return;
+  Slot& slot = slots_[handle];
+  switch (slot.state_) {
+    case TEXTURE_STATE_LOADING:
+      // The slot is freed once its decode result comes back
+      slot.released_ = true;
+      --pending_;
+      return;
+    case TEXTURE_STATE_UPLOADING:
+      upload_queue_.erase(
+          std::find(upload_queue_.begin(), upload_queue_.end(), handle));
+      --pending_;
+      break;
+    default:
+      break;
+  }
+  FreeSlot(handle);
+}
+
+void TextureManager::FreeSlot(const int32_t handle) {
+  Slot& slot = slots_[handle];
+  if (slot.texture_) backend_->DeleteTexture(slot.texture_);
+  slot.texture_ = 0;
+  slot.in_use_ = false;
+  slot.released_ = false;
+  slot.image_ = Image();
+  free_slots_.push_back(handle);
+}
+
+bool TextureManager::IsValidHandle(const int32_t handle) const {
+  return handle >= 0 && handle < (int32_t)slots_.size() &&
+         slots_[handle].in_use_ && !slots_[handle].released_;
+}
+
+uint32_t TextureManager::GetTexture(const int32_t handle) {
+  if (IsValidHandle(handle) && slots_[handle].state_ == TEXTURE_STATE_READY)
+    return slots_[handle].texture_;
+  if (!placeholder_) placeholder_ = backend_->CreatePlaceholder();
+  return placeholder_;
+}
+
+TEXTURE_STATE TextureManager::GetState(const int32_t handle) const {
+  if (!IsValidHandle(handle)) return TEXTURE_STATE_FAILED;
+  return slots_[handle].state_;
+}
+
+//--------------------------------------------------------------------------------
+// Upload
+//--------------------------------------------------------------------------------
+size_t TextureManager::Update(const size_t byte_budget) {
+  if (!placeholder_) placeholder_ = backend_->CreatePlaceholder();
+
+  std::deque<Result> results;
+  pthread_mutex_lock(&mutex_);
+  results.swap(results_);
+  pthread_mutex_unlock(&mutex_);
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const int32_t handle = results[i].handle_;
+    Slot& slot = slots_[handle];
+    if (slot.released_) {
+      FreeSlot(handle);
+    } else if (!results[i].succeeded_) {
+      slot.state_ = TEXTURE_STATE_FAILED;
+      --pending_;
+    } else {
+      std::swap(slot.image_, results[i].image_);
+      slot.state_ = TEXTURE_STATE_UPLOADING;
+      upload_queue_.push_back(handle);
+    }
+  }
+
+  // Textures are finished one at a time, in the order they were decoded
+  size_t uploaded = 0;
+  while (upload_queue_.size()) {
+    Slot& slot = slots_[upload_queue_.front()];
+    const Image& image = slot.image_;
+    if (image.format_ == IMAGE_FORMAT_COMPRESSED) {
+      if (uploaded && uploaded + image.pixels_.size() > byte_budget) break;
+      slot.texture_ = backend_->CreateTexture(image);
+      uploaded += image.pixels_.size();
+    } else {
+      const size_t stride = image.Stride();
+      size_t rows =
+          uploaded < byte_budget ? (byte_budget - uploaded) / stride : 0;
+      if (!uploaded && !rows) rows = 1;
+      if (!rows) break;
+      rows = std::min(rows, (size_t)(image.height_ - slot.uploaded_rows_));
+
+      if (!slot.texture_) slot.texture_ = backend_->CreateTexture(image);
+      if (slot.texture_) {
+        backend_->UploadRows(slot.texture_, image, slot.uploaded_rows_,
+                             (int32_t)rows);
+        uploaded += rows * stride;
+        slot.uploaded_rows_ += (int32_t)rows;
+        if (slot.uploaded_rows_ < image.height_) break;
+      }
+    }
+
+    if (slot.texture_) {
+      backend_->FinishTexture(slot.texture_, image);
+      slot.state_ = TEXTURE_STATE_READY;
+    } else {
+      slot.state_ = TEXTURE_STATE_FAILED;
+    }
+    slot.image_ = Image();
+    --pending_;
+    upload_queue_.pop_front();
+  }
+  return uploaded;
+}
+
+}  // namespace ndkHelper
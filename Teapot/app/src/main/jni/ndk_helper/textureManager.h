@@ -0,0 +1,172 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEXTURE_MANAGER_H_
+#define TEXTURE_MANAGER_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "imageDecoder.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Texture upload interface of TextureManager
+ * GLTextureBackend is the OpenGL ES implementation. Another backend (e.g. one
+ * that only counts bytes) lets the decode and upload scheduling run without
+ * a GL context. Every call is made on the thread that calls
+ * TextureManager::Update().
+ */
+class TextureBackend {
+ public:
+  virtual ~TextureBackend() {}
+
+  // Texture shown until a texture is ready
+  virtual uint32_t CreatePlaceholder() = 0;
+  // Allocate storage for |image|. Compressed images are uploaded whole here.
+  virtual uint32_t CreateTexture(const Image& image) = 0;
+  // Upload |rows| rows of |image| from row |y|
+  virtual void UploadRows(const uint32_t texture, const Image& image,
+                          const int32_t y, const int32_t rows) = 0;
+  // Every row is uploaded: build mipmaps, set filters
+  virtual void FinishTexture(const uint32_t texture, const Image& image) = 0;
+  virtual void DeleteTexture(const uint32_t texture) = 0;
+};
+
+enum TEXTURE_STATE {
+  TEXTURE_STATE_LOADING,    // Queued or being decoded
+  TEXTURE_STATE_UPLOADING,  // Decoded, being uploaded by Update()
+  TEXTURE_STATE_READY,
+  TEXTURE_STATE_FAILED,     // The file could not be read or decoded
+};
+
+/******************************************************************
+ * Asynchronous texture loader
+ * Files are read through AssetCache and decoded on worker threads, then
+ * uploaded by Update() on the GL thread with a per frame byte budget, so
+ * loading textures never stalls a frame. Until its texture is ready a handle
+ * resolves to a 1x1 white placeholder.
+ *
+ * Usage, on the GL thread:
+ *  TextureManager textures(new GLTextureBackend(), 2);
+ *  int32_t handle = textures.Load("Textures/teapot.png");
+ *  // each frame
+ *  textures.Update(TEXTURE_UPLOAD_BUDGET);
+ *  glBindTexture(GL_TEXTURE_2D, textures.GetTexture(handle));
+ *
+ * Except for the constructor's worker threads, everything runs on the GL
+ * thread. Destroy the manager while the GL context is still current.
+ * The files stay in AssetCache once decoded; AssetCache::Trim() drops them.
+ */
+const size_t TEXTURE_UPLOAD_BUDGET = 512 * 1024;
+
+class TextureManager {
+ private:
+  struct Slot {
+    uint32_t texture_;
+    TEXTURE_STATE state_;
+    bool in_use_;
+    bool released_;  // Released while still loading
+    int32_t uploaded_rows_;
+    Image image_;
+  };
+
+  struct Job {
+    int32_t handle_;
+    std::string file_name_;
+  };
+
+  struct Result {
+    int32_t handle_;
+    bool succeeded_;
+    Image image_;
+  };
+
+  TextureBackend* backend_;
+  uint32_t placeholder_;
+
+  // GL thread only
+  std::vector<Slot> slots_;
+  std::vector<int32_t> free_slots_;
+  std::deque<int32_t> upload_queue_;
+  int32_t pending_;
+
+  // Shared with the workers, guarded by mutex_
+  std::deque<Job> jobs_;
+  std::deque<Result> results_;
+  bool quit_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  std::vector<pthread_t> threads_;
+
+  static void* WorkerThread(void* param);
+  void Work();
+  void FreeSlot(const int32_t handle);
+  bool IsValidHandle(const int32_t handle) const;
+
+  TextureManager(TextureManager const&);
+  void operator=(TextureManager const&);
+
+ public:
+  /*
+   * arguments:
+   * in: backend, owned by the manager
+   * in: num_threads, decode threads, at least 1
+   */
+  TextureManager(TextureBackend* backend, const int32_t num_threads);
+  ~TextureManager();
+
+  /*
+   * Queue a PNG or KTX file for loading
+   *
+   * arguments:
+   * in: file_name, file name given to AssetCache::Open()
+   * return: handle of the texture
+   */
+  int32_t Load(const char* file_name);
+
+  /*
+   * Release a texture. Its handle may be reused by a later Load().
+   */
+  void Release(const int32_t handle);
+
+  /*
+   * Collect decoded images and upload them
+   *
+   * arguments:
+   * in: byte_budget, bytes uploaded at most, except that every call uploads
+   *     at least one row (or one compressed image) while work is pending
+   * return: bytes uploaded
+   */
+  size_t Update(const size_t byte_budget);
+
+  /*
+   * return: the texture name, or the placeholder while not ready
+   */
+  uint32_t GetTexture(const int32_t handle);
+  TEXTURE_STATE GetState(const int32_t handle) const;
+
+  // Textures not ready yet, loading or uploading
+  int32_t GetPendingCount() const { return pending_; }
+};
+
+}  // namespace ndkHelper
+#endif /* TEXTURE_MANAGER_H_ */
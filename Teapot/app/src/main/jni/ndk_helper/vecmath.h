@@ -18,23 +18,46 @@
 #define VECMATH_H_
 
 #include <math.h>
-#include "JNIHelper.h"
+#include "logging.h"
+
+/******************************************************************
+ * SIMD selection
+ * Mat4 * Mat4, Mat4 * Vec4, Vec4 * Mat4 and Quaternion * Quaternion use
+ * NEON on ARM and SSE on x86 when the compiler targets them, and fall back
+ * to the plain C++ implementation otherwise (e.g. armeabi without NEON).
+ * Define VECMATH_NO_SIMD to force the scalar path.
+ */
+#if !defined(VECMATH_NO_SIMD) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define VECMATH_USE_NEON 1
+#include <arm_neon.h>
+#elif !defined(VECMATH_NO_SIMD) && (defined(__SSE__) || defined(__x86_64__))
+#define VECMATH_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// The 4-wide types keep their natural 4-byte alignment: they live in
+// std::vector and in heap-allocated objects, and operator new only promises 8
+// bytes on 32-bit Android. The SIMD code uses unaligned loads and stores
+// throughout.
 
 namespace ndk_helper {
 
 /******************************************************************
  * Helper class for vector math operations
- * Currently all implementations are in pure C++.
  * Each class is an opaque class so caller does not have a direct access
- * to each element. This is for an ease of future optimization to use vector
- *operations.
+ * to each element. This allows the hot paths to use vector operations
+ * (see SIMD selection above) without changing the interface.
  *
  */
 
 class Vec2;
 class Vec3;
 class Vec4;
+class Mat3;
 class Mat4;
+class Quaternion;
+class Vec4Array;
+class Mat4Array;
 
 /******************************************************************
  * 2 elements vector class
@@ -211,6 +234,7 @@ class Vec3 {
 
  public:
   friend class Vec4;
+  friend class Mat3;
   friend class Mat4;
   friend class Quaternion;
 
@@ -411,6 +435,7 @@ class Vec4 {
   friend class Vec3;
   friend class Mat4;
   friend class Quaternion;
+  friend class Vec4Array;
 
   Vec4() { x_ = y_ = z_ = w_ = 0.f; }
 
@@ -616,6 +641,59 @@ class Vec4 {
   }
 };
 
+/******************************************************************
+ * 3x3 matrix
+ * Mainly used for normal matrices (see Mat4::NormalMatrix()). Elements are
+ * column major, same as Mat4.
+ *
+ */
+class Mat3 {
+ private:
+  float f_[9];
+
+ public:
+  friend class Mat4;
+
+  Mat3() {
+    for (int32_t i = 0; i < 9; ++i) f_[i] = 0.f;
+  }
+
+  Mat3(const float* mIn) {
+    for (int32_t i = 0; i < 9; ++i) f_[i] = mIn[i];
+  }
+
+  Vec3 operator*(const Vec3& rhs) const {
+    Vec3 ret;
+    ret.x_ = rhs.x_ * f_[0] + rhs.y_ * f_[3] + rhs.z_ * f_[6];
+    ret.y_ = rhs.x_ * f_[1] + rhs.y_ * f_[4] + rhs.z_ * f_[7];
+    ret.z_ = rhs.x_ * f_[2] + rhs.y_ * f_[5] + rhs.z_ * f_[8];
+    return ret;
+  }
+
+  Mat3 Transpose() {
+    Mat3 ret;
+    for (int32_t col = 0; col < 3; ++col)
+      for (int32_t row = 0; row < 3; ++row)
+        ret.f_[col * 3 + row] = f_[row * 3 + col];
+    *this = ret;
+    return *this;
+  }
+
+  float* Ptr() { return f_; }
+
+  static Mat3 Identity() {
+    Mat3 ret;
+    ret.f_[0] = ret.f_[4] = ret.f_[8] = 1.f;
+    return ret;
+  }
+
+  void Dump() {
+    LOGI("%f %f %f", f_[0], f_[1], f_[2]);
+    LOGI("%f %f %f", f_[3], f_[4], f_[5]);
+    LOGI("%f %f %f", f_[6], f_[7], f_[8]);
+  }
+};
+
 /******************************************************************
  * 4x4 matrix
  *
@@ -628,6 +706,7 @@ class Mat4 {
   friend class Vec3;
   friend class Vec4;
   friend class Quaternion;
+  friend class Mat4Array;
 
   Mat4();
   Mat4(const float*);
@@ -666,44 +745,7 @@ class Mat4 {
   }
 
   Mat4& operator*=(const Mat4& rhs) {
-    Mat4 ret;
-    ret.f_[0] = f_[0] * rhs.f_[0] + f_[4] * rhs.f_[1] + f_[8] * rhs.f_[2] +
-                f_[12] * rhs.f_[3];
-    ret.f_[1] = f_[1] * rhs.f_[0] + f_[5] * rhs.f_[1] + f_[9] * rhs.f_[2] +
-                f_[13] * rhs.f_[3];
-    ret.f_[2] = f_[2] * rhs.f_[0] + f_[6] * rhs.f_[1] + f_[10] * rhs.f_[2] +
-                f_[14] * rhs.f_[3];
-    ret.f_[3] = f_[3] * rhs.f_[0] + f_[7] * rhs.f_[1] + f_[11] * rhs.f_[2] +
-                f_[15] * rhs.f_[3];
-
-    ret.f_[4] = f_[0] * rhs.f_[4] + f_[4] * rhs.f_[5] + f_[8] * rhs.f_[6] +
-                f_[12] * rhs.f_[7];
-    ret.f_[5] = f_[1] * rhs.f_[4] + f_[5] * rhs.f_[5] + f_[9] * rhs.f_[6] +
-                f_[13] * rhs.f_[7];
-    ret.f_[6] = f_[2] * rhs.f_[4] + f_[6] * rhs.f_[5] + f_[10] * rhs.f_[6] +
-                f_[14] * rhs.f_[7];
-    ret.f_[7] = f_[3] * rhs.f_[4] + f_[7] * rhs.f_[5] + f_[11] * rhs.f_[6] +
-                f_[15] * rhs.f_[7];
-
-    ret.f_[8] = f_[0] * rhs.f_[8] + f_[4] * rhs.f_[9] + f_[8] * rhs.f_[10] +
-                f_[12] * rhs.f_[11];
-    ret.f_[9] = f_[1] * rhs.f_[8] + f_[5] * rhs.f_[9] + f_[9] * rhs.f_[10] +
-                f_[13] * rhs.f_[11];
-    ret.f_[10] = f_[2] * rhs.f_[8] + f_[6] * rhs.f_[9] + f_[10] * rhs.f_[10] +
-                 f_[14] * rhs.f_[11];
-    ret.f_[11] = f_[3] * rhs.f_[8] + f_[7] * rhs.f_[9] + f_[11] * rhs.f_[10] +
-                 f_[15] * rhs.f_[11];
-
-    ret.f_[12] = f_[0] * rhs.f_[12] + f_[4] * rhs.f_[13] + f_[8] * rhs.f_[14] +
-                 f_[12] * rhs.f_[15];
-    ret.f_[13] = f_[1] * rhs.f_[12] + f_[5] * rhs.f_[13] + f_[9] * rhs.f_[14] +
-                 f_[13] * rhs.f_[15];
-    ret.f_[14] = f_[2] * rhs.f_[12] + f_[6] * rhs.f_[13] + f_[10] * rhs.f_[14] +
-                 f_[14] * rhs.f_[15];
-    ret.f_[15] = f_[3] * rhs.f_[12] + f_[7] * rhs.f_[13] + f_[11] * rhs.f_[14] +
-                 f_[15] * rhs.f_[15];
-
-    *this = ret;
+    *this = *this * rhs;
     return *this;
   }
 
@@ -729,8 +771,23 @@ class Mat4 {
     return *this;
   }
 
+  // Inverse of an affine matrix (rotation, scale and translation only); the
+  // bottom row is assumed to be (0, 0, 0, 1)
   Mat4 Inverse();
 
+  // Inverse of any non-singular matrix. Returns false and leaves |out|
+  // untouched if the matrix is singular.
+  bool InverseGeneral(Mat4& out) const;
+
+  // Inverse transpose of the upper 3x3, for transforming normals. If that part
+  // is singular the cofactor matrix is returned instead, which still maps
+  // normals to the right directions (up to length).
+  Mat3 NormalMatrix() const;
+
+  // Split an affine matrix into translation * rotation * scale. A mirroring
+  // matrix gets a negative x scale. Returns false if any axis has zero scale.
+  bool Decompose(Vec3& translation, Quaternion& rotation, Vec3& scale) const;
+
   Mat4 Transpose() {
     Mat4 ret;
     ret.f_[0] = f_[0];
@@ -850,22 +907,10 @@ class Quaternion {
     w_ = *p++;
   }
 
-  Quaternion operator*(const Quaternion rhs) {
-    Quaternion ret;
-    ret.x_ = x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_ + w_ * rhs.x_;
-    ret.y_ = -x_ * rhs.z_ + y_ * rhs.w_ + z_ * rhs.x_ + w_ * rhs.y_;
-    ret.z_ = x_ * rhs.y_ - y_ * rhs.x_ + z_ * rhs.w_ + w_ * rhs.z_;
-    ret.w_ = -x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_ + w_ * rhs.w_;
-    return ret;
-  }
+  Quaternion operator*(const Quaternion rhs);
 
   Quaternion& operator*=(const Quaternion rhs) {
-    Quaternion ret;
-    ret.x_ = x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_ + w_ * rhs.x_;
-    ret.y_ = -x_ * rhs.z_ + y_ * rhs.w_ + z_ * rhs.x_ + w_ * rhs.y_;
-    ret.z_ = x_ * rhs.y_ - y_ * rhs.x_ + z_ * rhs.w_ + w_ * rhs.z_;
-    ret.w_ = -x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_ + w_ * rhs.w_;
-    *this = ret;
+    *this = *this * rhs;
     return *this;
   }
 
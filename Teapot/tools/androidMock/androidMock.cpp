@@ -0,0 +1,1838 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// androidMock.cpp
+//--------------------------------------------------------------------------------
+#include "androidMock.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+#include <android/log.h>
+
+#include "JNIHelper.h"
+
+namespace android_mock {
+
+namespace {
+
+std::string g_asset_dir = ".";
+bool g_compressed_assets = false;
+bool g_verbose = false;
+std::map<std::string, int32_t> g_calls;
+// Asset calls come from any thread
+std::mutex g_calls_mutex;
+
+struct Shader {
+  GLenum type;
+  std::string source;
+  bool compiled;
+};
+
+struct Program {
+  std::vector<GLuint> shaders;
+  std::map<std::string, GLuint> bindings;
+  std::string binary;
+  bool retrievable;
+  std::map<std::string, GLint> locations;
+  std::map<GLint, std::vector<float> > uniforms;
+};
+
+struct Buffer {
+  std::vector<uint8_t> data;
+  bool mapped;
+  GLenum target;  // Last given data through
+  size_t map_length;
+  GLbitfield map_access;
+};
+
+// Bindings and errors are per context
+struct ContextState {
+  GLuint texture;  // GL_TEXTURE_2D
+  std::map<GLenum, GLuint> buffers;
+  GLint unpack_alignment;
+  GLenum error;
+  GLuint program;
+  VertexAttrib attribs[MOCK_MAX_VERTEX_ATTRIBS];
+  GLint viewport[4];
+};
+
+struct Config {
+  EGLint id;
+  EGLint depth;
+  EGLint surface_type;
+};
+
+const Config CONFIGS[] = {
+    {1, 24, EGL_WINDOW_BIT | EGL_PBUFFER_BIT},
+    {2, 16, EGL_WINDOW_BIT | EGL_PBUFFER_BIT},
+    {3, 0, EGL_PBUFFER_BIT},
+};
+
+struct Surface {
+  const Config* config;
+  ANativeWindow* window;  // NULL for a pbuffer
+  EGLint width;
+  EGLint height;
+  bool current;
+  bool destroyed;  // Freed once no longer current
+};
+
+struct Context {
+  const Config* config;
+  int32_t share_group;
+  ContextState state;
+  bool current;
+  bool destroyed;
+};
+
+// GL and EGL state is shared by every thread
+std::mutex g_mutex;
+
+GlDriver g_driver;
+std::map<GLuint, Shader> g_shaders;
+std::map<GLuint, Program> g_programs;
+std::map<GLuint, Texture> g_textures;
+std::map<GLuint, Buffer> g_buffers;
+// Fences by name, so oldest first; true once signaled
+std::map<GLuint, bool> g_fences;
+int32_t g_fence_waits = 0;
+GLuint g_next_name = 1;
+ContextState g_no_context_state;
+std::vector<Draw> g_draws;
+
+EglDriver g_egl_driver;
+bool g_egl_initialized = false;
+std::set<Surface*> g_surfaces;
+std::set<Context*> g_contexts;
+int32_t g_next_share_group = 1;
+thread_local Context* t_context = NULL;
+thread_local Surface* t_surface = NULL;
+thread_local EGLint t_egl_error = EGL_SUCCESS;
+
+bool ReadAsset(const char* file_name, std::vector<uint8_t>* data) {
+  std::string path = g_asset_dir + "/" + file_name;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == NULL) return false;
+  std::vector<uint8_t> contents;
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    contents.insert(contents.end(), buffer, buffer + read);
+  fclose(f);
+  data->swap(contents);
+  return true;
+}
+
+ContextState DefaultContextState() {
+  ContextState state;
+  state.texture = 0;
+  state.unpack_alignment = 4;
+  state.error = GL_NO_ERROR;
+  state.program = 0;
+  memset(state.attribs, 0, sizeof(state.attribs));
+  memset(state.viewport, 0, sizeof(state.viewport));
+  return state;
+}
+
+ContextState& GetState() {
+  return t_context ? t_context->state : g_no_context_state;
+}
+
+bool IsEs3() {
+  return g_driver.version_.find("OpenGL ES 3.") != std::string::npos;
+}
+
+bool IsPowerOfTwo(const int32_t v) { return (v & (v - 1)) == 0; }
+
+struct InitMock {
+  InitMock() {
+    ResetGl();
+    ResetEgl();
+  }
+} g_init_mock;
+
+}  // namespace
+
+void SetAssetDir(const char* dir) { g_asset_dir = dir; }
+
+AAssetManager* GetAssetManager() {
+  // Only ever compared with NULL and handed back to AAssetManager_open()
+  static int32_t manager;
+  return reinterpret_cast<AAssetManager*>(&manager);
+}
+
+void SetCompressedAssets(const bool compressed) {
+  g_compressed_assets = compressed;
+}
+
+void SetVerbose(const bool verbose) { g_verbose = verbose; }
+
+void CountCall(const char* function) {
+  std::lock_guard<std::mutex> lock(g_calls_mutex);
+  ++g_calls[function];
+}
+
+int32_t GetCalls(const char* function) {
+  std::lock_guard<std::mutex> lock(g_calls_mutex);
+  std::map<std::string, int32_t>::const_iterator it = g_calls.find(function);
+  return it == g_calls.end() ? 0 : it->second;
+}
+
+void ResetCalls() {
+  std::lock_guard<std::mutex> lock(g_calls_mutex);
+  g_calls.clear();
+}
+
+GlDriver& GetGlDriver() { return g_driver; }
+
+void ResetGl() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_driver.vendor_ = "androidMock";
+  g_driver.renderer_ = "androidMock GL";
+  g_driver.version_ = "OpenGL ES 3.0 androidMock";
+  g_driver.extensions_ =
+      "GL_OES_get_program_binary GL_OES_compressed_ETC1_RGB8_texture";
+  g_driver.binary_formats_ = 1;
+  g_driver.accept_binaries_ = true;
+  g_driver.max_texture_size_ = 4096;
+  g_driver.gpu_hung_ = false;
+  g_shaders.clear();
+  g_programs.clear();
+  g_textures.clear();
+  g_buffers.clear();
+  g_fences.clear();
+  g_fence_waits = 0;
+  g_draws.clear();
+  g_no_context_state = DefaultContextState();
+  std::set<Context*>::iterator it = g_contexts.begin();
+  for (; it != g_contexts.end(); ++it) (*it)->state = DefaultContextState();
+}
+
+std::string GetProgramBinary(const GLuint program) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::map<GLuint, Program>::const_iterator it = g_programs.find(program);
+  return it == g_programs.end() ? std::string() : it->second.binary;
+}
+
+int32_t GetLiveObjects() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return (int32_t)(g_shaders.size() + g_programs.size() + g_textures.size() +
+                   g_buffers.size());
+}
+
+const Texture* GetTexture(const GLuint texture) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::map<GLuint, Texture>::const_iterator it = g_textures.find(texture);
+  return it == g_textures.end() ? NULL : &it->second;
+}
+
+bool IsTextureComplete(const GLuint texture) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::map<GLuint, Texture>::const_iterator it = g_textures.find(texture);
+  if (it == g_textures.end() || !it->second.width_) return false;
+  const Texture& t = it->second;
+  const bool mip_filter =
+      t.min_filter_ != GL_NEAREST && t.min_filter_ != GL_LINEAR;
+  if (mip_filter && !t.mipmaps_) return false;
+  if (!IsEs3() && (!IsPowerOfTwo(t.width_) || !IsPowerOfTwo(t.height_))) {
+    return !mip_filter && t.wrap_s_ == GL_CLAMP_TO_EDGE &&
+           t.wrap_t_ == GL_CLAMP_TO_EDGE;
+  }
+  return true;
+}
+
+const std::vector<uint8_t>* GetBufferData(const GLuint buffer) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::map<GLuint, Buffer>::const_iterator it = g_buffers.find(buffer);
+  return it == g_buffers.end() ? NULL : &it->second.data;
+}
+
+std::vector<GLuint> GetBuffers(const GLenum target) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::vector<GLuint> buffers;
+  std::map<GLuint, Buffer>::const_iterator it = g_buffers.begin();
+  for (; it != g_buffers.end(); ++it)
+    if (it->second.target == target) buffers.push_back(it->first);
+  return buffers;
+}
+
+std::vector<Draw> GetDraws() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_draws;
+}
+
+std::vector<float> GetUniform(const GLuint program, const char* name) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  std::map<GLuint, Program>::const_iterator p = g_programs.find(program);
+  if (p == g_programs.end()) return std::vector<float>();
+  std::map<std::string, GLint>::const_iterator location =
+      p->second.locations.find(name);
+  if (location == p->second.locations.end()) return std::vector<float>();
+  std::map<GLint, std::vector<float> >::const_iterator it =
+      p->second.uniforms.find(location->second);
+  return it == p->second.uniforms.end() ? std::vector<float>() : it->second;
+}
+
+EglDriver& GetEglDriver() { return g_egl_driver; }
+
+void ResetEgl() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_egl_driver.depth24_ = true;
+  g_egl_driver.window_pbuffer_ = true;
+  g_egl_driver.geometry_result_ = 0;
+  g_egl_driver.fence_sync_ = true;
+  std::set<Surface*>::iterator surface = g_surfaces.begin();
+  for (; surface != g_surfaces.end(); ++surface) delete *surface;
+  g_surfaces.clear();
+  std::set<Context*>::iterator context = g_contexts.begin();
+  for (; context != g_contexts.end(); ++context) delete *context;
+  g_contexts.clear();
+  g_egl_initialized = false;
+  t_context = NULL;
+  t_surface = NULL;
+}
+
+void SignalFences(const int32_t pending) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  int32_t unsignaled = 0;
+  std::map<GLuint, bool>::reverse_iterator it = g_fences.rbegin();
+  for (; it != g_fences.rend(); ++it)
+    if (!it->second && ++unsignaled > pending) it->second = true;
+}
+
+int32_t GetLiveFences() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return (int32_t)g_fences.size();
+}
+
+int32_t GetPendingFences() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  int32_t pending = 0;
+  std::map<GLuint, bool>::const_iterator it = g_fences.begin();
+  for (; it != g_fences.end(); ++it) pending += !it->second;
+  return pending;
+}
+
+int32_t GetFenceWaits() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_fence_waits;
+}
+
+int32_t GetLiveEglObjects() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return (int32_t)(g_surfaces.size() + g_contexts.size());
+}
+
+}  // namespace android_mock
+
+using namespace android_mock;
+
+#define MOCK_CALL() CountCall(__func__)
+
+namespace {
+
+void CountGlCall(const char* function) {
+  CountCall(function);
+  if (g_egl_initialized && !t_context) CountCall(MOCK_NO_CONTEXT);
+}
+
+void SetGlError(const GLenum error) {
+  // The first error sticks until glGetError()
+  ContextState& state = GetState();
+  if (state.error == GL_NO_ERROR) state.error = error;
+}
+
+void SetEglError(const EGLint error) { t_egl_error = error; }
+
+}  // namespace
+
+// GL and EGL calls hold the mock's lock
+#define MOCK_GL_CALL(name)                       \
+  std::lock_guard<std::mutex> gl_lock(g_mutex); \
+  CountGlCall(name)
+#define MOCK_EGL_CALL()                          \
+  std::lock_guard<std::mutex> egl_lock(g_mutex); \
+  CountCall(__func__)
+
+//--------------------------------------------------------------------------------
+// Log
+//--------------------------------------------------------------------------------
+int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+  if (prio < ANDROID_LOG_WARN && !g_verbose) return 0;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s: ", tag);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+  return 0;
+}
+
+//--------------------------------------------------------------------------------
+// Assets
+//--------------------------------------------------------------------------------
+struct AAsset {
+  std::vector<uint8_t> data;
+  size_t position;
+  bool buffered;
+  FILE* package;
+};
+
+AAsset* AAssetManager_open(AAssetManager*, const char* filename, int) {
+  MOCK_CALL();
+  AAsset* asset = new AAsset();
+  if (!ReadAsset(filename, &asset->data)) {
+    delete asset;
+    return NULL;
+  }
+  asset->position = 0;
+  asset->buffered = false;
+  asset->package = NULL;
+  return asset;
+}
+
+off_t AAsset_getLength(AAsset* asset) { return (off_t)asset->data.size(); }
+
+const void* AAsset_getBuffer(AAsset* asset) {
+  MOCK_CALL();
+  asset->buffered = true;
+  return asset->data.empty() ? "" : (const void*)&asset->data[0];
+}
+
+int AAsset_read(AAsset* asset, void* buf, size_t count) {
+  MOCK_CALL();
+  const size_t left = asset->data.size() - asset->position;
+  if (count > left) count = left;
+  if (count) memcpy(buf, &asset->data[asset->position], count);
+  asset->position += count;
+  return (int)count;
+}
+
+int AAsset_openFileDescriptor(AAsset* asset, off_t* out_start,
+                              off_t* out_length) {
+  MOCK_CALL();
+  if (g_compressed_assets) return -1;
+  if (asset->package == NULL) {
+    // Stored in a package file, past MOCK_ASSET_OFFSET bytes of other data
+    asset->package = tmpfile();
+    if (asset->package == NULL) return -1;
+    for (off_t i = 0; i < MOCK_ASSET_OFFSET; ++i) fputc('A', asset->package);
+    if (asset->data.size())
+      fwrite(&asset->data[0], 1, asset->data.size(), asset->package);
+    fflush(asset->package);
+  }
+  *out_start = MOCK_ASSET_OFFSET;
+  *out_length = (off_t)asset->data.size();
+  return dup(fileno(asset->package));
+}
+
+int AAsset_isAllocated(AAsset* asset) { return asset->buffered; }
+
+void AAsset_close(AAsset* asset) {
+  MOCK_CALL();
+  if (asset->package) fclose(asset->package);
+  delete asset;
+}
+
+//--------------------------------------------------------------------------------
+// Native windows
+//--------------------------------------------------------------------------------
+struct ANativeWindow {
+  int32_t width;
+  int32_t height;
+  // Size of the buffers, 0 for the window size
+  int32_t buffers_width;
+  int32_t buffers_height;
+  bool connected;  // Has a window surface
+};
+
+ANativeWindow* android_mock::CreateWindow(const int32_t width,
+                                          const int32_t height) {
+  ANativeWindow* window = new ANativeWindow();
+  window->width = width;
+  window->height = height;
+  window->buffers_width = 0;
+  window->buffers_height = 0;
+  window->connected = false;
+  return window;
+}
+
+void android_mock::DestroyWindow(ANativeWindow* window) { delete window; }
+
+void android_mock::GetBuffersSize(ANativeWindow* window, int32_t* width,
+                                  int32_t* height) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  *width = window->buffers_width ? window->buffers_width : window->width;
+  *height = window->buffers_height ? window->buffers_height : window->height;
+}
+
+int32_t ANativeWindow_getWidth(ANativeWindow* window) {
+  MOCK_CALL();
+  return window->width;
+}
+
+int32_t ANativeWindow_getHeight(ANativeWindow* window) {
+  MOCK_CALL();
+  return window->height;
+}
+
+int32_t ANativeWindow_getFormat(ANativeWindow*) {
+  MOCK_CALL();
+  return 1;  // WINDOW_FORMAT_RGBA_8888
+}
+
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width,
+                                         int32_t height, int32_t) {
+  MOCK_CALL();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (width < 0 || height < 0 || !width != !height) return -22;  // -EINVAL
+  if (width && g_egl_driver.geometry_result_) {
+    return g_egl_driver.geometry_result_;
+  }
+  window->buffers_width = width;
+  window->buffers_height = height;
+  return 0;
+}
+
+//--------------------------------------------------------------------------------
+// JNIHelper, the parts the linked ndk_helper code calls
+//--------------------------------------------------------------------------------
+namespace ndk_helper {
+
+JNIHelper::JNIHelper()
+    : activity_(NULL),
+      jni_helper_java_ref_(NULL),
+      jni_helper_java_class_(NULL) {
+  app_name_ = "androidMock";
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+JNIHelper::~JNIHelper() { pthread_mutex_destroy(&mutex_); }
+
+JNIHelper* JNIHelper::GetInstance() {
+  static JNIHelper helper;
+  return &helper;
+}
+
+bool JNIHelper::ReadFile(const char* file_name,
+                         std::vector<uint8_t>* buffer_ref) {
+  return ReadAsset(file_name, buffer_ref);
+}
+
+}  // namespace ndk_helper
+
+//--------------------------------------------------------------------------------
+// GL
+//--------------------------------------------------------------------------------
+namespace {
+
+int32_t GetBytesPerPixel(const GLenum format) {
+  switch (format) {
+    case GL_LUMINANCE:
+    case GL_ALPHA:
+      return 1;
+    case GL_LUMINANCE_ALPHA:
+      return 2;
+    case GL_RGB:
+      return 3;
+    case GL_RGBA:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+// Bytes per 4x4 block, 0 if the format is not supported
+int32_t GetBlockBytes(const GLenum format) {
+  switch (format) {
+    case GL_ETC1_RGB8_OES:
+      return g_driver.extensions_.find("GL_OES_compressed_ETC1_RGB8_texture") !=
+                     std::string::npos
+                 ? 8
+                 : 0;
+    case GL_COMPRESSED_RGB8_ETC2:
+      return IsEs3() ? 8 : 0;
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+      return IsEs3() ? 16 : 0;
+    default:
+      return 0;
+  }
+}
+
+Texture* GetBoundTexture() {
+  std::map<GLuint, Texture>::iterator it = g_textures.find(GetState().texture);
+  return it == g_textures.end() ? NULL : &it->second;
+}
+
+// Of the program in use, -1 is silently ignored
+void SetUniform(const GLint location, const GLfloat* value,
+                const int32_t count) {
+  std::map<GLuint, Program>::iterator it =
+      g_programs.find(GetState().program);
+  if (it == g_programs.end()) {
+    SetGlError(GL_INVALID_OPERATION);
+  } else if (location != -1) {
+    it->second.uniforms[location].assign(value, value + count);
+  }
+}
+
+Buffer* GetBoundBuffer(const GLenum target) {
+  std::map<GLuint, Buffer>::iterator it =
+      g_buffers.find(GetState().buffers[target]);
+  return it == g_buffers.end() ? NULL : &it->second;
+}
+
+// Source rows of an upload, from the unpack buffer if one is bound.
+// Returns NULL and sets the error if they can not be read.
+const uint8_t* GetUploadSource(const void* pixels, const int32_t height,
+                               const size_t row_bytes, size_t* stride) {
+  const GLint alignment = GetState().unpack_alignment;
+  *stride = (row_bytes + alignment - 1) / alignment * alignment;
+  const size_t size = height ? (height - 1) * *stride + row_bytes : 0;
+  if (!GetState().buffers[GL_PIXEL_UNPACK_BUFFER]) {
+    if (pixels == NULL && size) SetGlError(GL_INVALID_OPERATION);
+    return (const uint8_t*)pixels;
+  }
+  Buffer* buffer = GetBoundBuffer(GL_PIXEL_UNPACK_BUFFER);
+  const size_t offset = (size_t)pixels;
+  if (buffer->mapped || offset + size > buffer->data.size()) {
+    SetGlError(GL_INVALID_OPERATION);
+    return NULL;
+  }
+  return buffer->data.empty() ? NULL : &buffer->data[offset];
+}
+
+void GL_APIENTRY MockGetProgramBinary(GLuint program, GLsizei buf_size,
+                                      GLsizei* length, GLenum* format,
+                                      void* binary) {
+  MOCK_GL_CALL("glGetProgramBinary");
+  const std::string& data = g_programs[program].binary;
+  *length = 0;
+  if (data.empty() || (GLsizei)data.size() > buf_size) return;
+  memcpy(binary, data.data(), data.size());
+  *length = (GLsizei)data.size();
+  *format = MOCK_BINARY_FORMAT;
+}
+
+void GL_APIENTRY MockProgramBinary(GLuint program, GLenum format,
+                                   const void* binary, GLint length) {
+  MOCK_GL_CALL("glProgramBinary");
+  const std::string data((const char*)binary, length);
+  const std::string tag = g_driver.renderer_ + "\n";
+  Program& p = g_programs[program];
+  p.binary.clear();
+  p.locations.clear();
+  p.uniforms.clear();
+  if (g_driver.accept_binaries_ && format == MOCK_BINARY_FORMAT &&
+      data.compare(0, tag.size(), tag) == 0)
+    p.binary = data;
+}
+
+void GL_APIENTRY MockProgramParameteri(GLuint program, GLenum pname,
+                                       GLint value) {
+  MOCK_GL_CALL("glProgramParameteri");
+  if (pname == 0x8257 /* GL_PROGRAM_BINARY_RETRIEVABLE_HINT */)
+    g_programs[program].retrievable = value != 0;
+}
+
+
+void* GL_APIENTRY MockMapBufferRange(GLenum target, GLintptr offset,
+                                     GLsizeiptr length, GLbitfield access) {
+  MOCK_GL_CALL("glMapBufferRange");
+  Buffer* buffer = GetBoundBuffer(target);
+  if (buffer == NULL || buffer->mapped || offset < 0 || length <= 0 ||
+      (size_t)(offset + length) > buffer->data.size() ||
+      !(access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))) {
+    SetGlError(buffer == NULL || buffer->mapped ? GL_INVALID_OPERATION
+                                                : GL_INVALID_VALUE);
+    return NULL;
+  }
+  if (!(access & GL_MAP_UNSYNCHRONIZED_BIT)) {
+    // The driver lets the GPU finish with the buffer first
+    bool waited = false;
+    std::map<GLuint, bool>::iterator it = g_fences.begin();
+    for (; it != g_fences.end(); ++it) {
+      waited |= !it->second;
+      it->second = true;
+    }
+    g_fence_waits += waited;
+  }
+  if (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT))
+    memset(&buffer->data[offset], 0xcd, length);
+  buffer->mapped = true;
+  buffer->map_length = length;
+  buffer->map_access = access;
+  return &buffer->data[offset];
+}
+
+void GL_APIENTRY MockFlushMappedBufferRange(GLenum target, GLintptr offset,
+                                            GLsizeiptr length) {
+  MOCK_GL_CALL("glFlushMappedBufferRange");
+  Buffer* buffer = GetBoundBuffer(target);
+  if (buffer == NULL || !buffer->mapped ||
+      !(buffer->map_access & GL_MAP_FLUSH_EXPLICIT_BIT)) {
+    SetGlError(GL_INVALID_OPERATION);
+  } else if (offset < 0 || length < 0 ||
+             (size_t)(offset + length) > buffer->map_length) {
+    // Relative to the mapped range
+    SetGlError(GL_INVALID_VALUE);
+  }
+}
+
+GLboolean GL_APIENTRY MockUnmapBuffer(GLenum target) {
+  MOCK_GL_CALL("glUnmapBuffer");
+  Buffer* buffer = GetBoundBuffer(target);
+  if (buffer == NULL || !buffer->mapped) {
+    SetGlError(GL_INVALID_OPERATION);
+    return GL_FALSE;
+  }
+  buffer->mapped = false;
+  return GL_TRUE;
+}
+
+//--------------------------------------------------------------------------------
+// Fences
+//--------------------------------------------------------------------------------
+GLsync SyncHandle(const GLuint name) {
+  return reinterpret_cast<GLsync>((uintptr_t)name);
+}
+
+std::map<GLuint, bool>::iterator FindFence(GLsync sync) {
+  return g_fences.find((GLuint) reinterpret_cast<uintptr_t>(sync));
+}
+
+GLsync GL_APIENTRY MockFenceSync(GLenum condition, GLbitfield flags) {
+  MOCK_GL_CALL("glFenceSync");
+  if (condition != GL_SYNC_GPU_COMMANDS_COMPLETE) {
+    SetGlError(GL_INVALID_ENUM);
+    return 0;
+  }
+  if (flags) {
+    SetGlError(GL_INVALID_VALUE);
+    return 0;
+  }
+  g_fences[g_next_name] = false;
+  return SyncHandle(g_next_name++);
+}
+
+GLenum GL_APIENTRY MockClientWaitSync(GLsync sync, GLbitfield flags,
+                                      GLuint64 timeout) {
+  MOCK_GL_CALL("glClientWaitSync");
+  std::map<GLuint, bool>::iterator fence = FindFence(sync);
+  if (fence == g_fences.end() || (flags & ~GL_SYNC_FLUSH_COMMANDS_BIT)) {
+    SetGlError(GL_INVALID_VALUE);
+    return GL_WAIT_FAILED;
+  }
+  if (fence->second) return GL_ALREADY_SIGNALED;
+  if (timeout == 0) return GL_TIMEOUT_EXPIRED;
+  ++g_fence_waits;
+  if (g_driver.gpu_hung_) return GL_TIMEOUT_EXPIRED;
+  // The GPU finishes its work in order
+  ++fence;
+  for (std::map<GLuint, bool>::iterator it = g_fences.begin(); it != fence;
+       ++it)
+    it->second = true;
+  return GL_CONDITION_SATISFIED;
+}
+
+void GL_APIENTRY MockDeleteSync(GLsync sync) {
+  MOCK_GL_CALL("glDeleteSync");
+  std::map<GLuint, bool>::iterator fence = FindFence(sync);
+  if (fence != g_fences.end())
+    g_fences.erase(fence);
+  else if (sync)
+    SetGlError(GL_INVALID_VALUE);
+}
+
+// Every other ES3 entry point: a test reaching one needs a new mock
+void GL_APIENTRY MockMissing() {
+  fprintf(stderr, "androidMock: called a GL entry point with no mock\n");
+  abort();
+}
+}  // namespace
+
+extern "C" {
+
+const GLubyte* GL_APIENTRY glGetString(GLenum name) {
+  MOCK_GL_CALL(__func__);
+  const std::string* str = NULL;
+  switch (name) {
+    case GL_VENDOR:
+      str = &g_driver.vendor_;
+      break;
+    case GL_RENDERER:
+      str = &g_driver.renderer_;
+      break;
+    case GL_VERSION:
+      str = &g_driver.version_;
+      break;
+    case GL_EXTENSIONS:
+      str = &g_driver.extensions_;
+      break;
+  }
+  return str ? (const GLubyte*)str->c_str() : NULL;
+}
+
+void GL_APIENTRY glGetIntegerv(GLenum pname, GLint* data) {
+  MOCK_GL_CALL(__func__);
+  switch (pname) {
+    case GL_NUM_PROGRAM_BINARY_FORMATS_OES:
+      *data = g_driver.binary_formats_;
+      break;
+    case GL_MAX_TEXTURE_SIZE:
+      *data = g_driver.max_texture_size_;
+      break;
+    case GL_UNPACK_ALIGNMENT:
+      *data = GetState().unpack_alignment;
+      break;
+    case GL_VIEWPORT:
+      memcpy(data, GetState().viewport, sizeof(GetState().viewport));
+      break;
+    default:
+      *data = 0;
+  }
+}
+
+GLuint GL_APIENTRY glCreateShader(GLenum type) {
+  MOCK_GL_CALL(__func__);
+  Shader shader = {type, "", false};
+  g_shaders[g_next_name] = shader;
+  return g_next_name++;
+}
+
+void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count,
+                                const GLchar* const* string,
+                                const GLint* length) {
+  MOCK_GL_CALL(__func__);
+  std::string& source = g_shaders[shader].source;
+  source.clear();
+  for (GLsizei i = 0; i < count; ++i) {
+    if (length && length[i] >= 0)
+      source.append(string[i], length[i]);
+    else
+      source.append(string[i]);
+  }
+}
+
+void GL_APIENTRY glCompileShader(GLuint shader) {
+  MOCK_GL_CALL(__func__);
+  Shader& s = g_shaders[shader];
+  s.compiled = s.source.find(MOCK_COMPILE_ERROR) == std::string::npos;
+}
+
+void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+  MOCK_GL_CALL(__func__);
+  *params = pname == GL_COMPILE_STATUS ? g_shaders[shader].compiled : 0;
+}
+
+void GL_APIENTRY glGetShaderInfoLog(GLuint, GLsizei, GLsizei* length,
+                                    GLchar* info_log) {
+  MOCK_GL_CALL(__func__);
+  if (length) *length = 0;
+  if (info_log) *info_log = 0;
+}
+
+void GL_APIENTRY glDeleteShader(GLuint shader) {
+  MOCK_GL_CALL(__func__);
+  g_shaders.erase(shader);
+}
+
+GLuint GL_APIENTRY glCreateProgram() {
+  MOCK_GL_CALL(__func__);
+  g_programs[g_next_name] = Program();
+  return g_next_name++;
+}
+
+void GL_APIENTRY glDeleteProgram(GLuint program) {
+  MOCK_GL_CALL(__func__);
+  g_programs.erase(program);
+}
+
+void GL_APIENTRY glAttachShader(GLuint program, GLuint shader) {
+  MOCK_GL_CALL(__func__);
+  g_programs[program].shaders.push_back(shader);
+}
+
+void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index,
+                                      const GLchar* name) {
+  MOCK_GL_CALL(__func__);
+  g_programs[program].bindings[name] = index;
+}
+
+void GL_APIENTRY glLinkProgram(GLuint program) {
+  MOCK_GL_CALL(__func__);
+  Program& p = g_programs[program];
+  p.binary.clear();
+  p.locations.clear();
+  p.uniforms.clear();
+  std::string binary = g_driver.renderer_ + "\n";
+  for (size_t i = 0; i < p.shaders.size(); ++i) {
+    const Shader& shader = g_shaders[p.shaders[i]];
+    if (!shader.compiled) return;
+    binary += shader.source + "\n";
+  }
+  if (p.shaders.size() != 2) return;
+  char str[32];
+  std::map<std::string, GLuint>::const_iterator it = p.bindings.begin();
+  for (; it != p.bindings.end(); ++it) {
+    snprintf(str, sizeof(str), "=%u\n", it->second);
+    binary += it->first + str;
+  }
+  p.binary = binary;
+}
+
+void GL_APIENTRY glValidateProgram(GLuint) { MOCK_GL_CALL(__func__); }
+
+void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+  MOCK_GL_CALL(__func__);
+  const Program& p = g_programs[program];
+  switch (pname) {
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:
+      *params = !p.binary.empty();
+      break;
+    case GL_PROGRAM_BINARY_LENGTH_OES:
+      *params = (GLint)p.binary.size();
+      break;
+    default:
+      *params = 0;
+  }
+}
+
+void GL_APIENTRY glGetProgramInfoLog(GLuint, GLsizei, GLsizei* length,
+                                     GLchar* info_log) {
+  MOCK_GL_CALL(__func__);
+  if (length) *length = 0;
+  if (info_log) *info_log = 0;
+}
+
+//--------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------
+void GL_APIENTRY glGenTextures(GLsizei n, GLuint* textures) {
+  MOCK_GL_CALL(__func__);
+  for (GLsizei i = 0; i < n; ++i) {
+    Texture& texture = g_textures[g_next_name];
+    texture.width_ = 0;
+    texture.height_ = 0;
+    texture.format_ = 0;
+    texture.compressed_ = false;
+    texture.min_filter_ = GL_NEAREST_MIPMAP_LINEAR;
+    texture.mag_filter_ = GL_LINEAR;
+    texture.wrap_s_ = GL_REPEAT;
+    texture.wrap_t_ = GL_REPEAT;
+    texture.mipmaps_ = false;
+    textures[i] = g_next_name++;
+  }
+}
+
+void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint* textures) {
+  MOCK_GL_CALL(__func__);
+  for (GLsizei i = 0; i < n; ++i) {
+    g_textures.erase(textures[i]);
+    if (GetState().texture == textures[i]) GetState().texture = 0;
+  }
+}
+
+void GL_APIENTRY glBindTexture(GLenum target, GLuint texture) {
+  MOCK_GL_CALL(__func__);
+  if (target != GL_TEXTURE_2D) {
+    SetGlError(GL_INVALID_ENUM);
+  } else if (texture && !g_textures.count(texture)) {
+    SetGlError(GL_INVALID_OPERATION);
+  } else {
+    GetState().texture = texture;
+  }
+}
+
+void GL_APIENTRY glPixelStorei(GLenum pname, GLint param) {
+  MOCK_GL_CALL(__func__);
+  if (pname != GL_UNPACK_ALIGNMENT) return;
+  if (param != 1 && param != 2 && param != 4 && param != 8) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  GetState().unpack_alignment = param;
+}
+
+void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalformat,
+                              GLsizei width, GLsizei height, GLint border,
+                              GLenum format, GLenum type,
+                              const void* pixels) {
+  MOCK_GL_CALL(__func__);
+  Texture* texture = GetBoundTexture();
+  const int32_t bpp = GetBytesPerPixel(format);
+  if (target != GL_TEXTURE_2D || !bpp || type != GL_UNSIGNED_BYTE) {
+    SetGlError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texture == NULL || (GLenum)internalformat != format) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (level < 0 || width < 0 || height < 0 || border ||
+      width > g_driver.max_texture_size_ ||
+      height > g_driver.max_texture_size_) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  // Only level 0 is kept
+  if (level) return;
+
+  const size_t row_bytes = (size_t)width * bpp;
+  std::vector<uint8_t> data(row_bytes * height);
+  if (pixels || GetState().buffers[GL_PIXEL_UNPACK_BUFFER]) {
+    size_t stride;
+    const uint8_t* src = GetUploadSource(pixels, height, row_bytes, &stride);
+    if (src == NULL && data.size()) return;
+    for (GLsizei y = 0; y < height; ++y)
+      memcpy(&data[y * row_bytes], src + y * stride, row_bytes);
+  }
+  texture->width_ = width;
+  texture->height_ = height;
+  texture->format_ = format;
+  texture->compressed_ = false;
+  texture->pixels_.swap(data);
+  texture->mipmaps_ = false;
+}
+
+void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xoffset,
+                                 GLint yoffset, GLsizei width, GLsizei height,
+                                 GLenum format, GLenum type,
+                                 const void* pixels) {
+  MOCK_GL_CALL(__func__);
+  Texture* texture = GetBoundTexture();
+  const int32_t bpp = GetBytesPerPixel(format);
+  if (target != GL_TEXTURE_2D || !bpp || type != GL_UNSIGNED_BYTE) {
+    SetGlError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texture == NULL || texture->compressed_ || texture->format_ != format) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (level || xoffset < 0 || yoffset < 0 || width < 0 || height < 0 ||
+      xoffset + width > texture->width_ ||
+      yoffset + height > texture->height_) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+
+  const size_t row_bytes = (size_t)width * bpp;
+  size_t stride;
+  const uint8_t* src = GetUploadSource(pixels, height, row_bytes, &stride);
+  if (src == NULL) return;
+  const size_t texture_stride = (size_t)texture->width_ * bpp;
+  for (GLsizei y = 0; y < height; ++y) {
+    memcpy(&texture->pixels_[(yoffset + y) * texture_stride + xoffset * bpp],
+           src + y * stride, row_bytes);
+  }
+  // Levels generated before are stale now
+  texture->mipmaps_ = false;
+}
+
+void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level,
+                                        GLenum internalformat, GLsizei width,
+                                        GLsizei height, GLint border,
+                                        GLsizei image_size, const void* data) {
+  MOCK_GL_CALL(__func__);
+  Texture* texture = GetBoundTexture();
+  const int32_t block_bytes = GetBlockBytes(internalformat);
+  if (target != GL_TEXTURE_2D || !block_bytes) {
+    SetGlError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texture == NULL) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  const GLsizei expected =
+      ((width + 3) / 4) * ((height + 3) / 4) * block_bytes;
+  if (level || width < 0 || height < 0 || border ||
+      width > g_driver.max_texture_size_ ||
+      height > g_driver.max_texture_size_ || image_size != expected) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  texture->width_ = width;
+  texture->height_ = height;
+  texture->format_ = internalformat;
+  texture->compressed_ = true;
+  texture->pixels_.assign((const uint8_t*)data,
+                          (const uint8_t*)data + image_size);
+  texture->mipmaps_ = false;
+}
+
+void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param) {
+  MOCK_GL_CALL(__func__);
+  Texture* texture = GetBoundTexture();
+  if (target != GL_TEXTURE_2D || texture == NULL) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  switch (pname) {
+    case GL_TEXTURE_MIN_FILTER:
+      texture->min_filter_ = param;
+      break;
+    case GL_TEXTURE_MAG_FILTER:
+      texture->mag_filter_ = param;
+      break;
+    case GL_TEXTURE_WRAP_S:
+      texture->wrap_s_ = param;
+      break;
+    case GL_TEXTURE_WRAP_T:
+      texture->wrap_t_ = param;
+      break;
+    default:
+      SetGlError(GL_INVALID_ENUM);
+  }
+}
+
+void GL_APIENTRY glGenerateMipmap(GLenum target) {
+  MOCK_GL_CALL(__func__);
+  Texture* texture = GetBoundTexture();
+  if (target != GL_TEXTURE_2D) {
+    SetGlError(GL_INVALID_ENUM);
+  } else if (texture == NULL || !texture->width_ || texture->compressed_ ||
+             (!IsEs3() && (!IsPowerOfTwo(texture->width_) ||
+                           !IsPowerOfTwo(texture->height_)))) {
+    SetGlError(GL_INVALID_OPERATION);
+  } else {
+    texture->mipmaps_ = true;
+  }
+}
+
+GLenum GL_APIENTRY glGetError() {
+  MOCK_GL_CALL(__func__);
+  const GLenum error = GetState().error;
+  GetState().error = GL_NO_ERROR;
+  return error;
+}
+
+//--------------------------------------------------------------------------------
+// Buffers
+//--------------------------------------------------------------------------------
+void GL_APIENTRY glGenBuffers(GLsizei n, GLuint* buffers) {
+  MOCK_GL_CALL(__func__);
+  for (GLsizei i = 0; i < n; ++i) {
+    g_buffers[g_next_name] = Buffer();
+    buffers[i] = g_next_name++;
+  }
+}
+
+void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+  MOCK_GL_CALL(__func__);
+  for (GLsizei i = 0; i < n; ++i) {
+    g_buffers.erase(buffers[i]);
+    std::map<GLenum, GLuint>::iterator it = GetState().buffers.begin();
+    for (; it != GetState().buffers.end(); ++it)
+      if (it->second == buffers[i]) it->second = 0;
+  }
+}
+
+void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
+  MOCK_GL_CALL(__func__);
+  if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER &&
+      (target != GL_PIXEL_UNPACK_BUFFER || !IsEs3())) {
+    SetGlError(GL_INVALID_ENUM);
+  } else if (buffer && !g_buffers.count(buffer)) {
+    SetGlError(GL_INVALID_OPERATION);
+  } else {
+    GetState().buffers[target] = buffer;
+  }
+}
+
+void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void* data,
+                              GLenum) {
+  MOCK_GL_CALL(__func__);
+  Buffer* buffer = GetBoundBuffer(target);
+  if (buffer == NULL) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (size < 0) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  // New storage, unmapped; with no data its contents are undefined
+  buffer->mapped = false;
+  buffer->target = target;
+  if (data) {
+    buffer->data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+  } else {
+    buffer->data.assign(size, 0xcd);
+  }
+}
+
+void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset,
+                                 GLsizeiptr size, const void* data) {
+  MOCK_GL_CALL(__func__);
+  Buffer* buffer = GetBoundBuffer(target);
+  if (buffer == NULL || buffer->mapped) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (offset < 0 || size < 0 || (size_t)(offset + size) > buffer->data.size()) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  if (size) memcpy(&buffer->data[offset], data, size);
+}
+
+void GL_APIENTRY glFlush() { MOCK_GL_CALL(__func__); }
+
+void GL_APIENTRY glFinish() {
+  MOCK_GL_CALL(__func__);
+  // The GPU finishes everything, fenced or not
+  bool waited = false;
+  std::map<GLuint, bool>::iterator it = g_fences.begin();
+  for (; it != g_fences.end(); ++it) {
+    waited |= !it->second;
+    it->second = true;
+  }
+  g_fence_waits += waited;
+}
+
+//--------------------------------------------------------------------------------
+// Draws
+//--------------------------------------------------------------------------------
+void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  MOCK_GL_CALL(__func__);
+  const GLint viewport[4] = {x, y, width, height};
+  memcpy(GetState().viewport, viewport, sizeof(viewport));
+}
+
+void GL_APIENTRY glFrontFace(GLenum) { MOCK_GL_CALL(__func__); }
+
+void GL_APIENTRY glUseProgram(GLuint program) {
+  MOCK_GL_CALL(__func__);
+  std::map<GLuint, Program>::const_iterator it = g_programs.find(program);
+  if (program && (it == g_programs.end() || it->second.binary.empty())) {
+    SetGlError(GL_INVALID_OPERATION);
+    return;
+  }
+  GetState().program = program;
+}
+
+GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar* name) {
+  MOCK_GL_CALL(__func__);
+  std::map<GLuint, Program>::iterator it = g_programs.find(program);
+  if (it == g_programs.end() || it->second.binary.empty()) {
+    SetGlError(GL_INVALID_OPERATION);
+    return -1;
+  }
+  Program& p = it->second;
+  if (p.binary.find(name) == std::string::npos) return -1;
+  if (!p.locations.count(name)) p.locations[name] = (GLint)p.locations.size();
+  return p.locations[name];
+}
+
+void GL_APIENTRY glUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+  MOCK_GL_CALL(__func__);
+  const GLfloat value[] = {x, y, z};
+  SetUniform(location, value, 3);
+}
+
+void GL_APIENTRY glUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z,
+                             GLfloat w) {
+  MOCK_GL_CALL(__func__);
+  const GLfloat value[] = {x, y, z, w};
+  SetUniform(location, value, 4);
+}
+
+void GL_APIENTRY glUniform3fv(GLint location, GLsizei count,
+                              const GLfloat* value) {
+  MOCK_GL_CALL(__func__);
+  SetUniform(location, value, count * 3);
+}
+
+void GL_APIENTRY glUniform4fv(GLint location, GLsizei count,
+                              const GLfloat* value) {
+  MOCK_GL_CALL(__func__);
+  SetUniform(location, value, count * 4);
+}
+
+void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count,
+                                    GLboolean, const GLfloat* value) {
+  MOCK_GL_CALL(__func__);
+  SetUniform(location, value, count * 9);
+}
+
+void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count,
+                                    GLboolean, const GLfloat* value) {
+  MOCK_GL_CALL(__func__);
+  SetUniform(location, value, count * 16);
+}
+
+void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type,
+                                       GLboolean normalized, GLsizei stride,
+                                       const void* pointer) {
+  MOCK_GL_CALL(__func__);
+  if (index >= (GLuint)MOCK_MAX_VERTEX_ATTRIBS || size < 1 || size > 4 ||
+      stride < 0) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  VertexAttrib& attrib = GetState().attribs[index];
+  attrib.size_ = size;
+  attrib.type_ = type;
+  attrib.normalized_ = normalized != GL_FALSE;
+  attrib.stride_ = stride;
+  attrib.offset_ = (size_t)pointer;
+  attrib.buffer_ = GetState().buffers[GL_ARRAY_BUFFER];
+}
+
+void GL_APIENTRY glEnableVertexAttribArray(GLuint index) {
+  MOCK_GL_CALL(__func__);
+  if (index >= (GLuint)MOCK_MAX_VERTEX_ATTRIBS) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  GetState().attribs[index].enabled_ = true;
+}
+
+void GL_APIENTRY glDisableVertexAttribArray(GLuint index) {
+  MOCK_GL_CALL(__func__);
+  if (index >= (GLuint)MOCK_MAX_VERTEX_ATTRIBS) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  GetState().attribs[index].enabled_ = false;
+}
+
+void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type,
+                                const void* indices) {
+  MOCK_GL_CALL(__func__);
+  if (count < 0) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  Draw draw;
+  draw.mode_ = mode;
+  draw.count_ = count;
+  draw.type_ = type;
+  draw.offset_ = (size_t)indices;
+  draw.element_buffer_ = GetState().buffers[GL_ELEMENT_ARRAY_BUFFER];
+  draw.program_ = GetState().program;
+  memcpy(draw.attribs_, GetState().attribs, sizeof(draw.attribs_));
+  g_draws.push_back(draw);
+}
+
+void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+  MOCK_GL_CALL(__func__);
+  if (first < 0 || count < 0) {
+    SetGlError(GL_INVALID_VALUE);
+    return;
+  }
+  Draw draw;
+  draw.mode_ = mode;
+  draw.count_ = count;
+  draw.type_ = 0;
+  draw.offset_ = (size_t)first;
+  draw.element_buffer_ = 0;
+  draw.program_ = GetState().program;
+  memcpy(draw.attribs_, GetState().attribs, sizeof(draw.attribs_));
+  g_draws.push_back(draw);
+}
+
+//--------------------------------------------------------------------------------
+// EGL
+//--------------------------------------------------------------------------------
+namespace {
+
+int32_t g_display;
+
+bool IsConfigAvailable(const Config* config) {
+  return config->id != 1 || g_egl_driver.depth24_;
+}
+
+EGLint GetSurfaceType(const Config* config) {
+  if (config->depth && !g_egl_driver.window_pbuffer_) return EGL_WINDOW_BIT;
+  return config->surface_type;
+}
+
+bool IsLiveSurface(EGLSurface surface) {
+  Surface* s = static_cast<Surface*>(surface);
+  return g_surfaces.count(s) && !s->destroyed;
+}
+
+bool IsLiveContext(EGLContext context) {
+  Context* c = static_cast<Context*>(context);
+  return g_contexts.count(c) && !c->destroyed;
+}
+
+// Objects destroyed while current go when they stop being current
+void ReleaseCurrent() {
+  if (t_surface) {
+    t_surface->current = false;
+    if (t_surface->destroyed) {
+      if (t_surface->window) t_surface->window->connected = false;
+      g_surfaces.erase(t_surface);
+      delete t_surface;
+    }
+  }
+  if (t_context) {
+    t_context->current = false;
+    if (t_context->destroyed) {
+      g_contexts.erase(t_context);
+      delete t_context;
+    }
+  }
+  t_surface = NULL;
+  t_context = NULL;
+}
+
+}  // namespace
+
+EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType display_id) {
+  MOCK_EGL_CALL();
+  return display_id == EGL_DEFAULT_DISPLAY ? &g_display : EGL_NO_DISPLAY;
+}
+
+EGLBoolean EGLAPIENTRY eglInitialize(EGLDisplay dpy, EGLint* major,
+                                     EGLint* minor) {
+  MOCK_EGL_CALL();
+  if (dpy != &g_display) {
+    SetEglError(EGL_BAD_DISPLAY);
+    return EGL_FALSE;
+  }
+  g_egl_initialized = true;
+  if (major) *major = 1;
+  if (minor) *minor = 4;
+  return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay) {
+  MOCK_EGL_CALL();
+  // Objects current on a thread stay until released there
+  std::set<Surface*> surfaces(g_surfaces);
+  for (std::set<Surface*>::iterator it = surfaces.begin();
+       it != surfaces.end(); ++it) {
+    (*it)->destroyed = true;
+    if (!(*it)->current) {
+      if ((*it)->window) (*it)->window->connected = false;
+      g_surfaces.erase(*it);
+      delete *it;
+    }
+  }
+  std::set<Context*> contexts(g_contexts);
+  for (std::set<Context*>::iterator it = contexts.begin();
+       it != contexts.end(); ++it) {
+    (*it)->destroyed = true;
+    if (!(*it)->current) {
+      g_contexts.erase(*it);
+      delete *it;
+    }
+  }
+  g_egl_initialized = false;
+  return EGL_TRUE;
+}
+
+EGLint EGLAPIENTRY eglGetError() {
+  const EGLint error = t_egl_error;
+  t_egl_error = EGL_SUCCESS;
+  return error;
+}
+
+const char* EGLAPIENTRY eglQueryString(EGLDisplay, EGLint name) {
+  MOCK_EGL_CALL();
+  switch (name) {
+    case EGL_VENDOR:
+      return "androidMock";
+    case EGL_VERSION:
+      return "1.4 androidMock";
+    case EGL_EXTENSIONS:
+      return g_egl_driver.fence_sync_ ? "EGL_KHR_fence_sync" : "";
+    default:
+      SetEglError(EGL_BAD_PARAMETER);
+      return NULL;
+  }
+}
+
+EGLBoolean EGLAPIENTRY eglChooseConfig(EGLDisplay, const EGLint* attrib_list,
+                                       EGLConfig* configs, EGLint config_size,
+                                       EGLint* num_config) {
+  MOCK_EGL_CALL();
+  EGLint depth = 0;
+  EGLint surface_type = EGL_WINDOW_BIT;
+  for (const EGLint* a = attrib_list; a && *a != EGL_NONE; a += 2) {
+    if (a[0] == EGL_DEPTH_SIZE) depth = a[1];
+    if (a[0] == EGL_SURFACE_TYPE) surface_type = a[1];
+    if ((a[0] == EGL_RED_SIZE || a[0] == EGL_GREEN_SIZE ||
+         a[0] == EGL_BLUE_SIZE) &&
+        a[1] > 8)
+      depth = 1000;  // Nothing matches
+  }
+  // Sorted as EGL does with these attributes: smallest depth buffer first
+  *num_config = 0;
+  const int32_t count = sizeof(CONFIGS) / sizeof(CONFIGS[0]);
+  for (int32_t i = count - 1; i >= 0; --i) {
+    const Config* config = &CONFIGS[i];
+    if (!IsConfigAvailable(config) || config->depth < depth ||
+        (GetSurfaceType(config) & surface_type) != surface_type)
+      continue;
+    if (configs && *num_config < config_size)
+      configs[*num_config] = (EGLConfig)config;
+    if (configs == NULL || *num_config < config_size) ++*num_config;
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglGetConfigAttrib(EGLDisplay, EGLConfig config,
+                                          EGLint attribute, EGLint* value) {
+  MOCK_EGL_CALL();
+  const Config* c = static_cast<const Config*>(config);
+  switch (attribute) {
+    case EGL_CONFIG_ID:
+      *value = c->id;
+      break;
+    case EGL_DEPTH_SIZE:
+      *value = c->depth;
+      break;
+    case EGL_SURFACE_TYPE:
+      *value = GetSurfaceType(c);
+      break;
+    case EGL_RED_SIZE:
+    case EGL_GREEN_SIZE:
+    case EGL_BLUE_SIZE:
+      *value = 8;
+      break;
+    case EGL_RENDERABLE_TYPE:
+      *value = EGL_OPENGL_ES2_BIT;
+      break;
+    default:
+      SetEglError(EGL_BAD_ATTRIBUTE);
+      return EGL_FALSE;
+  }
+  return EGL_TRUE;
+}
+
+EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay, EGLConfig config,
+                                              EGLNativeWindowType win,
+                                              const EGLint*) {
+  MOCK_EGL_CALL();
+  const Config* c = static_cast<const Config*>(config);
+  if (win == NULL) {
+    SetEglError(EGL_BAD_NATIVE_WINDOW);
+    return EGL_NO_SURFACE;
+  }
+  if (!(GetSurfaceType(c) & EGL_WINDOW_BIT)) {
+    SetEglError(EGL_BAD_MATCH);
+    return EGL_NO_SURFACE;
+  }
+  // A window has one producer at a time
+  if (win->connected) {
+    SetEglError(EGL_BAD_ALLOC);
+    return EGL_NO_SURFACE;
+  }
+  win->connected = true;
+  Surface* surface = new Surface();
+  surface->config = c;
+  surface->window = win;
+  surface->width = win->buffers_width ? win->buffers_width : win->width;
+  surface->height = win->buffers_height ? win->buffers_height : win->height;
+  surface->current = false;
+  surface->destroyed = false;
+  g_surfaces.insert(surface);
+  return surface;
+}
+
+EGLSurface EGLAPIENTRY eglCreatePbufferSurface(EGLDisplay, EGLConfig config,
+                                               const EGLint* attrib_list) {
+  MOCK_EGL_CALL();
+  const Config* c = static_cast<const Config*>(config);
+  if (!(GetSurfaceType(c) & EGL_PBUFFER_BIT)) {
+    SetEglError(EGL_BAD_MATCH);
+    return EGL_NO_SURFACE;
+  }
+  Surface* surface = new Surface();
+  surface->config = c;
+  surface->window = NULL;
+  surface->width = 0;
+  surface->height = 0;
+  for (const EGLint* a = attrib_list; a && *a != EGL_NONE; a += 2) {
+    if (a[0] == EGL_WIDTH) surface->width = a[1];
+    if (a[0] == EGL_HEIGHT) surface->height = a[1];
+  }
+  surface->current = false;
+  surface->destroyed = false;
+  g_surfaces.insert(surface);
+  return surface;
+}
+
+EGLBoolean EGLAPIENTRY eglDestroySurface(EGLDisplay, EGLSurface surface) {
+  MOCK_EGL_CALL();
+  if (!IsLiveSurface(surface)) {
+    SetEglError(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+  }
+  Surface* s = static_cast<Surface*>(surface);
+  s->destroyed = true;
+  if (!s->current) {
+    if (s->window) s->window->connected = false;
+    g_surfaces.erase(s);
+    delete s;
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay, EGLSurface surface,
+                                       EGLint attribute, EGLint* value) {
+  MOCK_EGL_CALL();
+  if (!IsLiveSurface(surface)) {
+    SetEglError(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+  }
+  const Surface* s = static_cast<const Surface*>(surface);
+  switch (attribute) {
+    case EGL_WIDTH:
+      *value = s->width;
+      break;
+    case EGL_HEIGHT:
+      *value = s->height;
+      break;
+    case EGL_CONFIG_ID:
+      *value = s->config->id;
+      break;
+    default:
+      SetEglError(EGL_BAD_ATTRIBUTE);
+      return EGL_FALSE;
+  }
+  return EGL_TRUE;
+}
+
+EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay, EGLConfig config,
+                                        EGLContext share_context,
+                                        const EGLint*) {
+  MOCK_EGL_CALL();
+  if (share_context != EGL_NO_CONTEXT && !IsLiveContext(share_context)) {
+    SetEglError(EGL_BAD_CONTEXT);
+    return EGL_NO_CONTEXT;
+  }
+  Context* context = new Context();
+  context->config = static_cast<const Config*>(config);
+  context->share_group =
+      share_context != EGL_NO_CONTEXT
+          ? static_cast<Context*>(share_context)->share_group
+          : g_next_share_group++;
+  context->state = DefaultContextState();
+  context->current = false;
+  context->destroyed = false;
+  g_contexts.insert(context);
+  return context;
+}
+
+EGLBoolean EGLAPIENTRY eglDestroyContext(EGLDisplay, EGLContext context) {
+  MOCK_EGL_CALL();
+  if (!IsLiveContext(context)) {
+    SetEglError(EGL_BAD_CONTEXT);
+    return EGL_FALSE;
+  }
+  Context* c = static_cast<Context*>(context);
+  c->destroyed = true;
+  if (!c->current) {
+    g_contexts.erase(c);
+    delete c;
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay, EGLSurface draw,
+                                      EGLSurface read, EGLContext ctx) {
+  MOCK_EGL_CALL();
+  if (ctx == EGL_NO_CONTEXT) {
+    if (draw != EGL_NO_SURFACE || read != EGL_NO_SURFACE) {
+      SetEglError(EGL_BAD_MATCH);
+      return EGL_FALSE;
+    }
+    ReleaseCurrent();
+    return EGL_TRUE;
+  }
+  if (!IsLiveContext(ctx)) {
+    SetEglError(EGL_BAD_CONTEXT);
+    return EGL_FALSE;
+  }
+  if (!IsLiveSurface(draw) || !IsLiveSurface(read)) {
+    SetEglError(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+  }
+  Context* context = static_cast<Context*>(ctx);
+  Surface* surface = static_cast<Surface*>(draw);
+  if (draw != read || surface->config != context->config) {
+    SetEglError(EGL_BAD_MATCH);
+    return EGL_FALSE;
+  }
+  if ((context->current && context != t_context) ||
+      (surface->current && surface != t_surface)) {
+    SetEglError(EGL_BAD_ACCESS);
+    return EGL_FALSE;
+  }
+  ReleaseCurrent();
+  context->current = true;
+  surface->current = true;
+  t_context = context;
+  t_surface = surface;
+  return EGL_TRUE;
+}
+
+EGLContext EGLAPIENTRY eglGetCurrentContext() { return t_context; }
+
+EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint) { return t_surface; }
+
+EGLBoolean EGLAPIENTRY eglReleaseThread() {
+  MOCK_EGL_CALL();
+  ReleaseCurrent();
+  return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay, EGLSurface surface) {
+  MOCK_EGL_CALL();
+  Surface* s = static_cast<Surface*>(surface);
+  if (!IsLiveSurface(surface) || s != t_surface || s->window == NULL) {
+    SetEglError(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+  }
+  // The next buffer is dequeued at the window's current geometry
+  ANativeWindow* win = s->window;
+  s->width = win->buffers_width ? win->buffers_width : win->width;
+  s->height = win->buffers_height ? win->buffers_height : win->height;
+  return EGL_TRUE;
+}
+
+//--------------------------------------------------------------------------------
+// EGL_KHR_fence_sync, on the fences of the GL mock
+//--------------------------------------------------------------------------------
+namespace {
+
+EGLSyncKHR EGLAPIENTRY MockCreateSyncKHR(EGLDisplay, EGLenum type,
+                                         const EGLint* attrib_list) {
+  std::lock_guard<std::mutex> egl_lock(g_mutex);
+  CountCall("eglCreateSyncKHR");
+  if (type != EGL_SYNC_FENCE_KHR ||
+      (attrib_list && attrib_list[0] != EGL_NONE)) {
+    SetEglError(EGL_BAD_ATTRIBUTE);
+    return EGL_NO_SYNC_KHR;
+  }
+  // The fence goes in the command stream of the current context
+  if (t_context == NULL) {
+    SetEglError(EGL_BAD_MATCH);
+    return EGL_NO_SYNC_KHR;
+  }
+  g_fences[g_next_name] = false;
+  return reinterpret_cast<EGLSyncKHR>((uintptr_t)g_next_name++);
+}
+
+std::map<GLuint, bool>::iterator FindEglFence(EGLSyncKHR sync) {
+  return g_fences.find((GLuint) reinterpret_cast<uintptr_t>(sync));
+}
+
+EGLint EGLAPIENTRY MockClientWaitSyncKHR(EGLDisplay, EGLSyncKHR sync,
+                                         EGLint flags, EGLTimeKHR timeout) {
+  std::lock_guard<std::mutex> egl_lock(g_mutex);
+  CountCall("eglClientWaitSyncKHR");
+  std::map<GLuint, bool>::iterator fence = FindEglFence(sync);
+  if (fence == g_fences.end() || (flags & ~EGL_SYNC_FLUSH_COMMANDS_BIT_KHR)) {
+    SetEglError(EGL_BAD_PARAMETER);
+    return EGL_FALSE;
+  }
+  // Unlike glClientWaitSync(), a signaled fence satisfies the wait
+  if (fence->second) return EGL_CONDITION_SATISFIED_KHR;
+  if (timeout == 0) return EGL_TIMEOUT_EXPIRED_KHR;
+  ++g_fence_waits;
+  if (g_driver.gpu_hung_) return EGL_TIMEOUT_EXPIRED_KHR;
+  // The GPU finishes its work in order
+  ++fence;
+  for (std::map<GLuint, bool>::iterator it = g_fences.begin(); it != fence;
+       ++it)
+    it->second = true;
+  return EGL_CONDITION_SATISFIED_KHR;
+}
+
+EGLBoolean EGLAPIENTRY MockDestroySyncKHR(EGLDisplay, EGLSyncKHR sync) {
+  std::lock_guard<std::mutex> egl_lock(g_mutex);
+  CountCall("eglDestroySyncKHR");
+  std::map<GLuint, bool>::iterator fence = FindEglFence(sync);
+  if (fence == g_fences.end()) {
+    SetEglError(EGL_BAD_PARAMETER);
+    return EGL_FALSE;
+  }
+  g_fences.erase(fence);
+  return EGL_TRUE;
+}
+
+}  // namespace
+
+__eglMustCastToProperFunctionPointerType EGLAPIENTRY
+eglGetProcAddress(const char* procname) {
+  MOCK_CALL();
+  static const struct {
+    const char* name;
+    __eglMustCastToProperFunctionPointerType function;
+  } FUNCTIONS[] = {
+      {"glGetProgramBinary",
+       (__eglMustCastToProperFunctionPointerType)MockGetProgramBinary},
+      {"glGetProgramBinaryOES",
+       (__eglMustCastToProperFunctionPointerType)MockGetProgramBinary},
+      {"glProgramBinary",
+       (__eglMustCastToProperFunctionPointerType)MockProgramBinary},
+      {"glProgramBinaryOES",
+       (__eglMustCastToProperFunctionPointerType)MockProgramBinary},
+      {"glProgramParameteri",
+       (__eglMustCastToProperFunctionPointerType)MockProgramParameteri},
+      {"glMapBufferRange",
+       (__eglMustCastToProperFunctionPointerType)MockMapBufferRange},
+      {"glUnmapBuffer",
+       (__eglMustCastToProperFunctionPointerType)MockUnmapBuffer},
+      {"glFlushMappedBufferRange",
+       (__eglMustCastToProperFunctionPointerType)MockFlushMappedBufferRange},
+      {"glFenceSync",
+       (__eglMustCastToProperFunctionPointerType)MockFenceSync},
+      {"glClientWaitSync",
+       (__eglMustCastToProperFunctionPointerType)MockClientWaitSync},
+      {"glDeleteSync",
+       (__eglMustCastToProperFunctionPointerType)MockDeleteSync},
+      {"eglCreateSyncKHR",
+       (__eglMustCastToProperFunctionPointerType)MockCreateSyncKHR},
+      {"eglClientWaitSyncKHR",
+       (__eglMustCastToProperFunctionPointerType)MockClientWaitSyncKHR},
+      {"eglDestroySyncKHR",
+       (__eglMustCastToProperFunctionPointerType)MockDestroySyncKHR},
+  };
+  for (size_t i = 0; i < sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]); ++i)
+    if (!strcmp(procname, FUNCTIONS[i].name)) return FUNCTIONS[i].function;
+  // An ES3 driver resolves every GL entry point
+  if (IsEs3() && !strncmp(procname, "gl", 2))
+    return (__eglMustCastToProperFunctionPointerType)MockMissing;
+  return NULL;
+}
+
+}  // extern "C"
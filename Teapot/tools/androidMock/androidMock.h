@@ -0,0 +1,220 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MOCK_H_
+#define ANDROID_MOCK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include <android/asset_manager.h>
+#include <android/native_window.h>
+
+/******************************************************************
+ * Host mock of the Android, EGL and GLES calls ndk_helper makes
+ * Lets the host tests in tools/ link the GL and asset code of ndk_helper
+ * unchanged: include/ holds stand-ins for the NDK headers, androidMock.cpp
+ * implements the calls (GL and EGL with the host's Khronos headers). It
+ * also provides the JNIHelper methods the linked code uses, so JNIHelper.cpp
+ * is left out.
+ *
+ * The GL mock draws nothing: it tracks objects and their state, so tests can
+ * check what ndk_helper created, uploaded and linked. Every mocked call is
+ * counted.
+ */
+namespace android_mock {
+
+// Assets and JNIHelper::ReadFile() files are read from this directory
+void SetAssetDir(const char* dir);
+AAssetManager* GetAssetManager();
+// AAsset_openFileDescriptor() gives uncompressed assets in a package file,
+// MOCK_ASSET_OFFSET bytes in (not page aligned, as in an APK). Compressed
+// ones have no descriptor, only AAsset_getBuffer().
+const off_t MOCK_ASSET_OFFSET = 5001;
+void SetCompressedAssets(const bool compressed);
+
+// Print LOGI output too, not only warnings and errors
+void SetVerbose(const bool verbose);
+
+// Calls of a mocked function, by name, since the last ResetCalls()
+int32_t GetCalls(const char* function);
+void ResetCalls();
+
+/******************************************************************
+ * GL driver
+ * Programs link when both their shaders compiled; a shader fails to
+ * compile if its source holds MOCK_COMPILE_ERROR. The binary of a program
+ * is its sources and attribute bindings, tagged with the renderer string:
+ * glProgramBinary() takes it back only from the same renderer, and only
+ * while accept_binaries_ is set.
+ */
+const char MOCK_COMPILE_ERROR[] = "MOCK_COMPILE_ERROR";
+const GLenum MOCK_BINARY_FORMAT = 0x9130;
+
+struct GlDriver {
+  std::string vendor_;
+  std::string renderer_;
+  std::string version_;
+  std::string extensions_;
+  int32_t binary_formats_;
+  bool accept_binaries_;
+  int32_t max_texture_size_;
+  bool gpu_hung_;  // Waits on fences time out
+};
+
+// Mutable, takes effect on the next call
+GlDriver& GetGlDriver();
+// Back to an ES 3.0 driver with program binaries and ETC1, and no GL objects
+void ResetGl();
+
+// What glProgramBinary()/glLinkProgram() gave a program, "" if not linked
+std::string GetProgramBinary(const GLuint program);
+// Shaders, programs, textures and buffers
+int32_t GetLiveObjects();
+
+/******************************************************************
+ * Textures and buffers
+ * Level 0 of a texture holds real pixels, so uploads can be compared with
+ * their source. Uploads follow GL_UNPACK_ALIGNMENT and read from a bound
+ * GL_PIXEL_UNPACK_BUFFER, and raise the GL errors a driver would: sizes out
+ * of range or past max_texture_size_, a format other than the texture's,
+ * a mapped or too small unpack buffer, glGenerateMipmap() on a compressed
+ * texture or, on ES2, a non power of two one. ETC1 is supported with the
+ * GL_OES_compressed_ETC1_RGB8_texture extension, ETC2 on ES3.
+ *
+ * A mapped buffer range is filled with garbage first, as a driver may hand
+ * out any memory. Flushes must stay in a range mapped with
+ * GL_MAP_FLUSH_EXPLICIT_BIT.
+ */
+struct Texture {
+  int32_t width_;
+  int32_t height_;
+  GLenum format_;  // Internal format
+  bool compressed_;
+  std::vector<uint8_t> pixels_;  // Level 0, rows tightly packed
+  GLint min_filter_;
+  GLint mag_filter_;
+  GLint wrap_s_;
+  GLint wrap_t_;
+  bool mipmaps_;
+};
+
+// NULL if |texture| is not a texture
+const Texture* GetTexture(const GLuint texture);
+// Would sample as a driver does: mipmapped if the filter needs it, and on
+// ES2 a non power of two texture without mipmaps and clamped to its edges
+bool IsTextureComplete(const GLuint texture);
+// NULL if |buffer| is not a buffer
+const std::vector<uint8_t>* GetBufferData(const GLuint buffer);
+// Live buffers last given data through |target|, oldest first
+std::vector<GLuint> GetBuffers(const GLenum target);
+
+/******************************************************************
+ * Fences
+ * The GPU finishes work only when a test tells it to, with SignalFences(),
+ * or when glClientWaitSync() waits on a fence with a timeout: that signals
+ * the fence and every older one, unless gpu_hung_ is set. glFinish() and
+ * mapping a buffer without GL_MAP_UNSYNCHRONIZED_BIT wait for all fences.
+ */
+// Signal the oldest fences, leaving the newest |pending| unsignaled
+void SignalFences(const int32_t pending);
+// Fences not deleted, and how many of them are not signaled
+int32_t GetLiveFences();
+int32_t GetPendingFences();
+// glClientWaitSync() and glMapBufferRange() calls that had to wait for the
+// GPU
+int32_t GetFenceWaits();
+
+/******************************************************************
+ * Draws
+ * Vertex attribute pointers, uniform values and draw calls are recorded,
+ * so a test can fetch what a draw hands the vertex shader.
+ * glGetUniformLocation() finds a uniform only if the program's sources
+ * name it.
+ */
+const int32_t MOCK_MAX_VERTEX_ATTRIBS = 8;
+
+struct VertexAttrib {
+  bool enabled_;
+  GLint size_;
+  GLenum type_;
+  bool normalized_;
+  GLsizei stride_;
+  size_t offset_;
+  GLuint buffer_;
+};
+
+struct Draw {
+  GLenum mode_;
+  GLsizei count_;
+  GLenum type_;  // Of the indices, 0 for glDrawArrays()
+  size_t offset_;  // Of the indices, or first vertex
+  GLuint element_buffer_;
+  GLuint program_;
+  VertexAttrib attribs_[MOCK_MAX_VERTEX_ATTRIBS];
+};
+
+std::vector<Draw> GetDraws();
+// Values last given to a uniform of |program|, empty if never set
+std::vector<float> GetUniform(const GLuint program, const char* name);
+
+/******************************************************************
+ * Native windows and EGL
+ * A window hands out buffers of its own size, or of the size last given to
+ * ANativeWindow_setBuffersGeometry(). As on a device, a window surface
+ * takes a new size only with the next buffer it dequeues: when it is
+ * created, and at every eglSwapBuffers().
+ *
+ * The display has three configs: RGB888 with a 24 and a 16 bit depth
+ * buffer, for windows and pbuffers, and one with no depth buffer for
+ * pbuffers only. eglMakeCurrent() checks what EGL does: a context or
+ * surface current on another thread, a surface made with another config,
+ * a destroyed object. GL calls made with no current context are counted as
+ * MOCK_NO_CONTEXT once EGL is initialized.
+ *
+ * EGL_KHR_fence_sync fences are fences of the GL mock (see Fences above);
+ * eglGetProcAddress() serves the entry points whether or not the extension
+ * is listed, as drivers do.
+ */
+const char MOCK_NO_CONTEXT[] = "GL call with no current context";
+
+struct EglDriver {
+  bool depth24_;         // The 24 bit depth config exists
+  bool window_pbuffer_;  // The window configs make pbuffers too
+  // ANativeWindow_setBuffersGeometry() result for a non zero size
+  int32_t geometry_result_;
+  bool fence_sync_;  // EGL_KHR_fence_sync is in the extension string
+};
+
+// Mutable, takes effect on the next call
+EglDriver& GetEglDriver();
+// Back to all configs, with no EGL objects
+void ResetEgl();
+
+ANativeWindow* CreateWindow(const int32_t width, const int32_t height);
+void DestroyWindow(ANativeWindow* window);
+// Size of the next buffer the window hands out
+void GetBuffersSize(ANativeWindow* window, int32_t* width, int32_t* height);
+// Contexts and surfaces
+int32_t GetLiveEglObjects();
+
+}  // namespace android_mock
+
+#endif /* ANDROID_MOCK_H_ */
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// EGL/eglplatform.h
+// The host's Khronos header, with the Android native types: EGL takes
+// ANativeWindow pointers as on a device
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_EGLPLATFORM_H_
+#define ANDROID_MOCK_EGLPLATFORM_H_
+
+#ifndef ANDROID
+#define ANDROID
+#include_next <EGL/eglplatform.h>
+#undef ANDROID
+#else
+#include_next <EGL/eglplatform.h>
+#endif
+
+#endif /* ANDROID_MOCK_EGLPLATFORM_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// android/api-level.h
+// Host stand-in for the NDK header, the samples' minimum API level
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_API_LEVEL_H_
+#define ANDROID_MOCK_API_LEVEL_H_
+
+#ifndef __ANDROID_API__
+#define __ANDROID_API__ 19
+#endif
+
+#endif /* ANDROID_MOCK_API_LEVEL_H_ */
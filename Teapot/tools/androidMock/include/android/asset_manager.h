@@ -0,0 +1,52 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// android/asset_manager.h
+// Host stand-in for the NDK header; androidMock.cpp serves the assets from a
+// directory, see android_mock::SetAssetDir()
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_ASSET_MANAGER_H_
+#define ANDROID_MOCK_ASSET_MANAGER_H_
+
+#include <sys/types.h>
+
+typedef struct AAssetManager AAssetManager;
+typedef struct AAsset AAsset;
+
+enum {
+  AASSET_MODE_UNKNOWN,
+  AASSET_MODE_RANDOM,
+  AASSET_MODE_STREAMING,
+  AASSET_MODE_BUFFER,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+AAsset* AAssetManager_open(AAssetManager* mgr, const char* filename, int mode);
+off_t AAsset_getLength(AAsset* asset);
+const void* AAsset_getBuffer(AAsset* asset);
+int AAsset_read(AAsset* asset, void* buf, size_t count);
+int AAsset_openFileDescriptor(AAsset* asset, off_t* out_start,
+                              off_t* out_length);
+int AAsset_isAllocated(AAsset* asset);
+void AAsset_close(AAsset* asset);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANDROID_MOCK_ASSET_MANAGER_H_ */
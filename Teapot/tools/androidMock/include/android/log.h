@@ -0,0 +1,40 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// android/log.h
+// Host stand-in for the NDK header; androidMock.cpp prints to stderr
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_LOG_H_
+#define ANDROID_MOCK_LOG_H_
+
+enum {
+  ANDROID_LOG_VERBOSE = 2,
+  ANDROID_LOG_DEBUG,
+  ANDROID_LOG_INFO,
+  ANDROID_LOG_WARN,
+  ANDROID_LOG_ERROR,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int __android_log_print(int prio, const char* tag, const char* fmt, ...);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANDROID_MOCK_LOG_H_ */
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// android/native_window.h
+// Host stand-in for the NDK header, see android_mock::CreateWindow()
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_NATIVE_WINDOW_H_
+#define ANDROID_MOCK_NATIVE_WINDOW_H_
+
+#include <stdint.h>
+
+typedef struct ANativeWindow ANativeWindow;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int32_t ANativeWindow_getWidth(ANativeWindow* window);
+int32_t ANativeWindow_getHeight(ANativeWindow* window);
+int32_t ANativeWindow_getFormat(ANativeWindow* window);
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width,
+                                         int32_t height, int32_t format);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANDROID_MOCK_NATIVE_WINDOW_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// android_native_app_glue.h
+// Host stand-in for the NDK header: the android_app fields ndk_helper reads
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_NATIVE_APP_GLUE_H_
+#define ANDROID_MOCK_NATIVE_APP_GLUE_H_
+
+#include <android/native_activity.h>
+
+typedef struct AInputEvent AInputEvent;
+typedef struct AConfiguration AConfiguration;
+typedef struct ALooper ALooper;
+
+struct android_app {
+  void* userData;
+  void (*onAppCmd)(struct android_app* app, int32_t cmd);
+  int32_t (*onInputEvent)(struct android_app* app, AInputEvent* event);
+  ANativeActivity* activity;
+  AConfiguration* config;
+  void* savedState;
+  size_t savedStateSize;
+  ALooper* looper;
+  ANativeWindow* window;
+  int destroyRequested;
+};
+
+#endif /* ANDROID_MOCK_NATIVE_APP_GLUE_H_ */
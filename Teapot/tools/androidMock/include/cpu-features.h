@@ -0,0 +1,26 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// cpu-features.h
+// Host stand-in for the NDK cpufeatures header: included, nothing used
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_CPU_FEATURES_H_
+#define ANDROID_MOCK_CPU_FEATURES_H_
+
+#include <stdint.h>
+
+#endif /* ANDROID_MOCK_CPU_FEATURES_H_ */
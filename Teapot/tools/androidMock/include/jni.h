@@ -0,0 +1,40 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// jni.h
+// Host stand-in for the NDK header: the types ndk_helper declares, no JNI
+//--------------------------------------------------------------------------------
+#ifndef ANDROID_MOCK_JNI_H_
+#define ANDROID_MOCK_JNI_H_
+
+#include <stdint.h>
+
+typedef struct _JNIEnv JNIEnv;
+typedef struct _JavaVM JavaVM;
+typedef void* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef void* jmethodID;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef uint8_t jboolean;
+typedef float jfloat;
+
+#define JNIEXPORT
+#define JNICALL
+
+#endif /* ANDROID_MOCK_JNI_H_ */
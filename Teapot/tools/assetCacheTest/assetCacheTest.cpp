@@ -0,0 +1,341 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// assetCacheTest.cpp
+// Host test and benchmark of ndk_helper AssetCache
+//
+// Views of loose files and of uncompressed assets (mapped at their offset in
+// the package, through the AAsset mock of tools/androidMock) must point into
+// a file mapping, the same memory for every open and copy: no byte is
+// copied. Compressed assets must be the asset manager's own buffer. All must
+// read back the file's bytes, whatever their size, and stay valid while a
+// view holds them across Trim() and Init(). Threads opening, copying and
+// trimming at once must always see the right contents.
+//
+// Then times reading a file into a vector, as JNIHelper::ReadFile() did,
+// against a first and a cached Open(), each touching every page.
+//
+// Build and run on the host, from this directory (assetCache.cpp with
+// __ANDROID__ defined, for the asset manager path):
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  g++ -O2 -c -D__ANDROID__ -I$MOCK/include -I$NDK_HELPER
+//  $NDK_HELPER/assetCache.cpp
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER -o assetCacheTest
+//  assetCacheTest.cpp assetCache.o $MOCK/androidMock.cpp
+//  ./assetCacheTest
+//--------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "androidMock.h"
+#include "assetCache.h"
+
+using ndk_helper::AssetCache;
+using ndk_helper::AssetView;
+
+namespace {
+
+const int32_t THREADS = 8;
+const int32_t BENCH_SIZE = 100 * 1024;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+std::string g_files_dir;
+std::string g_asset_dir;
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+std::string Contents(const int32_t size, const int32_t seed) {
+  std::string contents(size, 0);
+  for (int32_t i = 0; i < size; ++i)
+    contents[i] = (char)((i * 31 + seed * 7 + (i >> 8)) & 0xff);
+  return contents;
+}
+
+void WriteFile(const std::string& file_name, const std::string& contents) {
+  FILE* f = fopen(file_name.c_str(), "wb");
+  fwrite(contents.data(), 1, contents.size(), f);
+  fclose(f);
+}
+
+bool Same(const AssetView& view, const std::string& contents) {
+  return view.IsValid() && view.Size() == contents.size() &&
+         (contents.empty() || !memcmp(view.Data(), contents.data(),
+                                      contents.size()));
+}
+
+// True if |p| lies in a file backed mapping of this process
+bool InFileMapping(const void* p) {
+  FILE* f = fopen("/proc/self/maps", "r");
+  if (f == NULL) return false;
+  char line[512];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), f)) {
+    unsigned long begin, end, inode;
+    char path[256] = "";
+    if (sscanf(line, "%lx-%lx %*s %*s %*s %lu %255s", &begin, &end, &inode,
+               path) < 3)
+      continue;
+    found = (uintptr_t)p >= begin && (uintptr_t)p < end && inode != 0 &&
+            path[0] == '/';
+  }
+  fclose(f);
+  return found;
+}
+
+//--------------------------------------------------------------------------------
+// Zero copy
+//--------------------------------------------------------------------------------
+void TestSource(const char* label, const bool asset, const bool compressed) {
+  const std::string& dir = asset ? g_asset_dir : g_files_dir;
+  const int32_t page = (int32_t)sysconf(_SC_PAGESIZE);
+  const int32_t SIZES[] = {0, 1, 7, page - 1, page, page + 1, 3 * page + 5,
+                           BENCH_SIZE};
+  AssetCache* cache = AssetCache::GetInstance();
+  android_mock::SetCompressedAssets(compressed);
+
+  for (size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "file%d.bin", SIZES[i]);
+    const std::string contents = Contents(SIZES[i], (int32_t)i);
+    WriteFile(dir + "/" + name, contents);
+
+    android_mock::ResetCalls();
+    AssetView view = cache->Open(name);
+    CHECK(Same(view, contents), "%s: %d bytes read back wrong", label,
+          SIZES[i]);
+    if (SIZES[i] && !compressed)
+      CHECK(InFileMapping(view.Data()), "%s: %d bytes not mapped", label,
+            SIZES[i]);
+    if (asset)
+      CHECK(android_mock::GetCalls("AAsset_getBuffer") == (compressed ? 1 : 0),
+            "%s: %d bytes, %d AAsset_getBuffer()", label, SIZES[i],
+            android_mock::GetCalls("AAsset_getBuffer"));
+
+    // Opens and copies share the memory, the second open is a lookup
+    AssetView again = cache->Open(name);
+    AssetView copy = view;
+    AssetView assigned;
+    assigned = again;
+    CHECK(again.Data() == view.Data() && copy.Data() == view.Data() &&
+              assigned.Data() == view.Data(),
+          "%s: %d bytes, views of the same file differ", label, SIZES[i]);
+    CHECK(android_mock::GetCalls("AAssetManager_open") <= 1,
+          "%s: opened again", label);
+    unlink((dir + "/" + name).c_str());
+  }
+  cache->Trim();
+  android_mock::SetCompressedAssets(false);
+}
+
+void TestLookup() {
+  AssetCache* cache = AssetCache::GetInstance();
+
+  // A loose file hides the asset of the same name
+  WriteFile(g_asset_dir + "/both.txt", "asset");
+  WriteFile(g_files_dir + "/both.txt", "loose");
+  CHECK(Same(cache->Open("both.txt"), "loose"), "loose file not preferred");
+  unlink((g_files_dir + "/both.txt").c_str());
+  cache->Trim();
+  CHECK(Same(cache->Open("both.txt"), "asset"), "asset not found");
+
+  CHECK(!cache->Open("missing.txt").IsValid(), "missing file opened");
+  AssetView invalid;
+  CHECK(!invalid.IsValid() && invalid.Data() == NULL && invalid.Size() == 0,
+        "default view not empty");
+
+  // Without an asset manager only loose files are found
+  cache->Init(NULL, g_files_dir.c_str());
+  CHECK(!cache->Open("both.txt").IsValid(), "asset found without a manager");
+  cache->Init(android_mock::GetAssetManager(), g_files_dir.c_str());
+  unlink((g_asset_dir + "/both.txt").c_str());
+}
+
+void TestLifetime() {
+  AssetCache* cache = AssetCache::GetInstance();
+  const std::string contents = Contents(BENCH_SIZE, 1);
+  WriteFile(g_files_dir + "/held.bin", contents);
+
+  AssetView held = cache->Open("held.bin");
+  const uint8_t* data = held.Data();
+  unlink((g_files_dir + "/held.bin").c_str());
+
+  // Neither Trim() nor Init() takes the memory from a view
+  cache->Trim();
+  CHECK(cache->Open("held.bin").Data() == data, "Trim() dropped a held file");
+  cache->Init(android_mock::GetAssetManager(), g_files_dir.c_str());
+  CHECK(Same(held, contents) && InFileMapping(data),
+        "view not valid after Init()");
+  CHECK(!cache->Open("held.bin").IsValid(), "Init() kept the cached file");
+
+  // The last view unmaps it
+  held = AssetView();
+  CHECK(!InFileMapping(data), "file still mapped after the last view");
+
+  // A Trim() with no views left unmaps too
+  WriteFile(g_files_dir + "/held.bin", contents);
+  data = cache->Open("held.bin").Data();
+  CHECK(InFileMapping(data), "cached file not mapped");
+  cache->Trim();
+  CHECK(!InFileMapping(data), "file still mapped after Trim()");
+  unlink((g_files_dir + "/held.bin").c_str());
+}
+
+void TestThreads() {
+  const int32_t FILES = 16;
+  std::vector<std::string> contents;
+  for (int32_t i = 0; i < FILES; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "/thread%d.bin", i);
+    contents.push_back(Contents(1000 + i * 997, i));
+    WriteFile((i & 1 ? g_asset_dir : g_files_dir) + name, contents.back());
+  }
+
+  std::atomic<int32_t> errors(0);
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < THREADS; ++t) {
+    threads.push_back(std::thread([t, &contents, &errors]() {
+      uint32_t seed = t * 7919 + 1;
+      std::vector<AssetView> kept;
+      for (int32_t i = 0; i < 5000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const int32_t file = (seed >> 16) % FILES;
+        char name[32];
+        snprintf(name, sizeof(name), "thread%d.bin", file);
+        AssetView view = AssetCache::GetInstance()->Open(name);
+        if (!Same(view, contents[file])) errors++;
+        if ((seed >> 8) % 4 == 0) kept.push_back(view);
+        if (kept.size() > 8) kept.erase(kept.begin());
+        if ((seed >> 12) % 64 == 0) AssetCache::GetInstance()->Trim();
+      }
+    }));
+  }
+  for (int32_t t = 0; t < THREADS; ++t) threads[t].join();
+  CHECK(errors.load() == 0, "%d wrong views across threads", errors.load());
+  AssetCache::GetInstance()->Trim();
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+// The copy JNIHelper::ReadFile() made before AssetCache
+bool ReadCopy(const std::string& file_name, std::vector<uint8_t>* data) {
+  FILE* f = fopen(file_name.c_str(), "rb");
+  if (f == NULL) return false;
+  fseek(f, 0, SEEK_END);
+  data->resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  const bool ok = fread(&(*data)[0], 1, data->size(), f) == data->size();
+  fclose(f);
+  return ok;
+}
+
+template <typename F>
+double TimeUs(const int32_t runs, F run) {
+  double best = 1e30;
+  for (int32_t r = 0; r < 5; ++r) {
+    const double start = NowNs();
+    for (int32_t i = 0; i < runs; ++i) run();
+    best = std::min(best, (NowNs() - start) / runs / 1000.0);
+  }
+  return best;
+}
+
+uint32_t TouchPages(const uint8_t* data, const size_t size) {
+  uint32_t sum = 0;
+  for (size_t i = 0; i < size; i += 4096) sum += data[i];
+  return sum;
+}
+
+void Benchmark() {
+  AssetCache* cache = AssetCache::GetInstance();
+  const std::string file_name = g_files_dir + "/bench.bin";
+  WriteFile(file_name, Contents(BENCH_SIZE, 3));
+  volatile uint32_t sink = 0;
+
+  const double copy = TimeUs(200, [&]() {
+    std::vector<uint8_t> data;
+    ReadCopy(file_name, &data);
+    sink += TouchPages(&data[0], data.size());
+  });
+  const double first = TimeUs(200, [&]() {
+    cache->Trim();
+    AssetView view = cache->Open("bench.bin");
+    sink += TouchPages(view.Data(), view.Size());
+  });
+  AssetView held = cache->Open("bench.bin");
+  const double cached = TimeUs(20000, [&]() {
+    AssetView view = cache->Open("bench.bin");
+    sink += TouchPages(view.Data(), view.Size());
+  });
+  printf("%dKB file: copy %.1fus, first Open %.1fus, cached Open %.2fus\n",
+         BENCH_SIZE / 1024, copy, first, cached);
+  held = AssetView();
+  cache->Trim();
+  unlink(file_name.c_str());
+}
+
+}  // namespace
+
+int main() {
+  char dir[] = "/tmp/assetCacheTest.XXXXXX";
+  if (!mkdtemp(dir)) return 1;
+  g_files_dir = std::string(dir) + "/files";
+  g_asset_dir = std::string(dir) + "/assets";
+  mkdir(g_files_dir.c_str(), 0700);
+  mkdir(g_asset_dir.c_str(), 0700);
+  android_mock::SetAssetDir(g_asset_dir.c_str());
+  AssetCache::GetInstance()->Init(android_mock::GetAssetManager(),
+                                  g_files_dir.c_str());
+
+  TestSource("loose file", false, false);
+  TestSource("stored asset", true, false);
+  TestSource("compressed asset", true, true);
+  TestLookup();
+  TestLifetime();
+  TestThreads();
+  Benchmark();
+
+  const std::string command = std::string("rm -rf ") + dir;
+  if (system(command.c_str())) printf("Could not remove %s\n", dir);
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
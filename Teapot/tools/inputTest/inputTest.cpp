@@ -0,0 +1,546 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// inputTest.cpp
+// Host test of ndk_helper touch resampling and camera momentum
+//
+// InputResampler is fed synthetic touch streams at panel rates of 60, 120
+// and 240Hz. Between samples it must follow a straight motion exactly and a
+// curved one within the linear interpolation error bound. Past the last
+// sample it must predict no further than half the last interval and
+// INPUT_MAX_PREDICTION, and not at all from samples under
+// INPUT_MIN_SAMPLE_INTERVAL apart. Late samples are dropped, samples of the
+// same time replaced, and the oldest overwritten when full. The release
+// velocity must be the motion's over the last INPUT_VELOCITY_WINDOW, and zero
+// once the finger rested INPUT_VELOCITY_STOP.
+//
+// TapCamera then replays a drag and a pinch, each ending in a fling, at 30,
+// 60, 90 and 120 fps: the camera must show the same pose at the display
+// times the rates share, while the finger is down and during the momentum.
+// Dragging, the pose must be that of the finger at the resampled time,
+// within the interpolation error. After the release, the rotation and the
+// offset must follow the decay of the release velocity in closed form, and
+// stop when it falls under the threshold.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  g++ -O2 -I$MOCK/include -I$NDK_HELPER -o inputTest inputTest.cpp
+//  $NDK_HELPER/inputResampler.cpp $NDK_HELPER/tapCamera.cpp
+//  $NDK_HELPER/vecmath.cpp
+//  ./inputTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "inputResampler.h"
+#include "tapCamera.h"
+
+using ndk_helper::InputResampler;
+using ndk_helper::Mat4;
+using ndk_helper::TapCamera;
+using ndk_helper::Vec2;
+
+namespace {
+
+const double PANEL_RATES[] = {60., 120., 240.};
+const int32_t FRAME_RATES[] = {30, 60, 90, 120};
+// Display times are counted in 1/360s ticks, so that the frame rates share
+// theirs exactly: every 12 ticks
+const int32_t TICKS_PER_SECOND = 360;
+const int32_t SHARED_TICKS = 12;
+// Sample times are not aligned with frames
+const double SAMPLE_PHASE = 0.0063;
+
+// Gestures: a wave, then a straight fling at the velocity it ends with
+const double CURVE_TIME = 0.3;
+const double FLING_TIME = 0.2;
+const double MOMENTUM_TIME = 1.5;
+const float FLING_VELOCITY[] = {0.9f, 0.4f};
+
+// Of TapCamera
+const float BALL_RADIUS = 0.75f;
+const float TRANSFORM_FACTOR = 15.f;
+const float MOMENTUM_FRAME_TIME = 1.f / 60.f;
+const float MOMENTUM_FACTOR_DECREASE = 0.85f;
+const float MOMENTUM_FACTOR_DECREASE_SHIFT = 0.9f;
+const float MOMENTUM_FACTOR_THRESHOLD = 0.001f;
+const float MOMENTUM_GAIN = 2.2f;
+
+// Float positions near 1
+const float POSITION_EPSILON = 1e-5f;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+float Distance(const Vec2& a, const Vec2& b) { return (a - b).Length(); }
+
+//--------------------------------------------------------------------------------
+// Synthetic motions, of the time since the gesture began
+//--------------------------------------------------------------------------------
+Vec2 Line(const double t) {
+  return Vec2((float)(-0.4 + 0.8 * t), (float)(0.3 - 0.5 * t));
+}
+
+// A circle, |p''| = radius * w^2
+const float CIRCLE_RADIUS = 0.5f;
+const float CIRCLE_SPEED = 2.f * (float)M_PI;
+
+Vec2 Circle(const double t) {
+  return Vec2(CIRCLE_RADIUS * (float)cos(CIRCLE_SPEED * t),
+              CIRCLE_RADIUS * (float)sin(CIRCLE_SPEED * t));
+}
+
+// One period of a sine wave then the fling, with no kink in between for the
+// interpolation error bound to hold. Stays well inside the trackball.
+const double WAVE_SPEED = 2. * M_PI / CURVE_TIME;
+
+Vec2 Finger(const double t) {
+  const double tc = std::min(t, CURVE_TIME);
+  Vec2 p((float)(-0.3 + FLING_VELOCITY[0] / WAVE_SPEED * sin(WAVE_SPEED * tc)),
+         (float)(-0.1 + FLING_VELOCITY[1] * tc));
+  if (t > CURVE_TIME) {
+    p += Vec2(FLING_VELOCITY[0], FLING_VELOCITY[1]) * (float)(t - CURVE_TIME);
+  }
+  return p;
+}
+
+float FingerMaxAcceleration() {
+  return FLING_VELOCITY[0] * (float)WAVE_SPEED;
+}
+
+// Pointers of a pinch: spreading and turning, the center moving linearly
+void PinchPointers(const double t, Vec2* pointers) {
+  const float angle = 0.3f + 1.2f * (float)t;
+  const float half = 0.2f + 0.5f * (float)t;
+  const Vec2 center((float)(0.1 * t), (float)(-0.05 + 0.2 * t));
+  const Vec2 arm(half * cosf(angle), half * sinf(angle));
+  pointers[0] = center + arm;
+  pointers[1] = center - arm;
+}
+const float PINCH_CENTER_VELOCITY[] = {0.1f, 0.2f};
+
+std::vector<double> SampleTimes(const double start, const double hz,
+                                const double duration) {
+  std::vector<double> times;
+  for (int32_t i = 0;; ++i) {
+    const double t = SAMPLE_PHASE + i / hz;
+    if (t > duration) break;
+    times.push_back(start + t);
+  }
+  return times;
+}
+
+//--------------------------------------------------------------------------------
+// Rotation matrices
+//--------------------------------------------------------------------------------
+// Angle of a * b^T, from the upper 3x3 of the column major matrices
+double RotationAngle(Mat4& a, Mat4& b) {
+  const float* ma = a.Ptr();
+  const float* mb = b.Ptr();
+  double r[3][3];
+  for (int32_t i = 0; i < 3; ++i) {
+    for (int32_t j = 0; j < 3; ++j) {
+      r[i][j] = 0.;
+      for (int32_t k = 0; k < 3; ++k)
+        r[i][j] += (double)ma[k * 4 + i] * mb[k * 4 + j];
+    }
+  }
+  // atan2 of sin and cos stays accurate for tiny angles, acos does not
+  const double x = r[2][1] - r[1][2];
+  const double y = r[0][2] - r[2][0];
+  const double z = r[1][0] - r[0][1];
+  return atan2(0.5 * sqrt(x * x + y * y + z * z),
+               0.5 * (r[0][0] + r[1][1] + r[2][2] - 1.));
+}
+
+double MaxDifference(Mat4& a, Mat4& b) {
+  double d = 0.;
+  for (int32_t i = 0; i < 16; ++i)
+    d = std::max(d, fabs((double)a.Ptr()[i] - b.Ptr()[i]));
+  return d;
+}
+
+//--------------------------------------------------------------------------------
+// InputResampler
+//--------------------------------------------------------------------------------
+void TestResampler() {
+  printf("InputResampler\n");
+  for (size_t r = 0; r < sizeof(PANEL_RATES) / sizeof(PANEL_RATES[0]); ++r) {
+    const double hz = PANEL_RATES[r];
+    const double interval = 1. / hz;
+
+    // Straight motion, with a second pointer going the other way
+    InputResampler resampler;
+    const std::vector<double> times = SampleTimes(10., hz, 0.1);
+    for (size_t i = 0; i < times.size(); ++i) {
+      const Vec2 pointers[] = {Line(times[i] - 10.), Line(10. - times[i])};
+      resampler.AddSample(times[i], pointers, 2);
+    }
+    const double first = times[0], last = times.back();
+    float error = 0.f;
+    for (double t = first; t <= last; t += interval / 7.) {
+      Vec2 p[ndk_helper::INPUT_MAX_POINTERS];
+      resampler.Resample(t, p);
+      error = std::max(error, Distance(p[0], Line(t - 10.)));
+      error = std::max(error, Distance(p[1], Line(10. - t)));
+    }
+    CHECK(error <= POSITION_EPSILON, "%gHz line off by %g", hz, error);
+
+    // Past the last sample, up to the prediction limit only
+    const double prediction =
+        std::min(interval * 0.5, ndk_helper::INPUT_MAX_PREDICTION);
+    Vec2 p[ndk_helper::INPUT_MAX_POINTERS];
+    resampler.Resample(last + prediction * 0.5, p);
+    CHECK(Distance(p[0], Line(last + prediction * 0.5 - 10.)) <=
+              POSITION_EPSILON,
+          "%gHz prediction off", hz);
+    resampler.Resample(last + 1., p);
+    CHECK(Distance(p[0], Line(last + prediction - 10.)) <= POSITION_EPSILON,
+          "%gHz prediction past %gms", hz, prediction * 1e3);
+    // Before the first sample, the first sample
+    resampler.Resample(first - 1., p);
+    CHECK(Distance(p[0], Line(first - 10.)) <= POSITION_EPSILON,
+          "%gHz before the first sample", hz);
+
+    // Release velocity of the line, and of the second pointer
+    const Vec2 velocity = Line(1.) - Line(0.);
+    const Vec2 reverse = velocity * -1.f;
+    CHECK(Distance(resampler.GetVelocity(0, last), velocity) <= 1e-3f &&
+              Distance(resampler.GetVelocity(1, last + 0.01), reverse) <= 1e-3f,
+          "%gHz velocity off", hz);
+    CHECK(resampler.GetVelocity(0, last + ndk_helper::INPUT_VELOCITY_STOP +
+                                       0.001).Length() == 0.f,
+          "%gHz velocity after the finger stopped", hz);
+
+    // Circle: within the linear interpolation error |p''| * h^2 / 8
+    resampler.Reset();
+    const std::vector<double> circle_times = SampleTimes(0., hz, 0.5);
+    for (size_t i = 0; i < circle_times.size(); ++i) {
+      const Vec2 pointer = Circle(circle_times[i]);
+      resampler.AddSample(circle_times[i], &pointer, 1);
+    }
+    const float bound = CIRCLE_RADIUS * CIRCLE_SPEED * CIRCLE_SPEED *
+                            (float)(interval * interval) / 8.f +
+                        POSITION_EPSILON;
+    // The resampler keeps the last INPUT_MAX_SAMPLES
+    const int32_t kept = std::min((int32_t)circle_times.size(),
+                                  ndk_helper::INPUT_MAX_SAMPLES);
+    CHECK(resampler.GetSampleCount() == kept, "%gHz kept %d samples, not %d",
+          hz, resampler.GetSampleCount(), kept);
+    error = 0.f;
+    const double oldest = circle_times[circle_times.size() - kept];
+    for (double t = oldest; t <= circle_times.back(); t += interval / 7.) {
+      resampler.Resample(t, p);
+      error = std::max(error, Distance(p[0], Circle(t)));
+    }
+    CHECK(error <= bound, "%gHz circle off by %g, bound %g", hz, error, bound);
+    // Times before the oldest kept sample give that sample
+    resampler.Resample(circle_times[0], p);
+    CHECK(Distance(p[0], Circle(oldest)) <= POSITION_EPSILON,
+          "%gHz overwritten samples still used", hz);
+    printf("%gHz: circle off by %g (bound %g), prediction %.2gms\n", hz, error,
+           bound, prediction * 1e3);
+  }
+
+  // Late samples are dropped, same time ones replace
+  InputResampler resampler;
+  const Vec2 a(0.f, 0.f), b(1.f, 0.f), c(5.f, 5.f), d(2.f, 0.f);
+  resampler.AddSample(1.0, &a, 1);
+  resampler.AddSample(1.1, &c, 1);
+  resampler.AddSample(1.1, &b, 1);
+  resampler.AddSample(1.05, &c, 1);
+  Vec2 p[ndk_helper::INPUT_MAX_POINTERS];
+  resampler.Resample(1.05, p);
+  CHECK(resampler.GetSampleCount() == 2 &&
+            Distance(p[0], Vec2(0.5f, 0.f)) <= POSITION_EPSILON,
+        "late or repeated samples kept");
+
+  // Samples too close to extrapolate from
+  resampler.AddSample(1.1 + ndk_helper::INPUT_MIN_SAMPLE_INTERVAL * 0.5, &d,
+                      1);
+  resampler.Resample(2., p);
+  CHECK(Distance(p[0], d) <= POSITION_EPSILON,
+        "extrapolated from samples %gms apart",
+        ndk_helper::INPUT_MIN_SAMPLE_INTERVAL * 0.5e3);
+
+  // The velocity fit only spans INPUT_VELOCITY_WINDOW
+  resampler.Reset();
+  const Vec2 slow(0.1f, 0.f), fast(2.f, -1.f);
+  Vec2 position;
+  for (int32_t i = 0; i <= 60; ++i) {
+    const double t = i / 120.;
+    position += (t <= 0.3 ? slow : fast) * (1.f / 120.f);
+    resampler.AddSample(t, &position, 1);
+  }
+  CHECK(Distance(resampler.GetVelocity(0, 0.5), fast) <= 1e-3f,
+        "velocity fit reaches past the window");
+  resampler.Reset();
+  resampler.AddSample(0., &position, 1);
+  CHECK(resampler.GetVelocity(0, 0.).Length() == 0.f,
+        "velocity of a single sample");
+}
+
+//--------------------------------------------------------------------------------
+// TapCamera
+//--------------------------------------------------------------------------------
+TapCamera* CreateCamera() {
+  TapCamera* camera = new TapCamera();
+  camera->SetFlip(1.f, -1.f, -1.f);
+  return camera;
+}
+
+struct Pose {
+  Mat4 rotation_;
+  Mat4 transform_;
+};
+
+// Replays a gesture, delivering each frame the samples reported up to its
+// display time, and returns the pose at every shared display time
+std::vector<Pose> ReplayGesture(const bool pinch, const int32_t fps,
+                                const double hz, float* drag_error) {
+  const double start = 100.;
+  const std::vector<double> times =
+      SampleTimes(start, hz, CURVE_TIME + FLING_TIME);
+  const double release = times.back() + 0.004;
+  const int32_t frame_ticks = TICKS_PER_SECOND / fps;
+  *drag_error = 0.f;
+
+  TapCamera* camera = CreateCamera();
+  std::vector<Pose> poses;
+  size_t next = 0;
+  bool released = false;
+  for (int32_t tick = 0;; tick += frame_ticks) {
+    const double display_time = start + (double)tick / TICKS_PER_SECOND;
+    if (display_time > release + MOMENTUM_TIME) break;
+    for (; next < times.size() && times[next] <= display_time; ++next) {
+      const double t = times[next] - start;
+      if (pinch) {
+        Vec2 pointers[2];
+        PinchPointers(t, pointers);
+        if (next == 0)
+          camera->BeginPinch(pointers[0], pointers[1], times[next]);
+        else
+          camera->Pinch(pointers[0], pointers[1], times[next]);
+      } else if (next == 0) {
+        camera->BeginDrag(Finger(t), times[next]);
+      } else {
+        camera->Drag(Finger(t), times[next]);
+      }
+    }
+    if (!released && release <= display_time) {
+      if (pinch)
+        camera->EndPinch(release);
+      else
+        camera->EndDrag(release);
+      released = true;
+    }
+    if (!next) continue;
+    camera->Update(display_time);
+
+    // The finger where the camera samples it, as a single straight drag
+    const double resample_time =
+        display_time - ndk_helper::INPUT_RESAMPLE_LATENCY;
+    if (!pinch && !released && resample_time >= times[0] &&
+        resample_time <= times[next - 1]) {
+      TapCamera* exact = CreateCamera();
+      exact->BeginDrag(Finger(times[0] - start), times[0]);
+      exact->Drag(Finger(resample_time - start), resample_time);
+      exact->Update(display_time);
+      *drag_error = std::max(
+          *drag_error, (float)RotationAngle(camera->GetRotationMatrix(),
+                                            exact->GetRotationMatrix()));
+      delete exact;
+    }
+
+    if (tick % SHARED_TICKS == 0) {
+      Pose pose = {camera->GetRotationMatrix(), camera->GetTransformMatrix()};
+      poses.push_back(pose);
+    }
+  }
+  delete camera;
+  return poses;
+}
+
+void TestFrameRates() {
+  printf("TapCamera frame rates\n");
+  for (int32_t pinch = 0; pinch < 2; ++pinch) {
+    const double hz = 120.;
+    std::vector<Pose> reference;
+    for (size_t f = 0; f < sizeof(FRAME_RATES) / sizeof(FRAME_RATES[0]); ++f) {
+      float drag_error;
+      std::vector<Pose> poses =
+          ReplayGesture(pinch != 0, FRAME_RATES[f], hz, &drag_error);
+      if (!f) reference = poses;
+      CHECK(poses.size() == reference.size(), "%d fps: %d poses, not %d",
+            FRAME_RATES[f], (int32_t)poses.size(), (int32_t)reference.size());
+      double rotation = 0., transform = 0.;
+      for (size_t i = 0; i < std::min(poses.size(), reference.size()); ++i) {
+        rotation = std::max(rotation, MaxDifference(poses[i].rotation_,
+                                                    reference[i].rotation_));
+        transform = std::max(transform, MaxDifference(poses[i].transform_,
+                                                      reference[i].transform_));
+      }
+      CHECK(rotation <= 1e-5 && transform <= 1e-4,
+            "%s at %d fps differs from %d fps by %g, offset by %g",
+            pinch ? "pinch" : "drag", FRAME_RATES[f], FRAME_RATES[0],
+            rotation, transform);
+      if (pinch) continue;
+
+      // Change of the ball point over a position error is at most 1 / z
+      // times it, the rotation twice the angle between ball points
+      const float z_min = 0.6f;
+      const float bound =
+          2.f * (FingerMaxAcceleration() * (float)(1. / (hz * hz)) / 8.f) /
+              (BALL_RADIUS * z_min) +
+          1e-4f;
+      CHECK(drag_error <= bound,
+            "%d fps drag off the finger by %g rad, bound %g", FRAME_RATES[f],
+            drag_error, bound);
+      printf("%d fps: drag %g rad off the finger (bound %g)\n", FRAME_RATES[f],
+             drag_error, bound);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Momentum
+//--------------------------------------------------------------------------------
+// Integral of the decaying velocity over t, stopped with the rotation
+double Decayed(const double factor, const double t) {
+  const double rate = -log(factor) / MOMENTUM_FRAME_TIME;
+  const double stop =
+      -log(MOMENTUM_FACTOR_THRESHOLD) /
+      (-log(MOMENTUM_FACTOR_DECREASE) / MOMENTUM_FRAME_TIME);
+  return (1. - exp(-rate * std::min(t, stop))) / rate;
+}
+
+// Drags the straight fling of Finger(), releasing |rest| after the last
+// sample, and returns the rotation angles after the release at |delays|
+std::vector<double> Fling(const double rest,
+                          const std::vector<double>& delays) {
+  const double start = 0.;
+  const std::vector<double> times =
+      SampleTimes(start, 120., CURVE_TIME + FLING_TIME);
+  TapCamera* camera = CreateCamera();
+  camera->BeginDrag(Finger(times[0] - start), times[0]);
+  for (size_t i = 1; i < times.size(); ++i)
+    camera->Drag(Finger(times[i] - start), times[i]);
+  const double release = times.back() + rest;
+  camera->EndDrag(release);
+
+  const double latency = ndk_helper::INPUT_RESAMPLE_LATENCY;
+  camera->Update(release + latency);
+  Mat4 released = camera->GetRotationMatrix();
+  std::vector<double> angles;
+  for (size_t i = 0; i < delays.size(); ++i) {
+    camera->Update(release + latency + delays[i]);
+    angles.push_back(RotationAngle(camera->GetRotationMatrix(), released));
+  }
+  delete camera;
+  return angles;
+}
+
+void TestMomentum() {
+  printf("TapCamera momentum\n");
+  const double delays[] = {0.001, 0.01, 0.05, 0.1, 0.3, 0.7, 2., 5.};
+  const std::vector<double> delay_list(
+      delays, delays + sizeof(delays) / sizeof(delays[0]));
+
+  // Rotation around the axis normal to the fling, at the ball's angular speed
+  const double speed = Vec2(FLING_VELOCITY[0], FLING_VELOCITY[1]).Length();
+  const double angular_velocity =
+      MOMENTUM_GAIN * 2. * speed / BALL_RADIUS;
+  std::vector<double> angles = Fling(0.004, delay_list);
+  double worst = 0.;
+  for (size_t i = 0; i < angles.size(); ++i) {
+    const double expected =
+        angular_velocity * Decayed(MOMENTUM_FACTOR_DECREASE, delays[i]);
+    worst = std::max(worst, fabs(angles[i] - expected) / expected);
+    CHECK(fabs(angles[i] - expected) <= expected * 1e-4 + 1e-6,
+          "%gs after the fling turned %g rad, not %g", delays[i], angles[i],
+          expected);
+  }
+  CHECK(angles[angles.size() - 1] == angles[angles.size() - 2],
+        "momentum does not stop");
+  printf("Fling: %g rad/s, turns %g rad, off by %.2g%%\n", angular_velocity,
+         angles.back(), worst * 100.);
+
+  // Released after resting: no momentum
+  angles = Fling(ndk_helper::INPUT_VELOCITY_STOP + 0.01, delay_list);
+  CHECK(*std::max_element(angles.begin(), angles.end()) == 0.,
+        "momentum after the finger rested");
+
+  // Pinch offset momentum: the center velocity, through the offset factors
+  const double start = 0.;
+  const std::vector<double> times =
+      SampleTimes(start, 120., CURVE_TIME + FLING_TIME);
+  TapCamera* camera = CreateCamera();
+  Vec2 pointers[2];
+  PinchPointers(times[0] - start, pointers);
+  camera->BeginPinch(pointers[0], pointers[1], times[0]);
+  for (size_t i = 1; i < times.size(); ++i) {
+    PinchPointers(times[i] - start, pointers);
+    camera->Pinch(pointers[0], pointers[1], times[i]);
+  }
+  const double release = times.back() + 0.004;
+  camera->EndPinch(release);
+  const double latency = ndk_helper::INPUT_RESAMPLE_LATENCY;
+  camera->Update(release + latency);
+  const float released[] = {camera->GetTransformMatrix().Ptr()[12],
+                            camera->GetTransformMatrix().Ptr()[13]};
+  for (size_t i = 0; i < delay_list.size(); ++i) {
+    camera->Update(release + latency + delays[i]);
+    const float* m = camera->GetTransformMatrix().Ptr();
+    const double shift =
+        MOMENTUM_GAIN * Decayed(MOMENTUM_FACTOR_DECREASE_SHIFT, delays[i]);
+    const double expected[] = {
+        TRANSFORM_FACTOR * PINCH_CENTER_VELOCITY[0] * shift,
+        -TRANSFORM_FACTOR * PINCH_CENTER_VELOCITY[1] * shift};
+    for (int32_t c = 0; c < 2; ++c) {
+      CHECK(fabs(m[12 + c] - released[c] - expected[c]) <=
+                fabs(expected[c]) * 2e-3 + 1e-4,
+            "%gs after the pinch offset %g, not %g", delays[i],
+            m[12 + c] - released[c], expected[c]);
+    }
+    CHECK(!isnan(m[14]) && !isinf(m[14]), "pinch depth not finite");
+  }
+  delete camera;
+}
+
+}  // namespace
+
+int main() {
+  TestResampler();
+  TestFrameRates();
+  TestMomentum();
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
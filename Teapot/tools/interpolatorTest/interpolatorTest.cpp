@@ -0,0 +1,327 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// interpolatorTest.cpp
+// Host test and benchmark of ndk_helper BatchInterpolator
+//
+// Every easing curve, from several start and end values, must give
+// Interpolator::GetFormula()'s values over the whole segment, and the end
+// value once it is over. Segments last CURVE_DURATION, so the time between
+// reading the clock and the Set() call, which both classes take as the start,
+// is negligible; the updates along the way move the time base forward many
+// times.
+//
+// Queued keyframes must be played in order, each starting from the end of the
+// last, as Interpolator plays them: values and IsActive() must be those of an
+// Interpolator given the same calls and updates. Clear() must drop the queue
+// but finish the current segment. Released channels must be reused, so that
+// there are never more than in use at once.
+//
+// Then times Update() of BatchInterpolator against a vector of Interpolator,
+// the std::list version, for 1000 and 100000 channels of random curves, in
+// the middle of their segments. The batch must be faster.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  g++ -O2 -I$MOCK/include -I$NDK_HELPER -o interpolatorTest
+//  interpolatorTest.cpp $NDK_HELPER/interpolator.cpp
+//  ./interpolatorTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "interpolator.h"
+
+using ndk_helper::BatchInterpolator;
+using ndk_helper::INTERPOLATOR_TYPE;
+using ndk_helper::Interpolator;
+using ndk_helper::PerfMonitor;
+
+namespace {
+
+const INTERPOLATOR_TYPE TYPES[] = {
+    ndk_helper::INTERPOLATOR_TYPE_LINEAR,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINQUAD,
+    ndk_helper::INTERPOLATOR_TYPE_EASEOUTQUAD,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINOUTQUAD,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINCUBIC,
+    ndk_helper::INTERPOLATOR_TYPE_EASEOUTCUBIC,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINOUTCUBIC,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINQUART,
+    ndk_helper::INTERPOLATOR_TYPE_EASEINEXPO,
+    ndk_helper::INTERPOLATOR_TYPE_EASEOUTEXPO,
+};
+const int32_t TYPE_COUNT = sizeof(TYPES) / sizeof(TYPES[0]);
+const char* const TYPE_NAMES[] = {
+    "linear",   "inQuad",     "outQuad", "inOutQuad", "inCubic",
+    "outCubic", "inOutCubic", "inQuart", "inExpo",    "outExpo",
+};
+
+const float CURVE_ENDS[][2] = {
+    {0.f, 1.f}, {1.f, 0.f}, {-3.5f, 250.f}, {1000.f, -20.f}, {2.f, 2.f},
+};
+// Long enough that a few microseconds between the clock read and Set()
+// make no visible difference
+const double CURVE_DURATION = 10000.0;
+const int32_t CURVE_STEPS = 500;
+// Of the value range; the start times relative to the time base lose
+// precision as they move back from it
+const float CURVE_TOLERANCE = 5e-6f;
+
+// The queued keyframes last 0 seconds, so each update moves one on whatever
+// the clock says, and both classes can be compared step by step
+const int32_t QUEUE_CHANNELS = 64;
+const int32_t QUEUE_STEPS = 2000;
+const int32_t MAX_QUEUED = 6;
+
+const int32_t BENCH_SIZES[] = {1000, 100000};
+const int32_t BENCH_UPDATES = 2000000;  // channel updates per timing
+const int32_t BENCH_REPEATS = 7;
+const int32_t BENCH_QUEUED = 3;
+const double FRAME_TIME = 1.0 / 60.0;
+
+int32_t g_failures = 0;
+volatile float g_sink;
+
+#define CHECK(cond, ...)                                \
+  do {                                                  \
+    if (!(cond)) {                                      \
+      if (g_failures < 20) {                            \
+        printf("  FAILED %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__);                            \
+        printf("\n");                                   \
+      }                                                 \
+      g_failures++;                                     \
+    }                                                   \
+  } while (0)
+
+uint32_t g_random = 12345;
+uint32_t Random() {
+  g_random = g_random * 1664525u + 1013904223u;
+  return g_random >> 8;
+}
+float RandomFloat(const float min, const float max) {
+  return min + (max - min) * (Random() & 0xffff) / 65535.f;
+}
+
+int64_t NowNs() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+//-------------------------------------------------
+// Curves
+//-------------------------------------------------
+void TestCurves() {
+  const int32_t end_count = sizeof(CURVE_ENDS) / sizeof(CURVE_ENDS[0]);
+  BatchInterpolator batch;
+  for (int32_t t = 0; t < TYPE_COUNT; ++t) {
+    const INTERPOLATOR_TYPE type = TYPES[t];
+    float worst = 0.f;
+    for (int32_t e = 0; e < end_count; ++e) {
+      const float b = CURVE_ENDS[e][0];
+      const float dest = CURVE_ENDS[e][1];
+      const float c = dest - b;
+      const float range = fabsf(b) + fabsf(c) + 1.f;
+      const int32_t channel = batch.Create();
+      const double start = PerfMonitor::GetCurrentTime();
+      batch.Set(channel, b, dest, type, CURVE_DURATION);
+
+      for (int32_t i = 0; i < CURVE_STEPS; ++i) {
+        const double time = CURVE_DURATION * i / CURVE_STEPS;
+        batch.Update(start + time);
+        const float expected = Interpolator::GetFormula(
+            type, (float)time, b, (float)CURVE_DURATION, c);
+        const float error = fabsf(batch.GetValue(channel) - expected) / range;
+        worst = std::max(worst, error);
+        CHECK(error <= CURVE_TOLERANCE,
+              "%s from %g to %g at %g: %.7g, expected %.7g", TYPE_NAMES[t], b,
+              dest, time / CURVE_DURATION, batch.GetValue(channel), expected);
+        CHECK(batch.IsActive(channel), "%s inactive at %g", TYPE_NAMES[t],
+              time / CURVE_DURATION);
+      }
+      batch.Update(start + CURVE_DURATION + 1.0);
+      CHECK(batch.GetValue(channel) == dest && !batch.IsActive(channel),
+            "%s from %g to %g: %g at the end, expected %g", TYPE_NAMES[t], b,
+            dest, batch.GetValue(channel), dest);
+      batch.Release(channel);
+    }
+    printf("  %-11s worst error %.2e of the range\n", TYPE_NAMES[t], worst);
+  }
+  CHECK(batch.Size() == 1, "%d channels for one at a time", batch.Size());
+}
+
+//-------------------------------------------------
+// Queues, Clear() and Release() against Interpolator
+//-------------------------------------------------
+struct Reference {
+  bool used;
+  bool active;
+  float value;
+  Interpolator interpolator;
+
+  Reference() : used(false), active(false), value(0.f) {}
+};
+
+void TestQueues() {
+  BatchInterpolator batch;
+  std::vector<Reference> references(QUEUE_CHANNELS);
+  std::vector<int32_t> channels(QUEUE_CHANNELS, -1);
+  int32_t checked = 0;
+  int32_t peak_size = 0;
+
+  for (int32_t step = 0; step < QUEUE_STEPS; ++step) {
+    const int32_t r = Random() % QUEUE_CHANNELS;
+    Reference& ref = references[r];
+    const uint32_t action = Random() % 8;
+    const INTERPOLATOR_TYPE type = TYPES[Random() % TYPE_COUNT];
+    const float dest = RandomFloat(-10.f, 10.f);
+
+    if (!ref.used) {
+      channels[r] = batch.Create();
+      ref.used = true;
+      ref.active = false;
+      ref.value = 0.f;
+      ref.interpolator.Clear();
+      // Interpolator has no idle state: start it on an empty segment
+      ref.interpolator.Set(0.f, 0.f, type, 0.0);
+    } else if (action == 0) {
+      batch.Release(channels[r]);
+      ref.used = false;
+    } else if (action == 1) {
+      batch.Clear(channels[r]);
+      ref.interpolator.Clear();
+    } else if (action < 4 || !ref.active) {
+      // A new segment, from the current value, with keyframes after it
+      const double duration = (Random() & 1) ? 0.0 : 1000.0;
+      batch.Set(channels[r], ref.value, dest, type, duration);
+      ref.interpolator.Set(ref.value, dest, type, duration);
+      ref.active = true;
+      batch.Clear(channels[r]);
+      ref.interpolator.Clear();
+      const int32_t keys = Random() % MAX_QUEUED;
+      for (int32_t k = 0; k < keys; ++k) {
+        const INTERPOLATOR_TYPE key_type = TYPES[Random() % TYPE_COUNT];
+        const float key_dest = RandomFloat(-10.f, 10.f);
+        batch.Add(channels[r], key_dest, key_type, 0.0);
+        ref.interpolator.Add(key_dest, key_type, 0.0);
+      }
+    }
+    peak_size = std::max(peak_size, batch.Size());
+
+    // Updates read the clock after every Set(), so zero length segments are
+    // over and long ones have barely started
+    const double now = PerfMonitor::GetCurrentTime();
+    batch.Update(now);
+    for (int32_t i = 0; i < QUEUE_CHANNELS; ++i) {
+      Reference& other = references[i];
+      if (!other.used) continue;
+      if (other.active)
+        other.active = other.interpolator.Update(now, other.value);
+      const float value = batch.GetValue(channels[i]);
+      CHECK(fabsf(value - other.value) <= 1e-4f * (fabsf(other.value) + 1.f),
+            "step %d channel %d: %g, Interpolator %g", step, i, value,
+            other.value);
+      CHECK(batch.IsActive(channels[i]) == other.active,
+            "step %d channel %d: active %d, Interpolator %d", step, i,
+            batch.IsActive(channels[i]), other.active);
+      checked++;
+    }
+  }
+  CHECK(peak_size <= QUEUE_CHANNELS, "%d channels for %d in use", peak_size,
+        QUEUE_CHANNELS);
+  printf("  %d channel updates matched Interpolator, %d channels at most\n",
+         checked, peak_size);
+}
+
+//-------------------------------------------------
+// Benchmark
+//-------------------------------------------------
+void Benchmark() {
+  for (size_t s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); ++s) {
+    const int32_t count = BENCH_SIZES[s];
+    const int32_t frames = std::max(BENCH_UPDATES / count, 1);
+    std::vector<Interpolator> list(count);
+    BatchInterpolator batch;
+    for (int32_t i = 0; i < count; ++i) {
+      const INTERPOLATOR_TYPE type = TYPES[Random() % TYPE_COUNT];
+      const float start = RandomFloat(-1.f, 1.f);
+      const float dest = RandomFloat(-1.f, 1.f);
+      const double duration = 1000.0 + RandomFloat(0.f, 1000.f);
+      const int32_t channel = batch.Create();
+      batch.Set(channel, start, dest, type, duration);
+      list[i].Set(start, dest, type, duration);
+      for (int32_t k = 0; k < BENCH_QUEUED; ++k) {
+        batch.Add(channel, start, type, duration);
+        list[i].Add(start, type, duration);
+      }
+    }
+
+    const double base = PerfMonitor::GetCurrentTime();
+    int64_t best_list = INT64_MAX;
+    int64_t best_batch = INT64_MAX;
+    float sink = 0.f;
+    for (int32_t repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+      int64_t start = NowNs();
+      for (int32_t f = 0; f < frames; ++f) {
+        const double now = base + f * FRAME_TIME;
+        for (int32_t i = 0; i < count; ++i) {
+          float p;
+          list[i].Update(now, p);
+          sink += p;
+        }
+      }
+      best_list = std::min(best_list, NowNs() - start);
+
+      start = NowNs();
+      for (int32_t f = 0; f < frames; ++f) {
+        batch.Update(base + f * FRAME_TIME);
+        const float* values = batch.GetValues();
+        for (int32_t i = 0; i < count; ++i) sink += values[i];
+      }
+      best_batch = std::min(best_batch, NowNs() - start);
+    }
+
+    const double list_us = best_list / 1000.0 / frames;
+    const double batch_us = best_batch / 1000.0 / frames;
+    g_sink = sink;
+    printf("  %6d channels: std::list %9.1f us, batch %9.1f us per frame "
+           "(x%.1f)\n",
+           count, list_us, batch_us, list_us / batch_us);
+    CHECK(batch_us < list_us, "batch slower for %d channels", count);
+  }
+}
+
+}  // namespace
+
+int main() {
+  printf("Curves against GetFormula()\n");
+  TestCurves();
+  printf("Queues against Interpolator\n");
+  TestQueues();
+  printf("Update() per frame\n");
+  Benchmark();
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
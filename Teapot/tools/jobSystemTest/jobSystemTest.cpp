@@ -0,0 +1,239 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// jobSystemTest.cpp
+// Host stress test of ndk_helper JobSystem
+//
+// Thousands of ParallelFor() calls, of random sizes and grains and with
+// chunks of random cost so that threads steal from each other, must each run
+// every element exactly once, in chunks of at most the grain starting at its
+// multiples (or in one call, with no worker). They must return only when all
+// are done, with their writes visible to the caller. Job systems of 0 to 7
+// workers are tried, on this machine's CPUs whatever their number.
+//
+// While workers run the last chunks, the caller must sleep: it may use only
+// a small part of that time on its CPU.
+//
+// Build and run on the host, from this directory, then again with
+// -fsanitize=thread in place of -O2 to check the synchronization:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  g++ -O2 -pthread -I$NDK_HELPER -o jobSystemTest jobSystemTest.cpp
+//  $NDK_HELPER/jobSystem.cpp
+//  ./jobSystemTest
+//--------------------------------------------------------------------------------
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "jobSystem.h"
+
+using ndk_helper::JobSystem;
+
+namespace {
+
+const int32_t WORKER_COUNTS[] = {0, 1, 2, 3, 7,
+                                 ndk_helper::JOB_SYSTEM_DEFAULT_THREADS};
+const int32_t STRESS_CALLS = 2000;
+const int32_t MAX_COUNT = 5000;
+const int32_t EDGE_COUNTS[] = {1, 2, 63, 64, 65, 1000};
+const int32_t EDGE_GRAINS[] = {0, 1, 7, 64, 4096};
+// Chunks on workers sleep this long in the blocking test
+const int32_t WORKER_SLEEP_MS = 40;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+uint32_t g_seed = 0x12345678;
+
+uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+double ClockNs(const clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void SleepMs(const int32_t ms) {
+  timespec ts = {0, ms * 1000000L};
+  nanosleep(&ts, NULL);
+}
+
+//--------------------------------------------------------------------------------
+// Every element once
+//--------------------------------------------------------------------------------
+struct Loop {
+  int32_t count_;
+  int32_t grain_;
+  bool inline_;  // No worker: one call over the whole range
+  int32_t call_;
+  // Runs per element, and the call that last ran it; the latter is plain
+  // memory, for the caller to see only through ParallelFor()'s
+  // synchronization
+  std::vector<std::atomic<int32_t> > runs_;
+  std::vector<int32_t> last_call_;
+  std::atomic<int32_t> bad_chunks_;
+  std::atomic<uint32_t> spin_;
+  uint32_t max_spin_;
+
+  explicit Loop(const int32_t size)
+      : count_(0), grain_(0), inline_(false), call_(0), runs_(size),
+        last_call_(size, -1), bad_chunks_(0), spin_(0), max_spin_(0) {}
+};
+
+void RunElements(void* data, const int32_t begin, const int32_t end) {
+  Loop* loop = static_cast<Loop*>(data);
+  const int32_t grain = loop->grain_ > 0 ? loop->grain_ : 1;
+  const bool whole = loop->inline_ && begin == 0 && end == loop->count_;
+  if (!whole && (begin < 0 || end > loop->count_ || begin >= end ||
+                 end - begin > grain || begin % grain))
+    ++loop->bad_chunks_;
+  for (int32_t i = std::max(begin, 0); i < std::min(end, loop->count_); ++i) {
+    loop->runs_[i].fetch_add(1, std::memory_order_relaxed);
+    loop->last_call_[i] = loop->call_;
+  }
+  // Uneven chunk costs, so that threads run out of work at different times
+  if (loop->max_spin_) {
+    uint32_t spin = (uint32_t)(begin * 2654435761u) % loop->max_spin_;
+    for (uint32_t i = 0; i < spin; ++i)
+      loop->spin_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool RunLoop(JobSystem* jobs, Loop* loop, const int32_t count,
+             const int32_t grain) {
+  loop->count_ = count;
+  loop->grain_ = grain;
+  loop->inline_ = jobs->GetThreadCount() == 1;
+  ++loop->call_;
+  for (int32_t i = 0; i < count; ++i)
+    loop->runs_[i].store(0, std::memory_order_relaxed);
+  loop->bad_chunks_ = 0;
+  jobs->ParallelFor(count, grain, RunElements, loop);
+
+  int32_t wrong = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    if (loop->runs_[i].load(std::memory_order_relaxed) != 1 ||
+        loop->last_call_[i] != loop->call_)
+      ++wrong;
+  }
+  CHECK(!wrong && !loop->bad_chunks_,
+        "%d threads, count %d grain %d: %d elements not run once, %d bad "
+        "chunks",
+        jobs->GetThreadCount(), count, grain, wrong,
+        loop->bad_chunks_.load());
+  return !wrong && !loop->bad_chunks_;
+}
+
+void TestEveryElementOnce() {
+  printf("Every element once\n");
+  for (size_t w = 0; w < sizeof(WORKER_COUNTS) / sizeof(WORKER_COUNTS[0]);
+       ++w) {
+    JobSystem jobs(WORKER_COUNTS[w]);
+    Loop loop(MAX_COUNT);
+
+    // Nothing to run
+    jobs.ParallelFor(0, 16, RunElements, &loop);
+    jobs.ParallelFor(-5, 16, RunElements, &loop);
+
+    for (size_t c = 0; c < sizeof(EDGE_COUNTS) / sizeof(EDGE_COUNTS[0]); ++c) {
+      for (size_t g = 0; g < sizeof(EDGE_GRAINS) / sizeof(EDGE_GRAINS[0]);
+           ++g)
+        RunLoop(&jobs, &loop, EDGE_COUNTS[c], EDGE_GRAINS[g]);
+    }
+
+    int32_t failed = 0;
+    for (int32_t call = 0; call < STRESS_CALLS && failed < 5; ++call) {
+      const int32_t count = 1 + Random() % MAX_COUNT;
+      const int32_t grain = 1 + Random() % 300;
+      loop.max_spin_ = call % 2 ? 1 + Random() % 2000 : 0;
+      if (!RunLoop(&jobs, &loop, count, grain)) ++failed;
+    }
+    printf("%d threads: %d loops\n", jobs.GetThreadCount(),
+           STRESS_CALLS + (int32_t)(sizeof(EDGE_COUNTS) /
+                                    sizeof(EDGE_COUNTS[0]) *
+                                    sizeof(EDGE_GRAINS) /
+                                    sizeof(EDGE_GRAINS[0])));
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Caller sleeps
+//--------------------------------------------------------------------------------
+struct SleepLoop {
+  pthread_t caller_;
+  std::atomic<int32_t> on_workers_;
+};
+
+void SleepChunk(void* data, const int32_t, const int32_t) {
+  SleepLoop* loop = static_cast<SleepLoop*>(data);
+  if (pthread_equal(pthread_self(), loop->caller_)) {
+    // Long enough for the workers to take their chunks
+    SleepMs(5);
+  } else {
+    ++loop->on_workers_;
+    SleepMs(WORKER_SLEEP_MS);
+  }
+}
+
+void TestCallerSleeps() {
+  printf("Caller sleeps while workers finish\n");
+  JobSystem jobs(3);
+  SleepLoop loop;
+  loop.caller_ = pthread_self();
+  loop.on_workers_ = 0;
+
+  const double wall = ClockNs(CLOCK_MONOTONIC);
+  const double cpu = ClockNs(CLOCK_THREAD_CPUTIME_ID);
+  jobs.ParallelFor(jobs.GetThreadCount(), 1, SleepChunk, &loop);
+  const double wall_time = ClockNs(CLOCK_MONOTONIC) - wall;
+  const double cpu_time = ClockNs(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+  CHECK(loop.on_workers_ > 0, "no chunk ran on a worker");
+  CHECK(cpu_time < wall_time * 0.2,
+        "caller used %.1fms of CPU in %.1fms", cpu_time / 1e6,
+        wall_time / 1e6);
+  printf("Caller used %.2fms of CPU in %.1fms, %d chunks on workers\n",
+         cpu_time / 1e6, wall_time / 1e6, loop.on_workers_.load());
+}
+
+}  // namespace
+
+int main() {
+  TestEveryElementOnce();
+  TestCallerSleeps();
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,512 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// meshTest.cpp
+// Host test and benchmark of the Teapot mesh loading
+//
+// Runs TeapotRenderer unchanged on the GL mock of tools/androidMock: it loads
+// Models/Teapot.mesh and draws it once. The draw is then decoded as the
+// vertex shader decodes it, from the buffers, attribute pointers and
+// uniforms it was given, and must be the geometry of teapot.inl that the
+// renderer used to upload: every vertex a source vertex within the encoding
+// bounds of tools/meshTool, the same triangles with the same winding, and the
+// same bounding box. Unload() must delete everything.
+//
+// The file's vertices are already 12 bytes, unorm16 positions and
+// octahedral normals, as small as the packed layout of ndk_helper/
+// vertexFormat.h: the renderer must upload them byte for byte, with no
+// repacking, and point the attributes at them unchanged.
+//
+// Then times loading the mesh as TeapotRenderer::LoadMesh() does, with the
+// file mapped first or already cached, against interleaving teapot.inl and
+// computing its bounding box, as the renderer did before. Buffer uploads are
+// memory copies in the mock, so this compares the CPU work only.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  NDK_HELPER=$JNI/ndk_helper
+//  MOCK=../androidMock
+//  gcc -O2 -c -I$MOCK/include -I$NDK_HELPER $NDK_HELPER/gl3stub.c
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER -I$JNI -o meshTest
+//  meshTest.cpp gl3stub.o $MOCK/androidMock.cpp $JNI/TeapotRenderer.cpp
+//  $NDK_HELPER/mesh.cpp $NDK_HELPER/assetCache.cpp $NDK_HELPER/shader.cpp
+//  $NDK_HELPER/shaderPreprocessor.cpp $NDK_HELPER/resourceLoader.cpp
+//  $NDK_HELPER/vecmath.cpp $NDK_HELPER/tapCamera.cpp
+//  $NDK_HELPER/inputResampler.cpp
+//  ./meshTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "androidMock.h"
+#include "TeapotRenderer.h"
+#include "mesh.h"
+#include "vertexFormat.h"
+
+#include "teapot.inl"
+
+using ndk_helper::AssetCache;
+using ndk_helper::AssetView;
+using ndk_helper::MeshData;
+
+namespace {
+
+const char ASSET_DIR[] = "../../app/src/main/assets";
+const char MESH_FILE[] = "Models/Teapot.mesh";
+// As tools/meshTool checks the written file
+const float MAX_NORMAL_ERROR = 2e-4f;
+const int32_t BENCH_RUNS = 200;
+
+const int32_t NUM_SOURCE_VERTICES =
+    sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
+const int32_t NUM_SOURCE_INDICES =
+    sizeof(teapotIndices) / sizeof(teapotIndices[0]);
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Vertex of the renderer before Models/Teapot.mesh
+struct TEAPOT_VERTEX {
+  float pos[3];
+  float normal[3];
+};
+
+struct Triangle {
+  int32_t v_[3];
+
+  // Rotated so the smallest index comes first, which keeps the winding
+  Triangle(const int32_t a, const int32_t b, const int32_t c) {
+    if (a <= b && a <= c) {
+      v_[0] = a, v_[1] = b, v_[2] = c;
+    } else if (b <= a && b <= c) {
+      v_[0] = b, v_[1] = c, v_[2] = a;
+    } else {
+      v_[0] = c, v_[1] = a, v_[2] = b;
+    }
+  }
+  bool operator<(const Triangle& rhs) const {
+    return std::lexicographical_compare(v_, v_ + 3, rhs.v_, rhs.v_ + 3);
+  }
+  bool operator==(const Triangle& rhs) const {
+    return std::equal(v_, v_ + 3, rhs.v_);
+  }
+};
+
+float Angle(const float* a, const float* b) {
+  // atan2 of |cross| and dot stays accurate for tiny angles, acos does not
+  const float cross[3] = {a[1] * b[2] - a[2] * b[1],
+                          a[2] * b[0] - a[0] * b[2],
+                          a[0] * b[1] - a[1] * b[0]};
+  return atan2f(sqrtf(cross[0] * cross[0] + cross[1] * cross[1] +
+                      cross[2] * cross[2]),
+                a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+}
+
+//--------------------------------------------------------------------------------
+// What the vertex shader sees
+//--------------------------------------------------------------------------------
+float FetchComponent(const uint8_t* p, const GLenum type,
+                     const bool normalized) {
+  switch (type) {
+    case GL_UNSIGNED_SHORT: {
+      uint16_t v;
+      memcpy(&v, p, sizeof(v));
+      return normalized ? v / 65535.f : v;
+    }
+    case GL_SHORT: {
+      int16_t v;
+      memcpy(&v, p, sizeof(v));
+      // ES3 normalization, as the mock reports an ES3 context
+      return normalized ? std::max(v / 32767.f, -1.f) : v;
+    }
+    case GL_FLOAT: {
+      float v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    default:
+      return NAN;
+  }
+}
+
+int32_t ComponentSize(const GLenum type) {
+  return type == GL_FLOAT ? 4 : type == GL_SHORT || type == GL_UNSIGNED_SHORT
+                                    ? 2
+                                    : 0;
+}
+
+// Missing components are 0, as the shader declares no more than it reads
+bool Fetch(const android_mock::VertexAttrib& attrib, const int32_t vertex,
+           float* out) {
+  const std::vector<uint8_t>* data =
+      android_mock::GetBufferData(attrib.buffer_);
+  const int32_t size = ComponentSize(attrib.type_);
+  if (!attrib.enabled_ || data == NULL || !size) return false;
+  const size_t stride = attrib.stride_ ? attrib.stride_ : attrib.size_ * size;
+  const size_t offset = attrib.offset_ + vertex * stride;
+  if (offset + attrib.size_ * size > data->size()) return false;
+  for (int32_t c = 0; c < 4; ++c) {
+    out[c] = c < attrib.size_
+                 ? FetchComponent(&(*data)[offset + c * size], attrib.type_,
+                                  attrib.normalized_)
+                 : 0.f;
+  }
+  return true;
+}
+
+// OctDecode() of VS_ShaderPlain.vsh
+void ShaderOctDecode(const float* e, float* n) {
+  n[0] = e[0], n[1] = e[1], n[2] = 1.f - fabsf(e[0]) - fabsf(e[1]);
+  if (n[2] < 0.f) {
+    n[0] = (1.f - fabsf(e[1])) * (e[0] >= 0.f ? 1.f : -1.f);
+    n[1] = (1.f - fabsf(e[0])) * (e[1] >= 0.f ? 1.f : -1.f);
+  }
+  const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  for (int32_t c = 0; c < 3; ++c) n[c] /= length;
+}
+
+//--------------------------------------------------------------------------------
+// Draw
+//--------------------------------------------------------------------------------
+void TestDraw() {
+  printf("TeapotRenderer draw\n");
+  android_mock::ResetGl();
+  glViewport(0, 0, 720, 1280);
+
+  TeapotRenderer* renderer = new TeapotRenderer();
+  ndk_helper::ResourceLoader loader(NULL);
+  renderer->Init(&loader);
+  renderer->Bind(NULL);
+  renderer->Update(0.);
+  renderer->Render();
+  CHECK(glGetError() == GL_NO_ERROR, "GL error");
+
+  const std::vector<android_mock::Draw> draws = android_mock::GetDraws();
+  CHECK(draws.size() == 1, "%d draws", (int32_t)draws.size());
+  if (draws.size() != 1) {
+    delete renderer;
+    return;
+  }
+  const android_mock::Draw& draw = draws[0];
+  CHECK(draw.mode_ == GL_TRIANGLES && draw.type_ == GL_UNSIGNED_SHORT,
+        "not a 16 bit indexed triangle list");
+  CHECK(draw.count_ == NUM_SOURCE_INDICES, "%d indices, source has %d",
+        draw.count_, NUM_SOURCE_INDICES);
+
+  const std::vector<float> scale =
+      android_mock::GetUniform(draw.program_, "uPositionScale");
+  const std::vector<float> bias =
+      android_mock::GetUniform(draw.program_, "uPositionBias");
+  CHECK(scale.size() == 3 && bias.size() == 3,
+        "position scale or bias not set");
+  const std::vector<uint8_t>* index_data =
+      android_mock::GetBufferData(draw.element_buffer_);
+  CHECK(index_data && draw.offset_ + draw.count_ * 2 <= index_data->size(),
+        "index buffer too small");
+  if (scale.size() != 3 || bias.size() != 3 || !index_data ||
+      draw.offset_ + draw.count_ * 2 > index_data->size()) {
+    delete renderer;
+    return;
+  }
+
+  // Every vertex the draw fetches, decoded
+  std::vector<int32_t> indices(draw.count_);
+  int32_t num_vertices = 0;
+  for (int32_t i = 0; i < draw.count_; ++i) {
+    uint16_t index;
+    memcpy(&index, &(*index_data)[draw.offset_ + i * 2], sizeof(index));
+    indices[i] = index;
+    num_vertices = std::max(num_vertices, index + 1);
+  }
+  CHECK(num_vertices == NUM_SOURCE_VERTICES, "%d vertices, source has %d",
+        num_vertices, NUM_SOURCE_VERTICES);
+
+  // Bounds of tools/meshTool: half a quantization step per axis plus float
+  // rounding, from the source bounding box
+  float aabb_min[3], aabb_max[3], max_position_error[3];
+  for (int32_t c = 0; c < 3; ++c) {
+    aabb_min[c] = aabb_max[c] = teapotPositions[c];
+    for (int32_t i = 1; i < NUM_SOURCE_VERTICES; ++i) {
+      aabb_min[c] = std::min(aabb_min[c], teapotPositions[i * 3 + c]);
+      aabb_max[c] = std::max(aabb_max[c], teapotPositions[i * 3 + c]);
+    }
+    const float magnitude = std::max(fabsf(aabb_min[c]), fabsf(aabb_max[c]));
+    max_position_error[c] =
+        (aabb_max[c] - aabb_min[c]) / 65535.f * 0.5f + magnitude * 4e-7f;
+  }
+
+  // Match each drawn vertex with a source vertex. The teapot repeats some
+  // vertices exactly, so a match stands for the first source vertex equal
+  // to it.
+  std::vector<int32_t> first_equal(NUM_SOURCE_VERTICES);
+  for (int32_t i = 0; i < NUM_SOURCE_VERTICES; ++i) {
+    first_equal[i] = i;
+    for (int32_t j = 0; j < i; ++j) {
+      if (!memcmp(&teapotPositions[i * 3], &teapotPositions[j * 3],
+                  3 * sizeof(float)) &&
+          !memcmp(&teapotNormals[i * 3], &teapotNormals[j * 3],
+                  3 * sizeof(float))) {
+        first_equal[i] = j;
+        break;
+      }
+    }
+  }
+
+  std::vector<int32_t> match(num_vertices, -1);
+  float drawn_min[3] = {1e30f, 1e30f, 1e30f};
+  float drawn_max[3] = {-1e30f, -1e30f, -1e30f};
+  float worst_position = 0.f, worst_normal = 0.f;
+  int32_t unmatched = 0;
+  for (int32_t v = 0; v < num_vertices; ++v) {
+    float position[4], encoded[4], normal[3];
+    if (!Fetch(draw.attribs_[ATTRIB_VERTEX], v, position) ||
+        !Fetch(draw.attribs_[ATTRIB_NORMAL], v, encoded)) {
+      CHECK(false, "vertex %d not fetched", v);
+      break;
+    }
+    for (int32_t c = 0; c < 3; ++c) {
+      position[c] = position[c] * scale[c] + bias[c];
+      drawn_min[c] = std::min(drawn_min[c], position[c]);
+      drawn_max[c] = std::max(drawn_max[c], position[c]);
+    }
+    ShaderOctDecode(encoded, normal);
+
+    float best = 1e30f;
+    for (int32_t s = 0; s < NUM_SOURCE_VERTICES; ++s) {
+      const float* p = &teapotPositions[s * 3];
+      bool inside = true;
+      float error = 0.f;
+      for (int32_t c = 0; c < 3; ++c) {
+        const float d = fabsf(position[c] - p[c]);
+        inside = inside && d <= max_position_error[c];
+        error = std::max(error, d / max_position_error[c]);
+      }
+      if (!inside) continue;
+      const float angle = Angle(normal, &teapotNormals[s * 3]);
+      if (angle > MAX_NORMAL_ERROR || error + angle / MAX_NORMAL_ERROR >= best)
+        continue;
+      best = error + angle / MAX_NORMAL_ERROR;
+      match[v] = first_equal[s];
+    }
+    if (match[v] < 0) {
+      ++unmatched;
+      continue;
+    }
+    const float* p = &teapotPositions[match[v] * 3];
+    for (int32_t c = 0; c < 3; ++c)
+      worst_position = std::max(worst_position, fabsf(position[c] - p[c]));
+    worst_normal =
+        std::max(worst_normal, Angle(normal, &teapotNormals[match[v] * 3]));
+  }
+  CHECK(!unmatched, "%d drawn vertices match no source vertex", unmatched);
+
+  // Same triangles, same winding, over the matched source vertices
+  std::vector<Triangle> drawn, source;
+  for (int32_t i = 0; i + 2 < draw.count_; i += 3) {
+    drawn.push_back(Triangle(match[indices[i]], match[indices[i + 1]],
+                             match[indices[i + 2]]));
+  }
+  for (int32_t i = 0; i + 2 < NUM_SOURCE_INDICES; i += 3) {
+    source.push_back(Triangle(first_equal[teapotIndices[i]],
+                              first_equal[teapotIndices[i + 1]],
+                              first_equal[teapotIndices[i + 2]]));
+  }
+  std::sort(drawn.begin(), drawn.end());
+  std::sort(source.begin(), source.end());
+  CHECK(drawn == source, "triangles differ from teapot.inl");
+
+  for (int32_t c = 0; c < 3; ++c) {
+    CHECK(fabsf(drawn_min[c] - aabb_min[c]) <= max_position_error[c] &&
+              fabsf(drawn_max[c] - aabb_max[c]) <= max_position_error[c],
+          "axis %d drawn over [%g, %g], source [%g, %g]", c, drawn_min[c],
+          drawn_max[c], aabb_min[c], aabb_max[c]);
+  }
+  printf("%d vertices, %d triangles: max position error %g, normal %g rad\n",
+         num_vertices, draw.count_ / 3, worst_position, worst_normal);
+
+  delete renderer;
+  CHECK(android_mock::GetLiveObjects() == 0, "%d GL objects left",
+        android_mock::GetLiveObjects());
+}
+
+//--------------------------------------------------------------------------------
+// Upload
+//--------------------------------------------------------------------------------
+void TestUpload() {
+  printf("TeapotRenderer upload\n");
+  android_mock::ResetGl();
+  AssetView view = AssetCache::GetInstance()->Open(MESH_FILE);
+  MeshData mesh;
+  CHECK(view.IsValid() && mesh.Parse(view.Data(), view.Size()),
+        "%s does not load", MESH_FILE);
+  if (!mesh.GetNumVertices()) return;
+  CHECK(mesh.IsQuantized() &&
+            mesh.GetVertexStride() == (int32_t)sizeof(ndk_helper::VertexPacked),
+        "%s: %d byte vertices, not the 12 of the packed layout", MESH_FILE,
+        mesh.GetVertexStride());
+
+  TeapotRenderer* renderer = new TeapotRenderer();
+  ndk_helper::ResourceLoader loader(NULL);
+  renderer->Init(&loader);
+  renderer->Bind(NULL);
+  renderer->Render();
+
+  const std::vector<GLuint> buffers = android_mock::GetBuffers(GL_ARRAY_BUFFER);
+  CHECK(buffers.size() == 1, "%d vertex buffers", (int32_t)buffers.size());
+  const std::vector<uint8_t>* data =
+      buffers.size() == 1 ? android_mock::GetBufferData(buffers[0]) : NULL;
+  CHECK(data && data->size() == mesh.GetVertexDataSize() &&
+            !memcmp(&(*data)[0], mesh.GetVertexData(), data->size()),
+        "the vertex buffer is not the vertices of %s", MESH_FILE);
+
+  const std::vector<android_mock::Draw> draws = android_mock::GetDraws();
+  CHECK(draws.size() == 1, "%d draws", (int32_t)draws.size());
+  if (draws.size() == 1 && buffers.size() == 1) {
+    const android_mock::VertexAttrib& position =
+        draws[0].attribs_[ATTRIB_VERTEX];
+    const android_mock::VertexAttrib& normal = draws[0].attribs_[ATTRIB_NORMAL];
+    CHECK(position.buffer_ == buffers[0] &&
+              position.type_ == GL_UNSIGNED_SHORT && position.normalized_ && position.size_ == 3 &&
+              position.stride_ == mesh.GetVertexStride() && !position.offset_,
+          "positions are not fetched as the file stores them");
+    CHECK(normal.buffer_ == buffers[0] && normal.type_ == GL_SHORT &&
+              normal.normalized_ && normal.size_ == 2 &&
+              normal.stride_ == mesh.GetVertexStride() &&
+              normal.offset_ ==
+                  offsetof(ndk_helper::MeshVertexQuantized, normal_),
+          "normals are not fetched as the file stores them");
+  }
+  delete renderer;
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+// TeapotRenderer::LoadMesh(), bar logging
+size_t LoadMesh(GLuint* buffers) {
+  AssetView view = AssetCache::GetInstance()->Open(MESH_FILE);
+  MeshData mesh;
+  if (!view.IsValid() || !mesh.Parse(view.Data(), view.Size())) return 0;
+  glGenBuffers(2, buffers);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.GetIndexDataSize(),
+               mesh.GetIndexData(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  float scale[3], bias[3];
+  mesh.GetPositionScale(scale);
+  mesh.GetPositionBias(bias);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, mesh.GetVertexDataSize(), mesh.GetVertexData(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return mesh.GetIndexDataSize() + mesh.GetVertexDataSize();
+}
+
+// What TeapotRenderer::Init() did before Models/Teapot.mesh
+size_t InterleaveTeapot(GLuint* buffers, float* aabb) {
+  glGenBuffers(2, buffers);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(teapotIndices), teapotIndices,
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  TEAPOT_VERTEX* p = new TEAPOT_VERTEX[NUM_SOURCE_VERTICES];
+  for (int32_t c = 0; c < 6; ++c) aabb[c] = 0.f;
+  for (int32_t i = 0; i < NUM_SOURCE_VERTICES; ++i) {
+    for (int32_t c = 0; c < 3; ++c) {
+      p[i].pos[c] = teapotPositions[i * 3 + c];
+      aabb[c] = std::min(aabb[c], p[i].pos[c]);
+      aabb[c + 3] = std::max(aabb[c + 3], p[i].pos[c]);
+      p[i].normal[c] = teapotNormals[i * 3 + c];
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(TEAPOT_VERTEX) * NUM_SOURCE_VERTICES,
+               p, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  delete[] p;
+  return sizeof(teapotIndices) + sizeof(TEAPOT_VERTEX) * NUM_SOURCE_VERTICES;
+}
+
+void Benchmark() {
+  printf("Benchmark, best of %d\n", BENCH_RUNS);
+  android_mock::ResetGl();
+  double best_mesh = 1e30, best_cached = 1e30, best_inl = 1e30;
+  size_t mesh_bytes = 0, inl_bytes = 0;
+  for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+    GLuint buffers[2];
+    // Maps the file again, as at startup
+    AssetCache::GetInstance()->Trim();
+    double start = NowNs();
+    mesh_bytes = LoadMesh(buffers);
+    best_mesh = std::min(best_mesh, NowNs() - start);
+    glDeleteBuffers(2, buffers);
+
+    // Held by the cache, as when the context is recreated
+    AssetView view = AssetCache::GetInstance()->Open(MESH_FILE);
+    start = NowNs();
+    LoadMesh(buffers);
+    best_cached = std::min(best_cached, NowNs() - start);
+    glDeleteBuffers(2, buffers);
+
+    float aabb[6];
+    start = NowNs();
+    inl_bytes = InterleaveTeapot(buffers, aabb);
+    best_inl = std::min(best_inl, NowNs() - start);
+    glDeleteBuffers(2, buffers);
+  }
+  CHECK(mesh_bytes, "%s does not load", MESH_FILE);
+  CHECK(android_mock::GetLiveObjects() == 0, "buffers left");
+  printf("%s, %d bytes: %.1fus, %.1fus cached\n", MESH_FILE,
+         (int32_t)mesh_bytes, best_mesh / 1e3, best_cached / 1e3);
+  printf("teapot.inl interleaved, %d bytes: %.1fus\n", (int32_t)inl_bytes,
+         best_inl / 1e3);
+}
+
+}  // namespace
+
+int main() {
+  android_mock::SetAssetDir(ASSET_DIR);
+  AssetCache::GetInstance()->Init(NULL, ASSET_DIR);
+
+  TestDraw();
+  TestUpload();
+  Benchmark();
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,500 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// meshOptimizer.cpp
+//--------------------------------------------------------------------------------
+#include "meshOptimizer.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace mesh_optimizer {
+
+namespace {
+
+//--------------------------------------------------------------------------------
+// Triangles using each vertex, as offsets into one flat array
+//--------------------------------------------------------------------------------
+struct Adjacency {
+  std::vector<int32_t> offsets_;    // num_vertices + 1
+  std::vector<int32_t> triangles_;  // 3 per triangle
+
+  void Build(const std::vector<uint16_t>& indices, const int32_t num_vertices) {
+    offsets_.assign(num_vertices + 1, 0);
+    for (size_t i = 0; i < indices.size(); ++i) ++offsets_[indices[i] + 1];
+    for (int32_t v = 0; v < num_vertices; ++v) offsets_[v + 1] += offsets_[v];
+    std::vector<int32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    triangles_.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+      triangles_[fill[indices[i]]++] = (int32_t)(i / 3);
+  }
+};
+
+//--------------------------------------------------------------------------------
+// FIFO post-transform cache, as in ComputeAcmr()
+//--------------------------------------------------------------------------------
+class FifoCache {
+  std::vector<int32_t> entries_;
+  int32_t head_;
+
+ public:
+  explicit FifoCache(const int32_t size) : entries_(size, -1), head_(0) {}
+
+  void Clear() { std::fill(entries_.begin(), entries_.end(), -1); }
+
+  // True on a miss, which pushes the vertex in
+  bool Access(const int32_t vertex) {
+    for (size_t k = 0; k < entries_.size(); ++k)
+      if (entries_[k] == vertex) return false;
+    entries_[head_] = vertex;
+    head_ = (head_ + 1) % (int32_t)entries_.size();
+    return true;
+  }
+
+  int32_t AccessTriangle(const uint16_t* triangle) {
+    return Access(triangle[0]) + Access(triangle[1]) + Access(triangle[2]);
+  }
+};
+
+int32_t CountMisses(const std::vector<uint16_t>& indices,
+                    const int32_t cache_size) {
+  FifoCache cache(cache_size);
+  int32_t misses = 0;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    misses += cache.AccessTriangle(&indices[i]);
+  return misses;
+}
+
+//--------------------------------------------------------------------------------
+// Forsyth vertex scores
+//--------------------------------------------------------------------------------
+const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+float ForsythScore(const int32_t cache_position, const int32_t live,
+                   const int32_t cache_size) {
+  if (!live) return -1.f;
+  float score = 0.f;
+  if (cache_position >= 0) {
+    // The last triangle's vertices score a fixed amount, so the next one
+    // does not just reuse its edge and make a strip
+    if (cache_position < 3)
+      score = FORSYTH_LAST_TRIANGLE_SCORE;
+    else
+      score = powf(1.f - (float)(cache_position - 3) / (cache_size - 3),
+                   FORSYTH_CACHE_DECAY_POWER);
+  }
+  // Vertices with few triangles left go first, not to be left stranded
+  return score + FORSYTH_VALENCE_BOOST_SCALE *
+                     powf((float)live, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+//--------------------------------------------------------------------------------
+// Overdraw estimation
+//--------------------------------------------------------------------------------
+const int32_t OVERDRAW_RESOLUTION = 256;
+
+void Cross(const float* a, const float* b, float* out) {
+  out[0] = a[1] * b[2] - a[2] * b[1];
+  out[1] = a[2] * b[0] - a[0] * b[2];
+  out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+float Dot(const float* a, const float* b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void Normalize(float* v) {
+  float length = sqrtf(Dot(v, v));
+  if (length > 0.f)
+    for (int32_t c = 0; c < 3; ++c) v[c] /= length;
+}
+
+// Shaded and covered pixels of one orthographic view along |direction|
+void RasterizeView(const std::vector<uint16_t>& indices,
+                   const float* positions, const int32_t num_vertices,
+                   const float* direction, int64_t* shaded, int64_t* covered) {
+  // View space as in GL: x right, y up, looking down -z
+  float forward[3] = {direction[0], direction[1], direction[2]};
+  Normalize(forward);
+  float up[3] = {0.f, 1.f, 0.f};
+  if (fabsf(forward[1]) > 0.99f) up[0] = 1.f, up[1] = 0.f;
+  float back[3] = {-forward[0], -forward[1], -forward[2]};
+  float right[3];
+  Cross(up, back, right);
+  Normalize(right);
+  Cross(back, right, up);
+
+  std::vector<float> screen(num_vertices * 3);
+  float low[2] = {1e30f, 1e30f}, high[2] = {-1e30f, -1e30f};
+  for (int32_t v = 0; v < num_vertices; ++v) {
+    const float* p = &positions[v * 3];
+    float* s = &screen[v * 3];
+    s[0] = Dot(p, right);
+    s[1] = Dot(p, up);
+    s[2] = Dot(p, forward);  // Depth, larger is farther
+    for (int32_t c = 0; c < 2; ++c) {
+      low[c] = std::min(low[c], s[c]);
+      high[c] = std::max(high[c], s[c]);
+    }
+  }
+  const float scale = (OVERDRAW_RESOLUTION - 1) /
+                      std::max(std::max(high[0] - low[0], high[1] - low[1]),
+                               1e-20f);
+  for (int32_t v = 0; v < num_vertices; ++v) {
+    screen[v * 3] = (screen[v * 3] - low[0]) * scale;
+    screen[v * 3 + 1] = (screen[v * 3 + 1] - low[1]) * scale;
+  }
+
+  std::vector<float> depth(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION, 1e30f);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const float* a = &screen[indices[i] * 3];
+    const float* b = &screen[indices[i + 1] * 3];
+    const float* c = &screen[indices[i + 2] * 3];
+    const float area =
+        (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+    if (area <= 0.f) continue;  // Back facing or degenerate
+
+    int32_t x0 = std::max((int32_t)floorf(std::min(a[0], std::min(b[0], c[0]))), 0);
+    int32_t y0 = std::max((int32_t)floorf(std::min(a[1], std::min(b[1], c[1]))), 0);
+    int32_t x1 = std::min((int32_t)ceilf(std::max(a[0], std::max(b[0], c[0]))),
+                          OVERDRAW_RESOLUTION - 1);
+    int32_t y1 = std::min((int32_t)ceilf(std::max(a[1], std::max(b[1], c[1]))),
+                          OVERDRAW_RESOLUTION - 1);
+    for (int32_t y = y0; y <= y1; ++y) {
+      for (int32_t x = x0; x <= x1; ++x) {
+        // Barycentrics at the pixel center
+        const float px = x + 0.5f, py = y + 0.5f;
+        const float wa =
+            (b[0] - px) * (c[1] - py) - (b[1] - py) * (c[0] - px);
+        const float wb =
+            (c[0] - px) * (a[1] - py) - (c[1] - py) * (a[0] - px);
+        const float wc = area - wa - wb;
+        if (wa < 0.f || wb < 0.f || wc < 0.f) continue;
+        const float z = (wa * a[2] + wb * b[2] + wc * c[2]) / area;
+        float& d = depth[y * OVERDRAW_RESOLUTION + x];
+        if (z < d) {
+          if (d == 1e30f) ++*covered;
+          d = z;
+          ++*shaded;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void TipsifyIndices(const std::vector<uint16_t>& indices,
+                    const int32_t num_vertices, const int32_t cache_size,
+                    std::vector<uint16_t>* out) {
+  const int32_t num_triangles = (int32_t)(indices.size() / 3);
+  out->clear();
+  out->reserve(indices.size());
+  if (!num_triangles) return;
+
+  Adjacency adjacency;
+  adjacency.Build(indices, num_vertices);
+
+  std::vector<int32_t> live(num_vertices);  // Triangles not emitted yet
+  for (int32_t v = 0; v < num_vertices; ++v)
+    live[v] = adjacency.offsets_[v + 1] - adjacency.offsets_[v];
+  std::vector<int32_t> cache_time(num_vertices, 0);
+  std::vector<bool> emitted(num_triangles, false);
+  std::vector<int32_t> dead_end;  // Recently used vertices
+  std::vector<int32_t> candidates;
+
+  int32_t time = cache_size + 1;
+  int32_t cursor = 0;   // Next vertex to try once the dead end stack is empty
+  int32_t fan = indices[0];
+  while (fan >= 0) {
+    // Emit every triangle around the fanning vertex
+    candidates.clear();
+    for (int32_t i = adjacency.offsets_[fan]; i < adjacency.offsets_[fan + 1];
+         ++i) {
+      int32_t t = adjacency.triangles_[i];
+      if (emitted[t]) continue;
+      emitted[t] = true;
+      for (int32_t k = 0; k < 3; ++k) {
+        int32_t v = indices[t * 3 + k];
+        out->push_back((uint16_t)v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - cache_time[v] > cache_size) cache_time[v] = time++;
+      }
+    }
+
+    // Next fan: the candidate that stays in the cache longest while its
+    // remaining triangles are emitted
+    int32_t best = -1;
+    int32_t best_priority = -1;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      int32_t v = candidates[i];
+      if (!live[v]) continue;
+      int32_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size)
+        priority = time - cache_time[v];
+      if (priority > best_priority) {
+        best_priority = priority;
+        best = v;
+      }
+    }
+
+    if (best < 0) {
+      // Dead end: back up to a recent vertex, else scan forward
+      while (dead_end.size() && best < 0) {
+        int32_t v = dead_end.back();
+        dead_end.pop_back();
+        if (live[v]) best = v;
+      }
+      while (best < 0 && cursor < num_vertices) {
+        if (live[cursor]) best = cursor;
+        ++cursor;
+      }
+    }
+    fan = best;
+  }
+}
+
+void ForsythIndices(const std::vector<uint16_t>& indices,
+                    const int32_t num_vertices, const int32_t cache_size,
+                    std::vector<uint16_t>* out) {
+  const int32_t num_triangles = (int32_t)(indices.size() / 3);
+  out->clear();
+  out->reserve(indices.size());
+  if (!num_triangles) return;
+
+  Adjacency adjacency;
+  adjacency.Build(indices, num_vertices);
+
+  std::vector<int32_t> live(num_vertices);
+  std::vector<int32_t> cache_position(num_vertices, -1);
+  std::vector<float> vertex_score(num_vertices);
+  for (int32_t v = 0; v < num_vertices; ++v) {
+    live[v] = adjacency.offsets_[v + 1] - adjacency.offsets_[v];
+    vertex_score[v] = ForsythScore(-1, live[v], cache_size);
+  }
+  std::vector<float> triangle_score(num_triangles);
+  std::vector<bool> emitted(num_triangles, false);
+  int32_t best = 0;
+  for (int32_t t = 0; t < num_triangles; ++t) {
+    const uint16_t* tri = &indices[t * 3];
+    triangle_score[t] = vertex_score[tri[0]] + vertex_score[tri[1]] +
+                        vertex_score[tri[2]];
+    if (triangle_score[t] > triangle_score[best]) best = t;
+  }
+
+  // LRU cache, most recent first; 3 more entries while a triangle goes in
+  std::vector<int32_t> cache, next_cache;
+  int32_t cursor = 0;  // Triangles before it are all emitted
+  while (best >= 0) {
+    const uint16_t* tri = &indices[best * 3];
+    emitted[best] = true;
+    next_cache.assign(tri, tri + 3);
+    for (int32_t k = 0; k < 3; ++k) {
+      out->push_back(tri[k]);
+      --live[tri[k]];
+    }
+    for (size_t i = 0; i < cache.size(); ++i)
+      if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+        next_cache.push_back(cache[i]);
+
+    for (size_t i = 0; i < next_cache.size(); ++i) {
+      const int32_t v = next_cache[i];
+      cache_position[v] = (int32_t)i < cache_size ? (int32_t)i : -1;
+      vertex_score[v] = ForsythScore(cache_position[v], live[v], cache_size);
+    }
+
+    // Next: the best triangle around the cache, the only scores changed
+    best = -1;
+    float best_score = -1e30f;
+    for (size_t i = 0; i < next_cache.size(); ++i) {
+      const int32_t v = next_cache[i];
+      for (int32_t j = adjacency.offsets_[v]; j < adjacency.offsets_[v + 1];
+           ++j) {
+        const int32_t t = adjacency.triangles_[j];
+        if (emitted[t]) continue;
+        const uint16_t* u = &indices[t * 3];
+        triangle_score[t] =
+            vertex_score[u[0]] + vertex_score[u[1]] + vertex_score[u[2]];
+        if (triangle_score[t] > best_score) {
+          best_score = triangle_score[t];
+          best = t;
+        }
+      }
+    }
+    next_cache.resize(std::min((int32_t)next_cache.size(), cache_size));
+    cache.swap(next_cache);
+
+    if (best < 0) {
+      // Nothing left around the cache: go on with the next triangle in the
+      // source order
+      while (cursor < num_triangles && emitted[cursor]) ++cursor;
+      if (cursor < num_triangles) best = cursor;
+    }
+  }
+}
+
+void OptimizeOverdraw(const std::vector<uint16_t>& indices,
+                      const float* positions, const int32_t num_vertices,
+                      const int32_t cache_size, const float threshold,
+                      std::vector<uint16_t>* out) {
+  const int32_t num_triangles = (int32_t)(indices.size() / 3);
+  out->clear();
+  if (!num_triangles) return;
+
+  // Hard boundaries: triangles missing on all their vertices start anew
+  std::vector<int32_t> hard;
+  {
+    FifoCache cache(cache_size);
+    for (int32_t t = 0; t < num_triangles; ++t)
+      if (cache.AccessTriangle(&indices[t * 3]) == 3) hard.push_back(t);
+    if (hard.empty() || hard[0]) hard.insert(hard.begin(), 0);
+    hard.push_back(num_triangles);
+  }
+
+  // Soft boundaries: within each, cut wherever the cluster so far runs at
+  // the ACMR of the whole times the threshold. The cache starts empty in
+  // each cluster, as it may follow any other once sorted.
+  std::vector<int32_t> clusters;
+  FifoCache cache(cache_size);
+  for (size_t h = 0; h + 1 < hard.size(); ++h) {
+    const int32_t begin = hard[h], end = hard[h + 1];
+    cache.Clear();
+    int32_t misses = 0;
+    for (int32_t t = begin; t < end; ++t)
+      misses += cache.AccessTriangle(&indices[t * 3]);
+    const float limit = (float)misses / (end - begin) * threshold;
+
+    clusters.push_back(begin);
+    cache.Clear();
+    int32_t cluster_misses = 0, cluster_triangles = 0;
+    for (int32_t t = begin; t < end; ++t) {
+      cluster_misses += cache.AccessTriangle(&indices[t * 3]);
+      ++cluster_triangles;
+      if (t + 1 < end && (float)cluster_misses / cluster_triangles <= limit) {
+        clusters.push_back(t + 1);
+        cache.Clear();
+        cluster_misses = cluster_triangles = 0;
+      }
+    }
+  }
+  clusters.push_back(num_triangles);
+
+  // Sort key: how far out the cluster lies along its own normal
+  float center[3] = {0.f, 0.f, 0.f};
+  for (int32_t v = 0; v < num_vertices; ++v)
+    for (int32_t c = 0; c < 3; ++c) center[c] += positions[v * 3 + c];
+  for (int32_t c = 0; c < 3; ++c) center[c] /= std::max(num_vertices, 1);
+
+  std::vector<std::pair<float, int32_t> > keys;
+  for (size_t i = 0; i + 1 < clusters.size(); ++i) {
+    float centroid[3] = {0.f, 0.f, 0.f};
+    float normal[3] = {0.f, 0.f, 0.f};
+    float total_area = 0.f;
+    for (int32_t t = clusters[i]; t < clusters[i + 1]; ++t) {
+      const float* a = &positions[indices[t * 3] * 3];
+      const float* b = &positions[indices[t * 3 + 1] * 3];
+      const float* c = &positions[indices[t * 3 + 2] * 3];
+      float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+      float n[3];
+      Cross(ab, ac, n);  // Length is twice the area
+      const float area = sqrtf(Dot(n, n)) * 0.5f;
+      for (int32_t k = 0; k < 3; ++k) {
+        centroid[k] += (a[k] + b[k] + c[k]) / 3.f * area;
+        normal[k] += n[k];
+      }
+      total_area += area;
+    }
+    if (total_area > 0.f)
+      for (int32_t k = 0; k < 3; ++k) centroid[k] /= total_area;
+    Normalize(normal);
+    float offset[3] = {centroid[0] - center[0], centroid[1] - center[1],
+                       centroid[2] - center[2]};
+    keys.push_back(std::make_pair(-Dot(offset, normal), (int32_t)i));
+  }
+  // Stable, so clusters with equal keys keep their cache order
+  std::stable_sort(keys.begin(), keys.end());
+
+  out->reserve(indices.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const int32_t c = keys[i].second;
+    out->insert(out->end(), indices.begin() + clusters[c] * 3,
+                indices.begin() + clusters[c + 1] * 3);
+  }
+}
+
+void OptimizeVertexFetch(const std::vector<uint16_t>& indices,
+                         const int32_t num_vertices,
+                         std::vector<int32_t>* remap,
+                         std::vector<uint16_t>* out) {
+  remap->assign(num_vertices, -1);
+  int32_t next = 0;
+  for (size_t i = 0; i < indices.size(); ++i)
+    if ((*remap)[indices[i]] < 0) (*remap)[indices[i]] = next++;
+  for (int32_t v = 0; v < num_vertices; ++v)
+    if ((*remap)[v] < 0) (*remap)[v] = next++;
+
+  out->resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    (*out)[i] = (uint16_t)(*remap)[indices[i]];
+}
+
+float ComputeAcmr(const std::vector<uint16_t>& indices,
+                  const int32_t cache_size) {
+  if (indices.size() < 3) return 0.f;
+  return (float)CountMisses(indices, cache_size) / (indices.size() / 3);
+}
+
+float ComputeAtvr(const std::vector<uint16_t>& indices,
+                  const int32_t num_vertices, const int32_t cache_size) {
+  std::vector<bool> used(num_vertices, false);
+  int32_t num_used = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (!used[indices[i]]) ++num_used;
+    used[indices[i]] = true;
+  }
+  if (!num_used) return 0.f;
+  return (float)CountMisses(indices, cache_size) / num_used;
+}
+
+float ComputeOverdraw(const std::vector<uint16_t>& indices,
+                      const float* positions, const int32_t num_vertices) {
+  int64_t shaded = 0, covered = 0;
+  for (int32_t axis = 0; axis < 3; ++axis) {
+    for (int32_t sign = -1; sign <= 1; sign += 2) {
+      float direction[3] = {0.f, 0.f, 0.f};
+      direction[axis] = (float)sign;
+      RasterizeView(indices, positions, num_vertices, direction, &shaded,
+                    &covered);
+    }
+  }
+  for (int32_t d = 0; d < 8; ++d) {
+    float direction[3] = {d & 1 ? 1.f : -1.f, d & 2 ? 1.f : -1.f,
+                          d & 4 ? 1.f : -1.f};
+    RasterizeView(indices, positions, num_vertices, direction, &shaded,
+                  &covered);
+  }
+  return covered ? (float)shaded / covered : 0.f;
+}
+
+}  // namespace mesh_optimizer
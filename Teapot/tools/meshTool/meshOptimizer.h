@@ -0,0 +1,133 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace mesh_optimizer {
+
+// Post-transform cache size the orderings are tuned for
+const int32_t DEFAULT_CACHE_SIZE = 16;
+
+/******************************************************************
+ * TipsifyIndices()
+ * Reorder the triangles of a triangle list for the post-transform vertex
+ * cache (Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw", 2007). Linear time.
+ *
+ * arguments:
+ *  in: indices, triangle list
+ *  in: num_vertices, vertex count
+ *  in: cache_size, cache size assumed
+ *  out: out, the same triangles, reordered
+ *
+ */
+void TipsifyIndices(const std::vector<uint16_t>& indices,
+                    const int32_t num_vertices, const int32_t cache_size,
+                    std::vector<uint16_t>* out);
+
+/******************************************************************
+ * ForsythIndices()
+ * Reorder the triangles of a triangle list for the post-transform vertex
+ * cache with Forsyth's greedy scoring ("Linear-Speed Vertex Cache
+ * Optimisation", 2006): each step emits the triangle whose vertices score
+ * highest, from their place in a simulated LRU cache and the triangles they
+ * still have to serve. Slower than Tipsify, often a little better.
+ *
+ * arguments:
+ *  in: indices, triangle list
+ *  in: num_vertices, vertex count
+ *  in: cache_size, cache size assumed, at least 4
+ *  out: out, the same triangles, reordered
+ *
+ */
+void ForsythIndices(const std::vector<uint16_t>& indices,
+                    const int32_t num_vertices, const int32_t cache_size,
+                    std::vector<uint16_t>* out);
+
+/******************************************************************
+ * OptimizeOverdraw()
+ * Reorder the clusters of a cache optimized triangle list so that the ones
+ * facing out from the mesh center come first, and tend to hide the rest
+ * from any view (the view independent sort of Sander et al. 2007).
+ * Clusters end where the cache order already misses on every vertex of a
+ * triangle, and are cut further where that costs little, as long as the
+ * ACMR of each cluster stays within threshold times its own.
+ *
+ * arguments:
+ *  in: indices, triangle list, ordered for the cache
+ *  in: positions, 3 floats per vertex
+ *  in: num_vertices, vertex count
+ *  in: cache_size, cache size assumed
+ *  in: threshold, ACMR growth allowed, e.g. 1.05
+ *  out: out, the same triangles, reordered
+ *
+ */
+void OptimizeOverdraw(const std::vector<uint16_t>& indices,
+                      const float* positions, const int32_t num_vertices,
+                      const int32_t cache_size, const float threshold,
+                      std::vector<uint16_t>* out);
+
+/******************************************************************
+ * OptimizeVertexFetch()
+ * Number the vertices in the order the triangles first use them, so the
+ * vertex fetch reads memory mostly forward. Unused vertices go last.
+ *
+ * arguments:
+ *  in: indices, triangle list
+ *  in: num_vertices, vertex count
+ *  out: remap, new index of each vertex
+ *  out: out, indices renumbered through remap
+ *
+ */
+void OptimizeVertexFetch(const std::vector<uint16_t>& indices,
+                         const int32_t num_vertices,
+                         std::vector<int32_t>* remap,
+                         std::vector<uint16_t>* out);
+
+/******************************************************************
+ * ComputeAcmr()
+ * Average cache miss ratio: vertices transformed per triangle with a FIFO
+ * cache of cache_size entries. 0.5 is the ideal for large regular meshes,
+ * 3 means no reuse at all.
+ */
+float ComputeAcmr(const std::vector<uint16_t>& indices,
+                  const int32_t cache_size);
+
+/******************************************************************
+ * ComputeAtvr()
+ * Average transformed vertex ratio: vertices transformed per vertex used,
+ * with the same FIFO cache. 1 is the ideal, whatever the mesh.
+ */
+float ComputeAtvr(const std::vector<uint16_t>& indices,
+                  const int32_t num_vertices, const int32_t cache_size);
+
+/******************************************************************
+ * ComputeOverdraw()
+ * Fragments shaded per covered pixel, averaged over orthographic views from
+ * the 6 axes and the 8 diagonals, with back faces (counter clockwise front
+ * faces) culled and early depth test. 1 is the ideal.
+ */
+float ComputeOverdraw(const std::vector<uint16_t>& indices,
+                      const float* positions, const int32_t num_vertices);
+
+}  // namespace mesh_optimizer
+#endif /* MESH_OPTIMIZER_H_ */
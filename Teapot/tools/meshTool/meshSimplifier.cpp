@@ -0,0 +1,440 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// meshSimplifier.cpp
+//--------------------------------------------------------------------------------
+#include "meshSimplifier.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <utility>
+
+namespace mesh_optimizer {
+
+namespace {
+
+// Boundary planes count this much more than the surface around them
+const double BOUNDARY_WEIGHT = 100.0;
+// Smallest cosine between a triangle normal before and after a collapse
+const double MIN_NORMAL_DOT = 0.2;
+// Steps per edge of the grid of points measured on each simplified triangle
+const int32_t SURFACE_SAMPLES = 8;
+
+//--------------------------------------------------------------------------------
+// Small vector helpers
+//--------------------------------------------------------------------------------
+struct Vec {
+  double x_, y_, z_;
+  Vec() : x_(0.0), y_(0.0), z_(0.0) {}
+  Vec(const double x, const double y, const double z) : x_(x), y_(y), z_(z) {}
+  Vec operator+(const Vec& v) const {
+    return Vec(x_ + v.x_, y_ + v.y_, z_ + v.z_);
+  }
+  Vec operator-(const Vec& v) const {
+    return Vec(x_ - v.x_, y_ - v.y_, z_ - v.z_);
+  }
+  Vec operator*(const double s) const { return Vec(x_ * s, y_ * s, z_ * s); }
+  double Dot(const Vec& v) const { return x_ * v.x_ + y_ * v.y_ + z_ * v.z_; }
+  Vec Cross(const Vec& v) const {
+    return Vec(y_ * v.z_ - z_ * v.y_, z_ * v.x_ - x_ * v.z_,
+               x_ * v.y_ - y_ * v.x_);
+  }
+  double Length() const { return sqrt(Dot(*this)); }
+};
+
+//--------------------------------------------------------------------------------
+// Quadric: sum of squared distances to a set of weighted planes
+//--------------------------------------------------------------------------------
+struct Quadric {
+  double xx_, xy_, xz_, xw_, yy_, yz_, yw_, zz_, zw_, ww_;
+
+  Quadric() { memset(this, 0, sizeof(*this)); }
+
+  // Plane n.p + d = 0, n unit length
+  void AddPlane(const Vec& n, const double d, const double weight) {
+    xx_ += weight * n.x_ * n.x_;
+    xy_ += weight * n.x_ * n.y_;
+    xz_ += weight * n.x_ * n.z_;
+    xw_ += weight * n.x_ * d;
+    yy_ += weight * n.y_ * n.y_;
+    yz_ += weight * n.y_ * n.z_;
+    yw_ += weight * n.y_ * d;
+    zz_ += weight * n.z_ * n.z_;
+    zw_ += weight * n.z_ * d;
+    ww_ += weight * d * d;
+  }
+
+  void Add(const Quadric& q) {
+    xx_ += q.xx_, xy_ += q.xy_, xz_ += q.xz_, xw_ += q.xw_;
+    yy_ += q.yy_, yz_ += q.yz_, yw_ += q.yw_;
+    zz_ += q.zz_, zw_ += q.zw_, ww_ += q.ww_;
+  }
+
+  double Evaluate(const Vec& p) const {
+    double e = xx_ * p.x_ * p.x_ + yy_ * p.y_ * p.y_ + zz_ * p.z_ * p.z_ +
+               2.0 * (xy_ * p.x_ * p.y_ + xz_ * p.x_ * p.z_ +
+                      yz_ * p.y_ * p.z_ + xw_ * p.x_ + yw_ * p.y_ +
+                      zw_ * p.z_) +
+               ww_;
+    return e > 0.0 ? e : 0.0;
+  }
+};
+
+struct Collapse {
+  double cost_;
+  int32_t from_;
+  int32_t to_;
+  uint32_t from_version_;
+  uint32_t to_version_;
+  bool operator>(const Collapse& rhs) const { return cost_ > rhs.cost_; }
+};
+
+//--------------------------------------------------------------------------------
+// Simplifier state, on welded vertices
+//--------------------------------------------------------------------------------
+class Simplifier {
+ public:
+  struct Vertex {
+    Vec position_;
+    Quadric quadric_;
+    bool alive_;
+    bool boundary_;
+    uint32_t version_;
+    std::vector<int32_t> triangles_;  // May list dead triangles
+  };
+  struct Triangle {
+    int32_t v_[3];
+    bool alive_;
+    bool Has(const int32_t v) const {
+      return v_[0] == v || v_[1] == v || v_[2] == v;
+    }
+  };
+
+  std::vector<Vertex> vertices_;
+  std::vector<Triangle> triangles_;
+  int32_t live_triangles_;
+  std::priority_queue<Collapse, std::vector<Collapse>,
+                      std::greater<Collapse> > heap_;
+
+  void AddTriangle(const int32_t a, const int32_t b, const int32_t c) {
+    Triangle t;
+    t.v_[0] = a, t.v_[1] = b, t.v_[2] = c;
+    t.alive_ = true;
+    for (int32_t k = 0; k < 3; ++k)
+      vertices_[t.v_[k]].triangles_.push_back((int32_t)triangles_.size());
+    triangles_.push_back(t);
+  }
+
+  Vec Normal(const Triangle& t) const {
+    const Vec& p0 = vertices_[t.v_[0]].position_;
+    return (vertices_[t.v_[1]].position_ - p0)
+        .Cross(vertices_[t.v_[2]].position_ - p0);
+  }
+
+  void BuildQuadrics() {
+    std::map<std::pair<int32_t, int32_t>, int32_t> edges;
+    for (size_t i = 0; i < triangles_.size(); ++i) {
+      const Triangle& t = triangles_[i];
+      for (int32_t k = 0; k < 3; ++k) {
+        int32_t a = t.v_[k], b = t.v_[(k + 1) % 3];
+        ++edges[std::make_pair(std::min(a, b), std::max(a, b))];
+      }
+    }
+
+    for (size_t i = 0; i < triangles_.size(); ++i) {
+      const Triangle& t = triangles_[i];
+      Vec n = Normal(t);
+      double length = n.Length();
+      if (length <= 0.0) continue;
+      n = n * (1.0 / length);
+      const Vec& p0 = vertices_[t.v_[0]].position_;
+      // Area weighted, so small triangles do not dominate
+      for (int32_t k = 0; k < 3; ++k)
+        vertices_[t.v_[k]].quadric_.AddPlane(n, -n.Dot(p0), length * 0.5);
+
+      // A plane through each boundary edge, normal to the surface
+      for (int32_t k = 0; k < 3; ++k) {
+        int32_t a = t.v_[k], b = t.v_[(k + 1) % 3];
+        if (edges[std::make_pair(std::min(a, b), std::max(a, b))] != 1)
+          continue;
+        const Vec& pa = vertices_[a].position_;
+        Vec e = vertices_[b].position_ - pa;
+        Vec m = e.Cross(n);
+        double m_length = m.Length();
+        if (m_length <= 0.0) continue;
+        m = m * (1.0 / m_length);
+        double weight = BOUNDARY_WEIGHT * e.Dot(e);
+        vertices_[a].quadric_.AddPlane(m, -m.Dot(pa), weight);
+        vertices_[b].quadric_.AddPlane(m, -m.Dot(pa), weight);
+        vertices_[a].boundary_ = vertices_[b].boundary_ = true;
+      }
+    }
+  }
+
+  void Neighbors(const int32_t v, std::vector<int32_t>* out) const {
+    out->clear();
+    const std::vector<int32_t>& list = vertices_[v].triangles_;
+    for (size_t i = 0; i < list.size(); ++i) {
+      const Triangle& t = triangles_[list[i]];
+      if (!t.alive_) continue;
+      for (int32_t k = 0; k < 3; ++k)
+        if (t.v_[k] != v) out->push_back(t.v_[k]);
+    }
+    std::sort(out->begin(), out->end());
+    out->erase(std::unique(out->begin(), out->end()), out->end());
+  }
+
+  int32_t SharedTriangles(const int32_t u, const int32_t v) const {
+    int32_t shared = 0;
+    const std::vector<int32_t>& list = vertices_[u].triangles_;
+    for (size_t i = 0; i < list.size(); ++i) {
+      const Triangle& t = triangles_[list[i]];
+      if (t.alive_ && t.Has(v)) ++shared;
+    }
+    return shared;
+  }
+
+  void Push(const int32_t from, const int32_t to) {
+    const Vertex& u = vertices_[from];
+    const Vertex& v = vertices_[to];
+    if (u.boundary_ && (!v.boundary_ || SharedTriangles(from, to) != 1))
+      return;
+    Quadric q = u.quadric_;
+    q.Add(v.quadric_);
+    Collapse c;
+    c.cost_ = q.Evaluate(v.position_);
+    c.from_ = from;
+    c.to_ = to;
+    c.from_version_ = u.version_;
+    c.to_version_ = v.version_;
+    heap_.push(c);
+  }
+
+  bool CanCollapse(const int32_t u, const int32_t v) const {
+    int32_t shared = SharedTriangles(u, v);
+    if (!shared) return false;
+
+    // Link condition: the only common neighbors are the vertices opposite
+    // the edge, otherwise the collapse pinches the surface
+    std::vector<int32_t> nu, nv, common;
+    Neighbors(u, &nu);
+    Neighbors(v, &nv);
+    std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(),
+                          std::back_inserter(common));
+    if ((int32_t)common.size() != shared) return false;
+
+    // The triangles that move must not fold over
+    const Vec& target = vertices_[v].position_;
+    const std::vector<int32_t>& list = vertices_[u].triangles_;
+    for (size_t i = 0; i < list.size(); ++i) {
+      const Triangle& t = triangles_[list[i]];
+      if (!t.alive_ || t.Has(v)) continue;
+      Vec before = Normal(t);
+      Vec p[3];
+      for (int32_t k = 0; k < 3; ++k)
+        p[k] = t.v_[k] == u ? target : vertices_[t.v_[k]].position_;
+      Vec after = (p[1] - p[0]).Cross(p[2] - p[0]);
+      double lengths = before.Length() * after.Length();
+      if (lengths <= 0.0 || before.Dot(after) < MIN_NORMAL_DOT * lengths)
+        return false;
+    }
+    return true;
+  }
+
+  void Apply(const int32_t u, const int32_t v) {
+    Vertex& to = vertices_[v];
+    to.quadric_.Add(vertices_[u].quadric_);
+    std::vector<int32_t>& list = vertices_[u].triangles_;
+    for (size_t i = 0; i < list.size(); ++i) {
+      Triangle& t = triangles_[list[i]];
+      if (!t.alive_) continue;
+      if (t.Has(v)) {
+        t.alive_ = false;
+        --live_triangles_;
+      } else {
+        for (int32_t k = 0; k < 3; ++k)
+          if (t.v_[k] == u) t.v_[k] = v;
+        to.triangles_.push_back(list[i]);
+      }
+    }
+    vertices_[u].alive_ = false;
+    list.clear();
+
+    // Costs around v changed
+    std::vector<int32_t> neighbors;
+    Neighbors(v, &neighbors);
+    ++to.version_;
+    for (size_t i = 0; i < neighbors.size(); ++i)
+      ++vertices_[neighbors[i]].version_;
+    for (size_t i = 0; i < neighbors.size(); ++i) {
+      Push(v, neighbors[i]);
+      Push(neighbors[i], v);
+    }
+  }
+
+  void Run(const int32_t target_triangles) {
+    for (size_t i = 0; i < triangles_.size(); ++i) {
+      const Triangle& t = triangles_[i];
+      for (int32_t k = 0; k < 3; ++k) {
+        Push(t.v_[k], t.v_[(k + 1) % 3]);
+        Push(t.v_[(k + 1) % 3], t.v_[k]);
+      }
+    }
+
+    while (live_triangles_ > target_triangles && !heap_.empty()) {
+      Collapse c = heap_.top();
+      heap_.pop();
+      const Vertex& u = vertices_[c.from_];
+      const Vertex& v = vertices_[c.to_];
+      if (!u.alive_ || !v.alive_ || u.version_ != c.from_version_ ||
+          v.version_ != c.to_version_)
+        continue;
+      if (!CanCollapse(c.from_, c.to_)) continue;
+      Apply(c.from_, c.to_);
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------
+// Distance from p to triangle abc (Ericson, Real-Time Collision Detection)
+//--------------------------------------------------------------------------------
+double PointTriangleDistance(const Vec& p, const Vec& a, const Vec& b,
+                             const Vec& c) {
+  Vec ab = b - a, ac = c - a, ap = p - a;
+  double d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+  if (d1 <= 0.0 && d2 <= 0.0) return ap.Length();
+  Vec bp = p - b;
+  double d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+  if (d3 >= 0.0 && d4 <= d3) return bp.Length();
+  double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    return (p - (a + ab * (d1 / (d1 - d3)))).Length();
+  Vec cp = p - c;
+  double d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+  if (d6 >= 0.0 && d5 <= d6) return cp.Length();
+  double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    return (p - (a + ac * (d2 / (d2 - d6)))).Length();
+  double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))))
+        .Length();
+  double denominator = 1.0 / (va + vb + vc);
+  Vec closest = a + ab * (vb * denominator) + ac * (vc * denominator);
+  return (p - closest).Length();
+}
+
+// Distance from p to the nearest of the triangles, three corners each
+double SurfaceDistance(const Vec& p, const std::vector<Vec>& corners) {
+  double distance = HUGE_VAL;
+  for (size_t i = 0; i < corners.size(); i += 3)
+    distance = std::min(distance, PointTriangleDistance(p, corners[i],
+                                                        corners[i + 1],
+                                                        corners[i + 2]));
+  return distance;
+}
+
+}  // namespace
+
+float SimplifyIndices(const float* positions, const int32_t num_vertices,
+                      const std::vector<uint16_t>& indices,
+                      const int32_t target_triangles,
+                      std::vector<uint16_t>* out) {
+  out->clear();
+  if (!num_vertices || indices.empty()) return 0.f;
+
+  // Weld vertices with the same position; the lowest index represents them
+  std::vector<int32_t> order(num_vertices);
+  for (int32_t i = 0; i < num_vertices; ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [positions](const int32_t a, const int32_t b) {
+                     return memcmp(positions + a * 3, positions + b * 3,
+                                   sizeof(float) * 3) < 0;
+                   });
+  std::vector<int32_t> weld(num_vertices);
+  std::vector<uint16_t> representative;
+  Simplifier simplifier;
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    const int32_t v = order[i];
+    if (i == 0 || memcmp(positions + v * 3, positions + order[i - 1] * 3,
+                         sizeof(float) * 3)) {
+      Simplifier::Vertex vertex;
+      vertex.position_ = Vec(positions[v * 3], positions[v * 3 + 1],
+                             positions[v * 3 + 2]);
+      vertex.alive_ = true;
+      vertex.boundary_ = false;
+      vertex.version_ = 0;
+      simplifier.vertices_.push_back(vertex);
+      representative.push_back((uint16_t)v);
+    }
+    weld[v] = (int32_t)simplifier.vertices_.size() - 1;
+  }
+
+  // Triangles collapsed by the welding (poles) are dropped
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    int32_t a = weld[indices[i]], b = weld[indices[i + 1]],
+            c = weld[indices[i + 2]];
+    if (a != b && b != c && c != a) simplifier.AddTriangle(a, b, c);
+  }
+  simplifier.live_triangles_ = (int32_t)simplifier.triangles_.size();
+  std::vector<Vec> source_corners;
+  for (size_t i = 0; i < simplifier.triangles_.size(); ++i)
+    for (int32_t k = 0; k < 3; ++k)
+      source_corners.push_back(
+          simplifier.vertices_[simplifier.triangles_[i].v_[k]].position_);
+  simplifier.BuildQuadrics();
+  simplifier.Run(target_triangles);
+
+  std::vector<Vec> corners;
+  for (size_t i = 0; i < simplifier.triangles_.size(); ++i) {
+    const Simplifier::Triangle& t = simplifier.triangles_[i];
+    if (!t.alive_) continue;
+    for (int32_t k = 0; k < 3; ++k) {
+      out->push_back(representative[t.v_[k]]);
+      corners.push_back(simplifier.vertices_[t.v_[k]].position_);
+    }
+  }
+
+  // Measure the error both ways: from every source vertex to the result,
+  // and from points spread over the result to the source surface
+  double max_distance = 0.0;
+  for (size_t i = 0; i < representative.size(); ++i) {
+    const float* p = positions + representative[i] * 3;
+    max_distance = std::max(
+        max_distance, SurfaceDistance(Vec(p[0], p[1], p[2]), corners));
+  }
+  for (size_t i = 0; i < corners.size(); i += 3) {
+    const Vec ab = corners[i + 1] - corners[i];
+    const Vec ac = corners[i + 2] - corners[i];
+    for (int32_t u = 0; u <= SURFACE_SAMPLES; ++u)
+      for (int32_t v = 0; u + v <= SURFACE_SAMPLES; ++v) {
+        const Vec point = corners[i] + ab * ((double)u / SURFACE_SAMPLES) +
+                          ac * ((double)v / SURFACE_SAMPLES);
+        max_distance =
+            std::max(max_distance, SurfaceDistance(point, source_corners));
+      }
+  }
+  return (float)max_distance;
+}
+
+}  // namespace mesh_optimizer
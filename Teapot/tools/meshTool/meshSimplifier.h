@@ -0,0 +1,55 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace mesh_optimizer {
+
+/******************************************************************
+ * SimplifyIndices()
+ * Decimate a triangle list with quadric error metrics (Garland, Heckbert,
+ * "Surface Simplification Using Quadric Error Metrics", 1997) and half edge
+ * collapses: a vertex is only ever merged into one of its neighbors, so the
+ * result indexes the source vertices and can share their vertex buffer.
+ *
+ * Vertices with the same position (seams between patches, poles) are
+ * simplified as one, so seams do not open. Open boundaries only collapse
+ * along themselves and are weighted to keep their shape. Collapses that
+ * would fold a triangle over or make the surface non manifold are skipped.
+ *
+ * arguments:
+ *  in: positions, num_vertices xyz
+ *  in: indices, triangle list
+ *  in: target_triangles, stop at this many triangles or fewer
+ *  out: out, the simplified triangle list
+ * return: largest distance between the source and the simplified surface:
+ *         from every source vertex to the result, and from a grid of
+ *         points on each result triangle to the source
+ *
+ */
+float SimplifyIndices(const float* positions, const int32_t num_vertices,
+                      const std::vector<uint16_t>& indices,
+                      const int32_t target_triangles,
+                      std::vector<uint16_t>* out);
+
+}  // namespace mesh_optimizer
+#endif /* MESH_SIMPLIFIER_H_ */
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// meshTool.cpp
+// Host tool writing the teapot in the ndk_helper binary mesh format (mesh.h)
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  g++ -O2 -I$NDK_HELPER -o meshTool *.cpp $NDK_HELPER/mesh.cpp
+//  ./meshTool ../../app/src/main/assets/Models/Teapot.mesh
+//  ./meshTool -lod ../../../MoreTeapots/app/src/main/jni/teapotLod.inl
+//
+// Options:
+//  -float  keep 32 bit float positions instead of quantizing them
+//  -lod    write the full mesh and decimated levels of detail, and the
+//          bounding sphere, as a C++ include indexing the vertices of
+//          teapot.inl
+//
+// Triangles are reordered for the post-transform cache (the best of the
+// source order, Tipsify and Forsyth), then their clusters sorted to cut
+// overdraw; the mesh file also has its vertices renumbered in fetch order.
+// ACMR, ATVR and overdraw are printed before and after. Each stage must keep
+// the triangle set of its input, with the same winding, and the result must
+// not have a higher ACMR than the source order.
+//
+// The written file is read back and checked: every decoded position and
+// normal must be within the encoding error bounds below, and the triangles
+// must be the ones of the source, with the same winding. Levels of detail
+// must only index existing vertices and have no degenerate triangles. Any
+// violation fails the tool.
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "mesh.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+
+#include "../../app/src/main/jni/teapot.inl"
+
+using ndk_helper::MeshData;
+
+namespace {
+
+// Largest angle between a source normal and its decoded encoding, radians.
+// 32 bit octahedral encoding peaks at about 1.3e-4 over the whole sphere.
+const float MAX_NORMAL_ERROR = 2e-4f;
+
+// Triangles kept by each level of detail below the full mesh
+const float LOD_FRACTIONS[] = {0.4f, 0.2f};
+const int32_t NUM_LODS = sizeof(LOD_FRACTIONS) / sizeof(LOD_FRACTIONS[0]);
+
+// ACMR growth allowed to the overdraw sort
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+struct Triangle {
+  uint16_t v_[3];
+
+  // Rotated so the smallest index comes first, which keeps the winding
+  void Set(const uint16_t a, const uint16_t b, const uint16_t c) {
+    if (a <= b && a <= c) {
+      v_[0] = a, v_[1] = b, v_[2] = c;
+    } else if (b <= a && b <= c) {
+      v_[0] = b, v_[1] = c, v_[2] = a;
+    } else {
+      v_[0] = c, v_[1] = a, v_[2] = b;
+    }
+  }
+  bool operator<(const Triangle& rhs) const {
+    return memcmp(v_, rhs.v_, sizeof(v_)) < 0;
+  }
+  bool operator==(const Triangle& rhs) const {
+    return memcmp(v_, rhs.v_, sizeof(v_)) == 0;
+  }
+};
+
+std::vector<Triangle> SortedTriangles(const std::vector<uint16_t>& indices) {
+  std::vector<Triangle> triangles(indices.size() / 3);
+  for (size_t i = 0; i < triangles.size(); ++i)
+    triangles[i].Set(indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+bool Verify(const std::vector<uint8_t>& file, const std::vector<float>& positions,
+            const std::vector<float>& normals,
+            const std::vector<uint16_t>& indices) {
+  MeshData mesh;
+  if (!mesh.Parse(&file[0], file.size())) {
+    fprintf(stderr, "Written mesh does not parse\n");
+    return false;
+  }
+  const int32_t num_vertices = (int32_t)positions.size() / 3;
+  if (mesh.GetNumVertices() != num_vertices ||
+      mesh.GetNumIndices() != (int32_t)indices.size()) {
+    fprintf(stderr, "Vertex or index count mismatch\n");
+    return false;
+  }
+
+  // Half a quantization step per axis, plus float rounding
+  float max_position_error[3];
+  for (int32_t c = 0; c < 3; ++c) {
+    float extent = mesh.GetAabbMax()[c] - mesh.GetAabbMin()[c];
+    float magnitude = std::max(fabsf(mesh.GetAabbMax()[c]),
+                               fabsf(mesh.GetAabbMin()[c]));
+    max_position_error[c] = (mesh.IsQuantized() ? extent / 65535.f * 0.5f : 0.f) +
+                            magnitude * 4e-7f;
+  }
+
+  float worst_position[3] = {0.f, 0.f, 0.f};
+  float worst_normal = 0.f;
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    float p[3], n[3];
+    mesh.GetPosition(i, p);
+    mesh.GetNormal(i, n);
+    const float* n0 = &normals[i * 3];
+    for (int32_t c = 0; c < 3; ++c) {
+      float error = fabsf(p[c] - positions[i * 3 + c]);
+      worst_position[c] = std::max(worst_position[c], error);
+      if (error > max_position_error[c]) {
+        fprintf(stderr, "Vertex %d axis %d position error %g > %g\n", i, c,
+                error, max_position_error[c]);
+        return false;
+      }
+    }
+    // atan2 of |cross| and dot stays accurate for tiny angles, acos does not
+    float cross[3] = {n[1] * n0[2] - n[2] * n0[1], n[2] * n0[0] - n[0] * n0[2],
+                      n[0] * n0[1] - n[1] * n0[0]};
+    float angle = atan2f(
+        sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]),
+        n[0] * n0[0] + n[1] * n0[1] + n[2] * n0[2]);
+    worst_normal = std::max(worst_normal, angle);
+    if (angle > MAX_NORMAL_ERROR) {
+      fprintf(stderr, "Vertex %d normal error %g rad\n", i, angle);
+      return false;
+    }
+  }
+
+  std::vector<uint16_t> decoded(indices.size());
+  for (size_t i = 0; i < decoded.size(); ++i) decoded[i] = mesh.GetIndex(i);
+  if (!(SortedTriangles(decoded) == SortedTriangles(indices))) {
+    fprintf(stderr, "Triangles differ from the source\n");
+    return false;
+  }
+
+  printf("Max position error %g %g %g (bound %g %g %g)\n", worst_position[0],
+         worst_position[1], worst_position[2], max_position_error[0],
+         max_position_error[1], max_position_error[2]);
+  printf("Max normal error %g rad (bound %g)\n", worst_normal,
+         MAX_NORMAL_ERROR);
+  return true;
+}
+
+bool VerifyLod(const std::vector<uint16_t>& indices,
+               const int32_t num_vertices) {
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const uint16_t* t = &indices[i];
+    if (t[0] >= num_vertices || t[1] >= num_vertices ||
+        t[2] >= num_vertices) {
+      fprintf(stderr, "LOD triangle %zu indexes a missing vertex\n", i / 3);
+      return false;
+    }
+    if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) {
+      fprintf(stderr, "LOD triangle %zu is degenerate\n", i / 3);
+      return false;
+    }
+  }
+  return !indices.empty();
+}
+
+bool SameTriangles(const char* stage, const std::vector<uint16_t>& before,
+                   const std::vector<uint16_t>& after) {
+  if (SortedTriangles(before) == SortedTriangles(after)) return true;
+  fprintf(stderr, "%s changed the triangles\n", stage);
+  return false;
+}
+
+void PrintStats(const char* name, const std::vector<uint16_t>& indices,
+                const std::vector<float>& positions) {
+  const int32_t num_vertices = (int32_t)positions.size() / 3;
+  const int32_t cache_size = mesh_optimizer::DEFAULT_CACHE_SIZE;
+  printf("  %-10s ACMR %.3f, ATVR %.3f, overdraw %.3f\n", name,
+         mesh_optimizer::ComputeAcmr(indices, cache_size),
+         mesh_optimizer::ComputeAtvr(indices, num_vertices, cache_size),
+         mesh_optimizer::ComputeOverdraw(indices, &positions[0],
+                                         num_vertices));
+}
+
+// Cache order, then overdraw order when it helps
+bool OptimizeIndices(const std::vector<float>& positions,
+                     const std::vector<uint16_t>& source,
+                     std::vector<uint16_t>* out) {
+  const int32_t num_vertices = (int32_t)positions.size() / 3;
+  const int32_t cache_size = mesh_optimizer::DEFAULT_CACHE_SIZE;
+  std::vector<uint16_t> tipsify, forsyth, sorted;
+  mesh_optimizer::TipsifyIndices(source, num_vertices, cache_size, &tipsify);
+  mesh_optimizer::ForsythIndices(source, num_vertices, cache_size, &forsyth);
+  if (!SameTriangles("Tipsify", source, tipsify) ||
+      !SameTriangles("Forsyth", source, forsyth))
+    return false;
+
+  // Keep the source order when it is as cache friendly: the teapot's
+  // patches each fit in the cache, so every vertex is transformed once
+  // before any reordering
+  const char* order = "source";
+  *out = source;
+  const float source_acmr = mesh_optimizer::ComputeAcmr(source, cache_size);
+  const float tipsify_acmr = mesh_optimizer::ComputeAcmr(tipsify, cache_size);
+  const float forsyth_acmr = mesh_optimizer::ComputeAcmr(forsyth, cache_size);
+  float acmr = source_acmr;
+  printf("  ACMR (FIFO %d): source %.3f, tipsify %.3f, forsyth %.3f\n",
+         cache_size, source_acmr, tipsify_acmr, forsyth_acmr);
+  if (tipsify_acmr < acmr) {
+    order = "tipsify";
+    *out = tipsify;
+    acmr = tipsify_acmr;
+  }
+  if (forsyth_acmr < acmr) {
+    order = "forsyth";
+    *out = forsyth;
+    acmr = forsyth_acmr;
+  }
+
+  mesh_optimizer::OptimizeOverdraw(*out, &positions[0], num_vertices,
+                                   cache_size, OVERDRAW_THRESHOLD, &sorted);
+  if (!SameTriangles("Overdraw sort", source, sorted)) return false;
+  const float overdraw =
+      mesh_optimizer::ComputeOverdraw(*out, &positions[0], num_vertices);
+  const float sorted_overdraw =
+      mesh_optimizer::ComputeOverdraw(sorted, &positions[0], num_vertices);
+  // The threshold holds per cluster; the sort is kept only if the whole
+  // stays within it of the cache order, and no worse than the source
+  const float sorted_acmr = mesh_optimizer::ComputeAcmr(sorted, cache_size);
+  const bool sorted_acmr_ok = sorted_acmr <= acmr * OVERDRAW_THRESHOLD &&
+                              sorted_acmr <= source_acmr;
+  printf("  Overdraw: %s %.3f, sorted %.3f (ACMR %.3f%s)\n", order, overdraw,
+         sorted_overdraw, sorted_acmr, sorted_acmr_ok ? "" : ", rejected");
+  if (sorted_overdraw < overdraw && sorted_acmr_ok) out->swap(sorted);
+
+  if (mesh_optimizer::ComputeAcmr(*out, cache_size) > source_acmr) {
+    fprintf(stderr, "The optimized order has a higher ACMR than the source\n");
+    return false;
+  }
+  return true;
+}
+
+void WriteArray(FILE* fp, const std::vector<uint16_t>& values) {
+  for (size_t i = 0; i < values.size(); ++i)
+    fprintf(fp, "%s%d%s", i % 16 ? " " : "    ", values[i],
+            i + 1 == values.size() ? "\n" : (i % 16 == 15 ? ",\n" : ","));
+}
+
+bool WriteLods(const char* output, const std::vector<float>& positions,
+               const std::vector<uint16_t>& source) {
+  const int32_t num_vertices = (int32_t)positions.size() / 3;
+
+  // Sphere around the center of the bounding box
+  float center[3], radius = 0.f;
+  for (int32_t c = 0; c < 3; ++c) {
+    float low = positions[c], high = positions[c];
+    for (int32_t i = 1; i < num_vertices; ++i) {
+      low = std::min(low, positions[i * 3 + c]);
+      high = std::max(high, positions[i * 3 + c]);
+    }
+    center[c] = (low + high) * 0.5f;
+  }
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    const float* p = &positions[i * 3];
+    float d[3] = {p[0] - center[0], p[1] - center[1], p[2] - center[2]};
+    radius = std::max(radius, sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]));
+  }
+  // Round up so float printing can not shrink the sphere
+  radius *= 1.0001f;
+
+  std::vector<uint16_t> all;
+  std::vector<uint16_t> counts;
+  std::vector<float> errors;
+  for (int32_t l = 0; l <= NUM_LODS; ++l) {
+    std::vector<uint16_t> simplified, indices;
+    float error = 0.f;
+    if (l == 0) {
+      simplified = source;
+    } else {
+      const int32_t target =
+          (int32_t)(source.size() / 3 * LOD_FRACTIONS[l - 1]);
+      error = mesh_optimizer::SimplifyIndices(&positions[0], num_vertices,
+                                              source, target, &simplified);
+    }
+    printf("LOD %d: %d triangles, max error %g\n", l,
+           (int32_t)simplified.size() / 3, error);
+    if (!OptimizeIndices(positions, simplified, &indices)) return false;
+    if (!VerifyLod(indices, num_vertices)) return false;
+    PrintStats("before", simplified, positions);
+    PrintStats("after", indices, positions);
+    all.insert(all.end(), indices.begin(), indices.end());
+    counts.push_back((uint16_t)indices.size());
+    errors.push_back(error);
+  }
+
+  FILE* fp = fopen(output, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "Can not write %s\n", output);
+    return false;
+  }
+  fprintf(fp,
+          "// Generated by Teapot/tools/meshTool -lod from teapot.inl, "
+          "do not edit.\n"
+          "// The teapot and decimated teapots, indexing the vertices of "
+          "teapot.inl.\n\n");
+  fprintf(fp, "const float teapotBoundingCenter[] = { %.9g, %.9g, %.9g };\n",
+          center[0], center[1], center[2]);
+  fprintf(fp, "const float teapotBoundingRadius = %.9g;\n\n", radius);
+  fprintf(fp,
+          "// Largest distance between teapot.inl and each level, either "
+          "way, full mesh\n// first\n");
+  fprintf(fp, "const float teapotLodErrors[] = { ");
+  for (int32_t l = 0; l <= NUM_LODS; ++l)
+    fprintf(fp, "%s%.9g", l ? ", " : "", errors[l]);
+  fprintf(fp, " };\n\n");
+  fprintf(fp,
+          "// Indices of each level, the levels one after another, ordered "
+          "for the vertex\n// cache and overdraw\n");
+  fprintf(fp, "const uint16_t teapotLodIndexCounts[] = { ");
+  for (int32_t l = 0; l <= NUM_LODS; ++l)
+    fprintf(fp, "%s%d", l ? ", " : "", counts[l]);
+  fprintf(fp, " };\n");
+  fprintf(fp, "const uint16_t teapotLodIndices[] = {\n");
+  WriteArray(fp, all);
+  fprintf(fp, "};\n");
+  bool written = !ferror(fp);
+  if (fclose(fp) || !written) {
+    fprintf(stderr, "Can not write %s\n", output);
+    return false;
+  }
+  printf("Wrote %s: bounding radius %g\n", output, radius);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t flags = ndk_helper::MESH_FLAG_QUANTIZED_POSITIONS;
+  const char* output = NULL;
+  const char* lod_output = NULL;
+  for (int32_t i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-float"))
+      flags &= ~ndk_helper::MESH_FLAG_QUANTIZED_POSITIONS;
+    else if (!strcmp(argv[i], "-lod") && i + 1 < argc)
+      lod_output = argv[++i];
+    else
+      output = argv[i];
+  }
+  if (output == NULL && lod_output == NULL) {
+    fprintf(stderr, "usage: %s [-float] [-lod lods.inl] [output.mesh]\n",
+            argv[0]);
+    return 1;
+  }
+
+  const int32_t num_vertices =
+      sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
+  std::vector<float> positions(teapotPositions,
+                               teapotPositions + num_vertices * 3);
+  std::vector<float> normals(teapotNormals, teapotNormals + num_vertices * 3);
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    float* n = &normals[i * 3];
+    float inv_length = 1.f / sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    for (int32_t c = 0; c < 3; ++c) n[c] *= inv_length;
+  }
+  std::vector<uint16_t> source(
+      teapotIndices,
+      teapotIndices + sizeof(teapotIndices) / sizeof(teapotIndices[0]));
+
+  if (lod_output && !WriteLods(lod_output, positions, source)) return 1;
+  if (output == NULL) return 0;
+
+  printf("Mesh: %d triangles\n", (int32_t)source.size() / 3);
+  std::vector<uint16_t> ordered, indices;
+  if (!OptimizeIndices(positions, source, &ordered)) return 1;
+
+  // Vertices in the order the triangles fetch them; the source goes through
+  // the same renumbering to be compared with the file
+  std::vector<int32_t> remap;
+  mesh_optimizer::OptimizeVertexFetch(ordered, num_vertices, &remap, &indices);
+  std::vector<float> fetch_positions(positions.size());
+  std::vector<float> fetch_normals(normals.size());
+  for (int32_t i = 0; i < num_vertices; ++i) {
+    for (int32_t c = 0; c < 3; ++c) {
+      fetch_positions[remap[i] * 3 + c] = positions[i * 3 + c];
+      fetch_normals[remap[i] * 3 + c] = normals[i * 3 + c];
+    }
+  }
+  std::vector<uint16_t> remapped_source(source.size());
+  for (size_t i = 0; i < source.size(); ++i)
+    remapped_source[i] = (uint16_t)remap[source[i]];
+  if (!SameTriangles("Vertex fetch order", remapped_source, indices)) return 1;
+  PrintStats("before", source, positions);
+  PrintStats("after", indices, fetch_positions);
+
+  std::vector<uint8_t> file;
+  if (!ndk_helper::mesh::WriteMesh(&fetch_positions[0], &fetch_normals[0],
+                                   num_vertices, &indices[0],
+                                   (int32_t)indices.size(), flags, &file)) {
+    fprintf(stderr, "Mesh can not be encoded\n");
+    return 1;
+  }
+  if (!Verify(file, fetch_positions, fetch_normals, remapped_source)) return 1;
+
+  FILE* fp = fopen(output, "wb");
+  if (fp == NULL || fwrite(&file[0], 1, file.size(), fp) != file.size()) {
+    fprintf(stderr, "Can not write %s\n", output);
+    if (fp) fclose(fp);
+    return 1;
+  }
+  fclose(fp);
+  printf("Wrote %s: %d vertices, %d triangles, %zu bytes\n", output,
+         num_vertices, (int32_t)indices.size() / 3, file.size());
+  return 0;
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// perfMonitorTest.cpp
+// Host test for the frame statistics and tracing of ndk_helper perfMonitor.h
+//
+// FrameHistogram percentiles are checked against the exact percentiles of
+// the recorded samples, for several frame time distributions: a bucket
+// midpoint is off by at most 1/32 of the value, plus the microsecond the
+// durations are truncated to. The max must be exact.
+//
+// TraceRecorder must be off by default and record nothing then. Enabled, an
+// export must hold each thread's most recent TRACE_BUFFER_EVENTS - 1 zones,
+// and exports taken while threads keep recording must never show a torn
+// event.
+// Then times a zone, disabled and enabled, and an export of full buffers.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  g++ -O2 -pthread -I$NDK_HELPER -o perfMonitorTest perfMonitorTest.cpp
+//  $NDK_HELPER/perfMonitor.cpp -lEGL -lGLESv2
+//  ./perfMonitorTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perfMonitor.h"
+
+using ndk_helper::FrameHistogram;
+using ndk_helper::PerfMonitor;
+using ndk_helper::TraceRecorder;
+using ndk_helper::TraceZone;
+
+namespace {
+
+const int32_t SAMPLES = 20000;
+const int32_t THREADS = 4;
+const int64_t MS = 1000000;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+uint32_t g_seed = 12345;
+
+// Uniform in [0, 1)
+double Random() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return (g_seed >> 8) / 16777216.0;
+}
+
+double NowNs() { return (double)PerfMonitor::GetCurrentTimeNs(); }
+
+//--------------------------------------------------------------------------------
+// Histogram
+//--------------------------------------------------------------------------------
+enum DISTRIBUTION {
+  DISTRIBUTION_CONSTANT,
+  DISTRIBUTION_UNIFORM,
+  DISTRIBUTION_BIMODAL,
+  DISTRIBUTION_LONG_TAIL,
+  DISTRIBUTION_SUB_MICROSECOND,
+  DISTRIBUTION_COUNT,
+};
+
+const char* DISTRIBUTION_NAMES[DISTRIBUTION_COUNT] = {
+    "constant 16.7ms", "uniform 1-50ms", "bimodal 16.7/33ms",
+    "long tail",       "below 1us",
+};
+
+int64_t Sample(const DISTRIBUTION distribution) {
+  switch (distribution) {
+    case DISTRIBUTION_CONSTANT:
+      return 16666667;
+    case DISTRIBUTION_UNIFORM:
+      return MS + (int64_t)(Random() * 49 * MS);
+    case DISTRIBUTION_BIMODAL:
+      // Mostly on time, one frame in ten missing a vsync
+      return (Random() < 0.9 ? 16666667 : 33333333) +
+             (int64_t)((Random() - 0.5) * MS);
+    case DISTRIBUTION_LONG_TAIL:
+      // 8ms times a log-normal factor, up to seconds
+      return (int64_t)(8 * MS * exp(1.2 * sqrt(-2.0 * log(1.0 - Random())) *
+                                    cos(2.0 * M_PI * Random())));
+    default:
+      return (int64_t)(Random() * 1000);
+  }
+}
+
+void TestHistogram() {
+  static const float PERCENTILES[] = {0.f,  1.f,  10.f, 50.f,
+                                      90.f, 99.f, 99.9f, 100.f};
+  for (int32_t d = 0; d < DISTRIBUTION_COUNT; ++d) {
+    FrameHistogram histogram;
+    std::vector<int64_t> samples;
+    for (int32_t i = 0; i < SAMPLES; ++i) {
+      samples.push_back(Sample((DISTRIBUTION)d));
+      histogram.Record(samples.back());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double worst = 0.0, worst_us = 0.0;
+    for (size_t p = 0; p < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]);
+         ++p) {
+      // Nearest rank, as GetPercentileNs()
+      int32_t rank = (int32_t)ceil(PERCENTILES[p] / 100.f * SAMPLES);
+      rank = std::min(std::max(rank, 1), SAMPLES);
+      const int64_t exact = samples[rank - 1];
+      const int64_t estimate = histogram.GetPercentileNs(PERCENTILES[p]);
+      const double error = fabs((double)(estimate - exact));
+      worst = std::max(worst, error / std::max(exact, (int64_t)1000));
+      worst_us = std::max(worst_us, error / 1000.0);
+      CHECK(error <= exact / 32.0 + 1000.0,
+            "%s: p%g is %lldns, exact %lldns", DISTRIBUTION_NAMES[d],
+            PERCENTILES[p], (long long)estimate, (long long)exact);
+    }
+    CHECK(histogram.GetMaxNs() == samples.back(), "%s: max %lld, not %lld",
+          DISTRIBUTION_NAMES[d], (long long)histogram.GetMaxNs(),
+          (long long)samples.back());
+    CHECK(histogram.GetPercentileNs(100.f) == samples.back(),
+          "%s: p100 is not the max", DISTRIBUTION_NAMES[d]);
+    CHECK(histogram.GetCount() == (uint32_t)SAMPLES, "%s: count %u",
+          DISTRIBUTION_NAMES[d], histogram.GetCount());
+    printf("histogram %-18s worst percentile error %.2f%%, %.1fus\n",
+           DISTRIBUTION_NAMES[d], worst * 100.0, worst_us);
+  }
+
+  FrameHistogram histogram;
+  CHECK(histogram.GetPercentileNs(50.f) == 0, "empty histogram p50");
+  histogram.Record(5 * MS);
+  histogram.Reset();
+  CHECK(histogram.GetCount() == 0 && histogram.GetMaxNs() == 0 &&
+            histogram.GetPercentileNs(99.f) == 0,
+        "histogram not empty after Reset()");
+}
+
+void TestMonitor() {
+  // The first Update() has no previous frame: no interval, and an FPS that
+  // is a number
+  PerfMonitor monitor;
+  float fps = -1.f;
+  monitor.Update(fps);
+  CHECK(fps >= 0.f && fps == fps, "first Update() FPS %f", fps);
+  CHECK(monitor.GetLastFrameInterval() == 0, "first frame has an interval");
+  CHECK(monitor.GetHistogram().GetCount() == 0, "first frame recorded");
+  monitor.Update(fps);
+  CHECK(monitor.GetHistogram().GetCount() == 1, "second frame not recorded");
+  CHECK(monitor.GetJankCount() == 0, "a short frame counted as jank");
+}
+
+//--------------------------------------------------------------------------------
+// Trace
+//--------------------------------------------------------------------------------
+struct ExportedEvent {
+  std::string name_;
+  int32_t tid_;
+  double ts_us_;
+  double dur_us_;
+};
+
+// Parses an export, one event per line as ExportChromeJson() writes them
+bool ReadExport(const char* file_name, std::vector<ExportedEvent>* events) {
+  events->clear();
+  FILE* f = fopen(file_name, "r");
+  if (!f) return false;
+  char line[512];
+  bool header = false, footer = false;
+  while (fgets(line, sizeof(line), f)) {
+    if (!strcmp(line, "{\"traceEvents\":[\n")) {
+      header = true;
+      continue;
+    }
+    if (!strcmp(line, "],\"displayTimeUnit\":\"ms\"}\n")) {
+      footer = true;
+      continue;
+    }
+    char name[64];
+    int pid, tid;
+    double ts, dur;
+    if (sscanf(line,
+               "{\"name\":\"%63[^\"]\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":%d,"
+               "\"tid\":%d,\"ts\":%lf,\"dur\":%lf}",
+               name, &pid, &tid, &ts, &dur) != 5) {
+      fclose(f);
+      return false;
+    }
+    ExportedEvent event = {name, tid, ts, dur};
+    events->push_back(event);
+  }
+  fclose(f);
+  return header && footer;
+}
+
+// Zone names and their durations, so that a torn event shows
+const char* ZONE_NAMES[2] = {"even", "odd"};
+const int64_t ZONE_NS[2] = {1000, 2000};
+
+void RecordZones(const int32_t count) {
+  for (int32_t i = 0; i < count; ++i) {
+    const int64_t begin = PerfMonitor::GetCurrentTimeNs();
+    TraceRecorder::Record(ZONE_NAMES[i & 1], begin, begin + ZONE_NS[i & 1]);
+  }
+}
+
+bool Consistent(const ExportedEvent& event) {
+  for (int32_t z = 0; z < 2; ++z)
+    if (event.name_ == ZONE_NAMES[z])
+      return fabs(event.dur_us_ * 1000.0 - ZONE_NS[z]) < 0.5;
+  return event.name_ == "zone" && event.dur_us_ >= 0.0;
+}
+
+void TestTrace(const char* file_name) {
+  std::vector<ExportedEvent> events;
+
+  CHECK(!TraceRecorder::IsEnabled(), "tracing is on by default");
+  { TraceZone zone("zone"); }
+  CHECK(TraceRecorder::ExportChromeJson(file_name), "export failed");
+  CHECK(ReadExport(file_name, &events) && events.empty(),
+        "disabled tracing recorded %d events", (int)events.size());
+
+  TraceRecorder::SetEnabled(true);
+  for (int32_t i = 0; i < 10; ++i) TraceZone zone("zone");
+  CHECK(TraceRecorder::ExportChromeJson(file_name), "export failed");
+  CHECK(ReadExport(file_name, &events) && events.size() == 10,
+        "10 zones, %d exported", (int)events.size());
+  const int32_t main_tid = events.empty() ? 0 : events[0].tid_;
+
+  // Threads writing more than their buffers hold: the most recent events of
+  // each, in order. The oldest slot of a full buffer is never exported, as
+  // its thread could be rewriting it.
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < THREADS; ++t)
+    threads.push_back(std::thread(RecordZones, 10000 + t));
+  for (int32_t t = 0; t < THREADS; ++t) threads[t].join();
+  CHECK(TraceRecorder::ExportChromeJson(file_name), "export failed");
+  CHECK(ReadExport(file_name, &events), "unreadable export");
+  std::map<int32_t, int32_t> per_thread;
+  std::map<int32_t, double> last_ts;
+  for (size_t i = 0; i < events.size(); ++i) {
+    const ExportedEvent& event = events[i];
+    per_thread[event.tid_]++;
+    CHECK(Consistent(event), "event %s of %.3fus", event.name_.c_str(),
+          event.dur_us_);
+    CHECK(event.ts_us_ >= last_ts[event.tid_], "thread %d out of order",
+          event.tid_);
+    last_ts[event.tid_] = event.ts_us_;
+  }
+  CHECK((int32_t)per_thread.size() == THREADS + 1, "%d threads exported",
+        (int)per_thread.size());
+  for (std::map<int32_t, int32_t>::iterator it = per_thread.begin();
+       it != per_thread.end(); ++it) {
+    const int32_t expected =
+        it->first == main_tid ? 10 : ndk_helper::TRACE_BUFFER_EVENTS - 1;
+    CHECK(it->second == expected, "thread %d: %d events, expected %d",
+          it->first, it->second, expected);
+  }
+
+  // Exports racing the writers: events may be dropped, never torn
+  std::atomic<bool> stop(false);
+  threads.clear();
+  for (int32_t t = 0; t < THREADS; ++t)
+    threads.push_back(std::thread([&stop]() {
+      while (!stop.load()) RecordZones(100);
+    }));
+  int32_t exported = 0, torn = 0;
+  for (int32_t e = 0; e < 20; ++e) {
+    CHECK(TraceRecorder::ExportChromeJson(file_name), "export failed");
+    CHECK(ReadExport(file_name, &events), "unreadable export");
+    exported += (int32_t)events.size();
+    for (size_t i = 0; i < events.size(); ++i)
+      if (!Consistent(events[i])) ++torn;
+  }
+  stop.store(true);
+  for (int32_t t = 0; t < THREADS; ++t) threads[t].join();
+  CHECK(torn == 0, "%d torn events", torn);
+  printf("trace: %d events in 20 exports while recording, %d torn\n",
+         exported, torn);
+}
+
+//--------------------------------------------------------------------------------
+// Overhead
+//--------------------------------------------------------------------------------
+void TimeTrace(const char* file_name) {
+  const int32_t zones = 1000000;
+  double ns[2];
+  for (int32_t enabled = 0; enabled < 2; ++enabled) {
+    TraceRecorder::SetEnabled(enabled != 0);
+    const double start = NowNs();
+    for (int32_t i = 0; i < zones; ++i) TraceZone zone("zone");
+    ns[enabled] = (NowNs() - start) / zones;
+  }
+  printf("\nTraceZone: %.1fns disabled, %.1fns enabled\n", ns[0], ns[1]);
+
+  // Every buffer is full by now
+  const double start = NowNs();
+  TraceRecorder::ExportChromeJson(file_name);
+  const double ms = (NowNs() - start) / 1e6;
+  std::vector<ExportedEvent> events;
+  ReadExport(file_name, &events);
+  printf("ExportChromeJson: %d events in %.1fms\n", (int)events.size(), ms);
+  TraceRecorder::SetEnabled(false);
+}
+
+}  // namespace
+
+int main() {
+  char file_name[64];
+  snprintf(file_name, sizeof(file_name), "/tmp/perfMonitorTest.%d.json",
+           (int)getpid());
+
+  TestHistogram();
+  TestMonitor();
+  TestTrace(file_name);
+  TimeTrace(file_name);
+  unlink(file_name);
+
+  printf("\n%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
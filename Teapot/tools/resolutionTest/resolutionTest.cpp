@@ -0,0 +1,433 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// resolutionTest.cpp
+// Host test of the ndk_helper dynamic render resolution
+//
+// ResolutionController is fed simulated frame time traces, the cost made of
+// a fixed part and a fill part that follows the area of the render scale,
+// with noise:
+// - a light load must keep the full size, and short spikes must not move it;
+// - a heavy load must settle on the largest scale that holds the target and
+//   stay there;
+// - a cost that jumps past the target one step up must not bring the
+//   controller back to that size more than once per ceiling period;
+// - frames that miss their vsync must count as too slow even when their
+//   cost is low, pauses must not;
+// - HoldScale() must keep the scale whatever the load.
+//
+// Then GLContext::SetRenderScale() runs on the EGL mock of tools/androidMock.
+// It must keep the surface, the new size showing only after the next swap,
+// and must keep the old scale when the window refuses the buffer size. Last,
+// frame traces drive the controller and the context together as the
+// samples' Engine does, the cost following the size actually rendered.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  gcc -O2 -c -I$MOCK/include -I$NDK_HELPER $NDK_HELPER/gl3stub.c
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER -o resolutionTest
+//  resolutionTest.cpp gl3stub.o $MOCK/androidMock.cpp
+//  $NDK_HELPER/resolutionController.cpp $NDK_HELPER/GLContext.cpp
+//  $NDK_HELPER/eglLoaderBackend.cpp
+//  ./resolutionTest
+//--------------------------------------------------------------------------------
+#include <EGL/egl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "androidMock.h"
+#include "GLContext.h"
+#include "resolutionController.h"
+
+using ndk_helper::GLContext;
+using ndk_helper::ResolutionController;
+
+namespace {
+
+const int64_t TARGET_NS = 1000000000LL / 60;
+const int32_t TRACE_FRAMES = 12000;
+// Frames the controller may take to settle on a heavy load
+const int32_t SETTLE_FRAMES = 1200;
+// Part of the cost the noise may add or take
+const double COST_NOISE = 0.03;
+// As resolutionController.cpp: frames before the scale may go back up to a
+// size it left, and the load it steps down above
+const int32_t CEILING_FRAMES = 600;
+const double HIGH_LOAD = 0.9;
+const int32_t WINDOW_WIDTH = 1280;
+const int32_t WINDOW_HEIGHT = 720;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+uint32_t g_seed = 0x12345678;
+
+uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// Uniform in [-1, 1]
+double RandomUnit() { return Random() / 2147483647.5 - 1.0; }
+
+/******************************************************************
+ * Frame cost model: a fixed part, e.g. the CPU work, and a fill part that
+ * follows the area rendered. Past |cliff_scale| the fill costs
+ * |cliff_factor| times more, as when the frame outgrows a cache.
+ */
+struct Load {
+  double fixed_ms;
+  double fill_ms;  // At the full size
+  double cliff_scale;
+  double cliff_factor;
+  // Every |spike_every| frames, one costs |spike_ms|; 0 for none
+  int32_t spike_every;
+  double spike_ms;
+  // Every |miss_every| frames, one shows after two target frames: its
+  // interval says it missed its vsync, whatever its cost
+  int32_t miss_every;
+};
+
+const Load LIGHT = {4.0, 6.0, 2.0, 1.0, 0, 0.0, 0};
+const Load SPIKES = {4.0, 6.0, 2.0, 1.0, 50, 40.0, 0};
+// 2 + 20 * s^2 ms holds 90% of the target up to a scale of 0.80
+const Load HEAVY = {2.0, 20.0, 2.0, 1.0, 0, 0.0, 0};
+const Load CLIFF = {2.0, 10.0, 0.825, 2.2, 0, 0.0, 0};
+const Load MISSED = {4.0, 6.0, 2.0, 1.0, 0, 0.0, 5};
+
+double ExpectedCostMs(const Load& load, const float scale) {
+  const double fill = load.fill_ms * scale * scale;
+  return load.fixed_ms +
+         (scale > load.cliff_scale ? fill * load.cliff_factor : fill);
+}
+
+int64_t FrameCost(const Load& load, const float scale, const int32_t frame) {
+  double ms = ExpectedCostMs(load, scale) * (1.0 + COST_NOISE * RandomUnit());
+  if (load.spike_every && frame % load.spike_every == 0) ms = load.spike_ms;
+  return (int64_t)(ms * 1e6);
+}
+
+int64_t FrameInterval(const Load& load, const int64_t cost,
+                      const int32_t frame) {
+  if (load.miss_every && frame % load.miss_every == 0) return 2 * TARGET_NS;
+  // A frame within the target shows at the next vsync
+  return cost < TARGET_NS ? TARGET_NS : 2 * TARGET_NS;
+}
+
+struct TraceResult {
+  float final_scale;
+  int32_t changes;
+  int32_t late_changes;  // After SETTLE_FRAMES
+  int32_t changes_over;  // To a scale whose expected cost is over the target
+  int32_t frames_over;
+};
+
+TraceResult RunTrace(ResolutionController* controller, const Load& load) {
+  TraceResult result = {0.f, 0, 0, 0, 0};
+  for (int32_t frame = 0; frame < TRACE_FRAMES; ++frame) {
+    const float scale = controller->GetScale();
+    const int64_t cost = FrameCost(load, scale, frame);
+    if (ExpectedCostMs(load, scale) * 1e6 > TARGET_NS) ++result.frames_over;
+    if (controller->Update(cost, FrameInterval(load, cost, frame))) {
+      ++result.changes;
+      if (frame >= SETTLE_FRAMES) ++result.late_changes;
+      const float new_scale = controller->GetScale();
+      if (ExpectedCostMs(load, new_scale) * 1e6 > TARGET_NS) {
+        ++result.changes_over;
+      }
+    }
+  }
+  result.final_scale = controller->GetScale();
+  return result;
+}
+
+//--------------------------------------------------------------------------------
+// ResolutionController
+//--------------------------------------------------------------------------------
+void TestController() {
+  printf("ResolutionController\n");
+  {
+    ResolutionController controller;
+    const TraceResult r = RunTrace(&controller, LIGHT);
+    CHECK(r.changes == 0 && r.final_scale == 1.f,
+          "light load: %d changes, scale %.2f", r.changes, r.final_scale);
+  }
+  {
+    ResolutionController controller;
+    const TraceResult r = RunTrace(&controller, SPIKES);
+    CHECK(r.changes == 0, "spikes on 2%% of the frames: %d changes",
+          r.changes);
+  }
+  {
+    ResolutionController controller;
+    const TraceResult r = RunTrace(&controller, HEAVY);
+    const float step = ndk_helper::RESOLUTION_SCALE_STEP;
+    // Noise included: the 90th percentile cost is near its top
+    const double high = HIGH_LOAD * TARGET_NS / (1.0 + COST_NOISE);
+    CHECK(ExpectedCostMs(HEAVY, r.final_scale) * 1e6 <= high &&
+              ExpectedCostMs(HEAVY, r.final_scale + step) * 1e6 > high,
+          "heavy load settled on %.2f, not the largest scale that holds "
+          "the target",
+          r.final_scale);
+    CHECK(r.late_changes == 0, "heavy load: %d changes once settled",
+          r.late_changes);
+    printf("  heavy load: %.2f after %d changes\n", r.final_scale,
+           r.changes);
+  }
+  {
+    // The controller may try a size past the cliff again once per ceiling
+    // period
+    ResolutionController controller;
+    const TraceResult r = RunTrace(&controller, CLIFF);
+    const int32_t max_tries = TRACE_FRAMES / CEILING_FRAMES + 1;
+    CHECK(r.changes_over <= max_tries,
+          "cliff: %d changes to a size over the target, at most %d",
+          r.changes_over, max_tries);
+    CHECK(r.frames_over * 10 < TRACE_FRAMES,
+          "cliff: %d of %d frames over the target", r.frames_over,
+          TRACE_FRAMES);
+    printf("  cliff: %d changes, %d to a size over the target, %d frames "
+           "over it\n",
+           r.changes, r.changes_over, r.frames_over);
+  }
+  {
+    ResolutionController controller;
+    const TraceResult r = RunTrace(&controller, MISSED);
+    CHECK(r.final_scale < 1.f,
+          "missed vsyncs on 20%% of the frames did not lower the scale");
+  }
+  {
+    // A pause is no frame: the controller stays
+    ResolutionController controller;
+    bool changed = false;
+    for (int32_t frame = 0; frame < TRACE_FRAMES; ++frame) {
+      const int64_t interval =
+          frame % 5 ? TARGET_NS : 2000000000LL;  // 2 s
+      changed |= controller.Update(TARGET_NS / 2, interval);
+    }
+    CHECK(!changed, "pauses lowered the scale");
+  }
+  {
+    ResolutionController controller;
+    controller.HoldScale(0.9f);
+    CHECK(fabsf(controller.GetScale() - 0.9f) < 1e-6f,
+          "HoldScale(0.9) gave %.2f", controller.GetScale());
+    RunTrace(&controller, HEAVY);
+    CHECK(fabsf(controller.GetScale() - 0.9f) < 1e-6f,
+          "a heavy load moved a held scale to %.2f", controller.GetScale());
+    RunTrace(&controller, LIGHT);
+    CHECK(fabsf(controller.GetScale() - 0.9f) < 1e-6f,
+          "a light load moved a held scale to %.2f", controller.GetScale());
+  }
+}
+
+//--------------------------------------------------------------------------------
+// GLContext::SetRenderScale()
+//--------------------------------------------------------------------------------
+void GetSurfaceSize(int32_t* width, int32_t* height) {
+  const EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  EGLint w = 0;
+  EGLint h = 0;
+  eglQuerySurface(display, eglGetCurrentSurface(EGL_DRAW), EGL_WIDTH, &w);
+  eglQuerySurface(display, eglGetCurrentSurface(EGL_DRAW), EGL_HEIGHT, &h);
+  *width = w;
+  *height = h;
+}
+
+bool HasRenderSize(GLContext* context, const int32_t width,
+                   const int32_t height) {
+  int32_t surface_width;
+  int32_t surface_height;
+  GetSurfaceSize(&surface_width, &surface_height);
+  return context->GetRenderWidth() == width &&
+         context->GetRenderHeight() == height && surface_width == width &&
+         surface_height == height;
+}
+
+void TestSetRenderScale(GLContext* context, ANativeWindow* window) {
+  printf("GLContext::SetRenderScale()\n");
+  const EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+  android_mock::ResetCalls();
+
+  CHECK(context->SetRenderScale(0.5f), "SetRenderScale(0.5) failed");
+  int32_t width;
+  int32_t height;
+  android_mock::GetBuffersSize(window, &width, &height);
+  CHECK(width == WINDOW_WIDTH / 2 && height == WINDOW_HEIGHT / 2,
+        "the window hands out %dx%d buffers at scale 0.5", width, height);
+  CHECK(HasRenderSize(context, WINDOW_WIDTH, WINDOW_HEIGHT),
+        "the frame being drawn changed size before the swap");
+  CHECK(context->Swap() == EGL_SUCCESS, "Swap() failed");
+  CHECK(HasRenderSize(context, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2),
+        "the render size is %dx%d after the swap, not %dx%d",
+        context->GetRenderWidth(), context->GetRenderHeight(),
+        WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+  CHECK(eglGetCurrentSurface(EGL_DRAW) == surface &&
+            android_mock::GetCalls("eglCreateWindowSurface") == 0 &&
+            android_mock::GetCalls("eglDestroySurface") == 0,
+        "the surface was made again");
+
+  // The window refuses smaller buffers: the scale stays
+  android_mock::GetEglDriver().geometry_result_ = -22;  // -EINVAL
+  CHECK(!context->SetRenderScale(0.75f), "SetRenderScale(0.75) succeeded");
+  CHECK(context->GetRenderScale() == 0.5f,
+        "a failed SetRenderScale() left the scale at %.2f",
+        context->GetRenderScale());
+  context->Swap();
+  CHECK(HasRenderSize(context, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2),
+        "a failed SetRenderScale() changed the render size");
+
+  // The window's own size needs no geometry
+  CHECK(context->SetRenderScale(1.f), "SetRenderScale(1) failed");
+  context->Swap();
+  CHECK(HasRenderSize(context, WINDOW_WIDTH, WINDOW_HEIGHT),
+        "the render size is %dx%d back at scale 1",
+        context->GetRenderWidth(), context->GetRenderHeight());
+  android_mock::GetEglDriver().geometry_result_ = 0;
+  CHECK(glGetError() == GL_NO_ERROR, "a GL error is left");
+}
+
+// A scale set while suspended shows when the surface is made again, on the
+// window the activity gets back
+ANativeWindow* TestResume(GLContext* context, ANativeWindow* window) {
+  printf("Suspend() and Resume()\n");
+  context->Suspend();
+  CHECK(context->SetRenderScale(0.5f), "SetRenderScale() while suspended");
+  ANativeWindow* resumed =
+      android_mock::CreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT);
+  CHECK(context->Resume(resumed) == EGL_SUCCESS, "Resume() failed");
+  // The suspended surface stayed current until then
+  android_mock::DestroyWindow(window);
+  CHECK(HasRenderSize(context, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2),
+        "resumed at %dx%d, not at scale 0.5", context->GetRenderWidth(),
+        context->GetRenderHeight());
+  return resumed;
+}
+
+//--------------------------------------------------------------------------------
+// Controller and context together
+//--------------------------------------------------------------------------------
+struct Viewport {
+  int32_t width;
+  int32_t height;
+};
+
+// Frames as the samples' Engine::DrawFrame() runs them. The cost follows the
+// area of the buffer the frame is drawn to.
+void RunFrames(GLContext* context, ResolutionController* controller,
+               const Load& load, Viewport* viewport, int32_t* mismatches) {
+  for (int32_t frame = 0; frame < TRACE_FRAMES; ++frame) {
+    int32_t width;
+    int32_t height;
+    GetSurfaceSize(&width, &height);
+    if (viewport->width != width || viewport->height != height) {
+      ++*mismatches;
+    }
+    const float scale = sqrtf((float)width * height /
+                              ((float)WINDOW_WIDTH * WINDOW_HEIGHT));
+    const int64_t cost = FrameCost(load, scale, frame);
+    context->Swap();
+    if (controller->Update(cost, FrameInterval(load, cost, frame)) &&
+        !context->SetRenderScale(controller->GetScale())) {
+      controller->HoldScale(context->GetRenderScale());
+    }
+    if (context->GetRenderWidth() != viewport->width ||
+        context->GetRenderHeight() != viewport->height) {
+      viewport->width = context->GetRenderWidth();
+      viewport->height = context->GetRenderHeight();
+    }
+  }
+}
+
+void TestEngineLoop(GLContext* context) {
+  printf("Engine loop\n");
+  Viewport viewport = {context->GetRenderWidth(), context->GetRenderHeight()};
+  int32_t mismatches = 0;
+  android_mock::ResetCalls();
+  {
+    ResolutionController controller;
+    RunFrames(context, &controller, HEAVY, &viewport, &mismatches);
+    CHECK(context->GetRenderScale() == controller.GetScale(),
+          "the context is at %.2f, the controller at %.2f",
+          context->GetRenderScale(), controller.GetScale());
+    const float step = ndk_helper::RESOLUTION_SCALE_STEP;
+    CHECK(context->GetRenderScale() <= 1.f - 3 * step,
+          "a heavy load left the scale at %.2f", context->GetRenderScale());
+    CHECK(android_mock::GetCalls("eglCreateWindowSurface") == 0,
+          "scale changes made the surface again");
+    printf("  heavy load: %.2f, %dx%d\n", context->GetRenderScale(),
+           context->GetRenderWidth(), context->GetRenderHeight());
+  }
+  CHECK(mismatches == 0, "%d frames drawn with a viewport off the surface",
+        mismatches);
+
+  // A window that takes no other buffer size: one try, then the controller
+  // holds the full size
+  context->SetRenderScale(1.f);
+  context->Swap();
+  viewport.width = context->GetRenderWidth();
+  viewport.height = context->GetRenderHeight();
+  android_mock::GetEglDriver().geometry_result_ = -22;  // -EINVAL
+  android_mock::ResetCalls();
+  {
+    ResolutionController controller;
+    RunFrames(context, &controller, HEAVY, &viewport, &mismatches);
+    const int32_t tries =
+        android_mock::GetCalls("ANativeWindow_setBuffersGeometry");
+    CHECK(tries == 1, "%d tries at a geometry the window refuses", tries);
+    CHECK(controller.GetScale() == 1.f && context->GetRenderScale() == 1.f &&
+              HasRenderSize(context, WINDOW_WIDTH, WINDOW_HEIGHT),
+          "the controller did not hold the full size");
+  }
+  android_mock::GetEglDriver().geometry_result_ = 0;
+  CHECK(mismatches == 0, "%d frames drawn with a viewport off the surface",
+        mismatches);
+  CHECK(glGetError() == GL_NO_ERROR, "a GL error is left");
+}
+
+}  // namespace
+
+int main() {
+  TestController();
+
+  ANativeWindow* window =
+      android_mock::CreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT);
+  GLContext* context = GLContext::GetInstance();
+  CHECK(context->Init(window), "GLContext::Init() failed");
+  TestSetRenderScale(context, window);
+  TestEngineLoop(context);
+  window = TestResume(context, window);
+  context->Invalidate();
+  CHECK(android_mock::GetLiveEglObjects() == 0, "EGL objects leaked");
+  android_mock::DestroyWindow(window);
+
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// resourceLoaderTest.cpp
+// Host test of ResourceLoader on the shared loader context of GLContext
+//
+// GLContext::CreateLoaderBackend() runs on the EGL mock of tools/androidMock,
+// with the window config making pbuffers and, in a second run, without. The
+// loader context must be another context than the GL thread's, current on
+// the loader thread only. Every load must run there with a context current,
+// and make buffers the GL thread then sees.
+//
+// With EGL_KHR_fence_sync, each load must end with a fence. Update() must
+// commit nothing past a fence the GPU has not signaled, and must commit in
+// submission order. Finish() must wait on the fences. Without the extension,
+// each load must end with glFinish() instead, and Update() must commit as
+// soon as a task is loaded. Destroying the loader, with tasks still queued,
+// must leave no fence and no EGL object of its own behind.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  gcc -O2 -c -I$MOCK/include -I$NDK_HELPER $NDK_HELPER/gl3stub.c
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER
+//  -o resourceLoaderTest resourceLoaderTest.cpp gl3stub.o
+//  $MOCK/androidMock.cpp $NDK_HELPER/resourceLoader.cpp
+//  $NDK_HELPER/GLContext.cpp $NDK_HELPER/eglLoaderBackend.cpp
+//  ./resourceLoaderTest
+//--------------------------------------------------------------------------------
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "androidMock.h"
+#include "GLContext.h"
+#include "resourceLoader.h"
+
+using ndk_helper::GLContext;
+using ndk_helper::ResourceLoader;
+
+namespace {
+
+const int32_t TASKS = 16;
+const int32_t BUFFER_SIZE = 256;
+// Polls for the loader thread, 1 ms apart
+const int32_t MAX_POLLS = 5000;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+pthread_t g_gl_thread;
+EGLContext g_gl_context;
+std::vector<int32_t> g_commits;
+
+struct Task {
+  int32_t index;
+  GLuint buffer;
+  bool on_gl_thread;
+  bool context_current;
+  bool shared;  // Current context is not the GL thread's
+  bool committed;
+};
+
+bool LoadBuffer(void* data) {
+  Task* task = static_cast<Task*>(data);
+  task->on_gl_thread = pthread_equal(pthread_self(), g_gl_thread) != 0;
+  const EGLContext context = eglGetCurrentContext();
+  task->context_current = context != EGL_NO_CONTEXT;
+  task->shared = context != g_gl_context;
+  const std::vector<uint8_t> data_bytes(BUFFER_SIZE, (uint8_t)task->index);
+  glGenBuffers(1, &task->buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, task->buffer);
+  glBufferData(GL_ARRAY_BUFFER, BUFFER_SIZE, &data_bytes[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void CommitBuffer(void* data, const bool succeeded) {
+  Task* task = static_cast<Task*>(data);
+  CHECK(pthread_equal(pthread_self(), g_gl_thread) && succeeded,
+        "task %d committed off the GL thread or failed", task->index);
+  task->committed = true;
+  g_commits.push_back(task->index);
+}
+
+void InitTasks(std::vector<Task>* tasks) {
+  tasks->assign(TASKS, Task());
+  for (int32_t i = 0; i < TASKS; ++i) (*tasks)[i].index = i;
+  g_commits.clear();
+}
+
+// Waits for the loader thread to have made |count| calls of |function|
+bool WaitCalls(const char* function, const int32_t count) {
+  for (int32_t i = 0; i < MAX_POLLS; ++i) {
+    if (android_mock::GetCalls(function) >= count) return true;
+    usleep(1000);
+  }
+  return false;
+}
+
+void CheckTasks(const std::vector<Task>& tasks) {
+  bool in_order = (int32_t)g_commits.size() == TASKS;
+  for (int32_t i = 0; in_order && i < TASKS; ++i)
+    in_order = g_commits[i] == i;
+  CHECK(in_order, "%d commits, not in submission order",
+        (int32_t)g_commits.size());
+  for (int32_t i = 0; i < TASKS; ++i) {
+    const Task& task = tasks[i];
+    CHECK(!task.on_gl_thread && task.context_current && task.shared,
+          "task %d loaded on the GL thread or without the loader context",
+          i);
+    const std::vector<uint8_t>* data = android_mock::GetBufferData(task.buffer);
+    CHECK(data && data->size() == (size_t)BUFFER_SIZE &&
+              (*data)[0] == (uint8_t)i,
+          "task %d: its buffer is not there", i);
+  }
+}
+
+void DeleteBuffers(const std::vector<Task>& tasks) {
+  for (size_t i = 0; i < tasks.size(); ++i)
+    if (tasks[i].buffer) glDeleteBuffers(1, &tasks[i].buffer);
+}
+
+//--------------------------------------------------------------------------------
+// With fences
+//--------------------------------------------------------------------------------
+void TestFences(GLContext* context) {
+  std::vector<Task> tasks;
+  InitTasks(&tasks);
+  android_mock::ResetCalls();
+  {
+    ResourceLoader loader(context->CreateLoaderBackend());
+    CHECK(loader.IsAsync(), "the loader has no thread");
+    for (int32_t i = 0; i < TASKS; ++i)
+      loader.Submit(LoadBuffer, CommitBuffer, &tasks[i]);
+    CHECK(WaitCalls("eglCreateSyncKHR", TASKS),
+          "%d fences made for %d tasks",
+          android_mock::GetCalls("eglCreateSyncKHR"), TASKS);
+    CHECK(android_mock::GetCalls("glFinish") == 0, "the loader finished");
+
+    // The GPU has done nothing yet
+    CHECK(loader.Update() == 0 && g_commits.empty(),
+          "committed past an unsignaled fence");
+    android_mock::SignalFences(TASKS / 2);
+    const int32_t committed = loader.Update();
+    CHECK(committed == TASKS / 2, "%d committed with %d fences signaled",
+          committed, TASKS / 2);
+    android_mock::SignalFences(0);
+    loader.Update();
+    CHECK(loader.GetPendingCount() == 0, "%d tasks left",
+          loader.GetPendingCount());
+    CheckTasks(tasks);
+    CHECK(android_mock::GetLiveFences() == 0, "%d fences left",
+          android_mock::GetLiveFences());
+
+    // Finish() waits on the fences
+    std::vector<Task> more;
+    InitTasks(&more);
+    for (int32_t i = 0; i < TASKS; ++i)
+      loader.Submit(LoadBuffer, CommitBuffer, &more[i]);
+    const int32_t waits = android_mock::GetFenceWaits();
+    loader.Finish();
+    CHECK(loader.GetPendingCount() == 0 &&
+              android_mock::GetFenceWaits() > waits,
+          "Finish() left %d tasks, or did not wait on the fences",
+          loader.GetPendingCount());
+    CheckTasks(more);
+    CHECK(android_mock::GetLiveFences() == 0, "%d fences left",
+          android_mock::GetLiveFences());
+    DeleteBuffers(more);
+  }
+  DeleteBuffers(tasks);
+}
+
+//--------------------------------------------------------------------------------
+// Without fences
+//--------------------------------------------------------------------------------
+void TestNoFences(GLContext* context) {
+  android_mock::GetEglDriver().fence_sync_ = false;
+  std::vector<Task> tasks;
+  InitTasks(&tasks);
+  android_mock::ResetCalls();
+  {
+    ResourceLoader loader(context->CreateLoaderBackend());
+    for (int32_t i = 0; i < TASKS; ++i)
+      loader.Submit(LoadBuffer, CommitBuffer, &tasks[i]);
+    CHECK(WaitCalls("glFinish", TASKS), "%d glFinish() for %d tasks",
+          android_mock::GetCalls("glFinish"), TASKS);
+    // Loaded tasks are complete: no GPU progress is needed
+    for (int32_t i = 0; i < MAX_POLLS && loader.GetPendingCount(); ++i) {
+      loader.Update();
+      usleep(1000);
+    }
+    CHECK(loader.GetPendingCount() == 0, "%d tasks left",
+          loader.GetPendingCount());
+    CHECK(android_mock::GetCalls("eglCreateSyncKHR") == 0,
+          "fences made without EGL_KHR_fence_sync");
+    CheckTasks(tasks);
+  }
+  DeleteBuffers(tasks);
+  android_mock::GetEglDriver().fence_sync_ = true;
+}
+
+//--------------------------------------------------------------------------------
+// Teardown
+//--------------------------------------------------------------------------------
+void TestDestroy(GLContext* context) {
+  std::vector<Task> tasks;
+  InitTasks(&tasks);
+  const int32_t egl_objects = android_mock::GetLiveEglObjects();
+  {
+    ResourceLoader loader(context->CreateLoaderBackend());
+    CHECK(android_mock::GetLiveEglObjects() == egl_objects + 2,
+          "the loader made %d EGL objects, not a context and a pbuffer",
+          android_mock::GetLiveEglObjects() - egl_objects);
+    for (int32_t i = 0; i < TASKS; ++i)
+      loader.Submit(LoadBuffer, CommitBuffer, &tasks[i]);
+    WaitCalls("eglCreateSyncKHR", 1);
+  }
+  CHECK(android_mock::GetLiveEglObjects() == egl_objects,
+        "%d EGL objects left by the loader",
+        android_mock::GetLiveEglObjects() - egl_objects);
+  CHECK(android_mock::GetLiveFences() == 0, "%d fences left",
+        android_mock::GetLiveFences());
+  // The loads that ran left their buffers to their owner
+  DeleteBuffers(tasks);
+}
+
+void TestLoader(const bool window_pbuffer) {
+  printf("Loader context, %s\n",
+         window_pbuffer ? "window config" : "pbuffer config");
+  android_mock::ResetGl();
+  android_mock::ResetEgl();
+  android_mock::GetEglDriver().window_pbuffer_ = window_pbuffer;
+  ANativeWindow* window = android_mock::CreateWindow(320, 240);
+  GLContext* context = GLContext::GetInstance();
+  CHECK(context->Init(window), "GLContext::Init() failed");
+  g_gl_thread = pthread_self();
+  g_gl_context = eglGetCurrentContext();
+
+  TestFences(context);
+  TestNoFences(context);
+  TestDestroy(context);
+
+  CHECK(eglGetCurrentContext() == g_gl_context,
+        "the GL thread lost its context");
+  CHECK(android_mock::GetLiveObjects() == 0, "%d GL objects leaked",
+        android_mock::GetLiveObjects());
+  CHECK(android_mock::GetCalls(android_mock::MOCK_NO_CONTEXT) == 0,
+        "GL called with no context");
+  CHECK(glGetError() == GL_NO_ERROR, "a GL error is left");
+  context->Invalidate();
+  CHECK(android_mock::GetLiveEglObjects() == 0, "EGL objects leaked");
+  android_mock::DestroyWindow(window);
+}
+
+}  // namespace
+
+int main() {
+  TestLoader(true);
+  TestLoader(false);
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
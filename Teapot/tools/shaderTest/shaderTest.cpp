@@ -0,0 +1,450 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// shaderTest.cpp
+// Host test of the shader preprocessor and the program binary cache
+//
+// PreprocessShader() must expand %KEY% parameters in one pass and splice
+// #include files resolved against the including file, and fail on missing
+// files, cycles and too deep nesting. MakeProgramCacheKey() must change with
+// any program input or the driver.
+//
+// shader::CreateProgram() and ProgramCache run unchanged against the GL mock
+// of tools/androidMock: a second build of a program must load the stored
+// binary without compiling, any change of a define, an included file, an
+// attribute binding or the driver must miss the cache, and a binary the
+// driver rejects or a damaged file must be deleted and rebuilt from source.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  g++ -O2 -I$MOCK/include -I$MOCK -I$NDK_HELPER -o shaderTest shaderTest.cpp
+//  $MOCK/androidMock.cpp $NDK_HELPER/shader.cpp
+//  $NDK_HELPER/shaderPreprocessor.cpp $NDK_HELPER/assetCache.cpp -lpthread
+//  ./shaderTest
+//--------------------------------------------------------------------------------
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "androidMock.h"
+#include "assetCache.h"
+#include "shader.h"
+
+using ndk_helper::AssetCache;
+using ndk_helper::shader::MakeProgramCacheKey;
+using ndk_helper::shader::PreprocessShader;
+using ndk_helper::shader::ProgramCache;
+
+namespace {
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+typedef std::map<std::string, std::string> Parameters;
+
+//--------------------------------------------------------------------------------
+// Preprocessor, on in memory files
+//--------------------------------------------------------------------------------
+std::map<std::string, std::string> g_files;
+
+bool LoadFile(const char* file_name, std::vector<uint8_t>* data) {
+  std::map<std::string, std::string>::const_iterator it =
+      g_files.find(file_name);
+  if (it == g_files.end()) return false;
+  data->assign(it->second.begin(), it->second.end());
+  return true;
+}
+
+bool Expand(const char* file_name, const Parameters& parameters,
+            std::string* out) {
+  const std::string& source = g_files[file_name];
+  return PreprocessShader(file_name, source.data(), (int32_t)source.size(),
+                          parameters, LoadFile, out);
+}
+
+void ExpectExpansion(const char* label, const char* file_name,
+                     const Parameters& parameters, const char* expected) {
+  std::string out;
+  const bool ok = Expand(file_name, parameters, &out);
+  CHECK(ok && out == expected, "%s: got %s\"%s\"", label,
+        ok ? "" : "failure, ", out.c_str());
+}
+
+void ExpectFailure(const char* label, const char* file_name) {
+  std::string out;
+  CHECK(!Expand(file_name, Parameters(), &out), "%s: did not fail", label);
+}
+
+void TestParameters() {
+  Parameters parameters;
+  parameters["%LOCATION%"] = "3";
+  parameters["%PRECISION%"] = "highp";
+  parameters["%SELF%"] = "%LOCATION%";
+
+  g_files["a.vsh"] = "layout(location=%LOCATION%) in %PRECISION% vec3 v;\n";
+  ExpectExpansion("parameters", "a.vsh", parameters,
+                  "layout(location=3) in highp vec3 v;\n");
+
+  // Values are never scanned again
+  g_files["a.vsh"] = "%SELF%%LOCATION%";
+  ExpectExpansion("no rescan", "a.vsh", parameters, "%LOCATION%3");
+
+  // Unknown keys and lone % signs stay as they are; a % that closes an
+  // unknown key can still open a known one
+  g_files["a.vsh"] = "%UNKNOWN% a % b %%LOCATION% 100%\n%LOCATION%\n";
+  ExpectExpansion("unknown keys", "a.vsh", parameters,
+                  "%UNKNOWN% a % b %3 100%\n3\n");
+
+  // A key never spans lines
+  g_files["a.vsh"] = "%LOCA\nTION%";
+  ExpectExpansion("key across lines", "a.vsh", parameters, "%LOCA\nTION%");
+
+  g_files["a.vsh"] = "";
+  ExpectExpansion("empty source", "a.vsh", parameters, "");
+}
+
+void TestIncludes() {
+  Parameters parameters;
+  parameters["%COLOR%"] = "vec3(1.0)";
+
+  // Relative to the including file, nested, and from the asset root
+  g_files["Shaders/main.fsh"] =
+      "precision mediump float;\n"
+      "  #  include \"lib/light.glsl\"  // spaces and a comment\n"
+      "void main() { gl_FragColor = vec4(Light(%COLOR%), 1.0); }\n";
+  g_files["Shaders/lib/light.glsl"] =
+      "#include <common.glsl>\n"
+      "vec3 Light(vec3 c) { return c * %COLOR%; }";
+  g_files["Shaders/lib/common.glsl"] = "#include \"/Shaders/constants.glsl\"\n";
+  g_files["Shaders/constants.glsl"] = "const float PI = 3.14159;\n";
+  ExpectExpansion("nested includes", "Shaders/main.fsh", parameters,
+                  "precision mediump float;\n"
+                  "const float PI = 3.14159;\n"
+                  "vec3 Light(vec3 c) { return c * vec3(1.0); }\n"
+                  "void main() { gl_FragColor = vec4(Light(vec3(1.0)), 1.0); "
+                  "}\n");
+
+  // Only a directive at the start of a line includes; an empty file adds
+  // nothing
+  g_files["Shaders/empty.glsl"] = "";
+  g_files["Shaders/text.fsh"] =
+      "// see #include \"missing.glsl\"\n#include \"empty.glsl\"\n"
+      "#define X 1\n#include";
+  ExpectExpansion("directives", "Shaders/text.fsh", Parameters(),
+                  "// see #include \"missing.glsl\"\n#define X 1\n#include");
+
+  g_files["Shaders/missing.fsh"] = "#include \"missing.glsl\"\n";
+  ExpectFailure("missing include", "Shaders/missing.fsh");
+
+  g_files["Shaders/cycle.fsh"] = "#include \"cycle.fsh\"\n";
+  ExpectFailure("include cycle", "Shaders/cycle.fsh");
+
+  // MAX_INCLUDE_DEPTH nested files are fine, one more is not
+  char name[32], next[32];
+  const int32_t depth = ndk_helper::shader::MAX_INCLUDE_DEPTH;
+  for (int32_t i = 0; i <= depth + 1; ++i) {
+    snprintf(name, sizeof(name), "deep%d.glsl", i);
+    snprintf(next, sizeof(next), "#include \"deep%d.glsl\"\n", i + 1);
+    g_files[name] = i == depth + 1 ? "x\n" : next;
+  }
+  std::string out;
+  snprintf(name, sizeof(name), "deep%d.glsl", 1);
+  CHECK(Expand(name, Parameters(), &out) && out == "x\n",
+        "%d nested includes failed", depth);
+  ExpectFailure("too deep includes", "deep0.glsl");
+
+  const std::string& source = g_files["Shaders/main.fsh"];
+  CHECK(!PreprocessShader("Shaders/main.fsh", source.data(),
+                          (int32_t)source.size(), parameters, NULL, &out),
+        "include without a loader did not fail");
+}
+
+void TestCacheKey() {
+  std::vector<std::string> sources;
+  sources.push_back("vertex");
+  sources.push_back("fragment");
+  sources.push_back("myVertex=0");
+  const std::string driver = "vendor\nrenderer\nversion";
+  const std::string key = MakeProgramCacheKey(sources, driver);
+
+  CHECK(key.size() == 16 && key.find_first_not_of("0123456789abcdef") ==
+                                std::string::npos,
+        "key %s is not 16 hex digits", key.c_str());
+  CHECK(MakeProgramCacheKey(sources, driver) == key, "key not stable");
+
+  std::set<std::string> keys;
+  keys.insert(key);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    std::vector<std::string> changed = sources;
+    changed[i] += " ";
+    keys.insert(MakeProgramCacheKey(changed, driver));
+  }
+  // Text moved from one part to the next
+  std::vector<std::string> moved = sources;
+  moved[0] += "f";
+  moved[1] = moved[1].substr(1);
+  keys.insert(MakeProgramCacheKey(moved, driver));
+  keys.insert(MakeProgramCacheKey(sources, driver + "2"));
+  std::vector<std::string> more = sources;
+  more.push_back("");
+  keys.insert(MakeProgramCacheKey(more, driver));
+  CHECK(keys.size() == sources.size() + 4, "%d distinct keys of %d",
+        (int)keys.size(), (int)sources.size() + 4);
+}
+
+//--------------------------------------------------------------------------------
+// Program cache, through the GL mock
+//--------------------------------------------------------------------------------
+std::string g_asset_dir;
+std::string g_cache_dir;
+
+void WriteFile(const std::string& file_name, const std::string& contents) {
+  FILE* f = fopen(file_name.c_str(), "wb");
+  fwrite(contents.data(), 1, contents.size(), f);
+  fclose(f);
+}
+
+std::vector<std::string> ListCache() {
+  std::vector<std::string> files;
+  DIR* dir = opendir(g_cache_dir.c_str());
+  if (dir == NULL) return files;
+  while (dirent* entry = readdir(dir))
+    if (entry->d_name[0] != '.') files.push_back(entry->d_name);
+  closedir(dir);
+  return files;
+}
+
+void ClearCache() {
+  std::vector<std::string> files = ListCache();
+  for (size_t i = 0; i < files.size(); ++i)
+    unlink((g_cache_dir + "/" + files[i]).c_str());
+}
+
+struct Build {
+  bool ok;
+  GLuint program;
+  int32_t compiles;
+  int32_t loads;
+};
+
+Build BuildProgram(const Parameters& parameters,
+                   const std::map<std::string, GLuint>& attributes) {
+  // Shader sources are cached views; drop them so edits are seen
+  AssetCache::GetInstance()->Trim();
+  android_mock::ResetCalls();
+  Build build;
+  build.program = 0;
+  build.ok = ndk_helper::shader::CreateProgram(
+      &build.program, "Shaders/VS.vsh", "Shaders/PS.fsh", parameters,
+      attributes);
+  build.compiles = android_mock::GetCalls("glCompileShader");
+  build.loads = android_mock::GetCalls("glProgramBinary");
+  return build;
+}
+
+void TestProgramCache() {
+  android_mock::ResetGl();
+  android_mock::SetAssetDir(g_asset_dir.c_str());
+  AssetCache::GetInstance()->Init(NULL, g_asset_dir.c_str());
+  mkdir((g_asset_dir + "/Shaders").c_str(), 0700);
+  WriteFile(g_asset_dir + "/Shaders/VS.vsh",
+            "attribute vec3 myVertex;\n#include \"Transform.glsl\"\n"
+            "void main() { gl_Position = Transform(myVertex); }\n");
+  WriteFile(g_asset_dir + "/Shaders/Transform.glsl",
+            "uniform mat4 uMVP;\n"
+            "vec4 Transform(vec3 v) { return uMVP * vec4(v, 1.0); }\n");
+  WriteFile(g_asset_dir + "/Shaders/PS.fsh",
+            "void main() { gl_FragColor = vec4(%COLOR%); }\n");
+
+  Parameters parameters;
+  parameters["%COLOR%"] = "1.0";
+  std::map<std::string, GLuint> attributes;
+  attributes["myVertex"] = 0;
+
+  ProgramCache* cache = ProgramCache::GetInstance();
+  cache->Init(g_cache_dir.substr(0, g_cache_dir.rfind('/')).c_str());
+  CHECK(cache->IsEnabled(), "cache disabled on an ES3 driver");
+
+  const int32_t objects = android_mock::GetLiveObjects();
+  Build first = BuildProgram(parameters, attributes);
+  CHECK(first.ok && first.compiles == 2 && first.loads == 0,
+        "first build: ok %d, %d compiles, %d loads", first.ok, first.compiles,
+        first.loads);
+  CHECK(android_mock::GetLiveObjects() == objects + 1,
+        "shaders left behind after a build");
+  std::vector<std::string> files = ListCache();
+  CHECK(files.size() == 1 && files[0].size() == 16 + 4 &&
+            files[0].compare(16, 4, ".bin") == 0,
+        "cache holds %d files after the first build", (int)files.size());
+  CHECK(android_mock::GetCalls("glProgramParameteri") == 1,
+        "no retrievable hint on ES3");
+
+  Build second = BuildProgram(parameters, attributes);
+  CHECK(second.ok && second.compiles == 0 && second.loads == 1,
+        "second build: ok %d, %d compiles, %d loads", second.ok,
+        second.compiles, second.loads);
+  CHECK(android_mock::GetProgramBinary(second.program) ==
+            android_mock::GetProgramBinary(first.program),
+        "cached program differs from the compiled one");
+
+  // Every input of the program misses the cache
+  parameters["%COLOR%"] = "0.5";
+  Build define = BuildProgram(parameters, attributes);
+  CHECK(define.ok && define.compiles == 2, "changed define: %d compiles",
+        define.compiles);
+
+  WriteFile(g_asset_dir + "/Shaders/Transform.glsl",
+            "uniform mat4 uMVP;\n"
+            "vec4 Transform(vec3 v) { return uMVP * vec4(v, 2.0); }\n");
+  Build include = BuildProgram(parameters, attributes);
+  CHECK(include.ok && include.compiles == 2,
+        "changed include: %d compiles", include.compiles);
+
+  attributes["myVertex"] = 1;
+  Build binding = BuildProgram(parameters, attributes);
+  CHECK(binding.ok && binding.compiles == 2,
+        "changed binding: %d compiles", binding.compiles);
+  CHECK(ListCache().size() == 4, "%d cached programs, expected 4",
+        (int)ListCache().size());
+
+  android_mock::GetGlDriver().renderer_ = "androidMock GL 2";
+  cache->Init(g_cache_dir.substr(0, g_cache_dir.rfind('/')).c_str());
+  Build driver = BuildProgram(parameters, attributes);
+  CHECK(driver.ok && driver.compiles == 2 && driver.loads == 0,
+        "changed driver: %d compiles, %d loads", driver.compiles,
+        driver.loads);
+  Build again = BuildProgram(parameters, attributes);
+  CHECK(again.ok && again.compiles == 0, "new driver: %d compiles",
+        again.compiles);
+
+  // A binary the driver turns down is deleted, the program rebuilt and
+  // stored again
+  android_mock::GetGlDriver().accept_binaries_ = false;
+  const size_t stored = ListCache().size();
+  Build rejected = BuildProgram(parameters, attributes);
+  CHECK(rejected.ok && rejected.loads == 1 && rejected.compiles == 2,
+        "rejected binary: ok %d, %d loads, %d compiles", rejected.ok,
+        rejected.loads, rejected.compiles);
+  CHECK(!android_mock::GetProgramBinary(rejected.program).empty(),
+        "rebuilt program not linked");
+  CHECK(ListCache().size() == stored, "rejected binary not replaced");
+  android_mock::GetGlDriver().accept_binaries_ = true;
+
+  // Damaged files: cut short, and a foreign header
+  for (int32_t damage = 0; damage < 2; ++damage) {
+    ClearCache();
+    BuildProgram(parameters, attributes);
+    files = ListCache();
+    CHECK(files.size() == 1, "damage %d: %d files stored", damage,
+          (int)files.size());
+    if (files.size() != 1) break;
+    const std::string file_name = g_cache_dir + "/" + files[0];
+    if (damage == 0) {
+      CHECK(truncate(file_name.c_str(), 10) == 0, "truncate failed");
+    } else {
+      FILE* f = fopen(file_name.c_str(), "r+b");
+      fputc('X', f);
+      fclose(f);
+    }
+    Build build = BuildProgram(parameters, attributes);
+    CHECK(build.ok && build.compiles == 2 && build.loads == 0,
+          "damage %d: ok %d, %d compiles, %d loads", damage, build.ok,
+          build.compiles, build.loads);
+    CHECK(ListCache().size() == 1, "damage %d: %d files kept", damage,
+          (int)ListCache().size());
+    build = BuildProgram(parameters, attributes);
+    CHECK(build.compiles == 0, "damage %d: rebuilt program not stored", damage);
+  }
+
+  // A failing compile stores nothing and leaks nothing
+  ClearCache();
+  WriteFile(g_asset_dir + "/Shaders/PS.fsh",
+            std::string("void main() { ") + android_mock::MOCK_COMPILE_ERROR +
+                " }\n");
+  const int32_t live = android_mock::GetLiveObjects();
+  Build broken = BuildProgram(parameters, attributes);
+  CHECK(!broken.ok, "broken shader built");
+  CHECK(android_mock::GetLiveObjects() == live,
+        "failed build leaked %d objects", android_mock::GetLiveObjects() - live);
+  CHECK(ListCache().empty(), "failed build stored a program");
+  WriteFile(g_asset_dir + "/Shaders/PS.fsh",
+            "void main() { gl_FragColor = vec4(%COLOR%); }\n");
+
+  // No cache without program binaries; the OES extension on ES2
+  const char* data_path = "/nonexistent";
+  android_mock::GetGlDriver().binary_formats_ = 0;
+  cache->Init(data_path);
+  CHECK(!cache->IsEnabled(), "cache enabled without binary formats");
+  android_mock::GetGlDriver().binary_formats_ = 1;
+  android_mock::GetGlDriver().version_ = "OpenGL ES 2.0 androidMock";
+  android_mock::GetGlDriver().extensions_ = "";
+  cache->Init(data_path);
+  CHECK(!cache->IsEnabled(), "cache enabled on ES2 without the extension");
+  Build uncached = BuildProgram(parameters, attributes);
+  CHECK(uncached.ok && uncached.compiles == 2 && uncached.loads == 0,
+        "uncached build: ok %d, %d compiles", uncached.ok, uncached.compiles);
+
+  android_mock::GetGlDriver().extensions_ = "GL_OES_get_program_binary";
+  cache->Init(g_cache_dir.substr(0, g_cache_dir.rfind('/')).c_str());
+  CHECK(cache->IsEnabled(), "cache disabled on ES2 with the extension");
+  BuildProgram(parameters, attributes);
+  Build oes = BuildProgram(parameters, attributes);
+  CHECK(oes.ok && oes.compiles == 0 && oes.loads == 1,
+        "ES2 cached build: %d compiles, %d loads", oes.compiles, oes.loads);
+  CHECK(android_mock::GetCalls("glProgramParameteri") == 0,
+        "retrievable hint used on ES2");
+  cache->Init(NULL);
+}
+
+}  // namespace
+
+int main() {
+  char dir[] = "/tmp/shaderTest.XXXXXX";
+  if (!mkdtemp(dir)) return 1;
+  g_asset_dir = std::string(dir) + "/assets";
+  g_cache_dir = std::string(dir) + "/data/program_cache";
+  mkdir(g_asset_dir.c_str(), 0700);
+  mkdir((std::string(dir) + "/data").c_str(), 0700);
+
+  TestParameters();
+  TestIncludes();
+  TestCacheKey();
+  TestProgramCache();
+
+  const std::string command = std::string("rm -rf ") + dir;
+  if (system(command.c_str())) printf("Could not remove %s\n", dir);
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
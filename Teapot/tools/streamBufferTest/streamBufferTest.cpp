@@ -0,0 +1,391 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// streamBufferTest.cpp
+// Host test of the ndk_helper RingAllocator and StreamBuffer
+//
+// 200 random runs of 2000 frames each drive a RingAllocator with random
+// buffer sizes, alignments, allocations, shrinks and retirements. Every
+// range must be aligned, inside the buffer and apart from every range still
+// in use. Fences must come back oldest first, and once all frames are
+// retired no byte may stay in use.
+//
+// Then rings sized as StreamBuffer::Init() sizes them are run with the GPU
+// |frames| - 1 frames behind. No Allocate() may fail, so Map() never waits.
+// Without the spare frame StreamBuffer adds, the same runs do fail.
+//
+// Last, StreamBuffer runs on the GL mock of tools/androidMock. The GPU
+// keeps STREAM_BUFFER_FRAMES - 1 frames, then more. Map() must wait only
+// when it has to, and must never hand out bytes of a frame the GPU still
+// reads. Those bytes must keep what was written. A hung GPU must make Map()
+// fail rather than block. Release() must delete the buffer and every fence.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  gcc -O2 -c -I$MOCK/include -I$NDK_HELPER $NDK_HELPER/gl3stub.c
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER -o streamBufferTest
+//  streamBufferTest.cpp gl3stub.o $MOCK/androidMock.cpp
+//  $NDK_HELPER/ringAllocator.cpp $NDK_HELPER/streamBuffer.cpp
+//  ./streamBufferTest
+//--------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <vector>
+
+#include "androidMock.h"
+#include "gl3stub.h"
+#include "ringAllocator.h"
+#include "streamBuffer.h"
+
+using ndk_helper::RingAllocator;
+using ndk_helper::StreamBuffer;
+using ndk_helper::RING_ALLOCATION_FAILED;
+using ndk_helper::STREAM_BUFFER_FRAMES;
+
+namespace {
+
+const int32_t RANDOM_RUNS = 200;
+const int32_t RUN_FRAMES = 2000;
+const size_t ALIGNMENTS[] = {1, 4, 16, 64, 256};
+const int32_t NUM_ALIGNMENTS = sizeof(ALIGNMENTS) / sizeof(ALIGNMENTS[0]);
+const size_t MAX_RING_SIZE = 100000;
+// Frames StreamBuffer rings are tried with, and the GPU's lag
+const int32_t MAX_FRAMES = 5;
+// StreamBuffer frames, as the MoreTeapots instance records at most
+const size_t STREAM_FRAME_SIZE = 4096 * 28 * sizeof(float);
+const size_t STREAM_ALIGNMENT = 16;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("  FAILED: ");     \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      ++g_failures;             \
+    }                           \
+  } while (0)
+
+uint32_t g_seed = 12345;
+
+uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// In [0, n)
+size_t Random(const size_t n) { return n ? Random() % n : 0; }
+
+size_t Align(const size_t size, const size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+struct Range {
+  size_t offset_;
+  size_t size_;
+  bool Overlaps(const Range& r) const {
+    return size_ && r.size_ && offset_ < r.offset_ + r.size_ &&
+           r.offset_ < offset_ + size_;
+  }
+};
+
+typedef std::vector<Range> Frame;
+
+bool OverlapsAny(const Range& range, const std::deque<Frame>& frames,
+                 const Frame& current) {
+  for (size_t f = 0; f < frames.size(); ++f)
+    for (size_t r = 0; r < frames[f].size(); ++r)
+      if (range.Overlaps(frames[f][r])) return true;
+  for (size_t r = 0; r < current.size(); ++r)
+    if (range.Overlaps(current[r])) return true;
+  return false;
+}
+
+size_t LiveBytes(const std::deque<Frame>& frames, const Frame& current) {
+  size_t bytes = 0;
+  for (size_t f = 0; f < frames.size(); ++f)
+    for (size_t r = 0; r < frames[f].size(); ++r) bytes += frames[f][r].size_;
+  for (size_t r = 0; r < current.size(); ++r) bytes += current[r].size_;
+  return bytes;
+}
+
+//--------------------------------------------------------------------------------
+// RingAllocator
+//--------------------------------------------------------------------------------
+// Returns false after the first failure of the run
+bool RandomRun(const int32_t run) {
+  const int32_t failures = g_failures;
+  const size_t alignment = ALIGNMENTS[Random(NUM_ALIGNMENTS)];
+  const size_t size = 1 + Random(MAX_RING_SIZE);
+  RingAllocator ring;
+  ring.Init(size, alignment);
+  CHECK(ring.GetSize() == size / alignment * alignment,
+        "run %d: size %zu for %zu, aligned to %zu", run, ring.GetSize(),
+        size, alignment);
+  // Allocations from tiny to more than the ring, and frames kept in flight
+  // for a while
+  const size_t max_allocation = 1 + Random(size + size / 4);
+  std::deque<Frame> frames;
+  std::deque<uintptr_t> fences;
+  uintptr_t next_fence = 1;
+  Frame current;
+
+  for (int32_t frame = 0; frame < RUN_FRAMES && g_failures == failures;
+       ++frame) {
+    const int32_t allocations = (int32_t)Random(4);
+    for (int32_t a = 0; a < allocations; ++a) {
+      const size_t bytes = 1 + Random(max_allocation);
+      const bool empty = frames.empty() && current.empty();
+      const size_t offset = ring.Allocate(bytes);
+      if (offset == RING_ALLOCATION_FAILED) {
+        CHECK(!empty || Align(bytes, alignment) > ring.GetSize(),
+              "run %d, frame %d: %zu bytes do not fit the empty ring", run,
+              frame, bytes);
+        continue;
+      }
+      Range range = {offset, Align(bytes, alignment)};
+      CHECK(offset % alignment == 0 &&
+                offset + range.size_ <= ring.GetSize(),
+            "run %d, frame %d: [%zu, +%zu) in a ring of %zu aligned to %zu",
+            run, frame, offset, range.size_, ring.GetSize(), alignment);
+      CHECK(!OverlapsAny(range, frames, current),
+            "run %d, frame %d: [%zu, +%zu) is in use", run, frame, offset,
+            range.size_);
+      if (Random(2)) {
+        // Give back the end, sometimes all of it
+        const size_t keep = Random(bytes + 1);
+        ring.Shrink(keep);
+        range.size_ = std::min(range.size_, Align(keep, alignment));
+      }
+      current.push_back(range);
+    }
+    CHECK(ring.GetUsed() >= LiveBytes(frames, current) &&
+              ring.GetUsed() <= ring.GetSize(),
+          "run %d, frame %d: %zu bytes used, %zu live in %zu", run, frame,
+          ring.GetUsed(), LiveBytes(frames, current), ring.GetSize());
+
+    ring.EndFrame(reinterpret_cast<void*>(next_fence));
+    fences.push_back(next_fence++);
+    frames.push_back(current);
+    current.clear();
+
+    // Fences signal in order, a few frames at a time
+    const int32_t keep = (int32_t)Random(5);
+    while ((int32_t)frames.size() > keep) {
+      const uintptr_t fence = reinterpret_cast<uintptr_t>(ring.RetireOldest());
+      CHECK(fence == fences.front(), "run %d, frame %d: retired fence %zu, "
+            "expected %zu", run, frame, (size_t)fence,
+            (size_t)fences.front());
+      fences.pop_front();
+      frames.pop_front();
+    }
+    CHECK(ring.GetFramesInFlight() == (int32_t)frames.size(),
+          "run %d, frame %d: %d frames in flight, expected %zu", run, frame,
+          ring.GetFramesInFlight(), frames.size());
+  }
+
+  while (ring.GetFramesInFlight()) ring.RetireOldest();
+  CHECK(ring.GetUsed() == 0, "run %d: %zu bytes leaked", run,
+        ring.GetUsed());
+  CHECK(ring.RetireOldest() == NULL && ring.GetOldestFence() == NULL,
+        "run %d: a fence with no frame in flight", run);
+  return g_failures == failures;
+}
+
+void TestRandomRuns() {
+  printf("RingAllocator, %d random runs of %d frames\n", RANDOM_RUNS,
+         RUN_FRAMES);
+  for (int32_t run = 0; run < RANDOM_RUNS; ++run)
+    if (!RandomRun(run)) return;
+}
+
+// Maps of |frames| - 1 frames in flight that find no room, in rings of
+// |frames| + |spare| frames
+int32_t CountBlockedMaps(const int32_t frames, const int32_t spare,
+                         int32_t* maps) {
+  int32_t blocked = 0;
+  *maps = 0;
+  for (int32_t run = 0; run < RANDOM_RUNS; ++run) {
+    const size_t alignment = ALIGNMENTS[Random(NUM_ALIGNMENTS)];
+    const size_t frame_size = 1 + Random(MAX_RING_SIZE);
+    // As StreamBuffer::Init()
+    RingAllocator ring;
+    ring.Init((frame_size + alignment) * (frames + spare), alignment);
+    for (int32_t frame = 0; frame < RUN_FRAMES; ++frame) {
+      // The GPU is done with all but the last |frames| - 1
+      while (ring.GetFramesInFlight() > frames - 1) ring.RetireOldest();
+      // Map the most a frame may need, keep what it wrote
+      size_t offset = ring.Allocate(frame_size);
+      ++*maps;
+      if (offset == RING_ALLOCATION_FAILED) {
+        ++blocked;
+        while (offset == RING_ALLOCATION_FAILED && ring.GetFramesInFlight()) {
+          ring.RetireOldest();
+          offset = ring.Allocate(frame_size);
+        }
+      }
+      ring.Shrink(Random(frame_size + 1));
+      ring.EndFrame(NULL);
+    }
+  }
+  return blocked;
+}
+
+void TestRingSize() {
+  printf("Ring sizes, maps that wait, %d runs of %d frames\n", RANDOM_RUNS,
+         RUN_FRAMES);
+  for (int32_t frames = 1; frames <= MAX_FRAMES; ++frames) {
+    int32_t maps = 0;
+    const int32_t blocked = CountBlockedMaps(frames, 1, &maps);
+    const int32_t blocked_no_spare = CountBlockedMaps(frames, 0, &maps);
+    printf("  %d frames, %d in flight: %6.2f%% with a spare frame, %6.2f%% "
+           "without\n",
+           frames, frames - 1, 100.0 * blocked / maps,
+           100.0 * blocked_no_spare / maps);
+    CHECK(blocked == 0, "%d frames: %d maps wait", frames, blocked);
+    if (frames > 1)
+      CHECK(blocked_no_spare > 0,
+            "%d frames: the spare frame is never needed", frames);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// StreamBuffer
+//--------------------------------------------------------------------------------
+struct StreamFrame {
+  size_t offset_;
+  size_t size_;
+  uint8_t value_;
+};
+
+// Map, check and write one frame, of the most a frame may hold if |full|;
+// false if Map() failed
+bool StreamFrameOnce(StreamBuffer* stream, const int32_t frame,
+                     const bool full, std::deque<StreamFrame>* frames) {
+  const size_t size = full ? STREAM_FRAME_SIZE : 1 + Random(STREAM_FRAME_SIZE);
+  uint8_t* p = static_cast<uint8_t*>(stream->Map(size));
+  if (p == NULL) return false;
+  const size_t offset = stream->GetOffset();
+  CHECK(offset % STREAM_ALIGNMENT == 0, "frame %d: offset %zu", frame,
+        offset);
+
+  // Frames whose fence has not signaled may still be read
+  const std::vector<uint8_t>* data =
+      android_mock::GetBufferData(stream->GetBuffer());
+  const Range range = {offset, size};
+  const int32_t pending = android_mock::GetPendingFences();
+  for (int32_t f = 0; f < pending && f < (int32_t)frames->size(); ++f) {
+    const StreamFrame& in_flight = (*frames)[frames->size() - 1 - f];
+    const Range read = {in_flight.offset_, in_flight.size_};
+    CHECK(!range.Overlaps(read),
+          "frame %d: [%zu, +%zu) maps bytes of a frame in flight", frame,
+          offset, size);
+    for (size_t i = 0; i < in_flight.size_; ++i)
+      if ((*data)[in_flight.offset_ + i] != in_flight.value_) {
+        CHECK(false, "frame %d: a frame in flight was overwritten", frame);
+        break;
+      }
+  }
+
+  const size_t written = full ? size : Random(size + 1);
+  const StreamFrame written_frame = {offset, written, (uint8_t)frame};
+  memset(p, written_frame.value_, written);
+  CHECK(stream->Unmap(written), "frame %d: Unmap() failed", frame);
+  stream->EndFrame();
+  frames->push_back(written_frame);
+  if ((int32_t)frames->size() > STREAM_BUFFER_FRAMES + 1) frames->pop_front();
+  CHECK(glGetError() == GL_NO_ERROR, "frame %d: GL error", frame);
+  return true;
+}
+
+void TestStreamBuffer() {
+  printf("StreamBuffer on the GL mock, %d frames\n", RUN_FRAMES * 3);
+  android_mock::ResetGl();
+  CHECK(gl3stubInit(), "gl3stubInit() failed");
+  {
+    StreamBuffer stream;
+    CHECK(stream.Init(GL_ARRAY_BUFFER, STREAM_FRAME_SIZE, STREAM_BUFFER_FRAMES,
+                      STREAM_ALIGNMENT),
+          "Init() failed");
+    std::deque<StreamFrame> frames;
+    // The GPU keeps up, lags a frame more than StreamBuffer allows for
+    // with full frames, then varies
+    for (int32_t phase = 0; phase < 3; ++phase) {
+      const int32_t waits = android_mock::GetFenceWaits();
+      for (int32_t f = 0; f < RUN_FRAMES; ++f) {
+        const int32_t frame = phase * RUN_FRAMES + f;
+        int32_t lag = (int32_t)Random(STREAM_BUFFER_FRAMES);
+        if (phase == 0) lag = STREAM_BUFFER_FRAMES - 1;
+        if (phase == 1) lag = STREAM_BUFFER_FRAMES;
+        android_mock::SignalFences(lag);
+        const int32_t before = android_mock::GetFenceWaits();
+        CHECK(StreamFrameOnce(&stream, frame, phase == 1 || Random(2),
+                              &frames),
+              "frame %d: Map() failed", frame);
+        if (lag < STREAM_BUFFER_FRAMES)
+          CHECK(android_mock::GetFenceWaits() == before,
+                "frame %d: Map() waited with %d frames in flight", frame,
+                lag);
+      }
+      printf("  GPU %s: %d of %d maps waited\n",
+             phase == 0 ? "keeping up"
+                        : phase == 1 ? "a frame more behind" : "varying",
+             android_mock::GetFenceWaits() - waits, RUN_FRAMES);
+    }
+    CHECK(android_mock::GetCalls("glFlushMappedBufferRange") > 0,
+          "written ranges are not flushed");
+    CHECK(android_mock::GetLiveFences() <= STREAM_BUFFER_FRAMES + 1,
+          "%d fences live", android_mock::GetLiveFences());
+
+    // A hung GPU: Map() gives up once every frame is in flight
+    android_mock::GetGlDriver().gpu_hung_ = true;
+    bool failed = false;
+    for (int32_t f = 0; f <= STREAM_BUFFER_FRAMES + 1 && !failed; ++f)
+      failed = !StreamFrameOnce(&stream, RUN_FRAMES * 3 + f, true, &frames);
+    CHECK(failed, "Map() never failed with the GPU hung");
+    android_mock::GetGlDriver().gpu_hung_ = false;
+    CHECK(StreamFrameOnce(&stream, RUN_FRAMES * 4, true, &frames),
+          "Map() failed once the GPU recovered");
+    stream.Release();
+    CHECK(android_mock::GetLiveFences() == 0, "%d fences leaked",
+          android_mock::GetLiveFences());
+  }
+  CHECK(android_mock::GetLiveObjects() == 0, "%d GL objects leaked",
+        android_mock::GetLiveObjects());
+}
+
+}  // namespace
+
+int main() {
+  TestRandomRuns();
+  TestRingSize();
+  TestStreamBuffer();
+
+  if (g_failures) {
+    printf("FAILED: %d\n", g_failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
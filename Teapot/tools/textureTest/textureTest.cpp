@@ -0,0 +1,896 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// textureTest.cpp
+// Host test and benchmark of the ndk_helper texture pipeline
+//
+// DecodePng() must give the pixels libpng gives, expanded to 8 bits the same
+// way, for every color type and bit depth, interlaced or not, with and
+// without tRNS, from files split into many IDAT chunks. Truncated or damaged
+// files must fail or decode to the right pixels, and never read out of
+// bounds (build with -fsanitize=address,undefined to check that).
+// DecodeKtx() must read both byte orders, drop the 4 byte row padding and
+// pass compressed data through.
+//
+// TextureManager first runs against a backend that records its calls:
+// Update() must keep to its byte budget, a handle must give the placeholder
+// until its texture is ready, and failed, released and destroyed textures
+// must be deleted. Then it runs with GLTextureBackend and GLContext on the
+// GL and EGL mock of tools/androidMock, on ES3 (rows staged in a pixel
+// unpack buffer) and on ES2 (in a child process, as GLContext reads the
+// version once): every texture must hold its image's pixels, raise no GL
+// error and be complete as a driver samples it.
+//
+// Then times DecodePng() against libpng.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  MOCK=../androidMock
+//  gcc -O2 -c -I$MOCK/include -I$NDK_HELPER $NDK_HELPER/gl3stub.c
+//  g++ -O2 -pthread -I$MOCK/include -I$MOCK -I$NDK_HELPER -o textureTest
+//  textureTest.cpp gl3stub.o $MOCK/androidMock.cpp
+//  $NDK_HELPER/imageDecoder.cpp $NDK_HELPER/textureManager.cpp
+//  $NDK_HELPER/glTextureBackend.cpp $NDK_HELPER/GLContext.cpp
+//  $NDK_HELPER/eglLoaderBackend.cpp $NDK_HELPER/assetCache.cpp -lpng -lz
+//  ./textureTest
+//--------------------------------------------------------------------------------
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "androidMock.h"
+#include "assetCache.h"
+#include "GLContext.h"
+#include "glTextureBackend.h"
+#include "imageDecoder.h"
+#include "textureManager.h"
+
+using ndk_helper::AssetCache;
+using ndk_helper::GLContext;
+using ndk_helper::GLTextureBackend;
+using ndk_helper::Image;
+using ndk_helper::TextureBackend;
+using ndk_helper::TextureManager;
+
+namespace {
+
+const int32_t PNG_SIZES[][2] = {{1, 1}, {7, 5}, {33, 17}, {64, 3}};
+const size_t UPDATE_BUDGET = 4096;
+// The recording backend fails to create textures this wide
+const int32_t FAIL_WIDTH = 200;
+const int32_t BENCH_SIZE = 1024;
+const int32_t BENCH_RUNS = 5;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)         \
+  do {                           \
+    if (!(cond)) {               \
+      printf("  FAILED: ");      \
+      printf(__VA_ARGS__);       \
+      printf("\n");              \
+      ++g_failures;              \
+    }                            \
+  } while (0)
+
+std::string g_files_dir;
+uint32_t g_seed = 0x12345678;
+
+uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+double NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void WriteFile(const std::string& name, const std::vector<uint8_t>& data) {
+  const std::string path = g_files_dir + "/" + name;
+  FILE* f = fopen(path.c_str(), "wb");
+  if (f == NULL) return;
+  if (data.size()) fwrite(&data[0], 1, data.size(), f);
+  fclose(f);
+}
+
+//--------------------------------------------------------------------------------
+// libpng
+//--------------------------------------------------------------------------------
+struct PngCase {
+  int32_t color;
+  int32_t depth;
+  bool trns;
+  bool interlaced;
+  int32_t width;
+  int32_t height;
+};
+
+std::string Describe(const PngCase& c) {
+  char str[64];
+  snprintf(str, sizeof(str), "color %d depth %d%s%s %dx%d", c.color, c.depth,
+           c.trns ? " tRNS" : "", c.interlaced ? " Adam7" : "", c.width,
+           c.height);
+  return str;
+}
+
+void WriteToVector(png_structp png, png_bytep data, png_size_t length) {
+  std::vector<uint8_t>* out =
+      static_cast<std::vector<uint8_t>*>(png_get_io_ptr(png));
+  out->insert(out->end(), data, data + length);
+}
+
+void Flush(png_structp) {}
+
+struct ReadState {
+  const uint8_t* data;
+  size_t size;
+  size_t position;
+};
+
+void ReadFromMemory(png_structp png, png_bytep data, png_size_t length) {
+  ReadState* state = static_cast<ReadState*>(png_get_io_ptr(png));
+  if (length > state->size - state->position) png_error(png, "truncated");
+  memcpy(data, state->data + state->position, length);
+  state->position += length;
+}
+
+int32_t PaletteSize(const PngCase& c) {
+  return c.color == PNG_COLOR_TYPE_PALETTE ? std::min(1 << c.depth, 200) : 0;
+}
+
+// Random samples in libpng's row layout: packed below 8 bits, 16 bit big
+// endian. A quarter of the pixels is the tRNS key, so that it is hit.
+std::vector<uint8_t> EncodePng(const PngCase& c) {
+  const int32_t channels = c.color == PNG_COLOR_TYPE_RGB         ? 3
+                           : c.color == PNG_COLOR_TYPE_RGB_ALPHA ? 4
+                           : c.color == PNG_COLOR_TYPE_GRAY_ALPHA ? 2
+                                                                  : 1;
+  const uint32_t max_sample = c.color == PNG_COLOR_TYPE_PALETTE
+                                  ? PaletteSize(c) - 1
+                                  : (1u << c.depth) - 1;
+  uint32_t key[3];
+  for (int32_t i = 0; i < 3; ++i) key[i] = Random() & max_sample;
+
+  const size_t row_bytes = (c.width * channels * c.depth + 7) / 8;
+  std::vector<uint8_t> pixels(row_bytes * c.height, 0);
+  for (int32_t y = 0; y < c.height; ++y) {
+    uint8_t* row = &pixels[y * row_bytes];
+    const bool use_key = c.trns && c.color != PNG_COLOR_TYPE_PALETTE;
+    for (int32_t x = 0; x < c.width; ++x) {
+      const bool keyed = use_key && Random() % 4 == 0;
+      for (int32_t ch = 0; ch < channels; ++ch) {
+        const uint32_t v = keyed ? key[ch] : Random() % (max_sample + 1);
+        const size_t bit = (size_t)(x * channels + ch) * c.depth;
+        if (c.depth == 16) {
+          row[bit / 8] = (uint8_t)(v >> 8);
+          row[bit / 8 + 1] = (uint8_t)v;
+        } else {
+          row[bit / 8] |= (uint8_t)(v << (8 - c.depth - bit % 8));
+        }
+      }
+    }
+  }
+
+  std::vector<uint8_t> out;
+  png_structp png =
+      png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  png_infop info = png_create_info_struct(png);
+  if (setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, &info);
+    return std::vector<uint8_t>();
+  }
+  png_set_write_fn(png, &out, WriteToVector, Flush);
+  // Small buffers: many IDAT chunks
+  png_set_compression_buffer_size(png, 64);
+  png_set_IHDR(png, info, c.width, c.height, c.depth, c.color,
+               c.interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  // Locals set before setjmp() and used after it could be clobbered by the
+  // longjmp(), so the palette size is only taken here
+  if (c.color == PNG_COLOR_TYPE_PALETTE) {
+    const int32_t palette_size = PaletteSize(c);
+    png_color palette[256];
+    for (int32_t i = 0; i < palette_size; ++i) {
+      palette[i].red = (png_byte)Random();
+      palette[i].green = (png_byte)Random();
+      palette[i].blue = (png_byte)Random();
+    }
+    png_set_PLTE(png, info, palette, palette_size);
+    if (c.trns) {
+      png_byte alpha[256];
+      const int32_t count = 1 + Random() % palette_size;
+      for (int32_t i = 0; i < count; ++i) alpha[i] = (png_byte)Random();
+      png_set_tRNS(png, info, alpha, count, NULL);
+    }
+  } else if (c.trns) {
+    png_color_16 color = {};
+    color.gray = (png_uint_16)key[0];
+    color.red = (png_uint_16)key[0];
+    color.green = (png_uint_16)key[1];
+    color.blue = (png_uint_16)key[2];
+    png_set_tRNS(png, info, NULL, 0, &color);
+  }
+  png_write_info(png, info);
+  std::vector<png_bytep> rows(c.height);
+  for (int32_t y = 0; y < c.height; ++y) rows[y] = &pixels[y * row_bytes];
+  png_set_interlace_handling(png);
+  png_write_image(png, &rows[0]);
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+  return out;
+}
+
+// libpng's reading, with the transforms that match the decoder's output
+bool DecodeReference(const std::vector<uint8_t>& data, Image* image) {
+  png_structp png =
+      png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  png_infop info = png_create_info_struct(png);
+  std::vector<png_bytep> rows;
+  if (setjmp(png_jmpbuf(png))) {
+    png_destroy_read_struct(&png, &info, NULL);
+    return false;
+  }
+  ReadState state = {&data[0], data.size(), 0};
+  png_set_read_fn(png, &state, ReadFromMemory);
+  png_read_info(png, info);
+  png_set_expand(png);
+  png_set_strip_16(png);
+  png_set_interlace_handling(png);
+  png_read_update_info(png, info);
+
+  image->width_ = png_get_image_width(png, info);
+  image->height_ = png_get_image_height(png, info);
+  switch (png_get_channels(png, info)) {
+    case 1:
+      image->format_ = ndk_helper::IMAGE_FORMAT_L8;
+      break;
+    case 2:
+      image->format_ = ndk_helper::IMAGE_FORMAT_LA8;
+      break;
+    case 3:
+      image->format_ = ndk_helper::IMAGE_FORMAT_RGB8;
+      break;
+    default:
+      image->format_ = ndk_helper::IMAGE_FORMAT_RGBA8;
+  }
+  const size_t stride = png_get_rowbytes(png, info);
+  image->pixels_.resize(stride * image->height_);
+  rows.resize(image->height_);
+  for (int32_t y = 0; y < image->height_; ++y)
+    rows[y] = &image->pixels_[y * stride];
+  png_read_image(png, &rows[0]);
+  png_destroy_read_struct(&png, &info, NULL);
+  return true;
+}
+
+bool SameImage(const Image& a, const Image& b) {
+  return a.width_ == b.width_ && a.height_ == b.height_ &&
+         a.format_ == b.format_ &&
+         a.compressed_format_ == b.compressed_format_ && a.pixels_ == b.pixels_;
+}
+
+//--------------------------------------------------------------------------------
+// PNG
+//--------------------------------------------------------------------------------
+std::vector<PngCase> MakePngCases() {
+  static const int32_t TYPES[][3] = {
+      // color, depth, tRNS allowed
+      {PNG_COLOR_TYPE_GRAY, 1, 1},        {PNG_COLOR_TYPE_GRAY, 2, 1},
+      {PNG_COLOR_TYPE_GRAY, 4, 1},        {PNG_COLOR_TYPE_GRAY, 8, 1},
+      {PNG_COLOR_TYPE_GRAY, 16, 1},       {PNG_COLOR_TYPE_GRAY_ALPHA, 8, 0},
+      {PNG_COLOR_TYPE_GRAY_ALPHA, 16, 0}, {PNG_COLOR_TYPE_RGB, 8, 1},
+      {PNG_COLOR_TYPE_RGB, 16, 1},        {PNG_COLOR_TYPE_PALETTE, 1, 1},
+      {PNG_COLOR_TYPE_PALETTE, 2, 1},     {PNG_COLOR_TYPE_PALETTE, 4, 1},
+      {PNG_COLOR_TYPE_PALETTE, 8, 1},     {PNG_COLOR_TYPE_RGB_ALPHA, 8, 0},
+      {PNG_COLOR_TYPE_RGB_ALPHA, 16, 0},
+  };
+  std::vector<PngCase> cases;
+  for (size_t t = 0; t < sizeof(TYPES) / sizeof(TYPES[0]); ++t) {
+    for (int32_t trns = 0; trns <= TYPES[t][2]; ++trns) {
+      for (int32_t interlaced = 0; interlaced < 2; ++interlaced) {
+        for (size_t s = 0; s < sizeof(PNG_SIZES) / sizeof(PNG_SIZES[0]);
+             ++s) {
+          PngCase c = {TYPES[t][0],     TYPES[t][1],     trns != 0,
+                       interlaced != 0, PNG_SIZES[s][0], PNG_SIZES[s][1]};
+          cases.push_back(c);
+        }
+      }
+    }
+  }
+  return cases;
+}
+
+void TestPng() {
+  printf("PNG\n");
+  const std::vector<PngCase> cases = MakePngCases();
+  int32_t matched = 0;
+  for (size_t i = 0; i < cases.size(); ++i) {
+    const std::vector<uint8_t> file = EncodePng(cases[i]);
+    Image expected, image;
+    if (!DecodeReference(file, &expected)) {
+      CHECK(false, "libpng could not read %s", Describe(cases[i]).c_str());
+      continue;
+    }
+    const bool decoded = ndk_helper::DecodePng(&file[0], file.size(), &image);
+    CHECK(decoded && SameImage(image, expected), "%s differs from libpng",
+          Describe(cases[i]).c_str());
+    if (decoded && SameImage(image, expected)) ++matched;
+  }
+  printf("  %d of %d files decode as libpng does\n", matched,
+         (int32_t)cases.size());
+
+  // Damaged files: every truncation, then random byte changes
+  static const PngCase DAMAGED[] = {
+      {PNG_COLOR_TYPE_RGB, 8, false, true, 33, 17},
+      {PNG_COLOR_TYPE_PALETTE, 4, true, false, 33, 17},
+      {PNG_COLOR_TYPE_GRAY, 16, true, true, 7, 5},
+  };
+  int32_t truncated = 0, flipped = 0, flipped_ok = 0;
+  for (size_t i = 0; i < sizeof(DAMAGED) / sizeof(DAMAGED[0]); ++i) {
+    const std::vector<uint8_t> file = EncodePng(DAMAGED[i]);
+    Image expected;
+    DecodeReference(file, &expected);
+    for (size_t size = 0; size < file.size(); ++size) {
+      // A copy of exactly |size| bytes, so that a sanitizer sees overreads
+      std::vector<uint8_t> part(file.begin(), file.begin() + size);
+      Image image;
+      const uint8_t* data = size ? &part[0] : NULL;
+      if (ndk_helper::DecodePng(data, size, &image)) {
+        CHECK(SameImage(image, expected), "%s cut at %d decodes wrong",
+              Describe(DAMAGED[i]).c_str(), (int32_t)size);
+      }
+      ++truncated;
+    }
+    for (int32_t n = 0; n < 2000; ++n) {
+      std::vector<uint8_t> damaged = file;
+      damaged[Random() % damaged.size()] ^= (uint8_t)(1 + Random() % 255);
+      Image image;
+      if (ndk_helper::DecodePng(&damaged[0], damaged.size(), &image))
+        ++flipped_ok;
+      ++flipped;
+    }
+  }
+  printf("  %d truncated files, %d damaged files (%d still decode)\n",
+         truncated, flipped, flipped_ok);
+}
+
+//--------------------------------------------------------------------------------
+// KTX
+//--------------------------------------------------------------------------------
+const uint8_t KTX_IDENTIFIER[12] = {0xab, 'K',  'T',  'X',  ' ',  '1',
+                                    '1',  0xbb, '\r', '\n', 0x1a, '\n'};
+
+void PutU32(std::vector<uint8_t>* out, const uint32_t v,
+            const bool big_endian) {
+  for (int32_t i = 0; i < 4; ++i) {
+    const int32_t shift = big_endian ? 24 - i * 8 : i * 8;
+    out->push_back((uint8_t)(v >> shift));
+  }
+}
+
+// Fields after the identifier, as KTX 1.1 orders them
+enum {
+  KTX_TYPE,
+  KTX_FORMAT,
+  KTX_INTERNAL_FORMAT,
+  KTX_WIDTH,
+  KTX_HEIGHT,
+  KTX_DEPTH,
+  KTX_FACES,
+};
+
+std::vector<uint8_t> MakeKtx(const bool big_endian, const uint32_t* fields,
+                             const std::vector<uint8_t>& level,
+                             const uint32_t image_size) {
+  std::vector<uint8_t> out(KTX_IDENTIFIER, KTX_IDENTIFIER + 12);
+  PutU32(&out, 0x04030201, big_endian);
+  PutU32(&out, fields[KTX_TYPE], big_endian);
+  PutU32(&out, fields[KTX_TYPE] ? 1 : 0, big_endian);
+  PutU32(&out, fields[KTX_FORMAT], big_endian);
+  PutU32(&out, fields[KTX_INTERNAL_FORMAT], big_endian);
+  PutU32(&out, fields[KTX_FORMAT] ? fields[KTX_FORMAT] : GL_RGB, big_endian);
+  PutU32(&out, fields[KTX_WIDTH], big_endian);
+  PutU32(&out, fields[KTX_HEIGHT], big_endian);
+  PutU32(&out, fields[KTX_DEPTH], big_endian);
+  PutU32(&out, 0, big_endian);  // Array elements
+  PutU32(&out, fields[KTX_FACES], big_endian);
+  PutU32(&out, 1, big_endian);  // Mipmap levels
+  // Key and value data, skipped by the decoder
+  PutU32(&out, 16, big_endian);
+  PutU32(&out, 12, big_endian);
+  const char KEY_VALUE[] = "KTXorientati";
+  out.insert(out.end(), KEY_VALUE, KEY_VALUE + 12);
+  PutU32(&out, image_size, big_endian);
+  out.insert(out.end(), level.begin(), level.end());
+  return out;
+}
+
+// Uncompressed KTX of random pixels, rows padded to 4 bytes
+std::vector<uint8_t> MakeUncompressedKtx(const bool big_endian,
+                                         const GLenum format,
+                                         const int32_t width,
+                                         const int32_t height, Image* image) {
+  const int32_t bpp = format == GL_LUMINANCE         ? 1
+                      : format == GL_LUMINANCE_ALPHA ? 2
+                      : format == GL_RGB             ? 3
+                                                     : 4;
+  const size_t stride = width * bpp;
+  const size_t padded = (stride + 3) & ~(size_t)3;
+  std::vector<uint8_t> level(padded * height, 0);
+  image->width_ = width;
+  image->height_ = height;
+  image->format_ = bpp == 1   ? ndk_helper::IMAGE_FORMAT_L8
+                   : bpp == 2 ? ndk_helper::IMAGE_FORMAT_LA8
+                   : bpp == 3 ? ndk_helper::IMAGE_FORMAT_RGB8
+                              : ndk_helper::IMAGE_FORMAT_RGBA8;
+  image->compressed_format_ = 0;
+  image->pixels_.resize(stride * height);
+  for (int32_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < stride; ++x) {
+      const uint8_t v = (uint8_t)Random();
+      level[y * padded + x] = v;
+      image->pixels_[y * stride + x] = v;
+    }
+  }
+  const uint32_t fields[] = {GL_UNSIGNED_BYTE, format, format,
+                             (uint32_t)width,  (uint32_t)height, 0, 1};
+  return MakeKtx(big_endian, fields, level, (uint32_t)level.size());
+}
+
+// ETC1 blocks of random bits, 8 bytes per 4x4 block
+std::vector<uint8_t> MakeEtc1Ktx(const int32_t width, const int32_t height,
+                                 Image* image) {
+  image->width_ = width;
+  image->height_ = height;
+  image->format_ = ndk_helper::IMAGE_FORMAT_COMPRESSED;
+  image->compressed_format_ = GL_ETC1_RGB8_OES;
+  image->pixels_.resize(((width + 3) / 4) * ((height + 3) / 4) * 8);
+  for (size_t i = 0; i < image->pixels_.size(); ++i)
+    image->pixels_[i] = (uint8_t)Random();
+  const uint32_t fields[] = {0, 0, GL_ETC1_RGB8_OES, (uint32_t)width,
+                             (uint32_t)height, 0, 1};
+  return MakeKtx(false, fields, image->pixels_,
+                 (uint32_t)image->pixels_.size());
+}
+
+void TestKtx() {
+  printf("KTX\n");
+  static const GLenum FORMATS[] = {GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB,
+                                   GL_RGBA};
+  for (int32_t big_endian = 0; big_endian < 2; ++big_endian) {
+    for (size_t f = 0; f < sizeof(FORMATS) / sizeof(FORMATS[0]); ++f) {
+      Image expected, image;
+      const std::vector<uint8_t> file =
+          MakeUncompressedKtx(big_endian != 0, FORMATS[f], 5, 3, &expected);
+      CHECK(ndk_helper::DecodeImage(&file[0], file.size(), &image) &&
+                SameImage(image, expected),
+            "KTX format 0x%x, %s endian", FORMATS[f],
+            big_endian ? "big" : "little");
+    }
+  }
+
+  Image expected, image;
+  std::vector<uint8_t> file = MakeEtc1Ktx(10, 6, &expected);
+  CHECK(ndk_helper::DecodeImage(&file[0], file.size(), &image) &&
+            SameImage(image, expected),
+        "ETC1 KTX is not passed through");
+
+  // Unsupported or malformed: 3D, cube map, float texels, short level
+  const std::vector<uint8_t> level(64, 0);
+  const uint32_t BAD[][7] = {
+      {GL_UNSIGNED_BYTE, GL_RGBA, GL_RGBA, 4, 4, 1, 1},
+      {GL_UNSIGNED_BYTE, GL_RGBA, GL_RGBA, 4, 4, 0, 6},
+      {GL_FLOAT, GL_RGBA, GL_RGBA, 4, 4, 0, 1},
+      {GL_UNSIGNED_BYTE, GL_RGBA, GL_RGBA, 4, 5, 0, 1},
+  };
+  for (size_t i = 0; i < sizeof(BAD) / sizeof(BAD[0]); ++i) {
+    file = MakeKtx(false, BAD[i], level, (uint32_t)level.size());
+    CHECK(!ndk_helper::DecodeImage(&file[0], file.size(), &image),
+          "bad KTX %d decodes", (int32_t)i);
+  }
+  // A level size past the end of the file
+  file = MakeKtx(false, BAD[0], level, 1000);
+  CHECK(!ndk_helper::DecodeKtx(&file[0], file.size(), &image),
+        "KTX with a level past the end decodes");
+  for (size_t size = 0; size < file.size(); ++size) {
+    std::vector<uint8_t> part(file.begin(), file.begin() + size);
+    CHECK(!ndk_helper::DecodeKtx(size ? &part[0] : NULL, size, &image),
+          "KTX cut at %d decodes", (int32_t)size);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// TextureManager
+//--------------------------------------------------------------------------------
+struct TestFile {
+  const char* name;
+  Image image;
+  bool valid;
+};
+
+std::vector<TestFile> g_test_files;
+
+void AddPngFile(const char* name, const int32_t color, const int32_t width,
+                const int32_t height) {
+  PngCase c = {color, 8, false, false, width, height};
+  const std::vector<uint8_t> file = EncodePng(c);
+  WriteFile(name, file);
+  TestFile test_file;
+  test_file.name = name;
+  test_file.valid = DecodeReference(file, &test_file.image);
+  g_test_files.push_back(test_file);
+}
+
+void WriteTestFiles() {
+  AddPngFile("rgba64.png", PNG_COLOR_TYPE_RGB_ALPHA, 64, 64);
+  AddPngFile("rgb100.png", PNG_COLOR_TYPE_RGB, 100, 37);
+  AddPngFile("l33.png", PNG_COLOR_TYPE_GRAY, 33, 17);
+  AddPngFile("la16.png", PNG_COLOR_TYPE_GRAY_ALPHA, 16, 16);
+  AddPngFile("wide.png", PNG_COLOR_TYPE_RGB, FAIL_WIDTH, 2);
+
+  TestFile etc1;
+  etc1.name = "etc1.ktx";
+  etc1.valid = true;
+  WriteFile(etc1.name, MakeEtc1Ktx(32, 16, &etc1.image));
+  g_test_files.push_back(etc1);
+
+  TestFile bad;
+  bad.name = "bad.png";
+  bad.valid = false;
+  WriteFile(bad.name, std::vector<uint8_t>(100, 0x89));
+  g_test_files.push_back(bad);
+
+  TestFile missing;
+  missing.name = "missing.png";
+  missing.valid = false;
+  g_test_files.push_back(missing);
+}
+
+// What the recording backend saw; global, as the manager deletes it
+struct BackendLog {
+  uint32_t next_name;
+  int32_t live;
+  uint32_t placeholder;
+  std::map<uint32_t, std::vector<uint8_t> > contents;
+  std::set<uint32_t> finished;
+};
+
+BackendLog g_log;
+
+class RecordingBackend : public TextureBackend {
+ public:
+  uint32_t CreatePlaceholder() {
+    ++g_log.live;
+    g_log.placeholder = g_log.next_name++;
+    return g_log.placeholder;
+  }
+
+  uint32_t CreateTexture(const Image& image) {
+    if (image.width_ == FAIL_WIDTH) return 0;
+    ++g_log.live;
+    std::vector<uint8_t>& contents = g_log.contents[g_log.next_name];
+    if (image.format_ == ndk_helper::IMAGE_FORMAT_COMPRESSED)
+      contents = image.pixels_;
+    else
+      contents.assign(image.pixels_.size(), 0);
+    return g_log.next_name++;
+  }
+
+  void UploadRows(const uint32_t texture, const Image& image, const int32_t y,
+                  const int32_t rows) {
+    const size_t stride = image.Stride();
+    std::vector<uint8_t>& contents = g_log.contents[texture];
+    memcpy(&contents[y * stride], &image.pixels_[y * stride], rows * stride);
+  }
+
+  void FinishTexture(const uint32_t texture, const Image&) {
+    g_log.finished.insert(texture);
+  }
+
+  void DeleteTexture(const uint32_t texture) {
+    --g_log.live;
+    g_log.contents.erase(texture);
+    g_log.finished.erase(texture);
+  }
+};
+
+// Update() until nothing is pending; the largest amount one call uploaded
+size_t UpdateAll(TextureManager* textures, const size_t budget,
+                 int32_t* calls) {
+  size_t largest = 0;
+  *calls = 0;
+  for (int32_t i = 0; i < 100000 && textures->GetPendingCount(); ++i) {
+    const size_t uploaded = textures->Update(budget);
+    largest = std::max(largest, uploaded);
+    if (uploaded)
+      ++*calls;
+    else
+      usleep(100);
+  }
+  return largest;
+}
+
+void TestManager() {
+  printf("TextureManager\n");
+  g_log.next_name = 1;
+  g_log.live = 0;
+  TextureManager* textures = new TextureManager(new RecordingBackend(), 2);
+
+  std::vector<int32_t> handles;
+  for (size_t i = 0; i < g_test_files.size(); ++i)
+    handles.push_back(textures->Load(g_test_files[i].name));
+  CHECK(textures->GetPendingCount() == (int32_t)handles.size(),
+        "%d pending, not %d", textures->GetPendingCount(),
+        (int32_t)handles.size());
+  const uint32_t placeholder = textures->GetTexture(handles[0]);
+  CHECK(placeholder == g_log.placeholder, "no placeholder while loading");
+
+  int32_t calls;
+  const size_t largest = UpdateAll(textures, UPDATE_BUDGET, &calls);
+  CHECK(largest <= UPDATE_BUDGET, "an Update() uploaded %d bytes",
+        (int32_t)largest);
+  size_t total = 0;
+  int32_t ready = 0;
+  for (size_t i = 0; i < g_test_files.size(); ++i) {
+    const TestFile& file = g_test_files[i];
+    const bool expect_ready = file.valid && file.image.width_ != FAIL_WIDTH;
+    const ndk_helper::TEXTURE_STATE state = textures->GetState(handles[i]);
+    const uint32_t texture = textures->GetTexture(handles[i]);
+    if (!expect_ready) {
+      CHECK(state == ndk_helper::TEXTURE_STATE_FAILED && texture == placeholder,
+            "%s did not fail", file.name);
+      continue;
+    }
+    ++ready;
+    total += file.image.pixels_.size();
+    CHECK(state == ndk_helper::TEXTURE_STATE_READY && texture != placeholder,
+          "%s is not ready", file.name);
+    CHECK(g_log.contents[texture] == file.image.pixels_,
+          "%s was not uploaded whole", file.name);
+    CHECK(g_log.finished.count(texture), "%s was not finished", file.name);
+  }
+  CHECK(g_log.live == ready + 1, "%d live textures, not %d", g_log.live,
+        ready + 1);
+  printf("  %d KB in %d Update() calls of at most %d KB\n",
+         (int32_t)(total / 1024), calls, (int32_t)(UPDATE_BUDGET / 1024));
+
+  // A budget too small for a row still uploads one row per call
+  const int32_t one_row = textures->Load("rgb100.png");
+  UpdateAll(textures, 1, &calls);
+  CHECK(calls == 37, "%d calls for 37 rows with a 1 byte budget", calls);
+  textures->Release(one_row);
+
+  // Released while loading: no texture is made, the handle is reused
+  const int32_t live = g_log.live;
+  int32_t last_handle = 0;
+  for (int32_t i = 0; i < 20; ++i) {
+    const int32_t handle = textures->Load("rgba64.png");
+    last_handle = std::max(last_handle, handle);
+    textures->Release(handle);
+    CHECK(textures->GetState(handle) == ndk_helper::TEXTURE_STATE_FAILED &&
+              textures->GetTexture(handle) == placeholder,
+          "a released handle still resolves");
+  }
+  CHECK(textures->GetPendingCount() == 0, "released loads stay pending");
+  for (int32_t i = 0; i < 200; ++i) {
+    textures->Update(UPDATE_BUDGET);
+    usleep(100);
+  }
+  CHECK(g_log.live == live, "released loads made %d textures",
+        g_log.live - live);
+  const int32_t reused = textures->Load("l33.png");
+  CHECK(reused <= last_handle, "handle %d was not reused", reused);
+  UpdateAll(textures, UPDATE_BUDGET, &calls);
+  CHECK(textures->GetState(reused) == ndk_helper::TEXTURE_STATE_READY,
+        "the reused handle did not load");
+
+  // Released once ready
+  textures->Release(handles[0]);
+  CHECK(g_log.live == live, "a released texture was not deleted");
+
+  delete textures;
+  CHECK(g_log.live == 0, "%d textures left after the manager", g_log.live);
+}
+
+//--------------------------------------------------------------------------------
+// GLTextureBackend
+//--------------------------------------------------------------------------------
+GLenum GetGLFormat(const Image& image) {
+  switch (image.format_) {
+    case ndk_helper::IMAGE_FORMAT_L8:
+      return GL_LUMINANCE;
+    case ndk_helper::IMAGE_FORMAT_LA8:
+      return GL_LUMINANCE_ALPHA;
+    case ndk_helper::IMAGE_FORMAT_RGB8:
+      return GL_RGB;
+    case ndk_helper::IMAGE_FORMAT_RGBA8:
+      return GL_RGBA;
+    default:
+      return image.compressed_format_;
+  }
+}
+
+void TestGlBackend(const bool es3) {
+  printf("GLTextureBackend, ES%d\n", es3 ? 3 : 2);
+  if (!es3) android_mock::GetGlDriver().version_ = "OpenGL ES 2.0 androidMock";
+  // The wide file fails: past the driver's size limit
+  android_mock::GetGlDriver().max_texture_size_ = FAIL_WIDTH - 1;
+  ANativeWindow* window = android_mock::CreateWindow(320, 240);
+  GLContext* context = GLContext::GetInstance();
+  CHECK(context->Init(window) && context->GetGLVersion() == (es3 ? 3.f : 2.f),
+        "GLContext did not make an ES%d context", es3 ? 3 : 2);
+  android_mock::ResetCalls();
+
+  {
+    TextureManager textures(new GLTextureBackend(), 2);
+    std::vector<int32_t> handles;
+    for (size_t i = 0; i < g_test_files.size(); ++i)
+      handles.push_back(textures.Load(g_test_files[i].name));
+    int32_t calls;
+    UpdateAll(&textures, UPDATE_BUDGET, &calls);
+    CHECK(glGetError() == GL_NO_ERROR, "a GL error is left");
+
+    const GLuint placeholder = textures.GetTexture(handles.back());
+    const android_mock::Texture* t = android_mock::GetTexture(placeholder);
+    CHECK(t && t->width_ == 1 && t->height_ == 1 &&
+              t->pixels_ == std::vector<uint8_t>(4, 255) &&
+              android_mock::IsTextureComplete(placeholder),
+          "the placeholder is not a complete white texel");
+
+    for (size_t i = 0; i < g_test_files.size(); ++i) {
+      const TestFile& file = g_test_files[i];
+      const GLuint texture = textures.GetTexture(handles[i]);
+      if (!file.valid || file.image.width_ == FAIL_WIDTH) {
+        CHECK(texture == placeholder, "%s did not fail", file.name);
+        continue;
+      }
+      t = android_mock::GetTexture(texture);
+      CHECK(t && t->width_ == file.image.width_ &&
+                t->height_ == file.image.height_ &&
+                t->format_ == GetGLFormat(file.image) &&
+                t->pixels_ == file.image.pixels_,
+            "%s does not hold its pixels", file.name);
+      CHECK(android_mock::IsTextureComplete(texture), "%s is not complete",
+            file.name);
+      // ES3 mipmaps every uncompressed texture, ES2 only powers of two
+      const bool pot = !(file.image.width_ & (file.image.width_ - 1)) &&
+                       !(file.image.height_ & (file.image.height_ - 1));
+      const bool mipmaps =
+          file.image.format_ != ndk_helper::IMAGE_FORMAT_COMPRESSED &&
+          (es3 || pot);
+      CHECK(t && t->mipmaps_ == mipmaps, "%s %s mipmaps", file.name,
+            mipmaps ? "lacks" : "has");
+    }
+    const int32_t mapped = android_mock::GetCalls("glMapBufferRange");
+    CHECK(es3 ? mapped > 0 : mapped == 0, "%d rows staged in a buffer",
+          mapped);
+    printf("  %d glTexSubImage2D(), %d through a pixel unpack buffer\n",
+           android_mock::GetCalls("glTexSubImage2D"), mapped);
+  }
+
+  CHECK(android_mock::GetLiveObjects() == 0, "%d GL objects leaked",
+        android_mock::GetLiveObjects());
+  CHECK(android_mock::GetCalls(android_mock::MOCK_NO_CONTEXT) == 0,
+        "GL called with no context");
+  context->Invalidate();
+  CHECK(android_mock::GetLiveEglObjects() == 0, "EGL objects leaked");
+  android_mock::DestroyWindow(window);
+}
+
+// GLContext keeps the version it read first: ES2 runs in a child
+void TestGlBackendEs2() {
+  fflush(stdout);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    TestGlBackend(false);
+    fflush(stdout);
+    _exit(g_failures ? 1 : 0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "ES2 backend failed");
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+void Benchmark() {
+  // A gradient with noise, which compresses as photos and art do
+  std::vector<uint8_t> pixels(BENCH_SIZE * BENCH_SIZE * 4);
+  for (int32_t y = 0; y < BENCH_SIZE; ++y) {
+    for (int32_t x = 0; x < BENCH_SIZE; ++x) {
+      uint8_t* p = &pixels[(y * BENCH_SIZE + x) * 4];
+      p[0] = (uint8_t)(x / 4 + Random() % 8);
+      p[1] = (uint8_t)(y / 4 + Random() % 8);
+      p[2] = (uint8_t)((x + y) / 8);
+      p[3] = 255;
+    }
+  }
+  std::vector<uint8_t> file;
+  png_structp png =
+      png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  png_infop info = png_create_info_struct(png);
+  if (setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, &info);
+    return;
+  }
+  png_set_write_fn(png, &file, WriteToVector, Flush);
+  png_set_IHDR(png, info, BENCH_SIZE, BENCH_SIZE, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+               PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+               PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+  for (int32_t y = 0; y < BENCH_SIZE; ++y)
+    png_write_row(png, &pixels[y * BENCH_SIZE * 4]);
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+
+  double best_decoder = 1e30, best_libpng = 1e30;
+  for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+    Image image;
+    double start = NowNs();
+    ndk_helper::DecodePng(&file[0], file.size(), &image);
+    best_decoder = std::min(best_decoder, NowNs() - start);
+    CHECK(image.pixels_ == pixels, "benchmark image decodes wrong");
+
+    start = NowNs();
+    DecodeReference(file, &image);
+    best_libpng = std::min(best_libpng, NowNs() - start);
+  }
+  const double mb = pixels.size() / (1024. * 1024.);
+  printf("%dx%d RGBA PNG (%d KB): DecodePng %.1fms (%.0f MB/s), "
+         "libpng %.1fms\n",
+         BENCH_SIZE, BENCH_SIZE, (int32_t)(file.size() / 1024),
+         best_decoder / 1e6, mb / (best_decoder / 1e9), best_libpng / 1e6);
+}
+
+}  // namespace
+
+int main() {
+  char dir[] = "/tmp/textureTest.XXXXXX";
+  if (!mkdtemp(dir)) return 1;
+  g_files_dir = dir;
+  AssetCache::GetInstance()->Init(NULL, g_files_dir.c_str());
+
+  TestPng();
+  TestKtx();
+  WriteTestFiles();
+  TestManager();
+  TestGlBackendEs2();
+  TestGlBackend(true);
+  Benchmark();
+
+  const std::string command = std::string("rm -rf ") + dir;
+  if (system(command.c_str())) printf("Could not remove %s\n", dir);
+  printf("%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// arm_neon.h
+// Host stand-in for the NEON intrinsics used by ndk_helper, so that the NEON
+// code paths can be built and checked on a machine without an ARM compiler
+// (see vecmathTest.cpp). Each intrinsic does what the ARM documentation says,
+// lane by lane, with the compiler's vector extensions; none of them fuses a
+// multiply and an add, as the real ones don't either.
+//
+// Only what ndk_helper uses is here; add intrinsics as the code needs them.
+//--------------------------------------------------------------------------------
+#ifndef VECMATH_TEST_ARM_NEON_H_
+#define VECMATH_TEST_ARM_NEON_H_
+
+#include <string.h>
+
+typedef float float32x2_t __attribute__((vector_size(8)));
+typedef float float32x4_t __attribute__((vector_size(16)));
+
+struct float32x4x4_t {
+  float32x4_t val[4];
+};
+
+inline float32x4_t vld1q_f32(const float* p) {
+  float32x4_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void vst1q_f32(float* p, const float32x4_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+// De-interleaving load: val[j][i] = p[4 * i + j]
+inline float32x4x4_t vld4q_f32(const float* p) {
+  float32x4x4_t v;
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j) v.val[j][i] = p[4 * i + j];
+  return v;
+}
+
+inline float32x4_t vdupq_n_f32(const float f) {
+  float32x4_t v = {f, f, f, f};
+  return v;
+}
+
+inline float32x4_t vaddq_f32(const float32x4_t a, const float32x4_t b) {
+  return a + b;
+}
+
+inline float32x4_t vmulq_f32(const float32x4_t a, const float32x4_t b) {
+  return a * b;
+}
+
+inline float32x4_t vmulq_n_f32(const float32x4_t a, const float f) {
+  return a * vdupq_n_f32(f);
+}
+
+// Reverses the lanes within each 64 bit half: (1 0 3 2)
+inline float32x4_t vrev64q_f32(const float32x4_t a) {
+  float32x4_t v = {a[1], a[0], a[3], a[2]};
+  return v;
+}
+
+inline float32x2_t vget_low_f32(const float32x4_t a) {
+  float32x2_t v = {a[0], a[1]};
+  return v;
+}
+
+inline float32x2_t vget_high_f32(const float32x4_t a) {
+  float32x2_t v = {a[2], a[3]};
+  return v;
+}
+
+inline float32x4_t vcombine_f32(const float32x2_t low, const float32x2_t high) {
+  float32x4_t v = {low[0], low[1], high[0], high[1]};
+  return v;
+}
+
+#endif /* VECMATH_TEST_ARM_NEON_H_ */
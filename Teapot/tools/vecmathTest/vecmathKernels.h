@@ -0,0 +1,66 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathKernels.h
+// The vecmath operations under test, as plain functions on float arrays, so
+// that vecmathTest.cpp can run the SIMD and the scalar builds of vecmath.cpp
+// side by side in one program.
+//--------------------------------------------------------------------------------
+#ifndef VECMATH_KERNELS_H_
+#define VECMATH_KERNELS_H_
+
+#include <stdint.h>
+
+struct VecmathKernels {
+  const char* name_;
+
+  // Matrices are 16 column major floats, vectors and quaternions 4 floats
+  // (x, y, z, w). The operands are copied to addresses that are only 4 byte
+  // aligned, as they may be inside a std::vector or a heap object.
+  void (*mat4_mul_)(const float* a, const float* b, float* out);
+  void (*mat4_mul_vec4_)(const float* m, const float* v, float* out);
+  void (*vec4_mul_mat4_)(const float* v, const float* m, float* out);
+  void (*quaternion_mul_)(const float* a, const float* b, float* out);
+  bool (*mat4_inverse_general_)(const float* m, float* out);
+  // Mat4::NormalMatrix(), 9 column major floats out
+  void (*mat4_normal_matrix_)(const float* m, float* out);
+  // Mat4::Decompose(): translation, quaternion and scale out
+  bool (*mat4_decompose_)(const float* m, float* translation, float* rotation,
+                          float* scale);
+
+  // Benchmarks: |count| independent chains of products, |rounds| long, from
+  // the given rotations (16 floats each) or unit quaternions (4 floats each).
+  // Return a sum of the results so the work cannot be optimized away.
+  float (*bench_mat4_mul_)(const float* mats, const int32_t count,
+                           const int32_t rounds);
+  float (*bench_mat4_mul_vec4_)(const float* mats, const int32_t count,
+                                const int32_t rounds);
+  float (*bench_quaternion_mul_)(const float* quats, const int32_t count,
+                                 const int32_t rounds);
+  // Each matrix inverted |rounds| times over; the matrices must be well
+  // conditioned
+  float (*bench_mat4_inverse_general_)(const float* mats, const int32_t count,
+                                       const int32_t rounds);
+};
+
+// vecmathSimd.cpp: vecmath.cpp as the app builds it (NEON, SSE or scalar,
+// depending on the target)
+extern const VecmathKernels SIMD_KERNELS;
+// vecmathScalar.cpp: vecmath.cpp built with VECMATH_NO_SIMD
+extern const VecmathKernels SCALAR_KERNELS;
+
+#endif /* VECMATH_KERNELS_H_ */
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathKernels.inl
+// Body of the VecmathKernels table, included by vecmathSimd.cpp and
+// vecmathScalar.cpp right after vecmath.cpp, with VECMATH_KERNELS set to the
+// name of the table to define.
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "vecmathKernels.h"
+
+namespace {
+
+using ndk_helper::Mat4;
+using ndk_helper::Quaternion;
+using ndk_helper::Vec4;
+
+// Storage for one object at an address that is 4 but not 8 byte aligned
+template <typename T>
+struct Misaligned {
+  union {
+    double align_;
+    char bytes_[sizeof(T) + 8];
+  };
+  T* Ptr() { return reinterpret_cast<T*>(bytes_ + 4); }
+};
+
+void Mat4Mul(const float* a, const float* b, float* out) {
+  Misaligned<Mat4> ma, mb;
+  new (ma.Ptr()) Mat4(a);
+  new (mb.Ptr()) Mat4(b);
+  Mat4 r = *ma.Ptr() * *mb.Ptr();
+  memcpy(out, r.Ptr(), 16 * sizeof(float));
+}
+
+void Mat4MulVec4(const float* m, const float* v, float* out) {
+  Misaligned<Mat4> mm;
+  Misaligned<Vec4> mv;
+  new (mm.Ptr()) Mat4(m);
+  new (mv.Ptr()) Vec4(v[0], v[1], v[2], v[3]);
+  Vec4 r = *mm.Ptr() * *mv.Ptr();
+  r.Value(out[0], out[1], out[2], out[3]);
+}
+
+void Vec4MulMat4(const float* v, const float* m, float* out) {
+  Misaligned<Mat4> mm;
+  Misaligned<Vec4> mv;
+  new (mm.Ptr()) Mat4(m);
+  new (mv.Ptr()) Vec4(v[0], v[1], v[2], v[3]);
+  Vec4 r = *mv.Ptr() * *mm.Ptr();
+  r.Value(out[0], out[1], out[2], out[3]);
+}
+
+void QuaternionMul(const float* a, const float* b, float* out) {
+  Misaligned<Quaternion> qa, qb;
+  new (qa.Ptr()) Quaternion(a[0], a[1], a[2], a[3]);
+  new (qb.Ptr()) Quaternion(b[0], b[1], b[2], b[3]);
+  Quaternion r = *qa.Ptr() * *qb.Ptr();
+  r.Value(out[0], out[1], out[2], out[3]);
+}
+
+bool Mat4InverseGeneral(const float* m, float* out) {
+  Mat4 inverse;
+  if (!Mat4(m).InverseGeneral(inverse)) return false;
+  memcpy(out, inverse.Ptr(), 16 * sizeof(float));
+  return true;
+}
+
+void Mat4NormalMatrix(const float* m, float* out) {
+  ndk_helper::Mat3 normal = Mat4(m).NormalMatrix();
+  memcpy(out, normal.Ptr(), 9 * sizeof(float));
+}
+
+bool Mat4Decompose(const float* m, float* translation, float* rotation,
+                   float* scale) {
+  ndk_helper::Vec3 t, s;
+  Quaternion q;
+  if (!Mat4(m).Decompose(t, q, s)) return false;
+  t.Value(translation[0], translation[1], translation[2]);
+  q.Value(rotation[0], rotation[1], rotation[2], rotation[3]);
+  s.Value(scale[0], scale[1], scale[2]);
+  return true;
+}
+
+float BenchMat4Mul(const float* mats, const int32_t count,
+                   const int32_t rounds) {
+  std::vector<Mat4> m, acc(count, Mat4::Identity());
+  for (int32_t i = 0; i < count; ++i) m.push_back(Mat4(mats + i * 16));
+  for (int32_t r = 0; r < rounds; ++r)
+    for (int32_t i = 0; i < count; ++i) acc[i] = acc[i] * m[i];
+  float sum = 0.f;
+  for (int32_t i = 0; i < count; ++i) sum += acc[i].Ptr()[0];
+  return sum;
+}
+
+float BenchMat4MulVec4(const float* mats, const int32_t count,
+                       const int32_t rounds) {
+  std::vector<Mat4> m;
+  std::vector<Vec4> acc(count, Vec4(1.f, 0.f, 0.f, 1.f));
+  for (int32_t i = 0; i < count; ++i) m.push_back(Mat4(mats + i * 16));
+  for (int32_t r = 0; r < rounds; ++r)
+    for (int32_t i = 0; i < count; ++i) acc[i] = m[i] * acc[i];
+  float sum = 0.f;
+  for (int32_t i = 0; i < count; ++i) {
+    float x, y, z, w;
+    acc[i].Value(x, y, z, w);
+    sum += x;
+  }
+  return sum;
+}
+
+float BenchQuaternionMul(const float* quats, const int32_t count,
+                         const int32_t rounds) {
+  std::vector<Quaternion> q, acc(count);
+  for (int32_t i = 0; i < count; ++i) {
+    const float* p = quats + i * 4;
+    q.push_back(Quaternion(p[0], p[1], p[2], p[3]));
+  }
+  for (int32_t r = 0; r < rounds; ++r)
+    for (int32_t i = 0; i < count; ++i) acc[i] = acc[i] * q[i];
+  float sum = 0.f;
+  for (int32_t i = 0; i < count; ++i) {
+    float x, y, z, w;
+    acc[i].Value(x, y, z, w);
+    sum += w;
+  }
+  return sum;
+}
+
+float BenchMat4InverseGeneral(const float* mats, const int32_t count,
+                              const int32_t rounds) {
+  std::vector<Mat4> acc;
+  for (int32_t i = 0; i < count; ++i) acc.push_back(Mat4(mats + i * 16));
+  for (int32_t r = 0; r < rounds; ++r) {
+    for (int32_t i = 0; i < count; ++i) {
+      Mat4 inverse;
+      acc[i].InverseGeneral(inverse);
+      acc[i] = inverse;
+    }
+  }
+  float sum = 0.f;
+  for (int32_t i = 0; i < count; ++i) sum += acc[i].Ptr()[0];
+  return sum;
+}
+
+}  // namespace
+
+extern const VecmathKernels VECMATH_KERNELS = {
+    VECMATH_KERNELS_NAME,
+    Mat4Mul,
+    Mat4MulVec4,
+    Vec4MulMat4,
+    QuaternionMul,
+    Mat4InverseGeneral,
+    Mat4NormalMatrix,
+    Mat4Decompose,
+    BenchMat4Mul,
+    BenchMat4MulVec4,
+    BenchQuaternionMul,
+    BenchMat4InverseGeneral,
+};
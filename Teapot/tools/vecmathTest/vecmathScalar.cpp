@@ -0,0 +1,28 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathScalar.cpp
+// vecmath.cpp built with VECMATH_NO_SIMD, in a namespace of its own so that it
+// links next to the SIMD build, wrapped for vecmathTest.cpp
+//--------------------------------------------------------------------------------
+#define VECMATH_NO_SIMD
+#define ndk_helper vecmath_scalar
+#include "vecmath.cpp"
+
+#define VECMATH_KERNELS_NAME "scalar"
+#define VECMATH_KERNELS SCALAR_KERNELS
+#include "vecmathKernels.inl"
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathSimd.cpp
+// vecmath.cpp as the app builds it, wrapped for vecmathTest.cpp
+//--------------------------------------------------------------------------------
+#include "vecmath.cpp"
+
+#if defined(VECMATH_USE_NEON)
+#define VECMATH_KERNELS_NAME "NEON"
+#elif defined(VECMATH_USE_SSE)
+#define VECMATH_KERNELS_NAME "SSE"
+#else
+#define VECMATH_KERNELS_NAME "scalar"
+#endif
+#define VECMATH_KERNELS SIMD_KERNELS
+#include "vecmathKernels.inl"
@@ -0,0 +1,538 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmathTest.cpp
+// Host test and benchmark for the SIMD code in ndk_helper vecmath.cpp: Mat4 *
+// Mat4, Mat4 * Vec4, Vec4 * Mat4 and Quaternion * Quaternion must give the
+// same bits as the scalar build (VECMATH_NO_SIMD), and both must match a
+// double precision reference. Mat4::InverseGeneral() must agree with the
+// scalar cofactor version and invert well conditioned matrices, and reject
+// singular ones. Operands sit at 4 byte aligned addresses, as they may in a
+// std::vector or on the heap.
+//
+// InverseGeneral() (both builds) and NormalMatrix() are then checked against
+// double precision Gauss-Jordan inverses: the error must stay within a few
+// cond(M) * FLT_EPSILON. Decompose() must recover the translation, rotation
+// and scale of random (and mirrored) TRS matrices.
+//
+// Last, times the products and InverseGeneral() of both builds.
+//
+// Build and run on the host, from this directory:
+//  NDK_HELPER=../../app/src/main/jni/ndk_helper
+//  g++ -O2 -ffp-contract=off -I$NDK_HELPER -o vecmathTest vecmathTest.cpp
+//  vecmathSimd.cpp vecmathScalar.cpp
+//  ./vecmathTest [rounds]
+// x86 builds test the SSE code. To test the NEON code on the same machine,
+// add -D__ARM_NEON -Ineon: neon/arm_neon.h emulates the intrinsics vecmath
+// uses, so this checks the lane arithmetic but not the code an ARM compiler
+// makes of it, and its timings mean nothing.
+//
+// -ffp-contract=off keeps the compiler from fusing the scalar multiplies and
+// adds, which the SIMD code never does; without it the two builds may differ
+// in the last bit.
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "vecmathKernels.h"
+
+namespace {
+
+const int32_t CASES = 20000;
+const int32_t BENCH_COUNT = 256;
+const int32_t DEFAULT_ROUNDS = 2000;
+const int32_t BENCH_RUNS = 4;
+
+// Relative to the sum of the magnitudes of the terms, for the products
+const double PRODUCT_TOLERANCE = 4.0 * 1.1920929e-7;
+// For inverses of the well conditioned matrices of TestInverse()
+const double INVERSE_TOLERANCE = 1e-4;
+// In units of cond(M) * FLT_EPSILON, see TestInversePrecision()
+const double INVERSE_MAX_SCALED_ERROR = 8.0;
+const double NORMAL_MAX_SCALED_ERROR = 8.0;
+// Relative to the translation range, scale and rotation
+const double DECOMPOSE_MAX_ERROR = 1e-5;
+
+int32_t g_failures = 0;
+
+void Fail(const char* what, const int32_t test_case) {
+  if (++g_failures <= 10) printf("  %s: case %d is wrong\n", what, test_case);
+}
+
+//--------------------------------------------------------------------------------
+// Inputs
+//--------------------------------------------------------------------------------
+uint32_t g_seed = 12345;
+
+float Random() {
+  g_seed = g_seed * 1664525u + 1013904223u;
+  return (g_seed >> 8) * (1.f / 16777216.f);
+}
+
+// Spread over a few binades either side of 1, with either sign
+float RandomValue() {
+  float v = ldexpf(0.5f + Random(), (int)(Random() * 12.f) - 6);
+  return Random() < 0.5f ? -v : v;
+}
+
+void RandomArray(float* out, const int32_t count) {
+  for (int32_t i = 0; i < count; ++i) out[i] = RandomValue();
+}
+
+void RandomQuaternion(float* q) {
+  float len = 0.f;
+  for (int32_t i = 0; i < 4; ++i) {
+    q[i] = Random() * 2.f - 1.f;
+    len += q[i] * q[i];
+  }
+  len = sqrtf(len);
+  for (int32_t i = 0; i < 4; ++i) q[i] /= len;
+}
+
+// Column major rotation for a unit quaternion
+void RotationMatrix(const float* q, float* m) {
+  const float x = q[0], y = q[1], z = q[2], w = q[3];
+  const float r[16] = {1 - 2 * (y * y + z * z), 2 * (x * y + z * w),
+                       2 * (x * z - y * w),     0,
+                       2 * (x * y - z * w),     1 - 2 * (x * x + z * z),
+                       2 * (y * z + x * w),     0,
+                       2 * (x * z + y * w),     2 * (y * z - x * w),
+                       1 - 2 * (x * x + y * y), 0,
+                       0,                       0,
+                       0,                       1};
+  memcpy(m, r, sizeof(r));
+}
+
+//--------------------------------------------------------------------------------
+// Double precision references. Each result is returned with the sum of the
+// magnitudes of its terms, which bounds its float rounding error.
+//--------------------------------------------------------------------------------
+void RefMat4Mul(const float* a, const float* b, double* out, double* mag) {
+  for (int32_t c = 0; c < 4; ++c)
+    for (int32_t r = 0; r < 4; ++r) {
+      out[c * 4 + r] = mag[c * 4 + r] = 0.0;
+      for (int32_t k = 0; k < 4; ++k) {
+        double t = (double)a[k * 4 + r] * b[c * 4 + k];
+        out[c * 4 + r] += t;
+        mag[c * 4 + r] += fabs(t);
+      }
+    }
+}
+
+// Column vector: out = m * v
+void RefMat4MulVec4(const float* m, const float* v, double* out,
+                    double* mag) {
+  for (int32_t r = 0; r < 4; ++r) {
+    out[r] = mag[r] = 0.0;
+    for (int32_t k = 0; k < 4; ++k) {
+      double t = (double)m[k * 4 + r] * v[k];
+      out[r] += t;
+      mag[r] += fabs(t);
+    }
+  }
+}
+
+// Row vector: out = v * m
+void RefVec4MulMat4(const float* v, const float* m, double* out,
+                    double* mag) {
+  for (int32_t c = 0; c < 4; ++c) {
+    out[c] = mag[c] = 0.0;
+    for (int32_t k = 0; k < 4; ++k) {
+      double t = (double)v[k] * m[c * 4 + k];
+      out[c] += t;
+      mag[c] += fabs(t);
+    }
+  }
+}
+
+// Hamilton product, (x, y, z, w) order
+void RefQuaternionMul(const float* a, const float* b, double* out,
+                      double* mag) {
+  const double t[4][4] = {
+      {(double)a[0] * b[3], (double)a[1] * b[2], -(double)a[2] * b[1],
+       (double)a[3] * b[0]},
+      {-(double)a[0] * b[2], (double)a[1] * b[3], (double)a[2] * b[0],
+       (double)a[3] * b[1]},
+      {(double)a[0] * b[1], -(double)a[1] * b[0], (double)a[2] * b[3],
+       (double)a[3] * b[2]},
+      {-(double)a[0] * b[0], -(double)a[1] * b[1], -(double)a[2] * b[2],
+       (double)a[3] * b[3]},
+  };
+  for (int32_t i = 0; i < 4; ++i) {
+    out[i] = mag[i] = 0.0;
+    for (int32_t k = 0; k < 4; ++k) {
+      out[i] += t[i][k];
+      mag[i] += fabs(t[i][k]);
+    }
+  }
+}
+
+// Gauss-Jordan with partial pivoting, on an n x n column major matrix.
+// Returns false if the matrix is singular.
+bool RefInverse(const float* m, const int32_t n, double* out) {
+  double a[4][8];
+  for (int32_t r = 0; r < n; ++r)
+    for (int32_t c = 0; c < n; ++c) {
+      a[r][c] = m[c * n + r];
+      a[r][n + c] = r == c ? 1.0 : 0.0;
+    }
+  for (int32_t c = 0; c < n; ++c) {
+    int32_t pivot = c;
+    for (int32_t r = c + 1; r < n; ++r)
+      if (fabs(a[r][c]) > fabs(a[pivot][c])) pivot = r;
+    if (a[pivot][c] == 0.0) return false;
+    for (int32_t k = 0; k < 2 * n; ++k) {
+      double t = a[c][k];
+      a[c][k] = a[pivot][k];
+      a[pivot][k] = t;
+    }
+    double rcp = 1.0 / a[c][c];
+    for (int32_t k = 0; k < 2 * n; ++k) a[c][k] *= rcp;
+    for (int32_t r = 0; r < n; ++r) {
+      if (r == c) continue;
+      double f = a[r][c];
+      for (int32_t k = 0; k < 2 * n; ++k) a[r][k] -= f * a[c][k];
+    }
+  }
+  for (int32_t r = 0; r < n; ++r)
+    for (int32_t c = 0; c < n; ++c) out[c * n + r] = a[r][n + c];
+  return true;
+}
+
+// Largest absolute row sum of an n x n column major matrix
+template <typename T>
+double NormInf(const T* m, const int32_t n) {
+  double norm = 0.0;
+  for (int32_t r = 0; r < n; ++r) {
+    double sum = 0.0;
+    for (int32_t c = 0; c < n; ++c) sum += fabs((double)m[c * n + r]);
+    if (sum > norm) norm = sum;
+  }
+  return norm;
+}
+
+// Largest element error of |v| against |ref|, relative to the largest
+// element of |ref|
+double RelativeError(const float* v, const double* ref, const int32_t count) {
+  double error = 0.0, largest = 0.0;
+  for (int32_t i = 0; i < count; ++i) {
+    error = fmax(error, fabs(v[i] - ref[i]));
+    largest = fmax(largest, fabs(ref[i]));
+  }
+  return error / largest;
+}
+
+bool SameBits(const float* a, const float* b, const int32_t count) {
+  return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+bool NearReference(const float* v, const double* ref, const double* mag,
+                   const int32_t count) {
+  for (int32_t i = 0; i < count; ++i)
+    if (fabs(v[i] - ref[i]) > PRODUCT_TOLERANCE * mag[i]) return false;
+  return true;
+}
+
+//--------------------------------------------------------------------------------
+// Products
+//--------------------------------------------------------------------------------
+typedef void (*Product)(const float* a, const float* b, float* out);
+typedef void (*Reference)(const float* a, const float* b, double* out,
+                          double* mag);
+
+void TestProduct(const char* what, Product simd, Product scalar,
+                 Reference reference, const int32_t size_a,
+                 const int32_t size_b, const int32_t size_out) {
+  int32_t failures = g_failures;
+  for (int32_t n = 0; n < CASES; ++n) {
+    float a[16], b[16], simd_out[16], scalar_out[16];
+    double ref[16], mag[16];
+    RandomArray(a, size_a);
+    RandomArray(b, size_b);
+    simd(a, b, simd_out);
+    scalar(a, b, scalar_out);
+    reference(a, b, ref, mag);
+    if (!SameBits(simd_out, scalar_out, size_out)) Fail(what, n);
+    if (!NearReference(simd_out, ref, mag, size_out)) Fail(what, n);
+  }
+  printf("%-22s %s\n", what, failures == g_failures ? "ok" : "FAILED");
+}
+
+//--------------------------------------------------------------------------------
+// Inverse
+//--------------------------------------------------------------------------------
+void TestInverse() {
+  int32_t failures = g_failures;
+  for (int32_t n = 0; n < CASES; ++n) {
+    // Rotation, scaled per axis by 1 to 8, plus a translation within 4 and a
+    // small perspective-like last row: not affine, and its condition number
+    // stays below ~30
+    float q[4], m[16], simd_out[16], scalar_out[16];
+    RandomQuaternion(q);
+    RotationMatrix(q, m);
+    for (int32_t c = 0; c < 3; ++c)
+      for (int32_t r = 0; r < 3; ++r) m[c * 4 + r] *= 1.f + Random() * 7.f;
+    for (int32_t r = 0; r < 3; ++r) m[12 + r] = Random() * 8.f - 4.f;
+    m[3] = Random() * 0.05f;
+    m[11] = -Random() * 0.05f;
+
+    bool simd_ok = SIMD_KERNELS.mat4_inverse_general_(m, simd_out);
+    bool scalar_ok = SCALAR_KERNELS.mat4_inverse_general_(m, scalar_out);
+    if (!simd_ok || !scalar_ok) {
+      Fail("InverseGeneral", n);
+      continue;
+    }
+    // m * inverse = identity, and both builds agree
+    double ref[16], mag[16];
+    RefMat4Mul(m, simd_out, ref, mag);
+    for (int32_t i = 0; i < 16; ++i) {
+      double identity = i % 5 == 0 ? 1.0 : 0.0;
+      double scale = fabs(scalar_out[i]) > 1.0 ? fabs(scalar_out[i]) : 1.0;
+      if (fabs(ref[i] - identity) > INVERSE_TOLERANCE ||
+          fabs(simd_out[i] - scalar_out[i]) > INVERSE_TOLERANCE * scale) {
+        Fail("InverseGeneral", n);
+        break;
+      }
+    }
+  }
+
+  // Singular: integer matrices, so every determinant term is exact and the
+  // determinant is exactly zero
+  for (int32_t n = 0; n < 1000; ++n) {
+    float m[16], out[16];
+    for (int32_t i = 0; i < 16; ++i) m[i] = (float)((int)(Random() * 9.f) - 4);
+    int32_t c0 = n % 4, c1 = (n / 4 + 1 + n) % 4;
+    if (c0 == c1) c1 = (c1 + 1) % 4;
+    if (n & 1)
+      memcpy(m + c1 * 4, m + c0 * 4, 4 * sizeof(float));  // Equal columns
+    else
+      for (int32_t c = 0; c < 4; ++c) m[c * 4 + c1] = 0.f;  // Zero row
+    if (SIMD_KERNELS.mat4_inverse_general_(m, out) ||
+        SCALAR_KERNELS.mat4_inverse_general_(m, out))
+      Fail("InverseGeneral singular", n);
+  }
+  printf("%-22s %s\n", "InverseGeneral",
+         failures == g_failures ? "ok" : "FAILED");
+}
+
+//--------------------------------------------------------------------------------
+// Precision against double references
+// Errors are measured in units of cond(M) * FLT_EPSILON, cond(M) being the
+// infinity norm condition number: what a backward stable float algorithm
+// gets. Random matrices cover condition numbers up to the thousands.
+//--------------------------------------------------------------------------------
+const double FLT_EPS = 1.1920929e-7;
+
+void TestInversePrecision(const VecmathKernels& kernels) {
+  int32_t failures = g_failures;
+  double sum_error = 0.0, max_scaled = 0.0;
+  int32_t tested = 0;
+  for (int32_t n = 0; n < CASES; ++n) {
+    float m[16], out[16];
+    double ref[16];
+    for (int32_t i = 0; i < 16; ++i) m[i] = Random() * 2.f - 1.f;
+    if (!RefInverse(m, 4, ref)) continue;
+    const double cond = NormInf(m, 4) * NormInf(ref, 4);
+    if (cond > 1e4) continue;  // Too close to singular for floats
+    if (!kernels.mat4_inverse_general_(m, out)) {
+      Fail("InverseGeneral precision", n);
+      continue;
+    }
+    const double error = RelativeError(out, ref, 16);
+    const double scaled = error / (cond * FLT_EPS);
+    sum_error += error;
+    max_scaled = fmax(max_scaled, scaled);
+    ++tested;
+    if (scaled > INVERSE_MAX_SCALED_ERROR) Fail("InverseGeneral precision", n);
+  }
+  char what[32];
+  snprintf(what, sizeof(what), "Inverse %s", kernels.name_);
+  printf("%-22s %s  mean error %.1e, max %.2f cond eps\n", what,
+         failures == g_failures ? "ok" : "FAILED", sum_error / tested,
+         max_scaled);
+}
+
+void TestNormalMatrix() {
+  int32_t failures = g_failures;
+  double sum_error = 0.0, max_scaled = 0.0;
+  int32_t tested = 0;
+  for (int32_t n = 0; n < CASES; ++n) {
+    float m[16], upper[9], out[9];
+    double inverse[9], ref[9];
+    for (int32_t i = 0; i < 16; ++i) m[i] = Random() * 2.f - 1.f;
+    for (int32_t c = 0; c < 3; ++c)
+      for (int32_t r = 0; r < 3; ++r) upper[c * 3 + r] = m[c * 4 + r];
+    if (!RefInverse(upper, 3, inverse)) continue;
+    const double cond = NormInf(upper, 3) * NormInf(inverse, 3);
+    if (cond > 1e4) continue;
+    for (int32_t c = 0; c < 3; ++c)
+      for (int32_t r = 0; r < 3; ++r) ref[c * 3 + r] = inverse[r * 3 + c];
+    SIMD_KERNELS.mat4_normal_matrix_(m, out);
+    const double error = RelativeError(out, ref, 9);
+    const double scaled = error / (cond * FLT_EPS);
+    sum_error += error;
+    max_scaled = fmax(max_scaled, scaled);
+    ++tested;
+    if (scaled > NORMAL_MAX_SCALED_ERROR) Fail("NormalMatrix", n);
+  }
+  printf("%-22s %s  mean error %.1e, max %.2f cond eps\n", "NormalMatrix",
+         failures == g_failures ? "ok" : "FAILED", sum_error / tested,
+         max_scaled);
+}
+
+void TestDecompose() {
+  int32_t failures = g_failures;
+  double max_error = 0.0;
+  for (int32_t n = 0; n < CASES; ++n) {
+    // T * R * S, scales 1/4 to 4, every other one mirrored in some axis
+    float t[3], q[4], scale[3], m[16];
+    RandomQuaternion(q);
+    RotationMatrix(q, m);
+    for (int32_t c = 0; c < 3; ++c) {
+      t[c] = Random() * 200.f - 100.f;
+      scale[c] = ldexpf(1.f + Random(), (int)(Random() * 4.f) - 2);
+    }
+    const bool mirror = n & 1;
+    if (mirror) scale[n / 2 % 3] = -scale[n / 2 % 3];
+    for (int32_t c = 0; c < 3; ++c) {
+      for (int32_t r = 0; r < 3; ++r) m[c * 4 + r] *= scale[c];
+      m[12 + c] = t[c];
+    }
+
+    float dt[3], dq[4], ds[3], r[16];
+    if (!SIMD_KERNELS.mat4_decompose_(m, dt, dq, ds)) {
+      Fail("Decompose", n);
+      continue;
+    }
+    // Translation as is; scales up to the sign, which goes to x when
+    // mirrored; a unit quaternion that recomposes the matrix
+    double error = 0.0, qlen = 0.0;
+    for (int32_t c = 0; c < 3; ++c) {
+      error = fmax(error, fabs(dt[c] - t[c]) / 100.0);
+      error = fmax(error, fabs(fabs(ds[c]) - fabs(scale[c])) / fabs(scale[c]));
+    }
+    for (int32_t i = 0; i < 4; ++i) qlen += (double)dq[i] * dq[i];
+    error = fmax(error, fabs(sqrt(qlen) - 1.0));
+    RotationMatrix(dq, r);
+    for (int32_t c = 0; c < 3; ++c)
+      for (int32_t row = 0; row < 3; ++row)
+        error = fmax(error, fabs(r[c * 4 + row] * ds[c] - m[c * 4 + row]) /
+                                fabs(ds[c]));
+    max_error = fmax(max_error, error);
+    if (error > DECOMPOSE_MAX_ERROR || (ds[0] < 0.f) != mirror ||
+        ds[1] < 0.f || ds[2] < 0.f)
+      Fail("Decompose", n);
+  }
+
+  // No scale along an axis: nothing to recover
+  float m[16], t[3], q[4], scale[3];
+  RandomQuaternion(q);
+  RotationMatrix(q, m);
+  for (int32_t r = 0; r < 3; ++r) m[4 + r] = 0.f;
+  if (SIMD_KERNELS.mat4_decompose_(m, t, q, scale)) Fail("Decompose", -1);
+
+  printf("%-22s %s  max error %.1e\n", "Decompose",
+         failures == g_failures ? "ok" : "FAILED", max_error);
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+double NowMs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+typedef float (*Bench)(const float* data, const int32_t count,
+                       const int32_t rounds);
+
+void RunBench(const char* what, Bench simd, Bench scalar, const float* data,
+              const int32_t rounds, const bool same_bits = true) {
+  double ns[2];
+  float sums[2];
+  Bench benches[2] = {simd, scalar};
+  for (int32_t b = 0; b < 2; ++b) {
+    // Best of a few runs, the first one warming up
+    ns[b] = HUGE_VAL;
+    for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+      double start = NowMs();
+      sums[b] = benches[b](data, BENCH_COUNT, rounds);
+      ns[b] = fmin(ns[b], (NowMs() - start) * 1e6 /
+                              ((double)BENCH_COUNT * rounds));
+    }
+  }
+  // Same operations in the same order: the chains must end on the same bits
+  if (same_bits && memcmp(&sums[0], &sums[1], sizeof(float))) {
+    printf("  %s: SIMD and scalar chains differ (%g, %g)\n", what, sums[0],
+           sums[1]);
+    ++g_failures;
+  }
+  printf("%-22s %8.2f ns %8.2f ns  x%.2f\n", what, ns[0], ns[1],
+         ns[1] / ns[0]);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int32_t rounds = argc > 1 ? atoi(argv[1]) : DEFAULT_ROUNDS;
+  if (rounds < 10) {
+    printf("usage: %s [rounds]\n", argv[0]);
+    return 1;
+  }
+
+  printf("SIMD build: %s\n", SIMD_KERNELS.name_);
+  TestProduct("Mat4 * Mat4", SIMD_KERNELS.mat4_mul_, SCALAR_KERNELS.mat4_mul_,
+              RefMat4Mul, 16, 16, 16);
+  TestProduct("Mat4 * Vec4", SIMD_KERNELS.mat4_mul_vec4_,
+              SCALAR_KERNELS.mat4_mul_vec4_, RefMat4MulVec4, 16, 4, 4);
+  TestProduct("Vec4 * Mat4", SIMD_KERNELS.vec4_mul_mat4_,
+              SCALAR_KERNELS.vec4_mul_mat4_, RefVec4MulMat4, 4, 16, 4);
+  TestProduct("Quaternion * Quat", SIMD_KERNELS.quaternion_mul_,
+              SCALAR_KERNELS.quaternion_mul_, RefQuaternionMul, 4, 4, 4);
+  TestInverse();
+  TestInversePrecision(SIMD_KERNELS);
+  TestInversePrecision(SCALAR_KERNELS);
+  TestNormalMatrix();
+  TestDecompose();
+
+  std::vector<float> mats(BENCH_COUNT * 16), quats(BENCH_COUNT * 4);
+  for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+    RandomQuaternion(&quats[i * 4]);
+    RotationMatrix(&quats[i * 4], &mats[i * 16]);
+  }
+  printf("\n%-22s %11s %11s\n", "per product", SIMD_KERNELS.name_, "scalar");
+  RunBench("Mat4 * Mat4", SIMD_KERNELS.bench_mat4_mul_,
+           SCALAR_KERNELS.bench_mat4_mul_, &mats[0], rounds);
+  RunBench("Mat4 * Vec4", SIMD_KERNELS.bench_mat4_mul_vec4_,
+           SCALAR_KERNELS.bench_mat4_mul_vec4_, &mats[0], rounds);
+  RunBench("Quaternion * Quat", SIMD_KERNELS.bench_quaternion_mul_,
+           SCALAR_KERNELS.bench_quaternion_mul_, &quats[0], rounds);
+  // Different algorithms: the results only agree to rounding
+  RunBench("InverseGeneral", SIMD_KERNELS.bench_mat4_inverse_general_,
+           SCALAR_KERNELS.bench_mat4_inverse_general_, &mats[0], rounds,
+           false);
+
+  printf("\n%s\n", g_failures ? "FAILED" : "OK");
+  return g_failures ? 1 : 0;
+}
@@ -46,7 +46,7 @@ public class ChoreographerNativeActivity extends NativeActivity
     @Override
     public void doFrame(long frameTimeNanos) {
         Choreographer.getInstance().postFrameCallback(this);
-        choregrapherCallback();
+        choregrapherCallback(frameTimeNanos);
     }
 
     @TargetApi(16)
@@ -56,12 +56,8 @@ public class ChoreographerNativeActivity extends NativeActivity
         use_choreographer = true;
     }
 
-    @TargetApi(16)
-    protected void stopChoreographer() {
-        use_choreographer = false;
-    }
-
-    protected native void choregrapherCallback();
+    // Hands the vsync timestamp to the native frame pacer.
+    protected native void choregrapherCallback(long frameTimeNanos);
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -19,12 +19,13 @@
 //--------------------------------------------------------------------------------
 #include <android/log.h>
 #include <android_native_app_glue.h>
-#include <condition_variable>
 #include <dlfcn.h>
 #include <EGL/egl.h>
 #include <thread>
 
+#include "FramePacer.h"
 #include "TeapotRenderer.h"
+#include "VsyncHandoff.h"
 #include "NDKHelper.h"
 //-------------------------------------------------------------------------
 // Preprocessor
@@ -40,8 +41,22 @@ enum APIMode {
   kAPIEGLExtension,
 };
 
+// Swap interval the pacer holds at least while throttled: 30 FPS at 60 Hz.
+// Otherwise it may go up to 60 FPS when frames are cheap enough.
 const int32_t kFPSThrottleInterval = 2;
-const int64_t kFPSThrottlePresentationInterval = (2.0f / 60.0f) * 1000000000;
+
+// Handoff of the Java Choreographer vsyncs to the render thread: the mutex
+// and condition variable one unless USE_FUTEX_VSYNC_HANDOFF is defined.
+#ifdef USE_FUTEX_VSYNC_HANDOFF
+typedef VsyncHandoff JavaVsyncHandoff;
+#else
+typedef CondVarVsyncHandoff JavaVsyncHandoff;
+#endif
+
+// Time the render thread spins for the Java Choreographer vsync before it
+// sleeps, with USE_FUTEX_VSYNC_HANDOFF. Spinning cuts the wake-up latency but
+// keeps a core busy, so it is off by default.
+const int64_t kVsyncSpinTime = 0;
 
 // Declaration for native chreographer API.
 struct AChoreographer;
@@ -74,7 +89,6 @@ class Engine {
   android_app* app_;
 
   APIMode api_mode_;
-  APIMode original_api_mode_;
 
   void UpdateFPS(float fFPS);
   void ShowUI();
@@ -90,7 +104,6 @@ class Engine {
 
   void StartChoreographer();
   void StartJavaChoreographer();
-  void StopJavaChoreographer();
   static void choreographer_callback(long frameTimeNanos, void* data);
 
   // Function pointers for native Choreographer API.
@@ -98,13 +111,25 @@ class Engine {
   func_AChoreographer_postFrameCallback AChoreographer_postFrameCallback_;
 
   // Stuff for EGL Android presentation time extension.
-  int64_t presentation_time_;
   bool (*eglPresentationTimeANDROID_)(EGLDisplay dpy, EGLSurface sur,
                                       khronos_stime_nanoseconds_t time);
-  int32_t render_cycle_;
+
+  // Picks the vsync every frame is presented on. Used from the render thread
+  // only.
+  FramePacer pacer_;
+  int64_t frame_start_;
   bool should_render_;
-  std::mutex mtx_;              // mutex for critical section
-  std::condition_variable cv_;  // condition variable for critical section
+
+  // Render scale, fed the CPU cost of each frame once it has been swapped.
+  ndk_helper::ResolutionController resolution_;
+  int64_t frame_cost_;
+  void UpdateRenderScale(int64_t frame_start);
+  // Render size the viewport was set for
+  int32_t viewport_width_;
+  int32_t viewport_height_;
+  void UpdateViewport();
+  JavaVsyncHandoff vsync_handoff_;  // Java Choreographer vsyncs
+  int64_t last_vsync_time_;         // last one given to pacer_
 
  public:
   static void HandleCmd(struct android_app* app, int32_t cmd);
@@ -124,7 +149,7 @@ class Engine {
 
   // Do swap operation while Choreographer callback. Need to be a public method
   // since it's called from JNI callback.
-  void SynchInCallback();
+  void SynchInCallback(int64_t frame_time);
 };
 
 // Global instance of the Engine class.
@@ -136,8 +161,12 @@ Engine::Engine()
       app_(NULL),
       fps_throttle_(true),
       api_mode_(kAPINone),
-      render_cycle_(0),
-      should_render_(true) {
+      frame_start_(0),
+      should_render_(true),
+      frame_cost_(0),
+      viewport_width_(0),
+      viewport_height_(0),
+      last_vsync_time_(0) {
   gl_context_ = ndk_helper::GLContext::GetInstance();
 }
 
@@ -177,7 +206,6 @@ void Engine::CheckAPISupport() {
         bool (*)(EGLDisplay, EGLSurface, khronos_stime_nanoseconds_t)>(
         eglGetProcAddress("eglPresentationTimeANDROID"));
     assert(eglPresentationTimeANDROID_);
-    presentation_time_ = GetCurrentTime();
   } else if (apilevel >= 16) {
     // Choreographer Java API is supported API level 16~.
     LOGI("Run with Chreographer Java API.");
@@ -185,12 +213,7 @@ void Engine::CheckAPISupport() {
   } else {
     api_mode_ = kAPINone;
   }
-  original_api_mode_ = api_mode_;
-  StartFPSThrottle();
-}
 
-void Engine::StartFPSThrottle() {
-  api_mode_ = original_api_mode_;
   if (api_mode_ == kAPINativeChoreographer) {
     // Initiate choreographer callback.
     StartChoreographer();
@@ -198,33 +221,46 @@ void Engine::StartFPSThrottle() {
     // Initiate Java choreographer callback.
     StartJavaChoreographer();
   }
+  StartFPSThrottle();
 }
 
-void Engine::StopFPSThrottle() {
-  if (api_mode_ == kAPINativeChoreographer) {
-    should_render_ = true;
-    //    ALooper_wake(app_->looper);
-  } else if (api_mode_ == kAPIJavaChoreographer) {
-    StopJavaChoreographer();
-  }
-  api_mode_ = kAPINone;
+// The pacer keeps running either way; the throttle only sets the shortest
+// swap interval it may pick.
+void Engine::StartFPSThrottle() {
+  pacer_.SetMinSwapInterval(kFPSThrottleInterval);
 }
 
+void Engine::StopFPSThrottle() { pacer_.SetMinSwapInterval(1); }
+
 void Engine::DoSwap() {
+  int64_t now = GetCurrentTime();
+  frame_cost_ = now - frame_start_;
+  if (api_mode_ != kAPINone) {
+    // The frame is ready: account its cost and pick its vsync.
+    pacer_.AddFrameCost(frame_cost_);
+    pacer_.SchedulePresent(now);
+  }
+
   if (api_mode_ == kAPINativeChoreographer) {
     // Use choreographer to synchronize.
     // Do nothing but wait the until choreographer callback.
     should_render_ = false;
   } else if (api_mode_ == kAPIJavaChoreographer) {
-    // Wait until the conditional variable is signaled.
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock);
+    // Feed the pacer the vsyncs posted by the Java thread until the frame
+    // is due. A vsync that came in while rendering is taken first.
+    do {
+      last_vsync_time_ = vsync_handoff_.Wait(last_vsync_time_, kVsyncSpinTime);
+      pacer_.AddVsync(last_vsync_time_);
+    } while (!pacer_.IsPresentDue(last_vsync_time_));
     Swap();
   } else if (api_mode_ == kAPIEGLExtension) {
-    // Use eglPresentationTimeANDROID extension.
-    presentation_time_ += kFPSThrottlePresentationInterval;
+    // Use eglPresentationTimeANDROID extension. There are no vsync
+    // timestamps in this mode, so the pacer's vsyncs are on a 60 Hz grid of
+    // its own; the compositor shows each frame on the first real vsync after
+    // its timestamp, which keeps the cadence.
     eglPresentationTimeANDROID_(gl_context_->GetDisplay(),
-                                gl_context_->GetSurface(), presentation_time_);
+                                gl_context_->GetSurface(),
+                                pacer_.GetPresentationTime());
     Swap();
   } else {
     // Regular Swap.
@@ -251,11 +287,21 @@ void Engine::choreographer_callback(long frameTimeNanos, void* data) {
     engine->StartChoreographer();
   }
 
-  // Swap buffer if the render cycle meet the condition.
+  // The callback takes a long, so 32-bit ABIs get the low 32 bits of the
+  // timestamp only. The vsync was a few milliseconds ago: take the high bits
+  // from the clock.
+  int64_t vsync_time = frameTimeNanos;
+  if (sizeof(long) < sizeof(int64_t)) {
+    int64_t now = engine->GetCurrentTime();
+    vsync_time = now - static_cast<uint32_t>(static_cast<uint32_t>(now) -
+                                             static_cast<uint32_t>(vsync_time));
+  }
+  engine->pacer_.AddVsync(vsync_time);
+
+  // Swap buffer if the rendered frame is due on this vsync.
   // The callback is in the same thread context, so that we can just invoke
   // eglSwapBuffers().
-  if (--engine->render_cycle_ <= 0) {
-    engine->render_cycle_ = kFPSThrottleInterval;
+  if (!engine->should_render_ && engine->pacer_.IsPresentDue(vsync_time)) {
     engine->should_render_ = true;
     engine->Swap();
     // Wake up main looper so that it will continue rendering.
@@ -277,31 +323,15 @@ void Engine::StartJavaChoreographer() {
   return;
 }
 
-void Engine::StopJavaChoreographer() {
-  JNIEnv* jni;
-  app_->activity->vm->AttachCurrentThread(&jni, NULL);
-  // Intiate Java Chreographer API.
-  jclass clazz = jni->GetObjectClass(app_->activity->clazz);
-  jmethodID methodID = jni->GetMethodID(clazz, "stopChoreographer", "()V");
-  jni->CallVoidMethod(app_->activity->clazz, methodID);
-  app_->activity->vm->DetachCurrentThread();
-  // Make sure the render thread is not blocked.
-  cv_.notify_one();
-  return;
+void Engine::SynchInCallback(int64_t frame_time) {
+  // Hand the vsync over to the render thread, which decides on the swap.
+  vsync_handoff_.Post(frame_time);
 }
 
-void Engine::SynchInCallback() {
-  // Signal render thread if the render cycle meet the condition.
-  if (--render_cycle_ <= 0) {
-    render_cycle_ = kFPSThrottleInterval;
-    cv_.notify_one();
-  }
-};
-
 extern "C" JNIEXPORT void JNICALL
 Java_com_sample_choreographer_ChoreographerNativeActivity_choregrapherCallback(
-    JNIEnv* env, jobject instance) {
-  g_engine.SynchInCallback();
+    JNIEnv* env, jobject instance, jlong frame_time_nanos) {
+  g_engine.SynchInCallback(frame_time_nanos);
 }
 
 // Helper functions.
@@ -356,9 +386,7 @@ int Engine::InitDisplay() {
   glDepthFunc(GL_LEQUAL);
 
   // Note that screen size might have been changed
-  glViewport(0, 0, gl_context_->GetScreenWidth(),
-             gl_context_->GetScreenHeight());
-  renderer_.UpdateViewport();
+  UpdateViewport();
 
   tap_camera_.SetFlip(1.f, -1.f, -1.f);
   tap_camera_.SetPinchTransformFactor(2.f, 2.f, 8.f);
@@ -370,6 +398,9 @@ int Engine::InitDisplay() {
  * Just the current frame in the display.
  */
 void Engine::DrawFrame() {
+  int64_t frame_start = GetCurrentTime();
+  UpdateRenderScale(frame_start);
+  frame_start_ = frame_start;
   float fps;
   if (monitor_.Update(fps)) {
     UpdateFPS(fps);
@@ -385,6 +416,43 @@ void Engine::DrawFrame() {
   DoSwap();
 }
 
+/**
+ * Fit the viewport to a render size the last swap brought, and feed the
+ * previous frame to the resolution controller. This runs before the next
+ * frame is rendered rather than right after DoSwap(): with the native
+ * Choreographer the swap happens later, in the callback.
+ */
+void Engine::UpdateRenderScale(int64_t frame_start) {
+  if (gl_context_->GetRenderWidth() != viewport_width_ ||
+      gl_context_->GetRenderHeight() != viewport_height_) {
+    UpdateViewport();
+  }
+  if (!frame_start_) return;
+  // The target is the frame time of the throttle, not of the cadence the
+  // pacer fell back to: a frame that missed it counts as too slow.
+  resolution_.SetTargetFrameTime(pacer_.GetVsyncPeriod() *
+                                 pacer_.GetMinSwapInterval());
+  if (!resolution_.Update(frame_cost_, frame_start - frame_start_)) return;
+
+  if (!gl_context_->SetRenderScale(resolution_.GetScale())) {
+    // The window keeps the buffer size it has
+    resolution_.HoldScale(gl_context_->GetRenderScale());
+    return;
+  }
+  LOGI("Render scale %.2f", resolution_.GetScale());
+}
+
+/**
+ * Fit the viewport and projection to the render size.
+ */
+void Engine::UpdateViewport() {
+  viewport_width_ = gl_context_->GetRenderWidth();
+  viewport_height_ = gl_context_->GetRenderHeight();
+  glViewport(0, 0, viewport_width_, viewport_height_);
+  renderer_.UpdateViewport();
+  LOGI("Viewport %dx%d", viewport_width_, viewport_height_);
+}
+
 /**
  * Tear down the EGL context currently associated with the display.
  */
@@ -487,8 +555,8 @@ void Engine::HandleCmd(struct android_app* app, int32_t cmd) {
       // Start animation
       eng->has_focus_ = true;
 
-      // Update counter when the app becomes active.
-      eng->presentation_time_ = eng->GetCurrentTime();
+      // The display may have changed while in the background.
+      eng->pacer_.Reset();
       if (eng->api_mode_ == kAPINativeChoreographer) {
         eng->StartChoreographer();
       }
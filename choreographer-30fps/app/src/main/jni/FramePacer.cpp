@@ -0,0 +1,400 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// FramePacer.cpp
+//--------------------------------------------------------------------------------
+#include "FramePacer.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+// Assumed until the fit locks.
+const int64_t kDefaultVsyncPeriod = 1000000000 / 60;
+// Refresh rates outside of 20..250 Hz are taken as a bad fit.
+const double kMinVsyncPeriod = 4000000.0;
+const double kMaxVsyncPeriod = 50000000.0;
+// Samples needed before the fit is trusted.
+const int32_t kMinVsyncSamples = 24;
+// Samples on the fitted line, no further from it than kMaxFitResidual
+// periods, must be this many percent of all of them to lock, and to stay
+// locked. Late callbacks are off the line; a period 1.5 times the fitted one
+// puts every other sample half a period off.
+const double kMaxFitResidual = 0.125;
+const int32_t kLockFitSamples = 66;
+const int32_t kKeepFitSamples = 55;
+// Largest distance of a gap to a whole number of periods, in periods, for
+// the gap to count when the period is seeded.
+const double kMaxGapError = 0.125;
+// Samples numbered by their gaps when the period is seeded, and the percent
+// of them that must be on their line, no further from it than
+// kMaxChainResidual periods: all but one. The line of so few samples is
+// easily pulled off by a late one, hence the tighter residual.
+const int32_t kChainedSamples = 8;
+const int32_t kChainFitSamples = 85;
+const double kMaxChainResidual = kMaxFitResidual / 2;
+// Times the seed period is refined.
+const int32_t kSeedPasses = 2;
+// Times the samples are renumbered against the fitted line and refitted.
+const int32_t kRenumberPasses = 2;
+
+// Slow frames, the 90th percentile of the costs, pick the swap interval.
+const int32_t kSlowFramePercentile = 90;
+// Part of the interval a slow frame may take before a longer one is picked.
+const double kCostBudget = 0.9;
+// A shorter interval is picked when slow frames take less than this part of
+// it for kShorterIntervalFrames frames in a row.
+const double kCostRecovery = 0.7;
+const int32_t kShorterIntervalFrames = 60;
+
+namespace {
+
+// True when |gap| is one or more periods, give or take kMaxGapError.
+bool IsWholeGap(double gap, double period) {
+  const double periods = floor(gap / period + 0.5);
+  return periods >= 1.0 &&
+         fabs(gap - periods * period) <= kMaxGapError * period;
+}
+
+// A wrong numbering, e.g. after a refresh rate change, leaves many samples
+// further than |max_residual| periods off the fitted line.
+bool IsOnLine(const double* times, const double* numbers, int32_t count,
+              double period, double intercept, int32_t percent,
+              double max_residual) {
+  double residuals[kVsyncSamples];
+  for (int32_t i = 0; i < count; ++i) {
+    residuals[i] = fabs(times[i] - intercept - period * numbers[i]);
+  }
+  const int32_t index = count * percent / 100;
+  std::nth_element(residuals, residuals + index, residuals + count);
+  return residuals[index] <= max_residual * period;
+}
+
+// Samples on a line fitted with a fraction of the period are numbered on
+// every m-th vsync only, bar a few late ones that fit it by chance. True
+// when an eighth of the samples on the line follow the one before by a
+// single period, which no fraction gets.
+bool HasSinglePeriodGaps(const double* times, const double* numbers,
+                         int32_t count, double period, double intercept) {
+  int32_t on_line = 0;
+  int32_t single = 0;
+  double last = 0.0;
+  for (int32_t i = 0; i < count; ++i) {
+    if (fabs(times[i] - intercept - period * numbers[i]) >
+        kMaxFitResidual * period) {
+      continue;
+    }
+    if (on_line++ && numbers[i] - last == 1.0) ++single;
+    last = numbers[i];
+  }
+  return 8 * single >= on_line;
+}
+
+// The fit is taken when |percent| of the samples are on the line, numbered
+// with the period rather than a fraction of it.
+bool IsGoodFit(const double* times, const double* numbers, int32_t count,
+               double period, double intercept, int32_t percent) {
+  return IsOnLine(times, numbers, count, period, intercept, percent,
+                  kMaxFitResidual) &&
+         HasSinglePeriodGaps(times, numbers, count, period, intercept);
+}
+
+}  // namespace
+
+FramePacer::FramePacer() : min_swap_interval_(1) { Reset(); }
+
+void FramePacer::Reset() {
+  vsync_count_ = 0;
+  vsync_next_ = 0;
+  phase_ = 0;
+  period_ = kDefaultVsyncPeriod;
+  locked_ = false;
+  cost_count_ = 0;
+  cost_next_ = 0;
+  swap_interval_ = min_swap_interval_;
+  shorter_interval_frames_ = 0;
+  present_time_ = 0;
+}
+
+void FramePacer::SetMinSwapInterval(int32_t interval) {
+  min_swap_interval_ = std::min(std::max(interval, 1), kMaxSwapInterval);
+  swap_interval_ = min_swap_interval_;
+  shorter_interval_frames_ = 0;
+}
+
+//--------------------------------------------------------------------------------
+// Vsync fit
+//--------------------------------------------------------------------------------
+void FramePacer::AddVsync(int64_t vsync_time) {
+  if (vsync_count_) {
+    int64_t last = vsyncs_[(vsync_next_ + kVsyncSamples - 1) % kVsyncSamples];
+    // A repeated timestamp, e.g. from a callback posted twice.
+    if (vsync_time <= last) return;
+    // After a pause the old samples say nothing about the phase.
+    if (vsync_time - last > kVsyncSamples * GetVsyncPeriod()) {
+      vsync_count_ = 0;
+      vsync_next_ = 0;
+    }
+  }
+  vsyncs_[vsync_next_] = vsync_time;
+  vsync_next_ = (vsync_next_ + 1) % kVsyncSamples;
+  vsync_count_ = std::min(vsync_count_ + 1, kVsyncSamples);
+
+  if (vsync_count_ < kMinVsyncSamples) {
+    // Until the fit has enough samples, the last vsync sets the phase.
+    phase_ = vsync_time;
+    return;
+  }
+  FitVsync();
+}
+
+void FramePacer::FitVsync() {
+  // Samples, oldest first and relative to the oldest one.
+  const int32_t count = vsync_count_;
+  const int32_t first = (vsync_next_ + kVsyncSamples - count) % kVsyncSamples;
+  const int64_t base = vsyncs_[first];
+  double times[kVsyncSamples];
+  for (int32_t i = 0; i < count; ++i) {
+    times[i] = static_cast<double>(vsyncs_[(first + i) % kVsyncSamples] - base);
+  }
+  double numbers[kVsyncSamples];
+  double period;
+  double intercept;
+
+  if (locked_) {
+    // Start from the last fit.
+    const double phase = static_cast<double>(phase_ - base);
+    for (int32_t i = 0; i < count; ++i) {
+      numbers[i] = floor((times[i] - phase) / period_ + 0.5);
+    }
+    if (FitLine(times, numbers, count, &period, &intercept) &&
+        IsGoodFit(times, numbers, count, period, intercept,
+                  kKeepFitSamples)) {
+      period_ = period;
+      phase_ = base + static_cast<int64_t>(floor(intercept + 0.5));
+      return;
+    }
+    locked_ = false;
+  }
+
+  // Gaps between samples are whole numbers of periods, give or take the
+  // jitter, except next to a late sample. Every fraction of the period fits
+  // the gaps at least as well as the period, and a late sample fits some
+  // fractions by chance, so the seed is the longest gap or fraction of one
+  // that fits 2/3 as many gaps as the best candidate: runs of missed
+  // callbacks do not pass for a longer period, nor late ones for a shorter
+  // one. Callbacks on every other vsync only look like a display at half the
+  // rate; once locked, the fit keeps its period through runs of them shorter
+  // than the samples.
+  double gaps[kVsyncSamples];
+  const int32_t num_gaps = count - 1;
+  for (int32_t i = 0; i < num_gaps; ++i) gaps[i] = times[i + 1] - times[i];
+  int32_t whole[kVsyncSamples][kMaxSwapInterval + 1];
+  int32_t most_whole = 0;
+  for (int32_t g = 0; g < num_gaps; ++g) {
+    for (int32_t periods = 1; periods <= kMaxSwapInterval + 1; ++periods) {
+      const double candidate = gaps[g] / periods;
+      whole[g][periods - 1] = 0;
+      if (candidate < kMinVsyncPeriod || candidate > kMaxVsyncPeriod) continue;
+      for (int32_t i = 0; i < num_gaps; ++i) {
+        if (IsWholeGap(gaps[i], candidate)) ++whole[g][periods - 1];
+      }
+      most_whole = std::max(most_whole, whole[g][periods - 1]);
+    }
+  }
+  double seed = 0.0;
+  for (int32_t g = 0; g < num_gaps; ++g) {
+    for (int32_t periods = 1; periods <= kMaxSwapInterval + 1; ++periods) {
+      if (3 * whole[g][periods - 1] >= 2 * most_whole) {
+        seed = std::max(seed, gaps[g] / periods);
+      }
+    }
+  }
+  if (seed == 0.0) return;
+
+  // Refine the seed to the median period of the gaps that are whole numbers
+  // of it, which leaves out most late samples.
+  for (int32_t pass = 0; pass < kSeedPasses; ++pass) {
+    double periods[kVsyncSamples];
+    int32_t num_periods = 0;
+    for (int32_t i = 0; i < num_gaps; ++i) {
+      if (IsWholeGap(gaps[i], seed)) {
+        periods[num_periods++] = gaps[i] / floor(gaps[i] / seed + 0.5);
+      }
+    }
+    std::nth_element(periods, periods + num_periods / 2,
+                     periods + num_periods);
+    seed = periods[num_periods / 2];
+  }
+  // Numbering all the samples by their gaps would add up the error of the
+  // seed and slip a number at a late sample. Number only the newest run of
+  // kChainedSamples whose fit is good so, then number twice as many around
+  // them against the line and refit, up to all of them.
+  int32_t fitted = std::min(count, kChainedSamples);
+  int32_t start = count - fitted;
+  for (;; --start) {
+    if (start < 0) return;
+    numbers[start] = 0.0;
+    for (int32_t i = start + 1; i < start + fitted; ++i) {
+      numbers[i] = numbers[i - 1] + floor(gaps[i - 1] / seed + 0.5);
+    }
+    if (FitLine(times + start, numbers + start, fitted, &period,
+                &intercept) &&
+        IsOnLine(times + start, numbers + start, fitted, period, intercept,
+                 kChainFitSamples, kMaxChainResidual)) {
+      break;
+    }
+  }
+  while (fitted < count) {
+    const int32_t grown = std::min(count, 2 * fitted);
+    start = std::min(std::max(start - (grown - fitted) / 2, 0), count - grown);
+    fitted = grown;
+    for (int32_t i = start; i < start + fitted; ++i) {
+      numbers[i] = floor((times[i] - intercept) / period + 0.5);
+    }
+    if (!FitLine(times + start, numbers + start, fitted, &period,
+                 &intercept)) {
+      return;
+    }
+  }
+  if (IsGoodFit(times, numbers, count, period, intercept, kLockFitSamples)) {
+    period_ = period;
+    phase_ = base + static_cast<int64_t>(floor(intercept + 0.5));
+    locked_ = true;
+  }
+}
+
+bool FramePacer::FitLine(const double* times, double* numbers, int32_t count,
+                         double* period, double* intercept) {
+  double slopes[kVsyncSamples * (kVsyncSamples - 1) / 2];
+  double intercepts[kVsyncSamples];
+  for (int32_t pass = 0;; ++pass) {
+    // Theil-Sen: the median of the slopes between all pairs of samples,
+    // then the median of the intercepts.
+    int32_t num_slopes = 0;
+    for (int32_t i = 0; i < count; ++i) {
+      for (int32_t j = i + 1; j < count; ++j) {
+        if (numbers[j] == numbers[i]) continue;
+        slopes[num_slopes++] =
+            (times[j] - times[i]) / (numbers[j] - numbers[i]);
+      }
+    }
+    if (!num_slopes) return false;
+    std::nth_element(slopes, slopes + num_slopes / 2, slopes + num_slopes);
+    *period = slopes[num_slopes / 2];
+    if (*period < kMinVsyncPeriod || *period > kMaxVsyncPeriod) return false;
+
+    for (int32_t i = 0; i < count; ++i) {
+      intercepts[i] = times[i] - *period * numbers[i];
+    }
+    std::nth_element(intercepts, intercepts + count / 2, intercepts + count);
+    *intercept = intercepts[count / 2];
+    if (pass == kRenumberPasses) break;
+
+    // Renumber every sample on its own against the line. That undoes the
+    // slips of the gap numbering around a late sample, which would shift
+    // all the samples after it.
+    bool renumbered = false;
+    for (int32_t i = 0; i < count; ++i) {
+      const double number = floor((times[i] - *intercept) / *period + 0.5);
+      renumbered |= number != numbers[i];
+      numbers[i] = number;
+    }
+    if (!renumbered) break;
+  }
+
+  return true;
+}
+
+int64_t FramePacer::GetVsyncPeriod() const {
+  return static_cast<int64_t>(floor(period_ + 0.5));
+}
+
+int64_t FramePacer::PredictVsync(int64_t time) const {
+  // The tolerance keeps a time on a vsync from rounding to the next one.
+  double periods = ceil(static_cast<double>(time - phase_) / period_ - 1e-6);
+  return phase_ + static_cast<int64_t>(floor(periods * period_ + 0.5));
+}
+
+//--------------------------------------------------------------------------------
+// Swap interval
+//--------------------------------------------------------------------------------
+void FramePacer::AddFrameCost(int64_t cost) {
+  costs_[cost_next_] = cost;
+  cost_next_ = (cost_next_ + 1) % kFrameCostSamples;
+  cost_count_ = std::min(cost_count_ + 1, kFrameCostSamples);
+  UpdateSwapInterval();
+}
+
+int64_t FramePacer::GetSlowFrameCost() const {
+  int64_t costs[kFrameCostSamples];
+  std::copy(costs_, costs_ + cost_count_, costs);
+  int32_t index = cost_count_ * kSlowFramePercentile / 100;
+  std::nth_element(costs, costs + index, costs + cost_count_);
+  return costs[index];
+}
+
+void FramePacer::UpdateSwapInterval() {
+  const double cost = static_cast<double>(GetSlowFrameCost());
+  int32_t interval = min_swap_interval_;
+  while (interval < kMaxSwapInterval &&
+         cost > kCostBudget * interval * period_) {
+    ++interval;
+  }
+
+  if (interval > swap_interval_) {
+    // Missing vsyncs stutters at once: slow down now.
+    swap_interval_ = interval;
+    shorter_interval_frames_ = 0;
+  } else if (interval < swap_interval_ &&
+             cost < kCostRecovery * (swap_interval_ - 1) * period_) {
+    if (++shorter_interval_frames_ >= kShorterIntervalFrames) {
+      --swap_interval_;
+      shorter_interval_frames_ = 0;
+    }
+  } else {
+    shorter_interval_frames_ = 0;
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Scheduling
+//--------------------------------------------------------------------------------
+int64_t FramePacer::SchedulePresent(int64_t ready_time) {
+  const int64_t period = GetVsyncPeriod();
+  // First vsync the frame can make.
+  const int64_t earliest = PredictVsync(ready_time);
+  int64_t target = earliest;
+  if (present_time_) {
+    // Next vsync of the cadence. When the frame ran past it, the cadence
+    // restarts at |earliest|. A frame may be ready long before its vsync,
+    // e.g. when frames are queued ahead with presentation timestamps.
+    int64_t next =
+        PredictVsync(present_time_ + swap_interval_ * period - period / 2);
+    if (next >= earliest) target = next;
+  }
+  present_time_ = target;
+  return target;
+}
+
+bool FramePacer::IsPresentDue(int64_t vsync_time) const {
+  return vsync_time >= present_time_ - GetVsyncPeriod() / 2;
+}
+
+int64_t FramePacer::GetPresentationTime() const {
+  return present_time_ - GetVsyncPeriod() / 2;
+}
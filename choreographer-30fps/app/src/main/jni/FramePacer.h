@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// FramePacer.h
+// Vsync prediction and swap interval selection for paced rendering
+//--------------------------------------------------------------------------------
+#ifndef _FRAMEPACER_H
+#define _FRAMEPACER_H
+
+#include <stdint.h>
+
+// Vsync timestamps kept for the fit, about a second at 60 Hz.
+const int32_t kVsyncSamples = 64;
+// Render costs kept to pick the swap interval.
+const int32_t kFrameCostSamples = 32;
+// Longest swap interval picked: 20 FPS on a 60 Hz display.
+const int32_t kMaxSwapInterval = 3;
+
+/*
+ * FramePacer decides on which vsync each frame is presented.
+ *
+ * - It learns the vsync period and phase from vsync timestamps (e.g.
+ *   Choreographer's frameTimeNanos). The fit is a Theil-Sen line through the
+ *   recent timestamps against their vsync numbers, so jittery, late and
+ *   missing callbacks barely move it. Until it has enough samples it assumes
+ *   a 60 Hz display.
+ * - It picks the swap interval, i.e. 60, 30 or 20 FPS on a 60 Hz display,
+ *   from the measured render cost: the shortest one the slow frames still
+ *   fit in. It moves to a longer interval at once, and back only after the
+ *   cost has stayed well below the shorter one for a while, so it does not
+ *   flicker between two rates.
+ * - It schedules every frame on the next vsync of the cadence set by the
+ *   swap interval. A frame that ran long goes to the first vsync it can
+ *   still make and the cadence restarts there, instead of queuing behind
+ *   stale timestamps and showing the following frames in a burst.
+ *
+ * All times are CLOCK_MONOTONIC nanoseconds. The class has no Android
+ * dependency; it is not thread safe, so feed it from the render thread.
+ */
+class FramePacer {
+  // Vsync timestamps, a ring of kVsyncSamples
+  int64_t vsyncs_[kVsyncSamples];
+  int32_t vsync_count_;
+  int32_t vsync_next_;
+
+  // Fitted vsync n is at phase_ + n * period_
+  int64_t phase_;
+  double period_;
+  bool locked_;
+
+  int64_t costs_[kFrameCostSamples];
+  int32_t cost_count_;
+  int32_t cost_next_;
+
+  int32_t min_swap_interval_;
+  int32_t swap_interval_;
+  int32_t shorter_interval_frames_;
+
+  int64_t present_time_;
+
+  void FitVsync();
+  bool FitLine(const double* times, double* numbers, int32_t count,
+               double* period, double* intercept);
+  void UpdateSwapInterval();
+  int64_t GetSlowFrameCost() const;
+
+ public:
+  FramePacer();
+
+  // Forgets the vsync fit, the render costs and the cadence.
+  void Reset();
+
+  // Swap interval the pacer never goes below, e.g. 2 to hold 30 FPS.
+  void SetMinSwapInterval(int32_t interval);
+  int32_t GetMinSwapInterval() const { return min_swap_interval_; }
+
+  // Adds the timestamp of a vsync. Gaps of any number of vsyncs are fine.
+  void AddVsync(int64_t vsync_time);
+  // True once the period and phase come from the fit.
+  bool IsLocked() const { return locked_; }
+  int64_t GetVsyncPeriod() const;
+  // First vsync at or after |time|.
+  int64_t PredictVsync(int64_t time) const;
+
+  // Adds the render cost of a frame, from the start of its work to its swap.
+  void AddFrameCost(int64_t cost);
+  int32_t GetSwapInterval() const { return swap_interval_; }
+
+  // Schedules the frame that is ready to be swapped at |ready_time| and
+  // returns the vsync it should be presented on.
+  int64_t SchedulePresent(int64_t ready_time);
+  int64_t GetPresentTime() const { return present_time_; }
+  // True when the scheduled frame should be swapped on |vsync_time|.
+  bool IsPresentDue(int64_t vsync_time) const;
+  // Timestamp for eglPresentationTimeANDROID: half a period before the
+  // scheduled vsync, so jitter can not push the frame to a neighbor.
+  int64_t GetPresentationTime() const;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// VsyncHandoff.cpp
+//--------------------------------------------------------------------------------
+#include "VsyncHandoff.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// The futex word is the 32-bit value inside the atomic.
+int* FutexWord(std::atomic<int32_t>* word) {
+  return reinterpret_cast<int*>(word);
+}
+
+void FutexWait(std::atomic<int32_t>* word, int32_t value) {
+  // Returns at once when the word no longer holds |value|; spurious wake-ups
+  // and signals are handled by the caller's loop.
+  syscall(__NR_futex, FutexWord(word), FUTEX_WAIT_PRIVATE, value, NULL, NULL,
+          0);
+}
+
+void FutexWake(std::atomic<int32_t>* word) {
+  syscall(__NR_futex, FutexWord(word), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void CpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause");
+#elif defined(__arm__) || defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+int64_t GetTime() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+}  // namespace
+
+VsyncHandoff::VsyncHandoff() : vsync_time_(0), sequence_(0), waiting_(false) {}
+
+void VsyncHandoff::Post(int64_t vsync_time) {
+  vsync_time_.store(vsync_time, std::memory_order_seq_cst);
+  sequence_.fetch_add(1, std::memory_order_seq_cst);
+  // Either the consumer sees the new timestamp before it sleeps, or this sees
+  // it waiting: both sides store, then load the other's flag, all seq_cst.
+  if (waiting_.load(std::memory_order_seq_cst)) {
+    FutexWake(&sequence_);
+  }
+}
+
+int64_t VsyncHandoff::Wait(int64_t last_vsync_time, int64_t spin_ns) {
+  int64_t vsync_time = vsync_time_.load(std::memory_order_acquire);
+  if (vsync_time != last_vsync_time) return vsync_time;
+
+  if (spin_ns > 0) {
+    const int64_t spin_end = GetTime() + spin_ns;
+    // Reading the clock costs more than a relax, so do it every few loops.
+    for (int32_t i = 1;; ++i) {
+      CpuRelax();
+      vsync_time = vsync_time_.load(std::memory_order_acquire);
+      if (vsync_time != last_vsync_time) return vsync_time;
+      if (!(i % 64) && GetTime() >= spin_end) break;
+    }
+  }
+
+  for (;;) {
+    // Sleep only while the sequence is the one read before the last check;
+    // a Post() in between changes it and the wait returns at once.
+    const int32_t sequence = sequence_.load(std::memory_order_seq_cst);
+    waiting_.store(true, std::memory_order_seq_cst);
+    vsync_time = vsync_time_.load(std::memory_order_seq_cst);
+    if (vsync_time != last_vsync_time) break;
+    FutexWait(&sequence_, sequence);
+  }
+  waiting_.store(false, std::memory_order_relaxed);
+  return vsync_time;
+}
+
+CondVarVsyncHandoff::CondVarVsyncHandoff() : vsync_time_(0) {}
+
+void CondVarVsyncHandoff::Post(int64_t vsync_time) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  vsync_time_ = vsync_time;
+  cv_.notify_one();
+}
+
+int64_t CondVarVsyncHandoff::Wait(int64_t last_vsync_time,
+                                  int64_t /*spin_ns*/) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this, last_vsync_time] {
+    return vsync_time_ != last_vsync_time;
+  });
+  return vsync_time_;
+}
+
+int64_t CondVarVsyncHandoff::Peek() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return vsync_time_;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// VsyncHandoff.h
+// Handoffs of vsync timestamps from one thread to another
+//--------------------------------------------------------------------------------
+#ifndef _VSYNCHANDOFF_H
+#define _VSYNCHANDOFF_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/*
+ * VsyncHandoff passes the latest vsync timestamp from a single producer, the
+ * Choreographer thread, to a single consumer, the render thread.
+ *
+ * The timestamp is one atomic word, so the consumer always reads a whole
+ * one; older ones it did not get to are overwritten. The producer never
+ * blocks and never takes a lock the consumer holds, so a low priority render
+ * thread can not hold up the callback. It only makes the futex wake system
+ * call when the consumer is asleep.
+ *
+ * The consumer may spin for a while before it sleeps: that saves the wake-up
+ * latency of the scheduler when the next vsync is known to be close, at the
+ * cost of a busy core.
+ *
+ * Linux only, it uses the futex system call directly.
+ */
+class VsyncHandoff {
+  std::atomic<int64_t> vsync_time_;
+  // Bumped on every Post(); the futex word the consumer sleeps on.
+  std::atomic<int32_t> sequence_;
+  std::atomic<bool> waiting_;
+
+  VsyncHandoff(const VsyncHandoff&);
+  void operator=(const VsyncHandoff&);
+
+ public:
+  VsyncHandoff();
+
+  // Producer: publishes |vsync_time| and wakes the consumer if it sleeps.
+  void Post(int64_t vsync_time);
+
+  // Consumer: returns the latest timestamp once it differs from
+  // |last_vsync_time|. Spins up to |spin_ns| nanoseconds, then sleeps.
+  int64_t Wait(int64_t last_vsync_time, int64_t spin_ns);
+
+  // Latest timestamp, 0 before the first Post().
+  int64_t Peek() const { return vsync_time_.load(std::memory_order_acquire); }
+};
+
+/*
+ * CondVarVsyncHandoff is the same handoff under a mutex, signaled through a
+ * condition variable, with the same interface. The producer takes the lock
+ * the consumer holds while it checks the timestamp, and the consumer never
+ * spins.
+ *
+ * tools/handoffBench shows VsyncHandoff waking the consumer a few
+ * microseconds sooner at the median but no better in the tail, so this is
+ * the one the sample uses unless USE_FUTEX_VSYNC_HANDOFF is defined.
+ */
+class CondVarVsyncHandoff {
+  mutable std::mutex mtx_;
+  std::condition_variable cv_;
+  int64_t vsync_time_;
+
+  CondVarVsyncHandoff(const CondVarVsyncHandoff&);
+  void operator=(const CondVarVsyncHandoff&);
+
+ public:
+  CondVarVsyncHandoff();
+
+  void Post(int64_t vsync_time);
+  // |spin_ns| is ignored.
+  int64_t Wait(int64_t last_vsync_time, int64_t spin_ns);
+  int64_t Peek() const;
+};
+
+#endif
@@ -39,6 +39,10 @@ GLContext::GLContext()
       context_(EGL_NO_CONTEXT),
       screen_width_(0),
       screen_height_(0),
+      render_width_(0),
+      render_height_(0),
+      render_scale_(1.f),
+      render_size_pending_(false),
       es3_supported_(false),
       egl_context_initialized_(false),
       gles_initialized_(false) {}
@@ -116,10 +120,50 @@ bool GLContext::InitEGLSurface() {
     return false;
   }
 
+  return CreateSurface();
+}
+
+bool GLContext::CreateSurface() {
+  // The window's own size first, then the buffers at the render scale
+  ANativeWindow_setBuffersGeometry(window_, 0, 0, 0);
+  screen_width_ = ANativeWindow_getWidth(window_);
+  screen_height_ = ANativeWindow_getHeight(window_);
+  if (render_scale_ < 1.f) {
+    ANativeWindow_setBuffersGeometry(
+        window_, (int32_t)(screen_width_ * render_scale_ + 0.5f),
+        (int32_t)(screen_height_ * render_scale_ + 0.5f), 0);
+  }
+
   surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
-  eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
-  eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
+  eglQuerySurface(display_, surface_, EGL_WIDTH, &render_width_);
+  eglQuerySurface(display_, surface_, EGL_HEIGHT, &render_height_);
+  render_size_pending_ = false;
+  return surface_ != EGL_NO_SURFACE;
+}
 
+bool GLContext::SetRenderScale(const float scale) {
+  float clamped = scale < 1.f ? scale : 1.f;
+  if (clamped == render_scale_) return true;
+  // Without a surface, Resume() applies it
+  if (surface_ == EGL_NO_SURFACE) {
+    render_scale_ = clamped;
+    return true;
+  }
+
+  // The surface stays; it takes the new size with the next buffer it
+  // dequeues, at the next eglSwapBuffers(). 0x0 is the window's own size.
+  int32_t width = 0;
+  int32_t height = 0;
+  if (clamped < 1.f) {
+    width = (int32_t)(screen_width_ * clamped + 0.5f);
+    height = (int32_t)(screen_height_ * clamped + 0.5f);
+  }
+  if (ANativeWindow_setBuffersGeometry(window_, width, height, 0) < 0) {
+    LOGW("Unable to resize the surface to scale %f", clamped);
+    return false;
+  }
+  render_scale_ = clamped;
+  render_size_pending_ = true;
   return true;
 }
 
@@ -154,6 +198,11 @@ EGLint GLContext::Swap() {
     }
     return err;
   }
+  if (render_size_pending_) {
+    eglQuerySurface(display_, surface_, EGL_WIDTH, &render_width_);
+    eglQuerySurface(display_, surface_, EGL_HEIGHT, &render_height_);
+    render_size_pending_ = false;
+  }
   return EGL_SUCCESS;
 }
 
@@ -187,9 +236,7 @@ EGLint GLContext::Resume(ANativeWindow* window) {
 
   // Create surface
   window_ = window;
-  surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
-  eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
-  eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
+  CreateSurface();
 
   if (screen_width_ != original_widhth || screen_height_ != original_height) {
     // Screen resized
@@ -62,6 +62,12 @@ class GLContext {
   // Screen parameters
   int32_t screen_width_;
   int32_t screen_height_;
+  // Size of the surface frames are rendered to, see SetRenderScale()
+  int32_t render_width_;
+  int32_t render_height_;
+  float render_scale_;
+  // The surface takes a new render size at the next Swap()
+  bool render_size_pending_;
   int32_t color_size_;
   int32_t depth_size_;
 
@@ -75,6 +81,7 @@ class GLContext {
   void InitGLES();
   void Terminate();
   bool InitEGLSurface();
+  bool CreateSurface();
   bool InitEGLContext();
 
   GLContext(GLContext const&);
@@ -97,8 +104,22 @@ class GLContext {
   void Suspend();
   EGLint Resume(ANativeWindow* window);
 
+  // Window size; touch coordinates are in this space
   int32_t GetScreenWidth() const { return screen_width_; }
   int32_t GetScreenHeight() const { return screen_height_; }
+  // Size frames are rendered at, use it for the viewport
+  int32_t GetRenderWidth() const { return render_width_; }
+  int32_t GetRenderHeight() const { return render_height_; }
+
+  /*
+   * Render at |scale| times the window size, the compositor scales the
+   * buffers up to the window. The surface keeps the frame being drawn at the
+   * old size and takes the new one with the next Swap(): set the viewport
+   * again once GetRenderWidth() and GetRenderHeight() change. On failure the
+   * scale stays as it was. The scale is kept across Suspend() and Resume().
+   */
+  bool SetRenderScale(const float scale);
+  float GetRenderScale() const { return render_scale_; }
 
   int32_t GetBufferColorSize() const { return color_size_; }
   int32_t GetBufferDepthSize() const { return depth_size_; }
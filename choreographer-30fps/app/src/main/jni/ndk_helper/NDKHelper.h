@@ -38,6 +38,7 @@
 #include "JNIHelper.h"       //JNI support
 #include "gestureDetector.h" //Tap/Doubletap/Pinch detector
 #include "perfMonitor.h"     //FPS counter
+#include "resolutionController.h" //Dynamic render resolution
 #include "sensorManager.h"   //SensorManager
 #include "interpolator.h"    //Interpolator
 #endif
@@ -0,0 +1,492 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// framePacerTest.cpp
+// Linux test and benchmark of FramePacer on synthetic vsync traces.
+//
+// Each trace is a display of a random refresh rate and phase, seen through
+// Choreographer callbacks that jitter, come late or are missed, one at a time
+// or in runs. Once enough callbacks came, the pacer must be locked to the
+// display: its period close to the real one and every vsync of the next
+// second predicted within a small part of a period. It must keep the period
+// through runs of callbacks on every other vsync, relock after the refresh
+// rate changes and start over after a pause.
+//
+// Swap intervals must follow the render cost, slowing down at once and
+// speeding up only after a while. Presents must keep the cadence of the swap
+// interval, and after a long frame restart it rather than bunch up.
+//
+// Last, AddVsync() is timed: it refits the line on every callback.
+//
+// Build and run on the host or on a device shell, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -I$JNI -o framePacerTest framePacerTest.cpp
+//    $JNI/FramePacer.cpp
+//  ./framePacerTest
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "FramePacer.h"
+
+// Random traces per case, and vsyncs per trace.
+const int32_t kTraces = 100;
+const int32_t kTraceVsyncs = 400;
+// Refresh rates of the traces, in Hz.
+const double kRefreshRates[] = {48.0, 60.0, 90.0, 120.0, 144.0};
+const int32_t kNumRefreshRates =
+    sizeof(kRefreshRates) / sizeof(kRefreshRates[0]);
+// Vsyncs predicted after the last callback: a second at 60 Hz.
+const int32_t kPredictedVsyncs = 60;
+// A locked period further off than this is a wrong lock.
+const double kMaxPeriodError = 0.02;
+// Callbacks the pacer may take to lock, with few and with many late ones, to
+// a new refresh rate, and after a pause. It fits from 24 samples on.
+const int32_t kLockCallbacks = 40;
+const int32_t kLateLockCallbacks = kVsyncSamples;
+const int32_t kRelockCallbacks = kVsyncSamples;
+const int32_t kPauseLockCallbacks = 24;
+const int32_t kBenchVsyncs = 20000;
+
+int32_t g_failures = 0;
+
+#define CHECK(cond, ...)    \
+  do {                      \
+    if (!(cond)) {          \
+      printf("  FAILED: "); \
+      printf(__VA_ARGS__);  \
+      printf("\n");         \
+      ++g_failures;         \
+    }                       \
+  } while (0)
+
+std::mt19937 g_random(12345);
+
+// In [0, 1)
+double Random() {
+  return std::uniform_real_distribution<double>(0.0, 1.0)(g_random);
+}
+
+int64_t GetTime() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+// How the callbacks of a trace come.
+struct Callbacks {
+  double jitter;     // Largest timestamp error either way, in periods
+  double late_rate;  // Part of the callbacks that come late
+  double late;       // Latest they come, in periods
+  double miss_rate;  // Part of the vsyncs that start a run of misses
+  int32_t miss_run;  // Longest run of vsyncs missed in a row
+};
+
+const Callbacks kExact = {0.0, 0.0, 0.0, 0.0, 1};
+const Callbacks kLateAndMissed = {0.02, 0.2, 0.45, 0.2, 4};
+
+// A display: vsync n is at phase + n * period.
+struct Display {
+  double phase;
+  double period;
+  int64_t Vsync(int64_t n) const {
+    return static_cast<int64_t>(floor(phase + n * period + 0.5));
+  }
+};
+
+Display RandomDisplay() {
+  Display display;
+  display.period =
+      1e9 / kRefreshRates[static_cast<int32_t>(Random() * kNumRefreshRates)];
+  // A boot clock a while up
+  display.phase = 1e12 + Random() * 1e11;
+  return display;
+}
+
+// Same clock, another refresh rate and phase, from vsync |n| of |display| on.
+Display ChangeRefreshRate(const Display& display, int64_t n) {
+  Display changed = display;
+  while (changed.period == display.period) changed = RandomDisplay();
+  changed.phase = display.phase + n * display.period + Random() * 1e7;
+  return changed;
+}
+
+// Timestamp of the callback of vsync |n|.
+int64_t CallbackTime(const Display& display, const Callbacks& callbacks,
+                     int64_t n) {
+  double error = (Random() * 2.0 - 1.0) * callbacks.jitter;
+  if (Random() < callbacks.late_rate) error += Random() * callbacks.late;
+  return display.Vsync(n) + static_cast<int64_t>(error * display.period);
+}
+
+// Vsyncs of a trace that get a callback, in [first, end).
+std::vector<int64_t> GetCallbackVsyncs(const Callbacks& callbacks,
+                                       int64_t first, int64_t end) {
+  std::vector<int64_t> vsyncs;
+  for (int64_t n = first; n < end; ++n) {
+    if (Random() < callbacks.miss_rate) {
+      n += static_cast<int64_t>(Random() * callbacks.miss_run);
+      continue;
+    }
+    vsyncs.push_back(n);
+  }
+  return vsyncs;
+}
+
+double GetPeriodError(const Display& display, const FramePacer& pacer) {
+  return fabs(pacer.GetVsyncPeriod() - display.period) / display.period;
+}
+
+// Largest error predicting the vsyncs after |n|, in periods.
+double GetPredictionError(const Display& display, const FramePacer& pacer,
+                          int64_t n) {
+  double worst = 0.0;
+  for (int64_t v = n + 1; v <= n + kPredictedVsyncs; ++v) {
+    // Halfway from the vsync before
+    int64_t time = display.Vsync(v) - static_cast<int64_t>(display.period / 2);
+    double error = fabs(static_cast<double>(pacer.PredictVsync(time) -
+                                            display.Vsync(v))) /
+                   display.period;
+    worst = std::max(worst, error);
+  }
+  return worst;
+}
+
+// Feeds the callbacks of vsyncs [first, end) and returns the last vsync that
+// got one, or -1.
+int64_t Feed(const Display& display, const Callbacks& callbacks,
+             int64_t first, int64_t end, FramePacer* pacer) {
+  std::vector<int64_t> vsyncs = GetCallbackVsyncs(callbacks, first, end);
+  for (size_t i = 0; i < vsyncs.size(); ++i) {
+    pacer->AddVsync(CallbackTime(display, callbacks, vsyncs[i]));
+  }
+  return vsyncs.empty() ? -1 : vsyncs.back();
+}
+
+//--------------------------------------------------------------------------------
+// Vsync fit
+//--------------------------------------------------------------------------------
+// Worst of a case over its traces
+struct Accuracy {
+  int32_t wrong_locks;      // Traces locked to a wrong period at some point
+  int32_t late_locks;       // Traces unlocked after enough callbacks
+  double period_error;      // Relative, once locked
+  double prediction_error;  // In periods, at the end of the traces
+};
+
+void TestTraces(const char* name, const Callbacks& callbacks,
+                int32_t lock_callbacks, double max_prediction_error) {
+  Accuracy accuracy = {};
+  for (int32_t t = 0; t < kTraces; ++t) {
+    Display display = RandomDisplay();
+    FramePacer pacer;
+    std::vector<int64_t> vsyncs =
+        GetCallbackVsyncs(callbacks, 0, kTraceVsyncs);
+    bool wrong = false;
+    bool late = false;
+    for (size_t i = 0; i < vsyncs.size(); ++i) {
+      pacer.AddVsync(CallbackTime(display, callbacks, vsyncs[i]));
+      if (pacer.IsLocked()) {
+        double error = GetPeriodError(display, pacer);
+        accuracy.period_error = std::max(accuracy.period_error, error);
+        if (error > kMaxPeriodError) wrong = true;
+      } else if (static_cast<int32_t>(i) >= lock_callbacks - 1) {
+        late = true;
+      }
+    }
+    accuracy.wrong_locks += wrong;
+    accuracy.late_locks += late;
+    accuracy.prediction_error =
+        std::max(accuracy.prediction_error,
+                 GetPredictionError(display, pacer, vsyncs.back()));
+  }
+  printf("  %-18s period %.3f%%, prediction %.3f periods\n", name,
+         accuracy.period_error * 100.0, accuracy.prediction_error);
+  CHECK(accuracy.wrong_locks == 0, "%s: %d traces locked to a wrong period",
+        name, accuracy.wrong_locks);
+  CHECK(accuracy.late_locks == 0, "%s: %d traces unlocked after %d callbacks",
+        name, accuracy.late_locks, lock_callbacks);
+  CHECK(accuracy.prediction_error <= max_prediction_error,
+        "%s: vsyncs predicted %.3f periods off", name,
+        accuracy.prediction_error);
+}
+
+void TestVsyncFit() {
+  printf("Vsync fit, %d traces of %d vsyncs at 48 to 144 Hz\n", kTraces,
+         kTraceVsyncs);
+  TestTraces("exact", kExact, kLockCallbacks, 0.001);
+  TestTraces("jitter", Callbacks{0.05, 0.0, 0.0, 0.0, 1}, kLockCallbacks,
+             0.1);
+  TestTraces("late", Callbacks{0.02, 0.2, 0.45, 0.0, 1}, kLateLockCallbacks,
+             0.1);
+  TestTraces("missed", Callbacks{0.02, 0.0, 0.0, 0.3, 1}, kLockCallbacks,
+             0.05);
+  TestTraces("missed in runs", Callbacks{0.02, 0.0, 0.0, 0.1, 8},
+             kLockCallbacks, 0.05);
+  TestTraces("late and missed", kLateAndMissed, kLateLockCallbacks, 0.05);
+  // Past what a device does: the pacer may lose the lock for a while, but
+  // never locks to a wrong period.
+  TestTraces("stress", Callbacks{0.02, 0.3, 0.45, 0.3, 4}, kTraceVsyncs,
+             0.15);
+}
+
+// The refresh rate changes halfway through the traces.
+void TestRefreshRateChange() {
+  printf("Refresh rate changes\n");
+  int32_t worst = 0;
+  for (int32_t t = 0; t < kTraces; ++t) {
+    Display display = RandomDisplay();
+    FramePacer pacer;
+    Feed(display, kLateAndMissed, 0, kTraceVsyncs / 2, &pacer);
+    Display changed = ChangeRefreshRate(display, kTraceVsyncs / 2);
+    std::vector<int64_t> vsyncs =
+        GetCallbackVsyncs(kLateAndMissed, 0, kTraceVsyncs);
+    int32_t relocked = -1;
+    for (size_t i = 0; i < vsyncs.size(); ++i) {
+      pacer.AddVsync(CallbackTime(changed, kLateAndMissed, vsyncs[i]));
+      bool locked = pacer.IsLocked() &&
+                    GetPeriodError(changed, pacer) <= kMaxPeriodError;
+      if (locked && relocked < 0) relocked = static_cast<int32_t>(i) + 1;
+      if (!locked) relocked = -1;
+    }
+    CHECK(relocked > 0 && relocked <= kRelockCallbacks,
+          "%.0f to %.0f Hz: relocked after %d callbacks",
+          1e9 / display.period, 1e9 / changed.period, relocked);
+    worst = std::max(worst, relocked);
+  }
+  printf("  relocked after %d callbacks at most\n", worst);
+}
+
+// Callbacks on every other vsync, e.g. from a 30 FPS render loop that posts
+// them late. The pacer keeps its period through runs shorter than its
+// samples; a longer run looks like a display at half the rate.
+void TestEveryOtherVsync() {
+  printf("Callbacks on every other vsync\n");
+  const Callbacks every_other = {0.02, 0.0, 0.0, 0.0, 1};
+  double worst = 0.0;
+  for (int32_t t = 0; t < kTraces; ++t) {
+    Display display = RandomDisplay();
+    FramePacer pacer;
+    int64_t n = Feed(display, kLateAndMissed, 0, kTraceVsyncs / 2, &pacer);
+    for (int32_t i = 0; i < kVsyncSamples / 2; ++i) {
+      n += 2;
+      pacer.AddVsync(CallbackTime(display, every_other, n));
+      double error = GetPeriodError(display, pacer);
+      worst = std::max(worst, error);
+      CHECK(pacer.IsLocked() && error <= kMaxPeriodError,
+            "%.0f Hz: locked %d to %.3f Hz in a short run",
+            1e9 / display.period, pacer.IsLocked(),
+            1e9 / pacer.GetVsyncPeriod());
+    }
+    for (int32_t i = 0; i < 2 * kVsyncSamples; ++i) {
+      n += 2;
+      pacer.AddVsync(CallbackTime(display, every_other, n));
+    }
+    Display half_rate = {display.phase + n * display.period,
+                         2.0 * display.period};
+    CHECK(pacer.IsLocked() &&
+              GetPeriodError(half_rate, pacer) <= kMaxPeriodError &&
+              GetPredictionError(half_rate, pacer, 0) <= 0.05,
+          "%.0f Hz: locked %d to %.3f Hz in a long run",
+          1e9 / display.period, pacer.IsLocked(),
+          1e9 / pacer.GetVsyncPeriod());
+  }
+  printf("  period %.3f%% in short runs\n", worst * 100.0);
+}
+
+// A pause longer than the samples, then callbacks of another display, or the
+// same display at another phase.
+void TestPause() {
+  printf("Pauses\n");
+  for (int32_t t = 0; t < kTraces; ++t) {
+    Display display = RandomDisplay();
+    FramePacer pacer;
+    int64_t last = Feed(display, kExact, 0, kTraceVsyncs / 2, &pacer);
+    const int64_t resume = last + 2 * kVsyncSamples;
+    Display resumed = t % 2 ? ChangeRefreshRate(display, resume) : display;
+    for (int32_t i = 0; i < kPauseLockCallbacks; ++i) {
+      pacer.AddVsync(resumed.Vsync(resume + i));
+    }
+    CHECK(pacer.IsLocked() && GetPeriodError(resumed, pacer) < 1e-6,
+          "%.0f to %.0f Hz: not relocked after the pause",
+          1e9 / display.period, 1e9 / resumed.period);
+    CHECK(GetPredictionError(resumed, pacer,
+                             resume + kPauseLockCallbacks - 1) < 1e-6,
+          "%.0f to %.0f Hz: phase kept from before the pause",
+          1e9 / display.period, 1e9 / resumed.period);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Swap interval
+//--------------------------------------------------------------------------------
+// A pacer locked to a 60 Hz display
+void LockTo60Hz(FramePacer* pacer) {
+  Display display = {1e12, 1e9 / 60.0};
+  Feed(display, kExact, 0, kVsyncSamples, pacer);
+}
+
+// Adds |frames| frames of |cost| and returns the frames until the swap
+// interval became |interval|, or -1.
+int32_t AddCosts(FramePacer* pacer, int64_t cost, int32_t frames,
+                 int32_t interval) {
+  int32_t reached = -1;
+  for (int32_t i = 0; i < frames; ++i) {
+    pacer->AddFrameCost(cost);
+    if (reached < 0 && pacer->GetSwapInterval() == interval) reached = i + 1;
+  }
+  return reached;
+}
+
+void TestSwapInterval() {
+  printf("Swap interval\n");
+  const int64_t kMs = 1000000;
+  FramePacer pacer;
+  LockTo60Hz(&pacer);
+  CHECK(AddCosts(&pacer, 10 * kMs, kFrameCostSamples, 1) == 1,
+        "10 ms frames: not at 60 FPS");
+  // The 90th percentile is slow after 4 slow frames of 32.
+  int32_t frames = AddCosts(&pacer, 20 * kMs, kFrameCostSamples, 2);
+  CHECK(frames > 0 && frames <= kFrameCostSamples / 8,
+        "20 ms frames: 30 FPS after %d frames", frames);
+  // The slow frames leave the percentile after 29 fast ones, then 60 more
+  // must pass.
+  frames = AddCosts(&pacer, 10 * kMs, 4 * kFrameCostSamples, 1);
+  CHECK(frames > 60 && frames <= 60 + kFrameCostSamples,
+        "10 ms frames again: 60 FPS after %d frames", frames);
+  frames = AddCosts(&pacer, 40 * kMs, kFrameCostSamples, 3);
+  CHECK(frames > 0 && frames <= kFrameCostSamples / 8,
+        "40 ms frames: 20 FPS after %d frames", frames);
+  CHECK(AddCosts(&pacer, 100 * kMs, kFrameCostSamples, 3) == 1,
+        "100 ms frames: not at 20 FPS");
+
+  // Costs around the 60 FPS budget do not flicker between two rates.
+  pacer.Reset();
+  LockTo60Hz(&pacer);
+  int32_t changes = 0;
+  int32_t interval = pacer.GetSwapInterval();
+  for (int32_t i = 0; i < 10 * kFrameCostSamples; ++i) {
+    pacer.AddFrameCost(static_cast<int64_t>((14.0 + 2.0 * Random()) * kMs));
+    changes += pacer.GetSwapInterval() != interval;
+    interval = pacer.GetSwapInterval();
+  }
+  CHECK(changes == 1, "14 to 16 ms frames: %d swap interval changes",
+        changes);
+
+  pacer.SetMinSwapInterval(2);
+  CHECK(AddCosts(&pacer, 5 * kMs, 4 * kFrameCostSamples, 1) == -1,
+        "Minimum of 2: went to 60 FPS");
+  CHECK(pacer.GetSwapInterval() == 2, "Minimum of 2: at %d",
+        pacer.GetSwapInterval());
+  pacer.SetMinSwapInterval(kMaxSwapInterval + 1);
+  CHECK(pacer.GetMinSwapInterval() == kMaxSwapInterval,
+        "Minimum past %d: %d", kMaxSwapInterval, pacer.GetMinSwapInterval());
+}
+
+//--------------------------------------------------------------------------------
+// Scheduling
+//--------------------------------------------------------------------------------
+// The fitted phase may round a nanosecond off.
+bool IsNear(int64_t time, int64_t vsync) {
+  return time >= vsync - 1 && time <= vsync + 1;
+}
+
+void TestScheduling() {
+  printf("Scheduling\n");
+  const Display display = {1e12, 1e9 / 60.0};
+  for (int32_t interval = 1; interval <= kMaxSwapInterval; ++interval) {
+    FramePacer pacer;
+    pacer.SetMinSwapInterval(interval);
+    int64_t n = Feed(display, kExact, 0, kVsyncSamples, &pacer);
+    // The first frame goes to the next vsync.
+    const int64_t ready_time =
+        display.Vsync(n) + static_cast<int64_t>(display.period / 4);
+    CHECK(IsNear(pacer.SchedulePresent(ready_time), display.Vsync(n + 1)),
+          "Interval %d: first frame not on the next vsync", interval);
+    ++n;
+    int32_t off_cadence = 0;
+    for (int32_t frame = 0; frame < 1000; ++frame) {
+      // Frames are ready in the period before their vsync, or every 10th
+      // one, in the period after it. That one goes to the vsync after and
+      // the cadence restarts there.
+      const bool long_frame = frame % 10 == 9;
+      const int64_t due = n + interval;
+      const double ready =
+          long_frame ? due + 0.01 + 0.98 * Random() : due - 0.99 * Random();
+      const int64_t present = pacer.SchedulePresent(
+          static_cast<int64_t>(display.phase + ready * display.period));
+      n = long_frame ? due + 1 : due;
+      off_cadence += !IsNear(present, display.Vsync(n));
+      CHECK(pacer.GetPresentTime() == present, "Interval %d: present time",
+            interval);
+      CHECK(pacer.IsPresentDue(display.Vsync(n)) &&
+                !pacer.IsPresentDue(display.Vsync(n - 1)),
+            "Interval %d: frame due on the wrong vsync", interval);
+      CHECK(pacer.GetPresentationTime() ==
+                present - pacer.GetVsyncPeriod() / 2,
+            "Interval %d: presentation time", interval);
+    }
+    CHECK(off_cadence == 0, "Interval %d: %d frames off the cadence",
+          interval, off_cadence);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------
+void BenchTrace(const char* name, const Callbacks& callbacks) {
+  const Display display = {1e12, 1e9 / 60.0};
+  std::vector<int64_t> times;
+  std::vector<int64_t> vsyncs = GetCallbackVsyncs(callbacks, 0, kBenchVsyncs);
+  for (size_t i = 0; i < vsyncs.size(); ++i) {
+    times.push_back(CallbackTime(display, callbacks, vsyncs[i]));
+  }
+  FramePacer pacer;
+  int64_t start = GetTime();
+  for (size_t i = 0; i < times.size(); ++i) pacer.AddVsync(times[i]);
+  int64_t elapsed = GetTime() - start;
+  printf("  %-18s %6.2f us per callback\n", name,
+         elapsed / 1000.0 / times.size());
+}
+
+void BenchAddVsync() {
+  printf("AddVsync() time, %d samples\n", kVsyncSamples);
+  BenchTrace("exact", kExact);
+  BenchTrace("late and missed", kLateAndMissed);
+}
+
+int main() {
+  TestVsyncFit();
+  TestRefreshRateChange();
+  TestEveryOtherVsync();
+  TestPause();
+  TestSwapInterval();
+  TestScheduling();
+  BenchAddVsync();
+  if (g_failures) {
+    printf("FAILED: %d\n", g_failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// handoffBench.cpp
+// Linux benchmark of the wake-to-run latency of the vsync handoff between the
+// Choreographer thread and the render thread: CondVarVsyncHandoff, the mutex
+// and condition variable the sample uses, against VsyncHandoff sleeping at
+// once and spinning first. A producer thread posts its clock as the timestamp at a fixed
+// interval; the consumer measures how long after the post it runs again.
+// Fails if the consumer gets a timestamp twice or out of order, or misses
+// one: a post made while it waited, overwritten before it got it, is a lost
+// wake-up or a consumer held off the CPU for a whole interval. Each post is
+// made an interval after the last one, never sooner to catch up, so that a
+// late producer does not post twice in a row.
+//
+// Build and run on the host or on a device shell, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -pthread -I$JNI -o handoffBench handoffBench.cpp
+//    $JNI/VsyncHandoff.cpp
+//  ./handoffBench [posts]
+//--------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "VsyncHandoff.h"
+
+// Posts are this far apart, about a 120 Hz display.
+const int64_t kPostInterval = 8000000;
+// Spin time of the spinning VsyncHandoff variant: past the post interval, so
+// it shows the latency when the consumer never sleeps.
+const int64_t kSpinTime = 2 * kPostInterval;
+
+int64_t GetTime() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+void SleepUntil(int64_t time) {
+  timespec deadline;
+  deadline.tv_sec = time / 1000000000;
+  deadline.tv_nsec = time % 1000000000;
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+}
+
+struct Result {
+  std::vector<int64_t> latencies;
+  int32_t errors;
+  // Posts made while the consumer waited, overwritten before it got them
+  int32_t missed;
+};
+
+// The consumer collects |posts| timestamps; the producer posts until then.
+template <class Handoff>
+Result Run(int32_t posts, int64_t spin_ns) {
+  Handoff handoff;
+  Result result;
+  result.latencies.reserve(posts);
+  result.errors = 0;
+  result.missed = 0;
+  // Every timestamp is stored here before it is posted.
+  std::vector<int64_t> post_times(2 * posts);
+  std::atomic<bool> done(false);
+
+  std::thread consumer([&handoff, &result, &post_times, &done, posts,
+                        spin_ns] {
+    int64_t last = 0;
+    size_t expected = 0;
+    while (static_cast<int32_t>(result.latencies.size()) < posts) {
+      int64_t wait_start = GetTime();
+      int64_t vsync_time = handoff.Wait(last, spin_ns);
+      int64_t now = GetTime();
+      if (vsync_time <= last) {
+        ++result.errors;
+        break;
+      }
+      // Posts between the last one received and this one were overwritten.
+      // That is fine for the ones made before the consumer waited.
+      while (expected < post_times.size() &&
+             post_times[expected] != vsync_time) {
+        if (post_times[expected] >= wait_start) ++result.missed;
+        ++expected;
+      }
+      ++expected;
+      result.latencies.push_back(now - vsync_time);
+      last = vsync_time;
+    }
+    done = true;
+  });
+
+  int64_t next = GetTime() + kPostInterval;
+  for (size_t i = 0; i < post_times.size() && !done; ++i) {
+    SleepUntil(next);
+    post_times[i] = GetTime();
+    handoff.Post(post_times[i]);
+    next = post_times[i] + kPostInterval;
+  }
+  consumer.join();
+  return result;
+}
+
+int64_t Percentile(const std::vector<int64_t>& sorted, int32_t percent) {
+  size_t index = sorted.size() * percent / 100;
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool Report(const char* name, Result result) {
+  std::vector<int64_t>& l = result.latencies;
+  std::sort(l.begin(), l.end());
+  printf("%-22s %8.1f %8.1f %8.1f %8.1f %8d\n", name,
+         Percentile(l, 50) / 1e3, Percentile(l, 90) / 1e3,
+         Percentile(l, 99) / 1e3, l.back() / 1e3, result.missed);
+  bool ok = true;
+  if (result.errors) {
+    printf("  FAILED: %d timestamps repeated or out of order\n", result.errors);
+    ok = false;
+  }
+  if (result.missed) {
+    printf("  FAILED: %d posts missed\n", result.missed);
+    ok = false;
+  }
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  int32_t posts = argc > 1 ? atoi(argv[1]) : 1000;
+  if (posts <= 0) {
+    fprintf(stderr, "usage: %s [posts]\n", argv[0]);
+    return 2;
+  }
+
+  printf("%d posts, %.1f ms apart; wake-to-run latency in us\n", posts,
+         kPostInterval / 1e6);
+  printf("%-22s %8s %8s %8s %8s %8s\n", "handoff", "p50", "p90", "p99", "max",
+         "missed");
+  bool ok = true;
+  ok &= Report("mutex+condvar", Run<CondVarVsyncHandoff>(posts, 0));
+  ok &= Report("VsyncHandoff", Run<VsyncHandoff>(posts, 0));
+  ok &= Report("VsyncHandoff spinning", Run<VsyncHandoff>(posts, kSpinTime));
+  return ok ? 0 : 1;
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include "anim.hpp"
+#include "game_consts.hpp"
 #include "util.hpp"
 
 void RenderBackgroundAnimation(ShapeRenderer *r) {
@@ -21,12 +22,18 @@ void RenderBackgroundAnimation(ShapeRenderer *r) {
     static const int BG_RECTS = 50;
     static const float RECT_W = 0.3f;
     static const float RECT_H = 0.1f;
+    static const float REFERENCE_FPS = 60.0f; // speeds below are per frame at this rate
     static float rectX[BG_RECTS];
     static float rectY[BG_RECTS];
     static bool rectsInitted = false;
+    static DeltaClock frameClock(MAX_DELTA_T);
     int i;
 
+    // scroll by real elapsed time so the animation looks the same at any frame rate
+    float frames = frameClock.ReadDelta() * REFERENCE_FPS;
+
     if (!rectsInitted) {
+        frameClock.SetSmoothing(true);
         for (i = 0; i < BG_RECTS; i++) {
             rectX[i] = aspect * (Random(100) / 100.0f);
             rectY[i] = Random(100) / 100.0f;
@@ -41,7 +48,7 @@ void RenderBackgroundAnimation(ShapeRenderer *r) {
         r->SetColor(c, c, c);
         r->RenderRect(rectX[i], rectY[i], RECT_W, RECT_H);
 
-        rectX[i] -= (0.01f + 0.01f * (i % 4));
+        rectX[i] -= (0.01f + 0.01f * (i % 4)) * frames;
         if (rectX[i] < -RECT_W * 0.5f) {
             rectX[i] = aspect + RECT_W * 0.5f;
             rectY[i] = Random(100) / 100.0f;
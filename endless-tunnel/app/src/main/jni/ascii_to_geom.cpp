@@ -18,7 +18,10 @@
 #define GEOM_DEBUG LOGD
 //#define GEOM_DEBUG
 
-SimpleGeom* AsciiArtToGeom(const char *art, float scale) {
+// Parses the ASCII art into an array of vertices (x, y, z, r, g, b, a) and an array of
+// line indices. The caller is responsible for deleting both arrays.
+static void _parse_ascii_art(const char *art, float scale, GLfloat **outVertices,
+        int *outVertexCount, GLushort **outIndices, int *outIndexCount) {
     // figure out width and height
     LOGD("Creating geometry from ASCII art.");
     GEOM_DEBUG("Ascii art source:\n%s", art);
@@ -95,7 +98,6 @@ SimpleGeom* AsciiArtToGeom(const char *art, float scale) {
 
     // allocate arrays for the vertices and lines
     const int VERTICES_STRIDE = sizeof(GLfloat) * 7;
-    const int VERTICES_COLOR_OFFSET = sizeof(GLfloat) * 3;
     GLfloat *verticesArray = new GLfloat[vertices * VERTICES_STRIDE];
     GLushort *indicesArray = new GLushort[indices];
     vertices = indices = 0; // current count of vertices and lines
@@ -209,6 +211,21 @@ SimpleGeom* AsciiArtToGeom(const char *art, float scale) {
         }
     }
 
+    *outVertices = verticesArray;
+    *outVertexCount = vertices;
+    *outIndices = indicesArray;
+    *outIndexCount = indices;
+}
+
+SimpleGeom* AsciiArtToGeom(const char *art, float scale) {
+    const int VERTICES_STRIDE = sizeof(GLfloat) * 7;
+    const int VERTICES_COLOR_OFFSET = sizeof(GLfloat) * 3;
+    GLfloat *verticesArray;
+    GLushort *indicesArray;
+    int vertices, indices;
+
+    _parse_ascii_art(art, scale, &verticesArray, &vertices, &indicesArray, &indices);
+
     // create the buffers
     GEOM_DEBUG("Creating output VBO (%d vertices) and IBO (%d indices).", vertices, indices);
     SimpleGeom* out = new SimpleGeom(new VertexBuf(verticesArray, vertices * sizeof(GLfloat) *
@@ -228,3 +245,24 @@ SimpleGeom* AsciiArtToGeom(const char *art, float scale) {
     return out;
 }
 
+GLfloat* AsciiArtToLines(const char *art, float scale, int *outVertexCount) {
+    GLfloat *verticesArray;
+    GLushort *indicesArray;
+    int vertices, indices;
+
+    _parse_ascii_art(art, scale, &verticesArray, &vertices, &indicesArray, &indices);
+
+    // resolve the indices, producing one (x, y) pair per line endpoint
+    GLfloat *out = new GLfloat[indices * 2];
+    for (int i = 0; i < indices; i++) {
+        out[i * 2] = verticesArray[indicesArray[i] * 7];
+        out[i * 2 + 1] = verticesArray[indicesArray[i] * 7 + 1];
+    }
+
+    delete [] verticesArray;
+    delete [] indicesArray;
+
+    *outVertexCount = indices;
+    return out;
+}
+
@@ -38,5 +38,10 @@
  */
 SimpleGeom* AsciiArtToGeom(const char *art, float scale);
 
+/* Same as AsciiArtToGeom, but instead of creating GL buffers, returns a newly allocated
+ * array of (x, y) pairs, two per line (suitable for drawing as GL_LINES). The number of
+ * vertices is returned in outVertexCount. The caller must delete [] the array. */
+GLfloat* AsciiArtToLines(const char *art, float scale, int *outVertexCount);
+
 #endif
 
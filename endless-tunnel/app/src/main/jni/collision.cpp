@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include "collision.hpp"
+#include "util.hpp"
+
+// Returns a bit for every cell along one axis that [lo, hi] touches. The axis starts at
+// -halfSize; positions past either end count as the cell at that end.
+static unsigned _cell_span(float lo, float hi, float halfSize) {
+    int i0 = Clamp((int)floor((lo + halfSize) / OBS_CELL_SIZE), 0, OBS_GRID_SIZE - 1);
+    int i1 = Clamp((int)floor((hi + halfSize) / OBS_CELL_SIZE), 0, OBS_GRID_SIZE - 1);
+    return ((1u << (i1 - i0 + 1)) - 1u) << i0;
+}
+
+// Combines a column span and a row span into a cell mask.
+static unsigned _spans_to_mask(unsigned colSpan, unsigned rowSpan) {
+    unsigned mask = 0;
+    for (int r = 0; r < OBS_GRID_SIZE; r++) {
+        if (rowSpan & (1u << r)) {
+            mask |= colSpan << (r * OBS_GRID_SIZE);
+        }
+    }
+    return mask;
+}
+
+unsigned GetCellFootprintMask(float x, float z, float radius) {
+    return _spans_to_mask(_cell_span(x - radius, x + radius, TUNNEL_HALF_W),
+            _cell_span(z - radius, z + radius, TUNNEL_HALF_H));
+}
+
+bool GetObstaclesEnteredBetween(float firstEntryY, int obstacleCount, float fromY,
+        float toY, int *lo, int *hi) {
+    // the index is computed directly from the spacing rather than searched for
+    *lo = Max((int)floor((fromY - firstEntryY) / TUNNEL_SECTION_LENGTH) + 1, 0);
+    *hi = Min((int)floor((toY - firstEntryY) / TUNNEL_SECTION_LENGTH), obstacleCount - 1);
+    return *lo <= *hi;
+}
+
+void GetCrossingPosition(float entryY, bool isLast, float fromX, float fromY, float fromZ,
+        float toX, float toY, float toZ, float *x, float *z) {
+    if (isLast || !(toY > fromY)) {
+        *x = toX;
+        *z = toZ;
+        return;
+    }
+    float t = (entryY - fromY) / (toY - fromY);
+    *x = fromX + t * (toX - fromX);
+    *z = fromZ + t * (toZ - fromZ);
+}
+
+int TestObstacleCrossing(unsigned solidMask, unsigned bonusMask, float x, float z) {
+    unsigned cell = GetCellFootprintMask(x, z, 0.0f);
+    if (solidMask & cell) {
+        return COLLISION_CRASH;
+    } else if (bonusMask & cell) {
+        return COLLISION_BONUS;
+    } else if (solidMask & GetCellFootprintMask(x, z, CLOSE_CALL_CALC_DELTA)) {
+        return COLLISION_CLOSE_CALL;
+    }
+    return COLLISION_NONE;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_collision_hpp
+#define endlesstunnel_collision_hpp
+
+#include "game_consts.hpp"
+
+// Collision math between the player and the obstacles. It only deals with occupancy
+// bitmasks and positions (no rendering, no game state), so it can be exercised on its
+// own: see tools/collisionTest.
+//
+// Cell (col, row) of an obstacle grid maps to bit (row * OBS_GRID_SIZE + col).
+
+// what the player ran into when crossing an obstacle's entry plane
+#define COLLISION_NONE 0
+#define COLLISION_CRASH 1
+#define COLLISION_BONUS 2
+#define COLLISION_CLOSE_CALL 3
+
+inline unsigned CellBit(int gridCol, int gridRow) {
+    return 1u << (gridRow * OBS_GRID_SIZE + gridCol);
+}
+
+// Returns the mask of the cells touched by a square footprint of the given half-size
+// centered at (x, z). A radius of 0 yields the single cell at (x, z).
+unsigned GetCellFootprintMask(float x, float z, float radius);
+
+// Obstacles are evenly spaced, one per tunnel section; obstacle i has its entry plane at
+// firstEntryY + i * TUNNEL_SECTION_LENGTH. Computes the range [*lo, *hi] of the obstacles
+// (among the first obstacleCount) whose entry plane lies in (fromY, toY]. Returns false
+// if there are none.
+bool GetObstaclesEnteredBetween(float firstEntryY, int obstacleCount, float fromY,
+        float toY, int *lo, int *hi);
+
+// Computes where, on the XZ plane, the player moving from (fromX, fromY, fromZ) to
+// (toX, toY, toZ) during a frame is tested against an obstacle whose entry plane at entryY
+// it crossed. The last obstacle crossed is tested where the player ends the frame, as the
+// game always did; any obstacle crossed before it in the same frame (only possible at high
+// speed) is tested where the player went through its entry plane.
+void GetCrossingPosition(float entryY, bool isLast, float fromX, float fromY, float fromZ,
+        float toX, float toY, float toZ, float *x, float *z);
+
+// Tests the player crossing an obstacle's entry plane at (x, z). Returns COLLISION_CRASH
+// if the player is in a cell with a box, otherwise COLLISION_BONUS if it is in the bonus
+// cell, otherwise COLLISION_CLOSE_CALL if a cell within CLOSE_CALL_CALC_DELTA of the
+// player has a box, otherwise COLLISION_NONE.
+int TestObstacleCrossing(unsigned solidMask, unsigned bonusMask, float x, float z);
+
+#endif
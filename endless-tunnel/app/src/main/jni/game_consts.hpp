@@ -154,6 +154,13 @@
 // save file name
 #define SAVE_FILE_NAME "tunnel.dat"
 
+// minimum interval between two writes of the save file, in seconds (save requests
+// that arrive in between get coalesced)
+#define SAVE_MIN_INTERVAL 1.0f
+
+// how long, in seconds, pausing the app may wait for a pending save to be written
+#define SAVE_FLUSH_TIMEOUT 0.5f
+
 // checkpoint (save progress) every how many levels?
 #define LEVELS_PER_CHECKPOINT 4
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "gl_sprite_target.hpp"
+#include "util.hpp"
+
+GlSpriteTarget::GlSpriteTarget(TrivialShader *ts) {
+    mTrivialShader = ts;
+    mBufferOffset = 0;
+
+    mVertexBuf = new VertexBuf(SpriteBatch::MAX_VERTICES * BUFFER_FLUSHES * VERTEX_STRIDE,
+            VERTEX_STRIDE);
+    mVertexBuf->SetColorsOffset(3 * sizeof(GLfloat));
+}
+
+GlSpriteTarget::~GlSpriteTarget() {
+    CleanUp(&mVertexBuf);
+}
+
+void GlSpriteTarget::BeginFrame() {
+    // orphan last frame's storage so we don't have to sync with the GPU
+    mVertexBuf->BindBuffer();
+    mVertexBuf->Orphan();
+    mVertexBuf->UnbindBuffer();
+    mBufferOffset = 0;
+}
+
+float GlSpriteTarget::GetPixelSize() {
+    // the normalized 2D coordinate system spans the screen height from 0 to 1
+    return 1.0f / SceneManager::GetInstance()->GetScreenHeight();
+}
+
+void GlSpriteTarget::Draw(const GLfloat *vertices, int vertexCount, GLenum primitive,
+        float lineWidth) {
+    MY_ASSERT(vertexCount <= SpriteBatch::MAX_VERTICES);
+
+    float aspect = SceneManager::GetInstance()->GetScreenAspect();
+    glm::mat4 orthoMat = glm::ortho(0.0f, aspect, 0.0f, 1.0f);
+
+    // upload the vertices after the ones we've already drawn this frame; if they
+    // don't fit, orphan the buffer and start from the beginning
+    mVertexBuf->BindBuffer();
+    if ((mBufferOffset + vertexCount) * VERTEX_STRIDE > mVertexBuf->GetCapacity()) {
+        mVertexBuf->Orphan();
+        mBufferOffset = 0;
+    }
+    mVertexBuf->Upload(mBufferOffset * VERTEX_STRIDE, vertices, vertexCount * VERTEX_STRIDE);
+    mVertexBuf->SetPrimitive(primitive);
+
+    bool hadDepthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    if (primitive == GL_LINES) {
+        glLineWidth(lineWidth);
+    }
+
+    // colors are baked into the vertices, so draw without tint
+    mTrivialShader->ResetTintColor();
+    mTrivialShader->BeginRender(mVertexBuf);
+    mTrivialShader->RenderArrays(&orthoMat, mBufferOffset, vertexCount);
+    mTrivialShader->EndRender();
+
+    if (primitive == GL_LINES) {
+        glLineWidth(1);
+    }
+    if (hadDepthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    mBufferOffset += vertexCount;
+}
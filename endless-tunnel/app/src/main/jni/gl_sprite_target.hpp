@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_gl_sprite_target_hpp
+#define endlesstunnel_gl_sprite_target_hpp
+
+#include "engine.hpp"
+#include "sprite_batch.hpp"
+
+/* Draws the geometry of a SpriteBatch with GL. All of it is streamed through a single
+ * vertex buffer that is orphaned when a frame begins, so we never have to wait for the
+ * GPU to finish with the previous frame's vertices. */
+class GlSpriteTarget : public SpriteTarget {
+    private:
+        static const int VERTEX_STRIDE = SpriteBatch::FLOATS_PER_VERTEX * sizeof(GLfloat);
+
+        // how many full runs fit in the GPU buffer before we have to orphan it again
+        static const int BUFFER_FLUSHES = 4;
+
+        TrivialShader *mTrivialShader;
+        VertexBuf *mVertexBuf;
+
+        // where (in vertices) the next draw will be written in the GPU buffer
+        int mBufferOffset;
+
+    public:
+        GlSpriteTarget(TrivialShader *trivialShader);
+        ~GlSpriteTarget();
+
+        virtual void BeginFrame();
+        virtual float GetPixelSize();
+        virtual void Draw(const GLfloat *vertices, int vertexCount, GLenum primitive,
+                float lineWidth);
+};
+
+#endif
@@ -29,3 +29,62 @@ struct JniSetup* GetJNISetup() {
 }
 
 
+
+// Clears any pending Java exception. Returns true if there was one.
+static bool _clear_exception(JNIEnv *env) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return true;
+    }
+    return false;
+}
+
+const char* GetCacheDirPath() {
+    static char path[512];
+    static bool queried = false;
+
+    if (!queried) {
+        queried = true;
+        path[0] = '\0';
+
+        struct JniSetup *setup = GetJNISetup();
+        JNIEnv *env = setup->env;
+        jobject file = NULL;
+        jmethodID getCacheDir = env->GetMethodID(setup->clazz, "getCacheDir",
+                "()Ljava/io/File;");
+        if (!_clear_exception(env) && getCacheDir) {
+            file = env->CallObjectMethod(setup->thiz, getCacheDir);
+            if (_clear_exception(env)) {
+                file = NULL;
+            }
+        }
+
+        if (file) {
+            jclass fileClass = env->GetObjectClass(file);
+            jmethodID getPath = env->GetMethodID(fileClass, "getAbsolutePath",
+                    "()Ljava/lang/String;");
+            jstring str = NULL;
+            if (!_clear_exception(env) && getPath) {
+                str = (jstring)env->CallObjectMethod(file, getPath);
+                if (_clear_exception(env)) {
+                    str = NULL;
+                }
+            }
+            if (str) {
+                const char *chars = env->GetStringUTFChars(str, NULL);
+                if (chars) {
+                    strncpy(path, chars, sizeof(path) - 1);
+                    path[sizeof(path) - 1] = '\0';
+                    env->ReleaseStringUTFChars(str, chars);
+                }
+                env->DeleteLocalRef(str);
+            }
+            env->DeleteLocalRef(fileClass);
+            env->DeleteLocalRef(file);
+        }
+
+        LOGD("Cache directory: %s", path[0] ? path : "(unknown)");
+    }
+
+    return path[0] ? path : NULL;
+}
@@ -25,5 +25,9 @@ struct JniSetup {
 // Does JNI setup (if needed) and returns a struct with convenience objects.
 struct JniSetup* GetJNISetup();
 
+// Returns the app's cache directory (as per Context.getCacheDir()), or NULL if it
+// can't be determined. The result is queried once and then remembered.
+const char* GetCacheDirPath();
+
 #endif
 
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_logging_hpp
+#define endlesstunnel_logging_hpp
+
+// Logging and assertion macros. Code that doesn't need GL or the activity includes
+// just this, rather than common.hpp, so that it also builds on a host for the tests
+// in tools/ (where the log goes to stderr).
+#ifdef __ANDROID__
+extern "C" {
+    #include <android/log.h>
+}
+#define DEBUG_TAG "EndlessTunnel:Native"
+#define LOGD(...) ((void)__android_log_print(ANDROID_LOG_DEBUG, DEBUG_TAG, __VA_ARGS__))
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, DEBUG_TAG, __VA_ARGS__))
+#define LOGW(...) ((void)__android_log_print(ANDROID_LOG_WARN, DEBUG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, DEBUG_TAG, __VA_ARGS__))
+#else
+#include <cstdio>
+#define LOGD(...) ((void)0)
+#define LOGI(...) ((void)(fprintf(stderr, __VA_ARGS__), fputc('\n', stderr)))
+#define LOGW(...) LOGI(__VA_ARGS__)
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+#define ABORT_GAME { LOGE("*** GAME ABORTING."); *((volatile char*)0) = 'a'; }
+#define DEBUG_BLIP LOGD("[ BLIP ]: %s:%d", __FILE__, __LINE__)
+
+#define MY_ASSERT(cond) { if (!(cond)) { LOGE("ASSERTION FAILED: %s", #cond); \
+   ABORT_GAME; } }
+
+#endif
@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 #include "common.hpp"
+#include "game_consts.hpp"
 #include "input_util.hpp"
 #include "joystick-support.hpp"
+#include "save_man.hpp"
 #include "scene_manager.hpp"
+#include "util.hpp"
 #include "welcome_scene.hpp"
 #include "native_engine.hpp"
 
@@ -102,6 +105,12 @@ void NativeEngine::GameLoop() {
         int ident, events;
         struct android_poll_source* source;
 
+        // Stop the game clock while we're not drawing, so that when we come back
+        // the game resumes exactly where it left off instead of jumping ahead.
+        if (!IsAnimating()) {
+            PauseClock();
+        }
+
         // If not animating, block until we get an event; if animating, don't block.
         while ((ident = ALooper_pollAll(IsAnimating() ? 0 : -1, NULL, &events, 
                 (void**)&source)) >= 0) {
@@ -173,7 +182,11 @@ void NativeEngine::HandleCommand(int32_t cmd) {
             break;
         case APP_CMD_PAUSE:
             VLOGD("NativeEngine: APP_CMD_PAUSE");
+            PauseClock();
             mgr->OnPause();
+
+            // we might get killed after this, so don't sit on unsaved progress
+            SaveMan::GetInstance()->Flush(SAVE_FLUSH_TIMEOUT);
             break;
         case APP_CMD_RESUME:
             VLOGD("NativeEngine: APP_CMD_RESUME");
@@ -507,6 +520,9 @@ void NativeEngine::DoFrame() {
 
     SceneManager *mgr = SceneManager::GetInstance();
 
+    // we're about to draw, so the game clock must be running
+    ResumeClock();
+
     // how big is the surface? We query every frame because it's cheap, and some
     // strange devices out there change the surface size without calling any callbacks...
     int width, height;
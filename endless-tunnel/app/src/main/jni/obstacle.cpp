@@ -18,6 +18,21 @@
 
 #define BONUS_PROBABILITY 0.7f
 
+void Obstacle::UpdateMasks() {
+    solidMask = 0;
+    for (int c = 0; c < OBS_GRID_SIZE; c++) {
+        for (int r = 0; r < OBS_GRID_SIZE; r++) {
+            if (grid[c][r]) {
+                solidMask |= CellBit(c, r);
+            }
+        }
+    }
+
+    bool bonusValid = bonusRow >= 0 && bonusRow < OBS_GRID_SIZE &&
+            bonusCol >= 0 && bonusCol < OBS_GRID_SIZE;
+    bonusMask = bonusValid ? CellBit(bonusCol, bonusRow) : 0;
+}
+
 void Obstacle::PutRandomBonus() {
     if (Random(100) * 0.01f > BONUS_PROBABILITY) {
         return;
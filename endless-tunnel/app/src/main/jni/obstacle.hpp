@@ -16,6 +16,7 @@
 #ifndef endlesstunnel_obstacle_hpp
 #define endlesstunnel_obstacle_hpp
 
+#include "collision.hpp"
 #include "engine.hpp"
 #include "game_consts.hpp"
 #include "util.hpp"
@@ -25,11 +26,18 @@
 // a bonus when hit.
 //
 // The obstacle grid lies on the XZ plane.
+//
+// Besides the grid itself, each obstacle keeps a precomputed occupancy bitmask where
+// cell (col, row) maps to bit (row * OBS_GRID_SIZE + col) (see collision.hpp). This lets
+// collision tests be done with a couple of bit operations instead of walking the grid.
+// Whoever modifies the grid must call UpdateMasks() afterwards.
 class Obstacle {
     public:
         bool grid[OBS_GRID_SIZE][OBS_GRID_SIZE]; // indexed as [col][row]
         int style;  // obstacle style (currently, this specifies its color).
         int bonusRow, bonusCol;
+        unsigned solidMask; // bit set for every cell that contains a box
+        unsigned bonusMask; // bit set for the bonus cell (0 if there is no bonus)
         const static int STYLE_NULL = 0;  // a null obstacle (not displayed)
 
         glm::vec3 GetBoxCenter(int gridCol, int gridRow, float posY) {
@@ -55,25 +63,29 @@ class Obstacle {
         void Reset() {
             style = STYLE_NULL;
             bonusRow = bonusCol = -1;
+            solidMask = bonusMask = 0;
             memset(grid, 0, sizeof(grid));
         }
 
         void SetBonus(int col, int row) {
             bonusCol = col;
             bonusRow = row;
+            UpdateMasks();
         }
 
         void PutRandomBonus();
 
         void DeleteBonus() {
             bonusCol = bonusRow = -1;
+            bonusMask = 0;
         }
 
         bool HasBonus() {
-            return bonusRow >= 0 && bonusRow < OBS_GRID_SIZE &&
-                    bonusCol >= 0 && bonusCol < OBS_GRID_SIZE &&
-                    !grid[bonusCol][bonusRow];
+            return 0 != (bonusMask & ~solidMask);
         }
+
+        // recomputes solidMask and bonusMask from the grid and the bonus position.
+        void UpdateMasks();
 };
 
 #endif
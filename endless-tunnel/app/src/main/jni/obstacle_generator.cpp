@@ -52,6 +52,7 @@ void ObstacleGenerator::Generate(Obstacle *result) {
         GenHard(result);
     }
     result->PutRandomBonus();
+    result->UpdateMasks();
 }
 
 void ObstacleGenerator::FillRow(Obstacle *result, int row) {
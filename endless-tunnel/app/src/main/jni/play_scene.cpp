@@ -17,8 +17,10 @@
 #include "anim.hpp"
 #include "ascii_to_geom.hpp"
 #include "game_consts.hpp"
+#include "jni_util.hpp"
 #include "our_shader.hpp"
 #include "play_scene.hpp"
+#include "save_man.hpp"
 #include "util.hpp"
 #include "welcome_scene.hpp"
 #include "welcome_scene.hpp"
@@ -29,6 +31,16 @@
 #include "data/tunnel_geom.inl"
 
 #define WALL_TEXTURE_SIZE 64
+#define WALL_TEXTURE_BORDER 3
+#define WALL_TEXTURE_BASE 128
+#define WALL_TEXTURE_NOISE 128
+#define WALL_TEXTURE_SEED 1337
+
+// use trilinear filtering on the walls? (smoother, but more texture bandwidth)
+#define WALL_TEXTURE_TRILINEAR true
+
+// the bonus spins at 90 rad/s; this is how long a full turn takes
+#define BONUS_SPIN_PERIOD ((float)(2.0 * M_PI / 90.0))
 
 // colors for menus
 static const float MENUITEM_SEL_COLOR[] = { 1.0f, 1.0f, 0.0f };
@@ -62,6 +74,7 @@ PlayScene::PlayScene() : Scene() {
     mTrivialShader = NULL;
     mTextRenderer = NULL;
     mShapeRenderer = NULL;
+    mSpriteBatch = NULL;
     mShipSteerX = mShipSteerZ = 0.0f;
     mFilteredSteerX = mFilteredSteerZ = 0.0f;
 
@@ -80,6 +93,18 @@ PlayScene::PlayScene() : Scene() {
     mPointerAnchorX = mPointerAnchorY = 0.0f;
 
     mWallTexture = NULL;
+    mWallTextureIsPlaceholder = false;
+
+    // start generating the wall texture right away, so that by the time we have
+    // graphics it will (most likely) be done
+    WallTextureGen::Params wallParams;
+    wallParams.size = WALL_TEXTURE_SIZE;
+    wallParams.border = WALL_TEXTURE_BORDER;
+    wallParams.base = WALL_TEXTURE_BASE;
+    wallParams.noise = WALL_TEXTURE_NOISE;
+    wallParams.seed = WALL_TEXTURE_SEED;
+    mWallTextureGen = new WallTextureGen(wallParams);
+    mWallTextureGen->Start(GetCacheDirPath());
 
     memset(mMenuItemText, 0, sizeof(mMenuItemText));
     mMenuItemText[MENUITEM_UNPAUSE] = S_UNPAUSE;
@@ -105,12 +130,13 @@ PlayScene::PlayScene() : Scene() {
 
     mPlayerSpeed = 0.0f;
     mBlinkingHeart = false;
-    mGameStartTime = Clock();
+    mGameStartTime = ClockNs();
 
     mBonusInARow = 0;
     mLastCrashSection = -1;
 
     mFrameClock.SetMaxDelta(MAX_DELTA_T);
+    mFrameClock.SetSmoothing(true);
     mLastAmbientBeepEmitted = 0;
     mMenuTouchActive = false;
 
@@ -137,27 +163,22 @@ PlayScene::PlayScene() : Scene() {
     }
 }
 
+PlayScene::~PlayScene() {
+    CleanUp(&mWallTextureGen);
+}
+
 void PlayScene::LoadProgress() {
     // try to load save file
     mSavedCheckpoint = 0;
 
     LOGD("Attempting to load: %s", mSaveFileName);
-    FILE *f = fopen(mSaveFileName, "r");
-    bool hasLocalFile = false;
-    if (f) {
-        hasLocalFile = true;
-        LOGD("File found. Loading data.");
-        if (1 != fscanf(f, "v1 %d", &mSavedCheckpoint)) {
-            LOGE("Error parsing save file.");
-            mSavedCheckpoint = 0;
-        } else {
-            LOGD("Loaded. Level = %d", mSavedCheckpoint);
-            mSavedCheckpoint = (mSavedCheckpoint / LEVELS_PER_CHECKPOINT) * LEVELS_PER_CHECKPOINT;
-            LOGD("Normalized check-point: level %d", mSavedCheckpoint);
-        }
-        fclose(f);
-    } else {
-        LOGD("Save file not present.");
+    SaveMan::SaveData data;
+    bool hasLocalFile = SaveMan::GetInstance()->Load(mSaveFileName, &data);
+    if (hasLocalFile) {
+        mSavedCheckpoint = data.level;
+        LOGD("Loaded. Level = %d", mSavedCheckpoint);
+        mSavedCheckpoint = (mSavedCheckpoint / LEVELS_PER_CHECKPOINT) * LEVELS_PER_CHECKPOINT;
+        LOGD("Normalized check-point: level %d", mSavedCheckpoint);
     }
 
     // check cloud save.
@@ -181,15 +202,11 @@ void PlayScene::LoadProgress() {
 }
 
 void PlayScene::WriteSaveFile(int level) {
+    // this just queues the data; the actual write happens in the background
     LOGD("Saving progress (level %d) to file: %s", level, mSaveFileName);
-    FILE *f = fopen(mSaveFileName, "w");
-    if (!f) {
-        LOGE("Error writing to save game file.");
-        return;
-    }
-    fprintf(f, "v1 %d", level);
-    fclose(f);
-    LOGD("Save file written.");
+    SaveMan::SaveData data;
+    data.level = level;
+    SaveMan::GetInstance()->RequestSave(mSaveFileName, data);
 }
 
 void PlayScene::SaveProgress() {
@@ -221,16 +238,25 @@ void PlayScene::SaveProgress() {
     mCheckpointSignPending = true;
 }
 
-static unsigned char* _gen_wall_texture() {
-    static unsigned char pixel_data[WALL_TEXTURE_SIZE * WALL_TEXTURE_SIZE * 3];
-    unsigned char *p;
-    int x, y;
-    for (y = 0, p = pixel_data; y < WALL_TEXTURE_SIZE; y++) {
-        for (x = 0; x < WALL_TEXTURE_SIZE; x++, p += 3) {
-            p[0] = p[1] = p[2] = 128 + ((x > 2 && y > 2) ? Random(128) : 0);
-        }
+void PlayScene::UpdateWallTexture() {
+    if (mWallTexture && !mWallTextureIsPlaceholder) {
+        // already have the real thing
+        return;
+    }
+
+    if (mWallTextureGen->IsReady()) {
+        CleanUp(&mWallTexture);
+        mWallTexture = mWallTextureGen->CreateTexture(WALL_TEXTURE_TRILINEAR);
+        mWallTextureIsPlaceholder = false;
+    } else if (!mWallTexture) {
+        // not ready yet; use a plain texture of the base color for now
+        static const unsigned char placeholder[] = {
+            WALL_TEXTURE_BASE, WALL_TEXTURE_BASE, WALL_TEXTURE_BASE
+        };
+        mWallTexture = new Texture();
+        mWallTexture->InitFromRawRGB(1, 1, false, placeholder);
+        mWallTextureIsPlaceholder = true;
     }
-    return pixel_data;
 }
 
 void PlayScene::OnStartGraphics() {
@@ -255,10 +281,8 @@ void PlayScene::OnStartGraphics() {
     mCubeGeom->vbuf->SetColorsOffset(CUBE_GEOM_COLOR_OFFSET);
     mCubeGeom->vbuf->SetTexCoordsOffset(CUBE_GEOM_TEXCOORD_OFFSET);
 
-    // make the wall texture
-    mWallTexture = new Texture();
-    mWallTexture->InitFromRawRGB(WALL_TEXTURE_SIZE, WALL_TEXTURE_SIZE, false,
-            _gen_wall_texture());
+    // make the wall texture (or a placeholder, if it's still being generated)
+    UpdateWallTexture();
 
     // reset frame clock so the animation doesn't jump
     mFrameClock.Reset();
@@ -269,11 +293,15 @@ void PlayScene::OnStartGraphics() {
     // create text renderer and shape renderer
     mTextRenderer = new TextRenderer(mTrivialShader);
     mShapeRenderer = new ShapeRenderer(mTrivialShader);
+    mSpriteBatch = new SpriteBatch(new GlSpriteTarget(mTrivialShader));
+    mTextRenderer->SetSpriteBatch(mSpriteBatch);
+    mShapeRenderer->SetSpriteBatch(mSpriteBatch);
 }
 
 void PlayScene::OnKillGraphics() {
     CleanUp(&mTextRenderer);
     CleanUp(&mShapeRenderer);
+    CleanUp(&mSpriteBatch);
     CleanUp(&mOurShader);
     CleanUp(&mTrivialShader);
     CleanUp(&mTunnelGeom);
@@ -284,7 +312,10 @@ void PlayScene::OnKillGraphics() {
 
 void PlayScene::DoFrame() {
     float deltaT = mFrameClock.ReadDelta();
-    float previousY = mPlayerPos.y;
+    glm::vec3 previousPos = mPlayerPos;
+
+    // swap in the wall texture as soon as it's ready
+    UpdateWallTexture();
 
     // clear screen
     glClearColor(0.0, 0.0, 0.0, 1.0);
@@ -333,7 +364,7 @@ void PlayScene::DoFrame() {
     }
 
     // deduct from the time remaining on the blinking heart animation
-    if (mBlinkingHeart && Clock() > mBlinkingHeartExpire) {
+    if (mBlinkingHeart && ClockNs() > mBlinkingHeartExpire) {
         mBlinkingHeart = false;
     }
 
@@ -371,15 +402,16 @@ void PlayScene::DoFrame() {
     mPlayerPos.x = Clamp(mPlayerPos.x, PLAYER_MIN_X, PLAYER_MAX_X);
     mPlayerPos.z = Clamp(mPlayerPos.z, PLAYER_MIN_Z, PLAYER_MAX_Z);
 
+    // detect collisions, before shifting: a long frame may have carried the player past
+    // the end of sections whose obstacles it still has to be tested against
+    DetectCollisions(previousPos);
+
     // shift sections if needed
     ShiftIfNeeded();
 
     // generate more obstacles!
     GenObstacles();
 
-    // detect collisions
-    DetectCollisions(previousY);
-
     // update ship's roll speed according to level
     static float roll_speeds[] = ROLL_SPEEDS;
     int count = sizeof(roll_speeds) / sizeof(float);
@@ -393,7 +425,7 @@ void PlayScene::DoFrame() {
     }
 
     // did the game expire?
-    if (mLives <= 0 && Clock() > mGameOverExpire) {
+    if (mLives <= 0 && ClockNs() > mGameOverExpire) {
         SceneManager::GetInstance()->RequestNewScene(new WelcomeScene());
 
     }
@@ -489,7 +521,8 @@ void PlayScene::RenderObstacles() {
                     modelMat = glm::translate(glm::mat4(1.0f), o->GetBoxCenter(c, r, posY));
                     modelMat = glm::scale(modelMat, glm::vec3(OBS_BONUS_SIZE, OBS_BONUS_SIZE,
                             OBS_BONUS_SIZE));
-                    modelMat = glm::rotate(modelMat, Clock() * 90.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+                    modelMat = glm::rotate(modelMat, ClockPeriodic(BONUS_SPIN_PERIOD) * 90.0f,
+                            glm::vec3(0.0f, 0.0f, 1.0f));
                     mvpMat = mProjMat * mViewMat * modelMat;
                     mOurShader->SetTintColor(SineWave(0.8f, 1.0f, 0.5f, 0.0f),
                             SineWave(0.8f, 1.0f, 0.5f, 0.0f),
@@ -595,6 +628,7 @@ void PlayScene::RenderHUD() {
     glm::mat4 mat;
 
     glDisable(GL_DEPTH_TEST);
+    mSpriteBatch->Begin();
 
     // render score digits
     int i, unit;
@@ -611,7 +645,7 @@ void PlayScene::RenderHUD() {
     // render current sign
     if (mSignText) {
         modelMat = glm::mat4(1.0f);
-        float t = Clock() - mSignStartTime;
+        float t = SecondsSince(mSignStartTime);
         if (t < SIGN_ANIM_DUR) {
             float scale = t / SIGN_ANIM_DUR;
             modelMat = glm::scale(modelMat, glm::vec3(1.0f, scale, 1.0f));
@@ -638,6 +672,7 @@ void PlayScene::RenderHUD() {
         modelMat = glm::translate(modelMat, glm::vec3(LIFE_SPACING_X, 0.0f, 0.0f));
     }
 
+    mSpriteBatch->End();
     glEnable(GL_DEPTH_TEST);
 }
 
@@ -647,6 +682,7 @@ void PlayScene::RenderMenu() {
     glm::mat4 mat;
 
     glDisable(GL_DEPTH_TEST);
+    mSpriteBatch->Begin();
 
     RenderBackgroundAnimation(mShapeRenderer);
 
@@ -663,90 +699,92 @@ void PlayScene::RenderMenu() {
     }
     mTextRenderer->ResetColor();
 
+    mSpriteBatch->End();
     glEnable(GL_DEPTH_TEST);
 }
 
-void PlayScene::DetectCollisions(float previousY) {
-    Obstacle *o = GetObstacleAt(0);
-    float obsCenter = GetSectionCenterY(mFirstSection);
-    float obsMin = obsCenter - OBS_BOX_SIZE;
-    float curY = mPlayerPos.y;
+bool PlayScene::GetObstaclesEnteredBetween(float fromY, float toY, int *lo, int *hi) {
+    return ::GetObstaclesEnteredBetween(GetSectionCenterY(mFirstSection) - OBS_BOX_SIZE,
+            mObstacleCount, fromY, toY, lo, hi);
+}
 
-    if (!o || !(previousY < obsMin && curY >= obsMin)) {
-        // no collision
+void PlayScene::DetectCollisions(const glm::vec3& previousPos) {
+    float curY = mPlayerPos.y;
+    int lo, hi;
+    if (!(curY > previousPos.y) || !GetObstaclesEnteredBetween(previousPos.y, curY, &lo, &hi)) {
+        // no collision (if not moving forward, we can't enter any obstacle)
         return;
     }
 
-    // what row/column is the player on?
-    int col = o->GetColAt(mPlayerPos.x);
-    int row = o->GetRowAt(mPlayerPos.z);
-
-    if (o->grid[col][row]) {
-        // crashed against obstacle
-        mLives--;
-        if (mLives > 0) {
-            ShowSign(S_OUCH, SIGN_DURATION);
-            SfxMan::GetInstance()->PlayTone(TONE_CRASHED);
-        } else {
-            // say "Game Over"
-            ShowSign(S_GAME_OVER, SIGN_DURATION_GAME_OVER);
-            SfxMan::GetInstance()->PlayTone(TONE_GAME_OVER);
-            mGameOverExpire = Clock() + GAME_OVER_EXPIRE;
-        }
-        mPlayerPos.y = obsMin - PLAYER_RECEDE_AFTER_COLLISION;
-        mPlayerSpeed = PLAYER_SPEED_AFTER_COLLISION;
-        mBlinkingHeart = true;
-        mBlinkingHeartExpire = Clock() + BLINKING_HEART_DURATION;
-
-        mLastCrashSection = mFirstSection;
+    // A long frame may cross several entry planes; test every one of them in order, so
+    // that no matter how far the player moved in this frame, we never skip over an
+    // obstacle.
+    for (int index = lo; index <= hi; index++) {
+        Obstacle *o = GetObstacleAt(index);
+        float obsMin = GetSectionCenterY(mFirstSection + index) - OBS_BOX_SIZE;
+
+        // where on the XZ plane the player met this obstacle
+        float hitX, hitZ;
+        GetCrossingPosition(obsMin, index == hi, previousPos.x, previousPos.y, previousPos.z,
+                mPlayerPos.x, curY, mPlayerPos.z, &hitX, &hitZ);
+
+        int result = TestObstacleCrossing(o->solidMask, o->bonusMask, hitX, hitZ);
+        if (result == COLLISION_CRASH) {
+            // crashed against obstacle
+            mLives--;
+            if (mLives > 0) {
+                ShowSign(S_OUCH, SIGN_DURATION);
+                SfxMan::GetInstance()->PlayTone(TONE_CRASHED);
+            } else {
+                // say "Game Over"
+                ShowSign(S_GAME_OVER, SIGN_DURATION_GAME_OVER);
+                SfxMan::GetInstance()->PlayTone(TONE_GAME_OVER);
+                mGameOverExpire = ClockNs() + SecondsToNs(GAME_OVER_EXPIRE);
+            }
+            mPlayerPos.x = hitX;
+            mPlayerPos.y = obsMin - PLAYER_RECEDE_AFTER_COLLISION;
+            mPlayerPos.z = hitZ;
+            mPlayerSpeed = PLAYER_SPEED_AFTER_COLLISION;
+            mBlinkingHeart = true;
+            mBlinkingHeartExpire = ClockNs() + SecondsToNs(BLINKING_HEART_DURATION);
 
-    } else if (row == o->bonusRow && col == o->bonusCol) {
-        ShowSign(S_GOT_BONUS, SIGN_DURATION_BONUS);
-        o->DeleteBonus();
-        AddScore(BONUS_POINTS);
-        mBonusInARow++;
+            mLastCrashSection = mFirstSection + index;
 
-        if (mBonusInARow >= 10) {
-            mBonusInARow = 0;
+            // the player was pushed back, so the obstacles past this one weren't reached
+            return;
         }
 
-        // update difficulty level, if applicable
-        int score = GetScore();
-        if (mDifficulty < score / SCORE_PER_LEVEL) {
-            mDifficulty = score / SCORE_PER_LEVEL;
-            ShowLevelSign();
-            mObstacleGen.SetDifficulty(mDifficulty);
-            SfxMan::GetInstance()->PlayTone(TONE_LEVEL_UP);
+        if (result == COLLISION_BONUS) {
+            ShowSign(S_GOT_BONUS, SIGN_DURATION_BONUS);
+            o->DeleteBonus();
+            AddScore(BONUS_POINTS);
+            mBonusInARow++;
 
-            // save progress, if needed
-            SaveProgress();
-        } else {
-            int tone = (score % SCORE_PER_LEVEL) / BONUS_POINTS - 1;
-            tone = tone < 0 ? 0 :
-                   tone >= static_cast<int>(sizeof(TONE_BONUS)/sizeof(char*)) ?
-                   static_cast<int>(sizeof(TONE_BONUS)/sizeof(char*) - 1) : tone;
-            SfxMan::GetInstance()->PlayTone(TONE_BONUS[tone]);
-        }
+            if (mBonusInARow >= 10) {
+                mBonusInARow = 0;
+            }
 
-    } else if (o->HasBonus()) {
-        // player missed bonus!
-        mBonusInARow = 0;
-    }
-
-    // was it a close call?
-    if (!o->grid[col][row]) {
-        bool isCloseCall = false;
-        for (int i = -1; i <= 1 && !isCloseCall; i++) {
-            for (int j = -1; j <= 1; j++) {
-                int other_row = o->GetColAt(mPlayerPos.x + i * CLOSE_CALL_CALC_DELTA);
-                int other_col = o->GetRowAt(mPlayerPos.z + j * CLOSE_CALL_CALC_DELTA);
-                if (o->grid[other_col][other_row]) {
-                    isCloseCall = true;
-                    break;
-                }
+            // update difficulty level, if applicable
+            int score = GetScore();
+            if (mDifficulty < score / SCORE_PER_LEVEL) {
+                mDifficulty = score / SCORE_PER_LEVEL;
+                ShowLevelSign();
+                mObstacleGen.SetDifficulty(mDifficulty);
+                SfxMan::GetInstance()->PlayTone(TONE_LEVEL_UP);
+
+                // save progress, if needed
+                SaveProgress();
+            } else {
+                int tone = (score % SCORE_PER_LEVEL) / BONUS_POINTS - 1;
+                tone = tone < 0 ? 0 :
+                       tone >= static_cast<int>(sizeof(TONE_BONUS)/sizeof(char*)) ?
+                       static_cast<int>(sizeof(TONE_BONUS)/sizeof(char*) - 1) : tone;
+                SfxMan::GetInstance()->PlayTone(TONE_BONUS[tone]);
             }
+        } else if (o->HasBonus()) {
+            // player missed bonus!
+            mBonusInARow = 0;
         }
-
     }
 }
 
@@ -17,12 +17,14 @@
 #define endlesstunnel_play_scene_h
 
 #include "engine.hpp"
+#include "gl_sprite_target.hpp"
 #include "obstacle_generator.hpp"
 #include "obstacle.hpp"
 #include "sfxman.hpp"
 #include "shape_renderer.hpp"
 #include "text_renderer.hpp"
 #include "util.hpp"
+#include "wall_texture.hpp"
 
 class OurShader;
 
@@ -31,6 +33,7 @@ class OurShader;
 class PlayScene : public Scene {
     public:
         PlayScene();
+        virtual ~PlayScene();
         virtual void OnStartGraphics();
         virtual void OnKillGraphics();
         virtual void DoFrame();
@@ -48,13 +51,19 @@ class PlayScene : public Scene {
         OurShader *mOurShader;
         TrivialShader *mTrivialShader;
 
-        // the wall texture
+        // the wall texture, and the generator that produces its pixels in the background.
+        // Until the pixels are ready, mWallTexture is a plain placeholder.
         Texture *mWallTexture;
+        WallTextureGen *mWallTextureGen;
+        bool mWallTextureIsPlaceholder;
 
         // shape and text renderers we use when rendering the HUD
         ShapeRenderer *mShapeRenderer;
         TextRenderer *mTextRenderer;
 
+        // batch through which the HUD and menu text and shapes are drawn
+        SpriteBatch *mSpriteBatch;
+
         // matrices
         glm::mat4 mViewMat, mProjMat;
 
@@ -123,7 +132,7 @@ class PlayScene : public Scene {
         const char *mSignText;
         bool mSignExpires; // does the sign expire after a while?
         float mSignTimeLeft; // for how much longer the sign will still be on screen
-        float mSignStartTime; // time when sign was shown
+        int64_t mSignStartTime; // time when sign was shown (ClockNs)
 
         // did we already show the instructions?
         bool mShowedHowto;
@@ -164,14 +173,14 @@ class PlayScene : public Scene {
 
         // are we showing the "just lost a heart" animation? If so, when does it expire?
         bool mBlinkingHeart;
-        float mBlinkingHeartExpire;
+        int64_t mBlinkingHeartExpire;
 
         // when should the game expire? This will be set after the game is over (mLives <= 0)
         // and indicates when we should return to the main screen
-        float mGameOverExpire;
+        int64_t mGameOverExpire;
 
         // time when game started
-        float mGameStartTime;
+        int64_t mGameStartTime;
 
         // how many bonuses were collected without missing one?
         int mBonusInARow;
@@ -225,20 +234,26 @@ class PlayScene : public Scene {
         // that came into view)
         void ShiftIfNeeded();
 
-        // detect if the player hit obstacles or got the bonus
-        void DetectCollisions(float previousY);
+        // detect if the player hit obstacles or got the bonus while moving from
+        // previousPos to the current position
+        void DetectCollisions(const glm::vec3& previousPos);
+
+        // computes the range [*lo, *hi] of the obstacles (indices relative to
+        // mFirstObstacle) whose entry plane lies in (fromY, toY]; returns false if
+        // there are none.
+        bool GetObstaclesEnteredBetween(float fromY, float toY, int *lo, int *hi);
 
         // shows a text sign on the middle of the screen
         void ShowSign(const char* sign, float timeout) {
             mSignTimeLeft = timeout;
             mSignText = sign;
             mSignExpires = true;
-            mSignStartTime = Clock();
+            mSignStartTime = ClockNs();
         }
         void ShowSign(const char* sign) {
             mSignText = sign;
             mSignExpires = false;
-            mSignStartTime = Clock();
+            mSignStartTime = ClockNs();
         }
         Obstacle* GetObstacleAt(int i) {
             return &mObstacleCircBuf[(mFirstObstacle + i) % MAX_OBS];
@@ -274,6 +289,9 @@ class PlayScene : public Scene {
 
         // update projection matrix
         void UpdateProjectionMatrix();
+
+        // replaces the placeholder wall texture with the real one, if it's ready
+        void UpdateWallTexture();
 };
 
 #endif
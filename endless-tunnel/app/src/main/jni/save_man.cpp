@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include "game_consts.hpp"
+#include "logging.hpp"
+#include "save_man.hpp"
+#include "util.hpp"
+
+#define SAVE_MAGIC 0x56535445 // "ETSV"
+#define SAVE_FORMAT_VERSION 2
+
+// pthread_condattr_setclock() only exists from API 21 on; older (32-bit) bionic has
+// pthread_cond_timedwait_monotonic_np() instead.
+#if defined(__ANDROID__) && __ANDROID_API__ < 21
+#define SAVE_MAN_TIMEDWAIT_MONOTONIC_NP
+#endif
+
+// on-disk format of a save record
+struct SaveRecord {
+    unsigned magic;
+    unsigned version;
+    unsigned sequence; // incremented on every write (useful for debugging)
+    int level;
+    unsigned checksum; // of all the fields above
+};
+
+static SaveMan *_instance = new SaveMan();
+
+SaveMan* SaveMan::GetInstance() {
+    return _instance ? _instance : (_instance = new SaveMan());
+}
+
+static unsigned _checksum(const SaveRecord *rec) {
+    // FNV-1a over everything but the checksum itself
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(rec);
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(SaveRecord, checksum); i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int64_t _monotonic_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000LL + (int64_t)t.tv_nsec;
+}
+
+// Waits on a condition variable created by SaveMan until the given CLOCK_MONOTONIC time.
+static int _timed_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, int64_t deadlineNs) {
+    struct timespec deadline;
+    deadline.tv_sec = (time_t)(deadlineNs / 1000000000LL);
+    deadline.tv_nsec = (long)(deadlineNs % 1000000000LL);
+#ifdef SAVE_MAN_TIMEDWAIT_MONOTONIC_NP
+    return pthread_cond_timedwait_monotonic_np(cond, mutex, &deadline);
+#else
+    return pthread_cond_timedwait(cond, mutex, &deadline);
+#endif
+}
+
+SaveMan::SaveMan() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+#ifndef SAVE_MAN_TIMEDWAIT_MONOTONIC_NP
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mCond, &attr);
+    pthread_cond_init(&mDoneCond, &attr);
+    pthread_condattr_destroy(&attr);
+    mThreadStarted = false;
+    memset(&mPending, 0, sizeof(mPending));
+    memset(&mWriting, 0, sizeof(mWriting));
+    mHasPending = false;
+    mHasWriting = false;
+    mFlushRequested = false;
+    mSequence = 0;
+}
+
+bool SaveMan::Load(const char *fileName, SaveData *outData) {
+    // if a save for this file is still in flight, that's the freshest data: first the
+    // pending one, then the one being written (which may not have reached the file yet)
+    pthread_mutex_lock(&mMutex);
+    bool inFlight = false;
+    if (mHasPending && 0 == strcmp(mPending.fileName, fileName)) {
+        *outData = mPending.data;
+        inFlight = true;
+    } else if (mHasWriting && 0 == strcmp(mWriting.fileName, fileName)) {
+        *outData = mWriting.data;
+        inFlight = true;
+    }
+    pthread_mutex_unlock(&mMutex);
+    if (inFlight) {
+        LOGD("SaveMan: using pending save data for %s", fileName);
+        return true;
+    }
+
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        LOGD("SaveMan: save file %s not present.", fileName);
+        return false;
+    }
+
+    SaveRecord rec;
+    bool ok = false;
+    if (1 == fread(&rec, sizeof(rec), 1, f) && rec.magic == SAVE_MAGIC) {
+        if (rec.version != SAVE_FORMAT_VERSION || rec.checksum != _checksum(&rec)) {
+            LOGE("SaveMan: save file %s is corrupt or has an unknown version.", fileName);
+        } else {
+            outData->level = rec.level;
+            ok = true;
+        }
+    } else {
+        // not a binary record; maybe it's the old text format ("v1 <level>")
+        rewind(f);
+        int level;
+        if (1 == fscanf(f, "v1 %d", &level)) {
+            LOGD("SaveMan: loaded legacy save file %s", fileName);
+            outData->level = level;
+            ok = true;
+        } else {
+            LOGE("SaveMan: error parsing save file %s", fileName);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+void SaveMan::RequestSave(const char *fileName, const SaveData& data) {
+    MY_ASSERT(strlen(fileName) < MAX_FILE_NAME);
+
+    pthread_mutex_lock(&mMutex);
+    if (!mThreadStarted) {
+        pthread_t thread;
+        if (0 == pthread_create(&thread, NULL, ThreadProc, this)) {
+            pthread_detach(thread);
+            mThreadStarted = true;
+        } else {
+            LOGE("SaveMan: failed to start worker thread.");
+        }
+    }
+    strcpy(mPending.fileName, fileName);
+    mPending.data = data;
+    mHasPending = true;
+    bool threadStarted = mThreadStarted;
+    pthread_cond_signal(&mCond);
+    pthread_mutex_unlock(&mMutex);
+
+    if (!threadStarted) {
+        // no worker thread; as a last resort, write synchronously
+        pthread_mutex_lock(&mMutex);
+        Request req = mPending;
+        mHasPending = false;
+        unsigned sequence = ++mSequence;
+        pthread_mutex_unlock(&mMutex);
+        WriteRecord(req, sequence);
+    }
+}
+
+bool SaveMan::Flush(float timeout) {
+    int64_t deadline = _monotonic_ns() + (int64_t)(timeout * 1e9);
+
+    pthread_mutex_lock(&mMutex);
+    if (mHasPending) {
+        mFlushRequested = true;
+        pthread_cond_signal(&mCond);
+    }
+    int err = 0;
+    while ((mHasPending || mHasWriting) && err != ETIMEDOUT) {
+        err = _timed_wait(&mDoneCond, &mMutex, deadline);
+    }
+    bool done = !mHasPending && !mHasWriting;
+    pthread_mutex_unlock(&mMutex);
+
+    if (!done) {
+        LOGW("SaveMan: flush timed out; the save is still being written.");
+    }
+    return done;
+}
+
+void* SaveMan::ThreadProc(void *arg) {
+    static_cast<SaveMan*>(arg)->ThreadLoop();
+    return NULL;
+}
+
+void SaveMan::ThreadLoop() {
+    // time of the last write (CLOCK_MONOTONIC, like our condition variables)
+    int64_t lastWrite = 0;
+    int64_t interval = (int64_t)(SAVE_MIN_INTERVAL * 1e9);
+
+    pthread_mutex_lock(&mMutex);
+    while (1) {
+        while (!mHasPending) {
+            pthread_cond_wait(&mCond, &mMutex);
+        }
+
+        // coalesce: don't write more often than SAVE_MIN_INTERVAL, unless asked to flush
+        while (!mFlushRequested &&
+                ETIMEDOUT != _timed_wait(&mCond, &mMutex, lastWrite + interval)) {
+            // woken up before the deadline (new data or a flush request); keep waiting
+        }
+
+        mWriting = mPending;
+        mHasWriting = true;
+        mHasPending = false;
+        mFlushRequested = false;
+        unsigned sequence = ++mSequence;
+
+        pthread_mutex_unlock(&mMutex);
+        WriteRecord(mWriting, sequence);
+        lastWrite = _monotonic_ns();
+        pthread_mutex_lock(&mMutex);
+
+        mHasWriting = false;
+        pthread_cond_broadcast(&mDoneCond);
+    }
+}
+
+bool SaveMan::WriteRecord(const Request& req, unsigned sequence) {
+    SaveRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = SAVE_MAGIC;
+    rec.version = SAVE_FORMAT_VERSION;
+    rec.sequence = sequence;
+    rec.level = req.data.level;
+    rec.checksum = _checksum(&rec);
+
+    char tmpName[MAX_FILE_NAME + 4];
+    snprintf(tmpName, sizeof(tmpName), "%s.tmp", req.fileName);
+
+    LOGD("SaveMan: writing level %d to %s", rec.level, req.fileName);
+    FILE *f = fopen(tmpName, "wb");
+    if (!f) {
+        LOGE("SaveMan: error creating %s", tmpName);
+        return false;
+    }
+    bool ok = 1 == fwrite(&rec, sizeof(rec), 1, f);
+    ok = ok && 0 == fflush(f);
+    ok = ok && 0 == fsync(fileno(f));
+    ok = (0 == fclose(f)) && ok;
+
+    // the rename is atomic: readers see either the old file or the new one
+    if (!ok || 0 != rename(tmpName, req.fileName)) {
+        LOGE("SaveMan: error writing save file %s", req.fileName);
+        remove(tmpName);
+        return false;
+    }
+
+    // make the rename itself durable, or a power loss could bring back the old file
+    if (!SyncParentDir(req.fileName)) {
+        LOGW("SaveMan: could not sync the directory of %s", req.fileName);
+    }
+    LOGD("SaveMan: save file written.");
+    return true;
+}
+
+bool SaveMan::SyncParentDir(const char *fileName) {
+    char dirName[MAX_FILE_NAME];
+    const char *slash = strrchr(fileName, '/');
+    if (!slash) {
+        strcpy(dirName, ".");
+    } else if (slash == fileName) {
+        strcpy(dirName, "/");
+    } else {
+        snprintf(dirName, sizeof(dirName), "%.*s", (int)(slash - fileName), fileName);
+    }
+
+    int fd = open(dirName, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = 0 == fsync(fd);
+    close(fd);
+    return ok;
+}
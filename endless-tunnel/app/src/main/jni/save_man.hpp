@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_save_man_hpp
+#define endlesstunnel_save_man_hpp
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Save game manager. This class is a singleton that persists the player's progress on
+ * a background thread, so that a slow flash write never stalls the game thread.
+ *
+ * Save requests only copy the data into a pending record and return. The worker thread
+ * writes at most one record every SAVE_MIN_INTERVAL, so bursts of requests are coalesced
+ * into a single write of the most recent data. Each write goes to a temporary file that
+ * is fsync'ed and then renamed over the save file, and the directory is fsync'ed after
+ * the rename, so a crash or power loss at any point leaves either the old or the new
+ * save intact, never a torn one. Records carry a checksum, so a corrupt file is
+ * detected and ignored on load.
+ *
+ * The worker waits on the monotonic clock, so changes to the wall clock don't make it
+ * write early or late. */
+class SaveMan {
+    public:
+        // the data we persist
+        struct SaveData {
+            int level;
+        };
+
+        SaveMan();
+
+        // Returns the (singleton) instance of SaveMan
+        static SaveMan* GetInstance();
+
+        // Loads the save data from the given file. If there's a save request for that file
+        // that hasn't been written yet (or is being written), returns that instead.
+        // Returns false if there is no valid save data.
+        bool Load(const char *fileName, SaveData *outData);
+
+        // Requests that the given data be saved to the given file. Returns immediately.
+        void RequestSave(const char *fileName, const SaveData& data);
+
+        // Asks for the pending save (if any) to be written right away, without waiting for
+        // the coalescing interval, and waits until it is on disk, for up to timeout
+        // seconds. Returns whether everything requested so far has been written. Call
+        // this when the app is paused, since the process might be killed afterwards.
+        bool Flush(float timeout);
+
+    private:
+        static const int MAX_FILE_NAME = 256;
+
+        // a save request: the data and where to write it
+        struct Request {
+            char fileName[MAX_FILE_NAME];
+            SaveData data;
+        };
+
+        pthread_mutex_t mMutex;
+        pthread_cond_t mCond;     // signaled when there's a new request or a flush
+        pthread_cond_t mDoneCond; // signaled when the worker finishes a write
+        bool mThreadStarted;
+
+        // double buffer: the game thread fills mPending, and the worker thread copies it
+        // into mWriting (under the lock) before writing it out (without the lock).
+        // mWriting stays valid, and is what Load() returns, until the write is done.
+        Request mPending, mWriting;
+        bool mHasPending;
+        bool mHasWriting;
+        bool mFlushRequested;
+        unsigned mSequence;
+
+        static void* ThreadProc(void *arg);
+        void ThreadLoop();
+        bool WriteRecord(const Request& req, unsigned sequence);
+        static bool SyncParentDir(const char *fileName);
+};
+
+#endif
@@ -184,6 +184,12 @@ void Shader::Render(IndexBuf *ibuf, glm::mat4* mvpMat) {
     }
 }
 
+void Shader::RenderArrays(glm::mat4* mvpMat, int firstVertex, int vertexCount) {
+    MY_ASSERT(mPreparedVertexBuf != NULL);
+    PushMVPMatrix(mvpMat);
+    glDrawArrays(mPreparedVertexBuf->GetPrimitive(), firstVertex, vertexCount);
+}
+
 void Shader::EndRender() {
     if (mPreparedVertexBuf) {
         mPreparedVertexBuf->UnbindBuffer();
@@ -62,6 +62,10 @@ class Shader {
         // the given model-view-projection matrix.
         virtual void Render(IndexBuf *ibuf, glm::mat4* mvpMat);
 
+        // Renders a range of vertices of the prepared geometry (without an index buffer),
+        // using the given model-view-projection matrix.
+        void RenderArrays(glm::mat4* mvpMat, int firstVertex, int vertexCount);
+
         // Finishes rendering (call this after you're done making calls to Render())
         virtual void EndRender();
 
@@ -32,6 +32,7 @@ ShapeRenderer::ShapeRenderer(TrivialShader *ts) {
     mTrivialShader = ts;
     mColor[0] = mColor[1] = mColor[2] = 1.0f;
     mGeom = NULL;
+    mSpriteBatch = NULL;
 
     // create geometry
     VertexBuf *vbuf = new VertexBuf(RECT_VERTICES, sizeof(RECT_VERTICES), 7 * sizeof(GLfloat));
@@ -46,6 +47,11 @@ ShapeRenderer::~ShapeRenderer() {
 }
 
 void ShapeRenderer::RenderRect(float centerX, float centerY, float width, float height) {
+    if (mSpriteBatch && mSpriteBatch->IsActive()) {
+        mSpriteBatch->AddQuad(centerX, centerY, width, height, mColor);
+        return;
+    }
+
     float aspect = SceneManager::GetInstance()->GetScreenAspect();
     glm::mat4 orthoMat = glm::ortho(0.0f, aspect, 0.0f, 1.0f);
     glm::mat4 modelMat, mat;
@@ -17,6 +17,7 @@
 #define endlesstunnel_shape_renderer_hpp
 
 #include "engine.hpp"
+#include "sprite_batch.hpp"
 
 /* Convenience class that renders shapes (currently, only rects). The
  * coordinate system is the "normalized 2D coordinate system" -- see
@@ -26,11 +27,18 @@ class ShapeRenderer {
         TrivialShader *mTrivialShader;
         float mColor[3];
         SimpleGeom* mGeom;
+        SpriteBatch* mSpriteBatch;
 
     public:
         ShapeRenderer(TrivialShader *trivialShader);
         ~ShapeRenderer();
 
+        // If set, shapes rendered while the batch is active are added to it instead of
+        // being drawn right away. The batch is not owned by the shape renderer.
+        void SetSpriteBatch(SpriteBatch *batch) {
+            mSpriteBatch = batch;
+        }
+
         void SetColor(float r, float g, float b) {
             mColor[0] = r, mColor[1] = g, mColor[2] = b;
         }
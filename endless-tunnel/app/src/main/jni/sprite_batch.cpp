@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sprite_batch.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+static bool _overlaps(const float *a, const float *b) {
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+static void _grow_bounds(float *bounds, const float *other) {
+    bounds[0] = bounds[0] < other[0] ? bounds[0] : other[0];
+    bounds[1] = bounds[1] < other[1] ? bounds[1] : other[1];
+    bounds[2] = bounds[2] > other[2] ? bounds[2] : other[2];
+    bounds[3] = bounds[3] > other[3] ? bounds[3] : other[3];
+}
+
+SpriteBatch::SpriteBatch(SpriteTarget *target) {
+    mTarget = target;
+    mRunCount = 0;
+    mActive = false;
+    mDrawCalls = 0;
+}
+
+SpriteBatch::~SpriteBatch() {
+    delete mTarget;
+}
+
+void SpriteBatch::Begin() {
+    if (mActive) {
+        End();
+    }
+    mActive = true;
+    mDrawCalls = 0;
+    mRunCount = 0;
+    mTarget->BeginFrame();
+}
+
+void SpriteBatch::End() {
+    Flush();
+    mActive = false;
+}
+
+SpriteBatch::Run *SpriteBatch::OpenRun(GLenum primitive, float lineWidth, int vertices,
+        const float *bounds) {
+    for (int i = 0; i < mRunCount; i++) {
+        Run *run = &mRuns[i];
+        if (run->primitive != primitive ||
+                (primitive == GL_LINES && run->lineWidth != lineWidth)) {
+            continue;
+        }
+        if (run->vertexCount + vertices > MAX_VERTICES) {
+            break;
+        }
+        // joining the first run moves the shape in front of the second run in drawing
+        // order, which only makes a difference where they overlap
+        if (i == 0 && mRunCount == 2 && _overlaps(bounds, mRuns[1].bounds)) {
+            break;
+        }
+        _grow_bounds(run->bounds, bounds);
+        return run;
+    }
+
+    // no run can take this shape: start a new one, flushing first if both are taken
+    // or if this shape would have to go in front of pending geometry
+    bool canAppend = mRunCount == 0;
+    if (mRunCount == 1) {
+        Run *only = &mRuns[0];
+        bool sameState = only->primitive == primitive &&
+                (primitive != GL_LINES || only->lineWidth == lineWidth);
+        canAppend = !sameState;
+    }
+    if (!canAppend) {
+        Flush();
+    }
+    Run *run = &mRuns[mRunCount++];
+    run->primitive = primitive;
+    run->lineWidth = lineWidth;
+    run->vertexCount = 0;
+    for (int i = 0; i < 4; i++) {
+        run->bounds[i] = bounds[i];
+    }
+    return run;
+}
+
+void SpriteBatch::AddQuad(float centerX, float centerY, float width, float height,
+        const float *color) {
+    float x0 = centerX - 0.5f * width, x1 = centerX + 0.5f * width;
+    float y0 = centerY - 0.5f * height, y1 = centerY + 0.5f * height;
+    float bounds[4] = { x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1,
+            x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0 };
+
+    Run *run = OpenRun(GL_TRIANGLES, 1.0f, 6, bounds);
+    PushVertex(run, x0, y0, color);
+    PushVertex(run, x1, y0, color);
+    PushVertex(run, x1, y1, color);
+    PushVertex(run, x0, y0, color);
+    PushVertex(run, x1, y1, color);
+    PushVertex(run, x0, y1, color);
+}
+
+void SpriteBatch::AddLines(const GLfloat *xy, int vertexCount, const glm::mat4& modelMat,
+        const float *color, float lineWidth) {
+    // we only deal with 2D affine transforms here, so there's no need to do the
+    // full 4x4 multiplication
+    const float *m = glm::value_ptr(modelMat);
+
+    // add the segments in chunks that fit in a run (whole segments only)
+    const int chunkVertices = MAX_VERTICES & ~1;
+    for (int first = 0; first < vertexCount; first += chunkVertices) {
+        int count = vertexCount - first < chunkVertices ? vertexCount - first : chunkVertices;
+        const GLfloat *chunk = xy + first * 2;
+        GLfloat transformed[chunkVertices * 2];
+
+        // wide lines reach past their endpoints by up to half their width (plus a
+        // pixel of rasterization slack)
+        float pad = (0.5f * lineWidth + 1.0f) * mTarget->GetPixelSize();
+        float bounds[4];
+        for (int i = 0; i < count; i++) {
+            float x = chunk[i * 2], y = chunk[i * 2 + 1];
+            float tx = m[0] * x + m[4] * y + m[12], ty = m[1] * x + m[5] * y + m[13];
+            transformed[i * 2] = tx;
+            transformed[i * 2 + 1] = ty;
+            if (i == 0) {
+                bounds[0] = bounds[2] = tx;
+                bounds[1] = bounds[3] = ty;
+            } else {
+                float point[4] = { tx, ty, tx, ty };
+                _grow_bounds(bounds, point);
+            }
+        }
+        bounds[0] -= pad;
+        bounds[1] -= pad;
+        bounds[2] += pad;
+        bounds[3] += pad;
+
+        Run *run = OpenRun(GL_LINES, lineWidth, count, bounds);
+        for (int i = 0; i < count; i++) {
+            PushVertex(run, transformed[i * 2], transformed[i * 2 + 1], color);
+        }
+    }
+}
+
+void SpriteBatch::Flush() {
+    for (int i = 0; i < mRunCount; i++) {
+        Run *run = &mRuns[i];
+        if (run->vertexCount > 0) {
+            mTarget->Draw(run->vertices, run->vertexCount, run->primitive, run->lineWidth);
+            ++mDrawCalls;
+        }
+    }
+    mRunCount = 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_sprite_batch_hpp
+#define endlesstunnel_sprite_batch_hpp
+
+// Only GL types and glm are needed here, so the batching logic also builds on a host
+// (see tools/spriteBatchTest).
+#include <GLES2/gl2.h>
+#include "glm/glm.hpp"
+
+/* Receives the geometry flushed by a SpriteBatch. The game draws it with GL (see
+ * GlSpriteTarget); a test can record it instead. Vertices are (x, y, z, r, g, b) in
+ * the "normalized 2D coordinate system". */
+class SpriteTarget {
+    public:
+        virtual ~SpriteTarget() {}
+
+        // Called when a batch begins (normally, once per frame).
+        virtual void BeginFrame() = 0;
+
+        // Returns the size of a pixel in the normalized 2D coordinate system.
+        virtual float GetPixelSize() = 0;
+
+        // Draws vertexCount vertices as the given primitive (GL_TRIANGLES or GL_LINES).
+        virtual void Draw(const GLfloat *vertices, int vertexCount, GLenum primitive,
+                float lineWidth) = 0;
+};
+
+/* Accumulates 2D geometry (colored quads and lines) given in the "normalized 2D
+ * coordinate system" and draws it in as few draw calls as possible.
+ *
+ * Usage: call Begin(), then add as many quads and lines as you want, then call End().
+ * The result looks exactly as if every shape had been drawn in the order it was added
+ * (painter's order). To get there in few draw calls, the batch keeps up to two runs
+ * of pending geometry, one per primitive type or line width, that are drawn one after
+ * the other. A shape may join the first run only if it does not overlap anything
+ * already in the second run, since it will be drawn before it; otherwise, or when a
+ * third state shows up or a run fills up, everything pending is flushed. So a menu
+ * whose labels sit on their own buttons takes two draw calls, however many widgets
+ * it has. */
+class SpriteBatch {
+    public:
+        // vertex format: x, y, z, r, g, b
+        static const int FLOATS_PER_VERTEX = 6;
+
+        // how many vertices a run accumulates on the CPU side before flushing
+        static const int MAX_VERTICES = 2048;
+
+    private:
+        struct Run {
+            GLenum primitive;
+            float lineWidth;
+            GLfloat vertices[MAX_VERTICES * FLOATS_PER_VERTEX];
+            int vertexCount;
+            // bounding box of the geometry in the run (minX, minY, maxX, maxY)
+            float bounds[4];
+        };
+
+        SpriteTarget *mTarget;
+
+        // pending runs, in drawing order
+        Run mRuns[2];
+        int mRunCount;
+
+        bool mActive;
+        int mDrawCalls;
+
+        Run *OpenRun(GLenum primitive, float lineWidth, int vertices, const float *bounds);
+        void PushVertex(Run *run, float x, float y, const float *color) {
+            GLfloat *v = run->vertices + run->vertexCount * FLOATS_PER_VERTEX;
+            v[0] = x;
+            v[1] = y;
+            v[2] = 0.0f;
+            v[3] = color[0];
+            v[4] = color[1];
+            v[5] = color[2];
+            ++run->vertexCount;
+        }
+
+    public:
+        // The batch takes ownership of the target.
+        SpriteBatch(SpriteTarget *target);
+        ~SpriteBatch();
+
+        // Starts a new batch (normally, once per frame).
+        void Begin();
+
+        // Flushes all pending geometry and ends the batch.
+        void End();
+
+        // Returns whether we are between Begin() and End().
+        bool IsActive() { return mActive; }
+
+        // Adds a solid rectangle.
+        void AddQuad(float centerX, float centerY, float width, float height,
+                const float *color);
+
+        // Adds line segments. xy contains vertexCount (x, y) pairs, two per segment, which
+        // are transformed by modelMat before being added.
+        void AddLines(const GLfloat *xy, int vertexCount, const glm::mat4& modelMat,
+                const float *color, float lineWidth);
+
+        // Draws all pending geometry now.
+        void Flush();
+
+        // Returns how many draw calls were issued since Begin().
+        int GetDrawCallCount() { return mDrawCalls; }
+};
+
+#endif
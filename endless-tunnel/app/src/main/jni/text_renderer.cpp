@@ -29,6 +29,9 @@
 TextRenderer::TextRenderer(TrivialShader *t) {
     mTrivialShader = t;
     memset(mCharGeom, 0, sizeof(mCharGeom));
+    memset(mCharLines, 0, sizeof(mCharLines));
+    memset(mCharLineVertices, 0, sizeof(mCharLineVertices));
+    mSpriteBatch = NULL;
     mFontScale = 1.0f;
     mMatrix = glm::mat4(1.0f);
     mColor[0] = mColor[1] = mColor[2] = 1.0f;
@@ -39,6 +42,8 @@ TextRenderer::TextRenderer(TrivialShader *t) {
         if (ALPHABET_ART[i]) {
             LOGD("Creating glyph for chr %d.", i);
             mCharGeom[i] = AsciiArtToGeom(ALPHABET_ART[i], ALPHABET_SCALE);
+            mCharLines[i] = AsciiArtToLines(ALPHABET_ART[i], ALPHABET_SCALE,
+                    &mCharLineVertices[i]);
         }
     }
 }
@@ -47,6 +52,8 @@ TextRenderer::~TextRenderer() {
     int i;
     for (i = 0; i < CHAR_CODES; i++) {
         CleanUp(&mCharGeom[i]);
+        delete [] mCharLines[i];
+        mCharLines[i] = NULL;
     }
 }
 
@@ -95,16 +102,19 @@ TextRenderer* TextRenderer::RenderText(const char *str, float centerX, float cen
     glm::mat4 orthoMat = glm::ortho(0.0f, aspect, 0.0f, 1.0f);
     glm::mat4 modelMat, mat, scaleMat;
     int cols, rows;
-    bool hadDepthTest;
+    bool hadDepthTest = false;
+    bool batched = mSpriteBatch && mSpriteBatch->IsActive();
 
     centerY += CORRECTION_Y * mFontScale;
 
-    glLineWidth(TEXT_LINE_WIDTH);
+    if (!batched) {
+        glLineWidth(TEXT_LINE_WIDTH);
 
-    hadDepthTest = glIsEnabled(GL_DEPTH_TEST);
-    glDisable(GL_DEPTH_TEST);
+        hadDepthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
 
-    mTrivialShader->SetTintColor(mColor[0], mColor[1], mColor[2]);
+        mTrivialShader->SetTintColor(mColor[0], mColor[1], mColor[2]);
+    }
 
     _count_rows_cols(str, &cols, &rows);
     scaleMat = glm::scale(glm::mat4(1.0f), glm::vec3(mFontScale, mFontScale, 1.0f));
@@ -126,16 +136,25 @@ TextRenderer* TextRenderer::RenderText(const char *str, float centerX, float cen
         } else {
             int code = (int) *str;
             if (code >= 0 && code < CHAR_CODES && mCharGeom[code]) {
-                mat = orthoMat * modelMat * scaleMat * mMatrix;
-                mTrivialShader->RenderSimpleGeom(&mat, mCharGeom[code]);
+                if (batched) {
+                    // the batch applies the projection itself
+                    mat = modelMat * scaleMat * mMatrix;
+                    mSpriteBatch->AddLines(mCharLines[code], mCharLineVertices[code], mat,
+                            mColor, TEXT_LINE_WIDTH);
+                } else {
+                    mat = orthoMat * modelMat * scaleMat * mMatrix;
+                    mTrivialShader->RenderSimpleGeom(&mat, mCharGeom[code]);
+                }
             }
             modelMat = glm::translate(modelMat, glm::vec3(charWidth + charSpacing, 0.0f, 0.0f));
         }
     }
 
-    glLineWidth(1);
-    if (hadDepthTest) {
-        glEnable(GL_DEPTH_TEST);
+    if (!batched) {
+        glLineWidth(1);
+        if (hadDepthTest) {
+            glEnable(GL_DEPTH_TEST);
+        }
     }
     return this;
 }
@@ -17,6 +17,7 @@
 #define endlesstunnel_text_renderer_hpp
 
 #include "engine.hpp"
+#include "sprite_batch.hpp"
 
 /* Renders text to the screen. Uses the "normalized 2D coordinate system" as
  * described in the README. */
@@ -26,6 +27,11 @@ class TextRenderer {
         SimpleGeom* mCharGeom[CHAR_CODES];
         TrivialShader *mTrivialShader;
 
+        // CPU-side copy of each glyph's lines, used when rendering through a sprite batch
+        GLfloat* mCharLines[CHAR_CODES];
+        int mCharLineVertices[CHAR_CODES];
+        SpriteBatch *mSpriteBatch;
+
         float mFontScale;
         float mColor[3];
         glm::mat4 mMatrix;
@@ -34,6 +40,12 @@ class TextRenderer {
         TextRenderer(TrivialShader *t);
         ~TextRenderer();
 
+        // If set, text rendered while the batch is active is added to it instead of
+        // being drawn right away. The batch is not owned by the text renderer.
+        void SetSpriteBatch(SpriteBatch *batch) {
+            mSpriteBatch = batch;
+        }
+
         TextRenderer* SetMatrix(glm::mat4 mat);
         TextRenderer* SetFontScale(float size);
         TextRenderer* RenderText(const char *str, float centerX, float centerY);
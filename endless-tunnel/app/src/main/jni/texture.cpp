@@ -15,20 +15,53 @@
  */
 #include "common.hpp"
 #include "texture.hpp"
+#include "util.hpp"
 
-void Texture::InitFromRawRGB(int width, int height, bool hasAlpha, const unsigned char *data) {
-    GLenum format = hasAlpha ? GL_RGBA : GL_RGB;
-
-    glGenTextures(1, &mTextureH);
-    glBindTexture(GL_TEXTURE_2D, mTextureH);
+static bool _is_power_of_two(int n) {
+    return n > 0 && 0 == (n & (n - 1));
+}
 
+static void _set_tex_params(bool mipmapped, bool trilinear) {
+    GLint minFilter = !mipmapped ? GL_LINEAR :
+            trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+void Texture::InitFromRawRGB(int width, int height, bool hasAlpha, const unsigned char *data,
+        bool trilinear) {
+    GLenum format = hasAlpha ? GL_RGBA : GL_RGB;
+
+    // ES 2.0 only supports mipmaps (and GL_REPEAT) on power-of-two textures
+    bool mipmapped = _is_power_of_two(width) && _is_power_of_two(height);
+
+    glGenTextures(1, &mTextureH);
+    glBindTexture(GL_TEXTURE_2D, mTextureH);
+    _set_tex_params(mipmapped, trilinear);
 
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    if (mipmapped) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::InitFromMipChain(int width, int height, int levels, const unsigned char *data,
+        bool trilinear) {
+    glGenTextures(1, &mTextureH);
+    glBindTexture(GL_TEXTURE_2D, mTextureH);
+    _set_tex_params(levels > 1, trilinear);
+
+    for (int level = 0; level < levels; level++) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                data);
+        data += width * height * 3;
+        width = Max(width / 2, 1);
+        height = Max(height / 2, 1);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -29,8 +29,16 @@ class Texture {
         }
 
         // Initialize from raw RGB data. If hasAlpha is true, then it's 4 bytes per pixel
-        // (RGBA), otherwise it's interpreted as 3 bytes per pixel (RGB).
-        void InitFromRawRGB(int width, int height, bool hasAlpha, const unsigned char *data);
+        // (RGBA), otherwise it's interpreted as 3 bytes per pixel (RGB). If the dimensions
+        // are powers of two, mipmaps are generated and used for minification, blending
+        // between levels if trilinear is true.
+        void InitFromRawRGB(int width, int height, bool hasAlpha, const unsigned char *data,
+                bool trilinear = false);
+
+        // Initialize from a precomputed RGB mip chain: levels images, each half the
+        // size of the previous one, stored back to back starting at the base level.
+        void InitFromMipChain(int width, int height, int levels, const unsigned char *data,
+                bool trilinear);
         void Bind(int unit);
         void Unbind();
 };
@@ -41,10 +41,11 @@ UiScene::UiScene() {
     mTrivialShader = NULL;
     mTextRenderer = NULL;
     mShapeRenderer = NULL;
+    mSpriteBatch = NULL;
     mDefaultButton = -1;
     mPointerDown = false;
     mWaitScreen = false;
-    mTransitionStart = 0.0f;
+    mTransitionStart = 0;
 }
 
 UiScene::~UiScene() {
@@ -69,11 +70,14 @@ void UiScene::OnStartGraphics() {
     mTrivialShader->Compile();
     mTextRenderer = new TextRenderer(mTrivialShader);
     mShapeRenderer = new ShapeRenderer(mTrivialShader);
+    mSpriteBatch = new SpriteBatch(new GlSpriteTarget(mTrivialShader));
+    mTextRenderer->SetSpriteBatch(mSpriteBatch);
+    mShapeRenderer->SetSpriteBatch(mSpriteBatch);
 
     for (int i = 0; i < mWidgetCount; ++i) {
         mWidgets[i]->StartGraphics();
     }
-    mTransitionStart = Clock();
+    mTransitionStart = ClockNs();
 
     if (mWidgetCount <= 0) {
         // time to create our widgets
@@ -84,6 +88,7 @@ void UiScene::OnStartGraphics() {
 void UiScene::OnKillGraphics() {
     CleanUp(&mTextRenderer);
     CleanUp(&mShapeRenderer);
+    CleanUp(&mSpriteBatch);
     CleanUp(&mTrivialShader);
 
     for (int i = 0; i < mWidgetCount; ++i) {
@@ -116,6 +121,8 @@ void UiScene::DoFrame() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glDisable(GL_DEPTH_TEST);
 
+    mSpriteBatch->Begin();
+
     // render background
     RenderBackground();
 
@@ -124,6 +131,7 @@ void UiScene::DoFrame() {
         mTextRenderer->SetFontScale(WAIT_SIGN_SCALE);
         mTextRenderer->SetColor(1.0f, 1.0f, 1.0f);
         mTextRenderer->RenderText(S_PLEASE_WAIT, mgr->GetScreenAspect() * 0.5f, 0.5f);
+        mSpriteBatch->End();
         glEnable(GL_DEPTH_TEST);
         return;
     }
@@ -135,9 +143,10 @@ void UiScene::DoFrame() {
 
     // calculate transition factor, which is 0 when we're starting the transition
     // and 1 when we've finished the transition
-    float tf = Clamp((Clock() - mTransitionStart) / TRANSITION_DURATION, 0.0f, 1.0f);
+    float tf = Clamp(SecondsSince(mTransitionStart) / TRANSITION_DURATION, 0.0f, 1.0f);
 
-    // render ALL the widgets!
+    // render ALL the widgets! Each widget draws its shapes and then its text on top;
+    // the sprite batch keeps that order while merging the draw calls.
     int i;
     for (i = 0; i < mWidgetCount; ++i) {
         mWidgets[i]->Render(mTrivialShader, mTextRenderer, mShapeRenderer,
@@ -145,6 +154,7 @@ void UiScene::DoFrame() {
                 (mFocusWidget == i) ? UiWidget::FOCUS_YES : UiWidget::FOCUS_NO, tf);
     }
 
+    mSpriteBatch->End();
     glEnable(GL_DEPTH_TEST);
 }
 
@@ -301,26 +311,38 @@ static void _apply_transition(int trans, float f, float *x, float *y, float *w,
     }
 }
 
+void UiWidget::ComputeLayout(int focus, float transitionFactor, float *x, float *y,
+        float *w, float *h, float *fontScale, float *pulseFactor, const float **color) {
+    bool pulse = IsClickableButton() && (focus != FOCUS_NO);
+    *pulseFactor = pulse ? SineWave(1.0f - PULSE_AMOUNT, 1.0f + PULSE_AMOUNT,
+            PULSE_PERIOD, 0.0f) : 1.0f;
+    *color = (mIsButton && focus == FOCUS_YES) ? BUTTON_FOCUS_COLOR :
+            (mIsButton && !mEnabled) ? BUTTON_DISABLED_COLOR : mTextColor;
+    *x = mCenterX;
+    *y = mCenterY;
+    *w = mWidth;
+    *h = mHeight;
+    *fontScale = mFontScale;
+
+    _apply_transition(mTransition, transitionFactor, x, y, w, h, fontScale);
+}
+
 void UiWidget::Render(TrivialShader *trivialShader, TextRenderer *textRenderer,
         ShapeRenderer *shapeRenderer, int focus, float transitionFactor) {
+    RenderShapes(shapeRenderer, focus, transitionFactor);
+    RenderText(textRenderer, focus, transitionFactor);
+}
+
+void UiWidget::RenderShapes(ShapeRenderer *shapeRenderer, int focus, float transitionFactor) {
     if (!mVisible) {
         // that was easy.
         return;
     }
 
-    bool pulse = IsClickableButton() && (focus != FOCUS_NO);
-    float factor = pulse ? SineWave(1.0f - PULSE_AMOUNT, 1.0f + PULSE_AMOUNT,
-            PULSE_PERIOD, 0.0f) : 1.0f;
-    const float *color = (mIsButton && focus == FOCUS_YES) ? BUTTON_FOCUS_COLOR :
-            (mIsButton && !mEnabled) ? BUTTON_DISABLED_COLOR : mTextColor;
+    float x, y, w, h, fontScale, factor;
+    const float *color;
     float borderSize = 0.0f;
-    float x = mCenterX;
-    float y = mCenterY;
-    float w = mWidth;
-    float h = mHeight;
-    float fontScale = mFontScale;
-
-    _apply_transition(mTransition, transitionFactor, &x, &y, &w, &h, &fontScale);
+    ComputeLayout(focus, transitionFactor, &x, &y, &w, &h, &fontScale, &factor, &color);
 
     // Note: right now, we don't support buttons that have borders AND are transparent.
     // They will be rendered incorrectly (the background will be the border color).
@@ -338,13 +360,20 @@ void UiWidget::Render(TrivialShader *trivialShader, TextRenderer *textRenderer,
         shapeRenderer->RenderRect(x, y, w * factor * (1.0f - borderSize),
                 h * factor * (1.0f - borderSize));
     }
+}
 
-    // draw text
-    if (mText) {
-        textRenderer->SetColor(color);
-        textRenderer->SetFontScale(fontScale * factor);
-        textRenderer->RenderText(mText, x, y);
+void UiWidget::RenderText(TextRenderer *textRenderer, int focus, float transitionFactor) {
+    if (!mVisible || !mText) {
+        return;
     }
+
+    float x, y, w, h, fontScale, factor;
+    const float *color;
+    ComputeLayout(focus, transitionFactor, &x, &y, &w, &h, &fontScale, &factor, &color);
+
+    textRenderer->SetColor(color);
+    textRenderer->SetFontScale(fontScale * factor);
+    textRenderer->RenderText(mText, x, y);
 }
 
 void UiScene::OnCreateWidgets() {}
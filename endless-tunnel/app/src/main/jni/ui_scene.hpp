@@ -18,6 +18,7 @@
 
 #include "ascii_to_geom.hpp"
 #include "engine.hpp"
+#include "gl_sprite_target.hpp"
 #include "shape_renderer.hpp"
 #include "text_renderer.hpp"
 #include "util.hpp"
@@ -52,6 +53,10 @@ class UiScene : public Scene {
         TextRenderer *mTextRenderer;
         ShapeRenderer *mShapeRenderer;
 
+        // batch through which the text and shape renderers draw, so that a whole
+        // screen's worth of UI takes only a few draw calls
+        SpriteBatch *mSpriteBatch;
+
         // if true, shows a "please wait" screen instead of the interface
         bool mWaitScreen;
 
@@ -59,8 +64,8 @@ class UiScene : public Scene {
         virtual void OnButtonClicked(int buttonId);
         virtual void RenderBackground();
 
-        // transition start time
-        float mTransitionStart;
+        // transition start time (ClockNs)
+        int64_t mTransitionStart;
 
         // add a new widget
         UiWidget* NewWidget();
@@ -75,7 +80,7 @@ class UiScene : public Scene {
         void SetWaitScreen(bool b) {
             mWaitScreen = b;
             if (mWaitScreen) {
-                mTransitionStart = Clock();
+                mTransitionStart = ClockNs();
             }
         }
 
@@ -283,6 +288,19 @@ class UiWidget {
         static const int FOCUS_NO = 2;
         void Render(TrivialShader *trivialShader, TextRenderer *textRenderer,
                 ShapeRenderer *shapeRenderer, int focus, float transitionFactor);
+
+        // Render() in two parts: the border/background shapes and the text. Rendering
+        // the shapes of all widgets before the text of all widgets lets a sprite batch
+        // draw each part in a single call.
+        void RenderShapes(ShapeRenderer *shapeRenderer, int focus, float transitionFactor);
+        void RenderText(TextRenderer *textRenderer, int focus, float transitionFactor);
+
+    private:
+        // computes where and how the widget should be drawn, considering the transition
+        // and the pulse animation.
+        void ComputeLayout(int focus, float transitionFactor, float *x, float *y,
+                float *w, float *h, float *fontScale, float *pulseFactor,
+                const float **color);
 };
 
 #endif
@@ -15,6 +15,7 @@
  */
 #include <cstdlib>
 #include <ctime>
+#include <pthread.h>
 
 #include "util.hpp"
 
@@ -29,29 +30,103 @@ int Random(int lbound, int uboundExclusive) {
     return lbound + r;
 }
 
-float Clock() {
-    static struct timespec _base;
-    static bool firstCall = true;
+static int64_t _raw_clock_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000LL + (int64_t)t.tv_nsec;
+}
+
+// The clock state is shared with worker threads (e.g. the wall texture generator),
+// so every access goes through this lock.
+static pthread_mutex_t _clock_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t _clock_base = -1;
+static int64_t _clock_paused_at = -1;
 
-    if (firstCall) {
-        clock_gettime(CLOCK_MONOTONIC, &_base);
-        firstCall = false;
+// Must be called with _clock_lock held.
+static int64_t _clock_ns_locked() {
+    if (_clock_base < 0) {
+        _clock_base = _raw_clock_ns();
     }
+    int64_t now = _clock_paused_at >= 0 ? _clock_paused_at : _raw_clock_ns();
+    return now - _clock_base;
+}
 
-    struct timespec t;
-    clock_gettime(CLOCK_MONOTONIC, &t);
-    float secDiff = (float)(t.tv_sec - _base.tv_sec);
-    float msecDiff = (float)((t.tv_nsec - _base.tv_nsec) / 1000000);
-    return secDiff + 0.001f * msecDiff;
+int64_t ClockNs() {
+    pthread_mutex_lock(&_clock_lock);
+    int64_t ns = _clock_ns_locked();
+    pthread_mutex_unlock(&_clock_lock);
+    return ns;
 }
 
+void PauseClock() {
+    pthread_mutex_lock(&_clock_lock);
+    if (_clock_paused_at < 0) {
+        _clock_ns_locked(); // make sure the base is initialized
+        _clock_paused_at = _raw_clock_ns();
+    }
+    pthread_mutex_unlock(&_clock_lock);
+}
+
+void ResumeClock() {
+    pthread_mutex_lock(&_clock_lock);
+    if (_clock_paused_at >= 0) {
+        // shift the base forward by the time we spent paused
+        _clock_base += _raw_clock_ns() - _clock_paused_at;
+        _clock_paused_at = -1;
+    }
+    pthread_mutex_unlock(&_clock_lock);
+}
+
+float SecondsSince(int64_t startNs) {
+    return (float)((ClockNs() - startNs) * 1e-9);
+}
+
+float ClockPeriodic(float period) {
+    int64_t periodNs = (int64_t)(period * 1e9);
+    if (periodNs <= 0) {
+        return 0.0f;
+    }
+    return (float)((ClockNs() % periodNs) * 1e-9);
+}
 
 float SineWave(float min, float max, float period, float phase) {
     float ampl = max - min;
-    return min + ampl * sin(((Clock() / period) + phase) * 2 * M_PI);
+    return min + ampl * sin(((ClockPeriodic(period) / period) + phase) * 2 * M_PI);
 }
 
 bool BlinkFunc(float period) {
-    return (int)(Clock() / period) & 1;
+    return ClockPeriodic(2.0f * period) >= period;
+}
+
+int64_t DeltaClock::MedianSample() {
+    int64_t sorted[SMOOTH_SAMPLES];
+    int i, j;
+    for (i = 0; i < mSampleCount; i++) {
+        // insertion sort (there are only a handful of samples)
+        int64_t v = mSamples[i];
+        for (j = i; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[mSampleCount / 2];
 }
 
+float DeltaClock::ReadDelta() {
+    int64_t now = ClockNs();
+    int64_t delta = now - mLastTick;
+    mLastTick = now;
+    if (delta < 0) {
+        delta = 0;
+    }
+
+    if (mSmooth) {
+        mSamples[mNextSample] = delta;
+        mNextSample = (mNextSample + 1) % SMOOTH_SAMPLES;
+        mSampleCount = Min(mSampleCount + 1, SMOOTH_SAMPLES);
+        delta = MedianSample();
+    }
+
+    float d = (float)(delta * 1e-9);
+    return mHasMax ? Min(d, mMaxDelta) : d;
+}
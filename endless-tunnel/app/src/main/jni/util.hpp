@@ -18,6 +18,7 @@
 
 #include <ctime>
 #include <cmath>
+#include <stdint.h>
 
 // Clean up a resource (delete and set to null).
 template<typename T> void CleanUp(T** pptr) {
@@ -67,37 +68,72 @@ template<typename T> T Abs(T f) {
     return f > static_cast<T>(0) ? f : -f;
 }
 
-// Returns current wall clock time (seconds elapsed since an arbitrary fixed point in the past).
-float Clock();
+// Returns the current game time in nanoseconds (elapsed on the monotonic clock since an
+// arbitrary fixed point in the past, not counting the time during which the clock was
+// paused). Game timers should be kept in these units: a float count of seconds loses
+// precision as the session grows. Safe to call from any thread.
+int64_t ClockNs();
+
+// Pauses/resumes the game clock. While paused, ClockNs() doesn't advance, so timers and
+// animations pick up where they left off. Calling these repeatedly is harmless.
+void PauseClock();
+void ResumeClock();
+
+// Converts a duration in seconds to nanoseconds, for deadlines such as
+// ClockNs() + SecondsToNs(GAME_OVER_EXPIRE).
+inline int64_t SecondsToNs(float seconds) {
+    return (int64_t)(seconds * 1e9);
+}
+
+// Returns the game time elapsed since the given ClockNs() reading, in seconds. The
+// subtraction is done on the integer clock, so the result is precise at any uptime.
+float SecondsSince(int64_t startNs);
+
+// Returns the current game time modulo the given period, in seconds. This is computed
+// from the integer clock so periodic animations stay smooth however long the game runs.
+float ClockPeriodic(float period);
+
 float SineWave(float min, float max, float period, float phase);
 bool BlinkFunc(float period);
 
-/* A simple chronometer that computes elapsed time. */
+/* A simple chronometer that computes elapsed time. Optionally, it can smooth the deltas
+ * by returning the median of the last few frame intervals, which hides one-off spikes
+ * (a late vsync, a GC pause in another process) from the animation. */
 class DeltaClock {
     private:
-        float mLastTick;
+        static const int SMOOTH_SAMPLES = 5;
+        int64_t mLastTick;
         float mMaxDelta;
         bool mHasMax;
+        bool mSmooth;
+        int64_t mSamples[SMOOTH_SAMPLES];
+        int mSampleCount, mNextSample;
+
+        int64_t MedianSample();
     public:
         DeltaClock() {
-            mLastTick = Clock();
+            mMaxDelta = 0.0f;
             mHasMax = false;
+            mSmooth = false;
+            Reset();
         }
         DeltaClock(float maxDelta) {
-            mLastTick = Clock();
             mMaxDelta = maxDelta;
             mHasMax = true;
+            mSmooth = false;
+            Reset();
         }
-        float ReadDelta() {
-            float d = Clamp(Clock() - mLastTick, 0.0f, mMaxDelta);
-            mLastTick = Clock();
-            return d;
-        }
+        float ReadDelta();
         void SetMaxDelta(float m) {
             mMaxDelta = m;
+            mHasMax = true;
+        }
+        void SetSmoothing(bool smooth) {
+            mSmooth = smooth;
         }
         void Reset() {
-            mLastTick = Clock();
+            mLastTick = ClockNs();
+            mSampleCount = mNextSample = 0;
         }
 };
 
@@ -23,6 +23,7 @@ VertexBuf::VertexBuf(GLfloat *geomData, int dataSize, int stride) {
     mStride = stride;
     mColorsOffset = mTexCoordsOffset = 0;
     mCount = dataSize / stride;
+    mCapacity = dataSize;
 
     // build VBO
     glGenBuffers(1, &mVbo);
@@ -31,6 +32,31 @@ VertexBuf::VertexBuf(GLfloat *geomData, int dataSize, int stride) {
     UnbindBuffer();
 }
 
+VertexBuf::VertexBuf(int capacity, int stride) {
+    MY_ASSERT(capacity % stride == 0);
+
+    mPrimitive = GL_TRIANGLES;
+    mVbo = 0;
+    mStride = stride;
+    mColorsOffset = mTexCoordsOffset = 0;
+    mCount = 0;
+    mCapacity = capacity;
+
+    glGenBuffers(1, &mVbo);
+    BindBuffer();
+    Orphan();
+    UnbindBuffer();
+}
+
+void VertexBuf::Orphan() {
+    glBufferData(GL_ARRAY_BUFFER, mCapacity, NULL, GL_STREAM_DRAW);
+}
+
+void VertexBuf::Upload(int offset, const GLfloat *data, int dataSize) {
+    MY_ASSERT(offset >= 0 && offset + dataSize <= mCapacity);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, dataSize, data);
+}
+
 void VertexBuf::BindBuffer() {
     glBindBuffer(GL_ARRAY_BUFFER, mVbo);
 }
@@ -27,14 +27,30 @@ class VertexBuf {
         int mColorsOffset;
         int mTexCoordsOffset;
         int mCount;
+        int mCapacity;
 
     public:
         VertexBuf(GLfloat *geomData, int dataSize, int stride);
+
+        // Creates an empty streaming buffer that can hold capacity bytes. Its contents
+        // are meant to be respecified every frame with Orphan() and Upload().
+        VertexBuf(int capacity, int stride);
         ~VertexBuf();
 
         void BindBuffer();
         void UnbindBuffer();
 
+        // Discards the buffer's storage, so that we can write to it again without
+        // waiting for the GPU to finish drawing from the previous contents.
+        // The buffer must be bound.
+        void Orphan();
+
+        // Copies the given data into the buffer at the given byte offset. The buffer
+        // must be bound.
+        void Upload(int offset, const GLfloat *data, int dataSize);
+
+        int GetCapacity() { return mCapacity; }
+
         int GetStride() { return mStride; }
         int GetCount() { return mCount; }
         int GetPositionsOffset() { return 0; }
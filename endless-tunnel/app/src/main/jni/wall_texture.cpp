@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdio>
+#include <cstring>
+#include "texture.hpp"
+#include "util.hpp"
+#include "wall_texture.hpp"
+
+WallTextureGen::WallTextureGen(const Params& params) : mReady(false) {
+    mParams = params;
+    mPixelsSize = GetMipChainSize(mParams, &mLevels);
+    mPixels = new unsigned char[mPixelsSize];
+    mCacheFileName = NULL;
+    mThreadStarted = false;
+}
+
+WallTextureGen::~WallTextureGen() {
+    if (mThreadStarted) {
+        pthread_join(mThread, NULL);
+    }
+    delete [] mPixels;
+    delete [] mCacheFileName;
+}
+
+void WallTextureGen::Start(const char *cacheDir) {
+    MY_ASSERT(!mThreadStarted);
+
+    if (cacheDir) {
+        int len = strlen(cacheDir) + 32;
+        mCacheFileName = new char[len];
+        snprintf(mCacheFileName, len, "%s/wall_%08x.tex", cacheDir, HashParams(mParams));
+    }
+
+    if (0 == pthread_create(&mThread, NULL, ThreadProc, this)) {
+        mThreadStarted = true;
+    } else {
+        LOGW("WallTextureGen: failed to start worker thread. Generating synchronously.");
+        Produce();
+    }
+}
+
+void* WallTextureGen::ThreadProc(void *arg) {
+    static_cast<WallTextureGen*>(arg)->Produce();
+    return NULL;
+}
+
+void WallTextureGen::Produce() {
+    if (!LoadFromCache()) {
+        int64_t start = ClockNs();
+        Generate(mParams, mPixels);
+        LOGD("WallTextureGen: generated %d levels in %.1f ms.", mLevels,
+                SecondsSince(start) * 1000.0f);
+        SaveToCache();
+    }
+    mReady.store(true, std::memory_order_release);
+}
+
+bool WallTextureGen::LoadFromCache() {
+    if (!mCacheFileName) {
+        return false;
+    }
+
+    int result = ReadCacheFile(mCacheFileName, mParams, mPixels);
+    if (result == CACHE_MISSING) {
+        LOGD("WallTextureGen: no cache file %s", mCacheFileName);
+        return false;
+    } else if (result == CACHE_INVALID) {
+        LOGW("WallTextureGen: ignoring stale or corrupt cache file %s", mCacheFileName);
+        remove(mCacheFileName);
+        return false;
+    }
+    LOGD("WallTextureGen: loaded from cache file %s", mCacheFileName);
+    return true;
+}
+
+void WallTextureGen::SaveToCache() {
+    if (!mCacheFileName) {
+        return;
+    }
+
+    if (WriteCacheFile(mCacheFileName, mParams, mPixels)) {
+        LOGD("WallTextureGen: saved cache file %s", mCacheFileName);
+    } else {
+        LOGW("WallTextureGen: failed to write cache file %s", mCacheFileName);
+    }
+}
+
+Texture* WallTextureGen::CreateTexture(bool trilinear) {
+    MY_ASSERT(IsReady());
+    Texture *t = new Texture();
+    t->InitFromMipChain(mParams.size, mParams.size, mLevels, mPixels, trilinear);
+    return t;
+}
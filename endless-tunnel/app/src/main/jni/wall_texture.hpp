@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef endlesstunnel_wall_texture_hpp
+#define endlesstunnel_wall_texture_hpp
+
+#include <atomic>
+#include <pthread.h>
+
+class Texture;
+
+/* Procedurally generates the tunnel's wall texture, including its full mip chain.
+ * Generation happens on a worker thread, so it doesn't delay the first frame. The result
+ * is saved to the cache directory, keyed by a hash of the generator parameters, so that
+ * subsequent launches only have to read it back (and changing the parameters or the
+ * generator automatically invalidates old cache files). Cache files also carry a
+ * checksum of the pixels, so a torn or corrupted file is regenerated rather than
+ * uploaded.
+ *
+ * The generated pixels stay in memory, so the texture can be re-uploaded cheaply when
+ * the GL context is recreated. */
+class WallTextureGen {
+    public:
+        struct Params {
+            int size;          // width and height of the base level (must be a power of 2)
+            int border;        // how many pixels of the top/left edges are left plain
+            int base;          // base gray level
+            int noise;         // amplitude of the random noise added to the base level
+            unsigned seed;     // seed for the noise
+        };
+
+        WallTextureGen(const Params& params);
+        ~WallTextureGen();
+
+        // Starts producing the pixels in the background. cacheDir may be NULL, in
+        // which case the cache is not used.
+        void Start(const char *cacheDir);
+
+        // Returns whether the pixels are ready to be uploaded.
+        bool IsReady() {
+            return mReady.load(std::memory_order_acquire);
+        }
+
+        // Creates a texture from the generated pixels. Must only be called once
+        // IsReady() returns true, on the GL thread.
+        Texture* CreateTexture(bool trilinear);
+
+        // Returns the hash that identifies the given parameters (and generator version).
+        static unsigned HashParams(const Params& params);
+
+        // Returns how many bytes the given parameters' full mip chain takes (RGB).
+        static int GetMipChainSize(const Params& params, int *outLevels);
+
+        // Generates the full mip chain for the given parameters into out (which must
+        // be GetMipChainSize() bytes long).
+        static void Generate(const Params& params, unsigned char *out);
+
+        // Returns the checksum stored with the pixels in cache files.
+        static unsigned Checksum(const unsigned char *data, int size);
+
+        // Results of ReadCacheFile()
+        static const int CACHE_OK = 0;
+        static const int CACHE_MISSING = 1;
+        static const int CACHE_INVALID = 2; // stale parameters, truncated or corrupt
+
+        // Writes the given parameters' pixels (GetMipChainSize() bytes) to a cache file,
+        // atomically. Returns whether it succeeded.
+        static bool WriteCacheFile(const char *fileName, const Params& params,
+                const unsigned char *pixels);
+
+        // Reads the given parameters' pixels from a cache file into pixels (which must
+        // be GetMipChainSize() bytes long). Returns one of the CACHE_* results; pixels
+        // are only valid with CACHE_OK.
+        static int ReadCacheFile(const char *fileName, const Params& params,
+                unsigned char *pixels);
+
+    private:
+        Params mParams;
+        unsigned char *mPixels;
+        int mPixelsSize;
+        int mLevels;
+        char *mCacheFileName;
+        pthread_t mThread;
+        bool mThreadStarted;
+        std::atomic<bool> mReady;
+
+        static void* ThreadProc(void *arg);
+        void Produce();
+        bool LoadFromCache();
+        void SaveToCache();
+};
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// The parts of WallTextureGen that don't need GL or threads: the generator itself and
+// the cache file format.
+#include <cstdio>
+#include <cstring>
+#include "util.hpp"
+#include "wall_texture.hpp"
+
+// bump this whenever the generator's output changes for the same parameters, so that
+// stale cache files get ignored
+#define WALL_TEXTURE_GEN_VERSION 1
+
+// cache file format. Files from the first format ("WTEX", no checksum) are rejected
+#define WALL_TEXTURE_CACHE_MAGIC 0x32585457 // "WTX2"
+
+struct WallTextureCacheHeader {
+    unsigned magic;
+    unsigned hash;
+    int size;
+    int levels;
+    int dataSize;
+    unsigned checksum; // Checksum() of the dataSize bytes that follow
+};
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+unsigned WallTextureGen::HashParams(const Params& params) {
+    // FNV-1a over each parameter
+    const int values[] = { WALL_TEXTURE_GEN_VERSION, params.size, params.border, params.base,
+            params.noise, (int)params.seed };
+    unsigned hash = FNV_OFFSET_BASIS;
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        unsigned v = (unsigned)values[i];
+        for (int b = 0; b < 4; b++) {
+            hash = (hash ^ ((v >> (b * 8)) & 0xff)) * FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+int WallTextureGen::GetMipChainSize(const Params& params, int *outLevels) {
+    int total = 0, levels = 0;
+    for (int s = params.size; s >= 1; s /= 2) {
+        total += s * s * 3;
+        levels++;
+    }
+    if (outLevels) {
+        *outLevels = levels;
+    }
+    return total;
+}
+
+void WallTextureGen::Generate(const Params& params, unsigned char *out) {
+    // base level: gray noise. We use our own generator (rather than rand()) because we
+    // run on a worker thread, and because the output must be reproducible from the seed.
+    unsigned state = params.seed;
+    unsigned char *p = out;
+    int x, y;
+    for (y = 0; y < params.size; y++) {
+        for (x = 0; x < params.size; x++, p += 3) {
+            state = state * 1103515245u + 12345u;
+            int noise = params.noise > 0 ? (int)((state >> 16) & 0x7fff) % params.noise : 0;
+            bool plain = x < params.border || y < params.border;
+            p[0] = p[1] = p[2] = (unsigned char)Clamp(params.base + (plain ? 0 : noise), 0, 255);
+        }
+    }
+
+    // remaining levels: 2x2 box filter of the previous level
+    const unsigned char *src = out;
+    int srcSize = params.size;
+    unsigned char *dst = out + srcSize * srcSize * 3;
+    while (srcSize > 1) {
+        int dstSize = srcSize / 2;
+        for (y = 0; y < dstSize; y++) {
+            const unsigned char *row0 = src + (y * 2) * srcSize * 3;
+            const unsigned char *row1 = row0 + srcSize * 3;
+            for (x = 0; x < dstSize; x++) {
+                for (int c = 0; c < 3; c++) {
+                    int sum = row0[x * 6 + c] + row0[x * 6 + 3 + c] +
+                            row1[x * 6 + c] + row1[x * 6 + 3 + c];
+                    dst[(y * dstSize + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        src = dst;
+        dst += dstSize * dstSize * 3;
+        srcSize = dstSize;
+    }
+}
+
+unsigned WallTextureGen::Checksum(const unsigned char *data, int size) {
+    // FNV-1a over 32-bit words, in four interleaved lanes so the multiplies don't wait
+    // on each other, then over the lanes and the leftover bytes. Each step is a
+    // bijection of the lane's state, so any single changed word changes the result.
+    // This is not meant to resist tampering, only to catch files that were truncated,
+    // torn or bit-flipped on their way to and from storage.
+    unsigned lanes[4] = { FNV_OFFSET_BASIS, FNV_OFFSET_BASIS + 1, FNV_OFFSET_BASIS + 2,
+            FNV_OFFSET_BASIS + 3 };
+    int i = 0;
+    for (; i + 16 <= size; i += 16) {
+        unsigned words[4];
+        memcpy(words, data + i, sizeof(words));
+        for (int l = 0; l < 4; l++) {
+            lanes[l] = (lanes[l] ^ words[l]) * FNV_PRIME;
+        }
+    }
+
+    unsigned hash = FNV_OFFSET_BASIS;
+    const unsigned char *lanesBytes = reinterpret_cast<const unsigned char*>(lanes);
+    for (unsigned b = 0; b < sizeof(lanes); b++) {
+        hash = (hash ^ lanesBytes[b]) * FNV_PRIME;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+bool WallTextureGen::WriteCacheFile(const char *fileName, const Params& params,
+        const unsigned char *pixels) {
+    // write to a temporary file and then rename it, so that a crash midway through
+    // never leaves a truncated cache file behind
+    int len = strlen(fileName) + 5;
+    char *tmpName = new char[len];
+    snprintf(tmpName, len, "%s.tmp", fileName);
+
+    WallTextureCacheHeader header;
+    header.magic = WALL_TEXTURE_CACHE_MAGIC;
+    header.hash = HashParams(params);
+    header.size = params.size;
+    header.dataSize = GetMipChainSize(params, &header.levels);
+    header.checksum = Checksum(pixels, header.dataSize);
+
+    FILE *f = fopen(tmpName, "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        ok = 1 == fwrite(&header, sizeof(header), 1, f) &&
+                1 == fwrite(pixels, header.dataSize, 1, f);
+        ok = (0 == fclose(f)) && ok;
+    }
+    ok = ok && 0 == rename(tmpName, fileName);
+    if (!ok) {
+        remove(tmpName);
+    }
+    delete [] tmpName;
+    return ok;
+}
+
+int WallTextureGen::ReadCacheFile(const char *fileName, const Params& params,
+        unsigned char *pixels) {
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        return CACHE_MISSING;
+    }
+
+    int levels;
+    int dataSize = GetMipChainSize(params, &levels);
+    WallTextureCacheHeader header;
+    bool ok = 1 == fread(&header, sizeof(header), 1, f) &&
+            header.magic == WALL_TEXTURE_CACHE_MAGIC &&
+            header.hash == HashParams(params) &&
+            header.size == params.size &&
+            header.levels == levels &&
+            header.dataSize == dataSize &&
+            1 == fread(pixels, dataSize, 1, f) &&
+            EOF == fgetc(f) && // nothing may follow the pixels
+            header.checksum == Checksum(pixels, dataSize);
+    fclose(f);
+    return ok ? CACHE_OK : CACHE_INVALID;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Linux unit test of the game clock (util.cpp).
+//
+// Checks that ClockNs() is monotonic and stops while paused, that the
+// SecondsToNs()/SecondsSince() deadlines the scenes use stay exact where float
+// seconds would not, that ClockPeriodic() stays in range and that DeltaClock
+// hides a one-off stall when smoothing. Then a second thread reads the clock
+// while the main thread pauses and resumes it, as the wall texture worker does
+// while the app goes in and out of the background: readings must never go
+// backwards. Build it with -fsanitize=thread as well to check for data races.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -pthread -I$JNI -o clockTest clockTest.cpp $JNI/util.cpp
+//  ./clockTest
+//  g++ -std=c++11 -O1 -g -fsanitize=thread -pthread -I$JNI -o clockTest_tsan
+//    clockTest.cpp $JNI/util.cpp
+//  ./clockTest_tsan
+
+#include <atomic>
+#include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "util.hpp"
+
+static int _failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        _failures++; \
+    } \
+} while (0)
+
+static const int64_t MS = 1000000LL;
+
+static void TestMonotonic() {
+    int64_t last = ClockNs();
+    for (int i = 0; i < 100000; i++) {
+        int64_t now = ClockNs();
+        CHECK(now >= last, "clock went back %lld ns", (long long)(last - now));
+        last = now;
+    }
+    int64_t start = ClockNs();
+    usleep(20000);
+    int64_t elapsed = ClockNs() - start;
+    CHECK(elapsed >= 20 * MS, "slept 20 ms, clock advanced %lld ns", (long long)elapsed);
+}
+
+static void TestPause() {
+    int64_t start = ClockNs();
+    PauseClock();
+    PauseClock(); // repeated calls are harmless
+    int64_t paused = ClockNs();
+    usleep(50000);
+    CHECK(ClockNs() == paused, "clock advanced while paused");
+    ResumeClock();
+    ResumeClock();
+    usleep(10000);
+    // Only the 10 ms after resuming count, not the 50 ms paused
+    int64_t elapsed = ClockNs() - start;
+    CHECK(elapsed >= 10 * MS && elapsed < 40 * MS,
+            "elapsed %lld ns across a 50 ms pause", (long long)elapsed);
+}
+
+static void TestDeadlines() {
+    // The scenes keep deadlines as ClockNs() + SecondsToNs(duration)
+    int64_t start = ClockNs() - SecondsToNs(1.5f);
+    float since = SecondsSince(start);
+    CHECK(since >= 1.5f && since < 1.6f, "SecondsSince = %f, expected ~1.5", since);
+    CHECK(SecondsToNs(0.25f) == 250 * MS, "SecondsToNs(0.25) = %lld",
+            (long long)SecondsToNs(0.25f));
+
+    // Why deadlines are integers: after ten days of uptime, a 16 ms frame
+    // measured with float seconds is off by more than the frame itself.
+    int64_t uptime = 10LL * 24 * 3600 * 1000 * MS;
+    int64_t later = uptime + 16 * MS;
+    float floatDelta = (float)(later * 1e-9) - (float)(uptime * 1e-9);
+    float intDelta = (float)((later - uptime) * 1e-9);
+    CHECK(intDelta == 0.016f, "integer delta %f", intDelta);
+    CHECK(Abs(floatDelta - 0.016f) > 0.008f,
+            "float seconds were expected to lose the frame delta");
+    printf("16 ms frame after 10 days: float seconds %.6f s, integer ns %.6f s\n",
+            floatDelta, intDelta);
+}
+
+static void TestPeriodic() {
+    for (int i = 0; i < 1000; i++) {
+        float p = ClockPeriodic(0.003f);
+        CHECK(p >= 0.0f && p < 0.003f, "ClockPeriodic(0.003) = %f", p);
+    }
+    CHECK(ClockPeriodic(0.0f) == 0.0f, "zero period");
+}
+
+static void TestDeltaClock() {
+    DeltaClock clock;
+    clock.SetSmoothing(true);
+    float d = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        // One 100 ms stall among 5 ms frames
+        usleep(i == 5 ? 100000 : 5000);
+        d = clock.ReadDelta();
+        if (i == 5) {
+            CHECK(d < 0.05f, "smoothed delta %f s let the stall through", d);
+        }
+    }
+    DeltaClock capped(0.02f);
+    usleep(50000);
+    d = capped.ReadDelta();
+    CHECK(d <= 0.02f, "capped delta %f s", d);
+}
+
+static std::atomic<bool> _stop(false);
+static std::atomic<long> _backwards(0);
+
+static void *ReaderProc(void *) {
+    int64_t last = ClockNs();
+    while (!_stop.load()) {
+        int64_t now = ClockNs();
+        float since = SecondsSince(now);
+        if (now < last || since < 0.0f) {
+            _backwards++;
+        }
+        last = now;
+    }
+    return NULL;
+}
+
+static void TestConcurrentPause() {
+    pthread_t reader;
+    pthread_create(&reader, NULL, ReaderProc, NULL);
+    for (int i = 0; i < 20000; i++) {
+        PauseClock();
+        ClockNs();
+        ResumeClock();
+    }
+    _stop.store(true);
+    pthread_join(reader, NULL);
+    CHECK(_backwards.load() == 0, "reader saw the clock go back %ld times",
+            _backwards.load());
+}
+
+int main() {
+    TestMonotonic();
+    TestPause();
+    TestDeadlines();
+    TestPeriodic();
+    TestDeltaClock();
+    TestConcurrentPause();
+    if (_failures) {
+        printf("FAILED: %d check(s)\n", _failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
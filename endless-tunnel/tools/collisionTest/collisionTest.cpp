@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Linux regression test and microbenchmark of the obstacle collision math
+// (collision.cpp) used by PlayScene::DetectCollisions.
+//
+// Player trajectories are recorded through a tunnel of random obstacles, moving as
+// PlayScene::DoFrame moves the player, then replayed through two copies of the frame's
+// collision step: the one the game had before the masks (shift the sections, then test
+// obstacle 0 at the player's cell, by grid lookup) and the current one (test every
+// obstacle entered during the frame with collision.cpp, then shift).
+//
+// At normal speeds, up to PLAYER_SPEED plus NORMAL_LEVELS levels of speed increments and
+// frames no longer than MAX_DELTA_T, both must report the same crashes and bonuses for
+// the same obstacles, frame by frame. At high speeds, where a frame may carry the player
+// past whole sections, the current step must test every obstacle the player entered
+// (bar those past a crash in the same frame), including those the old one skipped, and
+// must agree with the old one on every obstacle that one did test. Close calls must
+// match a lookup of the cells around the player. Then it times both steps.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -I$JNI -o collisionTest collisionTest.cpp
+//    $JNI/collision.cpp $JNI/util.cpp
+//  ./collisionTest [frames]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "collision.hpp"
+#include "util.hpp"
+
+// as PlayScene
+#define MAX_OBS (RENDER_TUNNEL_SECTION_COUNT * 2)
+
+// normal speeds go up to this level
+#define NORMAL_LEVELS 20
+
+// high speeds, in units per second; at MAX_DELTA_T, from half a section to several
+// sections per frame
+#define HIGH_SPEED_MIN (0.5f * TUNNEL_SECTION_LENGTH / MAX_DELTA_T)
+#define HIGH_SPEED_MAX (4.0f * TUNNEL_SECTION_LENGTH / MAX_DELTA_T)
+
+struct TestObstacle {
+    bool grid[OBS_GRID_SIZE][OBS_GRID_SIZE]; // [col][row], as in Obstacle
+    int bonusCol, bonusRow;
+    unsigned solidMask, bonusMask;
+};
+
+struct Position {
+    float x, y, z;
+};
+
+// what a collision step found: the obstacle's section and COLLISION_*
+struct Event {
+    int section;
+    int result;
+    bool operator==(const Event& other) const {
+        return section == other.section && result == other.result;
+    }
+};
+
+static float RandomFloat(float lo, float hi) {
+    return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+static void MakeObstacle(int section, TestObstacle *o) {
+    memset(o->grid, 0, sizeof(o->grid));
+    o->solidMask = o->bonusMask = 0;
+    o->bonusCol = o->bonusRow = -1;
+    if (section < OBS_START_SECTION) {
+        // as PlayScene::GenObstacles, the first sections are empty
+        return;
+    }
+    int fill = Random(0, 60);
+    for (int c = 0; c < OBS_GRID_SIZE; c++) {
+        for (int r = 0; r < OBS_GRID_SIZE; r++) {
+            o->grid[c][r] = Random(100) < fill;
+            if (o->grid[c][r]) {
+                o->solidMask |= CellBit(c, r);
+            }
+        }
+    }
+    int c = Random(OBS_GRID_SIZE), r = Random(OBS_GRID_SIZE);
+    if (!o->grid[c][r] && Random(100) < 70) {
+        o->bonusCol = c;
+        o->bonusRow = r;
+        o->bonusMask = CellBit(c, r);
+    }
+}
+
+// Obstacle::GetColAt and Obstacle::GetRowAt
+static int ColAt(float x) {
+    return Clamp((int)floor((x + TUNNEL_HALF_W) / OBS_CELL_SIZE), 0, OBS_GRID_SIZE - 1);
+}
+
+static int RowAt(float z) {
+    return Clamp((int)floor((z + TUNNEL_HALF_H) / OBS_CELL_SIZE), 0, OBS_GRID_SIZE - 1);
+}
+
+static float SectionCenterY(int section) {
+    return (float)section * TUNNEL_SECTION_LENGTH;
+}
+
+static float EntryY(int section) {
+    return SectionCenterY(section) - OBS_BOX_SIZE;
+}
+
+// the obstacle of every section, generated as first needed and shared by both steps
+static std::vector<TestObstacle> sObstacles;
+
+static const TestObstacle& ObstacleAt(int section) {
+    while ((int)sObstacles.size() <= section) {
+        sObstacles.push_back(TestObstacle());
+        MakeObstacle((int)sObstacles.size() - 1, &sObstacles.back());
+    }
+    return sObstacles[section];
+}
+
+// The sections as PlayScene holds them: the first section not shifted out yet.
+struct Tunnel {
+    int firstSection;
+
+    void Reset() {
+        firstSection = 0;
+    }
+
+    // PlayScene::ShiftIfNeeded
+    void Shift(float y) {
+        while (y > SectionCenterY(firstSection) + 0.5f * TUNNEL_SECTION_LENGTH + SHIFT_THRESH) {
+            firstSection++;
+        }
+    }
+};
+
+// The collision step before the masks: DoFrame shifted the sections, then
+// DetectCollisions tested obstacle 0 at the player's cell if its entry plane was crossed.
+// (It also looked for a close call, with row and column swapped, and dropped the result.)
+static bool OldStep(Tunnel *tunnel, const Position& from, const Position& to, Event *event) {
+    tunnel->Shift(to.y);
+    int section = tunnel->firstSection;
+    float obsMin = EntryY(section);
+    if (!(from.y < obsMin && to.y >= obsMin)) {
+        return false;
+    }
+    const TestObstacle& o = ObstacleAt(section);
+    int col = ColAt(to.x), row = RowAt(to.z);
+    event->section = section;
+    if (o.grid[col][row]) {
+        event->result = COLLISION_CRASH;
+    } else if (row == o.bonusRow && col == o.bonusCol) {
+        event->result = COLLISION_BONUS;
+    } else {
+        event->result = COLLISION_NONE;
+    }
+    return true;
+}
+
+// The current one, as DoFrame and DetectCollisions do it; returns the obstacles tested
+// in order, up to a crash.
+static void NewStep(Tunnel *tunnel, const Position& from, const Position& to,
+        std::vector<Event> *events, std::vector<Position> *hits) {
+    events->clear();
+    hits->clear();
+    int lo, hi;
+    if (to.y > from.y && GetObstaclesEnteredBetween(EntryY(tunnel->firstSection), MAX_OBS,
+            from.y, to.y, &lo, &hi)) {
+        for (int index = lo; index <= hi; index++) {
+            int section = tunnel->firstSection + index;
+            const TestObstacle& o = ObstacleAt(section);
+            Position hit;
+            GetCrossingPosition(EntryY(section), index == hi, from.x, from.y, from.z, to.x,
+                    to.y, to.z, &hit.x, &hit.z);
+            hit.y = EntryY(section);
+            Event event = { section, TestObstacleCrossing(o.solidMask, o.bonusMask, hit.x,
+                    hit.z) };
+            events->push_back(event);
+            hits->push_back(hit);
+            if (event.result == COLLISION_CRASH) {
+                break;
+            }
+        }
+    }
+    tunnel->Shift(to.y);
+}
+
+// Is there a box in a cell within CLOSE_CALL_CALC_DELTA of (x, z)? Looks up the cells of
+// the nine points DetectCollisions used to.
+static bool IsCloseCall(const TestObstacle& o, float x, float z) {
+    for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
+            if (o.grid[ColAt(x + i * CLOSE_CALL_CALC_DELTA)][RowAt(z + j * CLOSE_CALL_CALC_DELTA)]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// A trajectory, moving the player as DoFrame does: steering within
+// PLAYER_MAX_LAT_SPEED, clamped to the tunnel, frames of 60 fps with jitter and stalls,
+// clamped to MAX_DELTA_T.
+static void RecordTrajectory(int frames, float minSpeed, float maxSpeed,
+        std::vector<Position> *positions) {
+    Position p = { 0.0f, 0.0f, 0.0f };
+    float steerX = 0.0f, steerZ = 0.0f;
+    float speed = RandomFloat(minSpeed, maxSpeed);
+    positions->assign(1, p);
+    for (int f = 0; f < frames; f++) {
+        float dt = Random(100) < 2 ? RandomFloat(0.1f, 1.0f) : RandomFloat(0.012f, 0.020f);
+        dt = Min(dt, MAX_DELTA_T);
+        steerX = Clamp(steerX + RandomFloat(-0.3f, 0.3f), -1.0f, 1.0f);
+        steerZ = Clamp(steerZ + RandomFloat(-0.3f, 0.3f), -1.0f, 1.0f);
+        if (Random(1000) == 0) {
+            // a new level, or a new run
+            speed = RandomFloat(minSpeed, maxSpeed);
+        }
+        p.x = Clamp(p.x + dt * steerX * PLAYER_MAX_LAT_SPEED, PLAYER_MIN_X, PLAYER_MAX_X);
+        p.y += dt * speed;
+        p.z = Clamp(p.z + dt * steerZ * PLAYER_MAX_LAT_SPEED, PLAYER_MIN_Z, PLAYER_MAX_Z);
+        positions->push_back(p);
+    }
+}
+
+static int NoCloseCall(int result) {
+    return result == COLLISION_CLOSE_CALL ? COLLISION_NONE : result;
+}
+
+// Replays a trajectory through both steps; returns false on any failed check.
+static bool Replay(const char *name, const std::vector<Position>& positions,
+        bool normalSpeed) {
+    Tunnel oldTunnel, tunnel;
+    oldTunnel.Reset();
+    tunnel.Reset();
+    int failures = 0, crossed = 0, tested = 0, oldTested = 0, oldSkipped = 0;
+    int pastCrash = 0, closeCallMismatches = 0;
+    int results[4] = { 0, 0, 0, 0 };
+    std::vector<Event> events;
+    std::vector<Position> hits;
+    for (size_t f = 1; f < positions.size(); f++) {
+        const Position& from = positions[f - 1];
+        const Position& to = positions[f];
+        Event oldEvent;
+        bool oldHit = OldStep(&oldTunnel, from, to, &oldEvent);
+        NewStep(&tunnel, from, to, &events, &hits);
+
+        // the entry planes the player went through in this frame
+        int firstCrossed = (int)ceil((from.y + OBS_BOX_SIZE) / TUNNEL_SECTION_LENGTH);
+        if (EntryY(firstCrossed) <= from.y) {
+            firstCrossed++;
+        }
+        int lastCrossed = (int)floor((to.y + OBS_BOX_SIZE) / TUNNEL_SECTION_LENGTH);
+        int crossedNow = Max(lastCrossed - firstCrossed + 1, 0);
+        crossed += crossedNow;
+        tested += (int)events.size();
+        oldTested += oldHit;
+        for (size_t i = 0; i < events.size(); i++) {
+            results[events[i].result]++;
+        }
+
+        // every obstacle entered, in order, up to a crash
+        bool crashed = !events.empty() && events.back().result == COLLISION_CRASH;
+        bool inOrder = (int)events.size() <= crossedNow;
+        for (size_t i = 0; i < events.size() && inOrder; i++) {
+            inOrder = events[i].section == firstCrossed + (int)i;
+        }
+        if (!inOrder || (!crashed && (int)events.size() != crossedNow)) {
+            if (failures++ < 10) {
+                printf("FAILED: %s frame %d entered sections %d to %d, tested %d from %d\n",
+                        name, (int)f, firstCrossed, lastCrossed, (int)events.size(),
+                        events.empty() ? -1 : events[0].section);
+            }
+        }
+        pastCrash += crossedNow - (int)events.size();
+
+        // the old step skipped what it did not test
+        if (!oldHit) {
+            oldSkipped += crossedNow;
+        } else {
+            oldSkipped += crossedNow - 1;
+        }
+
+        if (normalSpeed) {
+            // exactly what the old step found
+            bool same = oldHit ? events.size() == 1 && oldEvent.section == events[0].section &&
+                    oldEvent.result == NoCloseCall(events[0].result) : events.empty();
+            if (!same && failures++ < 10) {
+                printf("FAILED: %s frame %d: old step %s (section %d, result %d), "
+                        "new one tested %d\n", name, (int)f, oldHit ? "hit" : "found nothing",
+                        oldHit ? oldEvent.section : -1, oldHit ? oldEvent.result : -1,
+                        (int)events.size());
+            }
+        } else if (oldHit) {
+            // same result on the obstacle the old step tested, unless a crash stopped the
+            // new one before it
+            bool found = false;
+            for (size_t i = 0; i < events.size(); i++) {
+                if (events[i].section == oldEvent.section) {
+                    found = true;
+                    if (NoCloseCall(events[i].result) != oldEvent.result && failures++ < 10) {
+                        printf("FAILED: %s frame %d section %d: old result %d, new %d\n", name,
+                                (int)f, oldEvent.section, oldEvent.result, events[i].result);
+                    }
+                }
+            }
+            if (!found && !crashed && failures++ < 10) {
+                printf("FAILED: %s frame %d: section %d, tested by the old step, was not\n",
+                        name, (int)f, oldEvent.section);
+            }
+        }
+
+        for (size_t i = 0; i < events.size(); i++) {
+            if (events[i].result == COLLISION_CRASH || events[i].result == COLLISION_BONUS) {
+                continue;
+            }
+            const TestObstacle& o = ObstacleAt(events[i].section);
+            bool close = IsCloseCall(o, hits[i].x, hits[i].z);
+            if (close != (events[i].result == COLLISION_CLOSE_CALL)) {
+                closeCallMismatches++;
+            }
+        }
+    }
+    if (closeCallMismatches) {
+        printf("FAILED: %s: %d close calls differ from the cell lookup\n", name,
+                closeCallMismatches);
+        failures++;
+    }
+    if (normalSpeed ? oldSkipped != 0 : oldSkipped == 0) {
+        printf("FAILED: %s: the old step skipped %d obstacles\n", name, oldSkipped);
+        failures++;
+    }
+
+    printf("%s: %d frames, %d obstacles entered, %d tested (%d past a crash); the old step "
+            "tested %d and skipped %d\n", name, (int)positions.size() - 1, crossed, tested,
+            pastCrash, oldTested, oldSkipped);
+    printf("  crash %d, bonus %d, close call %d, none %d\n", results[COLLISION_CRASH],
+            results[COLLISION_BONUS], results[COLLISION_CLOSE_CALL], results[COLLISION_NONE]);
+    return failures == 0;
+}
+
+static bool CheckEdges() {
+    // a box in the middle cell, a bonus in the cell on its left
+    TestObstacle o;
+    memset(&o, 0, sizeof(o));
+    o.grid[2][2] = true;
+    o.solidMask = CellBit(2, 2);
+    o.bonusMask = CellBit(1, 2);
+    float cellLeft = -0.5f * OBS_CELL_SIZE;
+    struct { float x; int expected; } cases[] = {
+        { 0.0f, COLLISION_CRASH },
+        // the gap between the box and its cell edge still counts, as it always did
+        { cellLeft + 0.01f, COLLISION_CRASH },
+        { cellLeft, COLLISION_CRASH },
+        // in the bonus cell, next to the box
+        { cellLeft - 0.01f, COLLISION_BONUS },
+        { cellLeft - CLOSE_CALL_CALC_DELTA - 0.01f, COLLISION_BONUS },
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int got = TestObstacleCrossing(o.solidMask, o.bonusMask, cases[i].x, 0.0f);
+        if (got != cases[i].expected) {
+            printf("FAILED: edge case %d at x=%g: got %d, expected %d\n", (int)i, cases[i].x,
+                    got, cases[i].expected);
+            ok = false;
+        }
+    }
+    o.bonusMask = 0;
+    if (TestObstacleCrossing(o.solidMask, 0, cellLeft - 0.5f * CLOSE_CALL_CALC_DELTA,
+            0.0f) != COLLISION_CLOSE_CALL ||
+            TestObstacleCrossing(o.solidMask, 0, cellLeft - 1.5f * CLOSE_CALL_CALC_DELTA,
+            0.0f) != COLLISION_NONE) {
+        printf("FAILED: close call next to a box\n");
+        ok = false;
+    }
+    return ok;
+}
+
+// Times both steps on a trajectory.
+static void Benchmark(const std::vector<Position>& positions) {
+    const int REPEAT = 20;
+    Tunnel oldTunnel, tunnel;
+    std::vector<Event> events;
+    std::vector<Position> hits;
+    volatile int sink = 0;
+    int64_t start = ClockNs();
+    for (int k = 0; k < REPEAT; k++) {
+        oldTunnel.Reset();
+        for (size_t f = 1; f < positions.size(); f++) {
+            Event event;
+            if (OldStep(&oldTunnel, positions[f - 1], positions[f], &event)) {
+                sink += event.result;
+            }
+        }
+    }
+    int64_t oldNs = ClockNs() - start;
+    start = ClockNs();
+    for (int k = 0; k < REPEAT; k++) {
+        tunnel.Reset();
+        for (size_t f = 1; f < positions.size(); f++) {
+            NewStep(&tunnel, positions[f - 1], positions[f], &events, &hits);
+            sink += (int)events.size();
+        }
+    }
+    int64_t newNs = ClockNs() - start;
+    double frames = (double)REPEAT * (positions.size() - 1);
+    printf("ns per frame: old step %.1f, new step %.1f\n", oldNs / frames, newNs / frames);
+}
+
+int main(int argc, char **argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200000;
+    if (frames <= 0) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+    srand(1);
+
+    bool ok = CheckEdges();
+
+    std::vector<Position> normal, high;
+    RecordTrajectory(frames, PLAYER_SPEED, PLAYER_SPEED + NORMAL_LEVELS *
+            PLAYER_SPEED_INC_PER_LEVEL, &normal);
+    ok = Replay("normal speed", normal, true) && ok;
+    RecordTrajectory(frames / 10, HIGH_SPEED_MIN, HIGH_SPEED_MAX, &high);
+    ok = Replay("high speed", high, false) && ok;
+
+    Benchmark(normal);
+
+    printf(ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
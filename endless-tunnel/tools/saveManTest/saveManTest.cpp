@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Linux test and benchmark of the save game manager (save_man.cpp).
+//
+//  - Crash injection: a child process saves and flushes in a loop and is killed with
+//    SIGKILL at random times. The save file must always load, and must hold at least
+//    the last level whose Flush() returned. (Power loss, which the directory fsync
+//    is for, can't be simulated this way.)
+//  - Read your own writes: while the worker writes in the background, Load() must
+//    always return the level that was last requested.
+//  - Damaged files (truncated, bit-flipped) must be rejected.
+//  - Cost: how long RequestSave() takes on the game thread, how long Flush() blocks,
+//    and how many requests one write coalesces.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -pthread -I$JNI -o saveManTest saveManTest.cpp
+//    $JNI/save_man.cpp $JNI/util.cpp
+//  ./saveManTest [scratch dir]
+//
+// The damaged files it feeds to Load() are logged to stderr as they are rejected.
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "game_consts.hpp"
+#include "save_man.hpp"
+#include "util.hpp"
+
+// byte offset of SaveRecord::sequence in a save file
+#define SEQUENCE_OFFSET 8
+
+static int _failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        _failures++; \
+    } \
+} while (0)
+
+static char _fileName[256];
+
+static SaveMan::SaveData Level(int level) {
+    SaveMan::SaveData data;
+    data.level = level;
+    return data;
+}
+
+// SaveMan is meant to be a singleton: its worker thread never exits, so instances
+// must never be destroyed.
+static SaveMan *NewSaveMan() {
+    return new SaveMan();
+}
+
+static std::vector<unsigned char> ReadFile(const char *name) {
+    std::vector<unsigned char> data;
+    FILE *f = fopen(name, "rb");
+    int c;
+    while (f && (c = fgetc(f)) != EOF) {
+        data.push_back((unsigned char)c);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return data;
+}
+
+static void WriteFile(const char *name, const std::vector<unsigned char>& data) {
+    FILE *f = fopen(name, "wb");
+    if (!data.empty()) {
+        fwrite(&data[0], 1, data.size(), f);
+    }
+    fclose(f);
+}
+
+static void ChildSaveLoop(int ackFd) {
+    SaveMan *sm = NewSaveMan();
+    for (int level = 1; ; level++) {
+        sm->RequestSave(_fileName, Level(level));
+        if (level % 4 == 0 && sm->Flush(5.0f)) {
+            if (write(ackFd, &level, sizeof(level)) != sizeof(level)) {
+                _exit(1);
+            }
+        }
+    }
+}
+
+static void TestCrashes(int rounds) {
+    int killedMidWrite = 0, minLevel = 1 << 30, maxLevel = 0;
+    remove(_fileName);
+    for (int round = 0; round < rounds; round++) {
+        int fds[2];
+        if (pipe(fds)) {
+            CHECK(false, "pipe");
+            return;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            ChildSaveLoop(fds[1]);
+        }
+        close(fds[1]);
+        usleep(1000 + rand() % 20000);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        int acked = 0, level;
+        while (read(fds[0], &level, sizeof(level)) == sizeof(level)) {
+            acked = level;
+        }
+        close(fds[0]);
+
+        char tmpName[300];
+        snprintf(tmpName, sizeof(tmpName), "%s.tmp", _fileName);
+        if (access(tmpName, F_OK) == 0) {
+            ++killedMidWrite;
+        }
+
+        SaveMan::SaveData data;
+        bool ok = NewSaveMan()->Load(_fileName, &data);
+        if (!ok) {
+            // only acceptable if the child was killed before its first write
+            CHECK(acked == 0 && access(_fileName, F_OK) != 0,
+                    "round %d: save file does not load", round);
+            continue;
+        }
+        CHECK(data.level >= acked, "round %d: loaded level %d, but %d was flushed", round,
+                data.level, acked);
+        minLevel = std::min(minLevel, data.level);
+        maxLevel = std::max(maxLevel, data.level);
+        remove(_fileName);
+    }
+    printf("%d crashes: every save file loaded (levels %d to %d), %d killed mid-write\n",
+            rounds, minLevel, maxLevel, killedMidWrite);
+}
+
+static void TestReadYourWrites() {
+    SaveMan *sm = NewSaveMan();
+    SaveMan::SaveData data;
+    int stale = 0, loads = 0, level = 0;
+    int64_t end = ClockNs() + SecondsToNs(SAVE_MIN_INTERVAL * 3.5f);
+    while (ClockNs() < end) {
+        sm->RequestSave(_fileName, Level(++level));
+        for (int i = 0; i < 200; i++, loads++) {
+            if (!sm->Load(_fileName, &data) || data.level != level) {
+                stale++;
+            }
+        }
+    }
+    CHECK(stale == 0, "%d of %d loads did not see the last requested level", stale, loads);
+
+    std::vector<unsigned char> file = ReadFile(_fileName);
+    unsigned writes = 0;
+    if (file.size() >= SEQUENCE_OFFSET + sizeof(writes)) {
+        memcpy(&writes, &file[SEQUENCE_OFFSET], sizeof(writes));
+    }
+    CHECK(writes >= 2 && writes <= 5, "%u writes in 3.5 intervals", writes);
+    printf("%d requests coalesced into %u writes; %d loads, %d stale\n", level, writes,
+            loads, stale);
+    CHECK(sm->Flush(5.0f), "flush timed out");
+}
+
+static void TestFlushAndDamage() {
+    SaveMan *sm = NewSaveMan();
+    SaveMan::SaveData data;
+    sm->RequestSave(_fileName, Level(12345));
+    CHECK(sm->Flush(5.0f), "flush timed out");
+
+    // Flush() returned, so the file itself must have it (not just Load())
+    SaveMan *loader = NewSaveMan();
+    CHECK(loader->Load(_fileName, &data) && data.level == 12345, "flushed level not on disk");
+
+    std::vector<unsigned char> good = ReadFile(_fileName);
+    int rejected = 0, tried = 0;
+    for (size_t len = 0; len < good.size(); len++) {
+        WriteFile(_fileName, std::vector<unsigned char>(good.begin(), good.begin() + len));
+        tried++;
+        rejected += !loader->Load(_fileName, &data);
+    }
+    for (size_t bit = 0; bit < good.size() * 8; bit++) {
+        std::vector<unsigned char> bad = good;
+        bad[bit / 8] ^= 1 << (bit % 8);
+        WriteFile(_fileName, bad);
+        tried++;
+        rejected += !loader->Load(_fileName, &data);
+    }
+    CHECK(rejected == tried, "accepted %d of %d damaged files", tried - rejected, tried);
+
+    // and the legacy text format still loads
+    const char *legacy = "v1 7";
+    WriteFile(_fileName, std::vector<unsigned char>(legacy, legacy + strlen(legacy)));
+    CHECK(loader->Load(_fileName, &data) && data.level == 7, "legacy file");
+    remove(_fileName);
+}
+
+static void Benchmark() {
+    SaveMan *sm = NewSaveMan();
+    const int REQUESTS = 200000;
+    std::vector<int64_t> costs(REQUESTS);
+    for (int i = 0; i < REQUESTS; i++) {
+        int64_t start = ClockNs();
+        sm->RequestSave(_fileName, Level(i));
+        costs[i] = ClockNs() - start;
+    }
+    std::sort(costs.begin(), costs.end());
+    printf("RequestSave: median %lld ns, 99.9%% %lld ns, max %lld ns\n",
+            (long long)costs[REQUESTS / 2], (long long)costs[REQUESTS * 999 / 1000],
+            (long long)costs[REQUESTS - 1]);
+
+    const int FLUSHES = 50;
+    std::vector<int64_t> flushes(FLUSHES);
+    for (int i = 0; i < FLUSHES; i++) {
+        sm->RequestSave(_fileName, Level(i));
+        int64_t start = ClockNs();
+        CHECK(sm->Flush(5.0f), "flush timed out");
+        flushes[i] = ClockNs() - start;
+    }
+    std::sort(flushes.begin(), flushes.end());
+    printf("Flush: median %.3f ms, max %.3f ms (%.0f durable saves/s)\n",
+            flushes[FLUSHES / 2] * 1e-6, flushes[FLUSHES - 1] * 1e-6,
+            1e9 / flushes[FLUSHES / 2]);
+    remove(_fileName);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+    snprintf(_fileName, sizeof(_fileName), "%s/saveManTest_%d.dat", dir, (int)getpid());
+    srand(1);
+
+    // fork before this process starts any worker thread
+    TestCrashes(200);
+    TestReadYourWrites();
+    TestFlushAndDamage();
+    Benchmark();
+
+    char tmpName[300];
+    snprintf(tmpName, sizeof(tmpName), "%s.tmp", _fileName);
+    remove(tmpName);
+    if (_failures) {
+        printf("FAILED: %d check(s)\n", _failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
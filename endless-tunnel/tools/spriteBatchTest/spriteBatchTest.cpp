@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Linux test of the UI sprite batch (sprite_batch.cpp), drawing into a recording
+// SpriteTarget instead of GL.
+//
+// Random frames of overlapping quads and text-like lines are added to the batch,
+// each shape tagged with its index in its vertex color. The recorded draw calls must
+// contain every shape exactly once, with its own primitive and line width, and any
+// two shapes that overlap must come out in the order they were added, which is what
+// makes the batched result look like drawing them one by one. A menu-like frame
+// (buttons with a label on each) must take two draw calls. Also checks that runs
+// larger than the staging area are split without reordering. Fails on any mismatch,
+// and prints the draw calls the batch saved over an in-order batch.
+//
+// Build and run on the host (needs the GLES2 headers, e.g. from libgles2-mesa-dev),
+// from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -I$JNI -o spriteBatchTest spriteBatchTest.cpp
+//    $JNI/sprite_batch.cpp
+//  ./spriteBatchTest [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sprite_batch.hpp"
+
+static const float PIXEL_SIZE = 1.0f / 720.0f;
+
+struct RecordedDraw {
+    GLenum primitive;
+    float lineWidth;
+    std::vector<GLfloat> vertices;
+};
+
+class RecordingTarget : public SpriteTarget {
+    public:
+        std::vector<RecordedDraw> draws;
+        int frames;
+
+        RecordingTarget() {
+            frames = 0;
+        }
+        virtual void BeginFrame() {
+            ++frames;
+            draws.clear();
+        }
+        virtual float GetPixelSize() {
+            return PIXEL_SIZE;
+        }
+        virtual void Draw(const GLfloat *vertices, int vertexCount, GLenum primitive,
+                float lineWidth) {
+            RecordedDraw d;
+            d.primitive = primitive;
+            d.lineWidth = lineWidth;
+            d.vertices.assign(vertices, vertices + vertexCount * SpriteBatch::FLOATS_PER_VERTEX);
+            draws.push_back(d);
+        }
+};
+
+// A shape as the test added it.
+struct Shape {
+    GLenum primitive;
+    float lineWidth;
+    std::vector<GLfloat> xy; // expected positions, in the order they must be drawn
+    float bounds[4];
+};
+
+// Where a shape came out: draw call and first vertex in it.
+struct Placement {
+    int draw, vertex, vertexCount;
+};
+
+static int _failures = 0;
+
+static void Fail(const char *what, int frame, int shape) {
+    if (_failures++ < 10) {
+        printf("FAIL frame %d, shape %d: %s\n", frame, shape, what);
+    }
+}
+
+static float Min(float a, float b) {
+    return a < b ? a : b;
+}
+
+static float Max(float a, float b) {
+    return a > b ? a : b;
+}
+
+static float RandomFloat(float lo, float hi) {
+    return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+static void AddQuad(SpriteBatch *batch, std::vector<Shape> *shapes, float cx, float cy,
+        float w, float h) {
+    float color[3] = { (float)shapes->size(), 0.0f, 0.0f };
+    batch->AddQuad(cx, cy, w, h, color);
+
+    Shape s;
+    s.primitive = GL_TRIANGLES;
+    s.lineWidth = 1.0f;
+    float x0 = cx - 0.5f * w, x1 = cx + 0.5f * w, y0 = cy - 0.5f * h, y1 = cy + 0.5f * h;
+    float xy[12] = { x0, y0, x1, y0, x1, y1, x0, y0, x1, y1, x0, y1 };
+    s.xy.assign(xy, xy + 12);
+    s.bounds[0] = x0, s.bounds[1] = y0, s.bounds[2] = x1, s.bounds[3] = y1;
+    shapes->push_back(s);
+}
+
+// Adds a "glyph": a few random segments in a box, moved to (x, y).
+static void AddGlyph(SpriteBatch *batch, std::vector<Shape> *shapes, float x, float y,
+        float size, float lineWidth, int segments) {
+    float color[3] = { (float)shapes->size(), 0.0f, 0.0f };
+    std::vector<GLfloat> xy;
+    for (int i = 0; i < segments * 2; i++) {
+        xy.push_back(RandomFloat(0.0f, size));
+        xy.push_back(RandomFloat(0.0f, size));
+    }
+    glm::mat4 mat(1.0f);
+    mat[3][0] = x;
+    mat[3][1] = y;
+    batch->AddLines(&xy[0], segments * 2, mat, color, lineWidth);
+
+    Shape s;
+    s.primitive = GL_LINES;
+    s.lineWidth = lineWidth;
+    // what a wide line can cover: its endpoints' box grown by half the width
+    float pad = 0.5f * lineWidth * PIXEL_SIZE;
+    s.bounds[0] = s.bounds[1] = 1e9f;
+    s.bounds[2] = s.bounds[3] = -1e9f;
+    for (size_t i = 0; i < xy.size(); i += 2) {
+        float px = xy[i] + x, py = xy[i + 1] + y;
+        s.xy.push_back(px);
+        s.xy.push_back(py);
+        s.bounds[0] = Min(s.bounds[0], px - pad), s.bounds[1] = Min(s.bounds[1], py - pad);
+        s.bounds[2] = Max(s.bounds[2], px + pad), s.bounds[3] = Max(s.bounds[3], py + pad);
+    }
+    shapes->push_back(s);
+}
+
+static bool Overlaps(const float *a, const float *b) {
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+// Checks the recorded draws against the shapes. Returns the draw calls an in-order
+// batch (flushing on every state change) would have needed.
+static int CheckFrame(int frame, const std::vector<Shape>& shapes,
+        const RecordingTarget& target) {
+    const int F = SpriteBatch::FLOATS_PER_VERTEX;
+    std::vector<Placement> placed(shapes.size());
+    std::vector<int> seen(shapes.size(), 0);
+
+    // find each shape's vertices; they must be contiguous
+    for (size_t d = 0; d < target.draws.size(); d++) {
+        const RecordedDraw& draw = target.draws[d];
+        int count = (int)draw.vertices.size() / F;
+        for (int v = 0; v < count; ) {
+            int id = (int)draw.vertices[v * F + 3];
+            if (id < 0 || id >= (int)shapes.size()) {
+                Fail("unknown vertex", frame, id);
+                return 0;
+            }
+            int first = v;
+            while (v < count && (int)draw.vertices[v * F + 3] == id) {
+                ++v;
+            }
+            if (seen[id]++) {
+                Fail("drawn more than once or split", frame, id);
+                continue;
+            }
+            placed[id].draw = (int)d;
+            placed[id].vertex = first;
+            placed[id].vertexCount = v - first;
+
+            const Shape& s = shapes[id];
+            if (draw.primitive != s.primitive ||
+                    (s.primitive == GL_LINES && draw.lineWidth != s.lineWidth)) {
+                Fail("drawn with the wrong state", frame, id);
+            }
+            if ((int)s.xy.size() != (v - first) * 2) {
+                Fail("wrong vertex count", frame, id);
+                continue;
+            }
+            for (int i = first; i < v; i++) {
+                float dx = draw.vertices[i * F] - s.xy[(i - first) * 2];
+                float dy = draw.vertices[i * F + 1] - s.xy[(i - first) * 2 + 1];
+                if (dx * dx + dy * dy > 1e-10f) {
+                    Fail("wrong vertex position", frame, id);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < shapes.size(); i++) {
+        if (!seen[i]) {
+            Fail("not drawn", frame, (int)i);
+        }
+    }
+
+    // painter's order: overlapping shapes come out in the order they were added
+    for (size_t i = 0; i < shapes.size(); i++) {
+        for (size_t j = i + 1; j < shapes.size(); j++) {
+            if (!Overlaps(shapes[i].bounds, shapes[j].bounds)) {
+                continue;
+            }
+            const Placement& a = placed[i];
+            const Placement& b = placed[j];
+            if (a.draw > b.draw || (a.draw == b.draw && a.vertex > b.vertex)) {
+                Fail("drawn after a later shape it overlaps", frame, (int)i);
+            }
+        }
+    }
+
+    int inOrderDraws = 0;
+    for (size_t i = 0; i < shapes.size(); i++) {
+        if (i == 0 || shapes[i].primitive != shapes[i - 1].primitive ||
+                shapes[i].lineWidth != shapes[i - 1].lineWidth) {
+            ++inOrderDraws;
+        }
+    }
+    return inOrderDraws;
+}
+
+static void TestRandomFrames(SpriteBatch *batch, RecordingTarget *target, int frames) {
+    long batchedDraws = 0, inOrderDraws = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        std::vector<Shape> shapes;
+        int count = 1 + rand() % 300;
+        // a few large shapes make for many overlaps, small ones for few
+        float maxSize = RandomFloat(0.02f, 0.5f);
+
+        batch->Begin();
+        for (int i = 0; i < count; i++) {
+            float x = RandomFloat(0.0f, 1.7f), y = RandomFloat(0.0f, 1.0f);
+            if (rand() % 2) {
+                AddQuad(batch, &shapes, x, y, RandomFloat(0.0f, maxSize),
+                        RandomFloat(0.0f, maxSize));
+            } else {
+                AddGlyph(batch, &shapes, x, y, RandomFloat(0.0f, maxSize),
+                        (rand() % 4) ? 4.0f : 2.0f, 1 + rand() % 6);
+            }
+        }
+        batch->End();
+
+        inOrderDraws += CheckFrame(frame, shapes, *target);
+        batchedDraws += target->draws.size();
+        if (batch->GetDrawCallCount() != (int)target->draws.size()) {
+            Fail("wrong draw call count", frame, -1);
+        }
+    }
+    printf("%d random frames: %ld draw calls, %ld in order\n", frames, batchedDraws,
+            inOrderDraws);
+}
+
+static void TestMenu(SpriteBatch *batch, RecordingTarget *target) {
+    // a column of buttons, each with a border, a fill and a label, like UiWidget
+    std::vector<Shape> shapes;
+    batch->Begin();
+    for (int i = 0; i < 8; i++) {
+        float y = 0.1f + i * 0.11f;
+        AddQuad(batch, &shapes, 0.8f, y, 0.6f, 0.1f);
+        AddQuad(batch, &shapes, 0.8f, y, 0.58f, 0.09f);
+        for (int c = 0; c < 6; c++) {
+            AddGlyph(batch, &shapes, 0.62f + c * 0.06f, y - 0.025f, 0.05f, 4.0f, 4);
+        }
+    }
+    batch->End();
+    CheckFrame(-1, shapes, *target);
+    if (target->draws.size() != 2) {
+        printf("FAIL menu took %d draw calls, expected 2\n", (int)target->draws.size());
+        _failures++;
+    }
+
+    // a label under a button that was added after it must stay under it
+    shapes.clear();
+    batch->Begin();
+    AddGlyph(batch, &shapes, 0.5f, 0.5f, 0.05f, 4.0f, 4);
+    AddQuad(batch, &shapes, 0.7f, 0.5f, 0.2f, 0.2f);
+    AddQuad(batch, &shapes, 0.52f, 0.52f, 0.1f, 0.1f);
+    AddGlyph(batch, &shapes, 0.5f, 0.5f, 0.05f, 4.0f, 4);
+    batch->End();
+    CheckFrame(-2, shapes, *target);
+    if (target->draws.size() != 3) {
+        printf("FAIL covered label took %d draw calls, expected 3\n",
+                (int)target->draws.size());
+        _failures++;
+    }
+}
+
+static void TestOverflow(SpriteBatch *batch, RecordingTarget *target) {
+    // more quads than a run holds, then one text line longer than a run
+    std::vector<Shape> shapes;
+    batch->Begin();
+    for (int i = 0; i < 1000; i++) {
+        AddQuad(batch, &shapes, RandomFloat(0.0f, 1.7f), RandomFloat(0.0f, 1.0f), 0.01f,
+                0.01f);
+    }
+    AddGlyph(batch, &shapes, 0.1f, 0.1f, 0.5f, 2.0f, SpriteBatch::MAX_VERTICES);
+    batch->End();
+
+    // the long glyph is split in chunks, so check the quads by hand
+    shapes.pop_back();
+    int quadVertices = 0;
+    for (size_t d = 0; d < target->draws.size(); d++) {
+        const RecordedDraw& draw = target->draws[d];
+        int count = (int)draw.vertices.size() / SpriteBatch::FLOATS_PER_VERTEX;
+        if (count > SpriteBatch::MAX_VERTICES) {
+            printf("FAIL draw of %d vertices\n", count);
+            _failures++;
+        }
+        if (draw.primitive == GL_TRIANGLES) {
+            quadVertices += count;
+        } else if (count % 2) {
+            printf("FAIL line draw split a segment\n");
+            _failures++;
+        }
+    }
+    if (quadVertices != 6000 || target->draws.size() != 5) {
+        printf("FAIL overflow: %d quad vertices in %d draws\n", quadVertices,
+                (int)target->draws.size());
+        _failures++;
+    }
+}
+
+int main(int argc, char **argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    srand(1);
+
+    RecordingTarget *target = new RecordingTarget();
+    SpriteBatch *batch = new SpriteBatch(target);
+
+    TestRandomFrames(batch, target, frames);
+    TestMenu(batch, target);
+    TestOverflow(batch, target);
+    if (target->frames != frames + 3) {
+        printf("FAIL target saw %d frames\n", target->frames);
+        _failures++;
+    }
+
+    delete batch;
+    if (_failures) {
+        printf("FAILED: %d check(s)\n", _failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
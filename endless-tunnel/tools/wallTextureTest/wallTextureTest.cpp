@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Linux determinism test and benchmark of the wall texture generator and its cache
+// files (wall_texture_gen.cpp).
+//
+// The generator must produce the same mip chain for the same parameters every time,
+// on any thread, and the game's parameters must still produce the pixels they did
+// when the cache format was defined: if GOLDEN_CHECKSUM changes, so must
+// WALL_TEXTURE_GEN_VERSION, or old cache files would be taken for the new output.
+// Every level must be the box filter of the previous one. Cache files must read
+// back exactly, and any truncation, extra byte, flipped pixel byte or parameter
+// change must be rejected. Then it times generating against reading the cache.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -std=c++11 -O2 -pthread -I$JNI -o wallTextureTest wallTextureTest.cpp
+//    $JNI/wall_texture_gen.cpp $JNI/util.cpp
+//  ./wallTextureTest [scratch dir]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <vector>
+
+#include "util.hpp"
+#include "wall_texture.hpp"
+
+// Fnv1a() of the mip chain of the game's parameters (see play_scene.cpp)
+#define GOLDEN_CHECKSUM 0x09c985b1u
+
+static int _failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        _failures++; \
+    } \
+} while (0)
+
+// Plain byte-wise FNV-1a, kept apart from WallTextureGen::Checksum() so the golden
+// value only changes with the generator.
+static unsigned Fnv1a(const std::vector<unsigned char>& data) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < data.size(); i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static WallTextureGen::Params GameParams() {
+    WallTextureGen::Params p;
+    p.size = 64;
+    p.border = 3;
+    p.base = 128;
+    p.noise = 128;
+    p.seed = 1337;
+    return p;
+}
+
+static std::vector<unsigned char> Generate(const WallTextureGen::Params& params) {
+    std::vector<unsigned char> pixels(WallTextureGen::GetMipChainSize(params, NULL));
+    WallTextureGen::Generate(params, &pixels[0]);
+    return pixels;
+}
+
+static void TestDeterminism() {
+    WallTextureGen::Params params = GameParams();
+    std::vector<unsigned char> a = Generate(params), b = Generate(params);
+    CHECK(a == b, "two runs differ");
+    unsigned checksum = Fnv1a(a);
+    CHECK(checksum == GOLDEN_CHECKSUM, "game texture checksum %08x, expected %08x",
+            checksum, GOLDEN_CHECKSUM);
+
+    WallTextureGen::Params other = params;
+    other.seed++;
+    CHECK(Generate(other) != a, "another seed gave the same pixels");
+    CHECK(WallTextureGen::HashParams(other) != WallTextureGen::HashParams(params),
+            "another seed gave the same hash");
+
+    // plain border
+    for (int y = 0; y < params.size; y++) {
+        for (int x = 0; x < params.border; x++) {
+            CHECK(a[(y * params.size + x) * 3] == params.base &&
+                    a[(x * params.size + y) * 3] == params.base, "border at %d, %d", x, y);
+        }
+    }
+}
+
+static void TestMipChain() {
+    WallTextureGen::Params params = GameParams();
+    int levels;
+    int size = WallTextureGen::GetMipChainSize(params, &levels);
+    CHECK(levels == 7, "%d levels", levels);
+    std::vector<unsigned char> pixels = Generate(params);
+
+    const unsigned char *src = &pixels[0];
+    int srcSize = params.size;
+    for (int level = 1; level < levels; level++) {
+        const unsigned char *dst = src + srcSize * srcSize * 3;
+        int dstSize = srcSize / 2;
+        for (int y = 0; y < dstSize; y++) {
+            for (int x = 0; x < dstSize; x++) {
+                for (int c = 0; c < 3; c++) {
+                    int sum = src[((2 * y) * srcSize + 2 * x) * 3 + c] +
+                            src[((2 * y) * srcSize + 2 * x + 1) * 3 + c] +
+                            src[((2 * y + 1) * srcSize + 2 * x) * 3 + c] +
+                            src[((2 * y + 1) * srcSize + 2 * x + 1) * 3 + c];
+                    int expected = (sum + 2) / 4;
+                    int got = dst[(y * dstSize + x) * 3 + c];
+                    if (got != expected) {
+                        CHECK(false, "level %d pixel %d, %d: %d, expected %d", level, x, y,
+                                got, expected);
+                        return;
+                    }
+                }
+            }
+        }
+        src = dst;
+        srcSize = dstSize;
+    }
+    CHECK(src + 3 == &pixels[0] + size, "mip chain size");
+}
+
+static void *GenerateProc(void *arg) {
+    std::vector<unsigned char> *out = static_cast<std::vector<unsigned char>*>(arg);
+    *out = Generate(GameParams());
+    return NULL;
+}
+
+static void TestThreads() {
+    // the generator runs on a worker thread in the game: it must not share state
+    const int THREADS = 4;
+    pthread_t threads[THREADS];
+    std::vector<unsigned char> results[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, GenerateProc, &results[i]);
+    }
+    std::vector<unsigned char> expected = Generate(GameParams());
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        CHECK(results[i] == expected, "thread %d differs", i);
+    }
+}
+
+static std::vector<unsigned char> ReadFile(const char *name) {
+    std::vector<unsigned char> data;
+    FILE *f = fopen(name, "rb");
+    int c;
+    while (f && (c = fgetc(f)) != EOF) {
+        data.push_back((unsigned char)c);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return data;
+}
+
+static void WriteFile(const char *name, const std::vector<unsigned char>& data) {
+    FILE *f = fopen(name, "wb");
+    fwrite(&data[0], 1, data.size(), f);
+    fclose(f);
+}
+
+static void TestCacheFiles(const char *dir) {
+    WallTextureGen::Params params = GameParams();
+    std::vector<unsigned char> pixels = Generate(params);
+    std::vector<unsigned char> read(pixels.size());
+    char name[512];
+    snprintf(name, sizeof(name), "%s/wall_test.tex", dir);
+    remove(name);
+
+    CHECK(WallTextureGen::ReadCacheFile(name, params, &read[0]) ==
+            WallTextureGen::CACHE_MISSING, "missing file");
+    CHECK(WallTextureGen::WriteCacheFile(name, params, &pixels[0]), "write failed");
+    CHECK(WallTextureGen::ReadCacheFile(name, params, &read[0]) == WallTextureGen::CACHE_OK,
+            "read failed");
+    CHECK(read == pixels, "read back different pixels");
+
+    WallTextureGen::Params other = params;
+    other.noise--;
+    CHECK(WallTextureGen::ReadCacheFile(name, other, &read[0]) ==
+            WallTextureGen::CACHE_INVALID, "stale parameters accepted");
+
+    std::vector<unsigned char> good = ReadFile(name);
+    int headerSize = (int)(good.size() - pixels.size());
+    int rejected = 0, tried = 0;
+
+    // flip one bit in each of many pixel bytes, and in the header
+    for (int i = 0; i < (int)good.size(); i += (i < headerSize ? 1 : 97)) {
+        std::vector<unsigned char> bad = good;
+        bad[i] ^= 1 << (i % 8);
+        WriteFile(name, bad);
+        ++tried;
+        rejected += WallTextureGen::ReadCacheFile(name, params, &read[0]) ==
+                WallTextureGen::CACHE_INVALID;
+    }
+    // truncate at many lengths, and append a byte
+    for (int len = 0; len < (int)good.size(); len += 61) {
+        std::vector<unsigned char> bad(good.begin(), good.begin() + len);
+        if (bad.empty()) {
+            remove(name);
+            FILE *f = fopen(name, "wb");
+            fclose(f);
+        } else {
+            WriteFile(name, bad);
+        }
+        ++tried;
+        rejected += WallTextureGen::ReadCacheFile(name, params, &read[0]) ==
+                WallTextureGen::CACHE_INVALID;
+    }
+    std::vector<unsigned char> longer = good;
+    longer.push_back(0);
+    WriteFile(name, longer);
+    ++tried;
+    rejected += WallTextureGen::ReadCacheFile(name, params, &read[0]) ==
+            WallTextureGen::CACHE_INVALID;
+
+    CHECK(rejected == tried, "accepted %d of %d damaged files", tried - rejected, tried);
+    printf("rejected %d damaged cache files\n", rejected);
+    remove(name);
+}
+
+static void Benchmark(const char *dir) {
+    char name[512];
+    snprintf(name, sizeof(name), "%s/wall_bench.tex", dir);
+    for (int size = 64; size <= 1024; size *= 4) {
+        WallTextureGen::Params params = GameParams();
+        params.size = size;
+        std::vector<unsigned char> pixels(WallTextureGen::GetMipChainSize(params, NULL));
+        const int RUNS = 20;
+
+        int64_t start = ClockNs();
+        for (int i = 0; i < RUNS; i++) {
+            WallTextureGen::Generate(params, &pixels[0]);
+        }
+        float generateMs = (ClockNs() - start) * 1e-6f / RUNS;
+
+        WallTextureGen::WriteCacheFile(name, params, &pixels[0]);
+        start = ClockNs();
+        for (int i = 0; i < RUNS; i++) {
+            WallTextureGen::ReadCacheFile(name, params, &pixels[0]);
+        }
+        float readMs = (ClockNs() - start) * 1e-6f / RUNS;
+
+        start = ClockNs();
+        for (int i = 0; i < RUNS; i++) {
+            WallTextureGen::Checksum(&pixels[0], (int)pixels.size());
+        }
+        float checksumMs = (ClockNs() - start) * 1e-6f / RUNS;
+
+        printf("%4d x %-4d generate %7.3f ms, read cache %7.3f ms (checksum %7.3f ms)\n",
+                size, size, generateMs, readMs, checksumMs);
+    }
+    remove(name);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+
+    TestDeterminism();
+    TestMipChain();
+    TestThreads();
+    TestCacheFiles(dir);
+    Benchmark(dir);
+
+    if (_failures) {
+        printf("FAILED: %d check(s)\n", _failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
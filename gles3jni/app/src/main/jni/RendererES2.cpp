@@ -46,7 +46,7 @@ public:
 private:
     virtual float* mapOffsetBuf();
     virtual void unmapOffsetBuf();
-    virtual float* mapTransformBuf();
+    virtual float* mapTransformBuf(unsigned int numInstances);
     virtual void unmapTransformBuf();
     virtual void draw(unsigned int numInstances);
 
@@ -58,8 +58,8 @@ private:
     GLint mScaleRotUniform;
     GLint mOffsetUniform;
 
-    float mOffsets[2*MAX_INSTANCES];
-    float mScaleRot[4*MAX_INSTANCES];   // array of 2x2 column-major matrices
+    float mOffsets[2*ES2_MAX_INSTANCES];
+    float mScaleRot[4*ES2_MAX_INSTANCES];   // array of 2x2 column-major matrices
 };
 
 Renderer* createES2Renderer() {
@@ -72,7 +72,8 @@ Renderer* createES2Renderer() {
 }
 
 RendererES2::RendererES2()
-:   mEglContext(eglGetCurrentContext()),
+:   Renderer(ES2_INSTANCES_PER_SIDE),
+    mEglContext(eglGetCurrentContext()),
     mProgram(0),
     mVB(0),
     mPosAttrib(-1),
@@ -118,7 +119,7 @@ float* RendererES2::mapOffsetBuf() {
 void RendererES2::unmapOffsetBuf() {
 }
 
-float* RendererES2::mapTransformBuf() {
+float* RendererES2::mapTransformBuf(unsigned int numInstances) {
     return mScaleRot;
 }
 
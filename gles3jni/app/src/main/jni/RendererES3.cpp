@@ -16,6 +16,7 @@
 
 #include "gles3jni.h"
 #include <EGL/egl.h>
+#include <string.h>
 
 #define STR(s) #s
 #define STRV(s) STR(s)
@@ -25,6 +26,22 @@
 #define SCALEROT_ATTRIB 2
 #define OFFSET_ATTRIB 3
 
+// The transforms stream through a ring of TRANSFORM_FRAMES slices of one
+// buffer: the CPU writes one slice while the GPU may still read the others.
+// A fence after each draw tells when its slice can be written again.
+#define TRANSFORM_FRAMES 3
+#define TRANSFORM_FRAME_SIZE (MAX_INSTANCES * 4*sizeof(float))
+// A fence should signal within a few frames; a second means the GPU hung
+#define FENCE_TIMEOUT_NS 1000000000ull
+
+// GL_EXT_buffer_storage, to keep the ring mapped for the renderer's lifetime
+#ifndef GL_MAP_PERSISTENT_BIT_EXT
+#define GL_MAP_PERSISTENT_BIT_EXT 0x0040
+#define GL_MAP_COHERENT_BIT_EXT 0x0080
+#endif
+typedef void (GL_APIENTRY* BufferStorageEXTProc)(GLenum target,
+        GLsizeiptr size, const void* data, GLbitfield flags);
+
 static const char VERTEX_SHADER[] =
     "#version 300 es\n"
     "layout(location = " STRV(POS_ATTRIB) ") in vec2 pos;\n"
@@ -58,14 +75,22 @@ private:
 
     virtual float* mapOffsetBuf();
     virtual void unmapOffsetBuf();
-    virtual float* mapTransformBuf();
+    virtual float* mapTransformBuf(unsigned int numInstances);
     virtual void unmapTransformBuf();
     virtual void draw(unsigned int numInstances);
 
+    bool initTransformRing();
+
     const EGLContext mEglContext;
     GLuint mProgram;
     GLuint mVB[VB_COUNT];
-    GLuint mVBState;
+    // one vertex array per slice of the transform ring
+    GLuint mVBState[TRANSFORM_FRAMES];
+    GLsync mFences[TRANSFORM_FRAMES];
+    // slice holding the latest transforms
+    unsigned int mFrame;
+    // the whole ring when it is persistently mapped, NULL otherwise
+    float* mPersistentTransforms;
 };
 
 Renderer* createES3Renderer() {
@@ -78,12 +103,18 @@ Renderer* createES3Renderer() {
 }
 
 RendererES3::RendererES3()
-:   mEglContext(eglGetCurrentContext()),
+:   Renderer(MAX_INSTANCES_PER_SIDE),
+    mEglContext(eglGetCurrentContext()),
     mProgram(0),
-    mVBState(0)
+    mFrame(0),
+    mPersistentTransforms(NULL)
 {
     for (int i = 0; i < VB_COUNT; i++)
         mVB[i] = 0;
+    for (int i = 0; i < TRANSFORM_FRAMES; i++) {
+        mVBState[i] = 0;
+        mFences[i] = 0;
+    }
 }
 
 bool RendererES3::init() {
@@ -94,34 +125,75 @@ bool RendererES3::init() {
     glGenBuffers(VB_COUNT, mVB);
     glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_INSTANCE]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), &QUAD[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
-    glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * 4*sizeof(float), NULL, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_OFFSET]);
     glBufferData(GL_ARRAY_BUFFER, MAX_INSTANCES * 2*sizeof(float), NULL, GL_STATIC_DRAW);
+    if (!initTransformRing())
+        return false;
 
-    glGenVertexArrays(1, &mVBState);
-    glBindVertexArray(mVBState);
+    // the vertex arrays only differ in the slice SCALEROT_ATTRIB reads
+    glGenVertexArrays(TRANSFORM_FRAMES, mVBState);
+    for (int i = 0; i < TRANSFORM_FRAMES; i++) {
+        glBindVertexArray(mVBState[i]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_INSTANCE]);
-    glVertexAttribPointer(POS_ATTRIB, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, pos));
-    glVertexAttribPointer(COLOR_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, rgba));
-    glEnableVertexAttribArray(POS_ATTRIB);
-    glEnableVertexAttribArray(COLOR_ATTRIB);
+        glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_INSTANCE]);
+        glVertexAttribPointer(POS_ATTRIB, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, pos));
+        glVertexAttribPointer(COLOR_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, rgba));
+        glEnableVertexAttribArray(POS_ATTRIB);
+        glEnableVertexAttribArray(COLOR_ATTRIB);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
-    glVertexAttribPointer(SCALEROT_ATTRIB, 4, GL_FLOAT, GL_FALSE, 4*sizeof(float), 0);
-    glEnableVertexAttribArray(SCALEROT_ATTRIB);
-    glVertexAttribDivisor(SCALEROT_ATTRIB, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
+        glVertexAttribPointer(SCALEROT_ATTRIB, 4, GL_FLOAT, GL_FALSE, 4*sizeof(float),
+                (const GLvoid*)(i * TRANSFORM_FRAME_SIZE));
+        glEnableVertexAttribArray(SCALEROT_ATTRIB);
+        glVertexAttribDivisor(SCALEROT_ATTRIB, 1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_OFFSET]);
-    glVertexAttribPointer(OFFSET_ATTRIB, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), 0);
-    glEnableVertexAttribArray(OFFSET_ATTRIB);
-    glVertexAttribDivisor(OFFSET_ATTRIB, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_OFFSET]);
+        glVertexAttribPointer(OFFSET_ATTRIB, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), 0);
+        glEnableVertexAttribArray(OFFSET_ATTRIB);
+        glVertexAttribDivisor(OFFSET_ATTRIB, 1);
+    }
+    glBindVertexArray(0);
 
     ALOGV("Using OpenGL ES 3.0 renderer");
     return true;
 }
 
+bool RendererES3::initTransformRing() {
+    const GLsizeiptr size = TRANSFORM_FRAMES * TRANSFORM_FRAME_SIZE;
+    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
+
+    // With immutable storage the ring is mapped once and written in place;
+    // coherent mapping makes the writes visible to the next draw.
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    BufferStorageEXTProc bufferStorage = NULL;
+    if (extensions && strstr(extensions, "GL_EXT_buffer_storage")) {
+        bufferStorage = (BufferStorageEXTProc)
+                eglGetProcAddress("glBufferStorageEXT");
+    }
+    if (bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT |
+                GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+        bufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        if (!checkGlError("glBufferStorageEXT")) {
+            mPersistentTransforms = (float*)glMapBufferRange(GL_ARRAY_BUFFER,
+                    0, size, flags);
+        }
+        if (mPersistentTransforms) {
+            ALOGV("Transforms stream through a persistently mapped buffer");
+            return true;
+        }
+        checkGlError("glMapBufferRange");
+        // the storage can not be respecified: start over with a new buffer
+        glDeleteBuffers(1, &mVB[VB_SCALEROT]);
+        glGenBuffers(1, &mVB[VB_SCALEROT]);
+        glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
+    }
+
+    // Otherwise each frame maps its slice unsynchronized
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+    return !checkGlError("glBufferData");
+}
+
 RendererES3::~RendererES3() {
     /* The destructor may be called after the context has already been
      * destroyed, in which case our objects have already been destroyed.
@@ -131,7 +203,12 @@ RendererES3::~RendererES3() {
      */
     if (eglGetCurrentContext() != mEglContext)
         return;
-    glDeleteVertexArrays(1, &mVBState);
+    for (int i = 0; i < TRANSFORM_FRAMES; i++) {
+        if (mFences[i])
+            glDeleteSync(mFences[i]);
+    }
+    glDeleteVertexArrays(TRANSFORM_FRAMES, mVBState);
+    // deleting the buffer unmaps it
     glDeleteBuffers(VB_COUNT, mVB);
     glDeleteProgram(mProgram);
 }
@@ -147,19 +224,58 @@ void RendererES3::unmapOffsetBuf() {
     glUnmapBuffer(GL_ARRAY_BUFFER);
 }
 
-float* RendererES3::mapTransformBuf() {
-    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
-    return (float*)glMapBufferRange(GL_ARRAY_BUFFER,
-            0, MAX_INSTANCES * 4*sizeof(float),
-            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+float* RendererES3::mapTransformBuf(unsigned int numInstances) {
+    // wait until the GPU is done with the slice's last draw; that only
+    // blocks when it is TRANSFORM_FRAMES - 1 frames behind
+    const unsigned int frame = (mFrame + 1) % TRANSFORM_FRAMES;
+    if (mFences[frame]) {
+        GLenum result = glClientWaitSync(mFences[frame],
+                GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            // draw the previous transforms again
+            ALOGE("Transform ring fence timed out");
+            return NULL;
+        }
+        glDeleteSync(mFences[frame]);
+        mFences[frame] = 0;
+    }
+
+    float* transforms;
+    if (mPersistentTransforms) {
+        transforms = mPersistentTransforms +
+                frame * TRANSFORM_FRAME_SIZE/sizeof(float);
+    } else {
+        // the fence already synchronized with the GPU, so the driver need
+        // not; nor keep the slice's old contents
+        glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
+        transforms = (float*)glMapBufferRange(GL_ARRAY_BUFFER,
+                frame * TRANSFORM_FRAME_SIZE, numInstances * 4*sizeof(float),
+                GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                GL_MAP_INVALIDATE_RANGE_BIT);
+        if (!transforms) {
+            checkGlError("glMapBufferRange");
+            return NULL;
+        }
+    }
+    mFrame = frame;
+    return transforms;
 }
 
 void RendererES3::unmapTransformBuf() {
+    if (mPersistentTransforms)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, mVB[VB_SCALEROT]);
     glUnmapBuffer(GL_ARRAY_BUFFER);
 }
 
 void RendererES3::draw(unsigned int numInstances) {
     glUseProgram(mProgram);
-    glBindVertexArray(mVBState);
+    glBindVertexArray(mVBState[mFrame]);
     glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, numInstances);
+
+    // the slice may be read again when a map failed; the new fence covers
+    // both draws
+    if (mFences[mFrame])
+        glDeleteSync(mFences[mFrame]);
+    mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
@@ -19,6 +19,7 @@
 #include <time.h>
 
 #include "gles3jni.h"
+#include "sincos.h"
 
 const Vertex QUAD[4] = {
     // Square with diagonal < 2 so that it fits in a [-1 .. 1]^2 square
@@ -122,8 +123,9 @@ static void printGlString(const char* name, GLenum s) {
 
 // ----------------------------------------------------------------------------
 
-Renderer::Renderer()
-:   mNumInstances(0),
+Renderer::Renderer(unsigned int instancesPerSide)
+:   mInstancesPerSide(instancesPerSide),
+    mNumInstances(0),
     mLastFrameNs(0)
 {
     memset(mScale, 0, sizeof(mScale));
@@ -153,7 +155,7 @@ void Renderer::resize(int w, int h) {
 void Renderer::calcSceneParams(unsigned int w, unsigned int h,
         float* offsets) {
     // number of cells along the larger screen dimension
-    const float NCELLS_MAJOR = MAX_INSTANCES_PER_SIDE;
+    const float NCELLS_MAJOR = mInstancesPerSide;
     // cell size in scene space
     const float CELL_SIZE = 2.0f / NCELLS_MAJOR;
 
@@ -196,27 +198,16 @@ void Renderer::step() {
     clock_gettime(CLOCK_MONOTONIC, &now);
     auto nowNs = now.tv_sec*1000000000ull + now.tv_nsec;
 
+    // The first frame after resize() writes the transforms without moving
+    float dt = 0.0f;
     if (mLastFrameNs > 0) {
-        float dt = float(nowNs - mLastFrameNs) * 0.000000001f;
-
-        for (unsigned int i = 0; i < mNumInstances; i++) {
-            mAngles[i] += mAngularVelocity[i] * dt;
-            if (mAngles[i] >= TWO_PI) {
-                mAngles[i] -= TWO_PI;
-            } else if (mAngles[i] <= -TWO_PI) {
-                mAngles[i] += TWO_PI;
-            }
-        }
+        dt = float(nowNs - mLastFrameNs) * 0.000000001f;
+    }
 
-        float* transforms = mapTransformBuf();
-        for (unsigned int i = 0; i < mNumInstances; i++) {
-            float s = sinf(mAngles[i]);
-            float c = cosf(mAngles[i]);
-            transforms[4*i + 0] =  c * mScale[0];
-            transforms[4*i + 1] =  s * mScale[1];
-            transforms[4*i + 2] = -s * mScale[0];
-            transforms[4*i + 3] =  c * mScale[1];
-        }
+    float* transforms = mNumInstances ? mapTransformBuf(mNumInstances) : NULL;
+    if (transforms) {
+        stepRotations(mAngles, mAngularVelocity, dt, mScale, transforms,
+                mNumInstances);
         unmapTransformBuf();
     }
 
@@ -263,9 +254,13 @@ Java_com_android_gles3jni_GLES3JNILib_init(JNIEnv* env, jobject obj) {
     const char* versionStr = (const char*)glGetString(GL_VERSION);
     if (strstr(versionStr, "OpenGL ES 3.") && gl3stubInit()) {
         g_renderer = createES3Renderer();
-    } else if (strstr(versionStr, "OpenGL ES 2.")) {
+    }
+    // ES3 contexts run the ES2 renderer too, with fewer instances
+    if (!g_renderer && (strstr(versionStr, "OpenGL ES 2.") ||
+            strstr(versionStr, "OpenGL ES 3."))) {
         g_renderer = createES2Renderer();
-    } else {
+    }
+    if (!g_renderer) {
         ALOGE("Unsupported OpenGL ES version");
     }
 }
@@ -40,8 +40,11 @@
 // Types, functions, and data used by both ES2 and ES3 renderers.
 // Defined in gles3jni.cpp.
 
-#define MAX_INSTANCES_PER_SIDE 16
+#define MAX_INSTANCES_PER_SIDE 256
 #define MAX_INSTANCES   (MAX_INSTANCES_PER_SIDE * MAX_INSTANCES_PER_SIDE)
+// The ES2 renderer makes a draw call per instance, so it keeps a small grid
+#define ES2_INSTANCES_PER_SIDE 16
+#define ES2_MAX_INSTANCES (ES2_INSTANCES_PER_SIDE * ES2_INSTANCES_PER_SIDE)
 #define TWO_PI          (2.0 * M_PI)
 #define MAX_ROT_SPEED   (0.3 * TWO_PI)
 
@@ -78,15 +81,18 @@ public:
     void render();
 
 protected:
-    Renderer();
+    // the scene is a grid of instancesPerSide (<= MAX_INSTANCES_PER_SIDE)
+    // cells along the larger screen dimension.
+    explicit Renderer(unsigned int instancesPerSide);
 
-    // return a pointer to a buffer of MAX_INSTANCES * sizeof(vec2).
+    // return a pointer to a buffer of instancesPerSide^2 * sizeof(vec2).
     // the buffer is filled with per-instance offsets, then unmapped.
     virtual float* mapOffsetBuf() = 0;
     virtual void unmapOffsetBuf() = 0;
-    // return a pointer to a buffer of MAX_INSTANCES * sizeof(vec4).
-    // the buffer is filled with per-instance scale and rotation transforms.
-    virtual float* mapTransformBuf() = 0;
+    // return a pointer to a buffer of numInstances * sizeof(vec4), or NULL
+    // to skip this frame's update. the buffer is filled with per-instance
+    // scale and rotation transforms, then unmapped.
+    virtual float* mapTransformBuf(unsigned int numInstances) = 0;
     virtual void unmapTransformBuf() = 0;
 
     virtual void draw(unsigned int numInstances) = 0;
@@ -95,6 +101,7 @@ private:
     void calcSceneParams(unsigned int w, unsigned int h, float* offsets);
     void step();
 
+    const unsigned int mInstancesPerSide;
     unsigned int mNumInstances;
     float mScale[2];
     float mAngularVelocity[MAX_INSTANCES];
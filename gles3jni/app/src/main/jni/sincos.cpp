@@ -0,0 +1,251 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sincos.h"
+
+#if !defined(SINCOS_NO_SIMD) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define SINCOS_USE_NEON 1
+#include <arm_neon.h>
+#elif !defined(SINCOS_NO_SIMD) && (defined(__SSE2__) || defined(__x86_64__))
+#define SINCOS_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// A Lane holds LANE_WIDTH floats, Bits as many 32-bit integers. The kernels
+// are written once against these helpers.
+
+#if defined(SINCOS_USE_NEON)
+static const unsigned int LANE_WIDTH = 4;
+typedef float32x4_t Lane;
+typedef uint32x4_t Bits;
+static inline Lane load(const float* p) { return vld1q_f32(p); }
+static inline void store(float* p, Lane v) { vst1q_f32(p, v); }
+static inline Lane splat(float f) { return vdupq_n_f32(f); }
+static inline Lane add(Lane a, Lane b) { return vaddq_f32(a, b); }
+static inline Lane sub(Lane a, Lane b) { return vsubq_f32(a, b); }
+static inline Lane mul(Lane a, Lane b) { return vmulq_f32(a, b); }
+static inline Bits splatBits(uint32_t u) { return vdupq_n_u32(u); }
+static inline Bits asBits(Lane v) { return vreinterpretq_u32_f32(v); }
+static inline Bits andBits(Bits a, Bits b) { return vandq_u32(a, b); }
+static inline Bits addBits(Bits a, Bits b) { return vaddq_u32(a, b); }
+static inline Bits subBits(Bits a, Bits b) { return vsubq_u32(a, b); }
+static inline Bits signBit(Bits two) { return vshlq_n_u32(two, 30); }
+static inline Lane flipSign(Lane v, Bits sign) {
+    return vreinterpretq_f32_u32(veorq_u32(asBits(v), sign));
+}
+static inline Lane select(Bits mask, Lane a, Lane b) {
+    return vbslq_f32(mask, a, b);
+}
+// p[4*i .. 4*i+3] = {a[i], b[i], c[i], d[i]}
+static inline void storeInterleaved(float* p, Lane a, Lane b, Lane c, Lane d) {
+    float32x4x4_t v = {{a, b, c, d}};
+    vst4q_f32(p, v);
+}
+#elif defined(SINCOS_USE_SSE)
+static const unsigned int LANE_WIDTH = 4;
+typedef __m128 Lane;
+typedef __m128i Bits;
+static inline Lane load(const float* p) { return _mm_loadu_ps(p); }
+static inline void store(float* p, Lane v) { _mm_storeu_ps(p, v); }
+static inline Lane splat(float f) { return _mm_set1_ps(f); }
+static inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+static inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+static inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+static inline Bits splatBits(uint32_t u) { return _mm_set1_epi32(u); }
+static inline Bits asBits(Lane v) { return _mm_castps_si128(v); }
+static inline Bits andBits(Bits a, Bits b) { return _mm_and_si128(a, b); }
+static inline Bits addBits(Bits a, Bits b) { return _mm_add_epi32(a, b); }
+static inline Bits subBits(Bits a, Bits b) { return _mm_sub_epi32(a, b); }
+static inline Bits signBit(Bits two) { return _mm_slli_epi32(two, 30); }
+static inline Lane flipSign(Lane v, Bits sign) {
+    return _mm_xor_ps(v, _mm_castsi128_ps(sign));
+}
+static inline Lane select(Bits mask, Lane a, Lane b) {
+    const Lane m = _mm_castsi128_ps(mask);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline void storeInterleaved(float* p, Lane a, Lane b, Lane c, Lane d) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(p + 0, a);
+    _mm_storeu_ps(p + 4, b);
+    _mm_storeu_ps(p + 8, c);
+    _mm_storeu_ps(p + 12, d);
+}
+#else
+static const unsigned int LANE_WIDTH = 1;
+typedef float Lane;
+typedef uint32_t Bits;
+static inline Lane load(const float* p) { return *p; }
+static inline void store(float* p, Lane v) { *p = v; }
+static inline Lane splat(float f) { return f; }
+static inline Lane add(Lane a, Lane b) { return a + b; }
+static inline Lane sub(Lane a, Lane b) { return a - b; }
+static inline Lane mul(Lane a, Lane b) { return a * b; }
+static inline Bits splatBits(uint32_t u) { return u; }
+static inline Bits asBits(Lane v) {
+    Bits u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+static inline Bits andBits(Bits a, Bits b) { return a & b; }
+static inline Bits addBits(Bits a, Bits b) { return a + b; }
+static inline Bits subBits(Bits a, Bits b) { return a - b; }
+static inline Bits signBit(Bits two) { return two << 30; }
+static inline Lane flipSign(Lane v, Bits sign) {
+    const Bits u = asBits(v) ^ sign;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+static inline Lane select(Bits mask, Lane a, Lane b) { return mask ? a : b; }
+static inline void storeInterleaved(float* p, Lane a, Lane b, Lane c, Lane d) {
+    p[0] = a;
+    p[1] = b;
+    p[2] = c;
+    p[3] = d;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+// Adding then subtracting 1.5 * 2^23 rounds to the nearest integer, for
+// |x| < 2^22, and leaves that integer in the low mantissa bits of the sum.
+// It is the same on every target, unlike the float to int conversions.
+static const float ROUND_MAGIC = 12582912.0f;
+
+static const float TWO_OVER_PI = 0.636619772367581343f;
+// pi/2 split so that j * PIO2_1 and j * PIO2_2 are exact for the j reached
+static const float PIO2_1 = 1.5703125f;
+static const float PIO2_2 = 4.837512969970703125e-4f;
+static const float PIO2_3 = 7.54978995489188216e-8f;
+
+static const float TWO_PI = 6.28318530717958648f;
+static const float ONE_OVER_TWO_PI = 0.159154943091895336f;
+
+// Minimax polynomials on [-pi/4 .. pi/4], from the Cephes library
+static const float SIN_P0 = -1.6666654611e-1f;
+static const float SIN_P1 = 8.3321608736e-3f;
+static const float SIN_P2 = -1.9515295891e-4f;
+static const float COS_P0 = 4.166664568298827e-2f;
+static const float COS_P1 = -1.388731625493765e-3f;
+static const float COS_P2 = 2.443315711809948e-5f;
+
+// Nearest integer to x, as a float and, in *j, as an integer
+static inline Lane roundToInt(Lane x, Bits* j) {
+    const Lane magic = splat(ROUND_MAGIC);
+    const Lane t = add(x, magic);
+    *j = subBits(asBits(t), asBits(magic));
+    return sub(t, magic);
+}
+
+static inline void sinCos(Lane x, Lane* sine, Lane* cosine) {
+    // x = j * pi/2 + r, |r| <= pi/4
+    Bits j;
+    const Lane jf = roundToInt(mul(x, splat(TWO_OVER_PI)), &j);
+    Lane r = sub(x, mul(jf, splat(PIO2_1)));
+    r = sub(r, mul(jf, splat(PIO2_2)));
+    r = sub(r, mul(jf, splat(PIO2_3)));
+    const Lane z = mul(r, r);
+
+    Lane s = add(mul(splat(SIN_P2), z), splat(SIN_P1));
+    s = add(mul(s, z), splat(SIN_P0));
+    s = add(mul(mul(s, z), r), r);
+
+    Lane c = add(mul(splat(COS_P2), z), splat(COS_P1));
+    c = add(mul(c, z), splat(COS_P0));
+    c = add(sub(mul(mul(c, z), z), mul(splat(0.5f), z)), splat(1.0f));
+
+    // By quadrant j & 3, (sin x, cos x) is (s, c), (c, -s), (-s, -c) or
+    // (-c, s)
+    const Bits one = splatBits(1);
+    const Bits two = splatBits(2);
+    const Bits swap = subBits(splatBits(0), andBits(j, one));
+    *sine = flipSign(select(swap, c, s), signBit(andBits(j, two)));
+    *cosine = flipSign(select(swap, s, c),
+            signBit(andBits(addBits(j, one), two)));
+}
+
+static inline void stepRotation(Lane* angle, Lane velocity, Lane dt,
+        Lane sx, Lane sy, Lane negSx, float* transforms) {
+    Lane a = add(*angle, mul(velocity, dt));
+    Bits turns;
+    a = sub(a, mul(roundToInt(mul(a, splat(ONE_OVER_TWO_PI)), &turns),
+            splat(TWO_PI)));
+    *angle = a;
+
+    Lane s, c;
+    sinCos(a, &s, &c);
+    storeInterleaved(transforms, mul(c, sx), mul(s, sy), mul(s, negSx),
+            mul(c, sy));
+}
+
+// ----------------------------------------------------------------------------
+
+void sincosBatch(const float* angles, float* sines, float* cosines,
+        unsigned int n) {
+    unsigned int i = 0;
+    for (; i + LANE_WIDTH <= n; i += LANE_WIDTH) {
+        Lane s, c;
+        sinCos(load(angles + i), &s, &c);
+        store(sines + i, s);
+        store(cosines + i, c);
+    }
+    if (i < n) {
+        // The last few angles go through a padded lane
+        const unsigned int count = n - i;
+        float a[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float out[2][4];
+        memcpy(a, angles + i, count * sizeof(float));
+        Lane s, c;
+        sinCos(load(a), &s, &c);
+        store(out[0], s);
+        store(out[1], c);
+        memcpy(sines + i, out[0], count * sizeof(float));
+        memcpy(cosines + i, out[1], count * sizeof(float));
+    }
+}
+
+void stepRotations(float* angles, const float* velocities, float dt,
+        const float scale[2], float* transforms, unsigned int n) {
+    const Lane step = splat(dt);
+    const Lane sx = splat(scale[0]);
+    const Lane sy = splat(scale[1]);
+    const Lane negSx = splat(-scale[0]);
+
+    unsigned int i = 0;
+    for (; i + LANE_WIDTH <= n; i += LANE_WIDTH) {
+        Lane a = load(angles + i);
+        stepRotation(&a, load(velocities + i), step, sx, sy, negSx,
+                transforms + 4*i);
+        store(angles + i, a);
+    }
+    if (i < n) {
+        const unsigned int count = n - i;
+        float a[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float out[16];
+        memcpy(a, angles + i, count * sizeof(float));
+        memcpy(v, velocities + i, count * sizeof(float));
+        Lane lane = load(a);
+        stepRotation(&lane, load(v), step, sx, sy, negSx, out);
+        store(a, lane);
+        memcpy(angles + i, a, count * sizeof(float));
+        memcpy(transforms + 4*i, out, 4 * count * sizeof(float));
+    }
+}
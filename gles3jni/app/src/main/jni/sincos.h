@@ -0,0 +1,42 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SINCOS_H
+#define SINCOS_H 1
+
+// ----------------------------------------------------------------------------
+// Batched sine and cosine, four angles at a time with NEON or SSE2 and one
+// at a time otherwise (define SINCOS_NO_SIMD to force the scalar code).
+// Defined in sincos.cpp.
+//
+// The angle is reduced to [-pi/4 .. pi/4] around the nearest multiple of
+// pi/2 and both functions are evaluated with minimax polynomials. Results
+// are within 2e-7 of the exact values for |angle| < 8192, about as close as
+// sinf()/cosf(), at a fraction of their cost.
+
+// sines[i] = sin(angles[i]), cosines[i] = cos(angles[i]) for i < n.
+extern void sincosBatch(const float* angles, float* sines, float* cosines,
+        unsigned int n);
+
+// Advances the rotation of n instances by dt seconds and writes their
+// scale/rotation matrices:
+//  angles[i] += velocities[i] * dt, wrapped into [-pi .. pi]
+//  transforms[4*i .. 4*i+3] = 2x2 column-major scale * rotation(angles[i])
+// transforms is written in order, so it may point to mapped GPU memory.
+extern void stepRotations(float* angles, const float* velocities, float dt,
+        const float scale[2], float* transforms, unsigned int n);
+
+#endif // SINCOS_H
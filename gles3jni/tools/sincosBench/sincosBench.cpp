@@ -0,0 +1,141 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ----------------------------------------------------------------------------
+// sincosBench.cpp
+// Host microbenchmark for the per-frame transform update of gles3jni
+// (stepRotations() in sincos.cpp), against the sinf()/cosf() loop it
+// replaced. Checks the accuracy of sincosBatch() first and fails if it is
+// out of bounds.
+//
+// Build and run on the host, from this directory:
+//  JNI=../../app/src/main/jni
+//  g++ -O2 -I$JNI -o sincosBench sincosBench.cpp $JNI/sincos.cpp
+//  ./sincosBench [instances]
+// Add -DSINCOS_NO_SIMD to measure the scalar code.
+// ----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include "sincos.h"
+
+// sincos.h promises this much, for |angle| < ACCURATE_RANGE
+static const double MAX_ERROR = 2e-7;
+static const float ACCURATE_RANGE = 8192.0f;
+
+static const float TWO_PI = 6.28318530717958648f;
+static const double MIN_RUN_NS = 200000000.0;
+
+static double nowNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec*1e9 + now.tv_nsec;
+}
+
+// Largest error of sincosBatch() over n angles in [lo .. hi]
+static double measureError(float lo, float hi, unsigned int n) {
+    std::vector<float> angles(n), sines(n), cosines(n);
+    for (unsigned int i = 0; i < n; i++) {
+        angles[i] = lo + (hi - lo) * (float)i / (float)(n - 1);
+    }
+    sincosBatch(&angles[0], &sines[0], &cosines[0], n);
+
+    double maxError = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+        maxError = fmax(maxError, fabs(sines[i] - sin((double)angles[i])));
+        maxError = fmax(maxError, fabs(cosines[i] - cos((double)angles[i])));
+    }
+    return maxError;
+}
+
+// Renderer::step() before sincos.cpp
+static void stepRotationsLibm(float* angles, const float* velocities,
+        float dt, const float scale[2], float* transforms, unsigned int n) {
+    for (unsigned int i = 0; i < n; i++) {
+        angles[i] += velocities[i] * dt;
+        if (angles[i] >= TWO_PI) {
+            angles[i] -= TWO_PI;
+        } else if (angles[i] <= -TWO_PI) {
+            angles[i] += TWO_PI;
+        }
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        float s = sinf(angles[i]);
+        float c = cosf(angles[i]);
+        transforms[4*i + 0] =  c * scale[0];
+        transforms[4*i + 1] =  s * scale[1];
+        transforms[4*i + 2] = -s * scale[0];
+        transforms[4*i + 3] =  c * scale[1];
+    }
+}
+
+typedef void (*StepFunction)(float*, const float*, float, const float[2],
+        float*, unsigned int);
+
+// Instances updated per millisecond, over frames of n instances
+static double measureRate(StepFunction step, unsigned int n) {
+    std::vector<float> angles(n), velocities(n), transforms(4 * n);
+    srand48(1);
+    for (unsigned int i = 0; i < n; i++) {
+        angles[i] = drand48() * TWO_PI;
+        velocities[i] = 0.3f * TWO_PI * (2.0f * drand48() - 1.0f);
+    }
+    const float scale[2] = {0.01f, 0.02f};
+    const float dt = 1.0f / 60.0f;
+
+    unsigned int frames = 0;
+    const double start = nowNs();
+    double elapsed;
+    do {
+        step(&angles[0], &velocities[0], dt, scale, &transforms[0], n);
+        frames++;
+        elapsed = nowNs() - start;
+    } while (elapsed < MIN_RUN_NS);
+    return (double)frames * n / (elapsed * 1e-6);
+}
+
+int main(int argc, char* argv[]) {
+    // Default to the landscape 16:9 grid of the ES3 renderer
+    unsigned int instances = argc > 1 ? atoi(argv[1]) : 256 * 144;
+    if (instances == 0) {
+        fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+        return 1;
+    }
+
+    const double frameError = measureError(-TWO_PI, TWO_PI, 1000003);
+    const double rangeError = measureError(-ACCURATE_RANGE, ACCURATE_RANGE,
+            1000003);
+    printf("sincosBatch max error: %.3g in [-2pi .. 2pi], %.3g in "
+            "[-%g .. %g]\n", frameError, rangeError, ACCURATE_RANGE,
+            ACCURATE_RANGE);
+    if (frameError > MAX_ERROR || rangeError > MAX_ERROR) {
+        fprintf(stderr, "Error above %g\n", MAX_ERROR);
+        return 1;
+    }
+
+    const double libm = measureRate(stepRotationsLibm, instances);
+    const double batch = measureRate(stepRotations, instances);
+    printf("%u instances per frame\n", instances);
+    printf("  sinf/cosf:     %10.0f instances/ms\n", libm);
+    printf("  stepRotations: %10.0f instances/ms (%.1fx)\n", batch,
+            batch / libm);
+    return 0;
+}